@@ -0,0 +1,231 @@
+#!/usr/bin/env bash
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+# Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+# Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+# Scaling Benchmark Script.
+#
+# Runs the `titwcsph` dam breaking case with the different resolutions and
+# numbers of threads, and collects the throughput, the parallel efficiency
+# and the profiler breakdown of each run into a Markdown report.
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+source "$(dirname "$0")/build-utils.sh" || exit $?
+TITWCSPH_EXE="${TITWCSPH_EXE:-$INSTALL_DIR/bin/titwcsph}"
+SCALING_DIR="${SCALING_DIR:-$SOURCE_DIR/output/scaling}"
+MODE="both"
+RESOLUTIONS=(40 80 160)
+THREADS=(1 2 4 8)
+STEPS=200
+
+usage() {
+  echo "Usage: $(basename "$0") [options]"
+  echo ""
+  echo "Options:"
+  echo "  -h, --help               Print this help message."
+  echo "  -m, --mode <mode>        Scaling mode: strong, weak or both."
+  echo "  -r, --resolutions <list> Resolutions (particles along the water"
+  echo "                           column height). For the weak scaling, the"
+  echo "                           first one is the resolution of one thread."
+  echo "  -t, --threads <list>     Numbers of threads."
+  echo "  -s, --steps <num>        Number of time steps of each run."
+  echo "  -o, --output <dir>       Directory for the logs and the report."
+}
+
+parse-args() {
+  while [[ $# -gt 0 ]]; do
+    case "$1" in
+      # Options.
+      -m | --mode)        MODE="$2";                      shift 2;;
+      -r | --resolutions) read -ra RESOLUTIONS <<< "$2";  shift 2;;
+      -t | --threads)     read -ra THREADS <<< "$2";      shift 2;;
+      -s | --steps)       STEPS="$2";                     shift 2;;
+      -o | --output)      SCALING_DIR="$2";               shift 2;;
+      # Help.
+      -h | -help | --help) usage; exit 0;;
+      *) echo "Invalid argument: $1."; usage; exit 1;;
+    esac
+  done
+  case "$MODE" in
+    strong | weak | both) ;;
+    *) echo "Invalid scaling mode: $MODE."; usage; exit 1;;
+  esac
+  if [ ! -x "$TITWCSPH_EXE" ]; then
+    echo "# Executable $TITWCSPH_EXE is not found, build and install it first."
+    exit 1
+  fi
+}
+
+display-options() {
+  echo "# Options:"
+  echo "#   MODE        = $MODE"
+  echo "#   RESOLUTIONS = ${RESOLUTIONS[*]}"
+  echo "#   THREADS     = ${THREADS[*]}"
+  echo "#   STEPS       = $STEPS"
+  echo "#   OUTPUT      = $SCALING_DIR"
+}
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+# Run the solver with the given resolution and number of threads, and print
+# the path to the run log.
+run-case() {
+  local RESOLUTION="$1"
+  local NUM_THREADS="$2"
+  local RUN_NAME="r${RESOLUTION}_t${NUM_THREADS}"
+  local RUN_DIR="$SCALING_DIR/runs/$RUN_NAME"
+  local RUN_LOG="$SCALING_DIR/logs/$RUN_NAME.log"
+  if [ ! -f "$RUN_LOG" ]; then
+    echo "# Running resolution $RESOLUTION with $NUM_THREADS threads..." >&2
+    mkdir -p "$RUN_DIR" "$(dirname "$RUN_LOG")" || exit $?
+    (
+      cd "$RUN_DIR" &&
+        TIT_ENABLE_PROFILER=1 "$TITWCSPH_EXE" \
+          --threads="$NUM_THREADS" \
+          --resolution="$RESOLUTION" \
+          --max_steps="$STEPS"
+    ) > "$RUN_LOG" 2>&1 || {
+      echo "# Run $RUN_NAME failed, see $RUN_LOG." >&2
+      exit 1
+    }
+    rm -rf "$RUN_DIR"
+  fi
+  echo "$RUN_LOG"
+}
+
+# Print the field of the performance summary line of the run log. Values are
+# looked up by the unit that follows them, e.g. `particles`, `steps`, `s` (the
+# wall time) or `particle` (the particle updates per second), so that the
+# other fields of the line, like the member index, do not shift them.
+perf-field() {
+  awk -v unit="$2" '$2 == "Performance:" {
+    for (i = 4; i <= NF; ++i) {
+      if ($i == unit || $i == unit ",") { print $(i - 1); exit }
+    }
+  }' "$1"
+}
+
+# Print the profiler report of the run log.
+profiler-report() {
+  sed -n '/^Profiling report:/,$p' "$1" | sed '1d; /^$/d'
+}
+
+# Append the scaling table to the report. Each case in the arguments is a
+# pair of the resolution and the number of threads. Efficiency is relative to
+# the first case: throughput per thread divided by the one of the first case.
+report-table() {
+  local TITLE="$1"; shift
+  local BASE_UPS=""
+  local BASE_THREADS=""
+  {
+    echo "## $TITLE"
+    echo ""
+    echo "| Threads | Resolution | Particles | Wall time [s] |" \
+         "Updates/s | Speedup | Efficiency |"
+    echo "|--------:|-----------:|----------:|--------------:|" \
+         "----------:|--------:|-----------:|"
+  } >> "$REPORT"
+  while [[ $# -gt 0 ]]; do
+    local RESOLUTION="$1"
+    local NUM_THREADS="$2"
+    shift 2
+    local RUN_LOG
+    RUN_LOG=$(run-case "$RESOLUTION" "$NUM_THREADS") || exit $?
+    local PARTICLES WALL_TIME UPS
+    PARTICLES=$(perf-field "$RUN_LOG" particles)
+    WALL_TIME=$(perf-field "$RUN_LOG" s)
+    UPS=$(perf-field "$RUN_LOG" particle)
+    [ -z "$BASE_UPS" ] && BASE_UPS="$UPS" && BASE_THREADS="$NUM_THREADS"
+    awk -v t="$NUM_THREADS" -v r="$RESOLUTION" -v n="$PARTICLES" \
+        -v w="$WALL_TIME" -v u="$UPS" -v bu="$BASE_UPS" -v bt="$BASE_THREADS" \
+        'BEGIN {
+           s = u / bu
+           printf "| %d | %d | %d | %.3f | %.3e | %.2f | %.1f%% |\n",
+                  t, r, n, w, u, s, 100 * s * bt / t
+         }' >> "$REPORT"
+    RUN_LOGS+=("$RUN_LOG")
+  done
+  echo "" >> "$REPORT"
+}
+
+# Append the profiler breakdowns of all the runs to the report.
+report-profiles() {
+  {
+    echo "## Profiler breakdowns"
+    echo ""
+  } >> "$REPORT"
+  local RUN_LOG
+  for RUN_LOG in $(printf '%s\n' "${RUN_LOGS[@]}" | sort -u); do
+    {
+      echo "### $(basename "$RUN_LOG" .log)"
+      echo ""
+      echo '```'
+      profiler-report "$RUN_LOG"
+      echo '```'
+      echo ""
+    } >> "$REPORT"
+  done
+}
+
+run-scaling() {
+  mkdir -p "$SCALING_DIR" || exit $?
+  REPORT="$SCALING_DIR/report.md"
+  RUN_LOGS=()
+  {
+    echo "# titwcsph scaling report"
+    echo ""
+    echo "$STEPS time steps per run, $(get-num-cpus) logical CPUs available."
+    echo ""
+  } > "$REPORT"
+
+  # Strong scaling: fixed resolution, increasing number of threads.
+  if [ "$MODE" != "weak" ]; then
+    local RESOLUTION NUM_THREADS CASES
+    for RESOLUTION in "${RESOLUTIONS[@]}"; do
+      CASES=()
+      for NUM_THREADS in "${THREADS[@]}"; do
+        CASES+=("$RESOLUTION" "$NUM_THREADS")
+      done
+      report-table "Strong scaling, resolution $RESOLUTION" "${CASES[@]}"
+    done
+  fi
+
+  # Weak scaling: the number of particles per thread is fixed. The case is
+  # two-dimensional, so the resolution grows as the square root of the
+  # number of threads.
+  if [ "$MODE" != "strong" ]; then
+    local BASE_RESOLUTION="${RESOLUTIONS[0]}"
+    local BASE_THREADS="${THREADS[0]}"
+    local NUM_THREADS CASES=()
+    for NUM_THREADS in "${THREADS[@]}"; do
+      CASES+=("$(awk -v r="$BASE_RESOLUTION" -v t="$NUM_THREADS" \
+                     -v bt="$BASE_THREADS" \
+                     'BEGIN { printf "%d", r * sqrt(t / bt) + 0.5 }')")
+      CASES+=("$NUM_THREADS")
+    done
+    report-table "Weak scaling, base resolution $BASE_RESOLUTION" \
+                 "${CASES[@]}"
+  fi
+
+  report-profiles
+  echo "# Report is written to $REPORT."
+}
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+# Run the scaling benchmark.
+TIMEFORMAT="Done. Elapsed %R seconds."
+time {
+  echo-thick-separator
+  echo "Tit Scaling Script"
+  echo-thick-separator
+  parse-args "$@"
+  display-options
+  run-scaling
+  echo-separator
+}
+echo-thick-separator
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -20,6 +20,10 @@ STDOUT_PATH=""
 STDERR_PATH=""
 INPUT_PATHS=()
 OUTPUT_PATHS=()
+PERF_BASELINE_PATH=""
+# Performance history is kept outside of the test output directory, so that
+# it survives between the test runs.
+PERF_HISTORY_PATH=${PERF_HISTORY_PATH:-$SOURCE_DIR/output/perf_history.csv}
 DIFF_EXE=${DIFF_EXE:-diff}
 # Prefer `gsed` to regular `sed`. This is essential on the BSD-like systems.
 SED_EXE=${SED_EXE:-$(command -v gsed || echo sed)}
@@ -47,6 +51,7 @@ usage() {
   echo "  --match-stderr <path> Match test 'stderr' with the specified file."
   echo "  --match-file <path>   Match test output file with the specified file."
   echo "  --filter <filter>     Extra 'sed' filter to be applied to the test output."
+  echo "  --match-perf <path>   Match test performance with the baseline."
   echo "  -- <test-command>     Test command line arguments."
 }
 
@@ -70,6 +75,8 @@ parse-args() {
       --match-file=*)   OUTPUT_PATHS+=("${1#*=}"); shift 1;;
       --filter)         SED_FILTERS+=("$2");       shift 2;;
       --filter=*)       SED_FILTERS+=("${1#*=}");  shift 1;;
+      --match-perf)     PERF_BASELINE_PATH="$2";   shift 2;;
+      --match-perf=*)   PERF_BASELINE_PATH="${1#*=}"; shift 1;;
       --)               TEST_COMMAND=("${@:2}");   break;;
       # Help.
       -h | -help | --help)             usage; exit 0;;
@@ -158,6 +165,8 @@ match-exit-code() {
   fi
 }
 
+# Match the checksum of the file. With `TIT_UPDATE_CHECKSUMS` set, the expected
+# checksum is replaced with the actual one instead.
 match-file-checksum() {
   local FILE="$1"
 
@@ -172,6 +181,13 @@ match-file-checksum() {
   shasum "$FILE" | cut -d' ' -f1 > "$ACTUAL_CHECKSUM_FILE"
   ACTUAL_CHECKSUM=$(cat "$ACTUAL_CHECKSUM_FILE")
 
+  # Update the expected checksum, if requested.
+  if [ "${TIT_UPDATE_CHECKSUMS:-}" ]; then
+    echo "# Updating the checksum $(readlink "$EXPECTED_CHECKSUM_FILE")..."
+    cp "$ACTUAL_CHECKSUM_FILE" "$(readlink "$EXPECTED_CHECKSUM_FILE")"
+    return 0
+  fi
+
   # Match them.
   if [ "$ACTUAL_CHECKSUM" != "$EXPECTED_CHECKSUM" ]; then
     echo "# Checksum of $FILE does not match!"
@@ -250,6 +266,83 @@ match-file() {
   "$MATCH_COMMAND" "$FILE"
 }
 
+# Print the performance metrics of the test, one `<metric>,<value>` per line:
+# the particle updates per second from the performance summary line, and the
+# total time of each section from the profiling report, summed over all the
+# places of the section in the call tree. Section name is the rest of the row
+# after the calls column, or after the counter columns, if they are present.
+perf-metrics() {
+  awk '
+    $2 == "Performance:" { print "updates_per_second," $11 }
+    /^Profiling report:/ { report = 1; next }
+    report && /section name$/ { num_columns = /IPC/ ? 6 : 3; next }
+    report && $1 ~ /^[0-9]+\.[0-9]+$/ {
+      name = $0
+      for (i = 0; i < num_columns; i++) sub(/^ *[^ ]+/, "", name)
+      sub(/^ +/, "", name)
+      times[name] += $1
+    }
+    END { for (name in times) print "section:" name "," times[name] }
+  ' "stdout.txt" | sort
+}
+
+# Match the performance metrics against the baseline. Each baseline row holds
+# the metric name, its kind (`time`, lower is better, or `rate`, higher is
+# better), the baseline value and the relative slowdown tolerance. Metrics
+# without the baseline value fail, so that the gate is never left empty.
+# Results are appended to the performance history. With
+# `TIT_PERF_UPDATE_BASELINE` set, the baseline is replaced with the measured
+# values instead.
+match-perf() {
+  echo "# Matching performance..."
+  if [ ! -f "$PERF_BASELINE_PATH" ]; then
+    echo "# Baseline $PERF_BASELINE_PATH does not exist!"
+    return 1
+  fi
+  perf-metrics > "perf.csv"
+  mkdir -p "$(dirname "$PERF_HISTORY_PATH")"
+  if [ ! -f "$PERF_HISTORY_PATH" ]; then
+    echo "date,test,metric,value,baseline,status" > "$PERF_HISTORY_PATH"
+  fi
+  local DATE
+  DATE=$(date -u +%Y-%m-%dT%H:%M:%SZ)
+  awk -F, -v date="$DATE" -v name="$TEST_NAME" \
+      -v history="$PERF_HISTORY_PATH" -v updated="perf_baseline.csv" \
+      -v update="${TIT_PERF_UPDATE_BASELINE:-}" '
+    FNR == NR { values[$1] = $2; next }
+    /^#/ || $1 == "metric" || NF < 4 { if (update) print > updated; next }
+    {
+      metric = $1; kind = $2; base = $3; tol = $4; value = ""
+      if (!(metric in values)) {
+        status = "missing"
+        printf "# - %s: not reported!\n", metric
+      } else if (base == "") {
+        value = values[metric]; status = "new"
+        printf "# - %s: %s, no baseline, record it with %s!\n",
+               metric, value, "TIT_PERF_UPDATE_BASELINE=1"
+      } else {
+        value = values[metric]
+        if (value <= 0) slowdown = 1e30
+        else if (kind == "rate") slowdown = base / value - 1
+        else slowdown = value / base - 1
+        status = slowdown > tol ? "regressed" : "passed"
+        printf "# - %s: %s, baseline %s, slowdown %+.1f%%, %s.\n",
+               metric, value, base, 100 * slowdown, status
+      }
+      if (status != "passed") failed = 1
+      print date "," name "," metric "," value "," base "," status >> history
+      if (update) {
+        print metric "," kind "," (value != "" ? value : base) "," tol > updated
+      }
+    }
+    END { exit update ? 0 : failed }
+  ' "perf.csv" "$PERF_BASELINE_PATH" || return 1
+  if [ "${TIT_PERF_UPDATE_BASELINE:-}" ]; then
+    echo "# Updating the baseline $PERF_BASELINE_PATH..."
+    cp "perf_baseline.csv" "$PERF_BASELINE_PATH"
+  fi
+}
+
 match() {
   echo "# Matching results..."
   PASSED=true
@@ -257,6 +350,9 @@ match() {
   # Match exit code.
   match-exit-code "$1" || PASSED=false
 
+  # Match the performance.
+  if [ "$PERF_BASELINE_PATH" ]; then match-perf || PASSED=false; fi
+
   # Match the output (in parallel).
   local PIDS=()
   for FILE in "${FILES_TO_MATCH[@]}"; do
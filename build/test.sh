@@ -57,8 +57,14 @@ run-tests() {
   # Parallelize the test execution.
   [ "$JOBS" -gt 1 ] && CTEST_ARGS+=("-j" "$JOBS")
 
-  # Exclude long tests if the flag is not set.
-  [ ! "$TIT_LONG_TESTS" ] && CTEST_ARGS+=("--exclude-regex" "\[long\]")
+  # Exclude long tests if the flag is not set. Performance tests are only
+  # meaningful on a quiet machine, so they are also excluded unless requested.
+  local EXCLUDE_TAGS=()
+  [ ! "$TIT_LONG_TESTS" ] && EXCLUDE_TAGS+=("\[long\]")
+  [ ! "$TIT_PERF_TESTS" ] && EXCLUDE_TAGS+=("\[perf\]")
+  if [ ${#EXCLUDE_TAGS[@]} -gt 0 ]; then
+    CTEST_ARGS+=("--exclude-regex" "$(IFS="|"; echo "${EXCLUDE_TAGS[*]}")")
+  fi
 
   # Run CTest.
   (cd "$TEST_DIR" && "${CTEST_ARGS[@]}") || exit $?
@@ -4,6 +4,7 @@
 # ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 include_guard()
+include(simd)
 include(utils)
 
 # ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -28,8 +29,8 @@ set(
   CLANG_COMPILE_OPTIONS
   # Warnings and diagnostics.
   ${CLANG_WARNINGS}
-  # Generate machine code for the host system's architecture.
-  -march=native
+  # Generate machine code for the selected architecture.
+  -march=${TIT_ARCH}
   # Position independent code.
   -fPIC
   # Do not export symbols.
@@ -4,6 +4,7 @@
 # ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 include_guard()
+include(simd)
 
 # ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -51,8 +52,8 @@ set(
   GNU_COMPILE_OPTIONS
   # Warnings and diagnostics.
   ${GNU_WARNINGS}
-  # Generate machine code for the host system's architecture.
-  -march=native
+  # Generate machine code for the selected architecture.
+  -march=${TIT_ARCH}
   # Position independent code.
   -fPIC
   # Do not export symbols.
@@ -0,0 +1,37 @@
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+# Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+# Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+include_guard()
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+# Baseline architecture of the generated machine code. Set it to the lowest
+# common denominator of the machines the build should run on.
+set(
+  TIT_ARCH "native"
+  CACHE STRING
+  "Baseline architecture of the generated code (value of `-march`)."
+)
+
+# Additional SIMD targets. Targets that are marked with `SIMD_VARIANTS` are
+# also compiled for each of these, and the executables select the best build
+# that is supported by the host at startup.
+set(
+  TIT_SIMD_TARGETS ""
+  CACHE STRING
+  "Additional SIMD targets to build the solvers for (e.g. `AVX2;AVX3`)."
+)
+
+# Architectures of the SIMD targets. Target names match the ones of Highway.
+set(SIMD_TARGET_ARCH_AVX2 "x86-64-v3")
+set(SIMD_TARGET_ARCH_AVX3 "x86-64-v4")
+
+foreach(SIMD_TARGET ${TIT_SIMD_TARGETS})
+  if(NOT DEFINED SIMD_TARGET_ARCH_${SIMD_TARGET})
+    message(FATAL_ERROR "Unknown SIMD target: '${SIMD_TARGET}'.")
+  endif()
+endforeach()
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -59,6 +59,33 @@ endfunction()
 
 # ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+#
+# Replace the dependencies with their SIMD variants, where those exist.
+#
+function(make_simd_variant_depends DEPENDS SUFFIX RESULT_VAR)
+  set(RESULT)
+  foreach(DEPEND ${DEPENDS})
+    if(TARGET "${DEPEND}_${SUFFIX}")
+      list(APPEND RESULT "${DEPEND}_${SUFFIX}")
+    else()
+      list(APPEND RESULT "${DEPEND}")
+    endif()
+  endforeach()
+  set(${RESULT_VAR} "${RESULT}" PARENT_SCOPE)
+endfunction()
+
+#
+# Generate the code of the target for the given SIMD target.
+#
+function(configure_simd_target TARGET SIMD_TARGET)
+  # Options are appended after the common ones, so they take precedence.
+  set(SIMD_OPTIONS "-march=${SIMD_TARGET_ARCH_${SIMD_TARGET}}")
+  target_compile_options(${TARGET} PRIVATE ${SIMD_OPTIONS})
+  target_link_options(${TARGET} PRIVATE ${SIMD_OPTIONS})
+endfunction()
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 #
 # Add a library.
 #
@@ -66,8 +93,8 @@ function(add_tit_library)
   # Parse and check arguments.
   cmake_parse_arguments(
     LIB
-    "PUBLIC"
-    "NAME;TYPE;PREFIX;SUFFIX;DESTINATION"
+    "PUBLIC;SIMD_VARIANTS"
+    "NAME;TYPE;PREFIX;SUFFIX;DESTINATION;SIMD_TARGET"
     "SOURCES;DEPENDS"
     ${ARGN}
   )
@@ -122,6 +149,9 @@ function(add_tit_library)
 
   # Configure the target.
   configure_tit_target(${LIB_TARGET} ${LIB_VISIBILITY})
+  if(LIB_SIMD_TARGET)
+    configure_simd_target(${LIB_TARGET} ${LIB_SIMD_TARGET})
+  endif()
   if(LIB_PREFIX OR LIB_SUFFIX)
     set_target_properties(
       ${LIB_TARGET} PROPERTIES
@@ -147,9 +177,24 @@ function(add_tit_library)
   endif()
 
   # Enable static analysis.
-  if(LIB_SOURCES)
+  if(LIB_SOURCES AND NOT LIB_SIMD_TARGET)
     enable_clang_tidy(${LIB_TARGET})
   endif()
+
+  # Build the variants of the library for the additional SIMD targets.
+  if(LIB_SIMD_VARIANTS)
+    foreach(SIMD_TARGET ${TIT_SIMD_TARGETS})
+      string(TOLOWER ${SIMD_TARGET} SIMD_SUFFIX)
+      make_simd_variant_depends("${LIB_DEPENDS}" ${SIMD_SUFFIX} SIMD_DEPENDS)
+      add_tit_library(
+        NAME "${LIB_NAME}_${SIMD_SUFFIX}"
+        TYPE ${LIB_TYPE}
+        SIMD_TARGET ${SIMD_TARGET}
+        SOURCES ${LIB_SOURCES}
+        DEPENDS ${SIMD_DEPENDS}
+      )
+    endforeach()
+  endif()
 endfunction()
 
 # ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -161,8 +206,8 @@ function(add_tit_executable)
   # Parse and check arguments.
   cmake_parse_arguments(
     EXE
-    "PUBLIC"
-    "NAME;DESTINATION"
+    "PUBLIC;SIMD_VARIANTS"
+    "NAME;DESTINATION;OUTPUT_NAME;SIMD_TARGET"
     "SOURCES;DEPENDS"
     ${ARGN}
   )
@@ -178,6 +223,15 @@ function(add_tit_executable)
 
   # Configure the target.
   configure_tit_target(${EXE_TARGET} PRIVATE)
+  if(EXE_SIMD_TARGET)
+    configure_simd_target(${EXE_TARGET} ${EXE_SIMD_TARGET})
+  endif()
+  if(EXE_OUTPUT_NAME)
+    set_target_properties(
+      ${EXE_TARGET} PROPERTIES
+      OUTPUT_NAME "${EXE_OUTPUT_NAME}"
+    )
+  endif()
 
   # Link with the dependent libraries.
   target_link_libraries(${EXE_TARGET} PRIVATE ${EXE_DEPENDS})
@@ -193,9 +247,31 @@ function(add_tit_executable)
   install(TARGETS ${EXE_TARGET} RUNTIME DESTINATION "${EXE_DESTINATION}")
 
   # Enable static analysis.
-  if(EXE_SOURCES)
+  if(EXE_SOURCES AND NOT EXE_SIMD_TARGET)
     enable_clang_tidy(${EXE_TARGET})
   endif()
+
+  # Build the variants of the executable for the additional SIMD targets.
+  # Variant is placed next to the executable with the SIMD target name
+  # appended, e.g. `titwcsph.avx3`, see `exec_simd_variant`.
+  if(EXE_SIMD_VARIANTS)
+    get_target_property(EXE_BASE_NAME ${EXE_TARGET} OUTPUT_NAME)
+    if(NOT EXE_BASE_NAME)
+      set(EXE_BASE_NAME ${EXE_TARGET})
+    endif()
+    foreach(SIMD_TARGET ${TIT_SIMD_TARGETS})
+      string(TOLOWER ${SIMD_TARGET} SIMD_SUFFIX)
+      make_simd_variant_depends("${EXE_DEPENDS}" ${SIMD_SUFFIX} SIMD_DEPENDS)
+      add_tit_executable(
+        NAME "${EXE_NAME}_${SIMD_SUFFIX}"
+        OUTPUT_NAME "${EXE_BASE_NAME}.${SIMD_SUFFIX}"
+        DESTINATION "${EXE_DESTINATION}"
+        SIMD_TARGET ${SIMD_TARGET}
+        SOURCES ${EXE_SOURCES}
+        DEPENDS ${SIMD_DEPENDS}
+      )
+    endforeach()
+  endif()
 endfunction()
 
 # ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
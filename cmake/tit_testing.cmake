@@ -28,7 +28,7 @@ function(add_tit_test)
   cmake_parse_arguments(
     TEST
     ""
-    "NAME;EXIT_CODE;STDIN;MATCH_STDOUT;MATCH_STDERR"
+    "NAME;EXIT_CODE;STDIN;MATCH_STDOUT;MATCH_STDERR;MATCH_PERF"
     "COMMAND;ENVIRONMENT;INPUT_FILES;MATCH_FILES;FILTERS"
     ${ARGN}
   )
@@ -64,6 +64,10 @@ function(add_tit_test)
     cmake_path(ABSOLUTE_PATH FILE NORMALIZE)
     list(APPEND TEST_DRIVER_ARGS "--match-file=${FILE}")
   endforeach()
+  if(TEST_MATCH_PERF)
+    cmake_path(ABSOLUTE_PATH TEST_MATCH_PERF NORMALIZE)
+    list(APPEND TEST_DRIVER_ARGS "--match-perf=${TEST_MATCH_PERF}")
+  endif()
   foreach(FILTER ${TEST_FILTERS})
     list(APPEND TEST_DRIVER_ARGS "--filter=${FILTER}")
   endforeach()
@@ -86,3 +90,58 @@ function(add_tit_test)
 endfunction()
 
 # ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#
+# Add a benchmark executable.
+#
+# Benchmarks are not registered as tests, since their results are only
+# meaningful on a quiet machine. Instead, each benchmark gets a target that
+# runs it and stores the results as JSON in the build directory, and the
+# `benchmarks` target runs all of them.
+#
+function(add_tit_benchmark)
+  # Parse and check arguments.
+  cmake_parse_arguments(
+    BENCH
+    ""
+    "NAME"
+    "SOURCES;DEPENDS"
+    ${ARGN}
+  )
+  if(NOT BENCH_NAME)
+    message(FATAL_ERROR "Benchmark name must be specified.")
+  endif()
+  if(NOT BENCH_SOURCES)
+    message(FATAL_ERROR "Benchmark sources must be specified.")
+  endif()
+
+  # Create the benchmark executable.
+  add_tit_executable(
+    NAME
+      ${BENCH_NAME}
+    SOURCES
+      ${BENCH_SOURCES}
+    DEPENDS
+      ${BENCH_DEPENDS}
+      tit::benchmark
+  )
+
+  # Create the target that runs the benchmark.
+  make_target_name(${BENCH_NAME} BENCH_TARGET)
+  add_custom_target(
+    "run_${BENCH_TARGET}"
+    COMMAND
+      "$<TARGET_FILE:${BENCH_TARGET}>"
+      "--benchmark_out=${CMAKE_BINARY_DIR}/${BENCH_TARGET}.json"
+      "--benchmark_out_format=json"
+    DEPENDS ${BENCH_TARGET}
+    WORKING_DIRECTORY "${CMAKE_BINARY_DIR}"
+    USES_TERMINAL
+  )
+  if(NOT TARGET benchmarks)
+    add_custom_target(benchmarks)
+  endif()
+  add_dependencies(benchmarks "run_${BENCH_TARGET}")
+endfunction()
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -3,4 +3,65 @@
 # Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 # ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-print()  # TODO: Remove this line once we actual code.
+"""
+Python interface to the BlueTit Solver.
+
+Simulations are created and stepped in C++, the GIL is released while the
+steps are being made, so a script could drive several simulations from
+different threads. Particle fields are returned as read-only NumPy arrays that
+refer to the simulation memory directly. These arrays are invalidated by the
+next call to `run`, since the particles may be reordered and reallocated, so
+copy them if they need to be kept.
+
+Example:
+
+    import pytit
+    sim = pytit.dam_break(height=0.6, resolution=40)
+    for _ in range(10):
+        time = pytit.run(sim, num_steps=100)
+        print(time, pytit.field(sim, "rho").max())
+
+Particles prepared in Python are handed over in bulk with
+`dam_break_from_arrays`, that takes the `uint8` array of the particle types
+(0 for fluid, 1 for fixed, other types are rejected) and the `float64` arrays
+of the positions, and optionally the velocities and densities. Particle fields
+are filled in parallel, and the densities that are not given are hydrostatic:
+
+    sim = pytit.dam_break_from_arrays(
+        height=0.6, resolution=40, type=types, r=positions
+    )
+
+Time steps of the stored data series are read with `read_series`, which
+decompresses the next time steps on the background threads while the current
+one is being processed:
+
+    for step in pytit.read_series("particles.ttdb"):
+        print(step["time"], step["varyings"]["rho"].max())
+"""
+
+from pytit import _core
+from pytit._core import dam_break, dam_break_from_arrays, field, run, time
+
+__all__ = [
+    "dam_break",
+    "dam_break_from_arrays",
+    "field",
+    "read_series",
+    "run",
+    "time",
+]
+
+
+def read_series(path, series=-1, depth=2):
+    """
+    Iterate over the time steps of a data series of the storage.
+
+    Up to `depth` time steps are read ahead by the background threads, so the
+    memory is bounded by the size of `depth + 1` time steps. Negative `series`
+    index counts from the last series. Each time step is a dictionary with its
+    `time`, and the `uniforms` and `varyings` dictionaries of the NumPy arrays,
+    that own their data.
+    """
+    reader = _core.open_series(path, series=series, depth=depth)
+    while (step := _core.next_time_step(reader)) is not None:
+        yield step
@@ -0,0 +1,449 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/data/series_reader.hpp"
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+#include "tit/geom/partition.hpp"
+#include "tit/geom/search.hpp"
+
+#include "tit/sph/artificial_viscosity.hpp"
+#include "tit/sph/boundary.hpp"
+#include "tit/sph/continuity_equation.hpp"
+#include "tit/sph/dam_break.hpp"
+#include "tit/sph/energy_equation.hpp"
+#include "tit/sph/equation_of_state.hpp"
+#include "tit/sph/field.hpp"
+#include "tit/sph/fluid_equations.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/momentum_equation.hpp"
+#include "tit/sph/motion_equation.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/particle_shifting.hpp"
+#include "tit/sph/time_integrator.hpp"
+#include "tit/sph/viscosity.hpp"
+
+#include "tit/py/capsule.hpp"
+#include "tit/py/error.hpp"
+#include "tit/py/gil.hpp"
+#include "tit/py/mapping.hpp"
+#include "tit/py/module.hpp"
+#include "tit/py/numpy.hpp"
+#include "tit/py/object.hpp"
+#include "tit/py/typing.hpp"
+
+namespace tit::sph {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Equations of the dam break case.
+template<class Real>
+auto make_dam_break_equations(const DamBreakCase<Real>& dam_break) {
+  constexpr auto g = DamBreakCase<Real>::g;
+  constexpr auto rho_0 = DamBreakCase<Real>::rho_0;
+  const auto cs_0 = dam_break.sound_speed();
+  return FluidEquations{
+      MotionEquation{},
+      ContinuityEquation{},
+      MomentumEquation{NoViscosity{},
+                       DeltaSPHArtificialViscosity{cs_0, rho_0},
+                       GravitySource{g}},
+      NoEnergyEquation{},
+      LinearTaitEquationOfState{cs_0, rho_0},
+      QuarticWendlandKernel{},
+      DomainBoundary{dam_break.domain(), rho_0, cs_0, Vec{Real{0.0}, -g}},
+      ParticleShifting{},
+  };
+}
+
+/// Particles of the case, given in bulk. Vector fields have two components
+/// per particle, optional fields are empty.
+template<class Real>
+struct ParticleInput final {
+  std::span<const uint8_t> type; ///< Particle types, see `ParticleType`.
+  std::span<const Real> r;       ///< Particle positions.
+  std::span<const Real> v{};     ///< Particle velocities.
+  std::span<const Real> rho{};   ///< Particle densities.
+};
+
+/// Dam break simulation, same case as in `titwcsph`.
+template<class Real>
+class DamBreak final {
+public:
+
+  /// Set up the dam break case for the water column of height @p H, resolved
+  /// with @p resolution particles along the height.
+  DamBreak(Real H, size_t resolution) : DamBreak{H, resolution, Setup_{}} {
+    case_.lattice().append_to(particles_);
+    init_(/*has_rho=*/false);
+  }
+
+  /// Set up the dam break case for the water column of height @p H, resolved
+  /// with @p resolution particles along the height, from the given particles.
+  ///
+  /// Particles are appended in bulk, and their fields are filled in parallel.
+  /// Velocities are zero and densities are hydrostatic, unless given.
+  DamBreak(Real H, size_t resolution, const ParticleInput<Real>& input)
+      : DamBreak{H, resolution, Setup_{}} {
+    append_(input);
+  }
+
+  /// Dimensionless simulation time.
+  auto time() const noexcept -> Real {
+    return case_.dimensionless_time(time_);
+  }
+
+  /// Time step.
+  auto time_step() const noexcept -> Real {
+    return dt_;
+  }
+
+  /// Make @p num_steps steps in time.
+  void run(size_t num_steps) {
+    for (size_t n = 0; n < num_steps; ++n) {
+      integrator_.step(dt_, mesh_, particles_);
+      time_ += dt_;
+    }
+  }
+
+  /// Particle array.
+  auto particles() const noexcept -> const auto& {
+    return particles_;
+  }
+
+private:
+
+  // Tag of the constructor that sets up the case without the particles.
+  struct Setup_ {};
+
+  DamBreak(Real H, size_t resolution, Setup_ /*tag*/)
+      : case_{H, resolution}, dt_{case_.time_step(CFL_)},
+        integrator_{make_dam_break_equations(case_)},
+        particles_{Space<Real, 2>{}, integrator_},
+        mesh_{geom::GridSearch{case_.width()},
+              geom::RecursiveInertialBisection{},
+              geom::GridGraphPartition{2 * case_.width()}} {}
+
+  // Append the given particles and initialize their fields.
+  void append_(const ParticleInput<Real>& input) {
+    const auto count = input.type.size();
+    TIT_ASSERT(input.r.size() == 2 * count, "Position array size mismatch!");
+    TIT_ASSERT(input.v.empty() || input.v.size() == 2 * count,
+               "Velocity array size mismatch!");
+    TIT_ASSERT(input.rho.empty() || input.rho.size() == count,
+               "Density array size mismatch!");
+    TIT_ASSERT(particles_.size() == 0, "Particles are already appended!");
+
+    // Particles of each type are stored contiguously, so the particles are
+    // counted by type first, and then scattered into their ranges. Only the
+    // fluid and the fixed particles are supported by the case.
+    constexpr auto num_types = std::to_underlying(ParticleType::count);
+    std::array<size_t, num_types + 1> offsets{};
+    for (const auto type : input.type) {
+      if (type != std::to_underlying(ParticleType::fluid) &&
+          type != std::to_underlying(ParticleType::fixed)) {
+        TIT_THROW("Invalid particle type {}, only fluid ({}) and fixed ({}) "
+                  "particles are supported.",
+                  type,
+                  std::to_underlying(ParticleType::fluid),
+                  std::to_underlying(ParticleType::fixed));
+      }
+      offsets[type + 1] += 1;
+    }
+    for (size_t t = 0; t < num_types; ++t) {
+      particles_.append_n(static_cast<ParticleType>(t), offsets[t + 1]);
+      offsets[t + 1] += offsets[t];
+    }
+    std::vector<size_t> indices(count);
+    for (size_t i = 0; i < count; ++i) indices[i] = offsets[input.type[i]]++;
+
+    // Scatter the given fields.
+    par::for_each(std::views::iota(size_t{0}, count),
+                  [this, &input, &indices](size_t i) {
+                    const auto a = particles_[indices[i]];
+                    r[a] = Vec{input.r[2 * i], input.r[2 * i + 1]};
+                    if (!input.v.empty()) {
+                      v[a] = Vec{input.v[2 * i], input.v[2 * i + 1]};
+                    }
+                    if (!input.rho.empty()) rho[a] = input.rho[i];
+                  });
+    init_(/*has_rho=*/!input.rho.empty());
+  }
+
+  // Initialize the fields of the appended particles. Hydrostatic density is
+  // a series solution of the Poisson problem, which is the most expensive
+  // part of the setup.
+  void init_(bool has_rho) {
+    m[particles_] = case_.mass();
+    h[particles_] = case_.width();
+    par::for_each(particles_.all(), [this, has_rho](auto a) {
+      if (a.has_type(ParticleType::fixed)) {
+        if (!has_rho) rho[a] = rho_0_;
+        return;
+      }
+      if (has_rho) {
+        p[a] = pow2(case_.sound_speed()) * (rho[a] - rho_0_);
+        return;
+      }
+      p[a] = case_.hydrostatic_pressure(r[a]);
+      rho[a] = case_.density(p[a]);
+    });
+  }
+
+  using Equations_ = decltype(make_dam_break_equations(
+      std::declval<const DamBreakCase<Real>&>()));
+  using Integrator_ = RungeKuttaIntegrator<Equations_>;
+  using ParticleArray_ = decltype(ParticleArray{Space<Real, 2>{},
+                                                std::declval<Integrator_>()});
+  using ParticleMesh_ = ParticleMesh<geom::GridSearch,
+                                     geom::RecursiveInertialBisection,
+                                     geom::GridGraphPartition>;
+
+  static constexpr Real rho_0_ = DamBreakCase<Real>::rho_0;
+  static constexpr Real CFL_ = 0.8;
+
+  DamBreakCase<Real> case_;
+  Real dt_;
+  Real time_{};
+  Integrator_ integrator_;
+  ParticleArray_ particles_;
+  ParticleMesh_ mesh_;
+
+}; // class DamBreak
+
+using Simulation = DamBreak<real_t>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Access the simulation stored in the capsule.
+auto simulation(const py::Capsule& sim) -> Simulation& {
+  return *static_cast<Simulation*>(sim.data());
+}
+
+// Create the dam break simulation.
+auto dam_break(real_t height, size_t resolution) -> py::Capsule {
+  std::unique_ptr<Simulation> sim;
+  {
+    const py::ReleaseGIL release_gil{};
+    sim = std::make_unique<Simulation>(height, resolution);
+  }
+  return py::Capsule{std::move(sim)};
+}
+
+// Default value of the optional array arguments.
+auto no_array() -> py::Optional<py::NDArray> {
+  return py::None();
+}
+
+// Get the values of the contiguous NumPy array of the given shape.
+template<class Num>
+auto array_values(const py::NDArray& array,
+                  std::string_view name,
+                  std::span<const size_t> shape) -> std::span<const Num> {
+  if (array.kind() != data::kind_of<Num> || !array.is_contiguous() ||
+      !std::ranges::equal(array.shape(), shape)) {
+    py::raise_type_error("array '{}' must be a contiguous '{}' array "
+                         "of shape {}",
+                         name,
+                         data::kind_of<Num>.name(),
+                         shape.size() == 1 ?
+                             std::format("({},)", shape[0]) :
+                             std::format("({}, {})", shape[0], shape[1]));
+  }
+  const auto bytes = array.data();
+  return {std::bit_cast<const Num*>(bytes.data()), bytes.size() / sizeof(Num)};
+}
+
+// Create the dam break simulation from the particle arrays. Arrays are only
+// read while the simulation is being set up, without holding the GIL.
+auto dam_break_from_arrays(real_t height,
+                           size_t resolution,
+                           const py::NDArray& type,
+                           const py::NDArray& r,
+                           const py::Optional<py::NDArray>& v,
+                           const py::Optional<py::NDArray>& rho)
+    -> py::Capsule {
+  if (type.rank() != 1) py::raise_type_error("array 'type' must be 1D");
+  const std::array scalar_shape{type.shape()[0]};
+  const std::array vector_shape{type.shape()[0], size_t{2}};
+  ParticleInput<real_t> input{
+      .type = array_values<uint8_t>(type, "type", scalar_shape),
+      .r = array_values<real_t>(r, "r", vector_shape),
+  };
+  if (!py::NoneType::isinstance(v)) {
+    input.v = array_values<real_t>(py::expect<py::NDArray>(v),
+                                   "v",
+                                   vector_shape);
+  }
+  if (!py::NoneType::isinstance(rho)) {
+    input.rho = array_values<real_t>(py::expect<py::NDArray>(rho),
+                                     "rho",
+                                     scalar_shape);
+  }
+  std::unique_ptr<Simulation> sim;
+  {
+    const py::ReleaseGIL release_gil{};
+    sim = std::make_unique<Simulation>(height, resolution, input);
+  }
+  return py::Capsule{std::move(sim)};
+}
+
+// Run the simulation for the given number of steps without holding the GIL.
+auto run(const py::Capsule& sim, size_t num_steps) -> real_t {
+  auto& simulation_ref = simulation(sim);
+  {
+    const py::ReleaseGIL release_gil{};
+    simulation_ref.run(num_steps);
+  }
+  return simulation_ref.time();
+}
+
+// Get the simulation time.
+auto time(const py::Capsule& sim) -> real_t {
+  return simulation(sim).time();
+}
+
+// Get the particle field as a NumPy array that refers to the particle data.
+auto field(const py::Capsule& sim, std::string_view name) -> py::NDArray {
+  const auto& particles = simulation(sim).particles();
+  using PA = std::remove_cvref_t<decltype(particles)>;
+  std::optional<py::NDArray> result;
+  PA::fields.for_each([&particles, &sim, name, &result]<class F>(F f) {
+    if (f.field_name != name) return;
+    const auto vals = [&particles, f] {
+      if constexpr (PA::uniform_fields.contains(F{})) {
+        return std::span{&particles[f], 1};
+      } else {
+        return particles[f];
+      }
+    }();
+    if constexpr (requires { py::NDArray{vals, sim}; }) {
+      result.emplace(vals, sim);
+    }
+  });
+  if (!result.has_value()) {
+    py::raise_type_error("field '{}' is not available", name);
+  }
+  return std::move(*result);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Access the data series reader stored in the capsule.
+auto series_reader(const py::Capsule& reader) -> data::DataSeriesReader& {
+  return *static_cast<data::DataSeriesReader*>(reader.data());
+}
+
+// Start reading the data series of the storage ahead. Negative series index
+// counts from the last series.
+auto open_series(std::string_view path, int64_t series, size_t depth)
+    -> py::Capsule {
+  std::unique_ptr<data::DataSeriesReader> reader;
+  {
+    const py::ReleaseGIL release_gil{};
+    const data::DataStorage storage{std::filesystem::path{path},
+                                    data::OpenMode::read_only};
+    std::vector<data::DataSeriesID> series_ids;
+    for (const auto series_id : storage.series_ids()) {
+      series_ids.push_back(series_id);
+    }
+    const auto num_series = static_cast<int64_t>(series_ids.size());
+    const auto index = series < 0 ? series + num_series : series;
+    if (index < 0 || index >= num_series) {
+      TIT_THROW("Data series index {} is out of range, storage has {} series.",
+                series,
+                num_series);
+    }
+    reader = std::make_unique<data::DataSeriesReader>(
+        storage,
+        series_ids[static_cast<size_t>(index)],
+        depth);
+  }
+  return py::Capsule{std::move(reader)};
+}
+
+// Get the next time step of the data series, or `None` if all of them are
+// read. Data arrays are moved into the NumPy arrays without copying.
+auto next_time_step(const py::Capsule& reader) -> py::Object {
+  auto& reader_ref = series_reader(reader);
+  std::optional<data::PrefetchedTimeStep> step;
+  {
+    const py::ReleaseGIL release_gil{};
+    step = reader_ref.next();
+  }
+  if (!step.has_value()) return py::None();
+  const auto make_arrays = [](std::vector<data::PrefetchedArray>& arrays) {
+    py::Dict result;
+    for (auto& array : arrays) {
+      result.set_at(array.name, py::NDArray{array.type, std::move(array.data)});
+    }
+    return result;
+  };
+  py::Dict result;
+  result.set_at("time", step->time);
+  result.set_at("uniforms", make_arrays(step->uniforms));
+  result.set_at("varyings", make_arrays(step->varyings));
+  return result;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit::sph
+
+TIT_PYTHON_MODULE(_core, [](const py::Module& m) {
+  m.def<"dam_break",
+        &sph::dam_break,
+        py::Param<real_t, "height", real_t{0.6}>,
+        py::Param<size_t, "resolution", size_t{80}>>();
+  m.def<"dam_break_from_arrays",
+        &sph::dam_break_from_arrays,
+        py::Param<real_t, "height">,
+        py::Param<size_t, "resolution">,
+        py::Param<py::NDArray, "type">,
+        py::Param<py::NDArray, "r">,
+        py::Param<py::Optional<py::NDArray>, "v", &sph::no_array>,
+        py::Param<py::Optional<py::NDArray>, "rho", &sph::no_array>>();
+  m.def<"run",
+        &sph::run,
+        py::Param<py::Capsule, "sim">,
+        py::Param<size_t, "num_steps">>();
+  m.def<"time", &sph::time, py::Param<py::Capsule, "sim">>();
+  m.def<"field",
+        &sph::field,
+        py::Param<py::Capsule, "sim">,
+        py::Param<std::string_view, "name">>();
+  m.def<"open_series",
+        &sph::open_series,
+        py::Param<std::string_view, "path">,
+        py::Param<int64_t, "series", int64_t{-1}>,
+        py::Param<size_t, "depth", data::DataSeriesReader::DefaultDepth>>();
+  m.def<"next_time_step",
+        &sph::next_time_step,
+        py::Param<py::Capsule, "reader">>();
+});
@@ -6,7 +6,9 @@
 // IWYU pragma: private, include "tit/core/mat.hpp"
 #pragma once
 
+#include <algorithm>
 #include <expected>
+#include <numbers>
 #include <type_traits>
 #include <utility>
 
@@ -109,4 +111,111 @@ constexpr auto jacobi(Mat<Num, Dim> A,
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace impl {
+
+// Eigendecomposition of the symmetric 2x2 matrix `{{a, b}, {b, c}}`. The
+// eigenvectors are the axes rotated by the angle that zeroes the
+// off-diagonal element, the first one corresponds to the larger eigenvalue.
+template<class Num>
+constexpr auto sym_eig_2x2(const Num& a, const Num& b, const Num& c)
+    -> MatEig<Num, 2> {
+  const auto theta = Num{0.5} * atan2(Num{2.0} * b, a - c);
+  const auto cos_theta = cos(theta);
+  const auto sin_theta = sin(theta);
+  const auto mean = Num{0.5} * (a + c);
+  const auto radius = sqrt(pow2(Num{0.5} * (a - c)) + pow2(b));
+  return {
+      .vecs = Mat<Num, 2>{{cos_theta, sin_theta}, {-sin_theta, cos_theta}},
+      .vals = Vec{mean + radius, mean - radius},
+  };
+}
+
+// Eigendecomposition of the symmetric 3x3 matrix.
+//
+// Eigenvalues are found by the trigonometric solution of the characteristic
+// equation of the shifted and scaled matrix `B = (A - q * I) / p`, whose
+// eigenvalues are `2 * cos(phi + 2 * pi * k / 3)`. Eigenvector of the most
+// separated eigenvalue is the largest cross product of the rows of
+// `B - beta * I`, and the other two are found by the 2x2 eigendecomposition
+// within its orthogonal complement, so that the repeated eigenvalues are
+// handled without the special cases.
+template<class Num>
+constexpr auto sym_eig_3x3(Mat<Num, 3> A, const Num& eps) -> MatEig<Num, 3> {
+  // Restore the upper-triangular part.
+  A[0, 1] = A[1, 0];
+  A[0, 2] = A[2, 0];
+  A[1, 2] = A[2, 1];
+
+  // Shift and scale the matrix. If the eigenvalues are equal up to the
+  // threshold, the matrix is a multiple of the identity.
+  const auto q = tr(A) / Num{3.0};
+  const auto p_sqr = (pow2(A[0, 0] - q) + pow2(A[1, 1] - q) +
+                      pow2(A[2, 2] - q) +
+                      Num{2.0} * (pow2(A[1, 0]) + pow2(A[2, 0]) +
+                                  pow2(A[2, 1]))) /
+                     Num{6.0};
+  if (p_sqr <= pow2(eps * q)) return {.vecs = eye(A), .vals = Vec<Num, 3>(q)};
+  const auto p = sqrt(p_sqr);
+  const auto B = (A - eye(A, q)) / p;
+
+  // Compute the eigenvalues of the scaled matrix, which sum up to zero.
+  const auto half_det = Num{0.5} * dot(B[0], cross(B[1], B[2]));
+  const auto phi = acos(std::clamp(half_det, Num{-1.0}, Num{1.0})) / Num{3.0};
+  const auto beta_max = Num{2.0} * cos(phi);
+  const auto beta_min =
+      Num{2.0} * cos(phi + Num{2.0 / 3.0} * std::numbers::pi_v<Num>);
+  const auto beta_mid = -beta_max - beta_min;
+
+  // Compute the eigenvector of the most separated eigenvalue.
+  const auto beta =
+      beta_max - beta_mid >= beta_mid - beta_min ? beta_max : beta_min;
+  const auto C = B - eye(B, beta);
+  auto v = cross(C[0], C[1]);
+  for (const auto& candidate : {cross(C[0], C[2]), cross(C[1], C[2])}) {
+    if (norm2(candidate) > norm2(v)) v = candidate;
+  }
+  v = normalize(v);
+
+  // Build the orthonormal basis of the complement, and solve the restricted
+  // 2x2 eigenvalue problem.
+  const auto u = normalize(abs(v[0]) > abs(v[1]) ? Vec{-v[2], Num{}, v[0]} :
+                                                   Vec{Num{}, v[2], -v[1]});
+  const auto w = cross(v, u);
+  const auto Bu = B * u;
+  const auto Bw = B * w;
+  const auto [R, gamma] = sym_eig_2x2(dot(u, Bu), dot(w, Bu), dot(w, Bw));
+  return {
+      .vecs = Mat<Num, 3>{v,
+                          R[0, 0] * u + R[0, 1] * w,
+                          R[1, 0] * u + R[1, 1] * w},
+      .vals = Vec{q + p * beta, q + p * gamma[0], q + p * gamma[1]},
+  };
+}
+
+} // namespace impl
+
+/// Compute the eigenvectors and eigenvalues of a symmetric matrix.
+///
+/// Closed-form solutions are used for the matrices up to 3x3, and the Jacobi
+/// eigenvalue algorithm is used for the larger ones. The result has the
+/// same layout as the one of `jacobi`, and only the lower-triangular part of
+/// the input matrix is accessed. For the 3x3 matrices, eigenvalues that
+/// differ by less than `eps` relative to their mean are considered equal.
+template<class Num, size_t Dim>
+constexpr auto sym_eig(const Mat<Num, Dim>& A,
+                       std::type_identity_t<Num> eps = tiny_v<Num>)
+    -> MatEigResult<Num, Dim> {
+  if constexpr (Dim == 1) {
+    return MatEig{eye(A), Vec{A[0, 0]}};
+  } else if constexpr (Dim == 2) {
+    return impl::sym_eig_2x2(A[0, 0], A[1, 0], A[1, 1]);
+  } else if constexpr (Dim == 3) {
+    return impl::sym_eig_3x3(A, eps);
+  } else {
+    return jacobi(A, eps);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit
@@ -65,6 +65,116 @@ TEST_CASE("Mat::jacobi") {
   }
 }
 
+// Check that the rows of the matrix are orthonormal.
+template<class Num, size_t Dim>
+void check_orthonormal(const Mat<Num, Dim>& V) {
+  for (size_t i = 0; i < Dim; ++i) {
+    for (size_t j = 0; j < Dim; ++j) {
+      CHECK_APPROX_EQ(dot(V[i], V[j]), i == j ? Num{1.0} : Num{0.0});
+    }
+  }
+}
+
+TEST_CASE("Mat::sym_eig") {
+  SUBCASE("1x1") {
+    const Mat A{{2.0}};
+    const auto eig = sym_eig(A);
+    REQUIRE(eig);
+    const auto& [V, d] = *eig;
+    CHECK(d == Vec{2.0});
+    CHECK_APPROX_EQ(V * A, diag(d) * V);
+  }
+  SUBCASE("2x2") {
+    SUBCASE("indefinite") {
+      const Mat A{
+          {1.0, -2.0},
+          {-2.0, 1.0},
+      };
+      const auto eig = sym_eig(A);
+      REQUIRE(eig);
+      const auto& [V, d] = *eig;
+      CHECK_APPROX_EQ(d, Vec{3.0, -1.0});
+      check_orthonormal(V);
+      CHECK_APPROX_EQ(V * A, diag(d) * V);
+    }
+    SUBCASE("diagonal") {
+      const Mat A{
+          {1.0, 0.0},
+          {0.0, 5.0},
+      };
+      const auto eig = sym_eig(A);
+      REQUIRE(eig);
+      const auto& [V, d] = *eig;
+      CHECK_APPROX_EQ(d, Vec{5.0, 1.0});
+      CHECK_APPROX_EQ(V * A, diag(d) * V);
+    }
+  }
+  SUBCASE("3x3") {
+    SUBCASE("positive definite") {
+      const Mat A{
+          {2.0, 1.0, 1.0},
+          {1.0, 3.0, 0.0},
+          {1.0, 0.0, 4.0},
+      };
+      const auto eig = sym_eig(A);
+      REQUIRE(eig);
+      const auto& [V, d] = *eig;
+      check_orthonormal(V);
+      CHECK_APPROX_EQ(V * A, diag(d) * V);
+    }
+    SUBCASE("repeated eigenvalues") {
+      const Mat A{
+          {1.0, 1.0, 1.0},
+          {1.0, 1.0, 1.0},
+          {1.0, 1.0, 1.0},
+      };
+      const auto eig = sym_eig(A);
+      REQUIRE(eig);
+      const auto& [V, d] = *eig;
+      CHECK_APPROX_EQ(d, Vec{3.0, 0.0, 0.0});
+      check_orthonormal(V);
+      CHECK_APPROX_EQ(V * A, diag(d) * V);
+    }
+    SUBCASE("multiple of identity") {
+      const auto A = eye(Mat<double, 3>{}, 4.0);
+      const auto eig = sym_eig(A);
+      REQUIRE(eig);
+      const auto& [V, d] = *eig;
+      CHECK(d == Vec{4.0, 4.0, 4.0});
+      CHECK(V == eye(A));
+    }
+    SUBCASE("lower triangle") {
+      // Only the lower-triangular part is accessed.
+      const Mat A{
+          {2.0, 9.0, 9.0},
+          {1.0, 3.0, 9.0},
+          {1.0, 0.0, 4.0},
+      };
+      const Mat S{
+          {2.0, 1.0, 1.0},
+          {1.0, 3.0, 0.0},
+          {1.0, 0.0, 4.0},
+      };
+      const auto eig = sym_eig(A);
+      REQUIRE(eig);
+      const auto& [V, d] = *eig;
+      CHECK_APPROX_EQ(V * S, diag(d) * V);
+    }
+  }
+  SUBCASE("4x4") {
+    const Mat A{
+        {2.0, 1.0, 1.0, 0.0},
+        {1.0, 3.0, 0.0, 1.0},
+        {1.0, 0.0, 4.0, 1.0},
+        {0.0, 1.0, 1.0, 2.0},
+    };
+    const auto eig = sym_eig(A);
+    REQUIRE(eig);
+    const auto& [V, d] = *eig;
+    CHECK_APPROX_EQ(V * A, diag(d) * V);
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
@@ -6,14 +6,21 @@
 // IWYU pragma: private, include "tit/core/mat.hpp"
 #pragma once
 
+#include <array>
+#include <concepts>
 #include <expected>
+#include <span>
 #include <utility>
 
 #include "tit/core/_mat/mat.hpp"
 #include "tit/core/_mat/part.hpp"
+#include "tit/core/_mat/sym_mat.hpp"
 #include "tit/core/_mat/traits.hpp"
 #include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
 #include "tit/core/math.hpp"
+#include "tit/core/simd.hpp"
+#include "tit/core/vec.hpp"
 
 namespace tit {
 
@@ -226,16 +233,11 @@ private:
 
 }; // class FactLDL
 
-/// Compute the Modified Cholesky matrix factorization: `A = L * D * L^T`,
-/// where `D` is a diagonal matrix and `L` is a lower-triangular matrix with
-/// unit diagonal.
-///
-/// Suitable for symmetric matrices.
-///
-/// Only the lower-triangular part of the input matrix is accessed.
-template<class Num, size_t Dim>
-constexpr auto ldl(const Mat<Num, Dim>& A)
-    -> FactResult<FactLDL<Mat<Num, Dim>>> {
+namespace impl {
+
+// Factorize a square or a symmetric matrix, both provide `A[i, j]`.
+template<class Num, size_t Dim, class Matrix>
+constexpr auto ldl(const Matrix& A) -> FactResult<FactLDL<Mat<Num, Dim>>> {
   Mat<Num, Dim> LD;
   auto& L = LD;
   auto& D = LD;
@@ -258,6 +260,144 @@ constexpr auto ldl(const Mat<Num, Dim>& A)
   return FactLDL{std::move(LD)};
 }
 
+} // namespace impl
+
+/// Compute the Modified Cholesky matrix factorization: `A = L * D * L^T`,
+/// where `D` is a diagonal matrix and `L` is a lower-triangular matrix with
+/// unit diagonal.
+///
+/// Suitable for symmetric matrices.
+///
+/// Only the lower-triangular part of the input matrix is accessed.
+/// @{
+template<class Num, size_t Dim>
+constexpr auto ldl(const Mat<Num, Dim>& A)
+    -> FactResult<FactLDL<Mat<Num, Dim>>> {
+  return impl::ldl<Num, Dim>(A);
+}
+template<class Num, size_t Dim>
+constexpr auto ldl(const SymMat<Num, Dim>& A)
+    -> FactResult<FactLDL<Mat<Num, Dim>>> {
+  return impl::ldl<Num, Dim>(A);
+}
+/// @}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Modified Cholesky factorization of several matrices at once, see `ldl`.
+///
+/// Matrices are transposed, so that each entry of all the matrices occupies a
+/// single lane vector, and are factorized in one pass. Instead of the error,
+/// the success of each factorization is reported by a lane mask.
+template<simd::supported_type Num,
+         size_t Dim,
+         size_t Lanes = simd::max_reg_size_v<Num>>
+class FactLDLBatch final {
+public:
+
+  /// Vector of the values in each lane.
+  using LaneVec = Vec<Num, Lanes>;
+
+  /// Mask of the lanes.
+  using LaneMask = VecMask<Num, Lanes>;
+
+  /// Compute the factorizations of the matrices.
+  ///
+  /// Only the lower-triangular parts of the input matrices are accessed.
+  template<class Matrix>
+    requires std::same_as<Matrix, Mat<Num, Dim>> ||
+             std::same_as<Matrix, SymMat<Num, Dim>>
+  constexpr explicit FactLDLBatch(std::span<const Matrix> As) {
+    TIT_ASSERT(As.size() <= Lanes, "Too many matrices to factorize!");
+
+    // Transpose the matrices. Unused lanes hold the identity matrix.
+    for (size_t i = 0; i < Dim; ++i) {
+      LD_[i][i] = LaneVec(Num{1.0});
+      for (size_t j = 0; j <= i; ++j) {
+        for (size_t l = 0; l < As.size(); ++l) LD_[i][j][l] = As[l][i, j];
+      }
+    }
+    success_ = lane_mask<Num, Lanes>(As.size());
+
+    // Factorize the matrices, same as `ldl` does.
+    const LaneVec eps(tiny_v<Num>);
+    for (size_t i = 0; i < Dim; ++i) {
+      for (size_t j = 0; j < i; ++j) {
+        for (size_t k = 0; k < j; ++k) {
+          LD_[i][j] -= LD_[i][k] * LD_[k][k] * LD_[j][k];
+        }
+        LD_[i][j] /= LD_[j][j];
+      }
+      for (size_t k = 0; k < i; ++k) {
+        LD_[i][i] -= LD_[i][k] * LD_[k][k] * LD_[i][k];
+      }
+
+      // Nearly singular lanes fail. Their pivots are replaced, so that the
+      // subsequent operations stay finite.
+      const auto singular = LD_[i][i] <= eps && LD_[i][i] >= -eps;
+      success_ = success_ && !singular;
+      LD_[i][i] = select(singular, LaneVec(Num{1.0}), LD_[i][i]);
+    }
+  }
+
+  /// Mask of the lanes, where the factorization succeeded.
+  constexpr auto success() const noexcept -> const LaneMask& {
+    return success_;
+  }
+
+  /// Did the factorization of the matrix at lane succeed?
+  constexpr auto success(size_t l) const noexcept -> bool {
+    TIT_ASSERT(l < Lanes, "Lane index is out of range!");
+    return success_[l];
+  }
+
+  /// Solve the matrix equations, one right hand side per lane.
+  ///
+  /// Results in the failed lanes are meaningless.
+  constexpr auto solve(VecPack<Num, Dim, Lanes> x) const
+      -> VecPack<Num, Dim, Lanes> {
+    for (size_t i = 0; i < Dim; ++i) {
+      for (size_t j = 0; j < i; ++j) x[i] -= LD_[i][j] * x[j];
+    }
+    for (size_t i = 0; i < Dim; ++i) x[i] /= LD_[i][i];
+    for (ssize_t i = Dim - 1; i >= 0; --i) {
+      for (size_t j = i + 1; j < Dim; ++j) x[i] -= LD_[j][i] * x[j];
+    }
+    return x;
+  }
+
+private:
+
+  std::array<std::array<LaneVec, Dim>, Dim> LD_{};
+  LaneMask success_{};
+
+}; // class FactLDLBatch
+
+/// Compute the modified Cholesky factorizations of several matrices at once,
+/// see `FactLDLBatch`.
+/// @{
+template<size_t Lanes, class Num, size_t Dim>
+constexpr auto ldl_batch(std::span<const Mat<Num, Dim>> As)
+    -> FactLDLBatch<Num, Dim, Lanes> {
+  return FactLDLBatch<Num, Dim, Lanes>{As};
+}
+template<class Num, size_t Dim>
+constexpr auto ldl_batch(std::span<const Mat<Num, Dim>> As)
+    -> FactLDLBatch<Num, Dim> {
+  return FactLDLBatch<Num, Dim>{As};
+}
+template<size_t Lanes, class Num, size_t Dim>
+constexpr auto ldl_batch(std::span<const SymMat<Num, Dim>> As)
+    -> FactLDLBatch<Num, Dim, Lanes> {
+  return FactLDLBatch<Num, Dim, Lanes>{As};
+}
+template<class Num, size_t Dim>
+constexpr auto ldl_batch(std::span<const SymMat<Num, Dim>> As)
+    -> FactLDLBatch<Num, Dim> {
+  return FactLDLBatch<Num, Dim>{As};
+}
+/// @}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit
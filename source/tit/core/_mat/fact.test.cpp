@@ -3,6 +3,10 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <array>
+#include <span>
+
+#include "tit/core/basic_types.hpp"
 #include "tit/core/mat.hpp"
 #include "tit/core/math.hpp" // IWYU pragma: keep
 #include "tit/core/vec.hpp"
@@ -387,6 +391,48 @@ TEST_CASE("Mat::ldl") {
   }
 }
 
+TEST_CASE("Mat::ldl_batch") {
+  // clang-format off
+  const std::array<Mat<double, 3>, 3> As{
+      Mat{
+          {  4.0,  12.0, -16.0},
+          { 12.0,  37.0, -43.0},
+          {-16.0, -43.0,  98.0},
+      },
+      Mat{
+          {1.0, 2.0, 3.0},
+          {2.0, 4.0, 6.0},
+          {3.0, 6.0, 9.0},
+      },
+      Mat{
+          {2.0, 1.0, 0.0},
+          {1.0, 2.0, 1.0},
+          {0.0, 1.0, 2.0},
+      },
+  };
+  // clang-format on
+  const auto fact = ldl_batch<4>(std::span<const Mat<double, 3>>{As});
+  SUBCASE("success") {
+    // Singular matrix and the unused tail lane fail.
+    CHECK(fact.success() == VecMask<double, 4>{true, false, true, false});
+    CHECK(fact.success(0));
+    CHECK_FALSE(fact.success(1));
+  }
+  SUBCASE("solve") {
+    const std::array bs{Vec{1.0, 2.0, 3.0},
+                        Vec{4.0, 5.0, 6.0},
+                        Vec{7.0, 8.0, 9.0}};
+    const auto xs = fact.solve(VecPack<double, 3, 4>{bs});
+    for (size_t l = 0; l < bs.size(); ++l) {
+      if (!fact.success(l)) continue;
+      const auto scalar_fact = ldl(As[l]);
+      REQUIRE(scalar_fact);
+      CHECK_APPROX_EQ(xs.unpack(l), scalar_fact->solve(bs[l]));
+      CHECK_APPROX_EQ(As[l] * xs.unpack(l), bs[l]);
+    }
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
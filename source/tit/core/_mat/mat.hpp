@@ -10,10 +10,12 @@
 #include <array>
 #include <format>
 #include <initializer_list>
+#include <type_traits>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/math.hpp"
+#include "tit/core/serialization.hpp"
 #include "tit/core/tuple_utils.hpp"
 #include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
@@ -128,19 +130,21 @@ public:
 
   /// Matrix-vector multiplication.
   friend constexpr auto operator*(const Mat& A, const Row& b) -> Row {
+    // Accumulate the columns, so that each step is a single vector FMA.
     const auto T = transpose(A);
     auto r = T[0] * b[0];
-    for (size_t i = 1; i < Dim; ++i) r += T[i] * b[i];
+    for (size_t i = 1; i < Dim; ++i) r = fma(b[i], T[i], r);
     return r;
   }
 
   /// Matrix-matrix multiplication.
   friend constexpr auto operator*(const Mat& A, const Mat& B) -> Mat {
-    Mat R(0.0);
+    // Each row of the result is a combination of the rows of the right
+    // operand, which keeps the inner loop on the whole vector registers.
+    Mat R;
     for (size_t i = 0; i < Dim; ++i) {
-      for (size_t j = 0; j < Dim; ++j) {
-        for (size_t k = 0; k < Dim; ++k) R[i, j] += A[i, k] * B[k, j];
-      }
+      R[i] = A[i, 0] * B[0];
+      for (size_t k = 1; k < Dim; ++k) R[i] = fma(A[i, k], B[k], R[i]);
     }
     return R;
   }
@@ -249,6 +253,18 @@ constexpr auto outer_sqr(const Vec<Num, Dim>& a) -> Mat<Num, Dim> {
 }
 /// @}
 
+/// Rank-one update of the matrix, `A += q * outer(a, b)`.
+///
+/// Unlike the explicit sum, no temporary matrix is formed, and each row is
+/// updated with a single vector FMA.
+template<class Num, size_t Dim>
+constexpr void add_outer(Mat<Num, Dim>& A,
+                         const Vec<Num, Dim>& a,
+                         const Vec<Num, Dim>& b,
+                         std::type_identity_t<Num> q = Num{1}) {
+  for (size_t i = 0; i < Dim; ++i) A[i] = fma(q * a[i], b, A[i]);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 // Matrix approximate equality operator.
@@ -275,6 +291,12 @@ constexpr auto deserialize(Stream& in, Mat<Num, Dim>& mat) -> bool {
   return deserialize(in, mat.rows());
 }
 
+/// Matrices without padding are raw serializable.
+template<class Num, size_t Dim>
+inline constexpr bool is_raw_serializable_v<Mat<Num, Dim>> =
+    is_raw_serializable_v<Vec<Num, Dim>> &&
+    sizeof(Mat<Num, Dim>) == Dim * sizeof(Vec<Num, Dim>);
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit
@@ -243,6 +243,20 @@ TEST_CASE("Mat::operator*") {
                      17.0,
                      39.0,
                  });
+    CHECK((Mat{
+               {1.0, 2.0, 3.0},
+               {4.0, 5.0, 6.0},
+               {7.0, 8.0, 9.0},
+           } *
+           Vec{
+               1.0,
+               0.0,
+               -1.0,
+           }) == Vec{
+                     -2.0,
+                     -2.0,
+                     -2.0,
+                 });
   }
   SUBCASE("matrix-matrix multiplication") {
     CHECK((Mat{
@@ -256,6 +270,20 @@ TEST_CASE("Mat::operator*") {
                      {19.0, 22.0},
                      {43.0, 50.0},
                  });
+    CHECK((Mat{
+               {1.0, 2.0, 3.0},
+               {4.0, 5.0, 6.0},
+               {7.0, 8.0, 9.0},
+           } *
+           Mat{
+               {1.0, 0.0, 1.0},
+               {0.0, 1.0, 0.0},
+               {1.0, 0.0, -1.0},
+           }) == Mat{
+                     {4.0, 2.0, -2.0},
+                     {10.0, 5.0, -2.0},
+                     {16.0, 8.0, -2.0},
+                 });
   }
 }
 
@@ -317,6 +345,23 @@ TEST_CASE("Vec::outer_sqr") {
                                     });
 }
 
+TEST_CASE("Mat::add_outer") {
+  Mat M{
+      {1.0, 0.0},
+      {0.0, 1.0},
+  };
+  add_outer(M, Vec{1.0, 2.0}, Vec{3.0, 4.0});
+  CHECK(M == Mat{
+                 {4.0, 4.0},
+                 {6.0, 9.0},
+             });
+  add_outer(M, Vec{1.0, 2.0}, Vec{3.0, 4.0}, -2.0);
+  CHECK(M == Mat{
+                 {-2.0, -4.0},
+                 {-6.0, -7.0},
+             });
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("Mat::operator==") {
@@ -0,0 +1,257 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+// IWYU pragma: private, include "tit/core/mat.hpp"
+#pragma once
+
+#include <array>
+#include <format>
+#include <utility>
+
+#include "tit/core/_mat/mat.hpp"
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/serialization.hpp"
+#include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Symmetric square matrix.
+///
+/// Only the lower-triangular part is stored, packed row by row, so that a
+/// matrix takes `Dim * (Dim + 1) / 2` entries instead of `Dim * Dim`.
+template<class Num, size_t Dim>
+class SymMat final {
+public:
+
+  /// Number of the stored entries.
+  static constexpr size_t Size = Dim * (Dim + 1) / 2;
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Fill-initialize the matrix with zeroes.
+  constexpr SymMat() = default;
+
+  /// Initialize the matrix with the lower-triangular part of a square matrix.
+  constexpr explicit SymMat(const Mat<Num, Dim>& A) {
+    for (size_t i = 0; i < Dim; ++i) {
+      for (size_t j = 0; j <= i; ++j) entries_[index_(i, j)] = A[i, j];
+    }
+  }
+
+  /// Packed entries array.
+  constexpr auto entries(this auto&& self) noexcept -> auto&& {
+    return TIT_FORWARD_LIKE(self, self.entries_);
+  }
+
+  /// Matrix element at index. Elements `[i, j]` and `[j, i]` are the same.
+  constexpr auto operator[](this auto&& self, size_t i, size_t j) noexcept
+      -> auto&& {
+    TIT_ASSERT(i < Dim, "Row index is out of range!");
+    TIT_ASSERT(j < Dim, "Column index is out of range!");
+    return TIT_FORWARD_LIKE(self, self.entries_[index_(i, j)]);
+  }
+
+  /// Unpack the full square matrix.
+  constexpr auto full() const -> Mat<Num, Dim> {
+    Mat<Num, Dim> A;
+    for (size_t i = 0; i < Dim; ++i) {
+      for (size_t j = 0; j < Dim; ++j) A[i, j] = (*this)[i, j];
+    }
+    return A;
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Matrix unary plus.
+  friend constexpr auto operator+(const SymMat& A) noexcept -> SymMat {
+    return A;
+  }
+
+  /// Matrix addition.
+  friend constexpr auto operator+(const SymMat& A, const SymMat& B)
+      -> SymMat {
+    SymMat R;
+    for (size_t k = 0; k < Size; ++k) {
+      R.entries_[k] = A.entries_[k] + B.entries_[k];
+    }
+    return R;
+  }
+
+  /// Matrix addition with assignment.
+  friend constexpr auto operator+=(SymMat& A, const SymMat& B) -> SymMat& {
+    for (size_t k = 0; k < Size; ++k) A.entries_[k] += B.entries_[k];
+    return A;
+  }
+
+  /// Matrix negation.
+  friend constexpr auto operator-(const SymMat& A) -> SymMat {
+    SymMat R;
+    for (size_t k = 0; k < Size; ++k) R.entries_[k] = -A.entries_[k];
+    return R;
+  }
+
+  /// Matrix subtraction.
+  friend constexpr auto operator-(const SymMat& A, const SymMat& B)
+      -> SymMat {
+    SymMat R;
+    for (size_t k = 0; k < Size; ++k) {
+      R.entries_[k] = A.entries_[k] - B.entries_[k];
+    }
+    return R;
+  }
+
+  /// Matrix subtraction with assignment.
+  friend constexpr auto operator-=(SymMat& A, const SymMat& B) -> SymMat& {
+    for (size_t k = 0; k < Size; ++k) A.entries_[k] -= B.entries_[k];
+    return A;
+  }
+
+  /// Matrix multiplication by a scalar.
+  /// @{
+  friend constexpr auto operator*(const Num& a, const SymMat& B) -> SymMat {
+    return B * a;
+  }
+  friend constexpr auto operator*(const SymMat& A, const Num& b) -> SymMat {
+    SymMat R;
+    for (size_t k = 0; k < Size; ++k) R.entries_[k] = A.entries_[k] * b;
+    return R;
+  }
+  /// @}
+
+  /// Matrix multiplication by a scalar with assignment.
+  friend constexpr auto operator*=(SymMat& A, const Num& b) -> SymMat& {
+    for (size_t k = 0; k < Size; ++k) A.entries_[k] *= b;
+    return A;
+  }
+
+  /// Matrix-vector multiplication.
+  friend constexpr auto operator*(const SymMat& A, const Vec<Num, Dim>& b)
+      -> Vec<Num, Dim> {
+    Vec<Num, Dim> r;
+    for (size_t i = 0; i < Dim; ++i) {
+      r[i] = A[i, 0] * b[0];
+      for (size_t j = 1; j < Dim; ++j) r[i] += A[i, j] * b[j];
+    }
+    return r;
+  }
+
+  /// Matrix division by a scalar.
+  friend constexpr auto operator/(const SymMat& A, const Num& b) -> SymMat {
+    SymMat R;
+    for (size_t k = 0; k < Size; ++k) R.entries_[k] = A.entries_[k] / b;
+    return R;
+  }
+
+  /// Matrix division by a scalar with assignment.
+  friend constexpr auto operator/=(SymMat& A, const Num& b) -> SymMat& {
+    for (size_t k = 0; k < Size; ++k) A.entries_[k] /= b;
+    return A;
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Matrix exact equality operator.
+  friend constexpr auto operator==(const SymMat& A, const SymMat& B) noexcept
+      -> bool {
+    return A.entries_ == B.entries_;
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+private:
+
+  // Index of the element in the packed lower-triangular storage.
+  static constexpr auto index_(size_t i, size_t j) noexcept -> size_t {
+    if (i < j) std::swap(i, j);
+    return i * (i + 1) / 2 + j;
+  }
+
+  std::array<Num, Size> entries_{};
+
+}; // class SymMat
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Make a zero matrix.
+template<class Num, size_t Dim>
+constexpr auto zero(const SymMat<Num, Dim>& /*A*/) -> SymMat<Num, Dim> {
+  return {};
+}
+
+/// Matrix trace (sum of the diagonal elements).
+template<class Num, size_t Dim>
+constexpr auto tr(const SymMat<Num, Dim>& A) -> Num {
+  auto r = A[0, 0];
+  for (size_t i = 1; i < Dim; ++i) r += A[i, i];
+  return r;
+}
+
+/// Symmetric part of the vector outer product, assuming it is symmetric.
+///
+/// Only the lower-triangular entries `a[i] * b[j]`, `j <= i` are computed,
+/// which is exact when the vectors are parallel, e.g. for a position
+/// difference and a radial kernel gradient.
+template<class Num, size_t Dim>
+constexpr auto sym_outer(const Vec<Num, Dim>& a, const Vec<Num, Dim>& b)
+    -> SymMat<Num, Dim> {
+  SymMat<Num, Dim> R;
+  for (size_t i = 0; i < Dim; ++i) {
+    for (size_t j = 0; j <= i; ++j) R[i, j] = a[i] * b[j];
+  }
+  return R;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Matrix approximate equality operator.
+template<class Num, size_t Dim>
+constexpr auto approx_equal_to(const SymMat<Num, Dim>& A,
+                               const SymMat<Num, Dim>& B) noexcept -> bool {
+  for (size_t k = 0; k < SymMat<Num, Dim>::Size; ++k) {
+    if (!approx_equal_to(A.entries()[k], B.entries()[k])) return false;
+  }
+  return true;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Serialize a matrix into the output stream.
+template<class Stream, class Num, size_t Dim>
+constexpr void serialize(Stream& out, const SymMat<Num, Dim>& mat) {
+  serialize(out, mat.entries());
+}
+
+/// Deserialize a matrix from the input stream.
+template<class Stream, class Num, size_t Dim>
+constexpr auto deserialize(Stream& in, SymMat<Num, Dim>& mat) -> bool {
+  return deserialize(in, mat.entries());
+}
+
+/// Matrices without padding are raw serializable.
+template<class Num, size_t Dim>
+inline constexpr bool is_raw_serializable_v<SymMat<Num, Dim>> =
+    is_raw_serializable_v<Num> &&
+    sizeof(SymMat<Num, Dim>) == SymMat<Num, Dim>::Size * sizeof(Num);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
+
+// Symmetric matrix formatter.
+template<class Num, tit::size_t Dim>
+struct std::formatter<tit::SymMat<Num, Dim>> :
+    std::formatter<tit::Mat<Num, Dim>> {
+  static constexpr auto format(const tit::SymMat<Num, Dim>& A,
+                               std::format_context& context) {
+    return std::formatter<tit::Mat<Num, Dim>>::format(A.full(), context);
+  }
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
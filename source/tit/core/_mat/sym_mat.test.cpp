@@ -0,0 +1,118 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <format>
+#include <span>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/mat.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/core/serialization.testing.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("SymMat") {
+  SUBCASE("zero initialization") {
+    const SymMat<double, 3> A{};
+    CHECK(A.full() == Mat<double, 3>{});
+  }
+  SUBCASE("initialization from a square matrix") {
+    // Only the lower-triangular part is copied.
+    const SymMat A{Mat{
+        {1.0, 9.0, 9.0},
+        {2.0, 3.0, 9.0},
+        {4.0, 5.0, 6.0},
+    }};
+    CHECK(A.entries() == std::array{1.0, 2.0, 3.0, 4.0, 5.0, 6.0});
+    CHECK(A.full() == Mat{
+                          {1.0, 2.0, 4.0},
+                          {2.0, 3.0, 5.0},
+                          {4.0, 5.0, 6.0},
+                      });
+  }
+  SUBCASE("element subscript") {
+    SymMat<double, 2> A;
+    A[0, 1] = 2.0;
+    CHECK(A[1, 0] == 2.0);
+    CHECK(A[0, 0] == 0.0);
+  }
+}
+
+TEST_CASE("SymMat::operators") {
+  const SymMat A{Mat{{1.0, 2.0}, {2.0, 3.0}}};
+  const SymMat B{Mat{{4.0, 5.0}, {5.0, 6.0}}};
+  CHECK(+A == A);
+  CHECK(A + B == SymMat{Mat{{5.0, 7.0}, {7.0, 9.0}}});
+  CHECK(B - A == SymMat{Mat{{3.0, 3.0}, {3.0, 3.0}}});
+  CHECK(-A == SymMat{Mat{{-1.0, -2.0}, {-2.0, -3.0}}});
+  CHECK(2.0 * A == SymMat{Mat{{2.0, 4.0}, {4.0, 6.0}}});
+  CHECK(A / 2.0 == SymMat{Mat{{0.5, 1.0}, {1.0, 1.5}}});
+  CHECK(A * Vec{1.0, 2.0} == Vec{5.0, 8.0});
+  auto C = A;
+  C += B;
+  C -= A;
+  C *= 2.0;
+  C /= 4.0;
+  CHECK(C == B / 2.0);
+}
+
+TEST_CASE("SymMat::tr") {
+  CHECK(tr(SymMat{Mat{{1.0, 2.0}, {2.0, 3.0}}}) == 4.0);
+}
+
+TEST_CASE("Vec::sym_outer") {
+  const Vec a{1.0, 2.0, 3.0};
+  const Vec b{2.0, 4.0, 6.0};
+  CHECK(sym_outer(a, b) == SymMat{outer(a, b)});
+  CHECK(sym_outer(a, b).full() == outer(a, b));
+}
+
+TEST_CASE("SymMat::ldl") {
+  const Mat A{
+      {4.0, 12.0, -16.0},
+      {12.0, 37.0, -43.0},
+      {-16.0, -43.0, 98.0},
+  };
+  const auto fact = ldl(SymMat{A});
+  REQUIRE(fact);
+  const auto expected_fact = ldl(A);
+  REQUIRE(expected_fact);
+  CHECK(fact->L() == expected_fact->L());
+  CHECK(fact->D() == expected_fact->D());
+  SUBCASE("batch") {
+    const std::array As{SymMat{A}};
+    const auto batch = ldl_batch<4>(std::span<const SymMat<double, 3>>{As});
+    CHECK(batch.success() == VecMask<double, 4>{true, false, false, false});
+    const std::array bs{Vec{1.0, 2.0, 3.0}};
+    const auto xs = batch.solve(VecPack<double, 3, 4>{bs});
+    CHECK_APPROX_EQ(xs.unpack(0), expected_fact->solve(bs[0]));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("SymMat::serialize") {
+  const SymMat A{Mat<float32_t, 3>{
+      {1.0F, 2.0F, 4.0F},
+      {2.0F, 3.0F, 5.0F},
+      {4.0F, 5.0F, 6.0F},
+  }};
+  testing::test_serialization(A, 6 * sizeof(float32_t));
+}
+
+TEST_CASE("SymMat::format") {
+  CHECK(std::format("{}", SymMat{Mat{{1, 2}, {2, 3}}}) == "1 2 2 3");
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
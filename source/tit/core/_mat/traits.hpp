@@ -10,6 +10,7 @@
 #include <type_traits>
 
 #include "tit/core/_mat/mat.hpp"
+#include "tit/core/_mat/sym_mat.hpp"
 #include "tit/core/basic_types.hpp"
 
 namespace tit {
@@ -27,6 +28,17 @@ inline constexpr bool is_mat_v<Mat<Num, Dim>> = true;
 template<class T>
 inline constexpr bool is_mat_v = impl::is_mat_v<T>;
 
+namespace impl {
+template<class>
+inline constexpr bool is_sym_mat_v = false;
+template<class Num, size_t Dim>
+inline constexpr bool is_sym_mat_v<SymMat<Num, Dim>> = true;
+} // namespace impl
+
+/// Is the type a specialization of a symmetric matrix type?
+template<class T>
+inline constexpr bool is_sym_mat_v = impl::is_sym_mat_v<T>;
+
 /// Matrix row type.
 template<class Mat>
   requires is_mat_v<Mat>
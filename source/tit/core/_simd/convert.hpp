@@ -0,0 +1,142 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+// IWYU pragma: private, include "tit/core/simd.hpp"
+#pragma once
+
+#include <concepts>
+#include <span>
+
+#include <hwy/highway.h>
+
+#include "tit/core/_simd/traits.hpp"
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+
+namespace tit::simd {
+
+namespace hn = hwy::HWY_NAMESPACE;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Half-precision floating-point type, IEEE 754 binary16.
+///
+/// This is a storage-only type: values are converted to the wider
+/// floating-point types for the arithmetic, see `convert`.
+using float16_t = hwy::float16_t;
+
+/// Brain floating-point type, the upper half of IEEE 754 binary32.
+///
+/// This is a storage-only type, see `float16_t`.
+using bfloat16_t = hwy::bfloat16_t;
+
+/// Is the type a 16-bit floating-point type?
+template<class Num>
+concept half_float =
+    std::same_as<Num, float16_t> || std::same_as<Num, bfloat16_t>;
+
+/// Is the type a floating-point type that could be converted?
+template<class Num>
+concept convertible_float = half_float<Num> ||
+                            std::same_as<Num, float32_t> ||
+                            std::same_as<Num, float64_t>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+// Convert the value to a 32-bit floating-point number.
+template<convertible_float From>
+auto to_float32(From val) noexcept -> float32_t {
+  if constexpr (std::same_as<From, float16_t>) {
+    return hwy::F32FromF16(val);
+  } else if constexpr (std::same_as<From, bfloat16_t>) {
+    return hwy::F32FromBF16(val);
+  } else {
+    return static_cast<float32_t>(val);
+  }
+}
+
+// Convert the 32-bit floating-point number to a value.
+template<convertible_float To>
+auto from_float32(float32_t val) noexcept -> To {
+  if constexpr (std::same_as<To, float16_t>) {
+    return hwy::F16FromF32(val);
+  } else if constexpr (std::same_as<To, bfloat16_t>) {
+    return hwy::BF16FromF32(val);
+  } else {
+    return static_cast<To>(val);
+  }
+}
+
+// Narrow the floating-point numbers to the 16-bit ones.
+template<half_float To, class From>
+void narrow(std::span<const From> from, std::span<To> to) noexcept {
+  const hn::FixedTag<From, max_reg_size_v<From>> df;
+  const hn::Rebind<float32_t, decltype(df)> d32;
+  const hn::Rebind<To, decltype(df)> dh;
+  const auto size = from.size();
+  size_t i = 0;
+  for (; i + hn::Lanes(df) <= size; i += hn::Lanes(df)) {
+    const auto v = hn::LoadU(df, from.data() + i);
+    if constexpr (std::same_as<From, float64_t>) {
+      // Note: there is no direct conversion on most of the targets.
+      hn::StoreU(hn::DemoteTo(dh, hn::DemoteTo(d32, v)), dh, to.data() + i);
+    } else {
+      hn::StoreU(hn::DemoteTo(dh, v), dh, to.data() + i);
+    }
+  }
+  for (; i < size; ++i) {
+    to[i] = from_float32<To>(static_cast<float32_t>(from[i]));
+  }
+}
+
+// Widen the 16-bit floating-point numbers.
+template<class To, half_float From>
+void widen(std::span<const From> from, std::span<To> to) noexcept {
+  const hn::FixedTag<To, max_reg_size_v<To>> dt;
+  const hn::Rebind<float32_t, decltype(dt)> d32;
+  const hn::Rebind<From, decltype(dt)> dh;
+  const auto size = from.size();
+  size_t i = 0;
+  for (; i + hn::Lanes(dt) <= size; i += hn::Lanes(dt)) {
+    const auto v = hn::LoadU(dh, from.data() + i);
+    if constexpr (std::same_as<To, float64_t>) {
+      hn::StoreU(hn::PromoteTo(dt, hn::PromoteTo(d32, v)), dt, to.data() + i);
+    } else {
+      hn::StoreU(hn::PromoteTo(dt, v), dt, to.data() + i);
+    }
+  }
+  for (; i < size; ++i) to[i] = static_cast<To>(to_float32(from[i]));
+}
+
+} // namespace impl
+
+/// Convert the floating-point numbers to a different precision.
+///
+/// Values are rounded to the nearest representable ones. Conversions between
+/// the 16-bit and the wider types are vectorized, 64-bit numbers are narrowed
+/// through the 32-bit ones.
+template<convertible_float To, convertible_float From>
+void convert(std::span<const From> from, std::span<To> to) noexcept {
+  TIT_ASSERT(from.size() == to.size(), "Size mismatch!");
+  if constexpr (half_float<To> && !half_float<From>) {
+    impl::narrow(from, to);
+  } else if constexpr (!half_float<To> && half_float<From>) {
+    impl::widen(from, to);
+  } else {
+    for (size_t i = 0; i < from.size(); ++i) {
+      if constexpr (half_float<To>) {
+        to[i] = impl::from_float32<To>(impl::to_float32(from[i]));
+      } else {
+        to[i] = static_cast<To>(from[i]);
+      }
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::simd
@@ -0,0 +1,87 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <cmath>
+#include <concepts>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/simd.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Values that are exactly representable in all the 16-bit types. Size is not
+// a multiple of the register size, so that the scalar tail is covered.
+auto exact_vals() -> std::vector<float64_t> {
+  std::vector<float64_t> vals;
+  for (size_t i = 0; i < 37; ++i) {
+    vals.push_back(0.25 * static_cast<float64_t>(i) - 4.0);
+  }
+  return vals;
+}
+
+// Narrow the values, and then widen them back.
+template<class Half, class Float>
+auto round_trip(std::span<const Float> vals) -> std::vector<Float> {
+  std::vector<Half> narrowed(vals.size());
+  simd::convert(vals, std::span{narrowed});
+  std::vector<Float> widened(vals.size());
+  simd::convert(std::span<const Half>{narrowed}, std::span{widened});
+  return widened;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE_TEMPLATE("simd::convert",
+                   Half,
+                   simd::float16_t,
+                   simd::bfloat16_t) {
+  SUBCASE("exact values") {
+    const auto vals = exact_vals();
+    CHECK(round_trip<Half>(std::span{vals}) == vals);
+    const std::vector<float32_t> vals_32(vals.begin(), vals.end());
+    CHECK(round_trip<Half>(std::span{vals_32}) == vals_32);
+  }
+  SUBCASE("rounding") {
+    // Relative error of the rounding to nearest must be within the half of
+    // the machine epsilon: 2^-11 for float16, and 2^-8 for bfloat16.
+    constexpr auto max_error =
+        std::same_as<Half, simd::float16_t> ? 0x1p-11 : 0x1p-8;
+    std::vector<float64_t> vals;
+    for (size_t i = 1; i <= 100; ++i) {
+      vals.push_back(std::numbers::pi * static_cast<float64_t>(i));
+    }
+    const auto result = round_trip<Half>(std::span<const float64_t>{vals});
+    for (size_t i = 0; i < vals.size(); ++i) {
+      CHECK(std::abs(result[i] - vals[i]) <= max_error * vals[i]);
+    }
+  }
+  SUBCASE("special values") {
+    const std::vector<float32_t> vals{
+        std::numeric_limits<float32_t>::infinity(),
+        -std::numeric_limits<float32_t>::infinity(),
+        std::numeric_limits<float32_t>::quiet_NaN(),
+        0.0F,
+    };
+    const auto result = round_trip<Half>(std::span{vals});
+    CHECK(result[0] == vals[0]);
+    CHECK(result[1] == vals[1]);
+    CHECK(std::isnan(result[2]));
+    CHECK(result[3] == 0.0F);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <span>
+#include <utility>
 
 #include <hwy/highway.h>
 
@@ -249,6 +250,14 @@ inline auto ceil(const Reg<Num, Size>& a) noexcept -> Reg<Num, Size> {
   return hn::Ceil(a.base);
 }
 
+/// SIMD `sqrt` function overload.
+template<class Num, size_t Size>
+  requires supported<Num, Size>
+[[gnu::always_inline]]
+inline auto sqrt(const Reg<Num, Size>& a) noexcept -> Reg<Num, Size> {
+  return hn::Sqrt(a.base);
+}
+
 /// SIMD fused multiply-add operation.
 template<class Num, size_t Size>
   requires supported<Num, Size>
@@ -287,4 +296,58 @@ inline auto max_value(const Reg<Num, Size>& a) noexcept -> Num {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// SIMD gather: load the elements of @p base at the @p indices.
+template<class Num, size_t Size>
+  requires supported<Num, Size>
+[[gnu::always_inline]]
+inline auto gather(std::span<const Num> base,
+                   const Reg<index_t<Num>, Size>& indices) noexcept
+    -> Reg<Num, Size> {
+  TIT_ASSERT(min_value(indices) >= 0 &&
+                 std::cmp_less(max_value(indices), base.size()),
+             "Gather index is out of range!");
+  return hn::GatherIndex(typename Reg<Num, Size>::Tag{},
+                         base.data(),
+                         indices.base);
+}
+
+/// SIMD scatter: store the elements of the register into @p base at the
+/// @p indices. If indices repeat, the element with the largest lane wins.
+template<class Num, size_t Size>
+  requires supported<Num, Size>
+[[gnu::always_inline]]
+inline void scatter(const Reg<Num, Size>& a,
+                    std::span<Num> base,
+                    const Reg<index_t<Num>, Size>& indices) noexcept {
+  TIT_ASSERT(min_value(indices) >= 0 &&
+                 std::cmp_less(max_value(indices), base.size()),
+             "Scatter index is out of range!");
+  hn::ScatterIndex(a.base,
+                   typename Reg<Num, Size>::Tag{},
+                   base.data(),
+                   indices.base);
+}
+
+/// SIMD compress-store: store the elements, selected by the mask,
+/// contiguously into memory, keeping their order.
+///
+/// Memory past the stored elements is left intact, but must still hold at
+/// least the full register.
+///
+/// @returns Number of the stored elements.
+template<class Num, size_t Size>
+  requires supported<Num, Size>
+[[gnu::always_inline]]
+inline auto compress_store(const RegMask<Num, Size>& m,
+                           const Reg<Num, Size>& a,
+                           std::span<Num> span) noexcept -> size_t {
+  TIT_ASSERT(span.size() >= Size, "Data size is too small!");
+  return hn::CompressBlendedStore(a.base,
+                                  m.base,
+                                  typename Reg<Num, Size>::Tag{},
+                                  span.data());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::simd
@@ -4,6 +4,7 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <array>
+#include <span>
 
 #include "tit/core/simd.hpp"
 
@@ -18,6 +19,8 @@ using FloatReg = simd::Reg<float, 4>;
 using FloatMask = simd::Mask<float>;
 using FloatMaskArray = std::array<FloatMask, 4>;
 using FloatRegMask = simd::RegMask<float, 4>;
+using IndexArray = std::array<simd::index_t<float>, 4>;
+using IndexReg = simd::Reg<simd::index_t<float>, 4>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -198,6 +201,13 @@ TEST_CASE("simd::Reg::ceil") {
   CHECK(out == FloatArray{2.0F, 3.0F, 4.0F, 5.0F});
 }
 
+TEST_CASE("simd::Reg::sqrt") {
+  const auto r = simd::sqrt(FloatReg{FloatArray{1.0F, 4.0F, 9.0F, 16.0F}});
+  FloatArray out{};
+  r.store(out);
+  CHECK(out == FloatArray{1.0F, 2.0F, 3.0F, 4.0F});
+}
+
 TEST_CASE("simd::Reg::fma") {
   const auto r = simd::fma(FloatReg{FloatArray{1.0F, 2.0F, 3.0F, 4.0F}},
                            FloatReg{FloatArray{5.0F, 6.0F, 7.0F, 8.0F}},
@@ -266,5 +276,39 @@ TEST_CASE("simd::Reg::max_value") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("simd::Reg::gather") {
+  const std::array base{0.0F, 1.0F, 2.0F, 3.0F, 4.0F, 5.0F, 6.0F, 7.0F};
+  const IndexReg indices{IndexArray{7, 0, 3, 3}};
+  const auto r = simd::gather(std::span<const float>{base}, indices);
+  FloatArray out{};
+  r.store(out);
+  CHECK(out == FloatArray{7.0F, 0.0F, 3.0F, 3.0F});
+}
+
+TEST_CASE("simd::Reg::scatter") {
+  std::array<float, 8> base{};
+  simd::scatter(FloatReg{FloatArray{1.0F, 2.0F, 3.0F, 4.0F}},
+                std::span<float>{base},
+                IndexReg{IndexArray{6, 1, 4, 0}});
+  CHECK(base == std::array{4.0F, 2.0F, 0.0F, 0.0F, 3.0F, 0.0F, 1.0F, 0.0F});
+}
+
+TEST_CASE("simd::Reg::compress_store") {
+  const FloatReg r{FloatArray{1.0F, 2.0F, 3.0F, 4.0F}};
+  SUBCASE("some") {
+    FloatArray out{-1.0F, -1.0F, -1.0F, -1.0F};
+    const FloatRegMask m{FloatMaskArray{false, true, false, true}};
+    CHECK(simd::compress_store(m, r, std::span<float>{out}) == 2);
+    CHECK(out == FloatArray{2.0F, 4.0F, -1.0F, -1.0F});
+  }
+  SUBCASE("none") {
+    FloatArray out{-1.0F, -1.0F, -1.0F, -1.0F};
+    CHECK(simd::compress_store(FloatRegMask{}, r, std::span<float>{out}) == 0);
+    CHECK(out == FloatArray{-1.0F, -1.0F, -1.0F, -1.0F});
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
@@ -0,0 +1,123 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+// IWYU pragma: private, include "tit/core/simd.hpp"
+#pragma once
+
+#include <concepts>
+#include <limits>
+#include <numbers>
+
+#include <hwy/contrib/math/math-inl.h>
+#include <hwy/highway.h>
+
+#include "tit/core/_simd/reg.hpp"
+#include "tit/core/_simd/traits.hpp"
+#include "tit/core/basic_types.hpp"
+
+namespace tit::simd {
+
+namespace hn = hwy::HWY_NAMESPACE;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Accuracy policy of the SIMD math functions.
+enum class Accuracy : uint8_t {
+  precise, ///< Error is within a few ULP.
+  fast,    ///< Relative error is within `5.0e-7`, about single precision.
+};
+
+/// SIMD math function argument type.
+template<class Num, size_t Size>
+concept math_supported = std::floating_point<Num> && supported<Num, Size>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+// Compute `2^x` with a polynomial. `x` is split into the integer part, that
+// goes straight into the exponent bits, and the fractional part in
+// `[-0.5, 0.5]`, where the degree 6 Taylor expansion of `2^f` is accurate to
+// `1.2e-7`. Arguments are clamped to the range of normal numbers.
+template<class Num, size_t Size>
+[[gnu::always_inline]]
+inline auto exp2_fast(const Reg<Num, Size>& a) noexcept -> Reg<Num, Size> {
+  using Tag = Reg<Num, Size>::Tag;
+  using Limits = std::numeric_limits<Num>;
+  const Tag d{};
+  const hn::RebindToSigned<Tag> di{};
+  constexpr auto MinExp = static_cast<Num>(Limits::min_exponent);
+  constexpr auto MaxExp = static_cast<Num>(Limits::max_exponent - 2);
+  const auto x =
+      hn::Min(hn::Max(a.base, hn::Set(d, MinExp)), hn::Set(d, MaxExp));
+  const auto n = hn::Round(x);
+  const auto f = hn::Sub(x, n);
+  auto p = hn::Set(d, Num{1.5403530393381608e-4});
+  p = hn::MulAdd(p, f, hn::Set(d, Num{1.3333558146428443e-3}));
+  p = hn::MulAdd(p, f, hn::Set(d, Num{9.6181291076284772e-3}));
+  p = hn::MulAdd(p, f, hn::Set(d, Num{5.5504108664821580e-2}));
+  p = hn::MulAdd(p, f, hn::Set(d, Num{2.4022650695910071e-1}));
+  p = hn::MulAdd(p, f, hn::Set(d, Num{6.9314718055994531e-1}));
+  p = hn::MulAdd(p, f, hn::Set(d, Num{1.0}));
+  constexpr auto MantissaBits = Limits::digits - 1;
+  const auto e = hn::ShiftLeft<MantissaBits>(hn::ConvertTo(di, n));
+  return hn::BitCast(d, hn::Add(hn::BitCast(di, p), e));
+}
+
+} // namespace impl
+
+/// SIMD `exp` function overload.
+template<Accuracy Acc = Accuracy::precise, class Num, size_t Size>
+  requires math_supported<Num, Size>
+[[gnu::always_inline]]
+inline auto exp(const Reg<Num, Size>& a) noexcept -> Reg<Num, Size> {
+  if constexpr (Acc == Accuracy::fast) {
+    return impl::exp2_fast(a * Reg<Num, Size>(std::numbers::log2e_v<Num>));
+  } else {
+    return hn::Exp(typename Reg<Num, Size>::Tag{}, a.base);
+  }
+}
+
+/// SIMD `log` function overload.
+///
+/// There is no fast variant, the accuracy policy is accepted for uniformity.
+template<Accuracy Acc = Accuracy::precise, class Num, size_t Size>
+  requires math_supported<Num, Size>
+[[gnu::always_inline]]
+inline auto log(const Reg<Num, Size>& a) noexcept -> Reg<Num, Size> {
+  return hn::Log(typename Reg<Num, Size>::Tag{}, a.base);
+}
+
+/// SIMD `pow` function overload, computed as `exp(b * log(a))`.
+///
+/// Base must be positive. Error grows with the magnitude of `b * log(a)`.
+template<Accuracy Acc = Accuracy::precise, class Num, size_t Size>
+  requires math_supported<Num, Size>
+[[gnu::always_inline]]
+inline auto pow(const Reg<Num, Size>& a, const Reg<Num, Size>& b) noexcept
+    -> Reg<Num, Size> {
+  return exp<Acc>(b * log<Acc>(a));
+}
+
+/// SIMD reciprocal square root function.
+template<Accuracy Acc = Accuracy::precise, class Num, size_t Size>
+  requires math_supported<Num, Size>
+[[gnu::always_inline]]
+inline auto rsqrt(const Reg<Num, Size>& a) noexcept -> Reg<Num, Size> {
+  using Tag = Reg<Num, Size>::Tag;
+  const Tag d{};
+  if constexpr (Acc == Accuracy::fast) {
+    // Refine the hardware estimate with a single Newton-Raphson step.
+    const auto r = hn::ApproximateReciprocalSqrt(a.base);
+    const auto h = hn::Mul(hn::Mul(hn::Set(d, Num{0.5}), a.base), r);
+    return hn::Mul(r, hn::NegMulAdd(h, r, hn::Set(d, Num{1.5})));
+  } else {
+    return hn::Div(hn::Set(d, Num{1.0}), hn::Sqrt(a.base));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::simd
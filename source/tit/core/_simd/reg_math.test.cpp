@@ -0,0 +1,84 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <cmath>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/simd.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// 128-bit floating point SIMD appears to be supported on all platforms.
+using FloatArray = std::array<float, 4>;
+using FloatReg = simd::Reg<float, 4>;
+
+// Check that the register matches the expected values.
+void check_values(const FloatReg& r, const FloatArray& expected) {
+  FloatArray out{};
+  r.store(out);
+  for (size_t i = 0; i < out.size(); ++i) CHECK_APPROX_EQ(out[i], expected[i]);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("simd::exp") {
+  const FloatArray in{-10.0F, -1.0F, 0.5F, 20.0F};
+  const FloatArray expected{std::exp(-10.0F),
+                            std::exp(-1.0F),
+                            std::exp(0.5F),
+                            std::exp(20.0F)};
+  SUBCASE("precise") {
+    check_values(simd::exp(FloatReg{in}), expected);
+  }
+  SUBCASE("fast") {
+    check_values(simd::exp<simd::Accuracy::fast>(FloatReg{in}), expected);
+  }
+}
+
+TEST_CASE("simd::log") {
+  const FloatArray in{0.25F, 1.0F, 2.0F, 100.0F};
+  const FloatArray expected{std::log(0.25F),
+                            std::log(1.0F),
+                            std::log(2.0F),
+                            std::log(100.0F)};
+  check_values(simd::log(FloatReg{in}), expected);
+}
+
+TEST_CASE("simd::pow") {
+  // Tait equation of state raises the density ratio to the power of 7.
+  const FloatArray in{0.9F, 1.0F, 1.1F, 2.0F};
+  const FloatReg power(7.0F);
+  const FloatArray expected{std::pow(0.9F, 7.0F),
+                            1.0F,
+                            std::pow(1.1F, 7.0F),
+                            128.0F};
+  SUBCASE("precise") {
+    check_values(simd::pow(FloatReg{in}, power), expected);
+  }
+  SUBCASE("fast") {
+    check_values(simd::pow<simd::Accuracy::fast>(FloatReg{in}, power),
+                 expected);
+  }
+}
+
+TEST_CASE("simd::rsqrt") {
+  const FloatArray in{0.25F, 1.0F, 4.0F, 100.0F};
+  const FloatArray expected{2.0F, 1.0F, 0.5F, 0.1F};
+  SUBCASE("precise") {
+    check_values(simd::rsqrt(FloatReg{in}), expected);
+  }
+  SUBCASE("fast") {
+    check_values(simd::rsqrt<simd::Accuracy::fast>(FloatReg{in}), expected);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
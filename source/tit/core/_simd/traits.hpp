@@ -10,6 +10,8 @@
 #include <concepts>
 #include <type_traits>
 
+#include <hwy/base.h>
+
 #include "tit/core/basic_types.hpp"
 #include "tit/core/type_utils.hpp"
 
@@ -145,6 +147,11 @@ struct fixed_width_type<Float> : std::type_identity<float64_t> {};
 
 } // namespace impl
 
+/// Signed integer type of the same width as the numeric type. Registers of
+/// this type hold the element indices for the gather and scatter operations.
+template<supported_type Num>
+using index_t = hwy::MakeSigned<impl::fixed_width_type_t<Num>>;
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit::simd
@@ -10,12 +10,14 @@
 #include <array>
 #include <concepts>
 #include <format>
+#include <type_traits>
 #include <utility>
 
 #include "tit/core/_vec/vec_mask.hpp"
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/math.hpp"
+#include "tit/core/serialization.hpp"
 #include "tit/core/simd.hpp"
 #include "tit/core/tuple_utils.hpp"
 #include "tit/core/utils.hpp"
@@ -501,6 +503,113 @@ constexpr auto ceil(const Vec<Num, Dim>& a) -> Vec<Num, Dim> {
   return r;
 }
 
+/// Compute the square root of vector element.
+template<class Num, size_t Dim>
+constexpr auto sqrt(const Vec<Num, Dim>& a) -> Vec<Num, Dim> {
+  Vec<Num, Dim> r;
+  TIT_IF_SIMD_AVALIABLE(Num) {
+    for (size_t i = 0; i < Vec<Num, Dim>::RegCount; ++i) {
+      r.reg(i) = simd::sqrt(a.reg(i));
+    }
+    return r;
+  }
+  for (size_t i = 0; i < Dim; ++i) r[i] = sqrt(a[i]);
+  return r;
+}
+
+/// Compute the reciprocal square root of vector element.
+template<simd::Accuracy Acc = simd::Accuracy::precise, class Num, size_t Dim>
+constexpr auto rsqrt(const Vec<Num, Dim>& a) -> Vec<Num, Dim> {
+  Vec<Num, Dim> r;
+  TIT_IF_SIMD_AVALIABLE(Num) {
+    for (size_t i = 0; i < Vec<Num, Dim>::RegCount; ++i) {
+      r.reg(i) = simd::rsqrt<Acc>(a.reg(i));
+    }
+    return r;
+  }
+  for (size_t i = 0; i < Dim; ++i) r[i] = inverse(sqrt(a[i]));
+  return r;
+}
+
+/// Compute the exponent of vector element.
+template<simd::Accuracy Acc = simd::Accuracy::precise, class Num, size_t Dim>
+constexpr auto exp(const Vec<Num, Dim>& a) -> Vec<Num, Dim> {
+  Vec<Num, Dim> r;
+  TIT_IF_SIMD_AVALIABLE(Num) {
+    for (size_t i = 0; i < Vec<Num, Dim>::RegCount; ++i) {
+      r.reg(i) = simd::exp<Acc>(a.reg(i));
+    }
+    return r;
+  }
+  for (size_t i = 0; i < Dim; ++i) r[i] = exp(a[i]);
+  return r;
+}
+
+/// Compute the natural logarithm of vector element.
+template<simd::Accuracy Acc = simd::Accuracy::precise, class Num, size_t Dim>
+constexpr auto log(const Vec<Num, Dim>& a) -> Vec<Num, Dim> {
+  Vec<Num, Dim> r;
+  TIT_IF_SIMD_AVALIABLE(Num) {
+    for (size_t i = 0; i < Vec<Num, Dim>::RegCount; ++i) {
+      r.reg(i) = simd::log<Acc>(a.reg(i));
+    }
+    return r;
+  }
+  for (size_t i = 0; i < Dim; ++i) r[i] = log(a[i]);
+  return r;
+}
+
+/// Raise vector elements to the floating-point power.
+template<simd::Accuracy Acc = simd::Accuracy::precise, class Num, size_t Dim>
+constexpr auto pow(const Vec<Num, Dim>& a, std::type_identity_t<Num> power)
+    -> Vec<Num, Dim> {
+  Vec<Num, Dim> r;
+  TIT_IF_SIMD_AVALIABLE(Num) {
+    using Reg = typename Vec<Num, Dim>::Reg;
+    const Reg power_reg(power);
+    for (size_t i = 0; i < Vec<Num, Dim>::RegCount; ++i) {
+      r.reg(i) = simd::pow<Acc>(a.reg(i), power_reg);
+    }
+    return r;
+  }
+  for (size_t i = 0; i < Dim; ++i) r[i] = pow(a[i], power);
+  return r;
+}
+
+/// Element-wise fused multiply-add, `a * b + c`.
+/// @{
+template<class Num, size_t Dim>
+constexpr auto fma(const Vec<Num, Dim>& a,
+                   const Vec<Num, Dim>& b,
+                   const Vec<Num, Dim>& c) -> Vec<Num, Dim> {
+  Vec<Num, Dim> r;
+  TIT_IF_SIMD_AVALIABLE(Num) {
+    for (size_t i = 0; i < Vec<Num, Dim>::RegCount; ++i) {
+      r.reg(i) = simd::fma(a.reg(i), b.reg(i), c.reg(i));
+    }
+    return r;
+  }
+  for (size_t i = 0; i < Dim; ++i) r[i] = a[i] * b[i] + c[i];
+  return r;
+}
+template<class Num, size_t Dim>
+constexpr auto fma(std::type_identity_t<Num> a,
+                   const Vec<Num, Dim>& b,
+                   const Vec<Num, Dim>& c) -> Vec<Num, Dim> {
+  Vec<Num, Dim> r;
+  TIT_IF_SIMD_AVALIABLE(Num) {
+    using Reg = typename Vec<Num, Dim>::Reg;
+    const Reg a_reg(a);
+    for (size_t i = 0; i < Vec<Num, Dim>::RegCount; ++i) {
+      r.reg(i) = simd::fma(a_reg, b.reg(i), c.reg(i));
+    }
+    return r;
+  }
+  for (size_t i = 0; i < Dim; ++i) r[i] = a * b[i] + c[i];
+  return r;
+}
+/// @}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Sum of the vector elements.
@@ -688,6 +797,11 @@ constexpr auto deserialize(Stream& in, Vec<Num, Dim>& vec) -> bool {
   return deserialize(in, vec.elems());
 }
 
+/// Vectors without padding are raw serializable.
+template<class Num, size_t Dim>
+inline constexpr bool is_raw_serializable_v<Vec<Num, Dim>> =
+    is_raw_serializable_v<Num> && sizeof(Vec<Num, Dim>) == Dim * sizeof(Num);
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit
@@ -5,6 +5,7 @@
 
 #include <array>
 #include <format>
+#include <numbers>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/math.hpp"
@@ -253,6 +254,47 @@ TEST_CASE_TEMPLATE("Vec::ceil", Num, NUM_TYPES) {
   CHECK(ceil(Vec{Num{1.5}, Num{2.7}}) == Vec{Num{2}, Num{3}});
 }
 
+TEST_CASE_TEMPLATE("Vec::sqrt", Num, NUM_TYPES) {
+  CHECK(sqrt(Vec{Num{4}, Num{9}}) == Vec{Num{2}, Num{3}});
+}
+
+TEST_CASE("Vec::rsqrt") {
+  CHECK_APPROX_EQ(rsqrt(Vec{4.0, 100.0, 0.25}), Vec{0.5, 0.1, 2.0});
+  CHECK_APPROX_EQ(rsqrt<simd::Accuracy::fast>(Vec{4.0, 100.0, 0.25}),
+                  Vec{0.5, 0.1, 2.0});
+}
+
+TEST_CASE("Vec::exp") {
+  CHECK_APPROX_EQ(exp(Vec{0.0, 1.0, -2.0}),
+                  Vec{1.0, std::numbers::e, 1.0 / pow2(std::numbers::e)});
+  CHECK_APPROX_EQ(exp<simd::Accuracy::fast>(Vec{0.0, 1.0, -2.0}),
+                  Vec{1.0, std::numbers::e, 1.0 / pow2(std::numbers::e)});
+}
+
+TEST_CASE("Vec::log") {
+  CHECK_APPROX_EQ(log(Vec{1.0, std::numbers::e, 8.0}),
+                  Vec{0.0, 1.0, 3.0 * std::numbers::ln2});
+}
+
+TEST_CASE("Vec::pow") {
+  CHECK_APPROX_EQ(pow(Vec{1.0, 2.0, 0.5}, 7.0), Vec{1.0, 128.0, 1.0 / 128.0});
+  CHECK_APPROX_EQ(pow<simd::Accuracy::fast>(Vec{1.0, 2.0, 0.5}, 7.0),
+                  Vec{1.0, 128.0, 1.0 / 128.0});
+}
+
+TEST_CASE_TEMPLATE("Vec::fma", Num, NUM_TYPES) {
+  SUBCASE("vector-vector") {
+    CHECK(fma(Vec{Num{1}, Num{2}, Num{3}},
+              Vec{Num{4}, Num{5}, Num{6}},
+              Vec{Num{7}, Num{8}, Num{9}}) == Vec{Num{11}, Num{18}, Num{27}});
+  }
+  SUBCASE("scalar-vector") {
+    CHECK(fma(Num{2},
+              Vec{Num{4}, Num{5}, Num{6}},
+              Vec{Num{7}, Num{8}, Num{9}}) == Vec{Num{15}, Num{18}, Num{21}});
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE_TEMPLATE("Vec::sum", Num, NUM_TYPES) {
@@ -0,0 +1,218 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+// IWYU pragma: private, include "tit/core/vec.hpp"
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <span>
+
+#include "tit/core/_vec/vec.hpp"
+#include "tit/core/_vec/vec_mask.hpp"
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/simd.hpp"
+#include "tit/core/utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Pack of vectors, stored transposed: each component of all the vectors
+/// occupies a single lane vector. This way small vectors, like the 2D and 3D
+/// positions of several particles, fill the whole width of SIMD registers.
+///
+/// Lanes past the packed vectors hold zeroes, use `lane_mask` to discard them.
+template<simd::supported_type Num,
+         size_t Dim,
+         size_t Lanes = simd::max_reg_size_v<Num>>
+class VecPack final {
+public:
+
+  /// Packed vector type.
+  using Point = Vec<Num, Dim>;
+
+  /// Vector of the values in each lane.
+  using LaneVec = Vec<Num, Lanes>;
+
+  /// Fill-initialize the pack with zeroes.
+  constexpr VecPack() noexcept = default;
+
+  /// Pack the vectors.
+  constexpr explicit VecPack(std::span<const Point> points) noexcept {
+    TIT_ASSERT(points.size() <= Lanes, "Too many vectors to pack!");
+    for (size_t j = 0; j < points.size(); ++j) {
+      for (size_t i = 0; i < Dim; ++i) comps_[i][j] = points[j][i];
+    }
+  }
+
+  /// Pack the vectors, returned by the function for the first @p count lanes.
+  template<std::invocable<size_t> Func>
+  constexpr VecPack(size_t count, Func func) {
+    TIT_ASSERT(count <= Lanes, "Too many vectors to pack!");
+    for (size_t j = 0; j < count; ++j) {
+      const Point point = func(j);
+      for (size_t i = 0; i < Dim; ++i) comps_[i][j] = point[i];
+    }
+  }
+
+  /// Number of the lanes.
+  static constexpr auto num_lanes() noexcept -> size_t {
+    return Lanes;
+  }
+
+  /// Lane vector of the component at index.
+  constexpr auto operator[](this auto&& self, size_t i) noexcept -> auto&& {
+    TIT_ASSERT(i < Dim, "Component index is out of range!");
+    return TIT_FORWARD_LIKE(self, self.comps_[i]);
+  }
+
+  /// Unpack the vector at lane.
+  constexpr auto unpack(size_t j) const noexcept -> Point {
+    TIT_ASSERT(j < Lanes, "Lane index is out of range!");
+    Point point;
+    for (size_t i = 0; i < Dim; ++i) point[i] = comps_[i][j];
+    return point;
+  }
+
+  /// Unpack the vectors of the first lanes.
+  constexpr void unpack(std::span<Point> points) const noexcept {
+    TIT_ASSERT(points.size() <= Lanes, "Too many vectors to unpack!");
+    for (size_t j = 0; j < points.size(); ++j) points[j] = unpack(j);
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Vector pack unary plus operation.
+  friend constexpr auto operator+(const VecPack& a) noexcept -> VecPack {
+    return a;
+  }
+
+  /// Vector pack addition operation.
+  friend constexpr auto operator+(const VecPack& a, const VecPack& b)
+      -> VecPack {
+    VecPack r;
+    for (size_t i = 0; i < Dim; ++i) r[i] = a[i] + b[i];
+    return r;
+  }
+
+  /// Vector pack addition with assignment operation.
+  friend constexpr auto operator+=(VecPack& a, const VecPack& b) -> VecPack& {
+    for (size_t i = 0; i < Dim; ++i) a[i] += b[i];
+    return a;
+  }
+
+  /// Vector pack negation operation.
+  friend constexpr auto operator-(const VecPack& a) -> VecPack {
+    VecPack r;
+    for (size_t i = 0; i < Dim; ++i) r[i] = -a[i];
+    return r;
+  }
+
+  /// Vector pack subtraction operation.
+  friend constexpr auto operator-(const VecPack& a, const VecPack& b)
+      -> VecPack {
+    VecPack r;
+    for (size_t i = 0; i < Dim; ++i) r[i] = a[i] - b[i];
+    return r;
+  }
+
+  /// Vector pack subtraction with assignment operation.
+  friend constexpr auto operator-=(VecPack& a, const VecPack& b) -> VecPack& {
+    for (size_t i = 0; i < Dim; ++i) a[i] -= b[i];
+    return a;
+  }
+
+  /// Vector pack multiplication by a scalar operation.
+  /// @{
+  friend constexpr auto operator*(const Num& a, const VecPack& b) -> VecPack {
+    return b * a;
+  }
+  friend constexpr auto operator*(const VecPack& a, const Num& b) -> VecPack {
+    VecPack r;
+    for (size_t i = 0; i < Dim; ++i) r[i] = a[i] * b;
+    return r;
+  }
+  /// @}
+
+  /// Vector pack multiplication by the lane values operation.
+  /// @{
+  friend constexpr auto operator*(const LaneVec& a, const VecPack& b)
+      -> VecPack {
+    return b * a;
+  }
+  friend constexpr auto operator*(const VecPack& a, const LaneVec& b)
+      -> VecPack {
+    VecPack r;
+    for (size_t i = 0; i < Dim; ++i) r[i] = a[i] * b;
+    return r;
+  }
+  /// @}
+
+  /// Vector pack division by the lane values operation.
+  friend constexpr auto operator/(const VecPack& a, const LaneVec& b)
+      -> VecPack {
+    VecPack r;
+    for (size_t i = 0; i < Dim; ++i) r[i] = a[i] / b;
+    return r;
+  }
+
+private:
+
+  std::array<LaneVec, Dim> comps_;
+
+}; // class VecPack
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Mask of the first @p count lanes.
+template<class Num, size_t Lanes>
+constexpr auto lane_mask(size_t count) -> VecMask<Num, Lanes> {
+  TIT_ASSERT(count <= Lanes, "Lane count is out of range!");
+  Vec<Num, Lanes> lane_index;
+  for (size_t j = 0; j < Lanes; ++j) lane_index[j] = static_cast<Num>(j);
+  return lane_index < Vec<Num, Lanes>(static_cast<Num>(count));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Lane-wise vector dot product.
+template<class Num, size_t Dim, size_t Lanes>
+constexpr auto dot(const VecPack<Num, Dim, Lanes>& a,
+                   const VecPack<Num, Dim, Lanes>& b) -> Vec<Num, Lanes> {
+  auto r = a[0] * b[0];
+  for (size_t i = 1; i < Dim; ++i) r += a[i] * b[i];
+  return r;
+}
+
+/// Lane-wise vector squared norm.
+template<class Num, size_t Dim, size_t Lanes>
+constexpr auto norm2(const VecPack<Num, Dim, Lanes>& a) -> Vec<Num, Lanes> {
+  return dot(a, a);
+}
+
+/// Lane-wise vector norm.
+template<class Num, size_t Dim, size_t Lanes>
+constexpr auto norm(const VecPack<Num, Dim, Lanes>& a) -> Vec<Num, Lanes> {
+  return sqrt(norm2(a));
+}
+
+/// Lane-wise vector normalization. Zero vectors are left as they are.
+template<class Num, size_t Dim, size_t Lanes>
+constexpr auto normalize(const VecPack<Num, Dim, Lanes>& a)
+    -> VecPack<Num, Dim, Lanes> {
+  using LaneVec = Vec<Num, Lanes>;
+  const auto norm_sqr = norm2(a);
+  const LaneVec eps_sqr(pow2(tiny_v<Num>));
+  const auto norm_recip = filter(norm_sqr >= eps_sqr,
+                                 LaneVec(Num{1.0}) / sqrt(norm_sqr));
+  return a * norm_recip;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -0,0 +1,81 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+using Point = Vec<double, 3>;
+using Pack = VecPack<double, 3, 4>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("VecPack") {
+  const std::array points{Point{1.0, 2.0, 3.0},
+                          Point{4.0, 5.0, 6.0},
+                          Point{7.0, 8.0, 9.0}};
+  SUBCASE("zero initialization") {
+    const Pack pack{};
+    for (size_t j = 0; j < Pack::num_lanes(); ++j) {
+      CHECK(pack.unpack(j) == Point{});
+    }
+  }
+  SUBCASE("pack and unpack") {
+    const Pack pack{points};
+    CHECK(pack[0] == Vec{1.0, 4.0, 7.0, 0.0});
+    CHECK(pack[1] == Vec{2.0, 5.0, 8.0, 0.0});
+    CHECK(pack[2] == Vec{3.0, 6.0, 9.0, 0.0});
+    std::array<Point, 3> unpacked{};
+    pack.unpack(unpacked);
+    for (size_t j = 0; j < points.size(); ++j) CHECK(unpacked[j] == points[j]);
+    CHECK(pack.unpack(3) == Point{});
+  }
+  SUBCASE("pack with function") {
+    const Pack pack{2, [](size_t j) { return Point(static_cast<double>(j)); }};
+    CHECK(pack.unpack(0) == Point(0.0));
+    CHECK(pack.unpack(1) == Point(1.0));
+    CHECK(pack.unpack(2) == Point{});
+  }
+}
+
+TEST_CASE("VecPack::operators") {
+  const Pack a{std::array{Point{1.0, 2.0, 3.0}, Point{4.0, 5.0, 6.0}}};
+  const Pack b{std::array{Point{1.0, 1.0, 1.0}, Point{2.0, 2.0, 2.0}}};
+  CHECK((a + b).unpack(1) == Point{6.0, 7.0, 8.0});
+  CHECK((a - b).unpack(1) == Point{2.0, 3.0, 4.0});
+  CHECK((-a).unpack(0) == Point{-1.0, -2.0, -3.0});
+  CHECK((2.0 * a).unpack(1) == Point{8.0, 10.0, 12.0});
+  const Vec lanes{1.0, 2.0, 3.0, 4.0};
+  CHECK((a * lanes).unpack(1) == Point{8.0, 10.0, 12.0});
+  CHECK((a / lanes).unpack(1) == Point{2.0, 2.5, 3.0});
+}
+
+TEST_CASE("VecPack::lane_mask") {
+  CHECK(lane_mask<double, 4>(0) == VecMask<double, 4>{});
+  CHECK(lane_mask<double, 4>(3) == VecMask<double, 4>{true, true, true, false});
+  CHECK(lane_mask<double, 4>(4) == VecMask<double, 4>(true));
+}
+
+TEST_CASE("VecPack::norm") {
+  const Pack pack{std::array{Point{3.0, 4.0, 0.0}, Point{2.0, 10.0, 11.0}}};
+  CHECK(dot(pack, pack) == Vec{25.0, 225.0, 0.0, 0.0});
+  CHECK(norm2(pack) == Vec{25.0, 225.0, 0.0, 0.0});
+  CHECK_APPROX_EQ(norm(pack), Vec{5.0, 15.0, 0.0, 0.0});
+  const auto unit = normalize(pack);
+  CHECK_APPROX_EQ(unit.unpack(0), Point{0.6, 0.8, 0.0});
+  CHECK_APPROX_EQ(norm(unit.unpack(1)), 1.0);
+  CHECK(unit.unpack(2) == Point{}); // zero lanes are left as they are.
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,143 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#include "tit/core/autotuner.hpp"
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/log.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+Autotuner::Autotuner(size_t window) : window_{window} {
+  TIT_ASSERT(window_ > 0, "Autotuner window must be positive!");
+}
+
+void Autotuner::add(AutotunerParam param) {
+  TIT_ASSERT(!param.candidates.empty(), "Candidate list must not be empty!");
+  TIT_ASSERT(param.apply, "Parameter apply function must be specified!");
+  const auto num_candidates = param.candidates.size();
+  const auto initial = param.initial;
+  params_.push_back({.param = std::move(param),
+                     .value = initial,
+                     .times = std::vector<std::optional<real_t>>(
+                         num_candidates)});
+
+  // Start tuning, if this is the only pending parameter.
+  if (param_index_ == params_.size() - 1) {
+    candidate_index_ = 0;
+    next_candidate_();
+  }
+}
+
+auto Autotuner::done() const noexcept -> bool {
+  return param_index_ == params_.size();
+}
+
+auto Autotuner::value(std::string_view name) const -> std::optional<size_t> {
+  for (const auto& p : params_) {
+    if (p.param.name == name) return p.value;
+  }
+  return std::nullopt;
+}
+
+void Autotuner::record(real_t step_time) {
+  // Tuned values must stay allowed on every step.
+  check_allowed_();
+  if (done()) return;
+
+  // Drop the measured candidate, if it is no longer allowed.
+  auto& p = params_[param_index_];
+  if (p.param.is_allowed && !p.param.is_allowed(p.value)) {
+    candidate_index_ += 1;
+    next_candidate_();
+    return;
+  }
+
+  // Skip the first step of the window, and wait for the window to complete.
+  num_steps_ += 1;
+  if (num_steps_ > 1) total_time_ += step_time;
+  if (num_steps_ <= window_) return;
+
+  // Store the mean time and switch to the next candidate.
+  p.times[candidate_index_] = total_time_ / static_cast<real_t>(window_);
+  candidate_index_ += 1;
+  next_candidate_();
+}
+
+void Autotuner::next_candidate_() {
+  while (!done()) {
+    auto& p = params_[param_index_];
+    const auto& candidates = p.param.candidates;
+
+    // Apply the next allowed candidate.
+    for (; candidate_index_ < candidates.size(); ++candidate_index_) {
+      const auto candidate = candidates[candidate_index_];
+      if (p.param.is_allowed && !p.param.is_allowed(candidate)) continue;
+      p.value = candidate;
+      p.param.apply(candidate);
+      num_steps_ = 0;
+      total_time_ = 0.0;
+      return;
+    }
+
+    // All the candidates are measured, keep the fastest one.
+    std::optional<size_t> best_index;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (!p.times[i].has_value()) continue;
+      if (!best_index.has_value() || *p.times[i] < *p.times[*best_index]) {
+        best_index = i;
+      }
+    }
+    p.value = best_index.has_value() ? candidates[*best_index] :
+                                       p.param.initial;
+    p.param.apply(p.value);
+    TIT_INFO("Autotuner: '{}' is set to {}.", p.param.name, p.value);
+
+    // Proceed to the next parameter.
+    param_index_ += 1;
+    candidate_index_ = 0;
+    num_steps_ = 0;
+    total_time_ = 0.0;
+  }
+}
+
+void Autotuner::check_allowed_() {
+  for (auto& p : std::span{params_}.first(param_index_)) {
+    const auto& is_allowed = p.param.is_allowed;
+    if (!is_allowed || is_allowed(p.value)) continue;
+
+    // Find the closest preceding allowed candidate, or the first allowed one
+    // if the value is not a candidate.
+    const auto& candidates = p.param.candidates;
+    const auto iter = std::ranges::find(candidates, p.value);
+    std::optional<size_t> fallback;
+    if (iter != candidates.end()) {
+      const auto index = static_cast<size_t>(iter - candidates.begin());
+      for (size_t i = 0; i < index; ++i) {
+        if (is_allowed(candidates[i])) fallback = candidates[i];
+      }
+    } else {
+      const auto allowed = std::ranges::find_if(candidates, is_allowed);
+      if (allowed != candidates.end()) fallback = *allowed;
+    }
+    if (!fallback.has_value()) continue;
+
+    p.value = *fallback;
+    p.param.apply(p.value);
+    TIT_INFO("Autotuner: '{}' falls back to {}.", p.param.name, p.value);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -0,0 +1,98 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Parameter, that is tuned by the autotuner.
+struct AutotunerParam final {
+  /// Parameter name, used for the reporting.
+  std::string name;
+
+  /// Candidate values, from the most to the least conservative one.
+  std::vector<size_t> candidates;
+
+  /// Value that is kept if none of the candidates could be measured.
+  size_t initial = 0;
+
+  /// Apply the parameter value.
+  std::function<void(size_t)> apply;
+
+  /// Is the value currently allowed, e.g. stable? All the values are allowed
+  /// if the function is not specified.
+  std::function<bool(size_t)> is_allowed;
+};
+
+/// Runtime autotuner of the discrete parameters.
+///
+/// Parameters are tuned one after another, in the order they were added:
+/// each of the allowed candidate values is applied for a window of steps,
+/// and the one with the smallest mean step time is kept, before the next
+/// parameter is tuned. First step of each window is not measured, since it
+/// usually includes the cost of the switch.
+///
+/// Values are checked on every step. If a tuned value is no longer allowed,
+/// the parameter falls back to the closest preceding allowed candidate, if
+/// there is one. If the measured candidate is no longer allowed, it is dropped
+/// and the next allowed one is measured instead.
+class Autotuner final {
+public:
+
+  /// Construct an autotuner.
+  ///
+  /// @param window Number of the measured steps per candidate.
+  explicit Autotuner(size_t window = 20);
+
+  /// Add a tuned parameter.
+  void add(AutotunerParam param);
+
+  /// Are all the parameters tuned?
+  auto done() const noexcept -> bool;
+
+  /// Current value of the parameter with the given name.
+  auto value(std::string_view name) const -> std::optional<size_t>;
+
+  /// Record the duration of a step (in seconds), and switch to the next
+  /// candidate, if the window is complete.
+  void record(real_t step_time);
+
+private:
+
+  struct Param_ final {
+    AutotunerParam param;
+    size_t value;
+    std::vector<std::optional<real_t>> times;
+  };
+
+  // Apply the next allowed candidate of the current parameter, or finish the
+  // parameter if there are none left.
+  void next_candidate_();
+
+  // Check that the tuned values are still allowed, and fall back otherwise.
+  void check_allowed_();
+
+  size_t window_;
+  std::vector<Param_> params_;
+  size_t param_index_ = 0;
+  size_t candidate_index_ = 0;
+  size_t num_steps_ = 0;
+  real_t total_time_ = 0.0;
+
+}; // class Autotuner
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
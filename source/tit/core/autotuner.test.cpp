@@ -0,0 +1,105 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <optional>
+
+#include "tit/core/autotuner.hpp"
+#include "tit/core/basic_types.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("Autotuner") {
+  // Step time is the smallest for `a == 20` and `b == 3`, but `b == 3` is
+  // not allowed, and `a` is allowed only up to `max_a`.
+  size_t a = 10;
+  size_t b = 1;
+  size_t max_a = 40;
+  const auto step_time = [&a, &b] {
+    const auto da = static_cast<real_t>(a > 20 ? a - 20 : 20 - a);
+    const auto db = static_cast<real_t>(3 - b);
+    return 1.0 + da + db;
+  };
+  Autotuner tuner{/*window=*/4};
+  tuner.add({.name = "a",
+             .candidates = {10, 20, 40},
+             .initial = 10,
+             .apply = [&a](size_t value) { a = value; },
+             .is_allowed = [&max_a](size_t value) { return value <= max_a; }});
+  tuner.add({.name = "b",
+             .candidates = {1, 2, 3},
+             .initial = 1,
+             .apply = [&b](size_t value) { b = value; },
+             .is_allowed = [](size_t value) { return value != 3; }});
+
+  // Tune the parameters: five steps per candidate, three candidates for
+  // `a`, and two allowed candidates for `b`.
+  size_t num_steps = 0;
+  while (!tuner.done()) {
+    tuner.record(step_time());
+    num_steps += 1;
+  }
+  CHECK(num_steps == 5 * (3 + 2));
+  CHECK(tuner.value("a") == 20);
+  CHECK(tuner.value("b") == 2);
+  CHECK(tuner.value("c") == std::nullopt);
+  CHECK(a == 20);
+  CHECK(b == 2);
+
+  // Tuned values are checked on every step, and `a` falls back to the
+  // preceding allowed candidate once the tuned value is no longer allowed.
+  max_a = 10;
+  tuner.record(step_time());
+  CHECK(a == 10);
+  CHECK(tuner.value("a") == 10);
+}
+
+TEST_CASE("Autotuner::is_allowed") {
+  // Step time is the smallest for `a == 2`.
+  size_t a = 1;
+  size_t b = 1;
+  size_t max_a = 2;
+  size_t max_b = 3;
+  Autotuner tuner{/*window=*/4};
+  tuner.add({.name = "a",
+             .candidates = {1, 2},
+             .initial = 1,
+             .apply = [&a](size_t value) { a = value; },
+             .is_allowed = [&max_a](size_t value) { return value <= max_a; }});
+  tuner.add({.name = "b",
+             .candidates = {1, 2, 3},
+             .initial = 1,
+             .apply = [&b](size_t value) { b = value; },
+             .is_allowed = [&max_b](size_t value) { return value <= max_b; }});
+
+  // Tune `a`, and measure the first candidate of `b`: five steps per
+  // candidate.
+  for (size_t i = 0; i < 5 * (2 + 1); ++i) tuner.record(a == 2 ? 1.0 : 2.0);
+  REQUIRE(a == 2);
+  REQUIRE(b == 2);
+
+  // Tuned value of `a` is checked while `b` is still being tuned.
+  max_a = 1;
+  tuner.record(1.0);
+  CHECK(a == 1);
+  CHECK(tuner.value("a") == 1);
+  CHECK_FALSE(tuner.done());
+
+  // Measured candidate of `b` is dropped once it is no longer allowed, and
+  // the only measured candidate is kept.
+  max_b = 1;
+  tuner.record(1.0);
+  CHECK(b == 1);
+  CHECK(tuner.done());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
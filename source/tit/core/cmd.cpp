@@ -3,10 +3,20 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <utility>
+
+#include <hwy/targets.h>
+#include <unistd.h>
+
 #include "tit/core/checks.hpp"
 #include "tit/core/cmd.hpp"
 #include "tit/core/exception.hpp"
+#include "tit/core/memory_stats.hpp"
 #include "tit/core/par/control.hpp"
+#include "tit/core/par/first_touch.hpp"
 #include "tit/core/profiler.hpp"
 #include "tit/core/stats.hpp"
 #include "tit/core/sys/signal.hpp"
@@ -16,17 +26,69 @@ namespace tit {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace {
+
+// Replace the current process with the variant of the executable, that is
+// built for the best SIMD target supported by the host. Variants are named
+// `<exe>.<target>` and are placed next to the executable, see the
+// `SIMD_VARIANTS` option of `add_tit_executable`. If no suitable variant is
+// present, the current executable continues.
+void exec_simd_variant(CmdArgs args) {
+  // Variant is already selected, or the selection is disabled by the user.
+  if (get_env("TIT_SIMD_TARGET")) return;
+#if HWY_ARCH_X86
+  static constexpr std::array simd_targets{
+      std::pair{HWY_AVX3, "avx3"},
+      std::pair{HWY_AVX2, "avx2"},
+  };
+  const auto supported_targets = hwy::SupportedTargets();
+  const auto exe = exe_path();
+  for (const auto& [target, suffix] : simd_targets) {
+    if ((supported_targets & target) == 0) continue;
+    auto variant_path = exe;
+    variant_path += ".";
+    variant_path += suffix;
+    if (!std::filesystem::exists(variant_path)) continue;
+    setenv("TIT_SIMD_TARGET", suffix, /*overwrite=*/1); // NOLINT(*-mt-unsafe)
+    execv(variant_path.c_str(), args.argv());
+    TIT_THROW("Unable to execute '{}'!", variant_path.c_str());
+  }
+#endif
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 auto run_main(int argc, char** argv, MainFunc main_func) -> int {
   // Setup error handlers.
   const TerminateHandler terminate_handler{};
   const FatalSignalHandler signal_handler{};
 
+  // Switch to the best build of the executable for the host.
+  exec_simd_variant({argc, argv});
+
   // Enable subsystems.
+  if (const auto export_path = get_env("TIT_STATS_EXPORT")) {
+    Stats::enable_export(*export_path);
+  }
   if (get_env("TIT_ENABLE_STATS", false)) Stats::enable();
-  if (get_env("TIT_ENABLE_PROFILER", false)) Profiler::enable();
+  if (get_env("TIT_ENABLE_MEMORY_STATS", false)) MemoryStats::enable();
+  // Trace is recorded by the profiler, so the trace enables it as well.
+  const auto trace_path = get_env("TIT_PROFILER_TRACE");
+  if (trace_path.has_value()) Profiler::enable_trace(*trace_path);
+  if (get_env("TIT_PROFILER_COUNTERS", false)) Profiler::enable_counters();
+  if (get_env("TIT_PROFILER_TSC", false)) Profiler::enable_tsc_clock();
+  if (trace_path.has_value() || get_env("TIT_ENABLE_PROFILER", false)) {
+    Profiler::enable();
+  }
 
   // Setup parallelism.
   par::set_num_threads(get_env("TIT_NUM_THREADS", 8UZ));
+  if (get_env("TIT_PIN_THREADS", false)) par::pin_threads();
+  if (const auto mode = get_env<par::HugePages>("TIT_HUGE_PAGES")) {
+    par::set_huge_pages(*mode);
+  }
 
   // Run the main function.
   TIT_ASSERT(main_func != nullptr, "Main function must be specified!");
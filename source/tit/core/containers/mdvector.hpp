@@ -16,6 +16,7 @@
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/memory_stats.hpp"
 #include "tit/core/range_utils.hpp"
 #include "tit/core/tuple_utils.hpp"
 
@@ -165,6 +166,11 @@ public:
     return self.vals_.end();
   }
 
+  /// Number of bytes allocated on the heap.
+  constexpr auto heap_bytes() const noexcept -> size_t {
+    return tit::heap_bytes(vals_);
+  }
+
   /// Clear the vector.
   constexpr void clear() noexcept {
     shape_.fill(0);
@@ -0,0 +1,66 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/containers/multivector.hpp"
+
+#include "tit/testing/benchmark.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Number of values per bucket on average, similar to the number of neighbors
+// of a particle.
+constexpr size_t ValsPerBucket = 32;
+
+// Pairs of the random bucket indices and the values.
+auto random_pairs(size_t num_buckets)
+    -> std::vector<std::pair<size_t, size_t>> {
+  std::mt19937_64 rng{42};
+  std::uniform_int_distribution<size_t> dist{0, num_buckets - 1};
+  std::vector<std::pair<size_t, size_t>> pairs(num_buckets * ValsPerBucket);
+  for (auto& [bucket, val] : pairs) bucket = dist(rng), val = dist(rng);
+  return pairs;
+}
+
+// Build the multivector from the pairs, with a shared counter per bucket.
+void bench_assign_pairs_par_tall(benchmark::State& state) {
+  const auto num_buckets = testing::setup_benchmark(state);
+  const auto pairs = random_pairs(num_buckets);
+  Multivector<size_t> multivector;
+  for (auto _ : state) {
+    multivector.assign_pairs_par_tall(num_buckets, pairs);
+    benchmark::DoNotOptimize(multivector.vals().data());
+  }
+  testing::report_items(state, pairs.size());
+}
+
+// Build the multivector from the pairs, with the per-thread counters.
+void bench_assign_pairs_par_wide(benchmark::State& state) {
+  const auto num_buckets = testing::setup_benchmark(state);
+  const auto pairs = random_pairs(num_buckets);
+  Multivector<size_t> multivector;
+  for (auto _ : state) {
+    multivector.assign_pairs_par_wide(num_buckets, pairs);
+    benchmark::DoNotOptimize(multivector.vals().data());
+  }
+  testing::report_items(state, pairs.size());
+}
+
+BENCHMARK(bench_assign_pairs_par_tall)
+    ->Apply(testing::sweep_sizes_and_threads);
+BENCHMARK(bench_assign_pairs_par_wide)
+    ->Apply(testing::sweep_sizes_and_threads);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -18,10 +18,11 @@
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/containers/mdvector.hpp"
+#include "tit/core/memory_stats.hpp"
 #include "tit/core/missing.hpp" // IWYU pragma: keep
 #include "tit/core/par/algorithms.hpp"
-#include "tit/core/par/atomic.hpp"
 #include "tit/core/par/control.hpp"
+#include "tit/core/par/first_touch.hpp"
 #include "tit/core/utils.hpp"
 
 namespace tit {
@@ -73,6 +74,16 @@ public:
                      self.vals_.begin() + self.val_ranges_[index + 1]};
   }
 
+  /// Values of all the buckets, stored contiguously in the bucket order.
+  constexpr auto vals(this auto& self) noexcept {
+    return std::span{self.vals_};
+  }
+
+  /// Number of bytes allocated on the heap.
+  constexpr auto heap_bytes() const noexcept -> size_t {
+    return tit::heap_bytes(val_ranges_) + tit::heap_bytes(vals_);
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Clear the multivector.
@@ -99,18 +110,17 @@ public:
   void assign_buckets_par(Buckets&& buckets) {
     TIT_ASSUME_UNIVERSAL(Buckets, buckets);
 
-    // Compute the total number of values.
-    size_t num_values = 0;
+    // Compute the bucket ranges from the bucket sizes.
     val_ranges_.clear(), val_ranges_.resize(std::size(buckets) + 1);
-    for (const auto& [index, bucket] :
-         std::views::as_const(std::views::enumerate(buckets))) {
-      const auto bucket_size = std::size(bucket);
-      val_ranges_[index + 1] = num_values + bucket_size;
-      num_values += bucket_size;
-    }
+    par::for_each(std::views::enumerate(buckets),
+                  [this](const auto& index_and_bucket) {
+                    const auto& [index, bucket] = index_and_bucket;
+                    val_ranges_[index + 1] = std::size(bucket);
+                  });
+    par::inclusive_scan(val_ranges_, val_ranges_.begin());
 
     // Copy the values.
-    vals_.resize(num_values);
+    vals_.resize(val_ranges_.back());
     par::for_each( //
         std::views::enumerate(buckets),
         [this](const auto& index_and_bucket) {
@@ -120,6 +130,34 @@ public:
         });
   }
 
+  /// Build the multivector in two passes, without the intermediate buckets.
+  ///
+  /// @param count     Amount of the value buckets to be added.
+  /// @param size_func Function that returns the size of the bucket at index.
+  /// @param fill_func Function that writes the values of the bucket at index
+  ///                  into the given span. Span size is exactly the size that
+  ///                  was returned by @p size_func for this bucket.
+  template<std::regular_invocable<size_t> SizeFunc,
+           std::invocable<size_t, std::span<Val>> FillFunc>
+  void assign_buckets_par(size_t count,
+                          SizeFunc size_func,
+                          FillFunc fill_func) {
+    // Compute the bucket ranges from the bucket sizes.
+    val_ranges_.clear(), val_ranges_.resize(count + 1);
+    par::for_each(std::views::iota(size_t{0}, count),
+                  [&size_func, this](size_t index) {
+                    val_ranges_[index + 1] = size_func(index);
+                  });
+    par::inclusive_scan(val_ranges_, val_ranges_.begin());
+
+    // Fill the values.
+    vals_.resize(val_ranges_.back());
+    par::for_each(std::views::iota(size_t{0}, count),
+                  [&fill_func, this](size_t index) {
+                    fill_func(index, (*this)[index]);
+                  });
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Build the multivector from pairs of bucket indices and values.
@@ -130,27 +168,75 @@ public:
   /// @param pairs Range of the pairs of bucket indices and values.
   template<std::ranges::input_range Pairs>
   constexpr void assign_pairs_seq(size_t count, Pairs&& pairs) {
-    assign_pairs_tall_impl_(
-        count,
-        std::bind_front(std::ranges::for_each,
-                        std::views::all(std::forward<Pairs>(pairs))),
-        [](auto& cnt) { return cnt++; });
+    TIT_ASSUME_UNIVERSAL(Pairs, pairs);
+
+    // Compute how many values there are per each index.
+    // Note: counts are shifted by two in order to avoid shifting the entire
+    // array after assigning the values.
+    val_ranges_.clear(), val_ranges_.resize(count + 2);
+    for (const auto& pair : pairs) {
+      const auto& index = std::get<0>(pair);
+      TIT_ASSERT(index < count, "Index of the value is out of expected range!");
+      val_ranges_[index + 2] += 1;
+    }
+
+    // Compute the bucket ranges from the bucket sizes.
+    std::partial_sum(val_ranges_.begin() + 2,
+                     val_ranges_.end(),
+                     val_ranges_.begin() + 2);
+
+    // Place each value into position of the first element of it's index
+    // range, then increment the position.
+    vals_.resize(val_ranges_.back());
+    for (const auto& pair : pairs) {
+      const auto& [index, value] = pair;
+      vals_[val_ranges_[index + 1]++] = value;
+    }
+    val_ranges_.pop_back();
   }
 
   /// Build the multivector from pairs of bucket indices and values.
   ///
   /// This version of the function works best when array size is much larger
-  /// than typical size in bucket (multivector is "tall").
+  /// than typical size in bucket (multivector is "tall"). Values are grouped
+  /// by a stable sort, so the order of values within each bucket is the same
+  /// as the order of the pairs.
   ///
   /// @param count Amount of the value buckets to be added.
   /// @param pairs Range of the pairs of bucket indices and values.
   template<par::range Pairs>
   constexpr void assign_pairs_par_tall(size_t count, Pairs&& pairs) {
-    assign_pairs_tall_impl_(
-        count,
-        std::bind_front(par::for_each,
-                        std::views::all(std::forward<Pairs>(pairs))),
-        [](auto& cnt) { return par::fetch_and_add(cnt, 1); });
+    TIT_ASSUME_UNIVERSAL(Pairs, pairs);
+
+    // Split the pairs into the bucket indices and the values.
+    const auto num_vals = std::ranges::size(pairs);
+    par::FirstTouchVector<size_t> indices(num_vals);
+    vals_.clear(), vals_.resize(num_vals);
+    par::for_each(std::views::iota(size_t{0}, num_vals),
+                  [&pairs, &indices, count, this](size_t i) {
+                    const auto& [index, value] = pairs[i];
+                    TIT_ASSERT(index < count,
+                               "Index of the value is out of expected range!");
+                    indices[i] = index;
+                    vals_[i] = value;
+                  });
+
+    // Group the values by the bucket indices. Sorting is done with per-thread
+    // histograms and conflict-free scatters, and is stable, so the values
+    // within each bucket keep the order of the pairs.
+    par::radix_sort(std::span{indices}, std::span{vals_});
+
+    // Position `i` is the start of the buckets `(indices[i - 1], indices[i]]`,
+    // so each bucket range is written exactly once.
+    val_ranges_.clear(), val_ranges_.resize(count + 1);
+    par::for_each(std::views::iota(size_t{0}, num_vals + 1),
+                  [&indices, count, num_vals, this](size_t i) {
+                    const auto first = i == 0 ? 0 : indices[i - 1] + 1;
+                    const auto last = i == num_vals ? count : indices[i];
+                    for (auto index = first; index <= last; ++index) {
+                      val_ranges_[index] = i;
+                    }
+                  });
   }
 
   /// Build the multivector from pairs of bucket indices and values.
@@ -184,45 +270,13 @@ public:
 
 private:
 
-  template<class ForEachPair, class FetchInc>
-  constexpr void assign_pairs_tall_impl_(size_t count,
-                                         ForEachPair for_each_pair,
-                                         FetchInc fetch_inc) {
-    // Compute how many values there are per each index.
-    // Note: counts are shifted by two in order to avoid shifting the entire
-    // array after assigning the values.
-    val_ranges_.clear(), val_ranges_.resize(count + 2);
-    for_each_pair([&fetch_inc, count, this](const auto& pair) {
-      const auto& index = std::get<0>(pair);
-      TIT_ASSERT(index < count, "Index of the value is out of expected range!");
-      fetch_inc(val_ranges_[index + 2]);
-    });
-
-    // Compute the bucket ranges from the bucket sizes.
-    std::partial_sum(val_ranges_.begin() + 2,
-                     val_ranges_.end(),
-                     val_ranges_.begin() + 2);
-
-    // Place each value into position of the first element of it's index
-    // range, then increment the position.
-    vals_.resize(val_ranges_.back());
-    for_each_pair([&fetch_inc, count, this](const auto& pair) {
-      const auto& [index, value] = pair;
-      TIT_ASSERT(index < count, "Index of the value is out of expected range!");
-      auto& position = val_ranges_[index + 1];
-      vals_[fetch_inc(position)] = value;
-    });
-    val_ranges_.pop_back();
-  }
-
   template<class ForEachPair>
   constexpr void assign_pairs_wide_impl_(size_t count,
                                          ForEachPair for_each_pair) {
     // Compute how many values there are per each index per each thread.
-    static Mdvector<size_t, 2> per_thread_ranges{};
     const auto num_threads = par::num_threads();
-    per_thread_ranges.assign(num_threads, count + 1);
-    for_each_pair([count](size_t thread, const auto& pair) {
+    Mdvector<size_t, 2> per_thread_ranges(num_threads, count + 1);
+    for_each_pair([count, &per_thread_ranges](size_t thread, const auto& pair) {
       const auto index = std::get<0>(pair);
       TIT_ASSERT(index < count, "Index of the value is out of expected range!");
       per_thread_ranges[thread, index] += 1;
@@ -230,18 +284,31 @@ private:
 
     // Compute the bucket ranges from the bucket sizes.
     val_ranges_.clear(), val_ranges_.resize(count + 1);
-    for (size_t offset = 0, index = 0; index < count; ++index) {
-      for (size_t thread = 0; thread < num_threads; ++thread) {
-        per_thread_ranges[thread, index] =
-            std::exchange(offset, offset + per_thread_ranges[thread, index]);
-      }
-      val_ranges_[index + 1] = offset;
-    }
+    par::for_each(std::views::iota(size_t{0}, count),
+                  [num_threads, &per_thread_ranges, this](size_t index) {
+                    size_t size = 0;
+                    for (size_t thread = 0; thread < num_threads; ++thread) {
+                      size += per_thread_ranges[thread, index];
+                    }
+                    val_ranges_[index + 1] = size;
+                  });
+    par::inclusive_scan(val_ranges_, val_ranges_.begin());
+
+    // Compute the offsets of the per-thread parts of each bucket.
+    par::for_each(std::views::iota(size_t{0}, count),
+                  [num_threads, &per_thread_ranges, this](size_t index) {
+                    auto offset = val_ranges_[index];
+                    for (size_t thread = 0; thread < num_threads; ++thread) {
+                      auto& range = per_thread_ranges[thread, index];
+                      range = std::exchange(offset, offset + range);
+                    }
+                  });
 
     // Place each value into position of the first element of it's index
     // range, then increment the position.
     vals_.resize(val_ranges_.back());
-    for_each_pair([count, this](size_t thread, const auto& pair) {
+    for_each_pair([count, &per_thread_ranges, this](size_t thread,
+                                                    const auto& pair) {
       const auto& [index, value] = pair;
       TIT_ASSERT(index < count, "Index of the value is out of expected range!");
       auto& position = per_thread_ranges[thread, index];
@@ -252,8 +319,8 @@ private:
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-  std::vector<size_t> val_ranges_{0};
-  std::vector<Val> vals_;
+  par::FirstTouchVector<size_t> val_ranges_{0};
+  par::FirstTouchVector<Val> vals_;
 
 }; // class Multivector
 
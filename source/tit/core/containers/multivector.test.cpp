@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <ranges>
+#include <span>
 #include <utility>
 #include <vector>
 
@@ -39,6 +40,8 @@ TEST_CASE("Multivector") {
     CHECK_RANGE_EQ(multivector[0], {1, 2, 3, 4});
     CHECK_RANGE_EQ(multivector[1], {5, 6, 7});
     CHECK_RANGE_EQ(multivector[2], {8, 9});
+    CHECK_RANGE_EQ(multivector.vals(), {1, 2, 3, 4, 5, 6, 7, 8, 9});
+    CHECK(multivector[1].data() == multivector.vals().data() + 4);
   }
 }
 
@@ -118,30 +121,52 @@ TEST_CASE("Multivector::assign_buckets_par") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("Multivector::assign_buckets_par(size_func, fill_func)") {
+  // Build a multivector, where bucket `i` contains `i` copies of `i`.
+  Multivector<int> multivector{};
+  multivector.assign_buckets_par(
+      5,
+      [](size_t index) { return index; },
+      [](size_t index, std::span<int> bucket) {
+        REQUIRE(bucket.size() == index);
+        std::ranges::fill(bucket, static_cast<int>(index));
+      });
+
+  // Ensure the multivector is correct.
+  REQUIRE(multivector.size() == 5);
+  CHECK(multivector[0].empty());
+  CHECK_RANGE_EQ(multivector[1], {1});
+  CHECK_RANGE_EQ(multivector[2], {2, 2});
+  CHECK_RANGE_EQ(multivector[3], {3, 3, 3});
+  CHECK_RANGE_EQ(multivector[4], {4, 4, 4, 4});
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("Multivector::assign_pairs_par_tall") {
   // Build a multivector from a sequence of pairs.
   const std::vector<std::pair<size_t, int>> pairs{
-      {0, 1},
-      {2, 8},
-      {0, 2},
-      {0, 4},
-      {1, 5},
-      {1, 6},
-      {0, 3},
-      {1, 7},
-      {2, 9},
+      {1, 1},
+      {4, 8},
+      {1, 2},
+      {1, 4},
+      {2, 5},
+      {2, 6},
+      {1, 3},
+      {2, 7},
+      {4, 9},
   };
   Multivector<int> multivector{};
-  multivector.assign_pairs_par_tall(3, pairs);
-
-  // Sort the buckets, since parallel algorithms does not guarantee order.
-  std::ranges::for_each(multivector.buckets(), std::ranges::sort);
-
-  // Ensure the multivector is correct.
-  REQUIRE(multivector.size() == 3);
-  CHECK_RANGE_EQ(multivector[0], {1, 2, 3, 4});
-  CHECK_RANGE_EQ(multivector[1], {5, 6, 7});
-  CHECK_RANGE_EQ(multivector[2], {8, 9});
+  multivector.assign_pairs_par_tall(5, pairs);
+
+  // Ensure the multivector is correct. Order of the values within the buckets
+  // is preserved.
+  REQUIRE(multivector.size() == 5);
+  CHECK(multivector[0].empty());
+  CHECK_RANGE_EQ(multivector[1], {1, 2, 4, 3});
+  CHECK_RANGE_EQ(multivector[2], {5, 6, 7});
+  CHECK(multivector[3].empty());
+  CHECK_RANGE_EQ(multivector[4], {8, 9});
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
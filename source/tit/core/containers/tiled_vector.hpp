@@ -0,0 +1,172 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/simd.hpp"
+#include "tit/core/uint_utils.hpp"
+#include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+template<class Val>
+struct TileTraits {
+  using Num = Val;
+  static constexpr size_t Dim = 1;
+};
+
+template<class Num_, size_t Dim_>
+struct TileTraits<Vec<Num_, Dim_>> {
+  using Num = Num_;
+  static constexpr size_t Dim = Dim_;
+};
+
+} // namespace impl
+
+/// Vector of numbers or numeric vectors, stored as an array of structures of
+/// arrays (AoSoA).
+///
+/// Values are grouped into the tiles of `TileSize` elements, and components of
+/// the values within a tile are stored contiguously, so that a component of
+/// the whole tile could be loaded into a SIMD register without a gather.
+/// Trailing elements of the last tile are zero-initialized padding.
+template<class Val,
+         size_t TileSize =
+             simd::max_reg_size_v<typename impl::TileTraits<Val>::Num>>
+  requires (TileSize > 0)
+class TiledVector final {
+public:
+
+  /// Numeric type.
+  using Num = impl::TileTraits<Val>::Num;
+
+  /// Number of the value components.
+  static constexpr size_t Dim = impl::TileTraits<Val>::Dim;
+
+  /// Number of the elements in a tile.
+  static constexpr size_t Tile = TileSize;
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Construct an empty tiled vector.
+  constexpr TiledVector() noexcept = default;
+
+  /// Construct a tiled vector of the given size and clear values.
+  constexpr explicit TiledVector(size_t size) {
+    resize(size);
+  }
+
+  /// Construct a tiled vector from a range of values.
+  template<std::ranges::input_range Vals>
+    requires std::convertible_to<std::ranges::range_reference_t<Vals>, Val>
+  constexpr explicit TiledVector(Vals&& vals) {
+    assign(std::forward<Vals>(vals));
+  }
+
+  /// Vector size.
+  constexpr auto size() const noexcept -> size_t {
+    return size_;
+  }
+
+  /// Number of tiles.
+  constexpr auto num_tiles() const noexcept -> size_t {
+    return divide_up(size_, Tile);
+  }
+
+  /// Resize the vector. New values are zero-initialized, and so is the
+  /// padding of the last tile, that may hold the values removed by shrinking.
+  constexpr void resize(size_t size) {
+    size_ = size;
+    nums_.resize(num_tiles() * Dim * Tile);
+    if (const auto tail = size_ % Tile; tail != 0) {
+      for (size_t dim = 0; dim < Dim; ++dim) {
+        std::ranges::fill(lanes(num_tiles() - 1, dim).subspan(tail), Num{0});
+      }
+    }
+  }
+
+  /// Assign the vector from a range of values.
+  template<std::ranges::input_range Vals>
+    requires std::convertible_to<std::ranges::range_reference_t<Vals>, Val>
+  constexpr void assign(Vals&& vals) {
+    TIT_ASSUME_UNIVERSAL(Vals, vals);
+    nums_.clear(), size_ = 0;
+    if constexpr (std::ranges::sized_range<Vals>) resize(std::size(vals));
+    size_t index = 0;
+    for (const Val& val : vals) {
+      if constexpr (!std::ranges::sized_range<Vals>) resize(index + 1);
+      set(index++, val);
+    }
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Value at index.
+  constexpr auto get(size_t index) const noexcept -> Val {
+    TIT_ASSERT(index < size_, "Index is out of range!");
+    if constexpr (Dim == 1) {
+      return nums_[offset_(index, 0)];
+    } else {
+      Val val{};
+      for (size_t i = 0; i < Dim; ++i) val[i] = nums_[offset_(index, i)];
+      return val;
+    }
+  }
+
+  /// Set value at index.
+  constexpr void set(size_t index, const Val& val) noexcept {
+    TIT_ASSERT(index < size_, "Index is out of range!");
+    if constexpr (Dim == 1) {
+      nums_[offset_(index, 0)] = val;
+    } else {
+      for (size_t i = 0; i < Dim; ++i) nums_[offset_(index, i)] = val[i];
+    }
+  }
+
+  /// Component @p dim of the values of the tile @p tile.
+  constexpr auto lanes(this auto& self, size_t tile, size_t dim) noexcept {
+    TIT_ASSERT(tile < self.num_tiles(), "Tile index is out of range!");
+    TIT_ASSERT(dim < Dim, "Component index is out of range!");
+    return std::span<std::remove_reference_t<decltype(*self.nums_.data())>,
+                     Tile>{self.nums_.data() + (tile * Dim + dim) * Tile,
+                           Tile};
+  }
+
+  /// Underlying numbers, including the padding.
+  constexpr auto nums(this auto& self) noexcept {
+    return std::span{self.nums_};
+  }
+
+private:
+
+  // Offset of the value component in the underlying storage.
+  static constexpr auto offset_(size_t index, size_t dim) noexcept -> size_t {
+    return ((index / Tile) * Dim + dim) * Tile + index % Tile;
+  }
+
+  size_t size_ = 0;
+  std::vector<Num> nums_;
+
+}; // class TiledVector
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
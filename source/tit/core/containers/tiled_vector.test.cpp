@@ -0,0 +1,93 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <ranges>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/containers/tiled_vector.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("TiledVector") {
+  SUBCASE("construction") {
+    SUBCASE("empty") {
+      const TiledVector<int, 4> tiled;
+      CHECK(tiled.size() == 0);
+      CHECK(tiled.num_tiles() == 0);
+      CHECK(tiled.nums().empty());
+    }
+    SUBCASE("from size") {
+      const TiledVector<Vec<int, 2>, 4> tiled(5);
+      CHECK(tiled.size() == 5);
+      CHECK(tiled.num_tiles() == 2);
+      CHECK(tiled.nums().size() == 16);
+      CHECK(std::ranges::all_of(tiled.nums(), [](int n) { return n == 0; }));
+    }
+    SUBCASE("from values") {
+      const std::array vals{1, 2, 3, 4, 5};
+      const TiledVector<int, 2> tiled{vals};
+      CHECK(tiled.size() == 5);
+      CHECK(tiled.num_tiles() == 3);
+      CHECK_RANGE_EQ(tiled.nums(), {1, 2, 3, 4, 5, 0});
+    }
+  }
+  SUBCASE("layout") {
+    TiledVector<Vec<int, 2>, 2> tiled(3);
+    tiled.set(0, {1, 2});
+    tiled.set(1, {3, 4});
+    tiled.set(2, {5, 6});
+    SUBCASE("values") {
+      CHECK(all(tiled.get(0) == Vec{1, 2}));
+      CHECK(all(tiled.get(1) == Vec{3, 4}));
+      CHECK(all(tiled.get(2) == Vec{5, 6}));
+    }
+    SUBCASE("lanes") {
+      CHECK_RANGE_EQ(tiled.nums(), {1, 3, 2, 4, 5, 0, 6, 0});
+      CHECK_RANGE_EQ(tiled.lanes(0, 0), {1, 3});
+      CHECK_RANGE_EQ(tiled.lanes(0, 1), {2, 4});
+      CHECK_RANGE_EQ(tiled.lanes(1, 0), {5, 0});
+      CHECK_RANGE_EQ(tiled.lanes(1, 1), {6, 0});
+    }
+    SUBCASE("lanes modification") {
+      tiled.lanes(1, 1)[0] = 7;
+      CHECK(all(tiled.get(2) == Vec{5, 7}));
+    }
+  }
+  SUBCASE("resize") {
+    TiledVector<int, 4> tiled{std::array{1, 2, 3, 4, 5, 6}};
+    SUBCASE("shrink") {
+      // Removed values become the zero padding.
+      tiled.resize(5);
+      CHECK_RANGE_EQ(tiled.nums(), {1, 2, 3, 4, 5, 0, 0, 0});
+      tiled.resize(3);
+      CHECK_RANGE_EQ(tiled.nums(), {1, 2, 3, 0});
+    }
+    SUBCASE("shrink and grow") {
+      // Values removed by shrinking do not come back.
+      tiled.resize(5);
+      tiled.resize(7);
+      CHECK_RANGE_EQ(tiled.nums(), {1, 2, 3, 4, 5, 0, 0, 0});
+    }
+    SUBCASE("padding modification") {
+      // Padding written through the lanes is cleared.
+      tiled.lanes(1, 0)[3] = 8;
+      tiled.resize(6);
+      CHECK_RANGE_EQ(tiled.nums(), {1, 2, 3, 4, 5, 6, 0, 0});
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
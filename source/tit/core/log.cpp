@@ -0,0 +1,233 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/io.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/missing.hpp" // IWYU pragma: keep
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+std::mutex sinks_mutex_;
+std::array<LogSink, 3> sinks_;
+
+// Write the message to the sink of its level.
+void write_to_sink(LogLevel level, std::string_view message) {
+  const std::scoped_lock lock{sinks_mutex_};
+  if (const auto& sink = sinks_[std::to_underlying(level)]; sink) {
+    sink(message);
+  } else if (level == LogLevel::info) {
+    println("{}", message);
+  } else {
+    eprintln("{}", message);
+  }
+}
+
+} // namespace
+
+void set_log_sink(LogLevel level, LogSink sink) {
+  TIT_ASSERT(std::to_underlying(level) < sinks_.size(), "Invalid log level!");
+  const std::scoped_lock lock{sinks_mutex_};
+  sinks_[std::to_underlying(level)] = std::move(sink);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Bounded multi-producer single-consumer ring buffer. Each slot carries a
+// sequence number: the slot at position `pos` is free for the producer if its
+// sequence equals `pos`, and is ready for the consumer if it equals `pos + 1`.
+class impl::LogQueue final {
+public:
+
+  // Construct the queue and start the consumer thread.
+  LogQueue(size_t max_rate, size_t capacity)
+      : max_rate_{max_rate}, capacity_{capacity},
+        slots_{std::make_unique<Slot_[]>(capacity)} {
+    TIT_ASSERT(capacity_ > 0, "Log buffer capacity must be positive!");
+    for (size_t i = 0; i < capacity_; ++i) slots_[i].seq.store(i);
+    thread_ = std::jthread{[this] { run_(); }};
+  }
+
+  // Number of the progress messages dropped by the rate limit.
+  auto num_dropped() const noexcept -> size_t {
+    return num_dropped_.load(std::memory_order_relaxed);
+  }
+
+  // Push the message into the buffer. If the buffer is full, wait until the
+  // consumer frees a slot.
+  void push(LogLevel level, std::string message, bool is_progress) noexcept {
+    if (is_progress && !within_rate_()) {
+      num_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    auto pos = head_.load(std::memory_order_relaxed);
+    Slot_* slot = nullptr;
+    while (true) {
+      slot = &slots_[pos % capacity_];
+      const auto seq = slot->seq.load(std::memory_order_acquire);
+      if (seq == pos) {
+        if (head_.compare_exchange_weak(pos,
+                                        pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (seq < pos) {
+        slot->seq.wait(seq, std::memory_order_acquire);
+        pos = head_.load(std::memory_order_relaxed);
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+    slot->level = level;
+    slot->message = std::move(message);
+    slot->seq.store(pos + 1, std::memory_order_release);
+    num_pushed_.fetch_add(1, std::memory_order_release);
+    num_pushed_.notify_one();
+  }
+
+  // Write the remaining messages and stop the consumer thread.
+  void stop() {
+    stopping_.store(true, std::memory_order_release);
+    num_pushed_.fetch_add(1, std::memory_order_release);
+    num_pushed_.notify_one();
+    thread_.join();
+  }
+
+private:
+
+  // Check if the progress message fits into the rate limit.
+  auto within_rate_() noexcept -> bool {
+    if (max_rate_ == 0) return true;
+    using namespace std::chrono;
+    const auto now = steady_clock::now().time_since_epoch();
+    const auto window = floor<seconds>(now).count();
+    auto current = rate_window_.load(std::memory_order_relaxed);
+    if (current != window &&
+        rate_window_.compare_exchange_strong(current,
+                                             window,
+                                             std::memory_order_relaxed)) {
+      rate_count_.store(0, std::memory_order_relaxed);
+    }
+    return rate_count_.fetch_add(1, std::memory_order_relaxed) < max_rate_;
+  }
+
+  // Write all the ready messages.
+  void drain_() {
+    while (true) {
+      auto& slot = slots_[tail_ % capacity_];
+      if (slot.seq.load(std::memory_order_acquire) != tail_ + 1) break;
+      try {
+        write_to_sink(slot.level, slot.message);
+      } catch (...) { // NOLINT(*-empty-catch)
+        // Failing sink must not stop the logger, the message is lost.
+      }
+      slot.message.clear();
+      slot.seq.store(tail_ + capacity_, std::memory_order_release);
+      slot.seq.notify_all();
+      ++tail_;
+    }
+  }
+
+  // Write the messages until the queue is stopped.
+  void run_() {
+    while (true) {
+      const auto seen = num_pushed_.load(std::memory_order_acquire);
+      drain_();
+      if (stopping_.load(std::memory_order_acquire)) break;
+      num_pushed_.wait(seen, std::memory_order_acquire);
+    }
+    drain_();
+  }
+
+  struct Slot_ final {
+    std::atomic<size_t> seq;
+    LogLevel level = LogLevel::info;
+    std::string message;
+  };
+
+  size_t max_rate_;
+  size_t capacity_;
+  std::unique_ptr<Slot_[]> slots_;
+  std::atomic<size_t> head_{0};
+  size_t tail_ = 0;
+  std::atomic<size_t> num_pushed_{0};
+  std::atomic<size_t> num_dropped_{0};
+  std::atomic<bool> stopping_{false};
+  std::atomic<int64_t> rate_window_{-1};
+  std::atomic<size_t> rate_count_{0};
+  std::jthread thread_;
+
+}; // class impl::LogQueue
+
+namespace {
+
+// Queue of the running logger, and the number of the threads that are
+// pushing into it right now.
+std::atomic<impl::LogQueue*> active_queue_{nullptr};
+std::atomic<size_t> num_producers_{0};
+
+} // namespace
+
+AsyncLogger::AsyncLogger(size_t max_rate, size_t capacity)
+    : queue_{std::make_unique<impl::LogQueue>(max_rate, capacity)} {
+  impl::LogQueue* prev_queue = nullptr;
+  if (!active_queue_.compare_exchange_strong(prev_queue, queue_.get())) {
+    queue_->stop();
+    TIT_THROW("Asynchronous logger is already running.");
+  }
+}
+
+AsyncLogger::~AsyncLogger() noexcept {
+  // New producers see no queue once there are no current ones.
+  active_queue_.store(nullptr);
+  while (num_producers_.load() != 0) std::this_thread::yield();
+  queue_->stop();
+  if (const auto num_dropped = queue_->num_dropped(); num_dropped != 0) {
+    try {
+      TIT_WARN("Asynchronous logger dropped {} messages.", num_dropped);
+    } catch (...) { // NOLINT(*-empty-catch)
+      // Nothing to do, the report is lost.
+    }
+  }
+}
+
+auto AsyncLogger::num_dropped() const noexcept -> size_t {
+  return queue_->num_dropped();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void write_log(LogLevel level, std::string message, bool is_progress) {
+  if (level != LogLevel::error) {
+    num_producers_.fetch_add(1);
+    if (auto* const queue = active_queue_.load(); queue != nullptr) {
+      queue->push(level, std::move(message), is_progress);
+      num_producers_.fetch_sub(1);
+      return;
+    }
+    num_producers_.fetch_sub(1);
+  }
+  write_to_sink(level, message);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -5,20 +5,110 @@
 
 #pragma once
 
+#include <format>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "tit/core/basic_types.hpp"
 #include "tit/core/io.hpp" // IWYU pragma: keep
+#include "tit/core/utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Log message level.
+enum class LogLevel : uint8_t {
+  info,  ///< Information message.
+  warn,  ///< Warning message.
+  error, ///< Error message.
+};
+
+/// Log sink, that writes a single message, without the trailing newline.
+using LogSink = std::function<void(std::string_view message)>;
+
+/// Set the sink for the messages of the given level.
+///
+/// By default, information messages are written to the standard output
+/// stream, and the rest of them to the standard error stream. Empty sink
+/// restores the default one.
+void set_log_sink(LogLevel level, LogSink sink);
+
+/// Write the message of the given level to its sink.
+///
+/// While an asynchronous logger is running, information and warning messages
+/// are queued, see `AsyncLogger`. Error messages are always written
+/// immediately. Progress messages are the information messages, that may be
+/// dropped by the rate limit of the asynchronous logger.
+void write_log(LogLevel level, std::string message, bool is_progress = false);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+class LogQueue;
+
+} // namespace impl
+
+/// Asynchronous logger.
+///
+/// While the logger exists, information and warning messages are pushed into
+/// a lock-free ring buffer, and written to their sinks by a background thread,
+/// so that logging does not wait for a slow output. If the buffer is full, the
+/// message waits for a free slot, so it is never lost. Only the progress
+/// messages above the rate limit are dropped. Only a single logger may be
+/// running at a time.
+class AsyncLogger final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(AsyncLogger);
+
+  /// Default ring buffer capacity, in messages.
+  static constexpr size_t DefaultCapacity = 1024;
+
+  /// Start the logger. Progress messages are limited to @p max_rate per
+  /// second, zero disables the limit.
+  explicit AsyncLogger(size_t max_rate = 0, size_t capacity = DefaultCapacity);
+
+  /// Write the queued messages, report the dropped ones and stop the logger.
+  ~AsyncLogger() noexcept;
+
+  /// Number of the progress messages dropped by the rate limit so far.
+  auto num_dropped() const noexcept -> size_t;
+
+private:
+
+  std::unique_ptr<impl::LogQueue> queue_;
+
+}; // class AsyncLogger
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Print information message.
 #define TIT_INFO(message, ...)                                                 \
-  tit::println("INFO: " message __VA_OPT__(, __VA_ARGS__))
+  tit::write_log(tit::LogLevel::info,                                          \
+                 std::format("INFO: " message __VA_OPT__(, __VA_ARGS__)))
+
+/// Print progress message, that may be dropped by the rate limit.
+#define TIT_PROGRESS(message, ...)                                             \
+  tit::write_log(tit::LogLevel::info,                                          \
+                 std::format("INFO: " message __VA_OPT__(, __VA_ARGS__)),      \
+                 /*is_progress=*/true)
 
 /// Print warning message.
 #define TIT_WARN(message, ...)                                                 \
-  tit::eprintln("WARN: " message __VA_OPT__(, __VA_ARGS__))
+  tit::write_log(tit::LogLevel::warn,                                          \
+                 std::format("WARN: " message __VA_OPT__(, __VA_ARGS__)))
 
 /// Print error message.
 #define TIT_ERROR(message, ...)                                                \
-  tit::eprintln("ERROR: " message __VA_OPT__(, __VA_ARGS__))
+  tit::write_log(tit::LogLevel::error,                                         \
+                 std::format("ERROR: " message __VA_OPT__(, __VA_ARGS__)))
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
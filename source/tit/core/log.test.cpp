@@ -0,0 +1,126 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <format>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/missing.hpp" // IWYU pragma: keep
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Capture the messages of each level, and restore the default sinks.
+class LogCapture final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(LogCapture);
+
+  LogCapture() {
+    for (const auto level : {LogLevel::info, LogLevel::warn, LogLevel::error}) {
+      set_log_sink(level, [this](std::string_view message) {
+        messages.emplace_back(message);
+      });
+    }
+  }
+
+  ~LogCapture() noexcept {
+    for (const auto level : {LogLevel::info, LogLevel::warn, LogLevel::error}) {
+      set_log_sink(level, {});
+    }
+  }
+
+  std::vector<std::string> messages;
+
+}; // class LogCapture
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("TIT_INFO") {
+  const LogCapture capture{};
+  TIT_INFO("Step {}.", 1);
+  TIT_WARN("Too slow.");
+  TIT_ERROR("Failed: {}.", "reason");
+  REQUIRE(capture.messages.size() == 3);
+  CHECK(capture.messages[0] == "INFO: Step 1.");
+  CHECK(capture.messages[1] == "WARN: Too slow.");
+  CHECK(capture.messages[2] == "ERROR: Failed: reason.");
+}
+
+TEST_CASE("AsyncLogger") {
+  const LogCapture capture{};
+  SUBCASE("basic") {
+    // Messages of all the threads are written, each in its order.
+    constexpr size_t NumThreads = 4;
+    constexpr size_t NumMessages = 100;
+    {
+      const AsyncLogger logger{};
+      std::vector<std::jthread> threads(NumThreads);
+      for (size_t i = 0; i < NumThreads; ++i) {
+        threads[i] = std::jthread{[i] {
+          for (size_t j = 0; j < NumMessages; ++j) TIT_INFO("{} {}", i, j);
+        }};
+      }
+      threads.clear();
+      CHECK(logger.num_dropped() == 0);
+    }
+    REQUIRE(capture.messages.size() == NumThreads * NumMessages);
+    std::vector<size_t> next(NumThreads, 0);
+    for (const auto& message : capture.messages) {
+      const auto i = static_cast<size_t>(message[6] - '0');
+      REQUIRE(i < NumThreads);
+      CHECK(message == std::format("INFO: {} {}", i, next[i]++));
+    }
+  }
+  SUBCASE("full buffer") {
+    // Messages that do not fit into the buffer wait for a free slot.
+    constexpr size_t NumMessages = 1000;
+    {
+      const AsyncLogger logger{/*max_rate=*/0, /*capacity=*/4};
+      for (size_t i = 0; i < NumMessages; ++i) TIT_INFO("{}", i);
+      CHECK(logger.num_dropped() == 0);
+    }
+    REQUIRE(capture.messages.size() == NumMessages);
+    for (size_t i = 0; i < NumMessages; ++i) {
+      CHECK(capture.messages[i] == std::format("INFO: {}", i));
+    }
+  }
+  SUBCASE("rate limit") {
+    // Progress messages above the limit are dropped, but not the other.
+    {
+      const AsyncLogger logger{10};
+      for (size_t i = 0; i < 10000; ++i) TIT_PROGRESS("{}", i);
+      TIT_INFO("Not dropped.");
+      TIT_WARN("Not dropped.");
+      CHECK(logger.num_dropped() > 0);
+    }
+    CHECK(capture.messages.size() < 10000);
+    CHECK(std::ranges::contains(capture.messages, "INFO: Not dropped."));
+    CHECK(std::ranges::contains(capture.messages, "WARN: Not dropped."));
+    CHECK(capture.messages.back().starts_with(
+        "WARN: Asynchronous logger dropped"));
+  }
+  SUBCASE("single logger") {
+    const AsyncLogger logger{};
+    CHECK_THROWS_MSG(AsyncLogger{},
+                     Exception,
+                     "Asynchronous logger is already running.");
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -12,6 +12,7 @@
 #include "tit/core/_mat/fact.hpp"
 #include "tit/core/_mat/mat.hpp"
 #include "tit/core/_mat/part.hpp"
+#include "tit/core/_mat/sym_mat.hpp"
 #include "tit/core/_mat/traits.hpp"
 // IWYU pragma: end_exports
 
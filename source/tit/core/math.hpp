@@ -27,6 +27,7 @@ namespace tit {
 // Clang does not have constexpr implementations of the math functions yet.
 #ifndef __clang__
 using std::abs;
+using std::acos;
 using std::atan2;
 using std::ceil;
 using std::cos;
@@ -45,6 +46,7 @@ using std::sqrt;
     return std::func(args...);                                                 \
   }
 TIT_MAKE_CONSTEXPR_MATH_FUNC_(abs)
+TIT_MAKE_CONSTEXPR_MATH_FUNC_(acos)
 TIT_MAKE_CONSTEXPR_MATH_FUNC_(atan2)
 TIT_MAKE_CONSTEXPR_MATH_FUNC_(ceil)
 TIT_MAKE_CONSTEXPR_MATH_FUNC_(cos)
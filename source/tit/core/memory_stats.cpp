@@ -0,0 +1,125 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/io.hpp"
+#include "tit/core/memory_stats.hpp"
+#include "tit/core/str_utils.hpp"
+#include "tit/core/sys/utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Convert the number of bytes to mebibytes.
+auto to_mib(size_t num_bytes) noexcept -> float64_t {
+  return static_cast<float64_t>(num_bytes) / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+bool MemoryStats::enabled_ = false;
+std::mutex MemoryStats::mutex_{};
+StrHashMap<MemoryStats::Entry_> MemoryStats::entries_;
+std::vector<size_t> MemoryStats::step_rss_;
+
+void MemoryStats::enable() noexcept {
+  // Report at exit.
+  enabled_ = true;
+  checked_atexit([] { report(); });
+}
+
+void MemoryStats::record(std::string_view name, size_t num_bytes) {
+  const std::scoped_lock lock{mutex_};
+  auto iter = entries_.find(name);
+  if (iter == entries_.end()) iter = entries_.emplace(name, Entry_{}).first;
+  auto& entry = iter->second;
+  entry.last = num_bytes;
+  entry.peak = std::max(entry.peak, num_bytes);
+}
+
+void MemoryStats::record_step() {
+  const auto rss = max_rss();
+  const std::scoped_lock lock{mutex_};
+  step_rss_.push_back(rss);
+}
+
+void MemoryStats::report() {
+  // Gather the entries and sort them by name.
+  const std::scoped_lock lock{mutex_};
+  auto sorted_entries =
+      entries_ |
+      std::views::transform([](const auto& entry) { return &entry; }) |
+      std::ranges::to<std::vector>();
+  std::ranges::sort(sorted_entries,
+                    /*cmp=*/{},
+                    [](const auto* entry) -> const auto& {
+                      return entry->first;
+                    });
+
+  // Print the report table.
+  const auto width = tty_width(TTY::Stdout).value_or(80);
+  constexpr size_t name_width = 39;
+  constexpr size_t col_width = 15;
+  println();
+  println("Memory report:");
+  println();
+  println("{:->{}}", "", width);
+  println("{:<{}} {:>{}} {:>{}}",
+          "name",
+          name_width,
+          "last [MiB]",
+          col_width,
+          "peak [MiB]",
+          col_width);
+  println("{:->{}}", "", width);
+  size_t total_last = 0;
+  for (const auto* named_entry : sorted_entries) {
+    const auto& [name, entry] = *named_entry;
+    println("{:<{}} {:>{}.3f} {:>{}.3f}",
+            name,
+            name_width,
+            to_mib(entry.last),
+            col_width,
+            to_mib(entry.peak),
+            col_width);
+    total_last += entry.last;
+  }
+  println("{:->{}}", "", width);
+  println("{:<{}} {:>{}.3f}",
+          "total",
+          name_width,
+          to_mib(total_last),
+          col_width);
+  println("{:->{}}", "", width);
+
+  // Print the steps at which the high-water mark of the process has grown.
+  if (!step_rss_.empty()) {
+    println();
+    println("Peak resident set size:");
+    println();
+    size_t prev_rss = 0;
+    for (const auto& [step, rss] : std::views::enumerate(step_rss_)) {
+      if (rss <= prev_rss) continue;
+      println("  step {:>8}: {:.3f} MiB", step, to_mib(rss));
+      prev_rss = rss;
+    }
+    println("  {} steps in total.", step_rss_.size());
+  }
+  println();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
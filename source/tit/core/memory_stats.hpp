@@ -0,0 +1,109 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <concepts>
+#include <mutex>
+#include <ranges>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/str_utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Number of bytes the object has allocated on the heap.
+///
+/// Objects with the `heap_bytes` member function report themselves.
+/// Contiguous containers are measured by their capacity, with the heap memory
+/// of their elements. Other objects are assumed to own no heap memory.
+template<class Val>
+constexpr auto heap_bytes(const Val& val) -> size_t {
+  if constexpr (requires {
+                  { val.heap_bytes() } -> std::convertible_to<size_t>;
+                }) {
+    return val.heap_bytes();
+  } else if constexpr (std::ranges::contiguous_range<Val> &&
+                       requires { val.capacity(); }) {
+    using Elem = std::ranges::range_value_t<Val>;
+    auto result = static_cast<size_t>(val.capacity()) * sizeof(Elem);
+    if constexpr (!std::is_trivially_copyable_v<Elem>) {
+      for (const auto& elem : val) result += heap_bytes(elem);
+    }
+    return result;
+  } else {
+    return 0;
+  }
+}
+
+/// Total number of bytes the objects have allocated on the heap.
+template<class... Vals>
+  requires (sizeof...(Vals) > 1)
+constexpr auto heap_bytes(const Vals&... vals) -> size_t {
+  return (heap_bytes(vals) + ...);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Memory footprint accounting interface.
+///
+/// Data structures report their heap footprint under a name, and the last and
+/// the peak footprint of each name are reported at exit, along with the peak
+/// resident set size of the process at each step where it has grown.
+class MemoryStats final {
+public:
+
+  /// Memory statistics is a static object.
+  MemoryStats() = delete;
+
+  /// Enable memory statistics. Report will be printed at exit.
+  static void enable() noexcept;
+
+  /// Is memory statistics enabled?
+  static auto enabled() noexcept -> bool {
+    return enabled_;
+  }
+
+  /// Record the current heap footprint of the named data structure, in bytes.
+  static void record(std::string_view name, size_t num_bytes);
+
+  /// Finish the step, and record the peak resident set size of the process.
+  static void record_step();
+
+  /// Print the report of the footprints so far.
+  static void report();
+
+private:
+
+  struct Entry_ final {
+    size_t last = 0;
+    size_t peak = 0;
+  };
+
+  static bool enabled_;
+  static std::mutex mutex_;
+  static StrHashMap<Entry_> entries_;
+  static std::vector<size_t> step_rss_;
+
+}; // class MemoryStats
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Record the total heap footprint of the objects.
+#define TIT_MEMORY_STATS(name, ...)                                            \
+  do {                                                                         \
+    if (tit::MemoryStats::enabled()) {                                         \
+      tit::MemoryStats::record(name, tit::heap_bytes(__VA_ARGS__));            \
+    }                                                                          \
+  } while (false)
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -0,0 +1,56 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/containers/mdvector.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/memory_stats.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("heap_bytes") {
+  SUBCASE("scalar") {
+    // Plain objects own no heap memory.
+    CHECK(heap_bytes(1.0) == 0);
+  }
+  SUBCASE("vector") {
+    // Vectors are measured by the capacity, not by the size.
+    std::vector<int> vec{1, 2, 3};
+    vec.reserve(10);
+    CHECK(heap_bytes(vec) == vec.capacity() * sizeof(int));
+  }
+  SUBCASE("nested vector") {
+    // Heap memory of the elements is included.
+    const std::vector<std::vector<double>> vecs{{1.0, 2.0}, {3.0}};
+    CHECK(heap_bytes(vecs) ==
+          vecs.capacity() * sizeof(std::vector<double>) +
+              (vecs[0].capacity() + vecs[1].capacity()) * sizeof(double));
+  }
+  SUBCASE("containers") {
+    // Containers with the `heap_bytes` member report themselves.
+    const Mdvector<double, 2> mdvec(3, 4);
+    CHECK(heap_bytes(mdvec) >= 12 * sizeof(double));
+    const Multivector<int> multivec{{1, 2}, {3}};
+    CHECK(heap_bytes(multivec) >= 3 * sizeof(int) + 3 * sizeof(size_t));
+  }
+  SUBCASE("multiple") {
+    // Footprints of multiple objects are summed.
+    const std::vector<int> a{1, 2};
+    const std::vector<int> b{3};
+    CHECK(heap_bytes(a, b) == heap_bytes(a) + heap_bytes(b));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,128 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/cmd.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/options.hpp"
+#include "tit/core/str_utils.hpp"
+#include "tit/core/sys/utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Strip the leading and trailing whitespace.
+auto strip(std::string_view str) -> std::string_view {
+  constexpr std::string_view whitespace = " \t\r\n";
+  const auto first = str.find_first_not_of(whitespace);
+  if (first == std::string_view::npos) return {};
+  const auto last = str.find_last_not_of(whitespace);
+  return str.substr(first, last - first + 1);
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+Options::Options(CmdArgs args) {
+  const std::span argv{args.argv(), static_cast<size_t>(args.argc())};
+  for (const std::string_view arg : argv.subspan(1)) {
+    if (!arg.starts_with("--") || arg.size() == 2) {
+      TIT_THROW("Invalid command line argument '{}', expected '--name=value'.",
+                arg);
+    }
+    const auto separator = arg.find('=');
+    const auto name = arg.substr(2, separator - 2);
+    const auto value = separator == std::string_view::npos ?
+                           std::string_view{"true"} :
+                           arg.substr(separator + 1);
+    if (name == "config") load_file(std::string{value});
+    else set(name, value);
+  }
+}
+
+void Options::load_file(CStrView path) {
+  const auto file = open_file(path, "r");
+  std::string config;
+  std::array<char, 4096> buffer{};
+  while (true) {
+    const auto count = std::fread(buffer.data(), 1, buffer.size(), file.get());
+    config.append(buffer.data(), count);
+    if (count < buffer.size()) break;
+  }
+  if (std::ferror(file.get()) != 0) {
+    TIT_THROW("Unable to read the configuration file '{}'.", path);
+  }
+  load_config(config, path);
+}
+
+void Options::load_config(std::string_view config,
+                          std::string_view source_name) {
+  size_t line_number = 0;
+  while (!config.empty()) {
+    line_number += 1;
+    const auto line_end = std::min(config.find('\n'), config.size());
+    const auto line = strip(config.substr(0, line_end));
+    config.remove_prefix(std::min(line_end + 1, config.size()));
+    if (line.empty() || line.starts_with('#')) continue;
+    const auto separator = line.find('=');
+    if (separator == std::string_view::npos) {
+      TIT_THROW("{}:{}: expected 'name = value', got '{}'.",
+                source_name,
+                line_number,
+                line);
+    }
+    const auto name = strip(line.substr(0, separator));
+    if (name.empty()) {
+      TIT_THROW("{}:{}: option name is missing.", source_name, line_number);
+    }
+    set(name, strip(line.substr(separator + 1)));
+  }
+}
+
+void Options::set(std::string_view name, std::string_view value) {
+  TIT_ASSERT(!name.empty(), "Option name must not be empty!");
+  options_.insert_or_assign(std::string{name}, Option_{std::string{value}});
+}
+
+auto Options::get(std::string_view name) const
+    -> std::optional<std::string_view> {
+  const auto iter = options_.find(name);
+  if (iter == options_.end()) return std::nullopt;
+  iter->second.used = true;
+  return iter->second.value;
+}
+
+void Options::check_unused() const {
+  std::vector<std::string_view> unused;
+  for (const auto& [name, option] : options_) {
+    if (!option.used) unused.emplace_back(name);
+  }
+  if (unused.empty()) return;
+  std::ranges::sort(unused);
+  std::string names;
+  for (const auto name : unused) {
+    names += names.empty() ? "" : ", ";
+    names += name;
+  }
+  TIT_THROW("Unknown options: {}.", names);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -0,0 +1,85 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "tit/core/cmd.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/str_utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Named run-time options.
+///
+/// Options are loaded from the configuration files, that consist of the
+/// `name = value` lines, and from the `--name=value` command line arguments.
+/// Option that is specified multiple times takes the last value.
+class Options final {
+public:
+
+  /// Construct an empty set of options.
+  Options() = default;
+
+  /// Load the options from the command line arguments.
+  ///
+  /// Argument `--config=<path>` loads the configuration file in place, so the
+  /// options that follow it override the ones from the file. Argument
+  /// `--name` with no value is a shortcut for `--name=true`.
+  explicit Options(CmdArgs args);
+
+  /// Load the options from the configuration file.
+  void load_file(CStrView path);
+
+  /// Load the options from the configuration file contents. Empty lines and
+  /// the lines that start with `#` are ignored.
+  void load_config(std::string_view config,
+                   std::string_view source_name = "<config>");
+
+  /// Set the option value.
+  void set(std::string_view name, std::string_view value);
+
+  /// Get the option value. Option is marked as used.
+  /// @{
+  auto get(std::string_view name) const -> std::optional<std::string_view>;
+  template<class Val>
+  auto get(std::string_view name) const -> std::optional<Val> {
+    return get(name).transform([name](std::string_view value) {
+      const auto result = str_to<Val>(value);
+      if (!result.has_value()) {
+        TIT_THROW("Invalid value '{}' of the option '{}'.", value, name);
+      }
+      return *result;
+    });
+  }
+  template<class Val>
+  auto get(std::string_view name, Val fallback) const -> Val {
+    return get<Val>(name).value_or(fallback);
+  }
+  /// @}
+
+  /// Throw an exception if some of the options were never used, which
+  /// typically means that the option name is misspelled.
+  void check_unused() const;
+
+private:
+
+  struct Option_ final {
+    std::string value;
+    mutable bool used = false;
+  };
+
+  StrHashMap<Option_> options_;
+
+}; // class Options
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -0,0 +1,95 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "tit/core/cmd.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/options.hpp"
+#include "tit/core/sys/utils.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("Options") {
+  SUBCASE("config") {
+    Options options;
+    options.load_config("# Comment.\n"
+                        "\n"
+                        "  resolution = 160  \n"
+                        "kernel=quartic_wendland\n"
+                        "telemetry = true");
+    CHECK(options.get<int>("resolution") == 160);
+    CHECK(options.get("kernel") == "quartic_wendland");
+    CHECK(options.get<bool>("telemetry", false));
+    CHECK_FALSE(options.get("missing").has_value());
+    CHECK(options.get<double>("missing", 0.5) == 0.5);
+    CHECK_NOTHROW(options.check_unused());
+  }
+  SUBCASE("command line") {
+    const std::filesystem::path file_name{"test_options.cfg"};
+    {
+      const auto file = open_file(file_name.c_str(), "w");
+      std::fputs("resolution = 40\nend_time = 1.5\n", file.get());
+    }
+    std::string exe{"exe"};
+    std::string config{"--config=" + file_name.string()};
+    std::string resolution{"--resolution=80"};
+    std::string telemetry{"--telemetry"};
+    std::array argv{exe.data(),
+                    config.data(),
+                    resolution.data(),
+                    telemetry.data()};
+    const Options options{CmdArgs{static_cast<int>(argv.size()), argv.data()}};
+    CHECK(options.get<int>("resolution") == 80);
+    CHECK(options.get<double>("end_time") == 1.5);
+    CHECK(options.get<bool>("telemetry") == true);
+    REQUIRE(std::filesystem::remove(file_name));
+  }
+  SUBCASE("failure") {
+    SUBCASE("invalid config line") {
+      Options options;
+      CHECK_THROWS_MSG(options.load_config("a = 1\nb\n", "case.cfg"),
+                       Exception,
+                       "case.cfg:2: expected 'name = value', got 'b'.");
+    }
+    SUBCASE("invalid argument") {
+      std::string exe{"exe"};
+      std::string arg{"-resolution=80"};
+      std::array argv{exe.data(), arg.data()};
+      CHECK_THROWS_MSG(
+          Options(CmdArgs{static_cast<int>(argv.size()), argv.data()}),
+          Exception,
+          "Invalid command line argument '-resolution=80'");
+    }
+    SUBCASE("invalid value") {
+      Options options;
+      options.set("resolution", "many");
+      CHECK_THROWS_MSG(options.get<int>("resolution"),
+                       Exception,
+                       "Invalid value 'many' of the option 'resolution'.");
+    }
+    SUBCASE("unused option") {
+      Options options;
+      options.set("resolutoin", "80");
+      options.set("kernel", "cubic_spline");
+      CHECK_THROWS_MSG(options.check_unused(),
+                       Exception,
+                       "Unknown options: kernel, resolutoin.");
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
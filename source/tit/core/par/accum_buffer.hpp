@@ -0,0 +1,119 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <oneapi/tbb/task_arena.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/utils.hpp"
+
+namespace tit::par {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Thread-private accumulation buffer.
+///
+/// Each worker thread accumulates its contributions into its own copy of the
+/// values, and the copies are summed into the output afterwards. This allows
+/// scattering the writes from a parallel loop without any synchronization, at
+/// the cost of the extra memory and the final reduction pass.
+///
+/// Copies are allocated and cleared lazily, by the thread that accesses them
+/// first, so the threads that did not participate in the loop cost nothing.
+/// Copies, that are much larger than needed, are freed on reset, so that the
+/// long-living buffers do not keep the memory of the largest run.
+///
+/// @note Order of the summation depends on the thread scheduling, so results
+///       may differ from run to run in the last bits.
+template<class Val>
+  requires std::semiregular<Val> && requires (Val& a, const Val& b) { a += b; }
+class AccumBuffer final {
+public:
+
+  /// Reset the buffer to accumulate @p size values.
+  void reset(size_t size) {
+    size_ = size;
+    slots_.resize(tbb::this_task_arena::max_concurrency());
+    for (auto& slot : slots_) {
+      slot.active = false;
+      if (slot.vals.capacity() > 2 * size_) {
+        slot.vals.clear();
+        slot.vals.shrink_to_fit();
+      }
+    }
+  }
+
+  /// Release the memory of the buffer. Buffer must be reset before reuse.
+  void release() noexcept {
+    size_ = 0;
+    slots_.clear();
+    slots_.shrink_to_fit();
+  }
+
+  /// Number of values per thread.
+  constexpr auto size() const noexcept -> size_t {
+    return size_;
+  }
+
+  /// Values of the current thread, initialized with zeroes on first access.
+  auto local() -> std::span<Val> {
+    const auto thread_index = tbb::this_task_arena::current_thread_index();
+    TIT_ASSERT(thread_index >= 0 && std::cmp_less(thread_index, slots_.size()),
+               "Thread index is out of range!");
+    auto& slot = slots_[thread_index];
+    if (!slot.active) slot.vals.assign(size_, Val{}), slot.active = true;
+    return slot.vals;
+  }
+
+  /// Add the accumulated values to the output range. Each value is passed
+  /// through the projection before being added, which allows accumulating
+  /// in a wider type than the output.
+  template<range Out, class Proj = std::identity>
+    requires requires (std::ranges::range_reference_t<Out> out_val,
+                       Proj& proj,
+                       const Val& val) { out_val += std::invoke(proj, val); }
+  void reduce_into(Out&& out, Proj proj = {}) const {
+    TIT_ASSUME_UNIVERSAL(Out, out);
+    TIT_ASSERT(std::size(out) == size_, "Output size must match buffer size!");
+    std::vector<std::span<const Val>> active_vals{};
+    for (const auto& slot : slots_) {
+      if (slot.active) active_vals.emplace_back(slot.vals);
+    }
+    if (active_vals.empty()) return;
+    for_each(std::views::iota(size_t{0}, size_),
+             [out_iter = std::begin(out), &active_vals, &proj](size_t index) {
+               auto& out_val = out_iter[index];
+               for (const auto& vals : active_vals) {
+                 out_val += std::invoke(proj, vals[index]);
+               }
+             });
+  }
+
+private:
+
+  struct Slot {
+    std::vector<Val> vals;
+    bool active = false;
+  };
+
+  size_t size_ = 0;
+  std::vector<Slot> slots_;
+
+}; // class AccumBuffer
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::par
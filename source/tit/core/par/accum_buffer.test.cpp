@@ -0,0 +1,87 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/accum_buffer.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::AccumBuffer") {
+  par::set_num_threads(4);
+  par::AccumBuffer<int> buffer{};
+  SUBCASE("scatter") {
+    // Scatter the values to the neighboring positions, as if we were
+    // processing the pairs of adjacent elements.
+    constexpr size_t size = 1000;
+    buffer.reset(size);
+    par::for_each(std::views::iota(size_t{1}, size), [&buffer](size_t i) {
+      const auto vals = buffer.local();
+      vals[i - 1] += 1;
+      vals[i] += 1;
+    });
+
+    // Ensure the values are reduced correctly.
+    std::vector<int> out(size, 10);
+    buffer.reduce_into(out);
+    CHECK(out.front() == 11);
+    CHECK(out.back() == 11);
+    CHECK(std::ranges::all_of(out | std::views::drop(1) |
+                                  std::views::take(size - 2),
+                              [](int val) { return val == 12; }));
+  }
+  SUBCASE("reset") {
+    // Ensure the values from the previous run are discarded.
+    buffer.reset(3);
+    par::for_each(std::views::iota(0, 3), [&buffer](int /*i*/) {
+      buffer.local()[0] += 1;
+    });
+    buffer.reset(3);
+    std::vector<int> out{1, 2, 3};
+    buffer.reduce_into(out);
+    CHECK(out == std::vector{1, 2, 3});
+  }
+  SUBCASE("release") {
+    // Ensure the buffer is usable again after the release.
+    buffer.reset(1000);
+    par::for_each(std::views::iota(0, 1000), [&buffer](int i) {
+      buffer.local()[i] += 1;
+    });
+    buffer.release();
+    CHECK(buffer.size() == 0);
+    buffer.reset(3);
+    par::for_each(std::views::iota(0, 3), [&buffer](int i) {
+      buffer.local()[i] += 1;
+    });
+    std::vector<int> out{1, 2, 3};
+    buffer.reduce_into(out);
+    CHECK(out == std::vector{2, 3, 4});
+  }
+  SUBCASE("projection") {
+    // Ensure the values are projected before being added to the output.
+    buffer.reset(3);
+    par::for_each(std::views::iota(0, 3), [&buffer](int i) {
+      buffer.local()[i] += i + 1;
+    });
+    std::vector<double> out{0.5, 0.5, 0.5};
+    buffer.reduce_into(out, [](int val) { return 2.0 * val; });
+    CHECK(out == std::vector{2.5, 4.5, 6.5});
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
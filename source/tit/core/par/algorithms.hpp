@@ -6,21 +6,34 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <concepts>
 #include <functional>
 #include <iterator>
+#include <numeric>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <oneapi/tbb/blocked_range.h>
 #include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/parallel_reduce.h>
 #include <oneapi/tbb/parallel_sort.h>
 #include <oneapi/tbb/partitioner.h>
+#include <oneapi/tbb/task_group.h>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
 #include "tit/core/missing.hpp" // IWYU pragma: keep
 #include "tit/core/par/atomic.hpp"
 #include "tit/core/par/control.hpp"
+#include "tit/core/stats.hpp"
+#include "tit/core/time.hpp"
 #include "tit/core/utils.hpp"
 
 namespace tit::par {
@@ -34,15 +47,89 @@ concept range =
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Partitioner of the dynamically partitioned loops.
+enum class Partitioner : uint8_t {
+  /// Range is split adaptively, as much as needed to balance the load.
+  automatic,
+
+  /// Range is split down to the grain size.
+  simple,
+
+  /// Range is split evenly between the threads, once.
+  uniform,
+
+  /// Like `automatic`, but the chunks are assigned to the threads that
+  /// processed them in the previous call, so that the data stays in their
+  /// caches. Requires the affinity state, that is kept between the calls.
+  affinity,
+};
+
+/// Affinity state of the loop, see `Partitioner::affinity`.
+using Affinity = tbb::affinity_partitioner;
+
+/// Execution policy of the dynamically partitioned loops.
+struct Policy final {
+  /// Minimal number of the range elements processed by a single task. Zero
+  /// means the grain size of the calling thread, see `par::grain_size`.
+  size_t grain_size = 0;
+
+  /// Partitioner.
+  Partitioner partitioner = Partitioner::automatic;
+
+  /// Affinity state, required for the `Partitioner::affinity` partitioner.
+  Affinity* affinity = nullptr;
+};
+
+namespace impl {
+
+// Blocked range of the range with the grain size of the policy.
+template<range Range>
+auto blocked_range(Range& range, const Policy& policy) {
+  const auto grain = policy.grain_size > 0 ? policy.grain_size : grain_size();
+  return tbb::blocked_range{std::begin(range), std::end(range), grain};
+}
+
+// Call the function with the partitioner of the policy.
+template<class Func>
+auto with_partitioner(const Policy& policy, Func func) -> decltype(auto) {
+  TIT_ASSERT(policy.partitioner != Partitioner::affinity ||
+                 policy.affinity != nullptr,
+             "Affinity state is missing!");
+  switch (policy.partitioner) {
+    case Partitioner::automatic: return func(tbb::auto_partitioner{});
+    case Partitioner::simple:    return func(tbb::simple_partitioner{});
+    case Partitioner::uniform:   return func(tbb::static_partitioner{});
+    case Partitioner::affinity:  return func(*policy.affinity);
+    default:                     std::unreachable();
+  }
+}
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Iterate through the range in parallel (dynamic partitioning).
 struct ForEach {
   template<range Range,
            std::regular_invocable<std::ranges::range_reference_t<Range&&>> Func>
   void operator()(Range&& range, Func func) const {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    (*this)(Policy{}, range, std::move(func));
+  }
+  template<range Range,
+           std::regular_invocable<std::ranges::range_reference_t<Range&&>> Func>
+  void operator()(const Policy& policy, Range&& range, Func func) const {
     /// @todo Replace with `tbb::parallel_for_each` when it supports ranges.
     TIT_ASSUME_UNIVERSAL(Range, range);
-    tbb::parallel_for(tbb::blocked_range{std::begin(range), std::end(range)},
-                      std::bind_back(std::ranges::for_each, std::move(func)));
+    // Grain size of the calling thread is passed to the nested loops.
+    impl::with_partitioner(policy, [&range, &policy, &func](auto&& part) {
+      tbb::parallel_for(impl::blocked_range(range, policy),
+                        [&func, grain = grain_size()](auto&& subrange) {
+                          const GrainScope scope{grain};
+                          std::ranges::for_each(subrange, std::ref(func));
+                        },
+                        part);
+    });
   }
 };
 
@@ -83,16 +170,76 @@ inline constexpr StaticForEach static_for_each{};
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Iterate through the block of ranges in parallel.
+///
+/// Blocks are grouped into the levels of @p level_size consecutive blocks
+/// (number of threads by default). Blocks within a level are processed
+/// concurrently, and the levels are processed one after another. Blocks of a
+/// level are statically partitioned between the threads, so that the same
+/// blocks are processed by the same threads on each call.
+///
+/// If statistics are enabled, execution times of the blocks and wall times
+/// of the levels are recorded, along with the idle fraction of the threads:
+/// the part of the level wall time, multiplied by the number of threads,
+/// that is not spent in the blocks.
 struct BlockForEach {
   template<range Range,
            std::invocable<std::ranges::range_reference_t<
                std::ranges::range_value_t<Range>>> Func>
   void operator()(Range&& range, Func func) const {
     TIT_ASSUME_UNIVERSAL(Range, range);
-    for (auto chunk : std::views::chunk(range, num_threads())) {
-      for_each(std::move(chunk),
-               std::bind_back(std::ranges::for_each, std::cref(func)));
+    (*this)(range, num_threads(), std::move(func));
+  }
+  template<range Range,
+           std::invocable<std::ranges::range_reference_t<
+               std::ranges::range_value_t<Range>>> Func>
+  void operator()(Range&& range, size_t level_size, Func func) const {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    TIT_ASSERT(level_size > 0, "Level size must be positive!");
+    if (Stats::enabled()) [[unlikely]] {
+      timed_(range, level_size, func);
+      return;
+    }
+    for (auto chunk : std::views::chunk(range, level_size)) {
+      static_for_each(std::move(chunk),
+                      [&func](size_t /*thread_index*/, auto&& block) {
+                        std::ranges::for_each(block, std::cref(func));
+                      });
+    }
+  }
+
+private:
+
+  // Process the blocks, and record the timings.
+  template<class Range, class Func>
+  static void timed_(Range& range, size_t level_size, Func& func) {
+    const auto num_blocks = std::size(range);
+    std::vector<uint64_t> block_ns(num_blocks);
+    std::vector<uint64_t> level_ns;
+    const auto elapsed_ns = [](TscClock::time_point start) {
+      return static_cast<uint64_t>((TscClock::now() - start).count());
+    };
+    for (size_t first = 0; first < num_blocks; first += level_size) {
+      const auto last = std::min(first + level_size, num_blocks);
+      const auto level_start = TscClock::now();
+      static_for_each(std::views::iota(first, last),
+                      [&range, &func, &block_ns, &elapsed_ns](
+                          size_t /*thread_index*/,
+                          size_t block_index) {
+                        const auto block_start = TscClock::now();
+                        std::ranges::for_each(std::begin(range)[block_index],
+                                              std::cref(func));
+                        block_ns[block_index] = elapsed_ns(block_start);
+                      });
+      level_ns.push_back(elapsed_ns(level_start));
     }
+    const auto busy_ns = std::ranges::fold_left(block_ns, 0.0, std::plus{});
+    const auto wall_ns = std::ranges::fold_left(level_ns, 0.0, std::plus{});
+    const auto capacity_ns = wall_ns * static_cast<float64_t>(num_threads());
+    const auto idle_fraction =
+        capacity_ns > 0.0 ? std::max(1.0 - busy_ns / capacity_ns, 0.0) : 0.0;
+    TIT_STATS("par::block_for_each::block_ns", block_ns);
+    TIT_STATS("par::block_for_each::level_ns", level_ns);
+    TIT_STATS("par::block_for_each::idle_fraction", idle_fraction);
   }
 };
 
@@ -101,6 +248,145 @@ inline constexpr BlockForEach block_for_each{};
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Iterate through the block of ranges in parallel, respecting the
+/// dependencies between the blocks.
+///
+/// Block is processed as soon as all the blocks it depends on are finished,
+/// there are no barriers between the groups of blocks. `deps[i]` is the range
+/// of indices of the blocks the block `i` depends on, each index must be less
+/// than `i`. Blocks that do not depend on each other must not share any data.
+/// Blocks without the dependencies are statically partitioned between the
+/// threads, so that the same blocks are processed by the same threads on each
+/// call, the rest are processed by the threads that are free.
+struct DepsForEach {
+  template<range Range,
+           std::ranges::random_access_range Deps,
+           std::invocable<std::ranges::range_reference_t<
+               std::ranges::range_value_t<Range>>> Func>
+    requires std::ranges::input_range<std::ranges::range_reference_t<Deps>> &&
+             std::convertible_to<std::ranges::range_value_t<
+                                     std::ranges::range_reference_t<Deps>>,
+                                 size_t>
+  void operator()(Range&& range, Deps&& deps, Func func) const {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    TIT_ASSUME_UNIVERSAL(Deps, deps);
+    const auto num_blocks = std::size(range);
+    TIT_ASSERT(std::size(deps) == num_blocks,
+               "Dependencies must be provided for each block!");
+
+    // Count the pending dependencies and collect the dependent blocks.
+    std::vector<size_t> num_pending(num_blocks);
+    std::vector<std::vector<size_t>> dependents(num_blocks);
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < num_blocks; ++i) {
+      for (const size_t j : std::begin(deps)[i]) {
+        TIT_ASSERT(j < i, "Block must depend only on the preceding blocks!");
+        num_pending[i] += 1;
+        dependents[j].push_back(i);
+      }
+      if (num_pending[i] == 0) ready.push_back(i);
+    }
+
+    // Process the blocks, spawning the ones that became ready.
+    tbb::task_group group;
+    using Iter = decltype(std::begin(range));
+    const Context_<Iter> context{std::begin(range),
+                                 num_pending,
+                                 dependents,
+                                 group};
+    static_for_each(ready, [&context, &func](size_t /*thread*/, size_t i) {
+      process_(context, func, i);
+    });
+    group.wait();
+  }
+
+private:
+
+  // Shared state of the loop.
+  template<class Iter>
+  struct Context_ {
+    Iter first;
+    std::vector<size_t>& num_pending;
+    const std::vector<std::vector<size_t>>& dependents;
+    tbb::task_group& group;
+  };
+
+  // Process the block, and spawn the dependent blocks that became ready.
+  template<class Iter, class Func>
+  static void process_(const Context_<Iter>& context,
+                       const Func& func,
+                       size_t i) {
+    std::ranges::for_each(context.first[i], std::cref(func));
+    // Note: the decrement must synchronize with the previous ones, so that
+    //       the block observes all the writes of its dependencies.
+    for (const auto k : context.dependents[i]) {
+      std::atomic_ref pending{context.num_pending[k]};
+      if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        context.group.run([&context, &func, k] { process_(context, func, k); });
+      }
+    }
+  }
+
+};
+
+/// @copydoc DepsForEach
+inline constexpr DepsForEach deps_for_each{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Iterate through the block of ranges in parallel, ignoring the blocks.
+/// Unlike `block_for_each`, all the blocks are processed concurrently.
+/// Blocks that are not random access ranges are iterated sequentially.
+struct FlatForEach {
+  template<range Range,
+           std::invocable<std::ranges::range_reference_t<
+               std::ranges::range_value_t<Range>>> Func>
+  void operator()(Range&& range, Func func) const {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    for_each(range, [&func](auto block) {
+      if constexpr (par::range<decltype(block)>) {
+        for_each(block, std::cref(func));
+      } else {
+        std::ranges::for_each(block, std::cref(func));
+      }
+    });
+  }
+};
+
+/// @copydoc FlatForEach
+inline constexpr FlatForEach flat_for_each{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Iterate through the batches of consecutive range elements in parallel.
+/// Each batch is a subrange of @p batch_size elements, except for the last
+/// one, which may be shorter.
+struct ForEachBatch {
+  template<range Range,
+           std::invocable<std::ranges::range_value_t<
+               std::ranges::chunk_view<std::views::all_t<Range>>>> Func>
+  void operator()(Range&& range, size_t batch_size, Func func) const {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    (*this)(Policy{}, range, batch_size, std::move(func));
+  }
+  template<range Range,
+           std::invocable<std::ranges::range_value_t<
+               std::ranges::chunk_view<std::views::all_t<Range>>>> Func>
+  void operator()(const Policy& policy,
+                  Range&& range,
+                  size_t batch_size,
+                  Func func) const {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    TIT_ASSERT(batch_size > 0, "Batch size must be positive!");
+    for_each(policy, std::views::chunk(range, batch_size), std::move(func));
+  }
+};
+
+/// @copydoc ForEachBatch
+inline constexpr ForEachBatch for_each_batch{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Parallel copy-if.
 /// Relative order of the elements in the output range is not preserved.
 struct CopyIf {
@@ -128,6 +414,540 @@ inline constexpr CopyIf copy_if{};
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Parallel stable remove-if.
+///
+/// The range is split into the per-thread blocks, which are compacted
+/// concurrently, so the predicate is evaluated exactly once per element. The
+/// compacted blocks are then shifted to their final offsets, which is a plain
+/// move of the kept elements and requires no extra storage.
+/// Relative order of the kept elements is preserved.
+struct RemoveIf {
+  template<range Range,
+           class Proj = std::identity,
+           std::indirect_unary_predicate<
+               std::projected<std::ranges::iterator_t<Range>, Proj>> Pred>
+    requires std::permutable<std::ranges::iterator_t<Range>>
+  auto operator()(Range&& range, Pred pred, Proj proj = {}) const
+      -> std::ranges::iterator_t<Range> {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    const auto thread_count = num_threads();
+    auto block_first = [quotient = std::size(range) / thread_count,
+                        remainder = std::size(range) % thread_count,
+                        first = std::begin(range)](size_t index) {
+      const auto offset = index * quotient + std::min(index, remainder);
+      return first + offset;
+    };
+
+    // Compact the blocks independently.
+    std::vector<size_t> block_sizes(thread_count);
+    tbb::parallel_for<size_t>(
+        /*first=*/0,
+        /*last=*/thread_count,
+        /*step=*/1,
+        [&block_first, &block_sizes, &pred, &proj](size_t thread_index) {
+          const auto first = block_first(thread_index);
+          const auto last = block_first(thread_index + 1);
+          const auto removed = std::ranges::remove_if(first, last, pred, proj);
+          block_sizes[thread_index] = std::begin(removed) - first;
+        },
+        tbb::static_partitioner{});
+
+    // Shift the compacted blocks to their final positions. Destinations of
+    // the block may overlap the kept elements of the preceding blocks, so the
+    // blocks must be processed in order.
+    auto out = block_first(0);
+    for (size_t thread_index = 0; thread_index < thread_count; ++thread_index) {
+      const auto first = block_first(thread_index);
+      const auto last = first + block_sizes[thread_index];
+      out = first == out ? last : std::move(first, last, out);
+    }
+    return out;
+  }
+};
+
+/// @copydoc RemoveIf
+inline constexpr RemoveIf remove_if{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Parallel partition.
+///
+/// The range is split into the per-thread blocks, and the elements that
+/// satisfy the predicate are counted in each block. Then the elements are
+/// moved into a temporary buffer at their final offsets, and moved back, so
+/// the predicate is evaluated twice per element. Small ranges are partitioned
+/// serially in place. Like `std::partition`, relative order of the elements
+/// is not guaranteed to be preserved.
+struct Partition final {
+  /// Ranges smaller than this size are partitioned serially.
+  static constexpr size_t SerialThreshold = 16384;
+
+  template<range Range,
+           class Proj = std::identity,
+           std::indirect_unary_predicate<
+               std::projected<std::ranges::iterator_t<Range>, Proj>> Pred>
+    requires std::permutable<std::ranges::iterator_t<Range>> &&
+             std::default_initializable<std::ranges::range_value_t<Range>>
+  static auto operator()(Range&& range, Pred pred, Proj proj = {})
+      -> std::ranges::iterator_t<Range> {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    if (std::size(range) < SerialThreshold) {
+      return std::begin(std::ranges::partition(range, pred, proj));
+    }
+    const auto thread_count = num_threads();
+    auto block_offset = [quotient = std::size(range) / thread_count,
+                         remainder = std::size(range) % thread_count](
+                            size_t index) {
+      return index * quotient + std::min(index, remainder);
+    };
+
+    // Count the matching elements in each block.
+    std::vector<size_t> block_counts(thread_count);
+    tbb::parallel_for<size_t>(
+        /*first=*/0,
+        /*last=*/thread_count,
+        /*step=*/1,
+        [&range, &block_offset, &block_counts, &pred, &proj](
+            size_t thread_index) {
+          const auto first = std::begin(range) + block_offset(thread_index);
+          const auto last = std::begin(range) + block_offset(thread_index + 1);
+          block_counts[thread_index] =
+              std::ranges::count_if(first, last, pred, proj);
+        },
+        tbb::static_partitioner{});
+    std::vector<size_t> true_offsets(thread_count + 1);
+    for (size_t i = 0; i < thread_count; ++i) {
+      true_offsets[i + 1] = true_offsets[i] + block_counts[i];
+    }
+    const auto num_true = true_offsets.back();
+
+    // Scatter the elements into the buffer, and move them back.
+    std::vector<std::ranges::range_value_t<Range>> buffer(std::size(range));
+    tbb::parallel_for<size_t>(
+        /*first=*/0,
+        /*last=*/thread_count,
+        /*step=*/1,
+        [&range,
+         &block_offset,
+         &true_offsets,
+         &buffer,
+         num_true,
+         &pred,
+         &proj](size_t thread_index) {
+          const auto offset = block_offset(thread_index);
+          const auto first = std::begin(range) + offset;
+          const auto last = std::begin(range) + block_offset(thread_index + 1);
+          const auto true_offset = true_offsets[thread_index];
+          auto true_out = buffer.begin() + true_offset;
+          auto false_out = buffer.begin() + num_true + (offset - true_offset);
+          for (auto iter = first; iter != last; ++iter) {
+            auto& out = std::invoke(pred, std::invoke(proj, *iter)) ?
+                            true_out :
+                            false_out;
+            *out++ = std::ranges::iter_move(iter);
+          }
+        },
+        tbb::static_partitioner{});
+    tbb::parallel_for<size_t>(
+        /*first=*/0,
+        /*last=*/thread_count,
+        /*step=*/1,
+        [&range, &block_offset, &buffer](size_t thread_index) {
+          const auto first = block_offset(thread_index);
+          const auto last = block_offset(thread_index + 1);
+          std::ranges::move(buffer.begin() + first,
+                            buffer.begin() + last,
+                            std::begin(range) + first);
+        },
+        tbb::static_partitioner{});
+    return std::begin(range) + num_true;
+  }
+};
+
+/// @copydoc Partition
+inline constexpr Partition partition{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Parallel nth element.
+///
+/// The range around the nth element is narrowed down by the parallel
+/// three-way partitioning with respect to the pivot, that is chosen as the
+/// median of an evenly spaced sample. Once the remaining range is small
+/// enough, it is processed serially.
+struct NthElement final {
+  /// Ranges smaller than this size are processed serially.
+  static constexpr size_t SerialThreshold = Partition::SerialThreshold;
+
+  /// Number of elements in the pivot sample.
+  static constexpr size_t SampleSize = 63;
+
+  template<range Range,
+           class Compare = std::ranges::less,
+           class Proj = std::identity>
+    requires std::sortable<std::ranges::iterator_t<Range>, Compare, Proj> &&
+             std::default_initializable<std::ranges::range_value_t<Range>>
+  static void operator()(Range&& range,
+                         std::ranges::iterator_t<Range> nth,
+                         Compare compare = {},
+                         Proj proj = {}) {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    auto first = std::begin(range);
+    auto last = std::end(range);
+    while (nth != last &&
+           std::cmp_greater_equal(last - first, SerialThreshold)) {
+      // Choose the pivot.
+      std::array<std::ranges::range_value_t<Range>, SampleSize> sample{};
+      const auto step = (last - first) / static_cast<ssize_t>(SampleSize);
+      for (size_t i = 0; i < SampleSize; ++i) {
+        sample[i] = first[static_cast<ssize_t>(i) * step];
+      }
+      const auto sample_median = sample.begin() + SampleSize / 2;
+      std::ranges::nth_element(sample, sample_median, compare, proj);
+      const auto pivot = std::invoke(proj, *sample_median);
+
+      // Split the range into the elements that are less than the pivot,
+      // equal to the pivot and greater than the pivot. Middle part is never
+      // empty, since it contains at least the pivot itself.
+      const auto middle_first = Partition{}(
+          std::ranges::subrange{first, last},
+          [&compare, &pivot](const auto& key) {
+            return std::invoke(compare, key, pivot);
+          },
+          proj);
+      if (nth < middle_first) {
+        last = middle_first;
+        continue;
+      }
+      const auto middle_last = Partition{}(
+          std::ranges::subrange{middle_first, last},
+          [&compare, &pivot](const auto& key) {
+            return !std::invoke(compare, pivot, key);
+          },
+          proj);
+      if (nth < middle_last) return;
+      first = middle_last;
+    }
+    std::ranges::nth_element(first, nth, last, compare, proj);
+  }
+};
+
+/// @copydoc NthElement
+inline constexpr NthElement nth_element{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Parallel fold.
+///
+/// The range is split into blocks, each block is folded with the function
+/// starting from the initial value, and the partial results are combined with
+/// the join function. Initial value must be the identity of the join function,
+/// and the join function must be associative.
+struct Fold final {
+  template<range Range, std::copyable Val, class Func, class Join>
+    requires std::regular_invocable<Func&,
+                                    Val,
+                                    std::ranges::range_reference_t<Range>> &&
+             std::regular_invocable<Join&, Val, Val>
+  static auto operator()(Range&& range, Val init, Func func, Join join)
+      -> Val {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    return operator()(Policy{},
+                      range,
+                      std::move(init),
+                      std::move(func),
+                      std::move(join));
+  }
+  template<range Range, std::copyable Val, class Func, class Join>
+    requires std::regular_invocable<Func&,
+                                    Val,
+                                    std::ranges::range_reference_t<Range>> &&
+             std::regular_invocable<Join&, Val, Val>
+  static auto operator()(const Policy& policy,
+                         Range&& range,
+                         Val init,
+                         Func func,
+                         Join join) -> Val {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    return impl::with_partitioner(
+        policy,
+        [&range, &policy, &init, &func, &join](auto&& part) {
+          return tbb::parallel_reduce(
+              impl::blocked_range(range, policy),
+              std::move(init),
+              [&func](const auto& block, Val val) {
+                for (auto&& item : block) {
+                  val = std::invoke(func, std::move(val), item);
+                }
+                return val;
+              },
+              [&join](Val a, Val b) {
+                return std::invoke(join, std::move(a), std::move(b));
+              },
+              part);
+        });
+  }
+};
+
+/// @copydoc Fold
+inline constexpr Fold fold{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Parallel reduce.
+///
+/// Elements are combined with the operation, starting from the initial value.
+/// Initial value must be the identity of the operation, and the operation
+/// must be associative.
+struct Reduce final {
+  template<range Range,
+           std::copyable Val = std::ranges::range_value_t<Range>,
+           class Op = std::plus<>>
+    requires std::regular_invocable<Op&,
+                                    Val,
+                                    std::ranges::range_reference_t<Range>> &&
+             std::regular_invocable<Op&, Val, Val>
+  static auto operator()(Range&& range, Val init = {}, Op op = {}) -> Val {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    return fold(range, std::move(init), op, op);
+  }
+};
+
+/// @copydoc Reduce
+inline constexpr Reduce reduce{};
+
+/// Parallel transform-reduce.
+///
+/// Elements are transformed with the function, and the results are combined
+/// with the operation, starting from the initial value. Initial value must be
+/// the identity of the operation, and the operation must be associative.
+struct TransformReduce final {
+  template<range Range, std::copyable Val, class Op, class Func>
+    requires std::regular_invocable<Func&,
+                                    std::ranges::range_reference_t<Range>> &&
+             std::regular_invocable<
+                 Op&,
+                 Val,
+                 std::invoke_result_t<Func&,
+                                      std::ranges::range_reference_t<Range>>> &&
+             std::regular_invocable<Op&, Val, Val>
+  static auto operator()(Range&& range, Val init, Op op, Func func) -> Val {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    return operator()(Policy{},
+                      range,
+                      std::move(init),
+                      std::move(op),
+                      std::move(func));
+  }
+  template<range Range, std::copyable Val, class Op, class Func>
+    requires std::regular_invocable<Func&,
+                                    std::ranges::range_reference_t<Range>> &&
+             std::regular_invocable<
+                 Op&,
+                 Val,
+                 std::invoke_result_t<Func&,
+                                      std::ranges::range_reference_t<Range>>> &&
+             std::regular_invocable<Op&, Val, Val>
+  static auto operator()(const Policy& policy,
+                         Range&& range,
+                         Val init,
+                         Op op,
+                         Func func) -> Val {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    return fold(
+        policy,
+        range,
+        std::move(init),
+        [&op, &func]<class Item>(Val val, Item&& item) {
+          TIT_ASSUME_UNIVERSAL(Item, item);
+          return std::invoke(op, std::move(val), std::invoke(func, item));
+        },
+        op);
+  }
+};
+
+/// @copydoc TransformReduce
+inline constexpr TransformReduce transform_reduce{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Parallel minimum element search.
+///
+/// If there are several minimal elements, the first one is returned. End of
+/// the range is returned if the range is empty.
+struct MinElement final {
+  template<range Range,
+           class Proj = std::identity,
+           std::indirect_strict_weak_order<
+               std::projected<std::ranges::iterator_t<Range>, Proj>> Compare =
+               std::ranges::less>
+  static auto operator()(Range&& range, Compare compare = {}, Proj proj = {})
+      -> std::ranges::iterator_t<Range> {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    using Iter = std::ranges::iterator_t<Range>;
+    const auto last = std::end(range);
+    // Pick the right iterator only if it is strictly less, so that the first
+    // of the equal elements wins. Left iterator always precedes the right.
+    const auto min = [&compare, &proj, last](Iter a, Iter b) {
+      if (a == last) return b;
+      if (b == last) return a;
+      const auto is_less =
+          std::invoke(compare, std::invoke(proj, *b), std::invoke(proj, *a));
+      return is_less ? b : a;
+    };
+    return tbb::parallel_reduce(
+        tbb::blocked_range{std::begin(range), last},
+        last,
+        [&compare, &proj, &min](const auto& block, Iter iter) {
+          return min(iter, std::ranges::min_element(block, compare, proj));
+        },
+        min);
+  }
+};
+
+/// @copydoc MinElement
+inline constexpr MinElement min_element{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Base of the parallel scans.
+///
+/// The range is split into the per-thread blocks, which are reduced
+/// concurrently. Then the block totals are scanned serially, and the blocks
+/// are scanned concurrently, each starting from the total of the preceding
+/// blocks. Small ranges are scanned serially. Operation must be associative.
+/// Output may be the beginning of the input range.
+struct ScanBase {
+  /// Ranges smaller than this size are scanned serially.
+  static constexpr size_t SerialThreshold = 16384;
+
+protected:
+
+  // Scan the range. Block function is called as `scan(first, last, out,
+  // offset)`, where `offset` is the total of the preceding elements, or empty
+  // if there are none and the initial value is not given.
+  template<class Val, class Range, class OutIter, class Op, class ScanBlock>
+  static auto scan_(Range& range,
+                    OutIter out,
+                    std::optional<Val> init,
+                    Op& op,
+                    const ScanBlock& scan_block) -> OutIter {
+    const auto size = std::size(range);
+    const auto first = std::begin(range);
+    if (size < SerialThreshold) {
+      return scan_block(first, first + size, out, init);
+    }
+    const auto thread_count = num_threads();
+    auto block_first = [quotient = size / thread_count,
+                        remainder = size % thread_count,
+                        first](size_t index) {
+      const auto offset = index * quotient + std::min(index, remainder);
+      return first + offset;
+    };
+    const auto for_each_block = [thread_count](const auto& func) {
+      tbb::parallel_for<size_t>(/*first=*/0,
+                                /*last=*/thread_count,
+                                /*step=*/1,
+                                func,
+                                tbb::static_partitioner{});
+    };
+
+    // Reduce the blocks, the last one is never needed. Blocks are not empty,
+    // since the range is large enough.
+    std::vector<std::optional<Val>> offsets(thread_count);
+    for_each_block([&block_first, &offsets, &op](size_t thread_index) {
+      if (thread_index + 1 == offsets.size()) return;
+      const auto block_first_iter = block_first(thread_index);
+      offsets[thread_index + 1] = std::accumulate(
+          std::next(block_first_iter),
+          block_first(thread_index + 1),
+          Val(*block_first_iter),
+          std::ref(op));
+    });
+
+    // Scan the block totals.
+    offsets[0] = std::move(init);
+    for (size_t i = 1; i < thread_count; ++i) {
+      if (offsets[i - 1].has_value()) {
+        offsets[i] = std::invoke(op, *offsets[i - 1], *std::move(offsets[i]));
+      }
+    }
+
+    // Scan the blocks.
+    for_each_block(
+        [&block_first, &offsets, &scan_block, first, out](size_t thread_index) {
+          const auto block_first_iter = block_first(thread_index);
+          scan_block(block_first_iter,
+                     block_first(thread_index + 1),
+                     out + (block_first_iter - first),
+                     offsets[thread_index]);
+        });
+    return out + size;
+  }
+};
+
+/// Parallel inclusive scan, see `ScanBase`.
+struct InclusiveScan final : ScanBase {
+  template<range Range,
+           std::random_access_iterator OutIter,
+           class Op = std::plus<>>
+    requires std::indirectly_writable<OutIter,
+                                      std::ranges::range_value_t<Range>>
+  static auto operator()(Range&& range, OutIter out, Op op = {}) -> OutIter {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    using Val = std::ranges::range_value_t<Range>;
+    return scan_<Val>(
+        range,
+        out,
+        std::nullopt,
+        op,
+        [&op](auto first, auto last, OutIter iter, std::optional<Val> offset) {
+          if (!offset.has_value()) {
+            return std::inclusive_scan(first, last, iter, std::ref(op));
+          }
+          return std::inclusive_scan(first,
+                                     last,
+                                     iter,
+                                     std::ref(op),
+                                     *std::move(offset));
+        });
+  }
+};
+
+/// @copydoc InclusiveScan
+inline constexpr InclusiveScan inclusive_scan{};
+
+/// Parallel exclusive scan, see `ScanBase`.
+struct ExclusiveScan final : ScanBase {
+  template<range Range,
+           std::random_access_iterator OutIter,
+           std::copyable Val,
+           class Op = std::plus<>>
+    requires std::indirectly_writable<OutIter, Val>
+  static auto operator()(Range&& range, OutIter out, Val init, Op op = {})
+      -> OutIter {
+    TIT_ASSUME_UNIVERSAL(Range, range);
+    return scan_<Val>(
+        range,
+        out,
+        std::move(init),
+        op,
+        [&op](auto first, auto last, OutIter iter, std::optional<Val> offset) {
+          TIT_ASSERT(offset.has_value(), "Initial value must be present!");
+          return std::exclusive_scan(first,
+                                     last,
+                                     iter,
+                                     *std::move(offset),
+                                     std::ref(op));
+        });
+  }
+};
+
+/// @copydoc ExclusiveScan
+inline constexpr ExclusiveScan exclusive_scan{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Parallel transform.
 struct Transform final {
   template<range Range,
@@ -158,6 +978,68 @@ inline constexpr Transform transform{};
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Parallel permutation of the multiple columns.
+///
+/// Each column is gathered into its buffer, `buffer[i] = column[perm[i]]`,
+/// and then swapped with it, so that the buffers keep the storage between
+/// the calls and the permutations of the same size do not allocate. Indices
+/// are processed by blocks, and all the columns are gathered for a block
+/// before the next one, so that the block of the permutation stays in cache.
+struct Permute final {
+  /// Number of indices in a block.
+  static constexpr size_t BlockSize = 1024;
+
+  template<std::ranges::random_access_range Perm, class Cols, class Buffers>
+    requires std::convertible_to<std::ranges::range_value_t<Perm>, size_t> &&
+             (std::tuple_size_v<std::remove_cvref_t<Cols>> ==
+              std::tuple_size_v<std::remove_cvref_t<Buffers>>)
+  static void operator()(const Perm& perm, Cols&& cols, Buffers&& buffers) {
+    TIT_ASSUME_UNIVERSAL(Cols, cols);
+    TIT_ASSUME_UNIVERSAL(Buffers, buffers);
+    static constexpr auto NumCols =
+        std::tuple_size_v<std::remove_cvref_t<Cols>>;
+    const auto for_each_col = [&cols, &buffers](const auto& func) {
+      [&]<size_t... Indices>(std::index_sequence<Indices...> /*indices*/) {
+        (func(std::get<Indices>(cols), std::get<Indices>(buffers)), ...);
+      }(std::make_index_sequence<NumCols>{});
+    };
+
+    // Prepare the buffers.
+    const auto size = std::size(perm);
+    for_each_col([size](const auto& col, auto& buffer) {
+      TIT_ASSERT(std::size(col) == size,
+                 "Column size must match the permutation size!");
+      buffer.resize(size);
+    });
+
+    // Gather the columns.
+    const auto num_blocks = (size + BlockSize - 1) / BlockSize;
+    for_each(std::views::iota(size_t{0}, num_blocks),
+             [&perm, &for_each_col, size](size_t block) {
+               const auto first = block * BlockSize;
+               const auto last = std::min(first + BlockSize, size);
+               for_each_col([&perm, first, last](const auto& col,
+                                                 auto& buffer) {
+                 for (size_t i = first; i < last; ++i) {
+                   TIT_ASSERT(static_cast<size_t>(perm[i]) < std::size(col),
+                              "Permutation index is out of range!");
+                   buffer[i] = col[perm[i]];
+                 }
+               });
+             });
+
+    // Swap the columns with the buffers.
+    for_each_col([](auto& col, auto& buffer) {
+      std::ranges::swap(col, buffer);
+    });
+  }
+};
+
+/// @copydoc Permute
+inline constexpr Permute permute{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Parallel sort.
 struct Sort final {
   template<range Range, class Compare = std::less<>, class Proj = std::identity>
@@ -180,4 +1062,114 @@ inline constexpr Sort sort{};
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Parallel radix sort of the values by the unsigned integer keys.
+///
+/// Least significant digit radix sort is used, the digits are eight bits
+/// wide. On each pass, the digits are counted in the per-thread blocks, and
+/// then the keys and values are scattered into the buffers at their offsets.
+/// Passes over the digits that are same for all the keys are skipped, and
+/// already sorted keys are detected upfront, so that the sparse keys and the
+/// nearly unchanged orderings are sorted cheaply. The sort is stable.
+struct RadixSort final {
+  /// Ranges smaller than this size are sorted serially.
+  static constexpr size_t SerialThreshold = 16384;
+
+  template<std::unsigned_integral Key, std::movable Val>
+    requires std::default_initializable<Val>
+  static void operator()(std::span<Key> keys, std::span<Val> vals) {
+    TIT_ASSERT(keys.size() == vals.size(),
+               "Number of the keys and values must match!");
+    if (std::ranges::is_sorted(keys)) return;
+    const auto size = keys.size();
+    const auto thread_count = size < SerialThreshold ? 1 : num_threads();
+    auto block_offset = [quotient = size / thread_count,
+                         remainder = size % thread_count](size_t index) {
+      return index * quotient + std::min(index, remainder);
+    };
+    const auto for_each_block = [thread_count](const auto& func) {
+      tbb::parallel_for<size_t>(/*first=*/0,
+                                /*last=*/thread_count,
+                                /*step=*/1,
+                                func,
+                                tbb::static_partitioner{});
+    };
+
+    // Sort the keys digit by digit, swapping the keys and the buffers.
+    static constexpr size_t DigitBits = 8;
+    static constexpr size_t NumDigits = size_t{1} << DigitBits;
+    std::vector<Key> key_buffer(size);
+    std::vector<Val> val_buffer(size);
+    auto src_keys = keys;
+    auto src_vals = vals;
+    auto dst_keys = std::span{key_buffer};
+    auto dst_vals = std::span{val_buffer};
+    std::vector<size_t> offsets(thread_count * NumDigits);
+    for (size_t shift = 0; shift < 8 * sizeof(Key); shift += DigitBits) {
+      const auto digit = [shift](Key key) {
+        return static_cast<size_t>(key >> shift) & (NumDigits - 1);
+      };
+
+      // Count the digits in each block.
+      std::ranges::fill(offsets, 0);
+      for_each_block([&src_keys, &block_offset, &offsets, &digit](
+                         size_t thread_index) {
+        const auto first = block_offset(thread_index);
+        const auto last = block_offset(thread_index + 1);
+        const auto counts = offsets.begin() + thread_index * NumDigits;
+        for (size_t i = first; i < last; ++i) ++counts[digit(src_keys[i])];
+      });
+
+      // Compute the offsets of the digits in each block, and skip the pass
+      // if all the keys have the same digit.
+      size_t offset = 0;
+      bool is_trivial = false;
+      for (size_t d = 0; d < NumDigits; ++d) {
+        const auto first_offset = offset;
+        for (size_t t = 0; t < thread_count; ++t) {
+          offset += std::exchange(offsets[t * NumDigits + d], offset);
+        }
+        if (offset - first_offset == size) is_trivial = true;
+      }
+      if (is_trivial) continue;
+
+      // Scatter the keys and the values.
+      for_each_block([&src_keys,
+                      &src_vals,
+                      &dst_keys,
+                      &dst_vals,
+                      &block_offset,
+                      &offsets,
+                      &digit](size_t thread_index) {
+        const auto first = block_offset(thread_index);
+        const auto last = block_offset(thread_index + 1);
+        const auto positions = offsets.begin() + thread_index * NumDigits;
+        for (size_t i = first; i < last; ++i) {
+          const auto position = positions[digit(src_keys[i])]++;
+          dst_keys[position] = src_keys[i];
+          dst_vals[position] = std::move(src_vals[i]);
+        }
+      });
+      std::swap(src_keys, dst_keys);
+      std::swap(src_vals, dst_vals);
+    }
+
+    // Move the results back, if they are stored in the buffers.
+    if (src_keys.data() == keys.data()) return;
+    for_each_block([&src_keys, &src_vals, &keys, &vals, &block_offset](
+                       size_t thread_index) {
+      const auto first = block_offset(thread_index);
+      const auto last = block_offset(thread_index + 1);
+      std::ranges::copy(src_keys.subspan(first, last - first),
+                        keys.begin() + first);
+      std::ranges::move(src_vals.subspan(first, last - first),
+                        vals.begin() + first);
+    });
+  }
+};
+
+/// @copydoc RadixSort
+inline constexpr RadixSort radix_sort{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::par
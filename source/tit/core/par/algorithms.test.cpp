@@ -5,9 +5,13 @@
 
 #include <algorithm>
 #include <chrono>
+#include <functional>
+#include <numeric>
 #include <random>
 #include <ranges>
+#include <span>
 #include <thread>
+#include <tuple>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
@@ -49,6 +53,30 @@ TEST_CASE("par::for_each") {
   }
 }
 
+TEST_CASE("par::for_each (policy)") {
+  par::set_num_threads(4);
+  par::Affinity affinity{};
+  for (const auto policy :
+       {par::Policy{},
+        par::Policy{.grain_size = 16, .partitioner = par::Partitioner::simple},
+        par::Policy{.partitioner = par::Partitioner::uniform},
+        par::Policy{.partitioner = par::Partitioner::affinity,
+                    .affinity = &affinity}}) {
+    // Ensure the loop is executed with each of the partitioners. Affinity
+    // state is reused between the calls.
+    std::vector<int> data(1000, 0);
+    par::for_each(policy, data, [](int& i) { i += 1; });
+    par::for_each(policy, data, [](int& i) { i += 1; });
+    CHECK(std::ranges::all_of(data, [](int i) { return i == 2; }));
+    CHECK(par::transform_reduce(
+              policy,
+              data,
+              0,
+              std::plus{},
+              [](int i) { return i; }) == 2000);
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("par::static_for_each") {
@@ -95,6 +123,14 @@ TEST_CASE("par::block_for_each") {
     });
     CHECK(data == VectorOfVectors{{1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}});
   }
+  SUBCASE("level size") {
+    // Ensure the loop is executed for the custom level size.
+    par::block_for_each(data, /*level_size=*/2, [](int& i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      i += 1;
+    });
+    CHECK(data == VectorOfVectors{{1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}});
+  }
   SUBCASE("exceptions") {
     // Ensure the exceptions from the worker threads are caught.
     const auto loop = [&data] {
@@ -110,6 +146,108 @@ TEST_CASE("par::block_for_each") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("par::deps_for_each") {
+  par::set_num_threads(4);
+  using VectorOfVectors = std::vector<std::vector<int>>;
+  VectorOfVectors data{{0, 1}, {2, 3}, {4}, {5, 6}, {7}};
+  const VectorOfVectors deps{{}, {}, {0, 1}, {}, {2, 3}};
+  SUBCASE("basic") {
+    // Ensure the loop is executed and the dependencies are respected.
+    std::vector<int> done(10, 0);
+    bool deps_respected = true;
+    par::deps_for_each(data, deps, [&done, &deps_respected](int& i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      if (i == 4) deps_respected &= done[0] && done[1] && done[2] && done[3];
+      if (i == 7) deps_respected &= done[4] && done[5] && done[6];
+      done[i] = 1;
+      i += 1;
+    });
+    CHECK(deps_respected);
+    CHECK(data == VectorOfVectors{{1, 2}, {3, 4}, {5}, {6, 7}, {8}});
+  }
+  SUBCASE("exceptions") {
+    // Ensure the exceptions from the worker threads are caught.
+    const auto loop = [&data, &deps] {
+      par::deps_for_each(data, deps, [](int i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        if (i == 4) throw std::runtime_error{"Loop failed!"};
+      });
+      FAIL("Loop should have thrown an exception!");
+    };
+    CHECK_THROWS_WITH_AS(loop(), "Loop failed!", std::runtime_error);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::flat_for_each") {
+  par::set_num_threads(4);
+  using VectorOfVectors = std::vector<std::vector<int>>;
+  VectorOfVectors data{{0, 1}, {2, 3}, {4, 5}, {6, 7}, {8, 9}};
+  SUBCASE("basic") {
+    // Ensure the loop is executed.
+    par::flat_for_each(data, [](int& i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      i += 1;
+    });
+    CHECK(data == VectorOfVectors{{1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}});
+  }
+  SUBCASE("non-random access blocks") {
+    // Ensure the blocks that are not random access are iterated sequentially.
+    const auto blocks =
+        data | std::views::transform([](std::vector<int>& block) {
+          return block |
+                 std::views::filter([](int i) { return i % 2 == 0; });
+        });
+    par::flat_for_each(blocks, [](int& i) { i += 2; });
+    CHECK(data == VectorOfVectors{{2, 1}, {4, 3}, {6, 5}, {8, 7}, {10, 9}});
+  }
+  SUBCASE("exceptions") {
+    // Ensure the exceptions from the worker threads are caught.
+    const auto loop = [&data] {
+      par::flat_for_each(data, [](int i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        if (i == 7) throw std::runtime_error{"Loop failed!"};
+      });
+      FAIL("Loop should have thrown an exception!");
+    };
+    CHECK_THROWS_WITH_AS(loop(), "Loop failed!", std::runtime_error);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::for_each_batch") {
+  par::set_num_threads(4);
+  std::vector<int> data{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  SUBCASE("basic") {
+    // Ensure the loop is executed and the batches are correct.
+    std::vector<size_t> sizes(4);
+    par::for_each_batch(data, 3, [&sizes](auto batch) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      sizes[batch.front() / 3] = std::size(batch);
+      for (int& i : batch) i += 1;
+    });
+    CHECK(data == std::vector{1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    CHECK(sizes == std::vector<size_t>{3, 3, 3, 1});
+  }
+  SUBCASE("exceptions") {
+    // Ensure the exceptions from the worker threads are caught.
+    const auto loop = [&data] {
+      par::for_each_batch(data, 3, [](auto batch) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        if (std::ranges::contains(batch, 7)) {
+          throw std::runtime_error{"Loop failed!"};
+        }
+      });
+      FAIL("Loop should have thrown an exception!");
+    };
+    CHECK_THROWS_WITH_AS(loop(), "Loop failed!", std::runtime_error);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("par::copy_if") {
   par::set_num_threads(4);
   std::vector<int> data{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
@@ -141,6 +279,199 @@ TEST_CASE("par::copy_if") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("par::remove_if") {
+  par::set_num_threads(4);
+  std::vector<int> data{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  SUBCASE("basic") {
+    const auto iter = par::remove_if(data, [](int i) { return i % 3 != 0; });
+    CHECK(iter == data.begin() + 5);
+    CHECK_RANGE_EQ(std::ranges::subrange(data.begin(), iter),
+                   {0, 3, 6, 9, 12});
+  }
+  SUBCASE("projection") {
+    const auto iter = par::remove_if(
+        data,
+        [](int i) { return i < 5; },
+        [](int i) { return 12 - i; });
+    CHECK(iter == data.begin() + 8);
+    CHECK_RANGE_EQ(std::ranges::subrange(data.begin(), iter),
+                   {0, 1, 2, 3, 4, 5, 6, 7});
+  }
+  SUBCASE("exceptions") {
+    // Ensure the exceptions from the worker threads are caught.
+    const auto algorithm = [&data] {
+      par::remove_if(data, [](int i) {
+        if (i == 7) throw std::runtime_error{"Algorithm failed!"};
+        return i % 2 == 0;
+      });
+      FAIL("Algorithm should have thrown an exception!");
+    };
+    CHECK_THROWS_WITH_AS(algorithm(), "Algorithm failed!", std::runtime_error);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::partition") {
+  par::set_num_threads(4);
+  const auto is_even = [](int i) { return i % 2 == 0; };
+  SUBCASE("small") {
+    std::vector<int> data{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    const auto iter = par::partition(data, is_even);
+    CHECK(iter == data.begin() + 5);
+    CHECK(std::ranges::all_of(data.begin(), iter, is_even));
+    CHECK(std::ranges::none_of(iter, data.end(), is_even));
+  }
+  SUBCASE("large") {
+    // Ensure the parallel code path produces a valid partitioning.
+    auto data = std::views::iota(0, 100'000) | std::ranges::to<std::vector>();
+    std::ranges::shuffle(data, std::mt19937{123});
+    const auto iter = par::partition(data, is_even);
+    CHECK(iter == data.begin() + 50'000);
+    CHECK(std::ranges::all_of(data.begin(), iter, is_even));
+    CHECK(std::ranges::none_of(iter, data.end(), is_even));
+    std::ranges::sort(data);
+    CHECK_RANGE_EQ(data, std::views::iota(0, 100'000));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::nth_element") {
+  par::set_num_threads(4);
+  SUBCASE("small") {
+    std::vector<int> data{5, 3, 9, 1, 7, 0, 8, 2, 6, 4};
+    const auto nth = data.begin() + 3;
+    par::nth_element(data, nth);
+    CHECK(*nth == 3);
+    CHECK(std::ranges::all_of(data.begin(), nth, [](int i) { return i < 3; }));
+  }
+  SUBCASE("large") {
+    // Ensure the parallel code path produces the correct element, also in
+    // the presence of many duplicates.
+    std::vector<int> data(100'000);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<int>(i / 7);
+    std::ranges::shuffle(data, std::mt19937{123});
+    const auto nth = data.begin() + 12'345;
+    par::nth_element(data, nth, std::greater{});
+    const auto expected = static_cast<int>((data.size() - 1 - 12'345) / 7);
+    CHECK(*nth == expected);
+    CHECK(std::ranges::all_of(data.begin(), nth, [expected](int i) {
+      return i >= expected;
+    }));
+    CHECK(std::ranges::all_of(nth, data.end(), [expected](int i) {
+      return i <= expected;
+    }));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::fold") {
+  par::set_num_threads(4);
+  const auto data =
+      std::views::iota(1, 100'001) | std::ranges::to<std::vector>();
+  SUBCASE("basic") {
+    const auto sum = par::fold(
+        data,
+        int64_t{0},
+        [](int64_t acc, int i) { return acc + i; },
+        std::plus{});
+    CHECK(sum == int64_t{5'000'050'000});
+  }
+  SUBCASE("exceptions") {
+    // Ensure the exceptions from the worker threads are caught.
+    const auto algorithm = [&data] {
+      par::fold(
+          data,
+          0,
+          [](int acc, int i) {
+            if (i == 777) throw std::runtime_error{"Algorithm failed!"};
+            return std::max(acc, i);
+          },
+          [](int a, int b) { return std::max(a, b); });
+      FAIL("Algorithm should have thrown an exception!");
+    };
+    CHECK_THROWS_WITH_AS(algorithm(), "Algorithm failed!", std::runtime_error);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::reduce") {
+  par::set_num_threads(4);
+  const auto data =
+      std::views::iota(1, 100'001) | std::ranges::to<std::vector>();
+  CHECK(par::reduce(data, int64_t{0}) == int64_t{5'000'050'000});
+  CHECK(par::reduce(data, 1, [](int a, int b) { return std::max(a, b); }) ==
+        100'000);
+}
+
+TEST_CASE("par::transform_reduce") {
+  par::set_num_threads(4);
+  const auto data =
+      std::views::iota(1, 100'001) | std::ranges::to<std::vector>();
+  const auto sum_sqr = par::transform_reduce(
+      data,
+      int64_t{0},
+      std::plus{},
+      [](int i) { return int64_t{i} * i; });
+  CHECK(sum_sqr == int64_t{333'338'333'350'000});
+}
+
+TEST_CASE("par::min_element") {
+  par::set_num_threads(4);
+  auto data = std::views::iota(0, 100'000) |
+              std::views::transform([](int i) { return (i * 7919) % 1000; }) |
+              std::ranges::to<std::vector>();
+  SUBCASE("first of the minimal elements") {
+    const auto iter = par::min_element(data);
+    CHECK(*iter == 0);
+    CHECK(iter == std::ranges::min_element(data));
+  }
+  SUBCASE("projection") {
+    const auto iter = par::min_element(data, {}, std::negate{});
+    CHECK(*iter == 999);
+    CHECK(iter == std::ranges::max_element(data));
+  }
+  SUBCASE("empty range") {
+    data.clear();
+    CHECK(par::min_element(data) == data.end());
+  }
+}
+
+TEST_CASE("par::inclusive_scan") {
+  par::set_num_threads(4);
+  for (const size_t size : {size_t{10}, size_t{100'000}}) {
+    auto data = std::views::iota(size_t{0}, size) |
+                std::ranges::to<std::vector>();
+    std::vector<size_t> expected(size);
+    std::inclusive_scan(data.begin(), data.end(), expected.begin());
+    std::vector<size_t> out(size);
+    CHECK(par::inclusive_scan(data, out.begin()) == out.end());
+    CHECK(out == expected);
+    par::inclusive_scan(data, data.begin()); // in place.
+    CHECK(data == expected);
+  }
+}
+
+TEST_CASE("par::exclusive_scan") {
+  par::set_num_threads(4);
+  for (const size_t size : {size_t{10}, size_t{100'000}}) {
+    auto data = std::views::iota(size_t{0}, size) |
+                std::ranges::to<std::vector>();
+    std::vector<size_t> expected(size);
+    std::exclusive_scan(data.begin(), data.end(), expected.begin(), size_t{3});
+    std::vector<size_t> out(size);
+    CHECK(par::exclusive_scan(data, out.begin(), size_t{3}) == out.end());
+    CHECK(out == expected);
+    par::exclusive_scan(data, data.begin(), size_t{3}); // in place.
+    CHECK(data == expected);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("par::transform") {
   par::set_num_threads(4);
   std::vector<int> data{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
@@ -170,6 +501,39 @@ TEST_CASE("par::transform") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("par::permute") {
+  par::set_num_threads(4);
+  SUBCASE("basic") {
+    // Ensure all the columns are permuted.
+    std::vector<int> ints{10, 11, 12, 13, 14};
+    std::vector<double> doubles{0.0, 0.5, 1.0, 1.5, 2.0};
+    std::vector<int> int_buffer;
+    std::vector<double> double_buffer;
+    const std::vector<size_t> perm{4, 2, 0, 1, 3};
+    par::permute(perm,
+                 std::tie(ints, doubles),
+                 std::tie(int_buffer, double_buffer));
+    CHECK_RANGE_EQ(ints, {14, 12, 10, 11, 13});
+    CHECK_RANGE_EQ(doubles, {2.0, 1.0, 0.0, 0.5, 1.5});
+  }
+  SUBCASE("large") {
+    // Ensure the blocks are permuted, and the buffers are reused.
+    constexpr size_t size = 10 * par::Permute::BlockSize + 123;
+    auto data = std::views::iota(size_t{0}, size) |
+                std::ranges::to<std::vector>();
+    auto perm = data;
+    std::ranges::shuffle(perm, std::mt19937{123});
+    std::vector<size_t> buffer;
+    par::permute(perm, std::tie(data), std::tie(buffer));
+    CHECK(data == perm);
+    const auto* const buffer_data = buffer.data();
+    par::permute(perm, std::tie(data), std::tie(buffer));
+    CHECK(data.data() == buffer_data);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("par::sort") {
   par::set_num_threads(4);
   constexpr auto sorted = std::views::iota(0, 1000);
@@ -195,5 +559,36 @@ TEST_CASE("par::sort") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("par::radix_sort") {
+  par::set_num_threads(4);
+  SUBCASE("small") {
+    std::vector<uint32_t> keys{5, 3, 9, 1, 3, 0};
+    std::vector<int> vals{0, 1, 2, 3, 4, 5};
+    par::radix_sort(std::span{keys}, std::span{vals});
+    CHECK_RANGE_EQ(keys, {0, 1, 3, 3, 5, 9});
+    CHECK_RANGE_EQ(vals, {5, 3, 1, 4, 0, 2});
+  }
+  SUBCASE("large") {
+    // Ensure the parallel code path sorts the keys both with the full range
+    // of the digits, and when some of the digits are same for all keys.
+    for (const auto shift : {0, 40}) {
+      std::mt19937_64 random_engine{123};
+      std::vector<uint64_t> keys(100'000);
+      for (auto& key : keys) key = (random_engine() % 1'000'000) << shift;
+      auto vals = std::views::iota(size_t{0}, keys.size()) |
+                  std::ranges::to<std::vector>();
+      auto expected = vals;
+      std::ranges::stable_sort(expected, std::less{}, [&keys](size_t i) {
+        return keys[i];
+      });
+      par::radix_sort(std::span{keys}, std::span{vals});
+      CHECK(std::ranges::is_sorted(keys));
+      CHECK_RANGE_EQ(vals, expected);
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
@@ -5,10 +5,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <concepts>
 #include <type_traits>
 
+#include "tit/core/basic_types.hpp"
 #include "tit/core/type_utils.hpp"
+#include "tit/core/vec.hpp"
 
 namespace tit::par {
 
@@ -21,6 +24,29 @@ auto fetch_and_add(Val& val, difference_t<Val> delta) noexcept -> Val {
   return __atomic_fetch_add(&val, delta, __ATOMIC_RELAXED); // NOLINT(*-vararg)
 }
 
+/// Atomically perform floating-point addition and return what was stored
+/// before. Native instructions are used if available, otherwise the addition
+/// is done in a compare-and-swap loop.
+template<std::floating_point Val>
+auto fetch_and_add(Val& val, std::type_identity_t<Val> delta) noexcept
+    -> Val {
+  return std::atomic_ref{val}.fetch_add(delta, std::memory_order_relaxed);
+}
+
+/// Atomically add to the scalar value.
+template<class Val>
+  requires std::integral<Val> || std::floating_point<Val>
+void atomic_add(Val& val, std::type_identity_t<Val> delta) noexcept {
+  fetch_and_add(val, delta);
+}
+
+/// Atomically add to each of the vector components. Components are updated
+/// independently, so the vector as a whole is not updated atomically.
+template<class Num, size_t Dim>
+void atomic_add(Vec<Num, Dim>& val, const Vec<Num, Dim>& delta) noexcept {
+  for (size_t i = 0; i < Dim; ++i) atomic_add(val[i], delta[i]);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit::par
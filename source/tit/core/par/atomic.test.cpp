@@ -3,7 +3,12 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <ranges>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/algorithms.hpp"
 #include "tit/core/par/atomic.hpp"
+#include "tit/core/vec.hpp"
 
 #include "tit/testing/test.hpp"
 
@@ -22,6 +27,28 @@ TEST_CASE("par::fetch_and_add") {
   CHECK(val == init + delta);
 }
 
+TEST_CASE("par::fetch_and_add (floating-point)") {
+  auto val = 1.5;
+  CHECK(par::fetch_and_add(val, 2.0) == 1.5);
+  CHECK(val == 3.5);
+}
+
+TEST_CASE("par::atomic_add") {
+  // Concurrent additions of the exactly representable values must not lose
+  // any of the updates.
+  constexpr size_t count = 10000;
+  double sum = 0.0;
+  Vec<double, 2> vec_sum{};
+  par::for_each(std::views::iota(size_t{0}, count),
+                [&sum, &vec_sum](size_t /*i*/) {
+                  par::atomic_add(sum, 1.0);
+                  par::atomic_add(vec_sum, Vec<double, 2>{1.0, 2.0});
+                });
+  constexpr auto expected = static_cast<double>(count);
+  CHECK(sum == expected);
+  CHECK(vec_sum == Vec<double, 2>{expected, 2 * expected});
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
@@ -3,10 +3,19 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
 #include <mutex>
 #include <optional>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include <oneapi/tbb/global_control.h>
+#include <oneapi/tbb/task_arena.h>
+#include <oneapi/tbb/task_scheduler_observer.h>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
@@ -17,8 +26,13 @@ namespace tit::par {
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 auto num_threads() noexcept -> size_t {
-  return tbb::global_control::active_value(
+  // Arena concurrency is known to all the threads that execute within it,
+  // including the workers.
+  const auto value = tbb::global_control::active_value(
       tbb::global_control::max_allowed_parallelism);
+  const auto arena_value =
+      static_cast<size_t>(tbb::this_task_arena::max_concurrency());
+  return std::min(value, arena_value);
 }
 
 void set_num_threads(size_t value) {
@@ -28,6 +42,83 @@ void set_num_threads(size_t value) {
   control.emplace(tbb::global_control::max_allowed_parallelism, value);
 }
 
+namespace {
+
+auto thread_grain_size() noexcept -> size_t& {
+  thread_local size_t value = 1;
+  return value;
+}
+
+} // namespace
+
+auto grain_size() noexcept -> size_t {
+  return thread_grain_size();
+}
+
+GrainScope::GrainScope(size_t grain_size) noexcept
+    : prev_grain_size_{thread_grain_size()} {
+  TIT_ASSERT(grain_size > 0, "Grain size must be positive!");
+  thread_grain_size() = grain_size;
+}
+
+GrainScope::~GrainScope() noexcept {
+  thread_grain_size() = prev_grain_size_;
+}
+
+#ifdef __linux__
+
+namespace {
+
+// Observer that pins the threads entering the arena to the CPUs.
+class ThreadPinner final : public tbb::task_scheduler_observer {
+public:
+
+  ThreadPinner() {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0) return;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpus)) cpus_.push_back(cpu);
+    }
+    observe(true);
+  }
+
+  ThreadPinner(ThreadPinner&&) = delete;
+  ThreadPinner(const ThreadPinner&) = delete;
+  auto operator=(ThreadPinner&&) -> ThreadPinner& = delete;
+  auto operator=(const ThreadPinner&) -> ThreadPinner& = delete;
+
+  ~ThreadPinner() override {
+    observe(false);
+  }
+
+  void on_scheduler_entry(bool /*is_worker*/) override {
+    const auto slot = tbb::this_task_arena::current_thread_index();
+    if (slot < 0 || cpus_.empty()) return;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpus_[static_cast<size_t>(slot) % cpus_.size()], &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+
+private:
+
+  std::vector<int> cpus_;
+
+}; // class ThreadPinner
+
+} // namespace
+
+void pin_threads() {
+  static const ThreadPinner pinner{};
+}
+
+#else
+
+void pin_threads() {}
+
+#endif
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 auto global_mutex() noexcept -> std::mutex& {
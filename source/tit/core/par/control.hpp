@@ -8,17 +8,52 @@
 #include <mutex>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/utils.hpp"
 
 namespace tit::par {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-/// Get number of the worker threads.
+/// Get number of the worker threads. Within a task arena, the number of the
+/// arena threads, see `TaskArena`.
 auto num_threads() noexcept -> size_t;
 
 /// Set number of the worker threads.
 void set_num_threads(size_t value);
 
+/// Get the grain size of the calling thread, the minimal number of the range
+/// elements processed by a single task of `par::for_each`. With the grain
+/// size of one, the default, the tasks are sized by the partitioner alone.
+auto grain_size() noexcept -> size_t;
+
+/// Grain size override of the calling thread.
+///
+/// While the scope is alive, the loops started from the calling thread use
+/// the given grain size, and so do the loops started from the bodies of
+/// `par::for_each`. Grain size is thus owned by the code that opens the scope, e.g.
+/// a solver, and the other threads are not affected by it.
+class GrainScope final {
+public:
+
+  /// Override the grain size of the calling thread.
+  explicit GrainScope(size_t grain_size) noexcept;
+
+  /// Restore the previous grain size.
+  ~GrainScope() noexcept;
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(GrainScope);
+
+private:
+
+  size_t prev_grain_size_;
+
+}; // class GrainScope
+
+/// Pin the threads to the CPUs available to the process, one CPU per thread
+/// slot, so that the threads stay next to the memory they have first-touched.
+/// Has no effect on the platforms other than Linux.
+void pin_threads();
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Get the global mutex.
@@ -3,6 +3,9 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <thread>
+
+#include "tit/core/basic_types.hpp"
 #include "tit/core/par/control.hpp"
 
 #include "tit/testing/test.hpp"
@@ -21,6 +24,34 @@ TEST_CASE("par::num_threads") {
   CHECK(par::num_threads() == 3);
 }
 
+TEST_CASE("par::grain_size") {
+  CHECK(par::grain_size() == 1);
+  {
+    const par::GrainScope scope{64};
+    CHECK(par::grain_size() == 64);
+    {
+      const par::GrainScope nested_scope{16};
+      CHECK(par::grain_size() == 16);
+    }
+    CHECK(par::grain_size() == 64);
+
+    // Other threads are not affected.
+    size_t other_grain_size = 0;
+    std::thread{[&other_grain_size] {
+      other_grain_size = par::grain_size();
+    }}.join();
+    CHECK(other_grain_size == 1);
+  }
+  CHECK(par::grain_size() == 1);
+}
+
+TEST_CASE("par::pin_threads") {
+  // Pinning must be safe to enable repeatedly.
+  par::pin_threads();
+  par::pin_threads();
+  CHECK(par::num_threads() > 0);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
@@ -0,0 +1,91 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <atomic>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/par/first_touch.hpp"
+#include "tit/core/uint_utils.hpp"
+
+namespace tit::par {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+std::atomic<HugePages> huge_pages_{HugePages::none};
+
+} // namespace
+
+auto huge_pages() noexcept -> HugePages {
+  return huge_pages_.load(std::memory_order_relaxed);
+}
+
+void set_huge_pages(HugePages value) noexcept {
+  huge_pages_.store(value, std::memory_order_relaxed);
+}
+
+#ifdef __linux__
+
+namespace {
+
+// Mapping sizes are rounded up to the whole huge pages, since both the
+// explicit huge page mappings and their unmapping require it.
+constexpr auto mapping_size_(size_t size) noexcept -> size_t {
+  return align_up(size, FirstTouchAllocator<byte_t>::HugePageSize);
+}
+
+} // namespace
+
+auto impl::allocate_pages(size_t size) -> void* {
+  const auto mode = huge_pages();
+  const auto mapping_size = mapping_size_(size);
+  constexpr auto prot = PROT_READ | PROT_WRITE;
+  constexpr auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  if (mode == HugePages::hugetlb) {
+    void* const ptr =
+        mmap(nullptr, mapping_size, prot, flags | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) return ptr;
+  }
+  void* const ptr = mmap(nullptr, mapping_size, prot, flags, -1, 0);
+  if (ptr == MAP_FAILED) throw std::bad_alloc{};
+  if (mode != HugePages::none) {
+    // Advice is only a hint, regular pages are used if it is rejected.
+    madvise(ptr, mapping_size, MADV_HUGEPAGE);
+  }
+  return ptr;
+}
+
+void impl::deallocate_pages(void* ptr, size_t size) noexcept {
+  [[maybe_unused]] const auto status = munmap(ptr, mapping_size_(size));
+  TIT_ASSERT(status == 0, "Unable to unmap the memory block!");
+}
+
+#else
+
+auto impl::allocate_pages(size_t size) -> void* {
+  using Alloc = FirstTouchAllocator<byte_t>;
+  void* const ptr = ::operator new(size, std::align_val_t{Alloc::PageSize});
+  std::memset(ptr, 0, size);
+  return ptr;
+}
+
+void impl::deallocate_pages(void* ptr, size_t /*size*/) noexcept {
+  using Alloc = FirstTouchAllocator<byte_t>;
+  ::operator delete(ptr, std::align_val_t{Alloc::PageSize});
+}
+
+#endif
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::par
@@ -0,0 +1,166 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/partitioner.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/str_utils.hpp"
+
+namespace tit {
+namespace par {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Huge page backing of the large allocations.
+enum class HugePages : uint8_t {
+  none,        ///< Regular pages.
+  transparent, ///< Transparent huge pages, requested with `madvise`.
+  hugetlb,     ///< Explicit huge pages from the `hugetlbfs` pool.
+};
+
+/// Get the huge page backing of the large `FirstTouchAllocator` allocations.
+auto huge_pages() noexcept -> HugePages;
+
+/// Set the huge page backing of the large `FirstTouchAllocator` allocations.
+/// Affects only the following allocations. If the explicit huge page pool is
+/// exhausted, the transparent huge pages are used instead. Has no effect on
+/// the platforms other than Linux.
+void set_huge_pages(HugePages value) noexcept;
+
+namespace impl {
+
+// Allocate the zero-filled, page-aligned memory block, backed by the huge
+// pages according to `huge_pages()`.
+auto allocate_pages(size_t size) -> void*;
+
+// Deallocate the memory block, that was allocated by `allocate_pages`.
+void deallocate_pages(void* ptr, size_t size) noexcept;
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Allocator that places the memory pages near the threads that process them.
+///
+/// Large allocations are touched in parallel, with the elements split over
+/// the threads in the same way `static_for_each` splits them. With the
+/// first-touch placement policy of the operating system, each page is then
+/// backed by the memory of the NUMA node of the thread that owns it.
+///
+/// Allocations of at least one huge page are mapped directly, and may be
+/// backed by the huge pages, see `set_huge_pages`. Random neighbor access to
+/// the large arrays then causes much fewer TLB misses.
+template<class Val>
+  requires std::is_object_v<Val>
+class FirstTouchAllocator {
+public:
+
+  /// Allocated value type.
+  using value_type = Val;
+
+  /// Allocations smaller than this size (in bytes) are not touched.
+  static constexpr size_t TouchThreshold = size_t{1} << 20;
+
+  /// Assumed size of the memory page. Touching more often is harmless.
+  static constexpr size_t PageSize = 4096;
+
+  /// Assumed size of the huge memory page. Allocations of at least this size
+  /// (in bytes) are mapped directly.
+  static constexpr size_t HugePageSize = size_t{1} << 21;
+
+  /// Construct the allocator.
+  constexpr FirstTouchAllocator() noexcept = default;
+
+  /// Construct the allocator from an allocator of a different type.
+  template<class Other>
+  constexpr explicit(false) FirstTouchAllocator(
+      const FirstTouchAllocator<Other>& /*other*/) noexcept {}
+
+  /// Allocate the storage for @p count values and touch its pages.
+  [[nodiscard]] auto allocate(size_t count) -> Val* {
+    const auto size = count * sizeof(Val);
+    auto* const ptr = size >= HugePageSize ?
+                          static_cast<Val*>(impl::allocate_pages(size)) :
+                          std::allocator<Val>{}.allocate(count);
+    if (size >= TouchThreshold) touch_(ptr, count);
+    return ptr;
+  }
+
+  /// Deallocate the storage.
+  void deallocate(Val* ptr, size_t count) noexcept {
+    const auto size = count * sizeof(Val);
+    if (size >= HugePageSize) impl::deallocate_pages(ptr, size);
+    else std::allocator<Val>{}.deallocate(ptr, count);
+  }
+
+  /// Allocators are stateless, thus always equal.
+  template<class Other>
+  constexpr auto operator==(
+      const FirstTouchAllocator<Other>& /*other*/) const noexcept -> bool {
+    return true;
+  }
+
+private:
+
+  // Write a byte into each page of each thread's block of the values.
+  static void touch_(Val* ptr, size_t count) {
+    auto* const bytes = reinterpret_cast<volatile byte_t*>(ptr);
+    const auto thread_count = num_threads();
+    auto block_first = [quotient = count / thread_count,
+                        remainder = count % thread_count](size_t index) {
+      const auto offset = index * quotient + std::min(index, remainder);
+      return offset * sizeof(Val);
+    };
+    tbb::parallel_for<size_t>(
+        /*first=*/0,
+        /*last=*/thread_count,
+        /*step=*/1,
+        [bytes, &block_first](size_t thread_index) {
+          const auto last = block_first(thread_index + 1);
+          for (auto i = block_first(thread_index); i < last; i += PageSize) {
+            bytes[i] = byte_t{0};
+          }
+        },
+        tbb::static_partitioner{});
+  }
+
+}; // class FirstTouchAllocator
+
+/// Vector, whose storage is placed with `FirstTouchAllocator`.
+template<class Val>
+using FirstTouchVector = std::vector<Val, FirstTouchAllocator<Val>>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace par
+
+/// String to huge page backing converter.
+template<>
+struct StrTo<par::HugePages> final {
+  static constexpr auto operator()(std::string_view str) noexcept
+      -> std::optional<par::HugePages> {
+    if (str_nocase_equal(str, "none")) return par::HugePages::none;
+    if (str_nocase_equal(str, "transparent")) {
+      return par::HugePages::transparent;
+    }
+    if (str_nocase_equal(str, "hugetlb")) return par::HugePages::hugetlb;
+    return std::nullopt;
+  }
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
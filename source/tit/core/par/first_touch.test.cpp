@@ -0,0 +1,66 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/par/first_touch.hpp"
+#include "tit/core/str_utils.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::FirstTouchAllocator") {
+  par::set_num_threads(4);
+  SUBCASE("small") {
+    par::FirstTouchVector<int> vals(10, 1);
+    CHECK(std::ranges::all_of(vals, [](int val) { return val == 1; }));
+  }
+  SUBCASE("large") {
+    // Large enough to be touched in parallel, and not a multiple of the
+    // number of threads.
+    constexpr size_t count = (1 << 20) + 3;
+    par::FirstTouchVector<double> vals(count);
+    CHECK(std::ranges::all_of(vals, [](double val) { return val == 0.0; }));
+    vals.back() = 1.0;
+    CHECK(vals.back() == 1.0);
+  }
+  SUBCASE("huge pages") {
+    // Huge pages are only a hint, so the data must be intact in any mode.
+    for (const auto mode : {par::HugePages::transparent,
+                            par::HugePages::hugetlb,
+                            par::HugePages::none}) {
+      par::set_huge_pages(mode);
+      CHECK(par::huge_pages() == mode);
+      constexpr size_t count = (1 << 19) + 5;
+      par::FirstTouchVector<double> vals(count, 2.0);
+      CHECK(std::ranges::all_of(vals, [](double val) { return val == 2.0; }));
+      vals.resize(2 * count);
+      CHECK(vals.back() == 0.0);
+      CHECK(vals[count - 1] == 2.0);
+    }
+  }
+  SUBCASE("parse huge pages") {
+    CHECK(str_to<par::HugePages>("none") == par::HugePages::none);
+    CHECK(str_to<par::HugePages>("Transparent") ==
+          par::HugePages::transparent);
+    CHECK(str_to<par::HugePages>("hugetlb") == par::HugePages::hugetlb);
+    CHECK_FALSE(str_to<par::HugePages>("huge").has_value());
+  }
+  SUBCASE("equality") {
+    CHECK(par::FirstTouchAllocator<int>{} ==
+          par::FirstTouchAllocator<double>{});
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -7,14 +7,17 @@
 
 #include <concepts>
 #include <memory>
+#include <span>
 #include <type_traits>
 
 #ifndef TBB_PREVIEW_MEMORY_POOL
 #define TBB_PREVIEW_MEMORY_POOL 1
 #endif
 
+#include <oneapi/tbb/enumerable_thread_specific.h>
 #include <oneapi/tbb/memory_pool.h>
 
+#include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/exception.hpp"
 
@@ -23,27 +26,73 @@ namespace tit::par {
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Thread-safe and scalable memory pool (arena).
+///
+/// Single values are allocated from the per-thread caches, that are refilled
+/// from the pool in blocks of `CacheSize` values, so that the threads do not
+/// contend for the pool. All the values are freed at once by `reset`, which
+/// keeps the pool memory for the following allocations.
 template<class Val>
   requires std::is_object_v<Val> && std::is_trivially_destructible_v<Val>
 class MemoryPool final {
 public:
 
+  /// Number of the values that a thread takes from the pool at once.
+  static constexpr size_t CacheSize = 64;
+
   /// Allocate and initialize the new value from @p args.
   template<class... Args>
     requires std::constructible_from<Val, Args&&...>
   [[nodiscard]] auto create(Args&&... args) -> Val* {
-    TIT_ASSERT(pool_ != nullptr, "Memory pool was moved away!");
-    auto* const ptr = static_cast<Val*>(pool_->malloc(sizeof(Val)));
-    if (ptr == nullptr) {
-      TIT_THROW("Memory pool failed to allocate {} bytes.", sizeof(Val));
+    auto& cache = caches_.local();
+    if (cache.first == cache.last) {
+      cache.first = allocate_(CacheSize);
+      cache.last = cache.first + CacheSize;
     }
-    return std::construct_at(ptr, std::forward<Args>(args)...);
+    return std::construct_at(cache.first++, std::forward<Args>(args)...);
+  }
+
+  /// Allocate @p count contiguous values, each initialized from @p args.
+  template<class... Args>
+    requires std::constructible_from<Val, const Args&...>
+  [[nodiscard]] auto create_n(size_t count, const Args&... args)
+      -> std::span<Val> {
+    if (count == 0) return {};
+    auto* const ptr = allocate_(count);
+    for (size_t i = 0; i < count; ++i) std::construct_at(ptr + i, args...);
+    return {ptr, count};
+  }
+
+  /// Free all the values at once. The memory is kept in the pool and reused
+  /// by the following allocations. Must not be called concurrently with the
+  /// allocations.
+  void reset() {
+    TIT_ASSERT(pool_ != nullptr, "Memory pool was moved away!");
+    pool_->recycle();
+    for (auto& cache : caches_) cache = {};
   }
 
 private:
 
+  // Values that the thread has taken from the pool, but not used yet.
+  struct Cache_ {
+    Val* first = nullptr;
+    Val* last = nullptr;
+  }; // struct Cache_
+
+  // Allocate the uninitialized storage for @p count values.
+  auto allocate_(size_t count) -> Val* {
+    TIT_ASSERT(pool_ != nullptr, "Memory pool was moved away!");
+    const auto size = count * sizeof(Val);
+    auto* const ptr = static_cast<Val*>(pool_->malloc(size));
+    if (ptr == nullptr) {
+      TIT_THROW("Memory pool failed to allocate {} bytes.", size);
+    }
+    return ptr;
+  }
+
   std::unique_ptr<tbb::memory_pool<std::allocator<Val>>> pool_ =
       std::make_unique<typename decltype(pool_)::element_type>();
+  tbb::enumerable_thread_specific<Cache_> caches_;
 
 }; // class MemoryPool
 
@@ -22,9 +22,32 @@ TEST_CASE("par::MemoryPool") {
     int data_2;
   };
   par::MemoryPool<Struct> pool{};
-  auto* const root = pool.create(10, 20);
-  CHECK(root->data_1 == 10);
-  CHECK(root->data_2 == 20);
+  SUBCASE("create") {
+    auto* const root = pool.create(10, 20);
+    CHECK(root->data_1 == 10);
+    CHECK(root->data_2 == 20);
+    // Allocate more values than a single cache holds.
+    constexpr auto count = 2 * par::MemoryPool<Struct>::CacheSize;
+    for (int i = 0; i < static_cast<int>(count); ++i) {
+      auto* const node = pool.create(i, i);
+      CHECK(node != root);
+      CHECK(node->data_1 == i);
+    }
+  }
+  SUBCASE("create_n") {
+    const auto nodes = pool.create_n(100, 1, 2);
+    CHECK(nodes.size() == 100);
+    CHECK(nodes.front().data_1 == 1);
+    CHECK(nodes.back().data_2 == 2);
+    CHECK(pool.create_n(0, 1, 2).empty());
+  }
+  SUBCASE("reset") {
+    for (int i = 0; i < 1000; ++i) CHECK(pool.create(i, i) != nullptr);
+    pool.reset();
+    auto* const node = pool.create(30, 40);
+    CHECK(node->data_1 == 30);
+    CHECK(node->data_2 == 40);
+  }
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,47 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <memory>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/par/scratch_arena.hpp"
+
+namespace tit::par {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void ScratchArena::reset() {
+  offset_ = 0;
+  if (chunks_.size() <= 1) return;
+  const auto size = capacity();
+  chunks_.clear();
+  chunks_.emplace_back(size);
+}
+
+auto ScratchArena::capacity() const noexcept -> size_t {
+  size_t size = 0;
+  for (const auto& chunk : chunks_) size += chunk.size();
+  return size;
+}
+
+auto ScratchArena::allocate_chunk_(size_t size, size_t align) -> void* {
+  // Grow the arena at least twice, so that the number of chunks stays
+  // logarithmic in the working size.
+  auto& chunk = chunks_.emplace_back(
+      std::max({MinChunkSize, size + align, 2 * capacity()}));
+  void* ptr = chunk.data();
+  auto space = chunk.size();
+  [[maybe_unused]] const auto* const aligned =
+      std::align(align, size, ptr, space);
+  TIT_ASSERT(aligned != nullptr, "Chunk is too small for the block!");
+  offset_ = chunk.size() - space + size;
+  return ptr;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::par
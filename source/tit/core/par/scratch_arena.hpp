@@ -0,0 +1,162 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <oneapi/tbb/enumerable_thread_specific.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+
+namespace tit::par {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Bump arena for the transient scratch memory.
+///
+/// Memory is allocated by advancing the offset within the current chunk, and
+/// is released all at once by `reset`. Chunks are kept between the resets, so
+/// once the arena has grown to its working size, no more memory is requested
+/// from the system.
+class ScratchArena final {
+public:
+
+  /// Minimal size of the memory chunk, in bytes.
+  static constexpr size_t MinChunkSize = size_t{1} << 16;
+
+  /// Allocate the memory block of @p size bytes, aligned by @p align.
+  [[nodiscard]] auto allocate(size_t size, size_t align) -> void* {
+    if (!chunks_.empty()) {
+      auto& chunk = chunks_.back();
+      void* ptr = chunk.data() + offset_;
+      auto space = chunk.size() - offset_;
+      if (std::align(align, size, ptr, space) != nullptr) {
+        offset_ = chunk.size() - space + size;
+        return ptr;
+      }
+    }
+    return allocate_chunk_(size, align);
+  }
+
+  /// Release all the allocated memory blocks at once.
+  ///
+  /// If the arena has grown by more than one chunk, the chunks are merged into
+  /// a single one, so that the following allocations fit into it.
+  void reset();
+
+  /// Total size of the chunks, in bytes.
+  auto capacity() const noexcept -> size_t;
+
+private:
+
+  // Allocate the block from a new chunk.
+  auto allocate_chunk_(size_t size, size_t align) -> void*;
+
+  std::vector<std::vector<byte_t>> chunks_;
+  size_t offset_ = 0;
+
+}; // class ScratchArena
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Scratch arenas of the threads.
+///
+/// Each thread allocates from its own arena, without any synchronization.
+/// Arenas are reset together by their owner, once none of the memory that was
+/// allocated from them is used anymore.
+class ScratchArenas final {
+public:
+
+  /// Arena of the current thread.
+  auto local() -> ScratchArena& {
+    return arenas_.local();
+  }
+
+  /// Reset the arenas of all the threads. Must not be called concurrently
+  /// with the allocations.
+  void reset() {
+    for (auto& arena : arenas_) arena.reset();
+  }
+
+  /// Total size of the chunks of all the threads, in bytes.
+  auto heap_bytes() const -> size_t {
+    size_t result = 0;
+    for (const auto& arena : arenas_) result += arena.capacity();
+    return result;
+  }
+
+private:
+
+  tbb::enumerable_thread_specific<ScratchArena> arenas_;
+
+}; // class ScratchArenas
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Allocator that allocates from the arena of the current thread.
+///
+/// Deallocation does nothing, memory is released when the arenas are reset.
+/// Memory that was allocated by one thread may be used and deallocated by
+/// the others.
+template<class Val>
+  requires std::is_object_v<Val>
+class ScratchAllocator {
+public:
+
+  /// Allocated value type.
+  using value_type = Val;
+
+  /// Allocator is moved along with the container contents.
+  using propagate_on_container_move_assignment = std::true_type;
+
+  /// Construct the allocator that allocates from the @p arenas.
+  constexpr explicit ScratchAllocator(ScratchArenas& arenas) noexcept
+      : arenas_{&arenas} {}
+
+  /// Construct the allocator from an allocator of a different type.
+  template<class Other>
+  constexpr explicit(false)
+      ScratchAllocator(const ScratchAllocator<Other>& other) noexcept
+      : arenas_{&other.arenas()} {}
+
+  /// Arenas the memory is allocated from.
+  constexpr auto arenas() const noexcept -> ScratchArenas& {
+    return *arenas_;
+  }
+
+  /// Allocate the storage for @p count values.
+  [[nodiscard]] auto allocate(size_t count) -> Val* {
+    TIT_ASSERT(arenas_ != nullptr, "Allocator has no arenas!");
+    return static_cast<Val*>(
+        arenas_->local().allocate(count * sizeof(Val), alignof(Val)));
+  }
+
+  /// Deallocate the storage (does nothing).
+  void deallocate(Val* /*ptr*/, size_t /*count*/) noexcept {}
+
+  /// Allocators are equal if they allocate from the same arenas.
+  template<class Other>
+  constexpr auto operator==(const ScratchAllocator<Other>& other) const noexcept
+      -> bool {
+    return arenas_ == &other.arenas();
+  }
+
+private:
+
+  ScratchArenas* arenas_;
+
+}; // class ScratchAllocator
+
+/// Vector, whose storage is allocated from the scratch arenas.
+template<class Val>
+using ScratchVector = std::vector<Val, ScratchAllocator<Val>>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::par
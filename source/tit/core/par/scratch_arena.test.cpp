@@ -0,0 +1,69 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <bit>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/scratch_arena.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::ScratchArena") {
+  par::ScratchArena arena;
+  SUBCASE("alignment") {
+    auto* const a = arena.allocate(1, 1);
+    auto* const b = arena.allocate(8, 64);
+    CHECK(a != b);
+    CHECK(std::bit_cast<size_t>(b) % 64 == 0);
+  }
+  SUBCASE("growth and reset") {
+    // Allocate more than fits into a single chunk.
+    constexpr auto size = par::ScratchArena::MinChunkSize / 2 + 1;
+    for (size_t i = 0; i < 4; ++i) {
+      CHECK(arena.allocate(size, alignof(double)) != nullptr);
+    }
+    const auto capacity = arena.capacity();
+    CHECK(capacity >= 4 * size);
+    // After the reset, the same allocations must fit into the same memory.
+    arena.reset();
+    CHECK(arena.capacity() == capacity);
+    for (size_t i = 0; i < 4; ++i) {
+      CHECK(arena.allocate(size, alignof(double)) != nullptr);
+    }
+    CHECK(arena.capacity() == capacity);
+  }
+}
+
+TEST_CASE("par::ScratchAllocator") {
+  par::ScratchArenas arenas;
+  const par::ScratchAllocator<int> alloc{arenas};
+  SUBCASE("vector") {
+    {
+      par::ScratchVector<int> vals(alloc);
+      for (int i = 0; i < 1000; ++i) vals.push_back(i);
+      for (int i = 0; i < 1000; ++i) CHECK(vals[i] == i);
+    }
+    const auto capacity = arenas.local().capacity();
+    arenas.reset();
+    par::ScratchVector<int> other(1000, 1, alloc);
+    CHECK(other.back() == 1);
+    CHECK(arenas.local().capacity() == capacity);
+  }
+  SUBCASE("equality") {
+    par::ScratchArenas other_arenas;
+    CHECK(alloc == par::ScratchAllocator<double>{alloc});
+    CHECK_FALSE(alloc == par::ScratchAllocator<int>{other_arenas});
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
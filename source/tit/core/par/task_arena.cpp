@@ -0,0 +1,89 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <oneapi/tbb/task_arena.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/par/task_arena.hpp"
+
+namespace tit::par {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TaskArena::TaskArena(size_t num_threads)
+    : arena_{
+          std::make_unique<tbb::task_arena>(static_cast<int>(num_threads))} {
+  TIT_ASSERT(num_threads > 0, "Invalid number of the arena threads!");
+}
+
+auto TaskArena::num_threads() const noexcept -> size_t {
+  TIT_ASSERT(arena_ != nullptr, "Task arena was moved away!");
+  return static_cast<size_t>(arena_->max_concurrency());
+}
+
+void TaskArena::execute(const std::function<void()>& func) {
+  TIT_ASSERT(arena_ != nullptr, "Task arena was moved away!");
+  TIT_ASSERT(func, "Function must be specified!");
+  arena_->execute(func);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void run_isolated(size_t num_jobs,
+                  size_t threads_per_job,
+                  const std::function<void(size_t)>& job) {
+  TIT_ASSERT(threads_per_job > 0, "Invalid number of the threads per job!");
+  TIT_ASSERT(job, "Job function must be specified!");
+  if (num_jobs == 0) return;
+
+  // Each slot is driven by its own thread, that takes the next job and runs
+  // it within the slot arena. Arena workers are taken from the shared pool,
+  // so the total number of the threads stays within the global limit.
+  const auto num_slots =
+      std::clamp(num_threads() / threads_per_job, size_t{1}, num_jobs);
+  std::atomic<size_t> next_job{0};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  {
+    std::vector<std::jthread> slots;
+    slots.reserve(num_slots);
+    for (size_t slot = 0; slot < num_slots; ++slot) {
+      slots.emplace_back([threads_per_job,
+                          num_jobs,
+                          &job,
+                          &next_job,
+                          &error_mutex,
+                          &error] {
+        TaskArena arena{threads_per_job};
+        while (true) {
+          const auto index = next_job.fetch_add(1, std::memory_order_relaxed);
+          if (index >= num_jobs) break;
+          try {
+            arena.execute([&job, index] { job(index); });
+          } catch (...) {
+            const std::scoped_lock lock{error_mutex};
+            if (!error) error = std::current_exception();
+          }
+        }
+      });
+    }
+  }
+  if (error) std::rethrow_exception(error);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::par
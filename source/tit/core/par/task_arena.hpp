@@ -0,0 +1,65 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include <oneapi/tbb/task_arena.h>
+
+#include "tit/core/basic_types.hpp"
+
+namespace tit::par {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Isolated task arena with its own thread budget.
+///
+/// Parallel algorithms, that are called within the arena, use at most its
+/// threads, and never pick up the tasks of the other arenas. Within the
+/// function passed to `execute`, `par::num_threads()` reports the number of
+/// the arena threads.
+class TaskArena final {
+public:
+
+  /// Construct the task arena with @p num_threads threads, including the
+  /// calling one.
+  explicit TaskArena(size_t num_threads);
+
+  /// Number of the arena threads.
+  auto num_threads() const noexcept -> size_t;
+
+  /// Call the function within the arena, and wait for it to finish.
+  void execute(const std::function<void()>& func);
+
+private:
+
+  std::unique_ptr<tbb::task_arena> arena_;
+
+}; // class TaskArena
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Run the independent jobs concurrently, each within its own task arena.
+///
+/// Jobs are handed out to `num_threads() / threads_per_job` slots, at least
+/// one, and each slot runs the jobs one after another within its arena of
+/// @p threads_per_job threads. This is meant for the ensembles of the small
+/// simulations, that do not scale to the whole machine on their own. Jobs
+/// must not share any mutable state, other than the explicitly synchronized
+/// one. If some of the jobs throw, the remaining jobs are still run, and the
+/// first exception is rethrown after all of them are finished.
+///
+/// @param num_jobs        Number of the jobs.
+/// @param threads_per_job Number of the threads available to each job.
+/// @param job             Job function, that is called with the job index.
+void run_isolated(size_t num_jobs,
+                  size_t threads_per_job,
+                  const std::function<void(size_t)>& job);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::par
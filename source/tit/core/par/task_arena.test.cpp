@@ -0,0 +1,86 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <atomic>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/par/task_arena.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("par::TaskArena") {
+  par::set_num_threads(4);
+  par::TaskArena arena{2};
+  CHECK(arena.num_threads() == 2);
+  size_t arena_num_threads = 0;
+  arena.execute(
+      [&arena_num_threads] { arena_num_threads = par::num_threads(); });
+  CHECK(arena_num_threads == 2);
+  CHECK(par::num_threads() == 4);
+
+  // Worker threads of the arena report the arena threads as well.
+  std::atomic<bool> workers_match{true};
+  arena.execute([&workers_match] {
+    par::for_each(std::views::iota(size_t{0}, size_t{1000}),
+                  [&workers_match](size_t /*i*/) {
+                    if (par::num_threads() != 2) workers_match = false;
+                  });
+  });
+  CHECK(workers_match);
+}
+
+TEST_CASE("par::run_isolated") {
+  par::set_num_threads(4);
+  SUBCASE("basic") {
+    // Ensure each job runs once, with its own thread budget.
+    std::vector<size_t> sums(8, 0);
+    std::atomic<size_t> max_num_threads{0};
+    par::run_isolated(sums.size(), 2, [&sums, &max_num_threads](size_t job) {
+      max_num_threads.store(
+          std::max(max_num_threads.load(), par::num_threads()));
+      const auto values = std::views::iota(size_t{0}, 100 * (job + 1));
+      std::atomic<size_t> sum{0};
+      par::for_each(values, [&sum](size_t i) { sum += i; });
+      sums[job] = sum;
+    });
+    for (size_t job = 0; job < sums.size(); ++job) {
+      const auto n = 100 * (job + 1);
+      CHECK(sums[job] == n * (n - 1) / 2);
+    }
+    CHECK(max_num_threads.load() <= 2);
+  }
+  SUBCASE("exceptions") {
+    // Ensure the remaining jobs run, and the exception is rethrown.
+    std::atomic<size_t> num_finished{0};
+    CHECK_THROWS_WITH_AS(par::run_isolated(6,
+                                           1,
+                                           [&num_finished](size_t job) {
+                                             if (job == 2) {
+                                               throw std::runtime_error{
+                                                   "Job failed!"};
+                                             }
+                                             ++num_finished;
+                                           }),
+                         "Job failed!",
+                         std::runtime_error);
+    CHECK(num_finished.load() == 5);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -4,16 +4,27 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <algorithm>
+#include <chrono>
+#include <format>
 #include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/io.hpp"
+#include "tit/core/log.hpp"
 #include "tit/core/profiler.hpp"
 #include "tit/core/str_utils.hpp"
+#include "tit/core/sys/perf_counters.hpp"
 #include "tit/core/sys/utils.hpp"
 #include "tit/core/time.hpp"
 
@@ -21,71 +32,390 @@ namespace tit {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-StrHashMap<Stopwatch> Profiler::sections_{};
+namespace {
 
-auto Profiler::section(std::string_view section_name) -> Stopwatch& {
+// Should the time stamp counter be used instead of the steady clock?
+bool use_tsc_clock = false;
+
+// Time since the first reading of the clock (in nanoseconds).
+template<class Clock>
+auto clock_ns() noexcept -> uint64_t {
+  static const auto origin = Clock::now();
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                           origin)
+          .count());
+}
+
+// Time since the profiling was enabled (in nanoseconds).
+auto now_ns() noexcept -> uint64_t {
+  if (use_tsc_clock) return clock_ns<TscClock>();
+  return clock_ns<std::chrono::steady_clock>();
+}
+
+// Node of the section call tree.
+struct CallNode final {
+  const ProfilerSection* section = nullptr;
+  uint64_t total_ns = 0;
+  size_t calls = 0;
+  PerfCounterValues counters;
+  size_t last_child = npos; // Most recently entered child node.
+  std::vector<size_t> children;
+};
+
+// Section entry, recorded for the trace.
+struct TraceEvent final {
+  const ProfilerSection* section;
+  uint64_t start_ns;
+  uint64_t duration_ns;
+};
+
+// Section, that is currently entered. Counters are missing if they were not
+// read on entry.
+struct StackEntry final {
+  size_t node_index;
+  uint64_t start_ns;
+  std::optional<PerfCounterValues> start_counters;
+};
+
+// Profiling data of a single thread. Aligned to the cache line, so that
+// the threads never write to the same cache lines while profiling.
+struct alignas(64) ThreadProfile final {
+  size_t thread_id;
+  std::vector<CallNode> nodes = std::vector<CallNode>(1); // Root node.
+  std::vector<StackEntry> stack;
+  std::vector<TraceEvent> events;
+  std::unique_ptr<PerfCounterGroup> counters; // Null if counters are off.
+};
+
+// Profiling data of all the threads, that have ever entered a section.
+std::mutex thread_profiles_mutex{};
+std::vector<std::unique_ptr<ThreadProfile>> thread_profiles{};
+
+// Profiling data of the current thread. Plain thread-local pointer is used
+// instead of the function-local thread-local object, so that the access
+// requires no initialization guard checks.
+constinit thread_local ThreadProfile* this_thread_profile_ptr = nullptr;
+
+// Profiling data of the current thread, registered on the first access.
+// Performance counters are opened for the thread during the registration.
+auto this_thread_profile(bool with_counters) -> ThreadProfile& {
+  if (this_thread_profile_ptr == nullptr) [[unlikely]] {
+    const std::scoped_lock lock{thread_profiles_mutex};
+    const auto thread_id = thread_profiles.size();
+    thread_profiles.push_back(
+        std::make_unique<ThreadProfile>(ThreadProfile{.thread_id = thread_id}));
+    this_thread_profile_ptr = thread_profiles.back().get();
+    if (with_counters) {
+      auto counters = std::make_unique<PerfCounterGroup>();
+      if (counters->active()) {
+        this_thread_profile_ptr->counters = std::move(counters);
+      } else if (static bool warned = false; !std::exchange(warned, true)) {
+        TIT_WARN("Hardware performance counters are not available.");
+      }
+    }
+  }
+  return *this_thread_profile_ptr;
+}
+
+// Node of the call tree, merged over all the threads.
+struct MergedNode final {
+  const ProfilerSection* section = nullptr;
+  uint64_t total_ns = 0;
+  size_t calls = 0;
+  PerfCounterValues counters;
+  std::vector<MergedNode> children;
+};
+
+// Merge the thread call subtree into the merged call tree. Time spent so far
+// in the currently entered sections is passed separately.
+void merge_subtree(const ThreadProfile& profile,
+                   std::span<const uint64_t> open_ns,
+                   size_t node_index,
+                   MergedNode& merged) {
+  const auto& node = profile.nodes[node_index];
+  merged.total_ns += node.total_ns + open_ns[node_index];
+  merged.calls += node.calls;
+  merged.counters += node.counters;
+  for (const auto child_index : node.children) {
+    const auto* const section = profile.nodes[child_index].section;
+    auto iter = std::ranges::find(merged.children,
+                                  section,
+                                  &MergedNode::section);
+    if (iter == merged.children.end()) {
+      iter = merged.children.insert(merged.children.end(),
+                                    MergedNode{.section = section});
+    }
+    merge_subtree(profile, open_ns, child_index, *iter);
+  }
+}
+
+// Escape the string for JSON.
+auto json_escape(std::string_view str) -> std::string {
+  std::string result;
+  result.reserve(str.size());
+  for (const auto c : str) {
+    if (c == '"' || c == '\\') result.push_back('\\');
+    result.push_back(c);
+  }
+  return result;
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+std::atomic<bool> Profiler::enabled_ = false;
+bool Profiler::counters_enabled_ = false;
+std::string Profiler::trace_path_{};
+std::mutex Profiler::sections_mutex_{};
+StrHashMap<ProfilerSection> Profiler::sections_{};
+
+auto Profiler::section(std::string_view section_name)
+    -> const ProfilerSection& {
   TIT_ASSERT(!section_name.empty(), "Section name must not be empty!");
+  const std::scoped_lock lock{sections_mutex_};
   /// @todo In C++26 there would be no need for `std::string{...}`.
-  return sections_[std::string{section_name}];
+  const auto [iter, _] =
+      sections_.try_emplace(std::string{section_name},
+                            std::string{section_name});
+  return iter->second;
 }
 
 void Profiler::enable() noexcept {
   // Start profiling.
-  constexpr const auto* root_section_name = "main";
-  section(root_section_name).start();
+  if (enabled_.exchange(true)) return;
+  static const auto& root_section = section("main");
+  enter(root_section);
 
   // Stop profiling and report at exit.
   checked_atexit([] {
-    section(root_section_name).stop();
-    report_();
+    leave();
+    enabled_.store(false);
+    report();
+    if (!trace_path_.empty()) write_trace_();
   });
 }
 
-void Profiler::report_() {
-  // Gather the sections and sort them by total time.
-  auto sorted_sections =
-      sections_ |
-      std::views::transform([](auto& section) { return &section; }) |
-      std::ranges::to<std::vector>();
-  std::ranges::sort(sorted_sections, std::greater{}, [](const auto* s) {
-    return s->second.total_ns();
-  });
+void Profiler::enable_trace(std::string_view trace_path) {
+  TIT_ASSERT(!trace_path.empty(), "Trace path must not be empty!");
+  trace_path_ = trace_path;
+}
+
+void Profiler::enable_counters() noexcept {
+  counters_enabled_ = true;
+}
+
+void Profiler::enable_tsc_clock() {
+  if (!TscClock::available()) {
+    TIT_WARN("Invariant time stamp counter is not available, "
+             "profiler falls back to the steady clock.");
+    return;
+  }
+  use_tsc_clock = true;
+}
+
+void Profiler::enter(const ProfilerSection& section) {
+  auto& profile = this_thread_profile(counters_enabled_);
+
+  // Find the child node of the current node, or create a new one. Most of
+  // the time the same child is entered repeatedly, so it is checked first.
+  const auto parent_index =
+      profile.stack.empty() ? 0 : profile.stack.back().node_index;
+  auto node_index = profile.nodes[parent_index].last_child;
+  if (node_index == npos || profile.nodes[node_index].section != &section) {
+    const auto& siblings = profile.nodes[parent_index].children;
+    const auto iter =
+        std::ranges::find(siblings, &section, [&profile](size_t index) {
+          return profile.nodes[index].section;
+        });
+    if (iter != siblings.end()) {
+      node_index = *iter;
+    } else {
+      node_index = profile.nodes.size();
+      profile.nodes.push_back({.section = &section});
+      profile.nodes[parent_index].children.push_back(node_index);
+    }
+    profile.nodes[parent_index].last_child = node_index;
+  }
+
+  // Start the section. Counters are read last, so that the bookkeeping above
+  // is not attributed to the section.
+  profile.stack.push_back({.node_index = node_index, .start_ns = now_ns()});
+  if (profile.counters) {
+    profile.stack.back().start_counters = profile.counters->read();
+  }
+}
+
+void Profiler::leave() noexcept {
+  TIT_ASSERT(this_thread_profile_ptr != nullptr, "No section was entered!");
+  auto& profile = *this_thread_profile_ptr;
+  const auto stop_counters = profile.counters ?
+                                  profile.counters->read() :
+                                  std::optional<PerfCounterValues>{};
+  const auto stop_ns = now_ns();
+  TIT_ASSERT(!profile.stack.empty(), "No section was entered!");
+  const auto [node_index, start_ns, start_counters] = profile.stack.back();
+  profile.stack.pop_back();
+
+  // Update the section statistics.
+  auto& node = profile.nodes[node_index];
+  const auto duration_ns = stop_ns - start_ns;
+  node.total_ns += duration_ns;
+  node.calls += 1;
+  if (start_counters.has_value() && stop_counters.has_value()) {
+    node.counters += *stop_counters - *start_counters;
+  }
+
+  // Record the trace event.
+  if (!trace_path_.empty()) {
+    try {
+      profile.events.push_back({.section = node.section,
+                                .start_ns = start_ns,
+                                .duration_ns = duration_ns});
+    } catch (...) { // NOLINT(*-empty-catch)
+      // Event is dropped if there is no memory left to store it.
+    }
+  }
+}
+
+void Profiler::report() {
+  // Merge the call trees of all the threads.
+  MergedNode root{};
+  {
+    const std::scoped_lock lock{thread_profiles_mutex};
+    const auto stop_ns = now_ns();
+    std::vector<uint64_t> open_ns;
+    for (const auto& profile : thread_profiles) {
+      open_ns.assign(profile->nodes.size(), 0);
+      for (const auto& entry : profile->stack) {
+        open_ns[entry.node_index] += stop_ns - entry.start_ns;
+      }
+      if (profile->thread_id == 0) {
+        merge_subtree(*profile, open_ns, 0, root);
+        continue;
+      }
+
+      // Section that spawned the work of a worker thread is not known, so
+      // its sections are reported under the thread node, instead of being
+      // the siblings of the sections of the first thread.
+      if (profile->nodes.front().children.empty()) continue;
+      auto& thread_node = root.children.emplace_back(MergedNode{
+          .section = &section(std::format("worker {}", profile->thread_id)),
+      });
+      merge_subtree(*profile, open_ns, 0, thread_node);
+      for (const auto& child : thread_node.children) {
+        thread_node.total_ns += child.total_ns;
+      }
+      thread_node.calls = 1;
+    }
+  }
+  if (root.children.empty()) return;
 
   // Print the report table.
   const auto width = tty_width(TTY::Stdout).value_or(80);
   constexpr std::string_view abs_time_title = "abs. time [s]";
   constexpr std::string_view rel_time_title = "rel. time [%]";
   constexpr std::string_view num_calls_title = "calls [#]";
+  constexpr std::string_view ipc_title = "IPC";
+  constexpr std::string_view mpki_title = "LLC MPKI";
+  constexpr std::string_view bandwidth_title = "BW [GB/s]";
   constexpr std::string_view section_title = "section name";
   println();
   println("Profiling report:");
   println();
   println("{:->{}}", "", width);
-  println("{}    {}    {}    {}",
+  println("{}    {}    {}    {}{}",
           abs_time_title,
           rel_time_title,
           num_calls_title,
+          counters_enabled_ ? std::format("{:>7}    {}    {}    ",
+                                          ipc_title,
+                                          mpki_title,
+                                          bandwidth_title) :
+                              std::string{},
           section_title);
   println("{:->{}}", "", width);
-  const auto root_absolute_time = sorted_sections.front()->second.total();
-  for (const auto* section : sorted_sections) {
-    const auto& [section_name, stopwatch] = *section;
-    const auto abs_time = stopwatch.total();
-    const auto rel_time = 100.0 * abs_time / root_absolute_time;
-    const auto num_calls = stopwatch.cycles();
-    println("{:>{}.5f}    {:>{}.5f}    {:>{}}    {}",
-            abs_time,
-            abs_time_title.size(),
-            rel_time,
-            rel_time_title.size(),
-            num_calls,
-            num_calls_title.size(),
-            section_name);
-  }
+  const auto root_total_ns =
+      std::ranges::max_element(root.children, {}, &MergedNode::total_ns)
+          ->total_ns;
+  const auto format_counters = [&mpki_title,
+                                &bandwidth_title](const MergedNode& node) {
+    const auto ratio = [](uint64_t num, uint64_t den) -> real_t {
+      return den == 0 ? 0.0 :
+                        static_cast<real_t>(num) / static_cast<real_t>(den);
+    };
+    constexpr uint64_t cache_line_size = 64; // Bytes per cache miss.
+    const auto& counters = node.counters;
+    return std::format("{:>7.3f}    {:>{}.3f}    {:>{}.3f}    ",
+                       ratio(counters[PerfCounter::instructions],
+                             counters[PerfCounter::cycles]),
+                       1000.0 * ratio(counters[PerfCounter::cache_misses],
+                                      counters[PerfCounter::instructions]),
+                       mpki_title.size(),
+                       ratio(cache_line_size *
+                                 counters[PerfCounter::cache_misses],
+                             node.total_ns),
+                       bandwidth_title.size());
+  };
+  const auto print_subtree = [&abs_time_title,
+                              &rel_time_title,
+                              &num_calls_title,
+                              &format_counters,
+                              root_total_ns](this const auto& self,
+                                             MergedNode& node,
+                                             size_t depth) -> void {
+    std::ranges::sort(node.children, std::greater{}, &MergedNode::total_ns);
+    for (auto& child : node.children) {
+      const auto abs_time = 1.0e-9 * static_cast<real_t>(child.total_ns);
+      const auto rel_time = 100.0 * static_cast<real_t>(child.total_ns) /
+                            static_cast<real_t>(root_total_ns);
+      println("{:>{}.5f}    {:>{}.5f}    {:>{}}    {}{}{}",
+              abs_time,
+              abs_time_title.size(),
+              rel_time,
+              rel_time_title.size(),
+              child.calls,
+              num_calls_title.size(),
+              counters_enabled_ ? format_counters(child) : std::string{},
+              std::string(2 * depth, ' '),
+              child.section->name());
+      self(child, depth + 1);
+    }
+  };
+  print_subtree(root, 0);
   println("{:->{}}", "", width);
   println();
 }
 
+void Profiler::write_trace_() {
+  const auto file = open_file(trace_path_, "w");
+  print(file.get(), "{{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  bool is_first = true;
+  const std::scoped_lock lock{thread_profiles_mutex};
+  for (const auto& profile : thread_profiles) {
+    print(file.get(),
+          "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},"
+          "\"args\":{{\"name\":\"{}\"}}}}",
+          is_first ? "" : ",",
+          profile->thread_id,
+          profile->thread_id == 0 ? "main" :
+                                    std::format("worker {}",
+                                                profile->thread_id));
+    is_first = false;
+    for (const auto& event : profile->events) {
+      print(file.get(),
+            ",{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,\"tid\":{},"
+            "\"ts\":{:.3f},\"dur\":{:.3f}}}",
+            json_escape(event.section->name()),
+            profile->thread_id,
+            1.0e-3 * static_cast<real_t>(event.start_ns),
+            1.0e-3 * static_cast<real_t>(event.duration_ns));
+    }
+  }
+  println(file.get(), "]}}");
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit
@@ -5,43 +5,155 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+#include <string>
 #include <string_view>
+#include <utility>
 
 #include "tit/core/str_utils.hpp"
-#include "tit/core/time.hpp"
 #include "tit/core/utils.hpp"
 
 namespace tit {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Profiled section.
+class ProfilerSection final {
+public:
+
+  /// Construct a section with the given name.
+  explicit ProfilerSection(std::string name) : name_{std::move(name)} {}
+
+  /// Section name.
+  auto name() const noexcept -> std::string_view {
+    return name_;
+  }
+
+private:
+
+  std::string name_;
+
+}; // class ProfilerSection
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Profiler interface.
+///
+/// Each thread records the sections it enters into its own call tree, so
+/// nested sections are accounted separately, and the work done inside of the
+/// parallel tasks is attributed to the worker threads that executed it. At
+/// exit, the call trees of all the threads are merged into a hierarchical
+/// report. Sections of the worker threads, that were not entered from another
+/// section of the same thread, are reported separately for each thread, since
+/// the section that spawned the work is not known. Optionally, every section
+/// entry is also recorded as a trace event, and the trace is written in the
+/// Chrome trace event format, that could be opened with Perfetto UI or
+/// `chrome://tracing`. Hardware performance
+/// counters could also be sampled on each section entry and exit, so that
+/// the report shows how efficiently each of the sections uses the CPU.
 class Profiler final {
 public:
 
   /// Profiler is a static object.
   Profiler() = delete;
 
-  /// Stopwatch associated with a section.
-  static auto section(std::string_view section_name) -> Stopwatch&;
+  /// Section with the given name.
+  ///
+  /// Lookup is synchronized, so it is intended to be done once per call site,
+  /// as `TIT_PROFILE_SECTION` does. Entering and leaving the sections only
+  /// touches the data of the current thread, and requires no locking.
+  static auto section(std::string_view section_name) -> const ProfilerSection&;
+
+  /// Is profiling enabled?
+  static auto enabled() noexcept -> bool {
+    return enabled_.load(std::memory_order_relaxed);
+  }
 
-  /// Enable profiling. Report will be printed at exit.
+  /// Enable profiling. Report will be printed at exit. Enabling profiling
+  /// more than once has no effect.
   static void enable() noexcept;
 
+  /// Record the trace events and write them to the file at exit.
+  ///
+  /// Trace is only recorded while profiling is enabled, `TIT_PROFILER_TRACE`
+  /// enables both.
+  ///
+  /// @note Trace events are kept in memory until exit, so tracing is intended
+  ///       for the relatively short runs.
+  static void enable_trace(std::string_view trace_path);
+
+  /// Sample the hardware performance counters on each section entry and exit,
+  /// and report the instructions per cycle, the last level cache misses per
+  /// thousand instructions, and the estimated memory bandwidth.
+  ///
+  /// @note Memory bandwidth is estimated from the last level cache misses,
+  ///       assuming that each miss transfers a single 64-byte cache line.
+  static void enable_counters() noexcept;
+
+  /// Measure the sections with the time stamp counter, see `TscClock`, so
+  /// that much finer sections could be profiled. Must be called before the
+  /// profiling is enabled.
+  static void enable_tsc_clock();
+
+  /// Print the report of the sections so far, without stopping profiling.
+  ///
+  /// Sections, that are currently entered by the calling thread, are
+  /// accounted up to now. Other threads must not be inside of the sections
+  /// while the report is printed, so it is intended to be called between
+  /// the parallel regions.
+  static void report();
+
+  /// Enter the section on the current thread.
+  static void enter(const ProfilerSection& section);
+
+  /// Leave the most recently entered section on the current thread.
+  static void leave() noexcept;
+
 private:
 
-  static void report_();
+  static void write_trace_();
 
-  static StrHashMap<Stopwatch> sections_;
+  static std::atomic<bool> enabled_;
+  static bool counters_enabled_;
+  static std::string trace_path_;
+  static std::mutex sections_mutex_;
+  static StrHashMap<ProfilerSection> sections_;
 
 }; // class Profiler
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Scoped profiler section.
+class ProfilerScope final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(ProfilerScope);
+
+  /// Enter the section, if profiling is enabled.
+  explicit ProfilerScope(const ProfilerSection& section)
+      : active_{Profiler::enabled()} {
+    if (active_) Profiler::enter(section);
+  }
+
+  /// Leave the section.
+  ~ProfilerScope() noexcept {
+    if (active_) Profiler::leave();
+  }
+
+private:
+
+  bool active_;
+
+}; // class ProfilerScope
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Profile the current scope.
 #define TIT_PROFILE_SECTION(section_name)                                      \
-  static auto& TIT_NAME(prof_section) = tit::Profiler::section(section_name);  \
-  const tit::StopwatchCycle TIT_NAME(prof_cycle)(TIT_NAME(prof_section))
+  static const auto& TIT_NAME(prof_section) =                                  \
+      tit::Profiler::section(section_name);                                    \
+  const tit::ProfilerScope TIT_NAME(prof_scope)(TIT_NAME(prof_section))
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
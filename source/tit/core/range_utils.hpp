@@ -76,6 +76,47 @@ constexpr void iota_perm(Range&& range, Perm&& perm) {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Output iterator that discards the written values and only counts them.
+class CountingOutputIterator final {
+public:
+
+  /// Iterator difference type.
+  using difference_type = ptrdiff_t;
+
+  /// Construct an iterator that increments @p count on each write.
+  constexpr explicit CountingOutputIterator(size_t& count) noexcept
+      : count_{&count} {}
+
+  /// Write a value.
+  constexpr auto operator*() const noexcept {
+    return Writer_{count_};
+  }
+
+  /// Advance the iterator.
+  /// @{
+  constexpr auto operator++() noexcept -> CountingOutputIterator& {
+    return *this;
+  }
+  constexpr auto operator++(int) noexcept -> CountingOutputIterator {
+    return *this;
+  }
+  /// @}
+
+private:
+
+  struct Writer_ {
+    size_t* count;
+    constexpr void operator=(const auto& /*val*/) const noexcept {
+      *count += 1;
+    }
+  };
+
+  size_t* count_;
+
+}; // class CountingOutputIterator
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Convert a value to a byte array.
 template<class T>
   requires std::is_trivially_copyable_v<T>
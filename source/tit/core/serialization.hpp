@@ -54,6 +54,22 @@ constexpr auto deserialize(Stream& in, Item& item) -> bool {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Check if the values of the type are serialized as their raw memory
+/// representation, so that contiguous ranges of them could be serialized and
+/// deserialized in bulk.
+template<class Item>
+inline constexpr bool is_raw_serializable_v =
+    std::is_trivially_copyable_v<Item> &&
+    (std::integral<Item> || std::floating_point<Item>);
+
+/// Arrays of raw serializable values are raw serializable too.
+template<class Item, size_t Size>
+inline constexpr bool is_raw_serializable_v<std::array<Item, Size>> =
+    is_raw_serializable_v<Item> &&
+    sizeof(std::array<Item, Size>) == Size * sizeof(Item);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Serialize multiple values into the output stream.
 template<class Stream, class... Items>
   requires (sizeof...(Items) > 1)
@@ -99,10 +115,15 @@ public:
   constexpr explicit StreamSerializer(OutputStreamPtr<byte_t> stream) noexcept
       : stream_{std::move(stream)} {}
 
-  /// Serialize the items and write them to the stream.
+  /// Serialize the items and write them to the stream. Raw serializable
+  /// items are written with a single call.
   constexpr void write(std::span<const Item> items) override {
     TIT_ASSERT(stream_ != nullptr, "Stream is null!");
-    for (const auto& item : items) serialize(*stream_, item);
+    if constexpr (is_raw_serializable_v<Item>) {
+      stream_->write(std::as_bytes(items));
+    } else {
+      for (const auto& item : items) serialize(*stream_, item);
+    }
   }
 
   /// Flush the stream.
@@ -135,9 +156,21 @@ public:
   constexpr explicit StreamDeserializer(InputStreamPtr<byte_t> stream) noexcept
       : stream_{std::move(stream)} {}
 
-  /// Read the bytes from the stream and deserialize thems.
+  /// Read the bytes from the stream and deserialize thems. Raw serializable
+  /// items are read directly into the output.
   constexpr auto read(std::span<Item> items) -> size_t override {
     TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+    if constexpr (is_raw_serializable_v<Item>) {
+      const auto bytes = std::as_writable_bytes(items);
+      size_t copied = 0;
+      while (copied < bytes.size()) {
+        const auto copied_now = stream_->read(bytes.subspan(copied));
+        if (copied_now == 0) break;
+        copied += copied_now;
+      }
+      if (copied % sizeof(Item) != 0) deserialization_failed();
+      return copied / sizeof(Item);
+    }
     for (size_t i = 0; i < items.size(); ++i) {
       if (!deserialize(*stream_, items[i])) {
         if (byte_t probe{}; stream_->read({&probe, 1}) != 1) return i;
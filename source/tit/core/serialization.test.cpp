@@ -45,6 +45,13 @@ TEST_CASE("serialize<std::array<...>>") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("is_raw_serializable_v") {
+  STATIC_CHECK(is_raw_serializable_v<int32_t>);
+  STATIC_CHECK(is_raw_serializable_v<float64_t>);
+  STATIC_CHECK(is_raw_serializable_v<std::array<float64_t, 3>>);
+  STATIC_CHECK_FALSE(is_raw_serializable_v<std::pair<int32_t, float64_t>>);
+}
+
 TEST_CASE("StreamSerializer") {
   std::vector<byte_t> bytes{};
   make_stream_serializer<int32_t>(make_container_output_stream(bytes))
@@ -66,6 +73,31 @@ TEST_CASE("StreamSerializer") {
   }
 }
 
+TEST_CASE("StreamSerializer<raw-serializable>") {
+  std::vector<byte_t> bytes{};
+  const std::vector<std::array<int32_t, 2>> input{{1, 2}, {3, 4}, {5, 6}};
+  make_stream_serializer<std::array<int32_t, 2>>(
+      make_container_output_stream(bytes))
+      ->write(input);
+  CHECK(bytes.size() == input.size() * 2 * sizeof(int32_t));
+
+  std::vector<std::array<int32_t, 2>> result(5);
+  SUBCASE("full") {
+    CHECK(make_stream_deserializer<std::array<int32_t, 2>>(
+              make_range_input_stream(bytes))
+              ->read(result) == 3);
+    CHECK(result >= input);
+  }
+  SUBCASE("truncated") {
+    bytes.pop_back();
+    CHECK_THROWS_MSG(make_stream_deserializer<std::array<int32_t, 2>>(
+                         make_range_input_stream(bytes))
+                         ->read(result),
+                     Exception,
+                     "truncated stream");
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
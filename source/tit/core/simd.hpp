@@ -8,10 +8,12 @@
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 // IWYU pragma: begin_exports
+#include "tit/core/_simd/convert.hpp"
 #include "tit/core/_simd/deduce.hpp"
 #include "tit/core/_simd/mask.hpp"
 #include "tit/core/_simd/reg.hpp"
 #include "tit/core/_simd/reg_mask.hpp"
+#include "tit/core/_simd/reg_math.hpp"
 #include "tit/core/_simd/traits.hpp"
 // IWYU pragma: end_exports
 
@@ -4,11 +4,19 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <ranges>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
 #include "tit/core/io.hpp"
 #include "tit/core/stats.hpp"
 #include "tit/core/str_utils.hpp"
@@ -18,17 +26,65 @@ namespace tit {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+void BaseStatsVar::summarize_step_() {
+  if (step_vals_.empty()) return;
+  auto& step = steps_.emplace_back();
+  const auto count = step_vals_.size();
+  step.count = count;
+  const auto [min, max] = std::ranges::minmax(step_vals_);
+  step.min = min, step.max = max;
+  step.mean = std::reduce(step_vals_.begin(), step_vals_.end()) /
+              static_cast<float64_t>(count);
+
+  // Compute the percentiles by the nearest rank. Percentiles are computed in
+  // the increasing order, so each next selection scans less values.
+  auto first = step_vals_.begin();
+  const auto percentile = [count, &first, this](float64_t fraction) {
+    const auto rank = static_cast<size_t>(
+        std::ceil(fraction * static_cast<float64_t>(count)));
+    const auto nth = step_vals_.begin() + static_cast<ssize_t>(
+                                              std::max<size_t>(rank, 1) - 1);
+    std::ranges::nth_element(first, nth, step_vals_.end());
+    first = nth;
+    return *nth;
+  };
+  step.p50 = percentile(0.50);
+  step.p90 = percentile(0.90);
+  step.p99 = percentile(0.99);
+
+  // Update the histogram.
+  for (const auto val : step_vals_) {
+    const auto bin = val < 1.0 ? 0 :
+                                 std::bit_width(static_cast<uint64_t>(
+                                     std::min(val, 0x1p63)));
+    histogram_[std::min<size_t>(bin, histogram_.size() - 1)] += 1;
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 bool Stats::enabled_ = false;
+std::string Stats::export_path_{};
+std::mutex Stats::vars_mutex_{};
 StrHashMap<std::unique_ptr<BaseStatsVar>> Stats::vars_;
 
 void Stats::enable() noexcept {
   // Report at exit.
   enabled_ = true;
-  checked_atexit(&report_);
+  checked_atexit([] {
+    report();
+    if (!export_path_.empty()) export_();
+  });
 }
 
-void Stats::report_() {
+void Stats::enable_export(std::string_view export_path) {
+  TIT_ASSERT(!export_path.empty(), "Export path must not be empty!");
+  export_path_ = export_path;
+}
+
+void Stats::report() {
   // Gather the variables and sort them by name.
+  const std::scoped_lock lock{vars_mutex_};
   auto sorted_vars = vars_ |
                      std::views::transform([](auto& var) { return &var; }) |
                      std::ranges::to<std::vector>();
@@ -52,11 +108,52 @@ void Stats::report_() {
     println("{:<{}} min: {}", "  ", name_width, var_ptr->render_min());
     println("{:<{}} avg: {}", name, name_width, var_ptr->render_avg());
     println("{:<{}} max: {}", "  ", name_width, var_ptr->render_max());
+
+    // Print the distribution of the values, if there are multiple values
+    // per step.
+    const auto steps = var_ptr->steps();
+    if (std::ranges::any_of(steps, [](const auto& s) { return s.count > 1; })) {
+      const auto& last = steps.back();
+      println("{:<{}} p50: {}, p90: {}, p99: {} (last step)",
+              "  ",
+              name_width,
+              last.p50,
+              last.p90,
+              last.p99);
+      const auto& histogram = var_ptr->histogram();
+      std::string bins;
+      for (const auto& [bin, count] : std::views::enumerate(histogram)) {
+        if (count == 0) continue;
+        bins += bin == 0 ? std::format(" <1: {}", count) :
+                           std::format(" <{}: {}", 1ULL << bin, count);
+      }
+      println("{:<{}} histogram:{}", "  ", name_width, bins);
+    }
     println("{:->{}}", "", width);
   }
   println();
 }
 
+void Stats::export_() {
+  const auto file = open_file(export_path_, "w");
+  println(file.get(), "name,step,count,min,mean,p50,p90,p99,max");
+  for (const auto& [name, var_ptr] : vars_) {
+    for (const auto& [index, step] : std::views::enumerate(var_ptr->steps())) {
+      println(file.get(),
+              "{},{},{},{},{},{},{},{},{}",
+              name,
+              index,
+              step.count,
+              step.min,
+              step.mean,
+              step.p50,
+              step.p90,
+              step.p99,
+              step.max);
+    }
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit
@@ -5,11 +5,14 @@
 
 #pragma once
 
+#include <array>
 #include <concepts>
 #include <format>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -25,10 +28,37 @@ namespace tit {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Summary of the values of a statistics variable in a single update step.
+struct StatsStep final {
+  size_t count = 0;     ///< Number of the values.
+  float64_t min = 0.0;  ///< Minimum value.
+  float64_t mean = 0.0; ///< Mean value.
+  float64_t p50 = 0.0;  ///< Median value.
+  float64_t p90 = 0.0;  ///< 90th percentile.
+  float64_t p99 = 0.0;  ///< 99th percentile.
+  float64_t max = 0.0;  ///< Maximum value.
+};
+
+/// Histogram of the values of a statistics variable. Bin `0` holds the values
+/// below `1`, and bin `k > 0` holds the values in range `[2^(k-1), 2^k)`.
+using StatsHistogram = std::array<size_t, 64>;
+
 /// Base class of a statistics variable.
 class BaseStatsVar : public VirtualBase {
 public:
 
+  /// Summaries of the update steps, in the order of the updates.
+  ///
+  /// @note Summaries are recorded only for the arithmetic values.
+  auto steps() const noexcept -> std::span<const StatsStep> {
+    return steps_;
+  }
+
+  /// Histogram of the values over all the update steps.
+  auto histogram() const noexcept -> const StatsHistogram& {
+    return histogram_;
+  }
+
   /// Get the average value as a string.
   constexpr virtual auto render_avg() const -> std::string = 0;
 
@@ -38,6 +68,30 @@ public:
   /// Get the maximum value as a string.
   constexpr virtual auto render_max() const -> std::string = 0;
 
+protected:
+
+  // Record the summary of the values of the update step.
+  template<std::ranges::input_range Vals>
+    requires std::is_arithmetic_v<std::ranges::range_value_t<Vals>>
+  void record_step_(Vals&& vals) {
+    step_vals_.clear();
+    for (const auto& val : vals) {
+      step_vals_.push_back(static_cast<float64_t>(val));
+    }
+    summarize_step_();
+  }
+
+  // Updates are synchronized by the derived classes with this mutex.
+  std::mutex mutex_;
+
+private:
+
+  void summarize_step_();
+
+  std::vector<float64_t> step_vals_;
+  std::vector<StatsStep> steps_;
+  StatsHistogram histogram_{};
+
 }; // class BaseStatsVar
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -78,11 +132,15 @@ public:
     return std::format("{}", max_);
   }
 
-  /// Update the statistics variable.
+  /// Update the statistics variable. Updates are thread-safe.
   void update(const Val& val) {
+    const std::scoped_lock lock{mutex_};
     if (count_ == 0) sum_ = min_ = max_ = val;
     else sum_ += val, min_ = std::min(min_, val), max_ = std::max(max_, val);
     count_ += 1;
+    if constexpr (std::is_arithmetic_v<Val>) {
+      record_step_(std::views::single(val));
+    }
   }
 
 private:
@@ -120,8 +178,9 @@ public:
     return std::format("{}", max_);
   }
 
-  /// Update the statistics variable.
+  /// Update the statistics variable. Updates are thread-safe.
   void update(const Vals& range) {
+    const std::scoped_lock lock{mutex_};
     for (const auto& [i, val] :
          std::views::enumerate(range) | std::views::take(sum_.size())) {
       sum_[i] += val;
@@ -134,6 +193,7 @@ public:
       max_.push_back(val);
     }
     count_ += 1;
+    if constexpr (std::is_arithmetic_v<Val>) record_step_(range);
   }
 
 private:
@@ -158,6 +218,7 @@ public:
   template<class Type>
     requires std::is_object_v<Type>
   static auto var(std::string_view var_name) -> StatsVar<Type>& {
+    const std::scoped_lock lock{vars_mutex_};
     /// @todo In C++26 there would be no need for `std::string{...}`.
     auto& var = vars_[std::string{var_name}];
     if (var == nullptr) var = std::make_unique<StatsVar<Type>>();
@@ -169,6 +230,15 @@ public:
   /// Enable statistics. Report will be printed at exit.
   static void enable() noexcept;
 
+  /// Export the update step summaries of all the variables to the CSV file
+  /// at exit. Each row of the file holds the name of the variable, the step
+  /// index, and the fields of the step summary.
+  static void enable_export(std::string_view export_path);
+
+  /// Print the report of the variables so far, without stopping the
+  /// statistics.
+  static void report();
+
   /// Is statistics enabled?
   static auto enabled() noexcept -> bool {
     return enabled_;
@@ -176,9 +246,11 @@ public:
 
 private:
 
-  static void report_();
+  static void export_();
 
   static bool enabled_;
+  static std::string export_path_;
+  static std::mutex vars_mutex_;
   static StrHashMap<std::unique_ptr<BaseStatsVar>> vars_;
 
 }; // class Stats
@@ -335,6 +335,128 @@ auto make_counting_output_stream(OutputStreamPtr<Item> stream,
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Default size of the stream buffer, in items.
+inline constexpr size_t DefaultStreamBufferSize = 4096;
+
+/// Buffered input stream.
+///
+/// Items are read from the underlying stream in blocks, so that the small
+/// reads do not reach the underlying stream each time. Reads that are larger
+/// than the buffer bypass it.
+template<class Item>
+  requires std::default_initializable<Item> && std::movable<Item>
+class BufferedInputStream final : public InputStream<Item> {
+public:
+
+  /// Construct a buffered input stream.
+  constexpr explicit BufferedInputStream(
+      InputStreamPtr<Item> stream,
+      size_t buffer_size = DefaultStreamBufferSize)
+      : stream_{std::move(stream)}, buffer_size_{buffer_size} {
+    TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+    TIT_ASSERT(buffer_size_ > 0, "Buffer size must be positive!");
+  }
+
+  /// Read the next items from the stream.
+  constexpr auto read(std::span<Item> items) -> size_t override {
+    size_t copied = 0;
+    while (copied < items.size()) {
+      if (offset_ == buffer_.size()) {
+        // Read large requests directly, refill the buffer otherwise.
+        if (const auto rest = items.subspan(copied);
+            rest.size() >= buffer_size_) {
+          const auto copied_now = stream_->read(rest);
+          if (copied_now == 0) break;
+          copied += copied_now;
+          continue;
+        }
+        buffer_.resize(buffer_size_);
+        buffer_.resize(stream_->read(buffer_));
+        offset_ = 0;
+        if (buffer_.empty()) break; // Underlying stream is exhausted.
+      }
+      const auto copied_now =
+          std::min(buffer_.size() - offset_, items.size() - copied);
+      std::ranges::move(std::span{buffer_}.subspan(offset_, copied_now),
+                        items.begin() + copied);
+      offset_ += copied_now, copied += copied_now;
+    }
+    return copied;
+  }
+
+private:
+
+  InputStreamPtr<Item> stream_;
+  size_t buffer_size_;
+  std::vector<Item> buffer_;
+  size_t offset_ = 0;
+
+}; // class BufferedInputStream
+
+/// Make a buffered input stream.
+template<class Item>
+constexpr auto make_buffered_input_stream(
+    InputStreamPtr<Item> stream,
+    size_t buffer_size = DefaultStreamBufferSize) -> InputStreamPtr<Item> {
+  using Result = BufferedInputStream<Item>;
+  return std::make_unique<Result>(std::move(stream), buffer_size);
+}
+
+/// Buffered output stream.
+///
+/// Items are accumulated in the buffer and written to the underlying stream
+/// in blocks. Writes that are larger than the buffer bypass it.
+template<class Item>
+class BufferedOutputStream final : public OutputStream<Item> {
+public:
+
+  /// Construct a buffered output stream.
+  constexpr explicit BufferedOutputStream(
+      OutputStreamPtr<Item> stream,
+      size_t buffer_size = DefaultStreamBufferSize)
+      : stream_{std::move(stream)}, buffer_size_{buffer_size} {
+    TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+    TIT_ASSERT(buffer_size_ > 0, "Buffer size must be positive!");
+  }
+
+  /// Write the next items to the stream.
+  constexpr void write(std::span<const Item> items) override {
+    if (buffer_.size() + items.size() > buffer_size_) flush_buffer_();
+    if (items.size() >= buffer_size_) stream_->write(items);
+    else buffer_.insert(buffer_.end(), items.begin(), items.end());
+  }
+
+  /// Flush the stream.
+  constexpr void flush() override {
+    flush_buffer_();
+    stream_->flush();
+  }
+
+private:
+
+  constexpr void flush_buffer_() {
+    if (buffer_.empty()) return;
+    stream_->write(buffer_);
+    buffer_.clear();
+  }
+
+  OutputStreamPtr<Item> stream_;
+  size_t buffer_size_;
+  std::vector<Item> buffer_;
+
+}; // class BufferedOutputStream
+
+/// Make a buffered output stream.
+template<class Item>
+constexpr auto make_buffered_output_stream(
+    OutputStreamPtr<Item> stream,
+    size_t buffer_size = DefaultStreamBufferSize) -> OutputStreamPtr<Item> {
+  using Result = BufferedOutputStream<Item>;
+  return make_flushable<Result>(std::move(stream), buffer_size);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Input stream transformer.
 template<class SourceItem, std::invocable<SourceItem&> Proj>
 class ProjectedInputStream final :
@@ -0,0 +1,74 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/stream.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("BufferedInputStream") {
+  std::vector<int> items(100);
+  std::ranges::iota(items, 0);
+  const auto stream =
+      make_buffered_input_stream(make_range_input_stream(items), 8);
+  SUBCASE("small reads") {
+    std::array<int, 3> result{};
+    for (int i = 0; i < 33; ++i) {
+      REQUIRE(stream->read(result) == 3);
+      CHECK(result == std::array{3 * i, 3 * i + 1, 3 * i + 2});
+    }
+    CHECK(stream->read(result) == 1);
+    CHECK(result[0] == 99);
+    CHECK(stream->read(result) == 0);
+  }
+  SUBCASE("large reads") {
+    std::vector<int> result(30);
+    REQUIRE(stream->read(std::span{result}.first(5)) == 5);
+    REQUIRE(stream->read(result) == 30);
+    CHECK_RANGE_EQ(result, std::views::iota(5, 35));
+    std::vector<int> rest(100);
+    REQUIRE(stream->read(rest) == 65);
+    CHECK_RANGE_EQ(std::span{rest}.first(65), std::views::iota(35, 100));
+  }
+}
+
+TEST_CASE("BufferedOutputStream") {
+  std::vector<int> result{};
+  const auto stream =
+      make_buffered_output_stream(make_container_output_stream(result), 8);
+  SUBCASE("small writes") {
+    for (int i = 0; i < 10; ++i) stream->write(std::array{2 * i, 2 * i + 1});
+    CHECK(result.size() == 16);
+    stream->flush();
+    CHECK_RANGE_EQ(result, std::views::iota(0, 20));
+  }
+  SUBCASE("large writes") {
+    std::vector<int> items(20);
+    std::ranges::iota(items, 0);
+    stream->write(std::span{items}.first(3));
+    CHECK(result.empty());
+    stream->write(std::span{items}.subspan(3, 12));
+    CHECK(result.size() == 15);
+    stream->write(std::span{items}.subspan(15));
+    stream->flush();
+    CHECK_RANGE_EQ(result, items);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
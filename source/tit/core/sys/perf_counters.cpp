@@ -0,0 +1,118 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <ranges>
+#include <utility>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/sys/perf_counters.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#ifdef __linux__
+
+namespace {
+
+// Open the hardware performance counter for the calling thread.
+auto open_perf_counter(PerfCounter counter, int group_fd) noexcept -> int {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = [counter] -> uint64_t {
+    switch (counter) {
+      case PerfCounter::cycles:       return PERF_COUNT_HW_CPU_CYCLES;
+      case PerfCounter::instructions: return PERF_COUNT_HW_INSTRUCTIONS;
+      case PerfCounter::cache_misses: return PERF_COUNT_HW_CACHE_MISSES;
+      default:                        std::unreachable();
+    }
+  }();
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.disabled = group_fd < 0 ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // NOLINTNEXTLINE(*-vararg)
+  return static_cast<int>(syscall(SYS_perf_event_open,
+                                  &attr,
+                                  /*pid=*/0,
+                                  /*cpu=*/-1,
+                                  group_fd,
+                                  /*flags=*/0UL));
+}
+
+} // namespace
+
+PerfCounterGroup::PerfCounterGroup() noexcept {
+  // Open the counters, the first one is the group leader.
+  fds_.fill(-1);
+  for (size_t i = 0; i < num_perf_counters; ++i) {
+    fds_[i] = open_perf_counter(static_cast<PerfCounter>(i), fds_[0]);
+    if (fds_[i] >= 0) continue;
+
+    // Counters are available only as a whole group.
+    for (auto& fd : fds_) {
+      if (fd >= 0) close(fd);
+      fd = -1;
+    }
+    return;
+  }
+
+  // Start counting.
+  // NOLINTBEGIN(*-vararg)
+  ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  // NOLINTEND(*-vararg)
+}
+
+PerfCounterGroup::~PerfCounterGroup() noexcept {
+  for (const auto fd : fds_) {
+    if (fd >= 0) close(fd);
+  }
+}
+
+auto PerfCounterGroup::read() const noexcept
+    -> std::optional<PerfCounterValues> {
+  if (!active()) return std::nullopt;
+
+  // Group read returns the number of counters, followed by their values.
+  std::array<uint64_t, num_perf_counters + 1> buffer{};
+  const auto size = ::read(fds_[0], buffer.data(), sizeof(buffer));
+  if (size != sizeof(buffer) || buffer[0] != num_perf_counters) {
+    return std::nullopt;
+  }
+  PerfCounterValues result{};
+  std::ranges::copy(buffer | std::views::drop(1), result.vals_.begin());
+  return result;
+}
+
+#else
+
+PerfCounterGroup::PerfCounterGroup() noexcept {
+  fds_.fill(-1);
+}
+
+PerfCounterGroup::~PerfCounterGroup() noexcept = default;
+
+auto PerfCounterGroup::read() const noexcept
+    -> std::optional<PerfCounterValues> {
+  return std::nullopt;
+}
+
+#endif
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
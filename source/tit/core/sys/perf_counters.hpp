@@ -0,0 +1,101 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <array>
+#include <optional>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/utils.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Hardware performance counter.
+enum class PerfCounter : uint8_t {
+  cycles,       ///< CPU cycles.
+  instructions, ///< Retired instructions.
+  cache_misses, ///< Last level cache misses.
+  count,        ///< Number of the counters.
+};
+
+/// Number of the hardware performance counters.
+inline constexpr auto num_perf_counters =
+    static_cast<size_t>(PerfCounter::count);
+
+/// Values of the hardware performance counters.
+class PerfCounterValues final {
+public:
+
+  /// Value of the counter.
+  constexpr auto operator[](PerfCounter counter) const noexcept -> uint64_t {
+    return vals_[static_cast<size_t>(counter)];
+  }
+
+  /// Add the values of the other counters.
+  constexpr auto operator+=(const PerfCounterValues& other) noexcept
+      -> PerfCounterValues& {
+    for (size_t i = 0; i < num_perf_counters; ++i) vals_[i] += other.vals_[i];
+    return *this;
+  }
+
+  /// Difference of the counter values.
+  constexpr auto operator-(const PerfCounterValues& other) const noexcept
+      -> PerfCounterValues {
+    PerfCounterValues result{};
+    for (size_t i = 0; i < num_perf_counters; ++i) {
+      result.vals_[i] = vals_[i] - other.vals_[i];
+    }
+    return result;
+  }
+
+private:
+
+  friend class PerfCounterGroup;
+
+  std::array<uint64_t, num_perf_counters> vals_{};
+
+}; // class PerfCounterValues
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Group of the hardware performance counters of the calling thread.
+///
+/// On Linux, the counters are opened with `perf_event_open`, and only count
+/// the user space events of the thread that has opened them. If counters are
+/// not supported by the platform, or access to them is denied (for example,
+/// by `kernel.perf_event_paranoid`), the group is inactive.
+class PerfCounterGroup final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(PerfCounterGroup);
+
+  /// Open and start the counters for the calling thread.
+  PerfCounterGroup() noexcept;
+
+  /// Close the counters.
+  ~PerfCounterGroup() noexcept;
+
+  /// Are the counters active?
+  auto active() const noexcept -> bool {
+    return fds_[0] >= 0;
+  }
+
+  /// Read the current values of the counters. Nothing is returned if the
+  /// group is inactive or the read has failed, so that no difference is
+  /// taken with the missing values.
+  auto read() const noexcept -> std::optional<PerfCounterValues>;
+
+private:
+
+  std::array<int, num_perf_counters> fds_{};
+
+}; // class PerfCounterGroup
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -0,0 +1,54 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/sys/perf_counters.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("PerfCounterValues") {
+  // Difference of the equal values is zero, and adding it changes nothing.
+  PerfCounterValues values{};
+  values += values - values;
+  CHECK(values[PerfCounter::cycles] == 0);
+  CHECK(values[PerfCounter::instructions] == 0);
+  CHECK(values[PerfCounter::cache_misses] == 0);
+}
+
+TEST_CASE("PerfCounterGroup") {
+  // Counters may be unavailable on the test machine, e.g. within a container
+  // or with the restrictive `kernel.perf_event_paranoid`. Inactive group must
+  // return no values, instead of the zeroes, that would make the difference
+  // of the readings meaningless.
+  const PerfCounterGroup group{};
+  if (!group.active()) {
+    CHECK_FALSE(group.read().has_value());
+    return;
+  }
+
+  // Counters only grow, and some instructions are executed between the
+  // readings.
+  const auto start = group.read();
+  REQUIRE(start.has_value());
+  volatile uint64_t sum = 0;
+  for (uint64_t i = 0; i < 1000; ++i) sum = sum + i;
+  const auto stop = group.read();
+  REQUIRE(stop.has_value());
+  CHECK((*stop)[PerfCounter::instructions] >
+        (*start)[PerfCounter::instructions]);
+  CHECK((*stop)[PerfCounter::cycles] >= (*start)[PerfCounter::cycles]);
+  const auto delta = *stop - *start;
+  CHECK(delta[PerfCounter::instructions] >= 1000);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <csignal>
 #include <cstdlib>
 #include <initializer_list>
@@ -82,6 +83,14 @@ void SignalHandler::handle_signal_(int signal_number) noexcept {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+SignalFlag::SignalFlag(int signal_number) : SignalHandler{signal_number} {}
+
+void SignalFlag::on_signal(int /*signal_number*/) noexcept {
+  caught_.store(true, std::memory_order_release);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 namespace {
 
 // Dump a message in the "async-signal-safe" way.
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <csignal>
 #include <initializer_list>
 #include <ranges>
@@ -57,6 +58,32 @@ private:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Signal handler that records the signal, so that it could be handled later
+/// at a point where it is safe to do so, for example, between the time steps.
+class SignalFlag final : public SignalHandler {
+public:
+
+  /// Initialize handling for the specified signal.
+  explicit SignalFlag(int signal_number);
+
+  /// Check if the signal was caught since the last check, and reset the flag.
+  auto test_and_reset() noexcept -> bool {
+    return caught_.exchange(false, std::memory_order_acq_rel);
+  }
+
+protected:
+
+  void on_signal(int signal_number) noexcept override;
+
+private:
+
+  std::atomic<bool> caught_{false};
+  static_assert(std::atomic<bool>::is_always_lock_free);
+
+}; // class SignalFlag
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Signal handler that catches fatal signals and exits the process.
 class FatalSignalHandler final : public SignalHandler {
 public:
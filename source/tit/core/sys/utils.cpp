@@ -19,6 +19,7 @@
 #include <sys/ttycom.h>
 #endif
 #include <sys/ioctl.h>
+#include <sys/resource.h>
 #include <unistd.h>
 
 #include <boost/core/demangle.hpp>
@@ -109,6 +110,21 @@ auto tty_width(TTY tty) -> std::optional<size_t> {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+auto max_rss() -> size_t {
+  rusage usage = {};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    TIT_THROW("Unable to query resource usage of the process!");
+  }
+  const auto max_rss = static_cast<size_t>(usage.ru_maxrss);
+#ifdef __APPLE__
+  return max_rss; // Reported in bytes.
+#else
+  return max_rss * 1024; // Reported in kilobytes.
+#endif
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 auto try_demangle(CStrView mangled_name) -> std::optional<std::string> {
   const boost::core::scoped_demangled_name demangled_name{mangled_name.c_str()};
   if (const auto* p = demangled_name.get(); p != nullptr) return p;
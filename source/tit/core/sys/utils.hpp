@@ -88,6 +88,11 @@ auto tty_width(TTY tty) -> std::optional<size_t>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Peak resident set size of the current process, in bytes.
+auto max_rss() -> size_t;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Try to demangle a mangled name.
 /// @{
 auto try_demangle(CStrView mangled_name) -> std::optional<std::string>;
@@ -3,6 +3,9 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
 #include "tit/core/sys/utils.hpp"
 
 #include "tit/testing/test.hpp"
@@ -46,5 +49,18 @@ TEST_CASE("get_env") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("max_rss") {
+  // Peak resident set size grows once the memory is touched.
+  const auto before = max_rss();
+  CHECK(before > 0);
+  constexpr size_t size = size_t{64} << 20;
+  const std::vector<char> buffer(size, 1);
+  CHECK(buffer[size / 2] == 1);
+  CHECK(max_rss() >= before);
+  CHECK(max_rss() >= size);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
@@ -0,0 +1,69 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/time.hpp"
+
+namespace tit {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Is the time stamp counter invariant?
+auto has_invariant_tsc() noexcept -> bool {
+#if defined(__x86_64__) || defined(__i386__)
+  // Invariant TSC is reported in the bit 8 of EDX of the leaf 0x80000007.
+  uint32_t eax = 0;
+  uint32_t ebx = 0;
+  uint32_t ecx = 0;
+  uint32_t edx = 0;
+  if (__get_cpuid(0x8000'0007, &eax, &ebx, &ecx, &edx) == 0) return false;
+  return (edx & (1U << 8U)) != 0;
+#elif defined(__aarch64__)
+  // Generic timer virtual counter is always running at a fixed frequency.
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Measure the counter rate against the steady clock.
+auto calibrate_tsc() noexcept -> impl::TscCalibration {
+  if (!has_invariant_tsc()) return {};
+  using std::chrono::steady_clock;
+  constexpr auto duration = std::chrono::milliseconds{10};
+  const auto start_time = steady_clock::now();
+  const auto start_ticks = TscClock::ticks();
+  auto stop_time = start_time;
+  while (stop_time - start_time < duration) stop_time = steady_clock::now();
+  const auto stop_ticks = TscClock::ticks();
+  if (stop_ticks <= start_ticks) return {};
+  const auto elapsed_ns =
+      std::chrono::duration<float64_t, std::nano>{stop_time - start_time};
+  return {
+      .available = true,
+      .origin = start_ticks,
+      .ns_per_tick =
+          elapsed_ns.count() / static_cast<float64_t>(stop_ticks - start_ticks),
+  };
+}
+
+} // namespace
+
+auto impl::tsc_calibration() noexcept -> const TscCalibration& {
+  static const auto calibration = calibrate_tsc();
+  return calibration;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit
@@ -6,8 +6,13 @@
 #pragma once
 
 #include <chrono>
+#include <ratio>
 #include <utility>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/utils.hpp"
@@ -16,19 +21,87 @@ namespace tit {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-/// Basic stopwatch.
-class Stopwatch final {
+namespace impl {
+
+// Time stamp counter calibration.
+struct TscCalibration final {
+  bool available = false;  // Is the invariant counter available?
+  uint64_t origin = 0;     // Counter value at the time point epoch.
+  float64_t ns_per_tick{}; // Counter period (in nanoseconds).
+};
+
+// Calibrate the time stamp counter on the first call.
+auto tsc_calibration() noexcept -> const TscCalibration&;
+
+} // namespace impl
+
+/// Clock based on the processor time stamp counter.
+///
+/// Reading the counter takes a few nanoseconds, so the clock is intended for
+/// the fine-grained sections, where the overhead of `steady_clock` would be
+/// noticeable. The counter must be invariant, that is, tick at a constant
+/// rate on all the cores regardless of the frequency scaling. It is
+/// calibrated against `steady_clock` on the first use. Where no such counter
+/// is available, the clock falls back to `steady_clock`.
+class TscClock final {
+public:
+
+  using rep = int64_t;                                  ///< Tick count type.
+  using period = std::nano;                             ///< Tick period.
+  using duration = std::chrono::nanoseconds;            ///< Duration type.
+  using time_point = std::chrono::time_point<TscClock>; ///< Time point type.
+
+  /// Clock is steady.
+  static constexpr bool is_steady = true;
+
+  /// Is the invariant time stamp counter available?
+  static auto available() noexcept -> bool {
+    return impl::tsc_calibration().available;
+  }
+
+  /// Read the raw counter value (in ticks).
+  static auto ticks() noexcept -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t result = 0;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(result));
+    return result;
+#else
+    return 0;
+#endif
+  }
+
+  /// Current time point.
+  static auto now() noexcept -> time_point {
+    const auto& calibration = impl::tsc_calibration();
+    if (!calibration.available) [[unlikely]] {
+      const auto now = std::chrono::steady_clock::now().time_since_epoch();
+      return time_point{std::chrono::duration_cast<duration>(now)};
+    }
+    const auto delta = static_cast<float64_t>(ticks() - calibration.origin);
+    return time_point{
+        duration{static_cast<rep>(delta * calibration.ns_per_tick)}};
+  }
+
+}; // class TscClock
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Basic stopwatch, that measures the time with the given clock.
+template<class Clock>
+class BasicStopwatch final {
 public:
 
   /// Start the new stopwatch cycle.
   void start() noexcept {
-    start_ = std::chrono::steady_clock::now();
+    start_ = Clock::now();
   }
 
   /// Stop the stopwatch cycle and update the measured delta time.
   void stop() noexcept {
-    const auto stop = std::chrono::steady_clock::now();
-    TIT_ASSERT(stop > start_, "Stopwatch was not started!");
+    const auto stop = Clock::now();
+    TIT_ASSERT(stop >= start_, "Stopwatch was not started!");
     const auto delta = stop - start_;
     total_ += std::chrono::duration_cast<std::chrono::nanoseconds>(delta);
     cycles_ += 1;
@@ -67,22 +140,29 @@ public:
 
 private:
 
-  std::chrono::time_point<std::chrono::steady_clock> start_;
+  typename Clock::time_point start_;
   std::chrono::nanoseconds total_{};
   size_t cycles_{};
 
-}; // class Stopwatch
+}; // class BasicStopwatch
+
+/// Stopwatch, based on the `steady_clock`.
+using Stopwatch = BasicStopwatch<std::chrono::steady_clock>;
+
+/// Stopwatch, based on the time stamp counter, see `TscClock`.
+using TscStopwatch = BasicStopwatch<TscClock>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Scoped stopwatch cycle.
+template<class Clock>
 class StopwatchCycle final {
 public:
 
   TIT_MOVE_ONLY(StopwatchCycle);
 
   /// Start the new stopwatch cycle.
-  explicit StopwatchCycle(Stopwatch& stopwatch) noexcept
+  explicit StopwatchCycle(BasicStopwatch<Clock>& stopwatch) noexcept
       : stopwatch_{&stopwatch} {
     stopwatch_->start();
   }
@@ -104,7 +184,7 @@ public:
 
 private:
 
-  Stopwatch* stopwatch_;
+  BasicStopwatch<Clock>* stopwatch_;
 
 }; // class StopwatchCycle
 
@@ -32,6 +32,34 @@ TEST_CASE("Stopwatch") {
   CHECK(stopwatch.cycle() >= delta_sec);
 }
 
+TEST_CASE("TscClock") {
+  // Ensure the clock is steady, and agrees with the steady clock up to the
+  // calibration error.
+  using std::chrono::steady_clock;
+  const auto delta = std::chrono::milliseconds(100);
+  const auto start = TscClock::now();
+  const auto steady_start = steady_clock::now();
+  std::this_thread::sleep_for(delta);
+  const auto steady_stop = steady_clock::now();
+  const auto stop = TscClock::now();
+  CHECK(stop - start >= 0.99 * (steady_stop - steady_start));
+  CHECK(stop - start < 2 * (steady_stop - steady_start));
+  CHECK(TscClock::now() >= stop);
+}
+
+TEST_CASE("TscStopwatch") {
+  TscStopwatch stopwatch{};
+  const auto delta = std::chrono::milliseconds(100);
+  const auto delta_sec = 1.0e-3 * static_cast<real_t>(delta.count());
+  {
+    const StopwatchCycle cycle{stopwatch};
+    std::this_thread::sleep_for(delta);
+  }
+  CHECK(stopwatch.cycles() == 1);
+  // Calibration error is allowed.
+  CHECK(stopwatch.total() >= 0.99 * delta_sec);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace
@@ -45,6 +45,12 @@ struct AlwaysTrue final {
   }
 };
 
+/// Hint the processor to fetch the memory at the address into the cache in
+/// advance of the read. Address does not need to be valid.
+inline void prefetch(const void* ptr) noexcept {
+  __builtin_prefetch(ptr, /*rw=*/0, /*locality=*/3);
+}
+
 /// Check if the given value is in the range [ @p a, @p b ].
 template<class T>
 constexpr auto in_range(T x,
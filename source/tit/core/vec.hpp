@@ -11,6 +11,7 @@
 #include "tit/core/_vec/traits.hpp"
 #include "tit/core/_vec/vec.hpp"
 #include "tit/core/_vec/vec_mask.hpp"
+#include "tit/core/_vec/vec_pack.hpp"
 // IWYU pragma: end_exports
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -0,0 +1,167 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+
+#include "tit/data/events.hpp"
+#include "tit/data/sqlite.hpp"
+#include "tit/data/storage.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Event as it is sent over the socket.
+struct WireEvent final {
+  sqlite::RowID series_id;
+  sqlite::RowID time_step_id;
+  float64_t time;
+  uint64_t num_particles;
+};
+
+// Make a socket address for the path.
+auto make_address(const std::filesystem::path& path) -> sockaddr_un {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  const auto& native = path.native();
+  if (native.size() >= sizeof(address.sun_path)) {
+    TIT_THROW("Event channel path '{}' is too long!", path.c_str());
+  }
+  std::memcpy(address.sun_path, native.c_str(), native.size() + 1);
+  return address;
+}
+
+// Is there a socket bound to the address?
+auto is_bound(const sockaddr_un& address) -> bool {
+  const auto probe = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (probe < 0) return false;
+  // Connection to a socket file, that no one is bound to, is refused.
+  const auto result = connect(probe,
+                              reinterpret_cast<const sockaddr*>(&address),
+                              sizeof(address));
+  close(probe);
+  return result == 0;
+}
+
+} // namespace
+
+auto events_path(const std::filesystem::path& storage_path)
+    -> std::filesystem::path {
+  auto result = storage_path;
+  if (!result.empty()) result += ".events";
+  return result;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+DataEventPublisher::DataEventPublisher(
+    const std::filesystem::path& storage_path)
+    : path_{events_path(storage_path)} {
+  if (path_.empty()) return; // In-memory storage, nothing to publish.
+  static_cast<void>(make_address(path_)); // Check the path length.
+  socket_ = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (socket_ < 0) TIT_THROW("Unable to create the event channel socket!");
+}
+
+DataEventPublisher::~DataEventPublisher() noexcept {
+  if (socket_ >= 0) close(socket_);
+}
+
+void DataEventPublisher::publish(
+    const DataTimeStepEvent& event) const noexcept {
+  if (socket_ < 0) return;
+  const WireEvent wire_event{.series_id = event.series_id.get(),
+                             .time_step_id = event.time_step_id.get(),
+                             .time = event.time,
+                             .num_particles = event.num_particles};
+  const auto address = make_address(path_);
+  // Failures mean that there is no subscriber, or it is not keeping up.
+  // Either way, the event is not needed.
+  static_cast<void>(sendto(socket_,
+                           &wire_event,
+                           sizeof(wire_event),
+                           MSG_NOSIGNAL,
+                           reinterpret_cast<const sockaddr*>(&address),
+                           sizeof(address)));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+DataEventSubscriber::DataEventSubscriber(
+    const std::filesystem::path& storage_path)
+    : path_{events_path(storage_path)} {
+  if (path_.empty()) TIT_THROW("Events require a file-backed storage!");
+  const auto address = make_address(path_);
+  if (is_bound(address)) {
+    TIT_THROW("Event channel '{}' already has a subscriber!", path_.c_str());
+  }
+  socket_ = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (socket_ < 0) TIT_THROW("Unable to create the event channel socket!");
+  std::error_code error;
+  std::filesystem::remove(path_, error); // Remove the stale channel, if any.
+  if (bind(socket_,
+           reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) != 0) {
+    close(socket_);
+    TIT_THROW("Unable to bind the event channel '{}'!", path_.c_str());
+  }
+
+  // Remember the socket file, so that only the one created here is removed.
+  struct stat info{};
+  if (stat(path_.c_str(), &info) == 0) {
+    device_ = static_cast<uint64_t>(info.st_dev);
+    inode_ = static_cast<uint64_t>(info.st_ino);
+  }
+}
+
+DataEventSubscriber::~DataEventSubscriber() noexcept {
+  close(socket_);
+  // Channel may have been replaced by another subscriber meanwhile.
+  struct stat info{};
+  if (stat(path_.c_str(), &info) != 0) return;
+  if (static_cast<uint64_t>(info.st_dev) != device_ ||
+      static_cast<uint64_t>(info.st_ino) != inode_) {
+    return;
+  }
+  std::error_code error;
+  std::filesystem::remove(path_, error);
+}
+
+auto DataEventSubscriber::receive(std::chrono::milliseconds timeout) const
+    -> std::optional<DataTimeStepEvent> {
+  pollfd poll_fd{.fd = socket_, .events = POLLIN, .revents = 0};
+  if (poll(&poll_fd, 1, static_cast<int>(timeout.count())) <= 0) {
+    return std::nullopt;
+  }
+  WireEvent wire_event{};
+  const auto size = recv(socket_, &wire_event, sizeof(wire_event), 0);
+  if (size != sizeof(wire_event)) return std::nullopt;
+  return DataTimeStepEvent{
+      .series_id = DataSeriesID{wire_event.series_id},
+      .time_step_id = DataTimeStepID{wire_event.time_step_id},
+      .time = wire_event.time,
+      .num_particles = wire_event.num_particles,
+  };
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
@@ -0,0 +1,95 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/data/storage.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Notification about a new time step in the data storage.
+struct DataTimeStepEvent final {
+  DataSeriesID series_id;      ///< Series of the time step.
+  DataTimeStepID time_step_id; ///< Time step ID.
+  real_t time;                 ///< Time step time.
+  size_t num_particles;        ///< Number of the particles, if known.
+};
+
+/// Path of the event channel of the data storage at the given path.
+auto events_path(const std::filesystem::path& storage_path)
+    -> std::filesystem::path;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Publisher of the data storage events.
+///
+/// Events are sent as datagrams over a local socket, so publishing never
+/// blocks the writer. Events are silently dropped if there is no subscriber.
+class DataEventPublisher final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(DataEventPublisher);
+
+  /// Construct a publisher of the events of the storage at the given path.
+  explicit DataEventPublisher(const std::filesystem::path& storage_path);
+
+  /// Close the publisher.
+  ~DataEventPublisher() noexcept;
+
+  /// Publish the time step event.
+  void publish(const DataTimeStepEvent& event) const noexcept;
+
+private:
+
+  std::filesystem::path path_;
+  int socket_ = -1;
+
+}; // class DataEventPublisher
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Subscriber to the data storage events.
+///
+/// Only one subscriber may listen to the events of a storage at a time. Stale
+/// channel of a subscriber, that has exited without the cleanup, is replaced.
+class DataEventSubscriber final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(DataEventSubscriber);
+
+  /// Subscribe to the events of the storage at the given path.
+  ///
+  /// @throws Exception if the storage already has a subscriber.
+  explicit DataEventSubscriber(const std::filesystem::path& storage_path);
+
+  /// Unsubscribe from the events. Channel is removed only if it was not
+  /// replaced by another subscriber.
+  ~DataEventSubscriber() noexcept;
+
+  /// Wait for the next time step event for at most @p timeout.
+  auto receive(std::chrono::milliseconds timeout) const
+      -> std::optional<DataTimeStepEvent>;
+
+private:
+
+  std::filesystem::path path_;
+  int socket_ = -1;
+  uint64_t device_ = 0;
+  uint64_t inode_ = 0;
+
+}; // class DataEventSubscriber
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
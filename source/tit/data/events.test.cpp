@@ -0,0 +1,109 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#include "tit/core/exception.hpp"
+
+#include "tit/data/events.hpp"
+#include "tit/data/storage.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+using namespace std::chrono_literals;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::events_path") {
+  CHECK(data::events_path("test.ttdb") == "test.ttdb.events");
+  CHECK(data::events_path("").empty());
+}
+
+TEST_CASE("data::DataEventPublisher") {
+  const std::filesystem::path storage_path{"test_events.ttdb"};
+  SUBCASE("no subscriber") {
+    // Events are dropped silently.
+    const data::DataEventPublisher publisher{storage_path};
+    publisher.publish({.series_id = data::DataSeriesID{1},
+                       .time_step_id = data::DataTimeStepID{2},
+                       .time = 0.5,
+                       .num_particles = 10});
+  }
+  SUBCASE("in-memory storage") {
+    const data::DataEventPublisher publisher{""};
+    publisher.publish({.series_id = data::DataSeriesID{1},
+                       .time_step_id = data::DataTimeStepID{2},
+                       .time = 0.5,
+                       .num_particles = 10});
+  }
+  SUBCASE("with subscriber") {
+    const data::DataEventSubscriber subscriber{storage_path};
+    CHECK(std::filesystem::exists(data::events_path(storage_path)));
+    CHECK_FALSE(subscriber.receive(0ms).has_value());
+    const data::DataEventPublisher publisher{storage_path};
+    publisher.publish({.series_id = data::DataSeriesID{1},
+                       .time_step_id = data::DataTimeStepID{2},
+                       .time = 0.5,
+                       .num_particles = 10});
+    const auto event = subscriber.receive(1000ms);
+    REQUIRE(event.has_value());
+    CHECK(event->series_id == data::DataSeriesID{1});
+    CHECK(event->time_step_id == data::DataTimeStepID{2});
+    CHECK(event->time == 0.5);
+    CHECK(event->num_particles == 10);
+    CHECK_FALSE(subscriber.receive(0ms).has_value());
+  }
+  CHECK_FALSE(std::filesystem::exists(data::events_path(storage_path)));
+}
+
+TEST_CASE("data::DataEventSubscriber") {
+  SUBCASE("in-memory storage") {
+    CHECK_THROWS_MSG(data::DataEventSubscriber{""},
+                     Exception,
+                     "Events require a file-backed storage!");
+  }
+  SUBCASE("second subscriber") {
+    const std::filesystem::path storage_path{"test_events.ttdb"};
+    const data::DataEventSubscriber subscriber{storage_path};
+    CHECK_THROWS_MSG(data::DataEventSubscriber{storage_path},
+                     Exception,
+                     "already has a subscriber");
+
+    // Channel of the first subscriber is still there.
+    const data::DataEventPublisher publisher{storage_path};
+    publisher.publish({.series_id = data::DataSeriesID{1},
+                       .time_step_id = data::DataTimeStepID{2},
+                       .time = 0.5,
+                       .num_particles = 10});
+    CHECK(subscriber.receive(1000ms).has_value());
+  }
+  SUBCASE("replaced channel") {
+    // Subscriber does not remove the channel it has not created.
+    const std::filesystem::path storage_path{"test_events.ttdb"};
+    const auto path = data::events_path(storage_path);
+    {
+      const data::DataEventSubscriber subscriber{storage_path};
+      std::filesystem::remove(path);
+      std::ofstream{path} << "other";
+    }
+    CHECK(std::filesystem::exists(path));
+    std::filesystem::remove(path);
+  }
+  SUBCASE("invalid path") {
+    CHECK_THROWS_MSG(data::DataEventSubscriber{"/invalid/path/to/file.ttdb"},
+                     Exception,
+                     "Unable to bind the event channel");
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
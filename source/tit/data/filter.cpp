@@ -0,0 +1,223 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/simd.hpp"
+
+#include "tit/data/filter.hpp"
+#include "tit/data/type.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Group the bytes of the same significance of the consecutive scalars.
+void shuffle(std::span<byte_t> chunk, size_t width) {
+  const auto count = chunk.size() / width;
+  const std::vector<byte_t> copy(chunk.begin(), chunk.end());
+  for (size_t i = 0; i < count; ++i) {
+    for (size_t j = 0; j < width; ++j) {
+      chunk[j * count + i] = copy[i * width + j];
+    }
+  }
+}
+
+// Inverse of the `shuffle`.
+void unshuffle(std::span<byte_t> chunk, size_t width) {
+  const auto count = chunk.size() / width;
+  const std::vector<byte_t> copy(chunk.begin(), chunk.end());
+  for (size_t i = 0; i < count; ++i) {
+    for (size_t j = 0; j < width; ++j) {
+      chunk[i * width + j] = copy[j * count + i];
+    }
+  }
+}
+
+// Replace the scalars with the differences to the scalars that are @p stride
+// positions before, or do the inverse. Unsigned arithmetic makes the encoding
+// wrap around, so it is lossless for the signed integers as well.
+template<bool Encode, class UInt>
+void delta(std::span<byte_t> chunk, size_t stride) {
+  std::vector<UInt> nums(chunk.size() / sizeof(UInt));
+  std::memcpy(nums.data(), chunk.data(), nums.size() * sizeof(UInt));
+  if constexpr (Encode) {
+    for (size_t i = nums.size(); i > stride; --i) {
+      nums[i - 1] -= nums[i - 1 - stride];
+    }
+  } else {
+    for (size_t i = stride; i < nums.size(); ++i) nums[i] += nums[i - stride];
+  }
+  std::memcpy(chunk.data(), nums.data(), nums.size() * sizeof(UInt));
+}
+template<bool Encode>
+void delta(std::span<byte_t> chunk, DataType type) {
+  const auto stride = type.dim();
+  switch (type.kind().width()) {
+    case 1:  delta<Encode, uint8_t>(chunk, stride); break;
+    case 2:  delta<Encode, uint16_t>(chunk, stride); break;
+    case 4:  delta<Encode, uint32_t>(chunk, stride); break;
+    case 8:  delta<Encode, uint64_t>(chunk, stride); break;
+    default: TIT_THROW("Delta filter is not supported for '{}'.", type.name());
+  }
+}
+
+// Round the values to the multiples of the powers of two, so that the error
+// stays within the bound.
+template<std::floating_point Float>
+void quantize(ErrorBound bound, std::span<byte_t> data) {
+  // Absolute bound allows rounding to a fixed power of two. Relative bound
+  // allows keeping only the first `rel_digits` digits of the mantissa.
+  const auto abs_exp =
+      bound.absolute > 0.0 ?
+          std::optional{std::ilogb(2.0 * bound.absolute)} :
+          std::nullopt;
+  const auto rel_digits =
+      bound.relative > 0.0 ?
+          std::optional{std::max(
+              static_cast<int>(std::ceil(-std::log2(bound.relative))) - 1,
+              0)} :
+          std::nullopt;
+  if (!abs_exp.has_value() && !rel_digits.has_value()) return;
+
+  std::vector<Float> vals(data.size() / sizeof(Float));
+  std::memcpy(vals.data(), data.data(), vals.size() * sizeof(Float));
+  for (auto& val : vals) {
+    if (!std::isfinite(val) || val == Float{0}) continue;
+    auto exp = std::numeric_limits<int>::min();
+    if (abs_exp.has_value()) exp = *abs_exp;
+    if (rel_digits.has_value()) {
+      exp = std::max(exp, std::ilogb(val) - *rel_digits);
+    }
+    // Scaling by a power of two is exact. Values near the maximum may be
+    // rounded to infinity, those are kept as is.
+    const auto rounded = std::ldexp(std::round(std::ldexp(val, -exp)), exp);
+    if (std::isfinite(rounded)) val = rounded;
+  }
+  std::memcpy(data.data(), vals.data(), vals.size() * sizeof(Float));
+}
+
+// Call the function with the floating-point type of the data kind.
+template<class Func>
+void visit_float_kind(DataKind kind, Func func) {
+  using enum DataKind::ID;
+  switch (kind.id()) {
+    case float16:  func(std::type_identity<simd::float16_t>{}); break;
+    case bfloat16: func(std::type_identity<simd::bfloat16_t>{}); break;
+    case float32:  func(std::type_identity<float32_t>{}); break;
+    case float64:  func(std::type_identity<float64_t>{}); break;
+    default:
+      TIT_THROW("Precision conversion is not supported for '{}'.",
+                kind.name());
+  }
+}
+
+// Convert the floating-point values. Bytes need not be aligned, so they are
+// converted block by block through the typed buffers on the stack, within
+// a single pass over the data.
+template<class To, class From>
+void convert_precision(std::span<const byte_t> data, std::span<byte_t> result) {
+  static constexpr size_t BlockSize = 1024;
+  std::array<From, BlockSize> from{};
+  std::array<To, BlockSize> to{};
+  const auto size = data.size() / sizeof(From);
+  for (size_t first = 0; first < size; first += BlockSize) {
+    const auto count = std::min(BlockSize, size - first);
+    std::memcpy(from.data(),
+                data.data() + first * sizeof(From),
+                count * sizeof(From));
+    simd::convert(std::span<const From>{from.data(), count},
+                  std::span{to.data(), count});
+    std::memcpy(result.data() + first * sizeof(To),
+                to.data(),
+                count * sizeof(To));
+  }
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto default_filter(DataType type) -> DataFilter {
+  return type.kind().is_float() ? DataFilter::shuffle : DataFilter::delta;
+}
+
+void filter_encode(DataFilter filter, DataType type, std::span<byte_t> chunk) {
+  const auto width = type.kind().width();
+  TIT_ASSERT(chunk.size() % width == 0, "Chunk must contain whole scalars!");
+  switch (filter) {
+    case DataFilter::none: break;
+    case DataFilter::delta:
+      delta</*Encode=*/true>(chunk, type);
+      shuffle(chunk, width);
+      break;
+    case DataFilter::shuffle: shuffle(chunk, width); break;
+    default:                  TIT_THROW("Invalid data filter!");
+  }
+}
+
+void filter_decode(DataFilter filter, DataType type, std::span<byte_t> chunk) {
+  const auto width = type.kind().width();
+  TIT_ASSERT(chunk.size() % width == 0, "Chunk must contain whole scalars!");
+  switch (filter) {
+    case DataFilter::none: break;
+    case DataFilter::delta:
+      unshuffle(chunk, width);
+      delta</*Encode=*/false>(chunk, type);
+      break;
+    case DataFilter::shuffle: unshuffle(chunk, width); break;
+    default:                  TIT_THROW("Invalid data filter!");
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+void quantize(ErrorBound bound, DataType type, std::span<byte_t> data) {
+  TIT_ASSERT(bound.absolute >= 0.0, "Absolute error bound must be positive!");
+  TIT_ASSERT(bound.relative >= 0.0, "Relative error bound must be positive!");
+  TIT_ASSERT(data.size() % type.kind().width() == 0,
+             "Data must contain whole scalars!");
+  using enum DataKind::ID;
+  switch (type.kind().id()) {
+    case float32: quantize<float32_t>(bound, data); break;
+    case float64: quantize<float64_t>(bound, data); break;
+    default:
+      TIT_THROW("Lossy compression is not supported for '{}'.", type.name());
+  }
+}
+
+auto convert_precision(DataType type,
+                       DataKind kind,
+                       std::span<const byte_t> data) -> std::vector<byte_t> {
+  const auto from_width = type.kind().width();
+  TIT_ASSERT(data.size() % from_width == 0, "Data must contain whole scalars!");
+  std::vector<byte_t> result(data.size() / from_width * kind.width());
+  visit_float_kind(type.kind(), [kind, data, &result](auto from) {
+    visit_float_kind(kind, [data, &result](auto to) {
+      using From = decltype(from)::type;
+      using To = decltype(to)::type;
+      convert_precision<To, From>(data, result);
+    });
+  });
+  return result;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
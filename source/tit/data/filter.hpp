@@ -0,0 +1,83 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+
+#include "tit/data/type.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Lossless filter, applied to the data array chunks before compression.
+///
+/// Filters reorder or transform the bytes of the numerical data so that the
+/// similar bytes end up next to each other, which greatly improves the
+/// compression ratio. Filters operate on the independent chunks, so that
+/// each chunk could be decoded on its own.
+enum class DataFilter : uint8_t {
+  none,    ///< No filtering.
+  shuffle, ///< Byte shuffle of the scalar components.
+  delta,   ///< Delta encoding of the integer components, then byte shuffle.
+};
+
+/// Default filter for the data type: delta encoding for integers, and byte
+/// shuffle for floating-point numbers.
+auto default_filter(DataType type) -> DataFilter;
+
+/// Encode the chunk of the data of the given type in place.
+///
+/// Chunk must contain a whole number of the scalar components. Deltas are
+/// computed between the same components of the consecutive values.
+void filter_encode(DataFilter filter, DataType type, std::span<byte_t> chunk);
+
+/// Decode the chunk of the data of the given type in place.
+void filter_decode(DataFilter filter, DataType type, std::span<byte_t> chunk);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Error bound of the lossy data compression.
+///
+/// Each value `x` is replaced with `y`, such that
+/// `|y - x| <= max(absolute, relative * |x|)`.
+struct ErrorBound final {
+
+  /// Absolute error bound. Zero means no absolute bound.
+  float64_t absolute = 0.0;
+
+  /// Relative error bound. Zero means no relative bound.
+  float64_t relative = 0.0;
+
+}; // struct ErrorBound
+
+/// Quantize the floating-point data of the given type in place.
+///
+/// Values are rounded to the multiples of the largest power of two that keeps
+/// the error within the bound. Rounding clears the trailing mantissa bits,
+/// which are then compressed away by the byte shuffle and the compressor.
+/// Quantized data is still the ordinary floating-point data, so it is read
+/// back as usual. Infinite and NaN values are kept as is.
+void quantize(ErrorBound bound, DataType type, std::span<byte_t> data);
+
+/// Convert the floating-point data of the given type to a different
+/// precision, e.g. to store the compact 16-bit output arrays.
+///
+/// Values are rounded to the nearest representable ones, the conversion is
+/// vectorized, see `simd::convert`. Supported kinds are `float16`,
+/// `bfloat16`, `float32` and `float64`.
+///
+/// @returns Data of the type `type.with_kind(kind)`.
+auto convert_precision(DataType type,
+                       DataKind kind,
+                       std::span<const byte_t> data) -> std::vector<byte_t>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
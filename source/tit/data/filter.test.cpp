@@ -0,0 +1,185 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/simd.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/data/filter.hpp"
+#include "tit/data/type.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::default_filter") {
+  CHECK(data::default_filter(data::type_of<float64_t>) ==
+        data::DataFilter::shuffle);
+  CHECK(data::default_filter(data::type_of<Vec<float32_t, 3>>) ==
+        data::DataFilter::shuffle);
+  CHECK(data::default_filter(data::type_of<uint32_t>) ==
+        data::DataFilter::delta);
+  CHECK(data::default_filter(data::type_of<simd::float16_t>) ==
+        data::DataFilter::shuffle);
+}
+
+TEST_CASE("data::filter_encode") {
+  SUBCASE("shuffle") {
+    std::vector<uint16_t> vals{0x0102, 0x0304, 0x0506};
+    const auto chunk = std::as_writable_bytes(std::span{vals});
+    data::filter_encode(data::DataFilter::shuffle,
+                        data::type_of<uint16_t>,
+                        chunk);
+    // Low bytes go first on little-endian machines, high bytes next.
+    CHECK_RANGE_EQ(chunk,
+                   {byte_t{0x02},
+                    byte_t{0x04},
+                    byte_t{0x06},
+                    byte_t{0x01},
+                    byte_t{0x03},
+                    byte_t{0x05}});
+    data::filter_decode(data::DataFilter::shuffle,
+                        data::type_of<uint16_t>,
+                        chunk);
+    CHECK_RANGE_EQ(vals, {0x0102, 0x0304, 0x0506});
+  }
+  SUBCASE("delta") {
+    std::vector<Vec<int64_t, 2>> vals{{10, -1}, {12, -5}, {11, -100}};
+    const auto chunk = std::as_writable_bytes(std::span{vals});
+    const std::vector<byte_t> orig(chunk.begin(), chunk.end());
+    data::filter_encode(data::DataFilter::delta,
+                        data::type_of<Vec<int64_t, 2>>,
+                        chunk);
+    data::filter_decode(data::DataFilter::delta,
+                        data::type_of<Vec<int64_t, 2>>,
+                        chunk);
+    CHECK_RANGE_EQ(chunk, orig);
+  }
+  SUBCASE("none") {
+    std::vector<float64_t> vals{1.0, 2.0, 3.0};
+    const auto chunk = std::as_writable_bytes(std::span{vals});
+    data::filter_encode(data::DataFilter::none,
+                        data::type_of<float64_t>,
+                        chunk);
+    CHECK_RANGE_EQ(vals, {1.0, 2.0, 3.0});
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::quantize") {
+  std::vector<float64_t> orig(1000);
+  for (size_t i = 0; i < orig.size(); ++i) {
+    orig[i] = 100.0 * std::sin(0.1 * static_cast<float64_t>(i));
+  }
+  auto vals = orig;
+  const auto data = std::as_writable_bytes(std::span{vals});
+  SUBCASE("absolute") {
+    data::quantize({.absolute = 1.0e-3}, data::type_of<float64_t>, data);
+    for (size_t i = 0; i < vals.size(); ++i) {
+      CHECK(std::abs(vals[i] - orig[i]) <= 1.0e-3);
+      // Values are rounded to the multiples of 2^-9.
+      CHECK(std::ldexp(vals[i], 9) == std::round(std::ldexp(vals[i], 9)));
+    }
+  }
+  SUBCASE("relative") {
+    data::quantize({.relative = 1.0e-4}, data::type_of<float64_t>, data);
+    for (size_t i = 0; i < vals.size(); ++i) {
+      CHECK(std::abs(vals[i] - orig[i]) <= 1.0e-4 * std::abs(orig[i]));
+    }
+  }
+  SUBCASE("absolute and relative") {
+    data::quantize({.absolute = 1.0e-2, .relative = 1.0e-4},
+                   data::type_of<float64_t>,
+                   data);
+    for (size_t i = 0; i < vals.size(); ++i) {
+      CHECK(std::abs(vals[i] - orig[i]) <=
+            std::max(1.0e-2, 1.0e-4 * std::abs(orig[i])));
+    }
+  }
+  SUBCASE("no bound") {
+    data::quantize({}, data::type_of<float64_t>, data);
+    CHECK_RANGE_EQ(vals, orig);
+  }
+  SUBCASE("vectors") {
+    std::vector<Vec<float32_t, 2>> vecs{{1.2345F, -6.789F}, {0.0F, 1.0e6F}};
+    data::quantize({.absolute = 0.01},
+                   data::type_of<Vec<float32_t, 2>>,
+                   std::as_writable_bytes(std::span{vecs}));
+    CHECK(std::abs(vecs[0][0] - 1.2345F) <= 0.01F);
+    CHECK(std::abs(vecs[0][1] + 6.789F) <= 0.01F);
+    CHECK(vecs[1][0] == 0.0F);
+    CHECK(vecs[1][1] == 1.0e6F);
+  }
+  SUBCASE("special values") {
+    std::vector<float64_t> specials{
+        std::numeric_limits<float64_t>::infinity(),
+        std::numeric_limits<float64_t>::quiet_NaN(),
+        std::numeric_limits<float64_t>::max(),
+    };
+    data::quantize({.relative = 0.1},
+                   data::type_of<float64_t>,
+                   std::as_writable_bytes(std::span{specials}));
+    CHECK(std::isinf(specials[0]));
+    CHECK(std::isnan(specials[1]));
+    CHECK(std::isfinite(specials[2]));
+  }
+  SUBCASE("integers") {
+    std::vector<int32_t> ints{1, 2, 3};
+    CHECK_THROWS_MSG(data::quantize({.absolute = 1.0},
+                                    data::type_of<int32_t>,
+                                    std::as_writable_bytes(std::span{ints})),
+                     Exception,
+                     "not supported");
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::convert_precision") {
+  const std::vector<Vec<float64_t, 2>> vals{{1.0, -2.5}, {0.125, 1024.0}};
+  const auto type = data::type_of<Vec<float64_t, 2>>;
+  const auto bytes = std::as_bytes(std::span{vals});
+  SUBCASE("narrow") {
+    const auto half_kind = data::kind_of<simd::float16_t>;
+    const auto half_bytes = data::convert_precision(type, half_kind, bytes);
+    REQUIRE(half_bytes.size() == 4 * 2);
+
+    // Values are exactly representable, so they survive the round trip.
+    const auto result =
+        data::convert_precision(type.with_kind(half_kind),
+                                data::kind_of<float64_t>,
+                                half_bytes);
+    REQUIRE(result.size() == bytes.size());
+    CHECK(std::ranges::equal(result, bytes));
+  }
+  SUBCASE("same kind") {
+    const auto result =
+        data::convert_precision(type, data::kind_of<float64_t>, bytes);
+    CHECK(std::ranges::equal(result, bytes));
+  }
+  SUBCASE("unsupported") {
+    CHECK_THROWS_MSG(data::convert_precision(type,
+                                             data::kind_of<int32_t>,
+                                             bytes),
+                     Exception,
+                     "not supported for 'int32_t'");
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
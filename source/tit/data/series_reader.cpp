@@ -0,0 +1,143 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/par/control.hpp"
+
+#include "tit/data/series_reader.hpp"
+#include "tit/data/storage.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Move the data of the read data arrays into the prefetched arrays.
+template<class Contents>
+auto prefetched_arrays(std::vector<Contents>& contents)
+    -> std::vector<PrefetchedArray> {
+  std::vector<PrefetchedArray> arrays;
+  arrays.reserve(contents.size());
+  for (auto& item : contents) {
+    arrays.push_back({.name = std::move(item.name),
+                      .type = item.array.type(),
+                      .data = std::move(item.data)});
+  }
+  return arrays;
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+DataSeriesReader::DataSeriesReader(const DataStorage& storage,
+                                   DataSeriesID series_id,
+                                   size_t depth)
+    : slots_(depth) {
+  TIT_ASSERT(storage.check_series(series_id), "Invalid series ID!");
+  TIT_ASSERT(depth > 0, "Read-ahead depth must be positive!");
+  const auto path = storage.path();
+  if (path.empty()) TIT_THROW("Data series reader requires a storage file.");
+  for (const auto time_step_id : storage.series_time_step_ids(series_id)) {
+    time_step_ids_.push_back(time_step_id);
+  }
+
+  // Each thread reads a single time step at a time, so there is no need for
+  // more threads than the time steps that may be read ahead. Arrays of each
+  // time step are decompressed in parallel anyway.
+  const auto num_threads =
+      std::min({depth, time_step_ids_.size(), par::num_threads()});
+  threads_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads_.emplace_back([path, this] { run_(path); });
+  }
+}
+
+DataSeriesReader::~DataSeriesReader() {
+  {
+    const std::scoped_lock lock{mutex_};
+    stopped_ = true;
+  }
+  cond_.notify_all();
+  threads_.clear();
+}
+
+auto DataSeriesReader::num_time_steps() const noexcept -> size_t {
+  return time_step_ids_.size();
+}
+
+auto DataSeriesReader::next() -> std::optional<PrefetchedTimeStep> {
+  std::unique_lock lock{mutex_};
+  if (consumed_ == time_step_ids_.size()) return std::nullopt;
+  auto& slot = slots_[consumed_ % slots_.size()];
+  cond_.wait(lock, [&slot] {
+    return slot.time_step.has_value() || slot.error != nullptr;
+  });
+  auto result = std::exchange(slot, Slot_{});
+  consumed_ += 1;
+  lock.unlock();
+  cond_.notify_all();
+  if (result.error) std::rethrow_exception(result.error);
+  return std::move(result.time_step);
+}
+
+void DataSeriesReader::run_(const std::filesystem::path& path) {
+  std::optional<DataStorage> storage;
+  std::vector<DataArrayContents<const DataStorage>> uniforms;
+  std::vector<DataArrayContents<const DataStorage>> varyings;
+  while (true) {
+    // Take the next time step, once there is a free slot for it.
+    size_t index = 0;
+    {
+      std::unique_lock lock{mutex_};
+      cond_.wait(lock, [this] {
+        return stopped_ || next_index_ == time_step_ids_.size() ||
+               next_index_ < consumed_ + slots_.size();
+      });
+      if (stopped_ || next_index_ == time_step_ids_.size()) break;
+      index = next_index_++;
+    }
+
+    // Read the time step.
+    Slot_ slot;
+    try {
+      if (!storage.has_value()) storage.emplace(path, OpenMode::read_only);
+      const DataTimeStepView step{std::as_const(*storage),
+                                  time_step_ids_[index]};
+      step.uniforms().read_all(uniforms);
+      step.varyings().read_all(varyings);
+      slot.time_step = PrefetchedTimeStep{
+          .id = step.id(),
+          .time = step.time(),
+          .uniforms = prefetched_arrays(uniforms),
+          .varyings = prefetched_arrays(varyings),
+      };
+    } catch (...) {
+      slot.error = std::current_exception();
+    }
+
+    // Publish the time step.
+    {
+      const std::scoped_lock lock{mutex_};
+      slots_[index % slots_.size()] = std::move(slot);
+    }
+    cond_.notify_all();
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
@@ -0,0 +1,119 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+namespace tit::data {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Data of a data array of the prefetched time step.
+struct PrefetchedArray final {
+
+  /// Name of the data array.
+  std::string name;
+
+  /// Data type of the data array.
+  DataType type;
+
+  /// Data of the data array.
+  std::vector<byte_t> data;
+
+}; // struct PrefetchedArray
+
+/// Data of the prefetched time step.
+struct PrefetchedTimeStep final {
+
+  /// Time step ID.
+  DataTimeStepID id{0};
+
+  /// Time of the time step.
+  real_t time{};
+
+  /// Data of the uniform data arrays.
+  std::vector<PrefetchedArray> uniforms;
+
+  /// Data of the varying data arrays.
+  std::vector<PrefetchedArray> varyings;
+
+}; // struct PrefetchedTimeStep
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Prefetching reader of the time steps of a data series.
+///
+/// Time steps are read in order by the background threads, each with its own
+/// read-only connection to the storage, while the consumer processes the
+/// current one. At most @p depth time steps are read ahead of the consumer,
+/// so the memory is bounded by the size of `depth + 1` time steps. Time steps
+/// of the series are collected when the reader is constructed, the ones that
+/// are added later are not read.
+class DataSeriesReader final {
+public:
+
+  /// Default number of the time steps that are read ahead.
+  static constexpr size_t DefaultDepth = 2;
+
+  /// Start reading the data series of the storage. Storage must be stored
+  /// in a file, since the reader threads open their own connections to it.
+  DataSeriesReader(const DataStorage& storage,
+                   DataSeriesID series_id,
+                   size_t depth = DefaultDepth);
+
+  /// Data series reader is not copyable or movable.
+  TIT_NOT_COPYABLE_OR_MOVABLE(DataSeriesReader);
+
+  /// Stop reading, and wait for the reader threads to finish.
+  ~DataSeriesReader();
+
+  /// Number of the time steps to read.
+  auto num_time_steps() const noexcept -> size_t;
+
+  /// Get the next time step, waiting for it to be read. Null result is
+  /// returned once all the time steps are consumed. Exceptions thrown while
+  /// reading the time step are rethrown here.
+  auto next() -> std::optional<PrefetchedTimeStep>;
+
+private:
+
+  // Time step that was read, or the exception thrown while reading it.
+  struct Slot_ {
+    std::optional<PrefetchedTimeStep> time_step;
+    std::exception_ptr error;
+  };
+
+  // Read the time steps, until all of them are assigned or the reader is
+  // stopped.
+  void run_(const std::filesystem::path& path);
+
+  std::vector<DataTimeStepID> time_step_ids_;
+  std::vector<Slot_> slots_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  size_t next_index_ = 0;
+  size_t consumed_ = 0;
+  bool stopped_ = false;
+  std::vector<std::jthread> threads_;
+
+}; // class DataSeriesReader
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::data
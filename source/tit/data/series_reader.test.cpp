@@ -0,0 +1,76 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+
+#include "tit/data/series_reader.hpp"
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::DataSeriesReader") {
+  const std::filesystem::path file_name{"test_series_reader.ttdb"};
+  std::filesystem::remove(file_name);
+  data::DataStorage storage{file_name};
+  const auto series = storage.create_series("");
+  constexpr size_t NumTimeSteps = 10;
+  for (size_t i = 0; i < NumTimeSteps; ++i) {
+    const auto step = series.create_time_step(static_cast<real_t>(i));
+    step.uniforms().create_array("n", std::vector{i});
+    const std::vector vals(100, static_cast<float64_t>(i));
+    step.varyings().create_array("v", vals);
+  }
+  SUBCASE("read all") {
+    // Ensure the time steps are read in order, whatever the read-ahead depth.
+    for (const auto depth : {size_t{1}, size_t{3}, size_t{16}}) {
+      data::DataSeriesReader reader{storage, series, depth};
+      REQUIRE(reader.num_time_steps() == NumTimeSteps);
+      for (size_t i = 0; i < NumTimeSteps; ++i) {
+        const auto step = reader.next();
+        REQUIRE(step.has_value());
+        CHECK(step->time == static_cast<real_t>(i));
+        REQUIRE(step->uniforms.size() == 1);
+        CHECK(step->uniforms[0].name == "n");
+        REQUIRE(step->varyings.size() == 1);
+        const auto& v = step->varyings[0];
+        CHECK(v.name == "v");
+        CHECK(v.type == data::type_of<float64_t>);
+        REQUIRE(v.data.size() == 100 * sizeof(float64_t));
+        float64_t val{};
+        std::memcpy(&val, v.data.data(), sizeof(val));
+        CHECK(val == static_cast<float64_t>(i));
+      }
+      CHECK_FALSE(reader.next().has_value());
+    }
+  }
+  SUBCASE("stop early") {
+    // Ensure the reader is stopped while the time steps are still pending.
+    data::DataSeriesReader reader{storage, series};
+    REQUIRE(reader.next().has_value());
+  }
+  SUBCASE("in-memory") {
+    data::DataStorage memory_storage{":memory:"};
+    const auto memory_series = memory_storage.create_series("");
+    CHECK_THROWS_MSG(data::DataSeriesReader(memory_storage, memory_series),
+                     Exception,
+                     "Data series reader requires a storage file.");
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -6,12 +6,16 @@
 #include <algorithm>
 #include <bit>
 #include <cctype>
+#include <chrono>
+#include <exception>
 #include <filesystem>
 #include <format>
 #include <limits>
+#include <memory>
 #include <span>
 #include <string>
 #include <string_view>
+#include <utility>
 
 #include <sqlite3.h>
 
@@ -41,12 +45,13 @@ auto error_message(int status, sqlite3* db = nullptr) -> std::string {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-Database::Database(const std::filesystem::path& path) {
+Database::Database(const std::filesystem::path& path, bool read_only) {
   sqlite3* db = nullptr;
   if (const auto status = sqlite3_open_v2( //
           path.c_str(),
           &db,
-          SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+          read_only ? SQLITE_OPEN_READONLY :
+                      SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
           nullptr);
       status != SQLITE_OK) {
     TIT_THROW("SQLite database open failed ({}): {}",
@@ -78,6 +83,18 @@ auto Database::path() const -> std::filesystem::path {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+void Database::set_busy_timeout(std::chrono::milliseconds timeout) const {
+  TIT_ASSERT(timeout.count() >= 0, "Busy timeout must be non-negative!");
+  const auto ms = std::min<int64_t>(timeout.count(),
+                                    std::numeric_limits<int>::max());
+  if (const auto status = sqlite3_busy_timeout(base(), static_cast<int>(ms));
+      status != SQLITE_OK) {
+    TIT_THROW("SQLite busy timeout setup failed ({}): {}",
+              status,
+              error_message(status, base()));
+  }
+}
+
 void Database::execute(CStrView sql) const {
   char* error_message = nullptr;
   if (const auto status = sqlite3_exec(base(),
@@ -99,14 +116,44 @@ auto Database::last_insert_row_id() const -> RowID {
   return sqlite3_last_insert_rowid(base());
 }
 
+auto Database::in_transaction() const noexcept -> bool {
+  return sqlite3_get_autocommit(base()) == 0;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-Statement::Statement(Database& db, std::string_view sql) : db_{&db} {
+void Database::Finalizer_::operator()(sqlite3_stmt* stmt) {
+  if (const auto status = sqlite3_finalize(stmt); status != SQLITE_OK) {
+    // `sqlite3_finalize` returns an error code if any usage of the statement
+    // resulted in an error, so we've must have already thrown an exception.
+    // So, let's just log the error here and return peacefully.
+    TIT_ERROR("SQLite statement close failed ({}): {}",
+              status,
+              error_message(status));
+  }
+}
+
+auto Database::acquire_statement_(std::string_view sql)
+    -> std::pair<sqlite3_stmt*, CacheSlot_*> {
   TIT_ASSERT(!sql.empty(), "SQL statement is null!");
   TIT_ASSERT(sql.size() <= std::numeric_limits<int>::max(), "SQL is too big!");
 
+  // Reuse the cached statement, if any. Slots are never removed from the
+  // cache, so the pointers to them remain valid.
+  auto iter = statement_cache_.find(sql);
+  if (iter == statement_cache_.end()) {
+    iter = statement_cache_.try_emplace(std::string{sql}).first;
+  }
+  auto& slot = iter->second;
+  if (!slot.empty()) {
+    auto* const stmt = slot.back().release();
+    slot.pop_back();
+    return {stmt, &slot};
+  }
+
+  // Prepare a new statement.
   sqlite3_stmt* stmt = nullptr;
-  if (const auto status = sqlite3_prepare_v3(db_->base(),
+  if (const auto status = sqlite3_prepare_v3(base(),
                                              sql.data(),
                                              static_cast<int>(sql.size()),
                                              SQLITE_PREPARE_PERSISTENT,
@@ -116,22 +163,41 @@ Statement::Statement(Database& db, std::string_view sql) : db_{&db} {
     TIT_THROW("SQLite statement '{}' prepare failed ({}): {}",
               sql,
               status,
-              error_message(status, db_->base()));
+              error_message(status, base()));
+  }
+  return {stmt, &slot};
+}
+
+void Database::release_statement_(CacheSlot_* slot,
+                                  sqlite3_stmt* stmt) noexcept {
+  TIT_ASSERT(slot != nullptr, "Cache slot is null!");
+  if (stmt == nullptr) return;
+  std::unique_ptr<sqlite3_stmt, Finalizer_> cached_stmt{stmt};
+
+  // Errors of the last step were already reported, so the status is ignored.
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+  try {
+    slot->push_back(std::move(cached_stmt));
+  } catch (const std::exception& e) {
+    // Statement is finalized if it cannot be cached.
+    TIT_ERROR("Failed to cache SQLite statement: {}", e.what());
   }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+Statement::Statement(Database& db, std::string_view sql)
+    : Statement{db, db.acquire_statement_(sql)} {}
 
-  stmt_.reset(stmt);
+Statement::Statement(Database& db,
+                     std::pair<sqlite3_stmt*, Database::CacheSlot_*> stmt)
+    : db_{&db}, stmt_{stmt.first, Releaser_{stmt.second}} {
   state_ = State_::prepared;
 }
 
-void Statement::Finalizer_::operator()(sqlite3_stmt* stmt) {
-  if (const auto status = sqlite3_finalize(stmt); status != SQLITE_OK) {
-    // `sqlite3_finalize` returns an error code if any usage of the statement
-    // resulted in an error, so we've must have already thrown an exception.
-    // So, let's just log the error here and return peacefully.
-    TIT_ERROR("SQLite statement close failed ({}): {}",
-              status,
-              error_message(status));
-  }
+void Statement::Releaser_::operator()(sqlite3_stmt* stmt) const noexcept {
+  Database::release_statement_(slot, stmt);
 }
 
 auto Statement::base() const noexcept -> sqlite3_stmt* {
@@ -340,11 +406,12 @@ auto Statement::column_blob_(size_t index) const -> BlobView {
 BlobReader::BlobReader(const Database& db,
                        CStrView table_name,
                        CStrView column_name,
-                       RowID row_id)
+                       RowID row_id,
+                       CStrView schema_name)
     : db_{&db} {
   sqlite3_blob* blob = nullptr;
   if (const auto status = sqlite3_blob_open(db.base(),
-                                            "main",
+                                            schema_name.c_str(),
                                             table_name.c_str(),
                                             column_name.c_str(),
                                             row_id,
@@ -400,11 +467,12 @@ auto BlobReader::read(std::span<byte_t> data) -> size_t {
 BlobWriter::BlobWriter(Database& db,
                        std::string_view table_name,
                        std::string_view column_name,
-                       RowID row_id)
-    : db_{&db}, //
-      table_name_{table_name}, column_name_{column_name}, row_id_{row_id} {
+                       RowID row_id,
+                       size_t size)
+    : db_{&db}, size_{size} {
   TIT_ASSERT(!table_name.empty(), "Table name is empty!");
   TIT_ASSERT(!column_name.empty(), "Column name is empty!");
+  TIT_ASSERT(size <= std::numeric_limits<int>::max(), "Blob is too large!");
 
   // Validate the table and column names to avoid SQL injection.
   constexpr auto is_valid_char = [](char c) {
@@ -416,20 +484,75 @@ BlobWriter::BlobWriter(Database& db,
   if (!std::ranges::all_of(column_name, is_valid_char)) {
     TIT_THROW("Invalid column name: '{}'.", column_name);
   }
+
+  // Reserve the blob. SQLite blobs cannot be resized through the blob handle,
+  // so the size must be known upfront.
+  // Note: we cannot set table and column names as arguments, so we have to
+  //       construct the SQL statement code manually.
+  const auto sql = std::format("UPDATE {} SET {} = zeroblob(?) WHERE rowid = ?",
+                               table_name,
+                               column_name);
+  Statement statement{db, sql};
+  statement.run(size, row_id);
+
+  // Open the reserved blob for writing.
+  const std::string table_name_str{table_name};
+  const std::string column_name_str{column_name};
+  sqlite3_blob* blob = nullptr;
+  if (const auto status = sqlite3_blob_open(db.base(),
+                                            "main",
+                                            table_name_str.c_str(),
+                                            column_name_str.c_str(),
+                                            row_id,
+                                            /*flags=*/1,
+                                            &blob);
+      status != SQLITE_OK) {
+    TIT_THROW("SQLite blob open failed ({}): {}",
+              status,
+              error_message(status, db.base()));
+  }
+
+  blob_.reset(blob);
+}
+
+void BlobWriter::Finalizer_::operator()(sqlite3_blob* blob) {
+  const auto status = sqlite3_blob_close(blob);
+  if (status != SQLITE_OK) {
+    // Let's not throw in destructors.
+    TIT_ERROR("SQLite blob close failed ({}): {}",
+              status,
+              error_message(status));
+  }
+}
+
+auto BlobWriter::base() const noexcept -> sqlite3_blob* {
+  TIT_ASSERT(blob_.get() != nullptr, "Blob was moved away!");
+  return blob_.get();
 }
 
 void BlobWriter::write(std::span<const byte_t> data) {
-  buffer_.insert(buffer_.end(), data.begin(), data.end());
+  TIT_ASSERT(offset_ <= size_, "Offset is out of range!");
+  if (data.size() > size_ - offset_) {
+    TIT_THROW("SQLite blob write of {} bytes exceeds the reserved size {}.",
+              offset_ + data.size(),
+              size_);
+  }
+  if (data.empty()) return;
+  if (const auto status = sqlite3_blob_write(base(),
+                                             data.data(),
+                                             static_cast<int>(data.size()),
+                                             static_cast<int>(offset_));
+      status != SQLITE_OK) {
+    TIT_THROW("SQLite blob write failed ({}): {}",
+              status,
+              error_message(status, db_->base()));
+  }
+
+  offset_ += data.size();
 }
 
 void BlobWriter::flush() {
-  // Note: we cannot set table and column names as arguments, so we have to
-  //       construct the SQL statement code manually.
-  const auto sql = std::format("UPDATE {} SET {} = ? WHERE rowid = ?",
-                               table_name_,
-                               column_name_);
-  Statement statement{*db_, sql};
-  statement.run(buffer_, row_id_);
+  // Bytes are written to the blob directly, nothing to flush.
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <concepts>
 #include <filesystem>
 #include <memory>
@@ -13,6 +14,7 @@
 #include <string>
 #include <string_view>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
@@ -26,19 +28,24 @@ struct sqlite3_blob;
 
 namespace tit::data::sqlite {
 
+class Statement;
+
 /// SQLite row ID type.
 using RowID = int64_t;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// SQLite database.
+///
+/// Database keeps a cache of the prepared statements, keyed by their SQL, so
+/// that the statements that are executed repeatedly are parsed only once.
 class Database final {
 public:
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-  /// Open or create a database file.
-  explicit Database(const std::filesystem::path& path);
+  /// Open or create a database file. Read-only database must exist.
+  explicit Database(const std::filesystem::path& path, bool read_only = false);
 
   /// SQLite database object.
   auto base() const noexcept -> sqlite3*;
@@ -48,21 +55,46 @@ public:
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+  /// Set the time to wait for the locks held by the other connections,
+  /// before the operations fail as busy.
+  void set_busy_timeout(std::chrono::milliseconds timeout) const;
+
   /// Execute a SQL statement.
   void execute(CStrView sql) const;
 
   /// Get the last insert row ID.
   auto last_insert_row_id() const -> RowID;
 
+  /// Check if a transaction is open, that is, the database is not in the
+  /// autocommit mode.
+  auto in_transaction() const noexcept -> bool;
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 private:
 
+  friend class Statement;
+
   struct Closer_ final {
     static void operator()(sqlite3* db);
   };
 
+  struct Finalizer_ final {
+    static void operator()(sqlite3_stmt* stmt);
+  };
+
+  using CacheSlot_ = std::vector<std::unique_ptr<sqlite3_stmt, Finalizer_>>;
+
+  // Take the prepared statement from the cache, or prepare a new one.
+  auto acquire_statement_(std::string_view sql)
+      -> std::pair<sqlite3_stmt*, CacheSlot_*>;
+
+  // Reset the statement and return it to the cache slot.
+  static void release_statement_(CacheSlot_* slot,
+                                 sqlite3_stmt* stmt) noexcept;
+
   std::unique_ptr<sqlite3, Closer_> db_;
+  StrHashMap<CacheSlot_> statement_cache_;
 
 }; // class Database
 
@@ -199,6 +231,8 @@ public:
 
 private:
 
+  friend class Database;
+
   enum class State_ : uint8_t {
     invalid,
     prepared,
@@ -206,10 +240,15 @@ private:
     finished,
   };
 
-  struct Finalizer_ final {
-    static void operator()(sqlite3_stmt* stmt);
+  struct Releaser_ final {
+    Database::CacheSlot_* slot;
+    void operator()(sqlite3_stmt* stmt) const noexcept;
   };
 
+  // Construct a statement from the acquired cached statement.
+  Statement(Database& db,
+            std::pair<sqlite3_stmt*, Database::CacheSlot_*> stmt);
+
   // Bind the statement arguments.
   auto num_params_() const -> size_t;
   void bind_(size_t index, int64_t value) const;
@@ -226,7 +265,7 @@ private:
   auto column_blob_(size_t index) const -> BlobView;
 
   Database* db_;
-  std::unique_ptr<sqlite3_stmt, Finalizer_> stmt_;
+  std::unique_ptr<sqlite3_stmt, Releaser_> stmt_;
   State_ state_ = State_::invalid;
 
 }; // class Statement
@@ -237,11 +276,13 @@ private:
 class BlobReader final : public InputStream<byte_t> {
 public:
 
-  /// Open a blob from a database.
+  /// Open a blob from a database. Tables of the attached databases are
+  /// accessed through their schema names.
   BlobReader(const Database& db,
              CStrView table_name,
              CStrView column_name,
-             RowID row_id);
+             RowID row_id,
+             CStrView schema_name = "main");
 
   /// SQLite blob object.
   auto base() const noexcept -> sqlite3_blob*;
@@ -266,21 +307,37 @@ private:
 constexpr auto make_blob_reader(const Database& db,
                                 CStrView table_name,
                                 CStrView column_name,
-                                RowID row_id) -> InputStreamPtr<byte_t> {
-  return std::make_unique<BlobReader>(db, table_name, column_name, row_id);
+                                RowID row_id,
+                                CStrView schema_name = "main")
+    -> InputStreamPtr<byte_t> {
+  return std::make_unique<BlobReader>(db,
+                                      table_name,
+                                      column_name,
+                                      row_id,
+                                      schema_name);
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// SQLite blob writer.
+///
+/// Blob of the given size is reserved in the database on construction, and
+/// the written bytes are streamed into it directly, so that the blob is never
+/// accumulated in memory. Reserved bytes that are not written are zero. Row
+/// must not be modified while the writer is alive, since SQLite invalidates
+/// the open blob handles on row modification.
 class BlobWriter final : public OutputStream<byte_t> {
 public:
 
-  /// Open a blob in a database.
+  /// Reserve a blob of the given size in a database and open it for writing.
   BlobWriter(Database& db,
              std::string_view table_name,
              std::string_view column_name,
-             RowID row_id);
+             RowID row_id,
+             size_t size);
+
+  /// SQLite blob object.
+  auto base() const noexcept -> sqlite3_blob*;
 
   /// Write the next bytes to the blob.
   void write(std::span<const byte_t> data) override;
@@ -290,11 +347,14 @@ public:
 
 private:
 
+  struct Finalizer_ final {
+    static void operator()(sqlite3_blob* blob);
+  };
+
   Database* db_;
-  std::string table_name_;
-  std::string column_name_;
-  RowID row_id_;
-  std::vector<byte_t> buffer_;
+  std::unique_ptr<sqlite3_blob, Finalizer_> blob_;
+  size_t size_ = 0;
+  size_t offset_ = 0;
 
 }; // class BlobWriter
 
@@ -302,8 +362,9 @@ private:
 constexpr auto make_blob_writer(Database& db,
                                 std::string_view table_name,
                                 std::string_view column_name,
-                                RowID row_id) -> OutputStreamPtr<byte_t> {
-  return make_flushable<BlobWriter>(db, table_name, column_name, row_id);
+                                RowID row_id,
+                                size_t size) -> OutputStreamPtr<byte_t> {
+  return make_flushable<BlobWriter>(db, table_name, column_name, row_id, size);
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
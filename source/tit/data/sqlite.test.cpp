@@ -8,6 +8,7 @@
 #include <numbers>
 #include <ranges>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
@@ -115,6 +116,15 @@ TEST_CASE("data::sqlite::Database::last_insert_row_id") {
   CHECK(db.last_insert_row_id() == 3);
 }
 
+TEST_CASE("data::sqlite::Database::in_transaction") {
+  const data::sqlite::Database db{":memory:"};
+  CHECK_FALSE(db.in_transaction());
+  db.execute("SAVEPOINT test");
+  CHECK(db.in_transaction());
+  db.execute("RELEASE test");
+  CHECK_FALSE(db.in_transaction());
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("data::sqlite::Statement") {
@@ -124,6 +134,27 @@ TEST_CASE("data::sqlite::Statement") {
     const data::sqlite::Statement s{db, "INSERT INTO test (id) VALUES (?)"};
     CHECK(s.base() != nullptr);
   }
+  SUBCASE("cache") {
+    constexpr std::string_view sql = "SELECT id FROM test WHERE id = ?";
+    const auto* stmt = [&db, sql] {
+      data::sqlite::Statement s{db, sql};
+      s.bind(1);
+      CHECK_FALSE(s.step());
+      return s.base();
+    }();
+    {
+      // Released statement is reused, with the bindings cleared.
+      data::sqlite::Statement s_1{db, sql};
+      CHECK(s_1.base() == stmt);
+      // Statement with the same SQL that is still in use is not reused.
+      const data::sqlite::Statement s_2{db, sql};
+      CHECK(s_2.base() != stmt);
+      db.execute("INSERT INTO test (id) VALUES (1)");
+      s_1.bind(1);
+      REQUIRE(s_1.step());
+      CHECK(s_1.column<int>() == 1);
+    }
+  }
   SUBCASE("failure") {
     SUBCASE("invalid SQL") {
       CHECK_THROWS_MSG(data::sqlite::Statement(db, "INVALID SQL"),
@@ -333,17 +364,24 @@ TEST_CASE("data::sqlite::BlobWriter") {
     ) STRICT;
     INSERT INTO Constants (id) VALUES (1);
   )SQL");
+  const auto read_value = [&db] {
+    data::sqlite::Statement statement{db, R"SQL(
+      SELECT value FROM Constants WHERE id = 1
+    )SQL"};
+    REQUIRE(statement.step());
+    return statement.column<Blob>();
+  };
   SUBCASE("success") {
     SUBCASE("single write") {
-      const auto run_writer = [&db](auto value) {
-        data::sqlite::make_blob_writer(db, "Constants", "value", 1)
-            ->write(to_byte_array(value));
-
-        data::sqlite::Statement statement{db, R"SQL(
-          SELECT value FROM Constants WHERE id = 1
-        )SQL"};
-        REQUIRE(statement.step());
-        CHECK(statement.column<Blob>() == to_bytes(value));
+      const auto run_writer = [&db, &read_value](auto value) {
+        const auto bytes = to_byte_array(value);
+        data::sqlite::make_blob_writer(db,
+                                       "Constants",
+                                       "value",
+                                       1,
+                                       bytes.size())
+            ->write(bytes);
+        CHECK(read_value() == to_bytes(value));
       };
       SUBCASE("write") {
         run_writer(std::numbers::pi);
@@ -355,55 +393,67 @@ TEST_CASE("data::sqlite::BlobWriter") {
       }
     }
     SUBCASE("empty") {
-      data::sqlite::make_blob_writer(db, "Constants", "value", 1)->flush();
-      data::sqlite::Statement statement{db, R"SQL(
-        SELECT value FROM Constants WHERE id = 1
-      )SQL"};
-      REQUIRE(statement.step());
-      CHECK(statement.column<Blob>().empty());
+      data::sqlite::make_blob_writer(db, "Constants", "value", 1, 0)->flush();
+      CHECK(read_value().empty());
     }
     SUBCASE("multiple writes") {
-      auto writer = data::sqlite::make_blob_writer(db, "Constants", "value", 1);
+      const auto size = sizeof(float) + sizeof(long double) + sizeof(double);
+      auto writer =
+          data::sqlite::make_blob_writer(db, "Constants", "value", 1, size);
       writer->write(to_byte_array(std::numbers::pi_v<float>));
       writer->flush();
       writer->write(to_byte_array(std::numbers::e_v<long double>));
       writer->write(to_byte_array(std::numbers::phi_v<double>));
       writer->flush();
-      data::sqlite::Statement statement{db, R"SQL(
-        SELECT value FROM Constants WHERE id = 1
-      )SQL"};
-      REQUIRE(statement.step());
-      CHECK_RANGE_EQ(statement.column<Blob>(),
+      CHECK_RANGE_EQ(read_value(),
                      std::vector{to_bytes(std::numbers::pi_v<float>),
                                  to_bytes(std::numbers::e_v<long double>),
                                  to_bytes(std::numbers::phi_v<double>)} |
                          std::views::join);
     }
+    SUBCASE("partial write") {
+      // Ensure the bytes that were not written are zero.
+      data::sqlite::make_blob_writer(db, "Constants", "value", 1, 4)
+          ->write(to_byte_array(uint8_t{0xFF}));
+      CHECK(read_value() == Blob{byte_t{0xFF}, {}, {}, {}});
+    }
   }
   SUBCASE("failure") {
     SUBCASE("SQL injection") {
       CHECK_THROWS_MSG(
-          data::sqlite::make_blob_writer(db, "DROP TABLE", "value", 1),
+          data::sqlite::make_blob_writer(db, "DROP TABLE", "value", 1, 0),
           Exception,
           "Invalid table name");
       CHECK_THROWS_MSG(
-          data::sqlite::make_blob_writer(db, "Constants", "DROP COLUMN", 1),
+          data::sqlite::make_blob_writer(db, "Constants", "DROP COLUMN", 1, 0),
           Exception,
           "Invalid column name");
     }
     SUBCASE("invalid table name") {
       CHECK_THROWS_MSG(
-          data::sqlite::make_blob_writer(db, "invalid", "value", 1)->flush(),
+          data::sqlite::make_blob_writer(db, "invalid", "value", 1, 0),
           Exception,
           "no such table");
     }
     SUBCASE("invalid column name") {
       CHECK_THROWS_MSG(
-          data::sqlite::make_blob_writer(db, "Constants", "invalid", 1)
-              ->flush(),
+          data::sqlite::make_blob_writer(db, "Constants", "invalid", 1, 0),
           Exception,
           "no such column");
     }
+    SUBCASE("invalid row ID") {
+      CHECK_THROWS_MSG(
+          data::sqlite::make_blob_writer(db, "Constants", "value", 100, 0),
+          Exception,
+          "no such row");
+    }
+    SUBCASE("write out of range") {
+      auto writer =
+          data::sqlite::make_blob_writer(db, "Constants", "value", 1, 4);
+      CHECK_THROWS_MSG(writer->write(to_byte_array(std::numbers::pi)),
+                       Exception,
+                       "exceeds the reserved size");
+    }
   }
 }
 
@@ -3,18 +3,48 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <exception>
 #include <filesystem>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <ranges>
 #include <span>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <tuple>
 #include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#endif
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/exception.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/str_utils.hpp"
 #include "tit/core/stream.hpp"
+#include "tit/core/sys/utils.hpp"
+#include "tit/core/uint_utils.hpp"
+#include "tit/core/utils.hpp"
 
+#include "tit/data/filter.hpp"
 #include "tit/data/sqlite.hpp"
 #include "tit/data/storage.hpp"
 #include "tit/data/type.hpp"
@@ -24,9 +54,547 @@ namespace tit::data {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-DataStorage::DataStorage(const std::filesystem::path& path) : db_{path} {
+namespace {
+
+// Size of the independently compressed chunk of the data array, in bytes.
+constexpr size_t ArrayChunkSize = 1024 * 1024;
+
+// Size of the compressed data array that is kept in memory while writing, in
+// bytes. Larger compressed data is spooled to a temporary file.
+constexpr size_t ArraySpoolThreshold = 4 * ArrayChunkSize;
+
+// Number of the data arrays with the same name, that are used to train
+// the compression dictionary.
+constexpr size_t DictTrainingArrays = 4;
+
+// Maximum size of the training data that is taken from a single data array,
+// and the size of a single training sample, in bytes.
+constexpr size_t DictArraySamplesSize = 1024 * 1024;
+constexpr size_t DictSampleSize = 16 * 1024;
+
+// Maximum size of the compression dictionary, in bytes.
+constexpr size_t DictMaxSize = 64 * 1024;
+
+// Output stream that compresses the data array in independent chunks. Each
+// chunk is filtered and then compressed into a separate ZSTD frame, so that
+// the whole data could still be decompressed as a single stream. Offsets of
+// the chunks are stored next to the data as pairs of the uncompressed and
+// the compressed offsets. If the compression dictionary is given, all chunks
+// are compressed with it. Compressed data that exceeds the spool threshold
+// is moved to a temporary file, and streamed into the blob on flush.
+class ChunkedArrayWriter final : public OutputStream<byte_t> {
+public:
+
+  ChunkedArrayWriter(sqlite::Database& db,
+                     DataArrayID array_id,
+                     DataType type,
+                     DataFilter filter,
+                     int level,
+                     size_t num_workers,
+                     sqlite::RowID dict_id,
+                     std::vector<byte_t> dictionary)
+      : db_{&db}, array_id_{array_id}, type_{type}, filter_{filter},
+        level_{level}, num_workers_{num_workers}, dict_id_{dict_id},
+        dictionary_{std::move(dictionary)} {}
+
+  void write(std::span<const byte_t> data) override {
+    if (chunk_.capacity() == 0) chunk_.reserve(ArrayChunkSize);
+    while (!data.empty()) {
+      const auto copied =
+          std::min(ArrayChunkSize - chunk_.size(), data.size());
+      chunk_.insert(chunk_.end(), data.begin(), data.begin() + copied);
+      data = data.subspan(copied);
+      if (chunk_.size() == ArrayChunkSize) compress_chunk_();
+    }
+  }
+
+  void flush() override {
+    compress_chunk_();
+    if (!modified_) return;
+
+    // Stream the compressed data into the reserved blob. Blob writer must be
+    // closed before the row is updated, since the update invalidates it.
+    {
+      sqlite::BlobWriter blob{*db_,
+                              "DataArrays",
+                              "data",
+                              array_id_.get(),
+                              spooled_size_ + compressed_.size()};
+      if (spooled_size_ != 0) {
+        std::rewind(spool_.get());
+        std::vector<byte_t> buffer(ArrayChunkSize);
+        for (size_t offset = 0; offset < spooled_size_;) {
+          const auto count = std::min(buffer.size(), spooled_size_ - offset);
+          if (std::fread(buffer.data(), 1, count, spool_.get()) != count) {
+            TIT_THROW("Unable to read the data array spool file!");
+          }
+          blob.write(std::span{buffer}.first(count));
+          offset += count;
+        }
+        if (std::fseek(spool_.get(), 0, SEEK_END) != 0) {
+          TIT_THROW("Unable to seek the data array spool file!");
+        }
+      }
+      blob.write(compressed_);
+    }
+
+    sqlite::Statement statement{*db_, R"SQL(
+      UPDATE DataArrays
+      SET chunks = ?, filter = ?, dict_id = nullif(?, 0),
+          payload_offset = NULL, payload_size = NULL
+      WHERE id = ?
+    )SQL"};
+    statement.run(std::as_bytes(std::span{chunk_offsets_}),
+                  std::to_underlying(filter_),
+                  dict_id_,
+                  array_id_.get());
+    modified_ = false;
+  }
+
+private:
+
+  void compress_chunk_() {
+    if (chunk_.empty()) return;
+    chunk_offsets_.push_back(uncompressed_size_);
+    chunk_offsets_.push_back(spooled_size_ + compressed_.size());
+    filter_encode(filter_, type_, chunk_);
+    zstd::compress(chunk_, compressed_, level_, num_workers_, dictionary_);
+    uncompressed_size_ += chunk_.size();
+    chunk_.clear();
+    modified_ = true;
+    if (compressed_.size() >= ArraySpoolThreshold) spool_chunks_();
+  }
+
+  // Move the compressed chunks from memory to the spool file, so that the
+  // memory usage does not grow with the data array size.
+  void spool_chunks_() {
+    if (spool_ == nullptr) {
+      spool_.reset(std::tmpfile());
+      if (spool_ == nullptr) {
+        TIT_THROW("Unable to create the data array spool file!");
+      }
+    }
+    if (std::fwrite(compressed_.data(), 1, compressed_.size(), spool_.get()) !=
+        compressed_.size()) {
+      TIT_THROW("Unable to write the data array spool file!");
+    }
+    spooled_size_ += compressed_.size();
+    compressed_.clear();
+  }
+
+  sqlite::Database* db_;
+  DataArrayID array_id_;
+  DataType type_;
+  DataFilter filter_;
+  int level_;
+  size_t num_workers_;
+  sqlite::RowID dict_id_;
+  std::vector<byte_t> dictionary_;
+  std::vector<byte_t> chunk_;
+  std::vector<byte_t> compressed_;
+  FilePtr spool_;
+  size_t spooled_size_ = 0;
+  std::vector<uint64_t> chunk_offsets_;
+  uint64_t uncompressed_size_ = 0;
+  bool modified_ = true;
+
+}; // class ChunkedArrayWriter
+
+// Input stream that decodes the filtered chunks of the data array. Chunks
+// are of the fixed size, except for the last one, unless their sizes are
+// given, as for the partitioned arrays.
+class ChunkedArrayReader final : public InputStream<byte_t> {
+public:
+
+  ChunkedArrayReader(InputStreamPtr<byte_t> stream,
+                     DataType type,
+                     DataFilter filter,
+                     std::vector<uint64_t> chunk_sizes = {})
+      : stream_{std::move(stream)}, type_{type}, filter_{filter},
+        chunk_sizes_{std::move(chunk_sizes)} {
+    TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  }
+
+  auto read(std::span<byte_t> data) -> size_t override {
+    size_t total_copied = 0;
+    while (!data.empty()) {
+      // If the current chunk is exhausted, read and decode the next one.
+      if (offset_ == chunk_.size()) {
+        offset_ = 0;
+        chunk_.resize(chunk_index_ < chunk_sizes_.size() ?
+                          chunk_sizes_[chunk_index_++] :
+                          ArrayChunkSize);
+        size_t chunk_size = 0;
+        while (chunk_size < chunk_.size()) {
+          const auto copied =
+              stream_->read(std::span{chunk_}.subspan(chunk_size));
+          if (copied == 0) break;
+          chunk_size += copied;
+        }
+        chunk_.resize(chunk_size);
+        if (chunk_.empty()) break; // Input stream is exhausted.
+        filter_decode(filter_, type_, chunk_);
+      }
+
+      // Copy the decoded data.
+      const auto copied = std::min(chunk_.size() - offset_, data.size());
+      std::copy_n(chunk_.begin() + offset_, copied, data.begin());
+      offset_ += copied, total_copied += copied;
+      data = data.subspan(copied);
+    }
+    return total_copied;
+  }
+
+private:
+
+  InputStreamPtr<byte_t> stream_;
+  DataType type_;
+  DataFilter filter_;
+  std::vector<uint64_t> chunk_sizes_;
+  size_t chunk_index_ = 0;
+  std::vector<byte_t> chunk_;
+  size_t offset_ = 0;
+
+}; // class ChunkedArrayReader
+
+// Uncompressed sizes of the chunks in the range, from the chunk offsets.
+auto chunk_sizes(std::span<const uint64_t> chunk_offsets,
+                 size_t first_chunk,
+                 size_t last_chunk,
+                 size_t data_size) -> std::vector<uint64_t> {
+  const auto num_chunks = chunk_offsets.size() / 2;
+  std::vector<uint64_t> sizes;
+  sizes.reserve(last_chunk - first_chunk);
+  for (size_t chunk = first_chunk; chunk < last_chunk; ++chunk) {
+    const auto next = chunk + 1 < num_chunks ? chunk_offsets[2 * chunk + 2] :
+                                               data_size;
+    sizes.push_back(next - chunk_offsets[2 * chunk]);
+  }
+  return sizes;
+}
+
+// Alignment of the data array payloads in the external payload file.
+constexpr size_t PayloadAlignment = 64;
+
+// Output stream that appends the uncompressed data array to the external
+// payload file. Data is accumulated in memory and appended on flush as a
+// single contiguous region, so that the arrays that are written at the same
+// time do not interleave.
+class ExternalArrayWriter final : public OutputStream<byte_t> {
+public:
+
+  ExternalArrayWriter(sqlite::Database& db,
+                      std::filesystem::path payload_path,
+                      DataArrayID array_id)
+      : db_{&db}, payload_path_{std::move(payload_path)}, array_id_{array_id} {}
+
+  void write(std::span<const byte_t> data) override {
+    payload_.insert(payload_.end(), data.begin(), data.end());
+    modified_ = true;
+  }
+
+  void flush() override {
+    if (!modified_) return;
+    const auto file = open_file(payload_path_.c_str(), "ab");
+    if (std::fseek(file.get(), 0, SEEK_END) != 0) {
+      TIT_THROW("Unable to seek the payload file '{}'!", payload_path_.c_str());
+    }
+    const auto end = std::ftell(file.get());
+    if (end < 0) {
+      TIT_THROW("Unable to query the payload file '{}'!",
+                payload_path_.c_str());
+    }
+    const auto offset = align_up(static_cast<size_t>(end), PayloadAlignment);
+    const std::vector<byte_t> padding(offset - static_cast<size_t>(end));
+    if (std::fwrite(padding.data(), 1, padding.size(), file.get()) !=
+            padding.size() ||
+        std::fwrite(payload_.data(), 1, payload_.size(), file.get()) !=
+            payload_.size() ||
+        std::fflush(file.get()) != 0) {
+      TIT_THROW("Unable to write the payload file '{}'!",
+                payload_path_.c_str());
+    }
+    sqlite::Statement statement{*db_, R"SQL(
+      UPDATE DataArrays
+      SET data = NULL, chunks = NULL, filter = NULL, dict_id = NULL,
+          payload_offset = ?, payload_size = ?
+      WHERE id = ?
+    )SQL"};
+    statement.run(offset, payload_.size(), array_id_.get());
+    modified_ = false;
+  }
+
+private:
+
+  sqlite::Database* db_;
+  std::filesystem::path payload_path_;
+  DataArrayID array_id_;
+  std::vector<byte_t> payload_;
+  bool modified_ = true;
+
+}; // class ExternalArrayWriter
+
+// Input stream that reads the region of the external payload file.
+class ExternalArrayReader final : public InputStream<byte_t> {
+public:
+
+  ExternalArrayReader(const std::filesystem::path& payload_path,
+                      size_t offset,
+                      size_t size)
+      : file_{open_file(payload_path.c_str(), "rb")}, remaining_{size} {
+    if (std::fseek(file_.get(), static_cast<long>(offset), SEEK_SET) != 0) {
+      TIT_THROW("Unable to seek the payload file '{}'!", payload_path.c_str());
+    }
+  }
+
+  auto read(std::span<byte_t> data) -> size_t override {
+    const auto count = std::min(data.size(), remaining_);
+    if (std::fread(data.data(), 1, count, file_.get()) != count) {
+      TIT_THROW("Unable to read data array: truncated payload file!");
+    }
+    remaining_ -= count;
+    return count;
+  }
+
+private:
+
+  FilePtr file_;
+  size_t remaining_;
+
+}; // class ExternalArrayReader
+
+// Hash of the data array content, used to detect the unchanged arrays.
+auto content_hash(std::span<const byte_t> data) noexcept -> uint64_t {
+  constexpr uint64_t prime = 0x100000001B3;
+  uint64_t hash = 0xCBF29CE484222325 ^ data.size();
+  size_t offset = 0;
+  for (; offset + sizeof(uint64_t) <= data.size(); offset += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    std::memcpy(&word, data.data() + offset, sizeof(uint64_t));
+    hash = std::rotl((hash ^ word) * prime, 31);
+  }
+  for (; offset < data.size(); ++offset) {
+    hash = (hash ^ std::to_integer<uint64_t>(data[offset])) * prime;
+  }
+  return hash;
+}
+
+// Skip the bytes of the input stream.
+void skip_bytes(InputStream<byte_t>& stream, size_t count) {
+  std::vector<byte_t> buffer(std::min(count, ArrayChunkSize));
+  while (count > 0) {
+    const auto skipped =
+        stream.read(std::span{buffer}.first(std::min(count, buffer.size())));
+    if (skipped == 0) TIT_THROW("Unable to skip data: truncated data!");
+    count -= skipped;
+  }
+}
+
+// Encoded data of the data array.
+struct ArraySource final {
+  DataType type;
+  DataFilter filter = DataFilter::none;
+  std::filesystem::path payload_path; // Empty unless external.
+  std::vector<byte_t> data;
+  std::vector<byte_t> dictionary;
+};
+
+// Independently decodable piece of the data array.
+struct ArrayPiece final {
+  size_t index;         // Index of the data array.
+  size_t data_offset;   // Offset of the decoded data, in bytes.
+  size_t data_size;     // Size of the decoded data, in bytes.
+  size_t source_offset; // Offset of the encoded data, in bytes.
+  size_t source_size;   // Size of the encoded data, in bytes.
+};
+
+// Tables that are shared with the shards, see `DataStorage::open_shard`.
+constexpr std::array shard_tables{
+    "DataSeries",
+    "TimeSteps",
+    "Telemetry",
+    "DataSets",
+    "DataDictionaries",
+    "DataArrays",
+};
+
+// Columns, that were added to the tables of the older storages by the schema
+// upgrades, along with the values they get, see `DataStorage::shadow_schema_`.
+constexpr std::array legacy_columns{
+    std::tuple{"DataSeries", "retired", "0"},
+    std::tuple{"TimeSteps", "index_id", "NULL"},
+    std::tuple{"DataArrays", "chunks", "NULL"},
+    std::tuple{"DataArrays", "parts", "NULL"},
+    std::tuple{"DataArrays", "filter", "NULL"},
+    std::tuple{"DataArrays", "payload_offset", "NULL"},
+    std::tuple{"DataArrays", "payload_size", "NULL"},
+    std::tuple{"DataArrays", "ref_id", "NULL"},
+    std::tuple{"DataArrays", "hash", "NULL"},
+    std::tuple{"DataArrays", "dict_id", "NULL"},
+};
+
+// Tables, that may be missing in the older storages, along with their columns.
+constexpr std::array legacy_tables{
+    std::pair{"Telemetry",
+              "series_id INTEGER, step INTEGER, name TEXT, value REAL"},
+    std::pair{"DataDictionaries",
+              "id INTEGER PRIMARY KEY, name TEXT, data BLOB"},
+    std::pair{"Shards", "id INTEGER PRIMARY KEY"},
+};
+
+// Name of the schema, that the shard is attached under.
+auto shard_schema(size_t index) -> std::string {
+  return std::format("shard{}", index);
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+DataArrayMapping::DataArrayMapping(const std::filesystem::path& path,
+                                   size_t offset,
+                                   size_t size) {
+  if (size == 0) return;
+  const auto file = open_file(path.c_str(), "rb");
+  const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const auto base_offset = offset / page_size * page_size;
+  base_size_ = offset - base_offset + size;
+  base_ = mmap(nullptr,
+               base_size_,
+               PROT_READ,
+               MAP_SHARED,
+               fileno(file.get()),
+               static_cast<off_t>(base_offset));
+  if (base_ == MAP_FAILED) {
+    base_ = nullptr;
+    TIT_THROW("Unable to map the payload file '{}'!", path.c_str());
+  }
+  data_ = std::span{static_cast<const byte_t*>(base_) + offset - base_offset,
+                    size};
+}
+
+DataArrayMapping::DataArrayMapping(DataArrayMapping&& other) noexcept
+    : base_{std::exchange(other.base_, nullptr)},
+      base_size_{std::exchange(other.base_size_, 0)},
+      data_{std::exchange(other.data_, {})} {}
+
+auto DataArrayMapping::operator=(DataArrayMapping&& other) noexcept
+    -> DataArrayMapping& {
+  if (this != &other) {
+    DataArrayMapping tmp{std::move(other)};
+    std::swap(base_, tmp.base_);
+    std::swap(base_size_, tmp.base_size_);
+    std::swap(data_, tmp.data_);
+  }
+  return *this;
+}
+
+DataArrayMapping::~DataArrayMapping() {
+  if (base_ != nullptr) munmap(base_, base_size_);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+DataArrayCache::DataArrayCache(size_t capacity) : capacity_{capacity} {}
+
+auto DataArrayCache::capacity() const -> size_t {
+  const std::scoped_lock lock{mutex_};
+  return capacity_;
+}
+
+void DataArrayCache::set_capacity(size_t capacity) {
+  const std::scoped_lock lock{mutex_};
+  capacity_ = capacity;
+  evict_();
+}
+
+auto DataArrayCache::size() const -> size_t {
+  const std::scoped_lock lock{mutex_};
+  return size_;
+}
+
+auto DataArrayCache::find(DataArrayID array_id) -> Buffer {
+  const std::scoped_lock lock{mutex_};
+  const auto iter = index_.find(array_id.get());
+  if (iter == index_.end()) return nullptr;
+  entries_.splice(entries_.begin(), entries_, iter->second);
+  return iter->second->second;
+}
+
+void DataArrayCache::insert(DataArrayID array_id, Buffer buffer) {
+  TIT_ASSERT(buffer != nullptr, "Buffer must not be null!");
+  const std::scoped_lock lock{mutex_};
+  if (const auto iter = index_.find(array_id.get()); iter != index_.end()) {
+    size_ -= iter->second->second->size();
+    entries_.erase(iter->second);
+    index_.erase(iter);
+  }
+  if (buffer->size() > capacity_) return;
+  size_ += buffer->size();
+  entries_.emplace_front(array_id, std::move(buffer));
+  index_.emplace(array_id.get(), entries_.begin());
+  evict_();
+}
+
+void DataArrayCache::erase(DataArrayID array_id) {
+  const std::scoped_lock lock{mutex_};
+  const auto iter = index_.find(array_id.get());
+  if (iter == index_.end()) return;
+  size_ -= iter->second->second->size();
+  entries_.erase(iter->second);
+  index_.erase(iter);
+}
+
+void DataArrayCache::clear() {
+  const std::scoped_lock lock{mutex_};
+  index_.clear();
+  entries_.clear();
+  size_ = 0;
+}
+
+void DataArrayCache::evict_() {
+  while (size_ > capacity_) {
+    TIT_ASSERT(!entries_.empty(), "Cache size is out of sync!");
+    const auto& [array_id, buffer] = entries_.back();
+    size_ -= buffer->size();
+    index_.erase(array_id.get());
+    entries_.pop_back();
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+DataStorage::DataStorage(const std::filesystem::path& path, OpenMode mode)
+    : db_{path, mode == OpenMode::read_only},
+      read_only_{mode == OpenMode::read_only} {
+  db_.set_busy_timeout(DefaultBusyTimeout);
+  if (read_only_) {
+    sqlite::Statement version_statement{db_, "PRAGMA user_version"};
+    const auto version =
+        version_statement.step() ? version_statement.column<int64_t>() : 0;
+    if (version > SchemaVersion) {
+      TIT_THROW("Data storage schema version {} is newer than the supported "
+                "version {}.",
+                version,
+                SchemaVersion);
+    }
+    db_.execute("PRAGMA foreign_keys = ON");
+    if (version < SchemaVersion) {
+      // Older storages cannot be upgraded without the write access, so their
+      // tables are presented with the current schema instead. Shards were
+      // introduced along with the current version, so there are none.
+      shadow_schema_();
+      return;
+    }
+    attach_shards_();
+    return;
+  }
+
+  // Note: vacuum mode only applies to the new databases. Existing ones keep
+  //       their mode until they are fully vacuumed.
   db_.execute(R"SQL(
     PRAGMA foreign_keys = ON;
+    PRAGMA auto_vacuum = INCREMENTAL;
 
     CREATE TABLE IF NOT EXISTS Settings (
       id INTEGER PRIMARY KEY CHECK (id = 0),
@@ -36,7 +604,8 @@ DataStorage::DataStorage(const std::filesystem::path& path) : db_{path} {
 
     CREATE TABLE IF NOT EXISTS DataSeries (
       id          INTEGER PRIMARY KEY AUTOINCREMENT,
-      parameters  TEXT
+      parameters  TEXT,
+      retired     INTEGER NOT NULL DEFAULT 0
     ) STRICT;
 
     CREATE TABLE IF NOT EXISTS TimeSteps (
@@ -45,6 +614,16 @@ DataStorage::DataStorage(const std::filesystem::path& path) : db_{path} {
       time        REAL NOT NULL,
       uniform_id  INTEGER NOT NULL,
       varying_id  INTEGER NOT NULL,
+      index_id    INTEGER,
+      FOREIGN KEY (series_id) REFERENCES DataSeries(id) ON DELETE CASCADE
+    ) STRICT;
+
+    CREATE TABLE IF NOT EXISTS Telemetry (
+      series_id   INTEGER NOT NULL,
+      step        INTEGER NOT NULL,
+      name        TEXT NOT NULL,
+      value       REAL NOT NULL,
+      PRIMARY KEY (series_id, name, step),
       FOREIGN KEY (series_id) REFERENCES DataSeries(id) ON DELETE CASCADE
     ) STRICT;
 
@@ -54,6 +633,12 @@ DataStorage::DataStorage(const std::filesystem::path& path) : db_{path} {
       FOREIGN KEY (time_step_id) REFERENCES TimeSteps(id) ON DELETE CASCADE
     ) STRICT;
 
+    CREATE TABLE IF NOT EXISTS DataDictionaries (
+      id          INTEGER PRIMARY KEY AUTOINCREMENT,
+      name        TEXT NOT NULL UNIQUE,
+      data        BLOB
+    ) STRICT;
+
     CREATE TABLE IF NOT EXISTS DataArrays (
       id          INTEGER PRIMARY KEY AUTOINCREMENT,
       data_set_id INTEGER NOT NULL,
@@ -61,16 +646,390 @@ DataStorage::DataStorage(const std::filesystem::path& path) : db_{path} {
       type        INTEGER NOT NULL,
       size        INTEGER,
       data        BLOB,
-      FOREIGN KEY (data_set_id) REFERENCES DataSets(id) ON DELETE CASCADE
+      chunks      BLOB,
+      parts       BLOB,
+      filter      INTEGER,
+      payload_offset INTEGER,
+      payload_size   INTEGER,
+      ref_id      INTEGER,
+      hash        INTEGER,
+      dict_id     INTEGER,
+      FOREIGN KEY (data_set_id) REFERENCES DataSets(id) ON DELETE CASCADE,
+      FOREIGN KEY (ref_id) REFERENCES DataArrays(id),
+      FOREIGN KEY (dict_id) REFERENCES DataDictionaries(id)
+    ) STRICT;
+
+    CREATE TABLE IF NOT EXISTS Shards (
+      id INTEGER PRIMARY KEY
+    ) STRICT;
+
+    CREATE TABLE IF NOT EXISTS FreePayloads (
+      payload_offset INTEGER NOT NULL,
+      payload_size   INTEGER NOT NULL
     ) STRICT;
   )SQL");
-  /// @todo We shall check if the database schema is actually what we expect.
+  upgrade_schema_();
+
+  // Data arrays, that are referred to by the other arrays, pass their data on
+  // to the oldest reference before they are deleted, and the remaining
+  // references are re-parented to it. References always point to the array
+  // that holds the data, so there are no chains to follow. The trigger is
+  // created after the upgrade, since it needs the newer columns.
+  db_.execute(R"SQL(
+    CREATE TRIGGER IF NOT EXISTS DataArraysReparent
+    BEFORE DELETE ON DataArrays
+    WHEN EXISTS (SELECT 1 FROM DataArrays WHERE ref_id = OLD.id)
+    BEGIN
+      UPDATE DataArrays
+        SET ref_id = (SELECT min(id) FROM DataArrays WHERE ref_id = OLD.id)
+        WHERE ref_id = OLD.id AND id != (
+          SELECT min(id) FROM DataArrays WHERE ref_id = OLD.id
+        );
+      UPDATE DataArrays
+        SET data = OLD.data, chunks = OLD.chunks, parts = OLD.parts,
+            filter = OLD.filter, payload_offset = OLD.payload_offset,
+            payload_size = OLD.payload_size, hash = OLD.hash,
+            dict_id = OLD.dict_id, ref_id = NULL
+        WHERE ref_id = OLD.id;
+    END;
+  )SQL");
+
+  // Regions of the external payload file, that are no longer referred to by
+  // any data array, are recorded once their arrays are deleted or rewritten,
+  // and are reclaimed after the changes are committed. Data, that was passed
+  // on to a reference, is still referred to, so it is kept.
+  db_.execute(R"SQL(
+    CREATE INDEX IF NOT EXISTS DataArraysPayload
+      ON DataArrays(payload_offset) WHERE payload_offset IS NOT NULL;
+
+    CREATE TRIGGER IF NOT EXISTS DataArraysFreePayload
+    AFTER DELETE ON DataArrays
+    WHEN OLD.payload_offset IS NOT NULL AND NOT EXISTS (
+      SELECT 1 FROM DataArrays WHERE payload_offset = OLD.payload_offset
+    )
+    BEGIN
+      INSERT INTO FreePayloads (payload_offset, payload_size)
+        VALUES (OLD.payload_offset, OLD.payload_size);
+    END;
+
+    CREATE TRIGGER IF NOT EXISTS DataArraysRewritePayload
+    AFTER UPDATE OF payload_offset ON DataArrays
+    WHEN OLD.payload_offset IS NOT NULL AND
+         OLD.payload_offset IS NOT NEW.payload_offset AND NOT EXISTS (
+      SELECT 1 FROM DataArrays WHERE payload_offset = OLD.payload_offset
+    )
+    BEGIN
+      INSERT INTO FreePayloads (payload_offset, payload_size)
+        VALUES (OLD.payload_offset, OLD.payload_size);
+    END;
+  )SQL");
+  reclaim_payloads_();
+}
+
+void DataStorage::reclaim_payloads_() {
+  // Changes may still be rolled back within a transaction, so the regions are
+  // reclaimed after the outermost one is committed.
+  if (read_only_ || path().empty() || db_.in_transaction()) return;
+  std::vector<std::pair<size_t, size_t>> regions;
+  sqlite::Statement regions_statement{db_, R"SQL(
+    SELECT payload_offset, payload_size FROM FreePayloads
+  )SQL"};
+  while (regions_statement.step()) {
+    const auto [offset, size] = regions_statement.columns<size_t, size_t>();
+    regions.emplace_back(offset, size);
+  }
+  if (regions.empty()) return;
+  db_.execute("DELETE FROM FreePayloads");
+
+  // Remove the payload file, once no data arrays are stored in it.
+  const auto payload_path = this->payload_path();
+  sqlite::Statement remaining_statement{db_, R"SQL(
+    SELECT EXISTS (SELECT 1 FROM DataArrays WHERE payload_offset IS NOT NULL)
+  )SQL"};
+  if (remaining_statement.step() && !remaining_statement.column<bool>()) {
+    std::error_code error{};
+    std::filesystem::remove(payload_path, error);
+    return;
+  }
+
+  // Otherwise, return the freed regions to the file system by punching the
+  // holes in the file, so that the offsets of the remaining arrays stay
+  // valid. Where this is not supported, regions are only reclaimed once the
+  // whole file is removed.
+#ifdef __linux__
+  const auto fd = open(payload_path.c_str(), O_WRONLY | O_CLOEXEC);
+  if (fd < 0) return;
+  for (const auto& [offset, size] : regions) {
+    if (fallocate(fd,
+                  FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  static_cast<off_t>(offset),
+                  static_cast<off_t>(size)) != 0) {
+      TIT_WARN("Unable to reclaim the regions of the payload file '{}'.",
+               payload_path.c_str());
+      break;
+    }
+  }
+  close(fd);
+#endif
+}
+
+void DataStorage::upgrade_schema_() {
+  sqlite::Statement version_statement{db_, "PRAGMA user_version"};
+  const auto version =
+      version_statement.step() ? version_statement.column<int64_t>() : 0;
+  if (version == SchemaVersion) return;
+  if (version > SchemaVersion) {
+    TIT_THROW("Data storage schema version {} is newer than the supported "
+              "version {}.",
+              version,
+              SchemaVersion);
+  }
+  const auto transaction = this->transaction();
+
+  // Version 1: data arrays got a few columns after the first storages were
+  // created, and these have to be added. Tables are only linked through the
+  // foreign keys, so the lookups and the cascading deletions have to scan
+  // the whole tables without the indexes on them.
+  if (version < 1) {
+    std::vector<std::string> columns;
+    sqlite::Statement columns_statement{db_, R"SQL(
+      SELECT name FROM pragma_table_info('DataArrays')
+    )SQL"};
+    while (columns_statement.step()) {
+      columns.push_back(columns_statement.column<std::string>());
+    }
+    static constexpr std::array new_columns{
+        std::pair{"chunks", "BLOB"},
+        std::pair{"filter", "INTEGER"},
+        std::pair{"payload_offset", "INTEGER"},
+        std::pair{"payload_size", "INTEGER"},
+        std::pair{"ref_id", "INTEGER REFERENCES DataArrays(id)"},
+        std::pair{"hash", "INTEGER"},
+        std::pair{"dict_id", "INTEGER REFERENCES DataDictionaries(id)"},
+    };
+    for (const auto& [name, type] : new_columns) {
+      if (std::ranges::contains(columns, std::string_view{name})) continue;
+      db_.execute(std::format("ALTER TABLE DataArrays ADD COLUMN {} {}",
+                              name,
+                              type));
+    }
+    db_.execute(R"SQL(
+      CREATE INDEX IF NOT EXISTS TimeStepsBySeries
+        ON TimeSteps(series_id);
+      CREATE INDEX IF NOT EXISTS DataSetsByTimeStep
+        ON DataSets(time_step_id);
+      CREATE INDEX IF NOT EXISTS DataArraysBySetAndName
+        ON DataArrays(data_set_id, name);
+      CREATE INDEX IF NOT EXISTS DataArraysByRef
+        ON DataArrays(ref_id);
+    )SQL");
+  }
+
+  // Version 2: series are retired first, and their data is purged later.
+  if (version < 2) {
+    sqlite::Statement retired_statement{db_, R"SQL(
+      SELECT COUNT(*) FROM pragma_table_info('DataSeries')
+        WHERE name = 'retired'
+    )SQL"};
+    if (retired_statement.step() && retired_statement.column<size_t>() == 0) {
+      db_.execute(R"SQL(
+        ALTER TABLE DataSeries ADD COLUMN retired INTEGER NOT NULL DEFAULT 0
+      )SQL");
+    }
+  }
+
+  // Version 3: time steps may have the spatial index of the particles.
+  if (version < 3) {
+    sqlite::Statement index_statement{db_, R"SQL(
+      SELECT COUNT(*) FROM pragma_table_info('TimeSteps')
+        WHERE name = 'index_id'
+    )SQL"};
+    if (index_statement.step() && index_statement.column<size_t>() == 0) {
+      db_.execute("ALTER TABLE TimeSteps ADD COLUMN index_id INTEGER");
+    }
+  }
+
+  // Version 4: data arrays may be created from the parts.
+  if (version < 4) {
+    sqlite::Statement parts_statement{db_, R"SQL(
+      SELECT COUNT(*) FROM pragma_table_info('DataArrays')
+        WHERE name = 'parts'
+    )SQL"};
+    if (parts_statement.step() && parts_statement.column<size_t>() == 0) {
+      db_.execute("ALTER TABLE DataArrays ADD COLUMN parts BLOB");
+    }
+  }
+
+  // Version 5: storage may be split into the shards, which are listed in the
+  // main storage. The list is created along with the other tables above.
+
+  db_.execute(std::format("PRAGMA user_version = {}", SchemaVersion));
+}
+
+void DataStorage::shadow_schema_() {
+  // Tables, that are missing, are shadowed by the empty temporary tables.
+  for (const auto& [table, columns] : legacy_tables) {
+    sqlite::Statement table_statement{db_, R"SQL(
+      SELECT COUNT(*) FROM main.sqlite_master WHERE type = 'table' AND name = ?
+    )SQL"};
+    table_statement.bind(table);
+    if (table_statement.step() && table_statement.column<size_t>() != 0) {
+      continue;
+    }
+    db_.execute(std::format("CREATE TEMP TABLE {} ({})", table, columns));
+  }
+
+  // Tables, that miss the columns, are shadowed by the temporary views, that
+  // add the missing columns with the values they would get on the upgrade.
+  for (const auto* table : shard_tables) {
+    std::vector<std::string> columns;
+    sqlite::Statement columns_statement{db_, R"SQL(
+      SELECT name FROM pragma_table_info(?, 'main')
+    )SQL"};
+    columns_statement.bind(table);
+    while (columns_statement.step()) {
+      columns.push_back(columns_statement.column<std::string>());
+    }
+    if (columns.empty()) continue; // Shadowed by the temporary table.
+    std::string missing_columns;
+    for (const auto& [column_table, name, value] : legacy_columns) {
+      if (std::string_view{column_table} != table) continue;
+      if (std::ranges::contains(columns, std::string_view{name})) continue;
+      missing_columns += std::format(", {} AS {}", value, name);
+    }
+    if (missing_columns.empty()) continue;
+    db_.execute(std::format("CREATE TEMP VIEW {0} AS "
+                            "SELECT *{1} FROM main.{0}",
+                            table,
+                            missing_columns));
+  }
+}
+
+void DataStorage::attach_shards_() {
+  shards_ = shard_indices();
+  if (shards_.empty()) return;
+  for (const auto index : shards_) {
+    const auto schema = shard_schema(index);
+    sqlite::Statement attach_statement{
+        db_,
+        std::format("ATTACH DATABASE ? AS {}", schema)};
+    attach_statement.run(shard_path(index).string());
+    sqlite::Statement version_statement{
+        db_,
+        std::format("PRAGMA {}.user_version", schema)};
+    const auto version =
+        version_statement.step() ? version_statement.column<int64_t>() : 0;
+    if (version != SchemaVersion) {
+      TIT_THROW("Data storage shard {} schema version {} is not supported in "
+                "the read-only mode, expected version {}.",
+                index,
+                version,
+                SchemaVersion);
+    }
+  }
+
+  // Tables are shadowed by the temporary views, that join the rows of the
+  // main storage and of the shards, so the queries see them all. Columns are
+  // listed by name, since the upgraded tables may have them in a different
+  // order. IDs of the shards do not overlap, so the rows are joined as is.
+  for (const auto* table : shard_tables) {
+    sqlite::Statement columns_statement{db_, R"SQL(
+      SELECT group_concat(name, ', ') FROM pragma_table_info(?, 'main')
+    )SQL"};
+    columns_statement.bind(table);
+    if (!columns_statement.step()) TIT_THROW("Unable to get table columns!");
+    const auto columns = columns_statement.column<std::string>();
+    auto view_sql = std::format("CREATE TEMP VIEW {0} AS "
+                                "SELECT {1} FROM main.{0}",
+                                table,
+                                columns);
+    for (const auto index : shards_) {
+      view_sql += std::format(" UNION ALL SELECT {1} FROM {2}.{0}",
+                              table,
+                              columns,
+                              shard_schema(index));
+    }
+    db_.execute(view_sql);
+  }
 }
 
 auto DataStorage::path() const -> std::filesystem::path {
   return db_.path();
 }
 
+auto DataStorage::read_only() const noexcept -> bool {
+  return read_only_;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+DataStorage::Transaction::Transaction(DataStorage& storage)
+    : storage_{&storage}, num_exceptions_{std::uncaught_exceptions()} {
+  storage_->db_.execute("SAVEPOINT tit_transaction");
+}
+
+DataStorage::Transaction::~Transaction() noexcept {
+  try {
+    if (std::uncaught_exceptions() > num_exceptions_) {
+      storage_->db_.execute("ROLLBACK TO tit_transaction");
+      storage_->cache_->clear();
+    }
+    storage_->db_.execute("RELEASE tit_transaction");
+    storage_->reclaim_payloads_();
+  } catch (const std::exception& e) {
+    TIT_ERROR("Failed to finish the data storage transaction: {}", e.what());
+  }
+}
+
+auto DataStorage::transaction() -> Transaction {
+  return Transaction{*this};
+}
+
+auto DataStorage::lock() const -> std::unique_lock<std::recursive_mutex> {
+  TIT_ASSERT(mutex_ != nullptr, "Data storage was moved away!");
+  return std::unique_lock{*mutex_};
+}
+
+auto DataStorage::journal_mode() const -> JournalMode {
+  sqlite::Statement statement{db_, "PRAGMA journal_mode"};
+  if (!statement.step()) TIT_THROW("Unable to get journal mode!");
+  return statement.column<std::string>() == "wal" ? JournalMode::wal :
+                                                    JournalMode::rollback;
+}
+
+void DataStorage::set_journal_mode(JournalMode mode) {
+  db_.execute(translate<CStrView>(mode)
+                  .option(JournalMode::rollback, "PRAGMA journal_mode = DELETE")
+                  .option(JournalMode::wal, "PRAGMA journal_mode = WAL")
+                  .fallback([](JournalMode /*mode*/) {
+                    TIT_THROW("Invalid journal mode!");
+                  }));
+}
+
+auto DataStorage::sync_mode() const -> SyncMode {
+  sqlite::Statement statement{db_, "PRAGMA synchronous"};
+  if (!statement.step()) TIT_THROW("Unable to get synchronization mode!");
+  switch (statement.column<int>()) {
+    case 0:  return SyncMode::off;
+    case 1:  return SyncMode::normal;
+    default: return SyncMode::full;
+  }
+}
+
+void DataStorage::set_sync_mode(SyncMode mode) {
+  db_.execute(translate<CStrView>(mode)
+                  .option(SyncMode::off, "PRAGMA synchronous = OFF")
+                  .option(SyncMode::normal, "PRAGMA synchronous = NORMAL")
+                  .option(SyncMode::full, "PRAGMA synchronous = FULL")
+                  .fallback([](SyncMode /*mode*/) {
+                    TIT_THROW("Invalid synchronization mode!");
+                  }));
+}
+
+void DataStorage::set_busy_timeout(std::chrono::milliseconds timeout) {
+  db_.set_busy_timeout(timeout);
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 auto DataStorage::max_series() const -> size_t {
@@ -90,18 +1049,112 @@ void DataStorage::set_max_series(size_t value) {
   )SQL"};
   update_statement.run(value);
   if (num_series() > value) {
-    sqlite::Statement remove_extra_statement{db_, R"SQL(
-      DELETE FROM DataSeries WHERE id IN (
-        SELECT id FROM DataSeries ORDER BY id ASC LIMIT ?
+    sqlite::Statement retire_extra_statement{db_, R"SQL(
+      UPDATE DataSeries SET retired = 1 WHERE id IN (
+        SELECT id FROM DataSeries WHERE retired = 0 ORDER BY id ASC LIMIT ?
       )
     )SQL"};
-    remove_extra_statement.run(num_series() - value);
+    retire_extra_statement.run(num_series() - value);
   }
 }
 
+auto DataStorage::compression_level() const noexcept -> int {
+  return compression_level_;
+}
+
+void DataStorage::set_compression_level(int value) noexcept {
+  compression_level_ = value;
+}
+
+auto DataStorage::compression_workers() const noexcept -> size_t {
+  return compression_workers_;
+}
+
+void DataStorage::set_compression_workers(size_t value) noexcept {
+  compression_workers_ = value;
+}
+
+auto DataStorage::external_arrays() const noexcept -> bool {
+  return external_arrays_;
+}
+
+auto DataStorage::dictionaries() const noexcept -> bool {
+  return dictionaries_;
+}
+
+void DataStorage::set_dictionaries(bool value) noexcept {
+  dictionaries_ = value;
+}
+
+void DataStorage::set_external_arrays(bool value) {
+  if (value && path().empty()) {
+    TIT_THROW("External data arrays require a file-backed storage!");
+  }
+  external_arrays_ = value;
+}
+
+auto DataStorage::payload_path() const -> std::filesystem::path {
+  auto result = path();
+  if (!result.empty()) result += ".payload";
+  return result;
+}
+
+auto DataStorage::open_shard(size_t index) -> DataStorage {
+  TIT_ASSERT(index > 0 && index <= MaxShards, "Shard index is out of range!");
+  if (read_only_) TIT_THROW("Shards cannot be opened in the read-only mode!");
+  if (path().empty()) TIT_THROW("Shards require a file-backed storage!");
+  DataStorage shard{shard_path(index)};
+
+  // Seed the ID sequences of the shard with the start of its range, unless
+  // they are already past it.
+  {
+    const auto transaction = shard.transaction();
+    const auto first_id = static_cast<int64_t>(index << ShardIdBits);
+    sqlite::Statement insert_statement{shard.db_, R"SQL(
+      INSERT INTO sqlite_sequence (name, seq)
+        SELECT ?1, ?2 WHERE NOT EXISTS (
+          SELECT 1 FROM sqlite_sequence WHERE name = ?1
+        )
+    )SQL"};
+    sqlite::Statement update_statement{shard.db_, R"SQL(
+      UPDATE sqlite_sequence SET seq = max(seq, ?2) WHERE name = ?1
+    )SQL"};
+    for (const auto* table : shard_tables) {
+      if (std::string_view{table} == "Telemetry") continue; // No IDs.
+      insert_statement.run(table, first_id);
+      update_statement.run(table, first_id);
+    }
+  }
+
+  // Shard is listed only once it is created, so that the readers never
+  // attach a missing shard.
+  sqlite::Statement register_statement{db_, R"SQL(
+    INSERT OR IGNORE INTO Shards (id) VALUES (?)
+  )SQL"};
+  register_statement.run(index);
+  return shard;
+}
+
+auto DataStorage::shard_path(size_t index) const -> std::filesystem::path {
+  auto result = path();
+  if (!result.empty()) result += std::format(".shard{}", index);
+  return result;
+}
+
+auto DataStorage::shard_indices() const -> std::vector<size_t> {
+  // Note: older read-only storages have the list in a temporary table, so
+  //       the schema is not specified. Main one is searched before shards.
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT id FROM Shards ORDER BY id
+  )SQL"};
+  std::vector<size_t> result;
+  while (statement.step()) result.push_back(statement.column<size_t>());
+  return result;
+}
+
 auto DataStorage::num_series() const -> size_t {
   sqlite::Statement statement{db_, R"SQL(
-    SELECT COUNT(*) FROM DataSeries
+    SELECT COUNT(*) FROM DataSeries WHERE retired = 0
   )SQL"};
   if (!statement.step()) TIT_THROW("Unable to count data series!");
   return statement.column<size_t>();
@@ -109,7 +1162,7 @@ auto DataStorage::num_series() const -> size_t {
 
 auto DataStorage::series_ids() const -> InputStreamPtr<DataSeriesID> {
   sqlite::Statement statement{db_, R"SQL(
-    SELECT id FROM DataSeries ORDER BY id ASC
+    SELECT id FROM DataSeries WHERE retired = 0 ORDER BY id ASC
   )SQL"};
   return make_generator_input_stream<DataSeriesID>(
       [statement = std::move(statement)](DataSeriesID& out) mutable {
@@ -122,7 +1175,7 @@ auto DataStorage::series_ids() const -> InputStreamPtr<DataSeriesID> {
 auto DataStorage::last_series_id() const -> DataSeriesID {
   TIT_ASSERT(num_series() > 0, "No data series in the storage!");
   sqlite::Statement statement{db_, R"SQL(
-    SELECT id FROM DataSeries ORDER BY id DESC LIMIT 1
+    SELECT id FROM DataSeries WHERE retired = 0 ORDER BY id DESC LIMIT 1
   )SQL"};
   if (!statement.step()) TIT_THROW("Unable to get last data series!");
   return DataSeriesID{statement.column<sqlite::RowID>()};
@@ -131,10 +1184,11 @@ auto DataStorage::last_series_id() const -> DataSeriesID {
 auto DataStorage::create_series_id(std::string_view parameters)
     -> DataSeriesID {
   if (num_series() >= max_series()) {
-    // Delete the oldest series if the maximum number of series is reached.
+    // Retire the oldest series if the maximum number of series is reached.
+    // Its data is purged later, see `purge_retired`.
     db_.execute(R"SQL(
-      DELETE FROM DataSeries WHERE id IN (
-        SELECT id FROM DataSeries ORDER BY id ASC LIMIT 1
+      UPDATE DataSeries SET retired = 1 WHERE id IN (
+        SELECT id FROM DataSeries WHERE retired = 0 ORDER BY id ASC LIMIT 1
       )
     )SQL");
   }
@@ -151,13 +1205,47 @@ void DataStorage::delete_series(DataSeriesID series_id) {
     DELETE FROM DataSeries WHERE id = ?
   )SQL"};
   statement.run(series_id.get());
+  cache_->clear();
+  reclaim_payloads_();
+}
+
+auto DataStorage::purge_retired(size_t max_time_steps) -> bool {
+  const auto transaction = this->transaction();
+
+  // Delete the last time steps of the retired series first, since the data
+  // arrays may refer to the arrays of the preceding time steps only.
+  sqlite::Statement time_steps_statement{db_, R"SQL(
+    DELETE FROM TimeSteps WHERE id IN (
+      SELECT id FROM TimeSteps WHERE series_id IN (
+        SELECT id FROM DataSeries WHERE retired = 1
+      ) ORDER BY id DESC LIMIT ?
+    )
+  )SQL"};
+  time_steps_statement.run(max_time_steps);
+  cache_->clear();
+
+  // Delete the retired series, that have no time steps left.
+  db_.execute(R"SQL(
+    DELETE FROM DataSeries WHERE retired = 1 AND id NOT IN (
+      SELECT series_id FROM TimeSteps
+    )
+  )SQL");
+
+  // Return the freed pages to the file system.
+  db_.execute("PRAGMA incremental_vacuum");
+
+  sqlite::Statement remaining_statement{db_, R"SQL(
+    SELECT COUNT(*) FROM DataSeries WHERE retired = 1
+  )SQL"};
+  return remaining_statement.step() &&
+         remaining_statement.column<size_t>() == 0;
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 auto DataStorage::check_series(DataSeriesID series_id) const -> bool {
   sqlite::Statement statement{db_, R"SQL(
-    SELECT id FROM DataSeries WHERE id = ?
+    SELECT id FROM DataSeries WHERE id = ? AND retired = 0
   )SQL"};
   statement.bind(series_id.get());
   return statement.step();
@@ -212,6 +1300,48 @@ auto DataStorage::series_last_time_step_id(DataSeriesID series_id) const
   return DataTimeStepID{statement.column<sqlite::RowID>()};
 }
 
+void DataStorage::series_record_telemetry(DataSeriesID series_id,
+                                          size_t step,
+                                          std::string_view name,
+                                          float64_t value) {
+  TIT_ASSERT(check_series(series_id), "Invalid series ID!");
+  TIT_ASSERT(!name.empty(), "Telemetry metric name must not be empty!");
+  sqlite::Statement statement{db_, R"SQL(
+    INSERT OR REPLACE INTO Telemetry (series_id, step, name, value)
+      VALUES (?, ?, ?, ?)
+  )SQL"};
+  statement.run(series_id.get(), step, name, value);
+}
+
+auto DataStorage::series_telemetry_names(DataSeriesID series_id) const
+    -> std::vector<std::string> {
+  TIT_ASSERT(check_series(series_id), "Invalid series ID!");
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT DISTINCT name FROM Telemetry WHERE series_id = ? ORDER BY name ASC
+  )SQL"};
+  statement.bind(series_id.get());
+  std::vector<std::string> result;
+  while (statement.step()) result.push_back(statement.column<std::string>());
+  return result;
+}
+
+auto DataStorage::series_telemetry(DataSeriesID series_id,
+                                   std::string_view name) const
+    -> std::vector<std::pair<size_t, float64_t>> {
+  TIT_ASSERT(check_series(series_id), "Invalid series ID!");
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT step, value FROM Telemetry
+      WHERE series_id = ? AND name = ? ORDER BY step ASC
+  )SQL"};
+  statement.bind(series_id.get(), name);
+  std::vector<std::pair<size_t, float64_t>> result;
+  while (statement.step()) {
+    auto [step, value] = statement.columns<size_t, float64_t>();
+    result.emplace_back(step, value);
+  }
+  return result;
+}
+
 auto DataStorage::create_time_step_id(DataSeriesID series_id, real_t time)
     -> DataTimeStepID {
   TIT_ASSERT(check_series(series_id), "Invalid series ID!");
@@ -244,6 +1374,8 @@ void DataStorage::delete_time_step(DataTimeStepID time_step_id) {
     DELETE FROM TimeSteps WHERE id = ?
   )SQL"};
   statement.run(time_step_id.get());
+  cache_->clear();
+  reclaim_payloads_();
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -292,6 +1424,95 @@ auto DataStorage::time_step_varyings_id(DataTimeStepID time_step_id) const
   return DataSetID{statement.column<sqlite::RowID>()};
 }
 
+// Decimated levels are the datasets of the time step, other than the uniform,
+// varying and index ones, in the order of their creation.
+auto DataStorage::time_step_num_levels(DataTimeStepID time_step_id) const
+    -> size_t {
+  TIT_ASSERT(check_time_step(time_step_id), "Invalid time step ID!");
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT COUNT(*) FROM DataSets
+      JOIN TimeSteps ON TimeSteps.id = DataSets.time_step_id
+      WHERE DataSets.time_step_id = ? AND
+            DataSets.id NOT IN (TimeSteps.uniform_id,
+                                TimeSteps.varying_id,
+                                IFNULL(TimeSteps.index_id, 0))
+  )SQL"};
+  statement.bind(time_step_id.get());
+  if (!statement.step()) TIT_THROW("Unable to count time step levels!");
+  return statement.column<size_t>();
+}
+
+auto DataStorage::time_step_level_id(DataTimeStepID time_step_id,
+                                     size_t level) const -> DataSetID {
+  TIT_ASSERT(check_time_step(time_step_id), "Invalid time step ID!");
+  if (level == 0) return time_step_varyings_id(time_step_id);
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT DataSets.id FROM DataSets
+      JOIN TimeSteps ON TimeSteps.id = DataSets.time_step_id
+      WHERE DataSets.time_step_id = ? AND
+            DataSets.id NOT IN (TimeSteps.uniform_id,
+                                TimeSteps.varying_id,
+                                IFNULL(TimeSteps.index_id, 0))
+      ORDER BY DataSets.id LIMIT 1 OFFSET ?
+  )SQL"};
+  statement.bind(time_step_id.get(), level - 1);
+  if (!statement.step()) {
+    TIT_THROW("Time step {} has no level {}.", time_step_id.get(), level);
+  }
+  return DataSetID{statement.column<sqlite::RowID>()};
+}
+
+auto DataStorage::create_time_step_level_id(DataTimeStepID time_step_id)
+    -> DataSetID {
+  TIT_ASSERT(check_time_step(time_step_id), "Invalid time step ID!");
+  const auto level_id = create_set_();
+  sqlite::Statement statement{db_, R"SQL(
+    UPDATE DataSets SET time_step_id = ? WHERE id = ?
+  )SQL"};
+  statement.run(time_step_id.get(), level_id.get());
+  return level_id;
+}
+
+auto DataStorage::time_step_has_index(DataTimeStepID time_step_id) const
+    -> bool {
+  TIT_ASSERT(check_time_step(time_step_id), "Invalid time step ID!");
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT index_id IS NOT NULL FROM TimeSteps WHERE id = ?
+  )SQL"};
+  statement.bind(time_step_id.get());
+  return statement.step() && statement.column<bool>();
+}
+
+auto DataStorage::time_step_index_id(DataTimeStepID time_step_id) const
+    -> DataSetID {
+  TIT_ASSERT(check_time_step(time_step_id), "Invalid time step ID!");
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT index_id FROM TimeSteps WHERE id = ? AND index_id IS NOT NULL
+  )SQL"};
+  statement.bind(time_step_id.get());
+  if (!statement.step()) {
+    TIT_THROW("Time step {} has no spatial index.", time_step_id.get());
+  }
+  return DataSetID{statement.column<sqlite::RowID>()};
+}
+
+auto DataStorage::create_time_step_index_id(DataTimeStepID time_step_id)
+    -> DataSetID {
+  TIT_ASSERT(check_time_step(time_step_id), "Invalid time step ID!");
+  TIT_ASSERT(!time_step_has_index(time_step_id),
+             "Time step already has a spatial index!");
+  const auto index_id = create_set_();
+  sqlite::Statement set_statement{db_, R"SQL(
+    UPDATE DataSets SET time_step_id = ? WHERE id = ?
+  )SQL"};
+  set_statement.run(time_step_id.get(), index_id.get());
+  sqlite::Statement time_step_statement{db_, R"SQL(
+    UPDATE TimeSteps SET index_id = ? WHERE id = ?
+  )SQL"};
+  time_step_statement.run(index_id.get(), time_step_id.get());
+  return index_id;
+}
+
 auto DataStorage::create_set_() -> DataSetID {
   sqlite::Statement statement{db_, R"SQL(
     INSERT INTO DataSets DEFAULT VALUES
@@ -371,12 +1592,160 @@ auto DataStorage::create_array_id(DataSetID dataset_id,
   return array_id;
 }
 
+auto DataStorage::create_array_id(DataSetID dataset_id,
+                                  std::string_view name,
+                                  DataType type,
+                                  std::span<const byte_t> data,
+                                  ErrorBound bound) -> DataArrayID {
+  std::vector<byte_t> quantized(data.begin(), data.end());
+  quantize(bound, type, quantized);
+  return create_array_id(dataset_id, name, type, quantized);
+}
+
+auto DataStorage::create_array_ref_id(DataSetID dataset_id,
+                                      std::string_view name,
+                                      DataArrayID source_id) -> DataArrayID {
+  TIT_ASSERT(check_dataset(dataset_id), "Invalid data set ID!");
+  TIT_ASSERT(check_array(source_id), "Invalid source data array ID!");
+  TIT_ASSERT(!name.empty(), "Array name must not be empty!");
+  TIT_ASSERT(!find_array_id(dataset_id, name), "Array already exists!");
+  sqlite::Statement statement{db_, R"SQL(
+    INSERT INTO DataArrays (data_set_id, name, type, size, ref_id, hash)
+    SELECT ?, ?, type, size, coalesce(ref_id, id), hash
+    FROM DataArrays WHERE id = ?
+  )SQL"};
+  statement.run(dataset_id.get(), name, source_id.get());
+  return DataArrayID{db_.last_insert_row_id()};
+}
+
+auto DataStorage::create_array_or_ref_id(DataSetID dataset_id,
+                                         std::string_view name,
+                                         DataType type,
+                                         std::span<const byte_t> data,
+                                         std::optional<DataSetID> previous_id)
+    -> DataArrayID {
+  const auto hash = content_hash(data);
+
+  // Refer to the previous data array if its data is identical. Matching hash
+  // only makes it likely, so the data is compared before it is reused.
+  if (previous_id.has_value()) {
+    if (const auto prev_id = find_array_id(*previous_id, name);
+        prev_id.has_value() && array_type(*prev_id) == type &&
+        array_size(*prev_id) * type.width() == data.size() &&
+        array_hash_(*prev_id) == hash &&
+        std::ranges::equal(*array_data_read(*prev_id), data)) {
+      return create_array_ref_id(dataset_id, name, *prev_id);
+    }
+  }
+
+  // Otherwise, write the data, and store the hash for the next time.
+  const auto array_id = create_array_id(dataset_id, name, type, data);
+  sqlite::Statement statement{db_, R"SQL(
+    UPDATE DataArrays SET hash = ? WHERE id = ?
+  )SQL"};
+  statement.run(hash, array_id.get());
+  return array_id;
+}
+
+auto DataStorage::create_partitioned_array_id(
+    DataSetID dataset_id,
+    std::string_view name,
+    DataType type,
+    std::span<const std::span<const byte_t>> parts) -> DataArrayID {
+  const auto array_id = create_array_id(dataset_id, name, type);
+  const auto byte_width = type.width();
+  std::vector<uint64_t> part_offsets{0};
+  for (const auto& part : parts) {
+    TIT_ASSERT(part.size() % byte_width == 0, "Truncated data!");
+    part_offsets.push_back(part_offsets.back() + part.size() / byte_width);
+  }
+
+  // External arrays are stored uncompressed, so the parts are just appended.
+  if (external_arrays_) {
+    const auto stream = array_data_open_write(array_id);
+    for (const auto& part : parts) stream->write(part);
+    stream->flush();
+  } else {
+    // Split the parts into the chunks, that never cross the part boundaries,
+    // and compress all the chunks in parallel.
+    struct PartChunk final {
+      std::span<const byte_t> data;
+      std::vector<byte_t> compressed;
+    };
+    std::vector<PartChunk> chunks;
+    for (const auto& part : parts) {
+      for (size_t offset = 0; offset < part.size(); offset += ArrayChunkSize) {
+        chunks.push_back(
+            {.data = part.subspan(offset,
+                                  std::min(ArrayChunkSize,
+                                           part.size() - offset)),
+             .compressed = {}});
+      }
+    }
+    const auto filter = default_filter(type);
+    const auto [dict_id, dictionary] =
+        dictionaries_ ? name_dictionary_(name) :
+                        std::pair<sqlite::RowID, std::vector<byte_t>>{};
+    par::for_each(
+        chunks,
+        [type, filter, level = compression_level_, &dictionary](
+            PartChunk& chunk) {
+          std::vector<byte_t> filtered(chunk.data.begin(), chunk.data.end());
+          filter_encode(filter, type, filtered);
+          zstd::compress(filtered,
+                         chunk.compressed,
+                         level,
+                         /*num_workers=*/0,
+                         dictionary);
+        });
+
+    // Store the compressed chunks one after the other.
+    std::vector<uint64_t> chunk_offsets;
+    chunk_offsets.reserve(2 * chunks.size());
+    size_t data_size = 0;
+    size_t compressed_size = 0;
+    for (const auto& chunk : chunks) {
+      chunk_offsets.push_back(data_size);
+      chunk_offsets.push_back(compressed_size);
+      data_size += chunk.data.size();
+      compressed_size += chunk.compressed.size();
+    }
+    {
+      sqlite::BlobWriter blob{db_,
+                              "DataArrays",
+                              "data",
+                              array_id.get(),
+                              compressed_size};
+      for (const auto& chunk : chunks) blob.write(chunk.compressed);
+    }
+    sqlite::Statement statement{db_, R"SQL(
+      UPDATE DataArrays
+      SET size = ?, chunks = ?, filter = ?, dict_id = nullif(?, 0)
+      WHERE id = ?
+    )SQL"};
+    statement.run(part_offsets.back(),
+                  std::as_bytes(std::span{chunk_offsets}),
+                  std::to_underlying(filter),
+                  dict_id,
+                  array_id.get());
+  }
+
+  // Store the part offsets.
+  sqlite::Statement parts_statement{db_, R"SQL(
+    UPDATE DataArrays SET parts = ? WHERE id = ?
+  )SQL"};
+  parts_statement.run(std::as_bytes(std::span{part_offsets}), array_id.get());
+  return array_id;
+}
+
 void DataStorage::delete_array(DataArrayID array_id) {
   TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
   sqlite::Statement statement{db_, R"SQL(
     DELETE FROM DataArrays WHERE id = ?
   )SQL"};
   statement.run(array_id.get());
+  cache_->erase(array_id);
+  reclaim_payloads_();
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -409,12 +1778,53 @@ auto DataStorage::array_size(DataArrayID array_id) const -> size_t {
   return statement.column<size_t>();
 }
 
+auto DataStorage::array_part_offsets(DataArrayID array_id) const
+    -> std::vector<size_t> {
+  TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT parts FROM DataArrays WHERE id = ?
+  )SQL"};
+  statement.bind(array_data_id_(array_id).get());
+  if (!statement.step()) TIT_THROW("Unable to get data array parts!");
+  const auto parts_blob = statement.column<sqlite::BlobView>();
+  if (parts_blob.empty()) return {0, array_size(array_id)};
+  std::vector<uint64_t> part_offsets(parts_blob.size() / sizeof(uint64_t));
+  std::memcpy(part_offsets.data(), parts_blob.data(), parts_blob.size());
+  return part_offsets | std::ranges::to<std::vector<size_t>>();
+}
+
+auto DataStorage::array_is_ref(DataArrayID array_id) const -> bool {
+  TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
+  return array_data_id_(array_id) != array_id;
+}
+
 auto DataStorage::array_data_open_write(DataArrayID array_id)
     -> OutputStreamPtr<byte_t> {
   TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
+  sqlite::Statement unref_statement{db_, R"SQL(
+    UPDATE DataArrays SET ref_id = NULL, hash = NULL, parts = NULL WHERE id = ?
+  )SQL"};
+  unref_statement.run(array_id.get());
+  cache_->erase(array_id);
+  OutputStreamPtr<byte_t> stream;
+  if (external_arrays_) {
+    stream = make_flushable<ExternalArrayWriter>(db_, payload_path(), array_id);
+  } else {
+    const auto type = array_type(array_id);
+    auto [dict_id, dictionary] =
+        dictionaries_ ? name_dictionary_(array_name_(array_id)) :
+                        std::pair<sqlite::RowID, std::vector<byte_t>>{};
+    stream = make_flushable<ChunkedArrayWriter>(db_,
+                                                array_id,
+                                                type,
+                                                default_filter(type),
+                                                compression_level_,
+                                                compression_workers_,
+                                                dict_id,
+                                                std::move(dictionary));
+  }
   return make_counting_output_stream(
-      zstd::make_stream_compressor(
-          sqlite::make_blob_writer(db_, "DataArrays", "data", array_id.get())),
+      std::move(stream),
       [this, array_id](size_t copied_bytes) {
         const auto byte_width = array_type(array_id).width();
         TIT_ASSERT(copied_bytes % byte_width == 0, "Truncated data!");
@@ -428,8 +1838,472 @@ auto DataStorage::array_data_open_write(DataArrayID array_id)
 auto DataStorage::array_data_open_read(DataArrayID array_id) const
     -> InputStreamPtr<byte_t> {
   TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
-  return zstd::make_stream_decompressor(
-      sqlite::make_blob_reader(db_, "DataArrays", "data", array_id.get()));
+  const auto data_id = array_data_id_(array_id);
+  if (const auto payload = array_payload_(data_id); payload.has_value()) {
+    const auto [offset, size] = *payload;
+    return std::make_unique<ExternalArrayReader>(array_payload_path_(data_id),
+                                                 offset,
+                                                 size);
+  }
+  auto stream = zstd::make_stream_decompressor(
+      sqlite::make_blob_reader(db_,
+                               "DataArrays",
+                               "data",
+                               data_id.get(),
+                               array_schema_(data_id)),
+      array_dictionary_(data_id));
+  if (const auto filter = array_filter_(data_id); filter != DataFilter::none) {
+    const auto type = array_type(array_id);
+    const auto chunk_offsets = array_chunk_offsets_(data_id);
+    return std::make_unique<ChunkedArrayReader>(
+        std::move(stream),
+        type,
+        filter,
+        chunk_sizes(chunk_offsets,
+                    0,
+                    chunk_offsets.size() / 2,
+                    array_size(array_id) * type.width()));
+  }
+  return stream;
+}
+
+auto DataStorage::array_is_external(DataArrayID array_id) const -> bool {
+  TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
+  return array_payload_(array_data_id_(array_id)).has_value();
+}
+
+auto DataStorage::array_data_map(DataArrayID array_id) const
+    -> DataArrayMapping {
+  TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
+  const auto data_id = array_data_id_(array_id);
+  const auto payload = array_payload_(data_id);
+  if (!payload.has_value()) TIT_THROW("Data array is not stored externally!");
+  const auto [offset, size] = *payload;
+  return DataArrayMapping{array_payload_path_(data_id), offset, size};
+}
+
+auto DataStorage::array_data_read_range(DataArrayID array_id,
+                                        size_t first,
+                                        size_t count) const
+    -> std::vector<byte_t> {
+  TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
+  TIT_ASSERT(first + count <= array_size(array_id), "Range is out of bounds!");
+  const auto byte_width = array_type(array_id).width();
+  const auto first_byte = first * byte_width;
+  std::vector<byte_t> result(count * byte_width);
+  if (result.empty()) return result;
+  const auto data_id = array_data_id_(array_id);
+
+  // Cached data is already decoded, so copy the range from it.
+  if (const auto cached = cache_->find(data_id); cached != nullptr) {
+    std::ranges::copy(std::span{*cached}.subspan(first_byte, result.size()),
+                      result.begin());
+    return result;
+  }
+
+  // External arrays are stored uncompressed, so read the range directly.
+  if (const auto payload = array_payload_(data_id); payload.has_value()) {
+    ExternalArrayReader reader{array_payload_path_(data_id),
+                               payload->first + first_byte,
+                               result.size()};
+    if (reader.read(result) != result.size()) {
+      TIT_THROW("Unable to read data array range: truncated data!");
+    }
+    return result;
+  }
+
+  // Load the chunk offsets.
+  sqlite::Statement index_statement{db_, R"SQL(
+    SELECT chunks, length(data) FROM DataArrays WHERE id = ?
+  )SQL"};
+  index_statement.bind(data_id.get());
+  if (!index_statement.step()) TIT_THROW("Unable to get data array chunks!");
+  const auto [index_blob, data_size] =
+      index_statement.columns<sqlite::BlobView, size_t>();
+  std::vector<uint64_t> chunk_offsets(index_blob.size() / sizeof(uint64_t));
+  if (!chunk_offsets.empty()) {
+    std::memcpy(chunk_offsets.data(), index_blob.data(), index_blob.size());
+  }
+
+  // If the array was written without the chunk offsets, decompress it from
+  // the beginning.
+  if (chunk_offsets.empty()) {
+    const auto stream = array_data_open_read(array_id);
+    skip_bytes(*stream, first_byte);
+    if (stream->read(result) != result.size()) {
+      TIT_THROW("Unable to read data array range: truncated data!");
+    }
+    return result;
+  }
+
+  // Find the chunks that contain the range.
+  const auto num_chunks = chunk_offsets.size() / 2;
+  const auto uncompressed_offset = [&chunk_offsets](size_t chunk) {
+    return chunk_offsets[2 * chunk];
+  };
+  const auto compressed_offset = [&chunk_offsets, num_chunks, data_size](
+                                     size_t chunk) -> size_t {
+    return chunk < num_chunks ? chunk_offsets[2 * chunk + 1] : data_size;
+  };
+  const auto chunks = std::views::iota(size_t{0}, num_chunks);
+  const auto first_chunk =
+      *std::ranges::prev(std::ranges::upper_bound(chunks,
+                                                  first_byte,
+                                                  std::less{},
+                                                  uncompressed_offset));
+  const auto last_chunk =
+      *std::ranges::lower_bound(chunks,
+                                first_byte + result.size(),
+                                std::less{},
+                                uncompressed_offset) -
+      1;
+
+  // Read and decompress only the needed chunks.
+  sqlite::Statement data_statement{db_, R"SQL(
+    SELECT substr(data, ?, ?) FROM DataArrays WHERE id = ?
+  )SQL"};
+  const auto compressed_first = compressed_offset(first_chunk);
+  data_statement.bind(
+      compressed_first + 1, // SQL strings are one-based.
+      compressed_offset(last_chunk + 1) - compressed_first,
+      data_id.get());
+  if (!data_statement.step()) TIT_THROW("Unable to read data array chunks!");
+  const auto compressed = data_statement.column<std::vector<byte_t>>();
+  const auto stream = std::make_unique<ChunkedArrayReader>(
+      zstd::make_stream_decompressor(make_range_input_stream(compressed),
+                                     array_dictionary_(data_id)),
+      array_type(array_id),
+      array_filter_(data_id),
+      chunk_sizes(chunk_offsets,
+                  first_chunk,
+                  last_chunk + 1,
+                  array_size(array_id) * byte_width));
+  skip_bytes(*stream, first_byte - uncompressed_offset(first_chunk));
+  if (stream->read(result) != result.size()) {
+    TIT_THROW("Unable to read data array range: truncated data!");
+  }
+  return result;
+}
+
+void DataStorage::array_data_read_all(
+    std::span<const DataArrayID> array_ids,
+    std::span<std::vector<byte_t>> buffers) const {
+  TIT_ASSERT(array_ids.size() == buffers.size(), "Size mismatch!");
+  std::vector<std::span<byte_t>> outputs;
+  outputs.reserve(array_ids.size());
+  for (auto&& [array_id, buffer] : std::views::zip(array_ids, buffers)) {
+    TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
+    buffer.resize(array_size(array_id) * array_type(array_id).width());
+    outputs.emplace_back(buffer);
+  }
+  array_data_decode_(array_ids, outputs);
+}
+
+void DataStorage::array_data_read_into(DataArrayID array_id,
+                                       std::span<byte_t> data) const {
+  array_data_read_all_into(std::span{&array_id, 1}, std::span{&data, 1});
+}
+
+void DataStorage::array_data_read_all_into(
+    std::span<const DataArrayID> array_ids,
+    std::span<const std::span<byte_t>> outputs) const {
+  TIT_ASSERT(array_ids.size() == outputs.size(), "Size mismatch!");
+  for (const auto& [array_id, data] : std::views::zip(array_ids, outputs)) {
+    TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
+    const auto data_size = array_size(array_id) * array_type(array_id).width();
+    if (data.size() != data_size) {
+      TIT_THROW("Data array size is {} bytes, but the buffer is {} bytes.",
+                data_size,
+                data.size());
+    }
+  }
+  array_data_decode_(array_ids, outputs);
+}
+
+void DataStorage::array_data_decode_(
+    std::span<const DataArrayID> array_ids,
+    std::span<const std::span<byte_t>> outputs) const {
+  TIT_ASSERT(array_ids.size() == outputs.size(), "Size mismatch!");
+
+  // Load the encoded data and split it into the independently decodable
+  // pieces. Database is only accessed from the calling thread.
+  const auto num_arrays = array_ids.size();
+  std::vector<ArraySource> sources;
+  sources.reserve(num_arrays);
+  std::vector<ArrayPiece> pieces;
+  sqlite::Statement data_statement{db_, R"SQL(
+    SELECT data, chunks FROM DataArrays WHERE id = ?
+  )SQL"};
+  for (size_t index = 0; index < num_arrays; ++index) {
+    const auto array_id = array_ids[index];
+    auto& source = sources.emplace_back(array_type(array_id));
+    const auto data_size = outputs[index].size();
+    TIT_ASSERT(data_size == array_size(array_id) * source.type.width(),
+               "Output size does not match the data array size!");
+    if (data_size == 0) continue;
+    const auto data_id = array_data_id_(array_id);
+
+    // External arrays are stored uncompressed, so they are read directly.
+    if (const auto payload = array_payload_(data_id); payload.has_value()) {
+      source.payload_path = array_payload_path_(data_id);
+      pieces.push_back({.index = index,
+                        .data_offset = 0,
+                        .data_size = data_size,
+                        .source_offset = payload->first,
+                        .source_size = data_size});
+      continue;
+    }
+
+    // Load the compressed data and the chunk offsets.
+    source.filter = array_filter_(data_id);
+    source.dictionary = array_dictionary_(data_id);
+    data_statement.reset();
+    data_statement.bind(data_id.get());
+    if (!data_statement.step()) TIT_THROW("Unable to read data array!");
+    auto [data, index_blob] =
+        data_statement.columns<std::vector<byte_t>, sqlite::BlobView>();
+    source.data = std::move(data);
+    std::vector<uint64_t> chunk_offsets(index_blob.size() / sizeof(uint64_t));
+    if (!chunk_offsets.empty()) {
+      std::memcpy(chunk_offsets.data(), index_blob.data(), index_blob.size());
+    }
+
+    // If the array was written without the chunk offsets, it is decoded as
+    // a single piece.
+    const auto source_size = source.data.size();
+    if (chunk_offsets.empty()) {
+      pieces.push_back({.index = index,
+                        .data_offset = 0,
+                        .data_size = data_size,
+                        .source_offset = 0,
+                        .source_size = source_size});
+      continue;
+    }
+
+    // Otherwise, each chunk is decoded as a separate piece.
+    const auto num_chunks = chunk_offsets.size() / 2;
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      const auto last = chunk + 1 == num_chunks;
+      const auto data_first = chunk_offsets[2 * chunk];
+      const auto data_last = last ? data_size : chunk_offsets[2 * chunk + 2];
+      const auto source_first = chunk_offsets[2 * chunk + 1];
+      const auto source_last =
+          last ? source_size : chunk_offsets[2 * chunk + 3];
+      pieces.push_back({.index = index,
+                        .data_offset = data_first,
+                        .data_size = data_last - data_first,
+                        .source_offset = source_first,
+                        .source_size = source_last - source_first});
+    }
+  }
+
+  // Decode the pieces in parallel, straight into the output buffers.
+  par::for_each(pieces, [&sources, outputs](const ArrayPiece& piece) {
+    const auto& source = sources[piece.index];
+    const auto data =
+        outputs[piece.index].subspan(piece.data_offset, piece.data_size);
+    if (!source.payload_path.empty()) {
+      ExternalArrayReader reader{source.payload_path,
+                                 piece.source_offset,
+                                 piece.source_size};
+      if (reader.read(data) != data.size()) {
+        TIT_THROW("Unable to read data array: truncated data!");
+      }
+      return;
+    }
+    const auto encoded = std::span<const byte_t>{source.data}.subspan(
+        piece.source_offset,
+        piece.source_size);
+    if (zstd::decompress(encoded, data, source.dictionary) != data.size()) {
+      TIT_THROW("Unable to read data array: truncated data!");
+    }
+    if (source.filter == DataFilter::none) return;
+
+    // Pieces start on the chunk boundaries, and the chunks are filtered
+    // independently, so they are decoded in place.
+    for (size_t offset = 0; offset < data.size(); offset += ArrayChunkSize) {
+      const auto size = std::min(ArrayChunkSize, data.size() - offset);
+      filter_decode(source.filter, source.type, data.subspan(offset, size));
+    }
+  });
+}
+
+auto DataStorage::array_data_read(DataArrayID array_id) const
+    -> DataArrayCache::Buffer {
+  TIT_ASSERT(check_array(array_id), "Invalid data array ID!");
+
+  // Data is cached by the ID of the array that holds it, so that the arrays
+  // referring to the same data share the cached buffer.
+  const auto data_id = array_data_id_(array_id);
+  if (auto cached = cache_->find(data_id); cached != nullptr) return cached;
+  std::vector<byte_t> data;
+  array_data_read_all(std::span{&array_id, 1}, std::span{&data, 1});
+  auto buffer = std::make_shared<const std::vector<byte_t>>(std::move(data));
+  cache_->insert(data_id, buffer);
+  return buffer;
+}
+
+auto DataStorage::cache_capacity() const -> size_t {
+  return cache_->capacity();
+}
+
+void DataStorage::set_cache_capacity(size_t capacity) {
+  cache_->set_capacity(capacity);
+}
+
+auto DataStorage::array_data_id_(DataArrayID array_id) const -> DataArrayID {
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT coalesce(ref_id, id) FROM DataArrays WHERE id = ?
+  )SQL"};
+  statement.bind(array_id.get());
+  if (!statement.step()) TIT_THROW("Unable to get data array reference!");
+  return DataArrayID{statement.column<sqlite::RowID>()};
+}
+
+auto DataStorage::array_hash_(DataArrayID array_id) const
+    -> std::optional<uint64_t> {
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT hash IS NOT NULL, coalesce(hash, 0) FROM DataArrays WHERE id = ?
+  )SQL"};
+  statement.bind(array_id.get());
+  if (!statement.step()) TIT_THROW("Unable to get data array hash!");
+  const auto [has_hash, hash] = statement.columns<bool, uint64_t>();
+  if (!has_hash) return std::nullopt;
+  return hash;
+}
+
+auto DataStorage::array_name_(DataArrayID array_id) const -> std::string {
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT name FROM DataArrays WHERE id = ?
+  )SQL"};
+  statement.bind(array_id.get());
+  if (!statement.step()) TIT_THROW("Unable to get data array name!");
+  return statement.column<std::string>();
+}
+
+auto DataStorage::array_dictionary_(DataArrayID array_id) const
+    -> std::vector<byte_t> {
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT DataDictionaries.data
+    FROM DataArrays JOIN DataDictionaries
+      ON DataDictionaries.id = DataArrays.dict_id
+    WHERE DataArrays.id = ?
+  )SQL"};
+  statement.bind(array_id.get());
+  if (!statement.step()) return {};
+  return statement.column<std::vector<byte_t>>();
+}
+
+auto DataStorage::name_dictionary_(std::string_view name)
+    -> std::pair<sqlite::RowID, std::vector<byte_t>> {
+  // Use the existing dictionary. Empty dictionary means the training has
+  // failed, and the arrays with this name are compressed without it.
+  sqlite::Statement find_statement{db_, R"SQL(
+    SELECT id, data FROM DataDictionaries WHERE name = ?
+  )SQL"};
+  find_statement.bind(name);
+  if (find_statement.step()) {
+    auto [dict_id, dictionary] =
+        find_statement.columns<sqlite::RowID, std::vector<byte_t>>();
+    if (dictionary.empty()) return {};
+    return {dict_id, std::move(dictionary)};
+  }
+
+  // Find the first arrays with this name, that were compressed without the
+  // dictionary. If there are not enough of them, try again later.
+  sqlite::Statement arrays_statement{db_, R"SQL(
+    SELECT id FROM DataArrays
+    WHERE name = ? AND data IS NOT NULL AND dict_id IS NULL
+    ORDER BY id LIMIT ?
+  )SQL"};
+  arrays_statement.bind(name, DictTrainingArrays);
+  std::vector<sqlite::RowID> array_ids;
+  while (arrays_statement.step()) {
+    array_ids.push_back(arrays_statement.column<sqlite::RowID>());
+  }
+  if (array_ids.size() < DictTrainingArrays) return {};
+
+  // Collect the samples. Chunks are filtered before the compression, so
+  // the dictionary is trained on the filtered data.
+  std::vector<byte_t> samples;
+  std::vector<size_t> sample_sizes;
+  for (const auto array_id : array_ids) {
+    const auto stream = zstd::make_stream_decompressor(
+        sqlite::make_blob_reader(db_, "DataArrays", "data", array_id));
+    for (size_t total = 0; total < DictArraySamplesSize;) {
+      const auto offset = samples.size();
+      samples.resize(offset + DictSampleSize);
+      const auto size =
+          stream->read(std::span{samples}.subspan(offset, DictSampleSize));
+      samples.resize(offset + size);
+      if (size == 0) break;
+      sample_sizes.push_back(size);
+      total += size;
+    }
+  }
+
+  // Train and store the dictionary.
+  const auto dictionary =
+      zstd::train_dictionary(samples, sample_sizes, DictMaxSize);
+  sqlite::Statement insert_statement{db_, R"SQL(
+    INSERT INTO DataDictionaries (name, data) VALUES (?, ?)
+  )SQL"};
+  insert_statement.run(name, dictionary);
+  if (dictionary.empty()) return {};
+  return {db_.last_insert_row_id(), dictionary};
+}
+
+auto DataStorage::array_filter_(DataArrayID array_id) const -> DataFilter {
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT coalesce(filter, 0) FROM DataArrays WHERE id = ?
+  )SQL"};
+  statement.bind(array_id.get());
+  if (!statement.step()) TIT_THROW("Unable to get data array filter!");
+  return static_cast<DataFilter>(statement.column<uint8_t>());
+}
+
+auto DataStorage::array_chunk_offsets_(DataArrayID array_id) const
+    -> std::vector<uint64_t> {
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT chunks FROM DataArrays WHERE id = ?
+  )SQL"};
+  statement.bind(array_id.get());
+  if (!statement.step()) TIT_THROW("Unable to get data array chunks!");
+  const auto index_blob = statement.column<sqlite::BlobView>();
+  std::vector<uint64_t> chunk_offsets(index_blob.size() / sizeof(uint64_t));
+  if (!chunk_offsets.empty()) {
+    std::memcpy(chunk_offsets.data(), index_blob.data(), index_blob.size());
+  }
+  return chunk_offsets;
+}
+
+auto DataStorage::array_payload_(DataArrayID array_id) const
+    -> std::optional<std::pair<size_t, size_t>> {
+  sqlite::Statement statement{db_, R"SQL(
+    SELECT payload_offset IS NOT NULL, payload_offset, payload_size
+    FROM DataArrays WHERE id = ?
+  )SQL"};
+  statement.bind(array_id.get());
+  if (!statement.step()) TIT_THROW("Unable to get data array payload!");
+  const auto [is_external, offset, size] =
+      statement.columns<bool, size_t, size_t>();
+  if (!is_external) return std::nullopt;
+  return std::pair{offset, size};
+}
+
+auto DataStorage::array_schema_(DataArrayID array_id) const -> std::string {
+  const auto index = static_cast<size_t>(array_id.get()) >> ShardIdBits;
+  if (!std::ranges::contains(shards_, index)) return "main";
+  return shard_schema(index);
+}
+
+auto DataStorage::array_payload_path_(DataArrayID array_id) const
+    -> std::filesystem::path {
+  const auto index = static_cast<size_t>(array_id.get()) >> ShardIdBits;
+  if (!std::ranges::contains(shards_, index)) return payload_path();
+  auto result = shard_path(index);
+  result += ".payload";
+  return result;
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -5,26 +5,40 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <concepts>
+#include <cstring>
 #include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <ranges>
 #include <span>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/numbers/strict.hpp"
 #include "tit/core/serialization.hpp"
 #include "tit/core/stream.hpp"
-
+#include "tit/core/uint_utils.hpp"
 #include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/data/filter.hpp"
 #include "tit/data/sqlite.hpp"
 #include "tit/data/type.hpp"
 
+#include "tit/geom/bbox.hpp"
+
 namespace tit::data {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -48,6 +62,125 @@ using DataSetID = Strict<sqlite::RowID, impl::DataSetTag>;
 /// Data array ID type.
 using DataArrayID = Strict<sqlite::RowID, impl::DataArrayTag>;
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Data storage journal mode.
+enum class JournalMode : uint8_t {
+  rollback, ///< Rollback journal, deleted after each transaction.
+  wal,      ///< Write-ahead log, requires fewer synchronizations.
+};
+
+/// Data storage open mode.
+enum class OpenMode : uint8_t {
+  read_write, ///< Open or create the storage for reading and writing.
+  read_only,  ///< Open the existing storage for reading only.
+};
+
+/// Data storage synchronization mode.
+enum class SyncMode : uint8_t {
+  off,    ///< No synchronization, the fastest, but unsafe on power loss.
+  normal, ///< Synchronize at the critical moments only. Safe with WAL.
+  full,   ///< Synchronize after each transaction.
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Read-only memory mapping of the external data array payload.
+class DataArrayMapping final {
+public:
+
+  /// Construct an empty mapping.
+  DataArrayMapping() = default;
+
+  /// Map the @p size bytes of the file starting at @p offset.
+  DataArrayMapping(const std::filesystem::path& path,
+                   size_t offset,
+                   size_t size);
+
+  /// Move-construct the mapping.
+  DataArrayMapping(DataArrayMapping&& other) noexcept;
+
+  /// Mapping is not copy-constructible.
+  DataArrayMapping(const DataArrayMapping&) = delete;
+
+  /// Move-assign the mapping.
+  auto operator=(DataArrayMapping&& other) noexcept -> DataArrayMapping&;
+
+  /// Mapping is not copy-assignable.
+  auto operator=(const DataArrayMapping&) -> DataArrayMapping& = delete;
+
+  /// Unmap the file.
+  ~DataArrayMapping();
+
+  /// Mapped data.
+  auto data() const noexcept -> std::span<const byte_t> {
+    return data_;
+  }
+
+private:
+
+  void* base_ = nullptr;
+  size_t base_size_ = 0;
+  std::span<const byte_t> data_;
+
+}; // class DataArrayMapping
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Size-bounded cache of the decoded data array data.
+///
+/// The least recently used data is evicted first, once the total size of the
+/// cached data exceeds the capacity. Cached buffers are shared and immutable,
+/// so they stay valid after being evicted. Cache is thread-safe.
+class DataArrayCache final {
+public:
+
+  /// Shared immutable data buffer.
+  using Buffer = std::shared_ptr<const std::vector<byte_t>>;
+
+  /// Construct the cache with the given capacity, in bytes.
+  explicit DataArrayCache(size_t capacity);
+
+  /// Cache capacity, in bytes.
+  auto capacity() const -> size_t;
+
+  /// Set the cache capacity, in bytes. Zero capacity disables the cache.
+  void set_capacity(size_t capacity);
+
+  /// Total size of the cached data, in bytes.
+  auto size() const -> size_t;
+
+  /// Find the cached data of the data array and mark it as recently used.
+  /// Null buffer is returned if the data is not cached.
+  auto find(DataArrayID array_id) -> Buffer;
+
+  /// Cache the data of the data array, replacing the existing data.
+  /// Data that exceeds the capacity by itself is not cached.
+  void insert(DataArrayID array_id, Buffer buffer);
+
+  /// Remove the data of the data array from the cache.
+  void erase(DataArrayID array_id);
+
+  /// Remove all the data from the cache.
+  void clear();
+
+private:
+
+  using Entry_ = std::pair<DataArrayID, Buffer>;
+
+  // Evict the least recently used data until it fits into the capacity.
+  void evict_();
+
+  mutable std::mutex mutex_;
+  size_t capacity_;
+  size_t size_ = 0;
+  std::list<Entry_> entries_;
+  std::unordered_map<sqlite::RowID, std::list<Entry_>::iterator> index_;
+
+}; // class DataArrayCache
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Data storage type.
 template<class Storage>
 concept data_storage =
@@ -103,6 +236,12 @@ public:
     return storage().array_size(array_id_);
   }
 
+  /// Get the offsets of the parts of the data array (in elements), see
+  /// `DataStorage::create_partitioned_array_id`.
+  auto part_offsets() const -> std::vector<size_t> {
+    return storage().array_part_offsets(array_id_);
+  }
+
   /// Open an output stream to write the data.
   /// @{
   auto open_write() const -> OutputStreamPtr<byte_t>
@@ -129,6 +268,45 @@ public:
   }
   /// @}
 
+  /// Read the whole data through the data array cache.
+  auto read() const -> DataArrayCache::Buffer {
+    return storage().array_data_read(array_id_);
+  }
+
+  /// Read the whole data straight into the buffer.
+  /// @{
+  void read_into(std::span<byte_t> data) const {
+    storage().array_data_read_into(array_id_, data);
+  }
+  template<known_type_of Val>
+  void read_into(std::span<Val> vals) const {
+    storage().template array_data_read_into<Val>(array_id_, vals);
+  }
+  /// @}
+
+  /// Read the range of elements of the data.
+  /// @{
+  auto read_range(size_t first, size_t count) const -> std::vector<byte_t> {
+    return storage().array_data_read_range(array_id_, first, count);
+  }
+  template<known_type_of Val>
+  auto read_range(size_t first, size_t count) const -> std::vector<Val> {
+    return storage().template array_data_read_range<Val>(array_id_,
+                                                         first,
+                                                         count);
+  }
+  /// @}
+
+  /// Check if the data is stored in the external payload file.
+  auto is_external() const -> bool {
+    return storage().array_is_external(array_id_);
+  }
+
+  /// Map the external data into memory.
+  auto map() const -> DataArrayMapping {
+    return storage().array_data_map(array_id_);
+  }
+
 private:
 
   Storage* storage_ = nullptr;
@@ -138,6 +316,42 @@ private:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+template<data_storage Storage>
+class DataSetView;
+
+/// Data of the data array, that was read along with the other data arrays.
+template<data_storage Storage>
+struct DataArrayContents final {
+
+  /// Dataset the data array belongs to.
+  DataSetView<Storage> dataset;
+
+  /// Name of the data array.
+  std::string name;
+
+  /// Data array view.
+  DataArrayView<Storage> array;
+
+  /// Data of the data array.
+  std::vector<byte_t> data;
+
+}; // struct DataArrayContents
+
+/// Data of the particles within a region, see `DataTimeStepView::read_region`.
+template<data_storage Storage>
+struct DataRegion final {
+
+  /// Indices of the particles within the region in the varying data arrays.
+  std::vector<size_t> indices;
+
+  /// Data of the requested varying data arrays, for the particles within the
+  /// region only, in the order of the indices.
+  std::vector<DataArrayContents<Storage>> arrays;
+
+}; // struct DataRegion
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Dataset view.
 template<data_storage Storage>
 class DataSetView final {
@@ -191,6 +405,19 @@ public:
     return storage().find_array(dataset_id_, name);
   }
 
+  /// Read the data of all data arrays in the dataset at once. Arrays are
+  /// decompressed in parallel.
+  /// @{
+  void read_all(std::vector<DataArrayContents<Storage>>& contents) const {
+    storage().datasets_read_all(std::span{&dataset_id_, 1}, contents);
+  }
+  auto read_all() const -> std::vector<DataArrayContents<Storage>> {
+    std::vector<DataArrayContents<Storage>> contents;
+    read_all(contents);
+    return contents;
+  }
+  /// @}
+
   /// Create a new data array in the dataset.
   template<class... Args>
   auto create_array(std::string_view name, Args&&... args) const
@@ -202,6 +429,58 @@ public:
                                   std::forward<Args>(args)...);
   }
 
+  /// Create a new data array in the dataset from the parts of its data.
+  template<class... Args>
+  auto create_partitioned_array(std::string_view name, Args&&... args) const
+      -> DataArrayView<Storage>
+    requires (!std::is_const_v<Storage>)
+  {
+    return storage().create_partitioned_array(dataset_id_,
+                                              name,
+                                              std::forward<Args>(args)...);
+  }
+
+  /// Create a new data array in the dataset that refers to the data of the
+  /// existing data array.
+  auto create_array_ref(std::string_view name,
+                        DataArrayView<Storage> source) const
+      -> DataArrayView<Storage>
+    requires (!std::is_const_v<Storage>)
+  {
+    return storage().create_array_ref(dataset_id_, name, source.id());
+  }
+
+  /// Create a new data array in the dataset, or a reference to the data array
+  /// with the same name in the @p previous dataset, if its data is identical.
+  /// @{
+  template<std::ranges::input_range Vals>
+  auto create_array_or_ref(std::string_view name,
+                           Vals&& vals,
+                           std::optional<DataSetView> previous) const
+      -> DataArrayView<Storage>
+    requires (!std::is_const_v<Storage>)
+  {
+    return storage().create_array_or_ref(
+        dataset_id_,
+        name,
+        std::forward<Vals>(vals),
+        previous.transform(&DataSetView::id));
+  }
+  auto create_array_or_ref(std::string_view name,
+                           DataType type,
+                           std::span<const byte_t> data,
+                           std::optional<DataSetView> previous) const
+      -> DataArrayView<Storage>
+    requires (!std::is_const_v<Storage>)
+  {
+    return storage().create_array_or_ref(dataset_id_,
+                                         name,
+                                         type,
+                                         data,
+                                         previous.transform(&DataSetView::id));
+  }
+  /// @}
+
 private:
 
   Storage* storage_ = nullptr;
@@ -265,6 +544,72 @@ public:
     return storage().time_step_varyings(time_step_id_);
   }
 
+  /// Get the number of the decimated levels of the varying dataset.
+  auto num_levels() const -> size_t {
+    return storage().time_step_num_levels(time_step_id_);
+  }
+
+  /// Get the decimated level of the varying dataset. Level zero is the
+  /// varying dataset itself, the following ones are coarser and coarser.
+  auto level(size_t level) const -> DataSetView<Storage> {
+    return storage().time_step_level(time_step_id_, level);
+  }
+
+  /// Read the data of all data arrays of the uniform and the varying datasets
+  /// at once. Arrays are decompressed in parallel.
+  /// @{
+  void read_all(std::vector<DataArrayContents<Storage>>& contents) const {
+    const std::array dataset_ids{uniforms().id(), varyings().id()};
+    storage().datasets_read_all(dataset_ids, contents);
+  }
+  auto read_all() const -> std::vector<DataArrayContents<Storage>> {
+    std::vector<DataArrayContents<Storage>> contents;
+    read_all(contents);
+    return contents;
+  }
+  /// @}
+
+  /// Create the next decimated level of the varying dataset.
+  auto create_level() const -> DataSetView<Storage>
+    requires (!std::is_const_v<Storage>)
+  {
+    return storage().create_time_step_level(time_step_id_);
+  }
+
+  /// Check if the time step has the spatial index of the particles.
+  auto has_index() const -> bool {
+    return storage().time_step_has_index(time_step_id_);
+  }
+
+  /// Get the spatial index dataset of the time step.
+  auto index() const -> DataSetView<Storage> {
+    return storage().time_step_index(time_step_id_);
+  }
+
+  /// Create the spatial index of the particles, see
+  /// `DataStorage::create_time_step_index`.
+  template<std::ranges::random_access_range Points>
+  auto create_index(DataArrayView<Storage> positions,
+                    Points&& points,
+                    size_t block_size = Storage::DefaultIndexBlockSize) const
+      -> DataSetView<Storage>
+    requires (!std::is_const_v<Storage>)
+  {
+    return storage().create_time_step_index(time_step_id_,
+                                            positions.id(),
+                                            std::forward<Points>(points),
+                                            block_size);
+  }
+
+  /// Read the data of the varying arrays for the particles within the
+  /// bounding box, see `DataStorage::time_step_read_region`.
+  template<class Point>
+  auto read_region(const geom::BBox<Point>& box,
+                   std::span<const std::string_view> names) const
+      -> DataRegion<Storage> {
+    return storage().time_step_read_region(time_step_id_, box, names);
+  }
+
 private:
 
   Storage* storage_ = nullptr;
@@ -332,6 +677,26 @@ public:
     return storage().series_last_time_step(series_id_);
   }
 
+  /// Record the telemetry value of the data series.
+  void record_telemetry(size_t step,
+                        std::string_view name,
+                        float64_t value) const
+    requires (!std::is_const_v<Storage>)
+  {
+    storage().series_record_telemetry(series_id_, step, name, value);
+  }
+
+  /// Get the names of the telemetry metrics of the data series.
+  auto telemetry_names() const -> std::vector<std::string> {
+    return storage().series_telemetry_names(series_id_);
+  }
+
+  /// Get the telemetry values of the metric of the data series.
+  auto telemetry(std::string_view name) const
+      -> std::vector<std::pair<size_t, float64_t>> {
+    return storage().series_telemetry(series_id_, name);
+  }
+
   /// Create a new time step in the data series.
   auto create_time_step(real_t time) const -> DataTimeStepView<Storage>
     requires (!std::is_const_v<Storage>)
@@ -355,21 +720,163 @@ public:
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+  /// Default time to wait for the other connections, see `set_busy_timeout`.
+  static constexpr std::chrono::milliseconds DefaultBusyTimeout{5000};
+
+  /// Default number of the particles in a spatial index block, see
+  /// `create_time_step_index`.
+  static constexpr size_t DefaultIndexBlockSize = 4096;
+
+  /// Default capacity of the data array cache, see `set_cache_capacity`.
+  static constexpr size_t DefaultCacheCapacity = 256 * 1024 * 1024;
+
+  /// Maximum number of the storage shards, see `open_shard`. Read-only
+  /// storage attaches all of its shards, and SQLite attaches at most 10
+  /// databases to a connection by default.
+  static constexpr size_t MaxShards = 10;
+
   /// Open a data storage or create it if it does not exist.
-  explicit DataStorage(const std::filesystem::path& path);
+  ///
+  /// Storage may be opened by several processes at once, e.g. the solver
+  /// that writes the storage and the monitoring tools that read it. Readers
+  /// should open the storage in the read-only mode, and the writer should
+  /// switch it to the WAL journal mode, see `set_journal_mode`, so that the
+  /// readers never block the writer, and vice versa. Each read is then done
+  /// from a consistent snapshot of the storage, and the reads are grouped
+  /// into a single snapshot by wrapping them into a transaction. Read-only
+  /// storage is not upgraded, the older schemas are presented as the current
+  /// one instead.
+  explicit DataStorage(const std::filesystem::path& path,
+                       OpenMode mode = OpenMode::read_write);
+
+  /// Check if the storage is opened in the read-only mode.
+  auto read_only() const noexcept -> bool;
 
   /// Path to the database file.
   auto path() const -> std::filesystem::path;
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+  /// Data storage transaction.
+  ///
+  /// All the changes made within the transaction scope are committed at once
+  /// when the scope is left normally, and rolled back if it is left due to an
+  /// exception. Transactions may be nested, in which case the changes are
+  /// committed only by the outermost transaction.
+  class Transaction final {
+  public:
+
+    /// Begin a transaction.
+    explicit Transaction(DataStorage& storage);
+
+    TIT_NOT_COPYABLE_OR_MOVABLE(Transaction);
+
+    /// Commit the transaction, or roll it back if an exception is thrown.
+    ~Transaction() noexcept;
+
+  private:
+
+    DataStorage* storage_;
+    int num_exceptions_;
+
+  }; // class Transaction
+
+  /// Begin a transaction.
+  auto transaction() -> Transaction;
+
+  /// Lock the storage for the exclusive access.
+  ///
+  /// Storage is not thread-safe by itself. Concurrent writers, e.g. the
+  /// simulations of an ensemble that write into different data series, must
+  /// hold the lock while accessing the storage. Lock is recursive, so it may
+  /// be taken again by the thread that holds it.
+  auto lock() const -> std::unique_lock<std::recursive_mutex>;
+
+  /// Get the journal mode.
+  auto journal_mode() const -> JournalMode;
+
+  /// Set the journal mode. In-memory storages ignore the setting.
+  void set_journal_mode(JournalMode mode);
+
+  /// Get the synchronization mode.
+  auto sync_mode() const -> SyncMode;
+
+  /// Set the synchronization mode. Setting is not persisted in the storage.
+  void set_sync_mode(SyncMode mode);
+
+  /// Set the time to wait for the locks held by the other connections, before
+  /// the operations fail as busy. Setting is not persisted in the storage.
+  void set_busy_timeout(std::chrono::milliseconds timeout);
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
   /// Get the maximum number of data series.
   auto max_series() const -> size_t;
 
   /// Set the maximum number of data series. If the number of series exceeds the
-  /// maximum, the oldest series will be deleted.
+  /// maximum, the oldest series will be retired, see `purge_retired`.
   void set_max_series(size_t value);
 
+  /// Get the compression level of the newly written data arrays.
+  auto compression_level() const noexcept -> int;
+
+  /// Set the compression level of the newly written data arrays. Zero means
+  /// the default level. Setting is not persisted in the storage.
+  void set_compression_level(int value) noexcept;
+
+  /// Get the number of compression worker threads.
+  auto compression_workers() const noexcept -> size_t;
+
+  /// Set the number of compression worker threads. Zero means the data is
+  /// compressed on the writing thread. Setting is not persisted in the
+  /// storage.
+  void set_compression_workers(size_t value) noexcept;
+
+  /// Check if the newly written data arrays are compressed with the
+  /// dictionaries.
+  auto dictionaries() const noexcept -> bool;
+
+  /// Compress the newly written data arrays with the dictionaries. Dictionary
+  /// is trained per data array name once a few arrays with this name were
+  /// written, and is stored in the storage. Setting is not persisted in the
+  /// storage.
+  void set_dictionaries(bool value) noexcept;
+
+  /// Check if the newly written data arrays are stored externally.
+  auto external_arrays() const noexcept -> bool;
+
+  /// Store the newly written data arrays uncompressed in the append-only
+  /// payload file next to the database, so that they could be memory-mapped
+  /// for reading. Only the metadata is kept in the database. Requires the
+  /// storage to be backed by a file. Setting is not persisted in the storage.
+  void set_external_arrays(bool value);
+
+  /// Path to the external data array payload file.
+  auto payload_path() const -> std::filesystem::path;
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Open a shard of the storage or create it if it does not exist.
+  ///
+  /// Shard is a separate storage file next to the main one, see `shard_path`,
+  /// with its own connection, so that the concurrent writers, e.g. the
+  /// simulations of an ensemble, that write into the different shards never
+  /// wait for each other on the storage lock or on the database write lock.
+  /// Each shard allocates the IDs from its own range, and the main storage
+  /// keeps the list of its shards. Storage that is opened in the read-only
+  /// mode attaches all the listed shards, and presents their series along
+  /// with its own ones, so the readers see a single storage. Shards that are
+  /// created after the read-only storage was opened are not visible to it.
+  ///
+  /// @param index Index of the shard, from 1 to `MaxShards`.
+  auto open_shard(size_t index) -> DataStorage;
+
+  /// Path to the shard database file.
+  auto shard_path(size_t index) const -> std::filesystem::path;
+
+  /// Indices of the shards of the storage.
+  auto shard_indices() const -> std::vector<size_t>;
+
   /// Number of data series in the storage.
   auto num_series() const -> size_t;
 
@@ -391,7 +898,8 @@ public:
   }
   /// @}
 
-  /// Create a new data series.
+  /// Create a new data series. If the maximum number of series is reached,
+  /// the oldest series is retired, see `purge_retired`.
   /// @{
   auto create_series_id(std::string_view parameters = "") -> DataSeriesID;
   auto create_series(std::string_view parameters = "")
@@ -403,6 +911,19 @@ public:
   /// Delete a data series.
   void delete_series(DataSeriesID series_id);
 
+  /// Delete the data of the retired series, at most @p max_time_steps time
+  /// steps at once, and return the freed pages to the file system.
+  ///
+  /// Series that exceed the maximum number of series are not deleted at once,
+  /// they are only retired, so that they are no longer visible. Deleting the
+  /// large data arrays is slow, so it is done here step by step, e.g. after
+  /// each time step is written, instead of stalling the creation of a new
+  /// series. Storages created with the older versions are not shrunk until
+  /// they are fully vacuumed.
+  ///
+  /// @returns True if no retired series are left.
+  auto purge_retired(size_t max_time_steps = 16) -> bool;
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Check if a data series with the given ID exists.
@@ -433,6 +954,28 @@ public:
   }
   /// @}
 
+  /// Record the telemetry value of the series.
+  ///
+  /// Telemetry is a set of the named scalar metrics, such as the wall time
+  /// or the number of neighbors, recorded at the simulation steps. It is kept
+  /// separately from the time steps, so that it could be recorded at every
+  /// step, not only at the steps when the data is written. Recording the
+  /// same metric at the same step again replaces the value.
+  void series_record_telemetry(DataSeriesID series_id,
+                               size_t step,
+                               std::string_view name,
+                               float64_t value);
+
+  /// Get the names of the telemetry metrics recorded in the series, in the
+  /// alphabetical order.
+  auto series_telemetry_names(DataSeriesID series_id) const
+      -> std::vector<std::string>;
+
+  /// Get the telemetry values of the metric recorded in the series, as pairs
+  /// of the step and the value, in the order of the steps.
+  auto series_telemetry(DataSeriesID series_id, std::string_view name) const
+      -> std::vector<std::pair<size_t, float64_t>>;
+
   /// Create a new time step in the series.
   /// @{
   auto create_time_step_id(DataSeriesID series_id, real_t time)
@@ -470,6 +1013,190 @@ public:
   }
   /// @}
 
+  /// Get the number of the decimated levels of a time step.
+  auto time_step_num_levels(DataTimeStepID time_step_id) const -> size_t;
+
+  /// Get the decimated level of a time step. Level zero is the varying
+  /// dataset.
+  /// @{
+  auto time_step_level_id(DataTimeStepID time_step_id, size_t level) const
+      -> DataSetID;
+  auto time_step_level(this auto& self,
+                       DataTimeStepID time_step_id,
+                       size_t level) {
+    return DataSetView{self, self.time_step_level_id(time_step_id, level)};
+  }
+  /// @}
+
+  /// Create the next decimated level of a time step.
+  /// @{
+  auto create_time_step_level_id(DataTimeStepID time_step_id) -> DataSetID;
+  auto create_time_step_level(DataTimeStepID time_step_id)
+      -> DataSetView<DataStorage> {
+    return DataSetView{*this, create_time_step_level_id(time_step_id)};
+  }
+  /// @}
+
+  /// Check if a time step has the spatial index of the particles.
+  auto time_step_has_index(DataTimeStepID time_step_id) const -> bool;
+
+  /// Get the spatial index dataset of a time step.
+  /// @{
+  auto time_step_index_id(DataTimeStepID time_step_id) const -> DataSetID;
+  auto time_step_index(this auto& self, DataTimeStepID time_step_id) {
+    return DataSetView{self, self.time_step_index_id(time_step_id)};
+  }
+  /// @}
+
+  /// Create the spatial index dataset of a time step.
+  auto create_time_step_index_id(DataTimeStepID time_step_id) -> DataSetID;
+
+  /// Create the spatial index of the particles of a time step.
+  ///
+  /// Particles are split into the blocks of @p block_size consecutive
+  /// particles, and the bounding boxes of the blocks are stored in the index
+  /// dataset, along with the reference to the positions array. Region reads
+  /// then only load the blocks that intersect the region, so the index is
+  /// tight only if the nearby particles are stored together, e.g. if they
+  /// are ordered along a space-filling curve.
+  ///
+  /// If the positions array was written in a lower precision, the
+  /// full-precision positions are stored in the index dataset instead of the
+  /// reference, so that the regions are selected by the same positions the
+  /// bounding boxes were computed from.
+  ///
+  /// @param positions_id Array that holds the particle positions.
+  /// @param points       Particle positions, same as the data of the array,
+  ///                     up to the precision.
+  template<std::ranges::random_access_range Points>
+    requires known_type_of<std::ranges::range_value_t<Points>>
+  auto create_time_step_index(DataTimeStepID time_step_id,
+                              DataArrayID positions_id,
+                              Points&& points,
+                              size_t block_size = DefaultIndexBlockSize)
+      -> DataSetView<DataStorage> {
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    using Point = std::ranges::range_value_t<Points>;
+    const auto num_points = std::ranges::size(points);
+    constexpr auto point_type = type_of<Point>;
+    const auto positions_type = array_type(positions_id);
+    TIT_ASSERT(positions_type.with_kind(point_type.kind()) == point_type,
+               "Type mismatch!");
+    TIT_ASSERT(array_size(positions_id) == num_points, "Size mismatch!");
+    TIT_ASSERT(block_size > 0, "Block size must be positive!");
+    const auto num_blocks = divide_up(num_points, block_size);
+    std::vector<Point> lows(num_blocks);
+    std::vector<Point> highs(num_blocks);
+    for (size_t block = 0; block < num_blocks; ++block) {
+      const auto first = block * block_size;
+      const auto last = std::min(first + block_size, num_points);
+      geom::BBox box{Point{points[first]}};
+      for (size_t i = first + 1; i < last; ++i) box.expand(points[i]);
+      lows[block] = box.low();
+      highs[block] = box.high();
+    }
+    const DataSetView index{*this, create_time_step_index_id(time_step_id)};
+    if (positions_type == point_type) {
+      index.create_array_ref("positions", DataArrayView{*this, positions_id});
+    } else {
+      index.create_array("positions", points);
+    }
+    index.create_array("block_size", std::array{block_size});
+    index.create_array("low", lows);
+    index.create_array("high", highs);
+    return index;
+  }
+
+  /// Read the data of the varying arrays of a time step for the particles
+  /// within the bounding box, using the spatial index of the time step.
+  ///
+  /// Only the ranges of the blocks that intersect the bounding box are read,
+  /// and only the compressed chunks that contain these ranges are loaded and
+  /// decompressed, see `array_data_read_range`.
+  template<class Self, class Point>
+  auto time_step_read_region(this Self& self,
+                             DataTimeStepID time_step_id,
+                             const geom::BBox<Point>& box,
+                             std::span<const std::string_view> names)
+      -> DataRegion<Self> {
+    const auto find_array = [](const auto& dataset, std::string_view name) {
+      auto array = dataset.find_array(name);
+      if (!array.has_value()) TIT_THROW("Data array '{}' is not found.", name);
+      return *array;
+    };
+    const auto index = self.time_step_index(time_step_id);
+    const auto positions = find_array(index, "positions");
+    if (positions.type() != type_of<Point>) {
+      TIT_THROW("Region type '{}' does not match the positions type '{}'.",
+                type_of<Point>.name(),
+                positions.type().name());
+    }
+    const auto num_points = positions.size();
+    const auto block_size =
+        find_array(index, "block_size").template read_range<size_t>(0, 1)[0];
+    const auto lows_array = find_array(index, "low");
+    const auto highs_array = find_array(index, "high");
+    const auto lows =
+        lows_array.template read_range<Point>(0, lows_array.size());
+    const auto highs =
+        highs_array.template read_range<Point>(0, highs_array.size());
+
+    // Merge the consecutive blocks that intersect the bounding box into the
+    // runs, and select the particles of the runs within the bounding box.
+    struct Run {
+      size_t first;
+      size_t last;
+      size_t count;
+    };
+    std::vector<Run> runs;
+    for (size_t block = 0; block < lows.size(); ++block) {
+      if (!all(lows[block] <= box.high()) || !all(box.low() <= highs[block])) {
+        continue;
+      }
+      const auto first = block * block_size;
+      const auto last = std::min(first + block_size, num_points);
+      if (!runs.empty() && runs.back().last == first) runs.back().last = last;
+      else runs.push_back({.first = first, .last = last, .count = 0});
+    }
+    DataRegion<Self> region;
+    for (auto& run : runs) {
+      const auto points =
+          positions.template read_range<Point>(run.first, run.last - run.first);
+      for (size_t i = run.first; i < run.last; ++i) {
+        const auto& point = points[i - run.first];
+        if (!all(box.low() <= point) || !all(point <= box.high())) continue;
+        region.indices.push_back(i);
+        run.count += 1;
+      }
+    }
+
+    // Read the runs of the requested arrays, and gather the selected values.
+    const auto varyings = self.time_step_varyings(time_step_id);
+    for (const auto name : names) {
+      const auto array = find_array(varyings, name);
+      if (array.size() != num_points) {
+        TIT_THROW("Size of data array '{}' does not match the positions.",
+                  name);
+      }
+      const auto width = array.type().width();
+      auto& item = region.arrays.emplace_back();
+      item.dataset = varyings;
+      item.name = std::string{name};
+      item.array = array;
+      item.data.resize(region.indices.size() * width);
+      size_t offset = 0;
+      for (const auto& run : runs) {
+        if (run.count == 0) continue;
+        const auto bytes = array.read_range(run.first, run.last - run.first);
+        for (size_t k = 0; k < run.count; ++k, ++offset) {
+          const auto i = region.indices[offset] - run.first;
+          std::memcpy(&item.data[offset * width], &bytes[i * width], width);
+        }
+      }
+    }
+    return region;
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Check if a dataset with the given ID exists.
@@ -524,6 +1251,34 @@ public:
     array_data_open_write<Val>(array_id)->write(vals);
     return array_id;
   }
+  /// @}
+
+  /// Create a new data array in the dataset, and store its floating-point
+  /// data lossily, within the error bound. Data is quantized before the
+  /// compression, and is read back as usual.
+  /// @{
+  auto create_array_id(DataSetID dataset_id,
+                       std::string_view name,
+                       DataType type,
+                       std::span<const byte_t> data,
+                       ErrorBound bound) -> DataArrayID;
+  template<std::ranges::input_range Vals>
+    requires known_type_of<std::ranges::range_value_t<Vals>>
+  auto create_array_id(DataSetID dataset_id,
+                       std::string_view name,
+                       Vals&& vals,
+                       ErrorBound bound) -> DataArrayID {
+    TIT_ASSUME_UNIVERSAL(Vals, vals);
+    using Val = std::ranges::range_value_t<Vals>;
+    std::vector<byte_t> data;
+    make_stream_serializer<Val>(make_container_output_stream(data))
+        ->write(vals);
+    quantize(bound, type_of<Val>, data);
+    return create_array_id(dataset_id, name, type_of<Val>, data);
+  }
+  /// @}
+
+  /// Create a new data array in the dataset, see `create_array_id`.
   template<class... Args>
   auto create_array(DataSetID dataset_id, std::string_view name, Args&&... args)
       -> DataArrayView<DataStorage> {
@@ -531,9 +1286,111 @@ public:
         *this,
         create_array_id(dataset_id, name, std::forward<Args>(args)...)};
   }
+
+  /// Create a new data array in the dataset from the parts of its data, e.g.
+  /// the particles of the separate partitions, that only have their own
+  /// parts at hand.
+  ///
+  /// Parts are compressed in parallel, each into its own chunks, and the
+  /// chunks are stored one after the other, so that the readers see a single
+  /// contiguous array, and the data is never gathered into a single buffer.
+  /// Offsets of the parts are stored along, see `array_part_offsets`.
+  /// @{
+  auto create_partitioned_array_id(
+      DataSetID dataset_id,
+      std::string_view name,
+      DataType type,
+      std::span<const std::span<const byte_t>> parts) -> DataArrayID;
+  template<std::ranges::input_range Parts>
+    requires std::ranges::contiguous_range<
+                 std::ranges::range_reference_t<Parts>> &&
+             known_type_of<std::ranges::range_value_t<
+                 std::ranges::range_reference_t<Parts>>>
+  auto create_partitioned_array_id(DataSetID dataset_id,
+                                   std::string_view name,
+                                   Parts&& parts) -> DataArrayID {
+    TIT_ASSUME_UNIVERSAL(Parts, parts);
+    using Val =
+        std::ranges::range_value_t<std::ranges::range_reference_t<Parts>>;
+    std::vector<std::span<const byte_t>> byte_parts;
+    for (const auto& part : parts) {
+      byte_parts.push_back(std::as_bytes(std::span{part}));
+    }
+    return create_partitioned_array_id(dataset_id,
+                                       name,
+                                       type_of<Val>,
+                                       byte_parts);
+  }
+  template<class... Args>
+  auto create_partitioned_array(DataSetID dataset_id,
+                                std::string_view name,
+                                Args&&... args) -> DataArrayView<DataStorage> {
+    return DataArrayView{*this,
+                         create_partitioned_array_id(
+                             dataset_id,
+                             name,
+                             std::forward<Args>(args)...)};
+  }
+  /// @}
+
+  /// Create a new data array in the dataset that refers to the data of the
+  /// existing data array. No data is copied.
+  /// @{
+  auto create_array_ref_id(DataSetID dataset_id,
+                           std::string_view name,
+                           DataArrayID source_id) -> DataArrayID;
+  auto create_array_ref(DataSetID dataset_id,
+                        std::string_view name,
+                        DataArrayID source_id) -> DataArrayView<DataStorage> {
+    return DataArrayView{*this,
+                         create_array_ref_id(dataset_id, name, source_id)};
+  }
+  /// @}
+
+  /// Create a new data array in the dataset, or a reference to the data array
+  /// with the same name in the previous dataset, if its data is identical.
+  ///
+  /// Data is compared by type, size and a 64-bit content hash, which is
+  /// stored along with the arrays created by this function.
+  /// @{
+  auto create_array_or_ref_id(DataSetID dataset_id,
+                              std::string_view name,
+                              DataType type,
+                              std::span<const byte_t> data,
+                              std::optional<DataSetID> previous_id)
+      -> DataArrayID;
+  template<std::ranges::input_range Vals>
+    requires known_type_of<std::ranges::range_value_t<Vals>>
+  auto create_array_or_ref_id(DataSetID dataset_id,
+                              std::string_view name,
+                              Vals&& vals,
+                              std::optional<DataSetID> previous_id)
+      -> DataArrayID {
+    TIT_ASSUME_UNIVERSAL(Vals, vals);
+    using Val = std::ranges::range_value_t<Vals>;
+    std::vector<byte_t> data;
+    make_stream_serializer<Val>(make_container_output_stream(data))
+        ->write(vals);
+    return create_array_or_ref_id(dataset_id,
+                                  name,
+                                  type_of<Val>,
+                                  data,
+                                  previous_id);
+  }
+  template<class... Args>
+  auto create_array_or_ref(DataSetID dataset_id,
+                           std::string_view name,
+                           Args&&... args) -> DataArrayView<DataStorage> {
+    return DataArrayView{
+        *this,
+        create_array_or_ref_id(dataset_id, name, std::forward<Args>(args)...)};
+  }
   /// @}
 
   /// Delete a data array.
+  ///
+  /// @note Data array cannot be deleted while other arrays refer to it,
+  ///       unless they are deleted together.
   void delete_array(DataArrayID array_id);
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -547,6 +1404,13 @@ public:
   /// Get the number of elements in the data array.
   auto array_size(DataArrayID array_id) const -> size_t;
 
+  /// Get the offsets of the parts of the data array, in elements. Arrays that
+  /// were not created from the parts consist of a single part.
+  auto array_part_offsets(DataArrayID array_id) const -> std::vector<size_t>;
+
+  /// Check if the data array refers to the data of another data array.
+  auto array_is_ref(DataArrayID array_id) const -> bool;
+
   /// Open an output stream to write the data of a data array.
   /// @{
   auto array_data_open_write(DataArrayID array_id) -> OutputStreamPtr<byte_t>;
@@ -564,20 +1428,198 @@ public:
   template<known_type_of Val>
   auto array_data_open_read(DataArrayID array_id) const -> InputStreamPtr<Val> {
     TIT_ASSERT(array_type(array_id) == type_of<Val>, "Type mismatch!");
-    return make_stream_deserializer<Val>(array_data_open_read(array_id));
+    return make_buffered_input_stream(
+        make_stream_deserializer<Val>(array_data_open_read(array_id)));
   }
   /// @}
 
+  /// Check if the data of a data array is stored in the external payload file.
+  auto array_is_external(DataArrayID array_id) const -> bool;
+
+  /// Map the data of an external data array into memory.
+  auto array_data_map(DataArrayID array_id) const -> DataArrayMapping;
+
+  /// Read the range of elements of a data array.
+  ///
+  /// Only the compressed chunks that contain the range are loaded and
+  /// decompressed, so reading a small range of a large array is cheap.
+  /// @{
+  auto array_data_read_range(DataArrayID array_id,
+                             size_t first,
+                             size_t count) const -> std::vector<byte_t>;
+  template<known_type_of Val>
+  auto array_data_read_range(DataArrayID array_id,
+                             size_t first,
+                             size_t count) const -> std::vector<Val> {
+    TIT_ASSERT(array_type(array_id) == type_of<Val>, "Type mismatch!");
+    const auto bytes = array_data_read_range(array_id, first, count);
+    std::vector<Val> vals(count);
+    const auto copied =
+        make_stream_deserializer<Val>(make_range_input_stream(bytes))
+            ->read(vals);
+    TIT_ASSERT(copied == count, "Truncated data!");
+    return vals;
+  }
+  /// @}
+
+  /// Read the whole data of a data array through the data array cache.
+  ///
+  /// Repeated reads of the same data, e.g. scrubbing over the recent time
+  /// steps, return the cached buffer instead of decoding the data again.
+  /// Ranges of the cached data are also read from the cache.
+  auto array_data_read(DataArrayID array_id) const -> DataArrayCache::Buffer;
+
+  /// Get the capacity of the data array cache, in bytes.
+  auto cache_capacity() const -> size_t;
+
+  /// Set the capacity of the data array cache, in bytes. Zero capacity
+  /// disables the cache. Setting is not persisted in the storage.
+  void set_cache_capacity(size_t capacity);
+
+  /// Read the data of the data arrays at once.
+  ///
+  /// Compressed data is loaded on the calling thread, and then the chunks of
+  /// all the arrays are decompressed in parallel. Buffers are resized to fit
+  /// the data, so that passing the buffers of a previous read reuses their
+  /// memory.
+  void array_data_read_all(std::span<const DataArrayID> array_ids,
+                           std::span<std::vector<byte_t>> buffers) const;
+
+  /// Read the whole data of a data array straight into the buffer.
+  ///
+  /// Chunks are decompressed directly into the buffer, without any
+  /// intermediate copies, e.g. right into a particle array column or a NumPy
+  /// array. Buffer size must match the size of the data, in bytes.
+  /// @{
+  void array_data_read_into(DataArrayID array_id, std::span<byte_t> data) const;
+  template<known_type_of Val>
+  void array_data_read_into(DataArrayID array_id, std::span<Val> vals) const {
+    TIT_ASSERT(array_type(array_id) == type_of<Val>, "Type mismatch!");
+    array_data_read_into(array_id, std::as_writable_bytes(vals));
+  }
+  /// @}
+
+  /// Read the whole data of the data arrays straight into the buffers at
+  /// once, like `array_data_read_into`. Chunks of all the arrays are
+  /// decompressed in parallel, so that the small arrays do not leave the
+  /// worker threads idle.
+  void array_data_read_all_into(
+      std::span<const DataArrayID> array_ids,
+      std::span<const std::span<byte_t>> outputs) const;
+
+  /// Read the data of all the data arrays of the datasets at once.
+  ///
+  /// Contents are stored in the order of the datasets, and then in the order
+  /// of the arrays within the dataset. Data buffers of the existing contents
+  /// are reused.
+  template<class Self>
+  void datasets_read_all(this Self& self,
+                         std::span<const DataSetID> dataset_ids,
+                         std::vector<DataArrayContents<Self>>& contents) {
+    size_t num_arrays = 0;
+    std::vector<DataArrayID> array_ids;
+    for (const auto dataset_id : dataset_ids) {
+      for (auto [name, array_id] : self.dataset_array_ids(dataset_id)) {
+        if (num_arrays == contents.size()) contents.emplace_back();
+        auto& item = contents[num_arrays++];
+        item.dataset = DataSetView{self, dataset_id};
+        item.name = std::move(name);
+        item.array = DataArrayView{self, array_id};
+        array_ids.push_back(array_id);
+      }
+    }
+    contents.resize(num_arrays);
+    std::vector<std::vector<byte_t>> buffers(num_arrays);
+    for (auto&& [item, buffer] : std::views::zip(contents, buffers)) {
+      std::swap(item.data, buffer);
+    }
+    self.array_data_read_all(array_ids, buffers);
+    for (auto&& [item, buffer] : std::views::zip(contents, buffers)) {
+      std::swap(item.data, buffer);
+    }
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 private:
 
+  // Current version of the database schema.
+  static constexpr int64_t SchemaVersion = 5;
+
+  // Number of the low ID bits, that are allocated within a shard. The high
+  // bits hold the shard index.
+  static constexpr size_t ShardIdBits = 40;
+
+  // Upgrade the database schema to the current version.
+  void upgrade_schema_();
+
+  // Shadow the tables of the older read-only storage by the temporary tables
+  // and views, that have the current schema.
+  void shadow_schema_();
+
+  // Attach the shards to the read-only storage.
+  void attach_shards_();
+
+  // Reclaim the regions of the external payload file, that are no longer
+  // referred to by the data arrays. Does nothing within a transaction.
+  void reclaim_payloads_();
+
+  // Get the name of the schema that holds the data array.
+  auto array_schema_(DataArrayID array_id) const -> std::string;
+
+  // Get the path to the payload file of the external data array.
+  auto array_payload_path_(DataArrayID array_id) const
+      -> std::filesystem::path;
+
   // Create a new dataset.
   auto create_set_() -> DataSetID;
 
+  // Decode the data of the data arrays into the output buffers, which must
+  // match the data sizes.
+  void array_data_decode_(std::span<const DataArrayID> array_ids,
+                          std::span<const std::span<byte_t>> outputs) const;
+
+  // Get the data array that holds the data of the given one.
+  auto array_data_id_(DataArrayID array_id) const -> DataArrayID;
+
+  // Get the content hash of the data array, if it was computed.
+  auto array_hash_(DataArrayID array_id) const -> std::optional<uint64_t>;
+
+  // Get the name of the data array.
+  auto array_name_(DataArrayID array_id) const -> std::string;
+
+  // Get the compression dictionary of the data array, if any.
+  auto array_dictionary_(DataArrayID array_id) const -> std::vector<byte_t>;
+
+  // Get the compression dictionary for the data arrays with the given name,
+  // training it if possible. Null ID means there is no dictionary.
+  auto name_dictionary_(std::string_view name)
+      -> std::pair<sqlite::RowID, std::vector<byte_t>>;
+
+  // Get the filter of the data array chunks.
+  auto array_filter_(DataArrayID array_id) const -> DataFilter;
+
+  // Get the uncompressed and compressed offsets of the data array chunks.
+  auto array_chunk_offsets_(DataArrayID array_id) const
+      -> std::vector<uint64_t>;
+
+  // Get the offset and size of the external data array payload.
+  auto array_payload_(DataArrayID array_id) const
+      -> std::optional<std::pair<size_t, size_t>>;
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   mutable sqlite::Database db_;
+  bool read_only_ = false;
+  std::unique_ptr<std::recursive_mutex> mutex_ =
+      std::make_unique<std::recursive_mutex>();
+  std::unique_ptr<DataArrayCache> cache_ =
+      std::make_unique<DataArrayCache>(DefaultCacheCapacity);
+  int compression_level_ = 0;
+  size_t compression_workers_ = 0;
+  bool dictionaries_ = false;
+  bool external_arrays_ = false;
+  std::vector<size_t> shards_;
 
 }; // class Database
 
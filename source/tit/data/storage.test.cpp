@@ -3,20 +3,39 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
 #include <filesystem>
+#include <functional>
+#include <memory>
 #include <numbers>
+#include <numeric>
+#include <optional>
+#include <random>
 #include <ranges>
 #include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/exception.hpp"
 #include "tit/core/range_utils.hpp"
 #include "tit/core/sys/utils.hpp"
+#include "tit/core/vec.hpp"
 
+#include "tit/data/sqlite.hpp"
 #include "tit/data/storage.hpp"
 #include "tit/data/type.hpp"
 
+#include "tit/geom/bbox.hpp"
+
+#include "tit/testing/temp_dir.hpp"
 #include "tit/testing/test.hpp"
 
 namespace tit {
@@ -66,6 +85,272 @@ TEST_CASE("data::DataStorage") {
   }
 }
 
+TEST_CASE("data::DataStorage::upgrade_schema") {
+  const std::filesystem::path file_name{"test_schema.ttdb"};
+  std::filesystem::remove(file_name);
+  SUBCASE("unversioned") {
+    // Create the storage with the schema of the first versions, where the
+    // data arrays had fewer columns, and there were no indexes.
+    {
+      const data::sqlite::Database db{file_name};
+      db.execute(R"SQL(
+        CREATE TABLE DataSeries (
+          id          INTEGER PRIMARY KEY AUTOINCREMENT,
+          parameters  TEXT
+        ) STRICT;
+        CREATE TABLE DataArrays (
+          id          INTEGER PRIMARY KEY AUTOINCREMENT,
+          data_set_id INTEGER NOT NULL,
+          name        TEXT NOT NULL,
+          type        INTEGER NOT NULL,
+          size        INTEGER,
+          data        BLOB
+        ) STRICT;
+        INSERT INTO DataSeries (parameters) VALUES ('old');
+      )SQL");
+    }
+    {
+      data::DataStorage storage{file_name};
+      REQUIRE(storage.num_series() == 1);
+      CHECK(storage.last_series().parameters() == "old");
+      const auto series = storage.create_series("new");
+      const auto uniforms = series.create_time_step(0.0).uniforms();
+      const std::vector<float64_t> vals{1.0, 2.0, 3.0};
+      const auto array = uniforms.create_array("array", vals);
+      CHECK_RANGE_EQ(array.open_read<float64_t>(), vals);
+    }
+    const data::sqlite::Database db{file_name};
+    data::sqlite::Statement version_statement{db, "PRAGMA user_version"};
+    REQUIRE(version_statement.step());
+    CHECK(version_statement.column<int64_t>() == 5);
+    data::sqlite::Statement index_statement{db, R"SQL(
+      SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND name IN (
+        'TimeStepsBySeries', 'DataSetsByTimeStep', 'DataArraysBySetAndName')
+    )SQL"};
+    REQUIRE(index_statement.step());
+    CHECK(index_statement.column<size_t>() == 3);
+  }
+  SUBCASE("read-only") {
+    // Create the storage, and then roll it back to the schema of the older
+    // versions, where the data arrays had no parts, the time steps had no
+    // index, and there were no telemetry and no shards.
+    const std::vector<float64_t> vals{1.0, 2.0, 3.0};
+    {
+      data::DataStorage storage{file_name};
+      const auto series = storage.create_series("old");
+      series.create_time_step(0.0).uniforms().create_array("array", vals);
+    }
+    {
+      const data::sqlite::Database db{file_name};
+      db.execute(R"SQL(
+        DROP TRIGGER DataArraysReparent;
+        ALTER TABLE DataArrays DROP COLUMN parts;
+        ALTER TABLE TimeSteps DROP COLUMN index_id;
+        DROP TABLE Telemetry;
+        DROP TABLE Shards;
+        PRAGMA user_version = 2;
+      )SQL");
+    }
+
+    // Older storage must be readable without the upgrade.
+    {
+      const data::DataStorage storage{file_name, data::OpenMode::read_only};
+      REQUIRE(storage.num_series() == 1);
+      const auto series = storage.last_series();
+      CHECK(series.parameters() == "old");
+      CHECK(series.telemetry_names().empty());
+      CHECK(storage.shard_indices().empty());
+      REQUIRE(series.num_time_steps() == 1);
+      const auto time_step = series.last_time_step();
+      CHECK_FALSE(time_step.has_index());
+      const auto array = time_step.uniforms().find_array("array");
+      REQUIRE(array.has_value());
+      CHECK_RANGE_EQ(array->open_read<float64_t>(), vals);
+    }
+    const data::sqlite::Database db{file_name};
+    data::sqlite::Statement version_statement{db, "PRAGMA user_version"};
+    REQUIRE(version_statement.step());
+    CHECK(version_statement.column<int64_t>() == 2);
+  }
+  SUBCASE("newer") {
+    {
+      const data::sqlite::Database db{file_name};
+      db.execute("PRAGMA user_version = 1000");
+    }
+    CHECK_THROWS_MSG(data::DataStorage{file_name},
+                     Exception,
+                     "Data storage schema version 1000 is newer");
+    CHECK_THROWS_MSG(data::DataStorage(file_name, data::OpenMode::read_only),
+                     Exception,
+                     "Data storage schema version 1000 is newer");
+  }
+}
+
+TEST_CASE("data::DataStorage::Transaction") {
+  SUBCASE("commit") {
+    data::DataStorage storage{":memory:"};
+    {
+      const auto transaction = storage.transaction();
+      storage.create_series("1");
+      {
+        const auto nested_transaction = storage.transaction();
+        storage.create_series("2");
+      }
+    }
+    CHECK(storage.num_series() == 2);
+  }
+  SUBCASE("rollback") {
+    data::DataStorage storage{":memory:"};
+    storage.create_series("1");
+    try {
+      const auto transaction = storage.transaction();
+      storage.create_series("2");
+      TIT_THROW("Failure!");
+    } catch (const Exception& /*e*/) {}
+    CHECK(storage.num_series() == 1);
+  }
+}
+
+TEST_CASE("data::DataStorage::read_only") {
+  const std::filesystem::path file_name{"test_read_only.ttdb"};
+  std::filesystem::remove(file_name);
+  SUBCASE("missing") {
+    CHECK_THROWS_MSG(data::DataStorage(file_name, data::OpenMode::read_only),
+                     Exception,
+                     "unable to open database file");
+  }
+  SUBCASE("live") {
+    // Writer appends the time steps, while the reader reads the completed
+    // ones from its snapshot.
+    data::DataStorage writer{file_name};
+    writer.set_journal_mode(data::JournalMode::wal);
+    const auto series = writer.create_series("1");
+    series.create_time_step(0.0);
+    data::DataStorage reader{file_name, data::OpenMode::read_only};
+    CHECK(reader.read_only());
+    CHECK_FALSE(writer.read_only());
+    {
+      const auto snapshot = reader.transaction();
+      REQUIRE(reader.num_series() == 1);
+      CHECK(reader.last_series().num_time_steps() == 1);
+      series.create_time_step(1.0);
+      CHECK(reader.last_series().num_time_steps() == 1);
+    }
+    CHECK(reader.last_series().num_time_steps() == 2);
+    CHECK_THROWS_MSG(reader.create_series("2"),
+                     Exception,
+                     "attempt to write a readonly database");
+  }
+}
+
+TEST_CASE("data::DataStorage::lock") {
+  // Concurrent writers of the different series serialize on the lock.
+  data::DataStorage storage{":memory:"};
+  constexpr size_t NumWriters = 4;
+  constexpr size_t NumTimeSteps = 10;
+  {
+    std::vector<std::jthread> writers;
+    for (size_t i = 0; i < NumWriters; ++i) {
+      writers.emplace_back([&storage] {
+        auto series = [&storage] {
+          const auto lock = storage.lock();
+          return storage.create_series();
+        }();
+        for (size_t j = 0; j < NumTimeSteps; ++j) {
+          const auto lock = storage.lock();
+          const auto nested_lock = storage.lock();
+          series.create_time_step(static_cast<real_t>(j));
+        }
+      });
+    }
+  }
+  REQUIRE(storage.num_series() == NumWriters);
+  for (const auto series : storage.series()) {
+    CHECK(series.num_time_steps() == NumTimeSteps);
+  }
+}
+
+TEST_CASE("data::DataStorage::journal_mode") {
+  const std::filesystem::path file_name{"test_journal.ttdb"};
+  std::filesystem::remove(file_name);
+  data::DataStorage storage{file_name};
+  storage.set_journal_mode(data::JournalMode::wal);
+  CHECK(storage.journal_mode() == data::JournalMode::wal);
+  storage.set_sync_mode(data::SyncMode::normal);
+  CHECK(storage.sync_mode() == data::SyncMode::normal);
+  storage.set_journal_mode(data::JournalMode::rollback);
+  CHECK(storage.journal_mode() == data::JournalMode::rollback);
+  storage.set_sync_mode(data::SyncMode::full);
+  CHECK(storage.sync_mode() == data::SyncMode::full);
+}
+
+TEST_CASE("data::DataStorage::shards") {
+  const std::filesystem::path file_name{"test_shards.ttdb"};
+  std::filesystem::remove(file_name);
+  data::DataStorage storage{file_name};
+  for (size_t index = 1; index <= 2; ++index) {
+    std::filesystem::remove(storage.shard_path(index));
+    std::filesystem::remove(storage.shard_path(index).string() + ".payload");
+  }
+  SUBCASE("success") {
+    // Write a series into the main storage, and one into each shard. Arrays
+    // of the second shard are stored externally.
+    std::vector<float64_t> vals(1000);
+    std::ranges::iota(vals, 0.0);
+    const auto write_series = [&vals](data::DataStorage& target,
+                                      std::string_view parameters) {
+      const auto series = target.create_series(parameters);
+      const auto uniforms = series.create_time_step(0.0).uniforms();
+      uniforms.create_array("vals", vals);
+      uniforms.create_array("step", std::vector{1.0});
+    };
+    write_series(storage, "main");
+    {
+      auto shard_1 = storage.open_shard(1);
+      auto shard_2 = storage.open_shard(2);
+      shard_2.set_external_arrays(true);
+      write_series(shard_1, "shard_1");
+      write_series(shard_2, "shard_2");
+      CHECK(shard_1.num_series() == 1);
+      CHECK(shard_2.num_series() == 1);
+    }
+    CHECK(storage.num_series() == 1);
+    CHECK_RANGE_EQ(storage.shard_indices(), {1, 2});
+
+    // Read-only storage sees all the series.
+    const data::DataStorage reader{file_name, data::OpenMode::read_only};
+    REQUIRE(reader.num_series() == 3);
+    std::set<data::sqlite::RowID> series_ids;
+    std::vector<std::string> names;
+    for (const auto series : reader.series()) {
+      series_ids.insert(series.id().get());
+      names.push_back(series.parameters());
+      REQUIRE(series.num_time_steps() == 1);
+      const auto uniforms = series.last_time_step().uniforms();
+      const auto array = uniforms.find_array("vals");
+      REQUIRE(array.has_value());
+      CHECK_RANGE_EQ(array->open_read<float64_t>(), vals);
+      CHECK_RANGE_EQ(array->read_range<float64_t>(100, 10),
+                     std::span{vals}.subspan(100, 10));
+      const auto contents = uniforms.read_all();
+      REQUIRE(contents.size() == 2);
+      CHECK_RANGE_EQ(contents[0].data, std::as_bytes(std::span{vals}));
+    }
+    CHECK(series_ids.size() == 3);
+    CHECK_RANGE_EQ(names, {"main", "shard_1", "shard_2"});
+  }
+  SUBCASE("failure") {
+    data::DataStorage reader{file_name, data::OpenMode::read_only};
+    CHECK_THROWS_MSG(reader.open_shard(1),
+                     Exception,
+                     "Shards cannot be opened in the read-only mode!");
+    data::DataStorage in_memory{":memory:"};
+    CHECK_THROWS_MSG(in_memory.open_shard(1),
+                     Exception,
+                     "Shards require a file-backed storage!");
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("data::DataSeriesView") {
@@ -186,6 +471,62 @@ TEST_CASE("data::DataSeriesView") {
     CHECK(series_4 != series_2);
     CHECK_RANGE_EQ(storage.series(), {series_1, series_3, series_4});
   }
+  SUBCASE("purge retired series") {
+    data::DataStorage storage{":memory:"};
+    storage.set_max_series(1);
+
+    // Create a series with a few time steps, and retire it.
+    const auto series_1 = storage.create_series("1");
+    const auto step_1 = series_1.create_time_step(0.0);
+    const auto step_2 = series_1.create_time_step(1.0);
+    const auto step_3 = series_1.create_time_step(2.0);
+    const auto array =
+        step_2.uniforms().create_array("array", std::vector<float64_t>{1.0});
+    step_3.uniforms().create_array_ref("array", array);
+    const auto series_2 = storage.create_series("2");
+    const auto step_4 = series_2.create_time_step(0.0);
+    CHECK_FALSE(storage.check_series(series_1));
+    CHECK_RANGE_EQ(storage.series(), {series_2});
+
+    // Retired time steps are deleted step by step, the last ones first.
+    CHECK(storage.check_time_step(step_1));
+    CHECK_FALSE(storage.purge_retired(2));
+    CHECK(storage.check_time_step(step_1));
+    CHECK_FALSE(storage.check_time_step(step_2));
+    CHECK_FALSE(storage.check_time_step(step_3));
+    CHECK(storage.purge_retired(2));
+    CHECK_FALSE(storage.check_time_step(step_1));
+    CHECK(storage.check_time_step(step_4));
+    CHECK(storage.purge_retired());
+  }
+  SUBCASE("telemetry") {
+    data::DataStorage storage{":memory:"};
+    const auto series_1 = storage.create_series("1");
+    const auto series_2 = storage.create_series("2");
+    CHECK(series_1.telemetry_names().empty());
+
+    // Record a few metrics.
+    series_1.record_telemetry(0, "wall_time", 0.5);
+    series_1.record_telemetry(1, "wall_time", 0.25);
+    series_1.record_telemetry(1, "num_pairs", 10.0);
+    series_2.record_telemetry(0, "wall_time", 1.0);
+    CHECK(series_1.telemetry_names() ==
+          std::vector<std::string>{"num_pairs", "wall_time"});
+    CHECK(series_1.telemetry("wall_time") ==
+          std::vector<std::pair<size_t, float64_t>>{{0, 0.5}, {1, 0.25}});
+    CHECK(series_2.telemetry("wall_time") ==
+          std::vector<std::pair<size_t, float64_t>>{{0, 1.0}});
+    CHECK(series_1.telemetry("missing").empty());
+
+    // Record the same metric again. Value should be replaced.
+    series_1.record_telemetry(1, "wall_time", 0.75);
+    CHECK(series_1.telemetry("wall_time") ==
+          std::vector<std::pair<size_t, float64_t>>{{0, 0.5}, {1, 0.75}});
+
+    // Delete the series. Telemetry of the other series should be kept.
+    storage.delete_series(series_1);
+    CHECK(series_2.telemetry_names() == std::vector<std::string>{"wall_time"});
+  }
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -281,6 +622,135 @@ TEST_CASE("data::DataTimeStepView") {
     CHECK(step_4 == data::DataTimeStepID{4});
     CHECK_RANGE_EQ(series.time_steps(), {step_1, step_3, step_4});
   }
+  SUBCASE("levels") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step_1 = series.create_time_step(0.0);
+    const auto step_2 = series.create_time_step(1.0);
+    CHECK(step_1.num_levels() == 0);
+    CHECK(step_1.level(0) == step_1.varyings());
+
+    // Create the levels, and make sure they are not shared between the
+    // time steps.
+    const auto level_11 = step_1.create_level();
+    const auto level_21 = step_2.create_level();
+    const auto level_12 = step_1.create_level();
+    CHECK(step_1.num_levels() == 2);
+    CHECK(step_1.level(1) == level_11);
+    CHECK(step_1.level(2) == level_12);
+    CHECK(step_2.num_levels() == 1);
+    CHECK(step_2.level(1) == level_21);
+    CHECK_THROWS_MSG(step_2.level(2), Exception, "Time step 2 has no level 2.");
+
+    // Make sure the levels are deleted with the time step.
+    storage.delete_time_step(step_1);
+    CHECK_FALSE(storage.check_dataset(level_11));
+    CHECK_FALSE(storage.check_dataset(level_12));
+    CHECK(storage.check_dataset(level_21));
+  }
+  SUBCASE("spatial index") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    CHECK_FALSE(step.has_index());
+
+    // Create the particles along a line, so that each block of the index
+    // covers a segment of it.
+    std::vector<Vec<float64_t, 2>> points(100);
+    std::vector<float64_t> vals(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+      points[i] = Vec{static_cast<float64_t>(i), 0.0};
+      vals[i] = 10.0 * static_cast<float64_t>(i);
+    }
+    const auto varyings = step.varyings();
+    const auto positions = varyings.create_array("r", points);
+    varyings.create_array("v", vals);
+    const auto index = step.create_index(positions, points, 16);
+    REQUIRE(step.has_index());
+    CHECK(step.index() == index);
+    CHECK(step.num_levels() == 0);
+
+    // Read the region, that spans two blocks.
+    const std::array<std::string_view, 2> names{"v", "r"};
+    const geom::BBox box{Vec{30.5, -1.0}, Vec{33.5, 1.0}};
+    const auto region = step.read_region(box, names);
+    CHECK_RANGE_EQ(region.indices, {31, 32, 33});
+    REQUIRE(region.arrays.size() == 2);
+    CHECK(region.arrays[0].name == "v");
+    CHECK(region.arrays[0].array == varyings.find_array("v"));
+    std::vector<float64_t> region_vals(region.indices.size());
+    REQUIRE(region.arrays[0].data.size() == 3 * sizeof(float64_t));
+    std::memcpy(region_vals.data(),
+                region.arrays[0].data.data(),
+                region.arrays[0].data.size());
+    CHECK_RANGE_EQ(region_vals, {310.0, 320.0, 330.0});
+    CHECK(region.arrays[1].name == "r");
+    CHECK(region.arrays[1].data.size() == 3 * sizeof(Vec<float64_t, 2>));
+
+    // Read the region, that intersects a block, but holds no particles.
+    const geom::BBox empty_box{Vec{30.2, -1.0}, Vec{30.8, 1.0}};
+    const auto empty_region = step.read_region(empty_box, names);
+    CHECK(empty_region.indices.empty());
+    REQUIRE(empty_region.arrays.size() == 2);
+    CHECK(empty_region.arrays[0].data.empty());
+
+    // Make sure the errors are reported.
+    const std::array<std::string_view, 1> missing_names{"missing"};
+    CHECK_THROWS_MSG(step.read_region(box, missing_names),
+                     Exception,
+                     "Data array 'missing' is not found.");
+    const auto other_step = series.create_time_step(1.0);
+    CHECK_THROWS_MSG(other_step.read_region(box, names),
+                     Exception,
+                     "Time step 2 has no spatial index.");
+  }
+  SUBCASE("read all") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto uniforms = step.uniforms();
+    const auto varyings = step.varyings();
+
+    // Create the arrays, one of which spans multiple compressed chunks.
+    std::vector<float64_t> vals_1(300'000);
+    std::ranges::iota(vals_1, 0.0);
+    const std::vector<float32_t> vals_2{1.0F, 2.0F, 3.0F};
+    const auto array_1 = varyings.create_array("array_1", vals_1);
+    const auto array_2 = varyings.create_array("array_2", vals_2);
+    const auto array_3 = varyings.create_array_ref("array_3", array_1);
+    const auto array_4 = uniforms.create_array("array_4", vals_2);
+    const auto array_5 =
+        uniforms.create_array("array_5", std::vector<float64_t>{});
+
+    // Read the arrays of the time step.
+    std::vector<data::DataArrayContents<data::DataStorage>> contents(8);
+    contents[0].data.resize(1'000'000);
+    step.read_all(contents);
+    REQUIRE(contents.size() == 5);
+    const auto check_contents = [&contents](size_t index,
+                                            data::DataSetID dataset,
+                                            std::string_view name,
+                                            data::DataArrayID array,
+                                            std::span<const byte_t> data) {
+      CHECK(contents[index].dataset == dataset);
+      CHECK(contents[index].name == name);
+      CHECK(contents[index].array == array);
+      CHECK_RANGE_EQ(contents[index].data, data);
+    };
+    const auto bytes_1 = std::as_bytes(std::span{vals_1});
+    const auto bytes_2 = std::as_bytes(std::span{vals_2});
+    check_contents(0, uniforms, "array_4", array_4, bytes_2);
+    check_contents(1, uniforms, "array_5", array_5, {});
+    check_contents(2, varyings, "array_1", array_1, bytes_1);
+    check_contents(3, varyings, "array_2", array_2, bytes_2);
+    check_contents(4, varyings, "array_3", array_3, bytes_1);
+
+    // Read the arrays of a single dataset.
+    const auto uniform_contents = uniforms.read_all();
+    REQUIRE(uniform_contents.size() == 2);
+    CHECK(uniform_contents[0].name == "array_4");
+    CHECK(uniform_contents[1].name == "array_5");
+  }
   SUBCASE("delete series") {
     data::DataStorage storage{":memory:"};
     const auto series = storage.create_series("");
@@ -372,6 +842,63 @@ TEST_CASE("data::DataSetView") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("data::DataArrayCache") {
+  const auto make_buffer = [](size_t size) {
+    return std::make_shared<const std::vector<byte_t>>(size);
+  };
+  data::DataArrayCache cache{8};
+  const data::DataArrayID id_1{1};
+  const data::DataArrayID id_2{2};
+  const data::DataArrayID id_3{3};
+  const auto buffer_1 = make_buffer(4);
+  const auto buffer_2 = make_buffer(4);
+  cache.insert(id_1, buffer_1);
+  cache.insert(id_2, buffer_2);
+  CHECK(cache.size() == 8);
+  SUBCASE("find") {
+    CHECK(cache.find(id_1) == buffer_1);
+    CHECK(cache.find(id_2) == buffer_2);
+    CHECK(cache.find(id_3) == nullptr);
+  }
+  SUBCASE("evict least recently used") {
+    // Ensure the recently found data is kept.
+    REQUIRE(cache.find(id_1) == buffer_1);
+    cache.insert(id_3, make_buffer(4));
+    CHECK(cache.size() == 8);
+    CHECK(cache.find(id_1) == buffer_1);
+    CHECK(cache.find(id_2) == nullptr);
+    CHECK(cache.find(id_3) != nullptr);
+  }
+  SUBCASE("too large") {
+    cache.insert(id_3, make_buffer(16));
+    CHECK(cache.find(id_3) == nullptr);
+    CHECK(cache.size() == 8);
+  }
+  SUBCASE("replace") {
+    const auto buffer_3 = make_buffer(2);
+    cache.insert(id_1, buffer_3);
+    CHECK(cache.find(id_1) == buffer_3);
+    CHECK(cache.size() == 6);
+  }
+  SUBCASE("erase and clear") {
+    cache.erase(id_1);
+    CHECK(cache.find(id_1) == nullptr);
+    CHECK(cache.size() == 4);
+    cache.clear();
+    CHECK(cache.find(id_2) == nullptr);
+    CHECK(cache.size() == 0);
+  }
+  SUBCASE("set capacity") {
+    cache.set_capacity(4);
+    CHECK(cache.capacity() == 4);
+    CHECK(cache.size() == 4);
+    CHECK(cache.find(id_1) == nullptr);
+    CHECK(cache.find(id_2) == buffer_2);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("data::DataArrayView") {
   SUBCASE("empty dataset") {
     data::DataStorage storage{":memory:"};
@@ -450,6 +977,328 @@ TEST_CASE("data::DataArrayView") {
     CHECK_RANGE_EQ(array.open_read<float64_t>(),
                    {std::numbers::phi, std::numbers::sqrt3});
   }
+  SUBCASE("read ranges") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.uniforms();
+
+    // Create an array that spans multiple compressed chunks.
+    std::vector<float64_t> vals(300'000);
+    std::ranges::iota(vals, 0.0);
+    const auto array = dataset.create_array("array", vals);
+    REQUIRE(storage.check_array(array));
+    CHECK(array.size() == vals.size());
+
+    // Read the ranges within a single chunk and across the chunk boundaries.
+    const auto check_range = [&array, &vals](size_t first, size_t count) {
+      CHECK_RANGE_EQ(array.read_range<float64_t>(first, count),
+                     std::span{vals}.subspan(first, count));
+    };
+    check_range(0, 0);
+    check_range(0, 10);
+    check_range(131'000, 100);
+    check_range(100'000, 150'000);
+    check_range(299'990, 10);
+    check_range(0, vals.size());
+
+    // Whole array can still be read sequentially.
+    CHECK_RANGE_EQ(array.open_read<float64_t>(), vals);
+
+    // Whole array can be read straight into a buffer of the matching size.
+    std::vector<float64_t> direct_vals(vals.size());
+    array.read_into(std::span{direct_vals});
+    CHECK(direct_vals == vals);
+    std::vector<float64_t> small_vals(10);
+    CHECK_THROWS_MSG(array.read_into(std::span{small_vals}),
+                     Exception,
+                     "but the buffer is 80 bytes");
+  }
+  SUBCASE("partitioned arrays") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.varyings();
+
+    // Create an array from the parts, that span multiple chunks, and do not
+    // start on the chunk boundaries.
+    std::vector<float64_t> vals(350'007);
+    std::ranges::iota(vals, 0.0);
+    const auto vals_span = std::span{vals};
+    const std::vector parts{vals_span.first(200'000),
+                            vals_span.subspan(200'000, 7),
+                            vals_span.subspan(200'007, 0),
+                            vals_span.subspan(200'007)};
+    const auto array = dataset.create_partitioned_array("array", parts);
+    REQUIRE(storage.check_array(array));
+    CHECK(array.type() == data::type_of<float64_t>);
+    CHECK(array.size() == vals.size());
+    CHECK_RANGE_EQ(array.part_offsets(),
+                   {0UZ, 200'000UZ, 200'007UZ, 200'007UZ, 350'007UZ});
+
+    // Array is read back as a contiguous one.
+    CHECK_RANGE_EQ(array.open_read<float64_t>(), vals);
+    CHECK_RANGE_EQ(array.read_range<float64_t>(199'990, 30),
+                   vals_span.subspan(199'990, 30));
+    CHECK_RANGE_EQ(array.read_range<float64_t>(300'000, 50'007),
+                   vals_span.subspan(300'000));
+    std::vector<float64_t> direct_vals(vals.size());
+    array.read_into(std::span{direct_vals});
+    CHECK(direct_vals == vals);
+
+    // Arrays that were written as a whole consist of a single part.
+    const auto whole_array = dataset.create_array("whole_array", vals);
+    CHECK_RANGE_EQ(whole_array.part_offsets(), {0UZ, vals.size()});
+  }
+  SUBCASE("spooled arrays") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.uniforms();
+
+    // Create an incompressible array, so that the compressed chunks exceed
+    // the spool threshold and are streamed into the storage on flush.
+    std::vector<uint64_t> vals(1'000'000);
+    std::mt19937_64 random_engine{123};
+    std::ranges::generate(vals, std::ref(random_engine));
+    const auto array = dataset.create_array("array", vals);
+    REQUIRE(storage.check_array(array));
+    CHECK(array.size() == vals.size());
+    CHECK_RANGE_EQ(array.read_range<uint64_t>(999'000, 1000),
+                   std::span{vals}.subspan(999'000, 1000));
+    CHECK_RANGE_EQ(array.open_read<uint64_t>(), vals);
+  }
+  SUBCASE("lossy arrays") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.varyings();
+
+    // Create the arrays within the error bound.
+    std::vector<float64_t> vals(10'000);
+    for (const auto& [i, val] : std::views::enumerate(vals)) {
+      val = std::sin(0.01 * static_cast<float64_t>(i));
+    }
+    constexpr data::ErrorBound bound_1{.absolute = 1.0e-3};
+    const auto array_1 = dataset.create_array("array_1", vals, bound_1);
+    const auto array_2 = dataset.create_array(
+        "array_2",
+        data::type_of<float64_t>,
+        std::as_bytes(std::span{vals}),
+        data::ErrorBound{.relative = 1.0e-6});
+
+    // Read the arrays back.
+    REQUIRE(array_1.size() == vals.size());
+    const auto vals_1 = array_1.read_range<float64_t>(0, vals.size());
+    for (const auto& [x, y] : std::views::zip(vals, vals_1)) {
+      CHECK(std::abs(x - y) <= 1.0e-3);
+    }
+    REQUIRE(array_2.size() == vals.size());
+    const auto vals_2 = array_2.read_range<float64_t>(0, vals.size());
+    for (const auto& [x, y] : std::views::zip(vals, vals_2)) {
+      CHECK(std::abs(x - y) <= 1.0e-6 * std::abs(x));
+    }
+  }
+  SUBCASE("dictionaries") {
+    data::DataStorage storage{":memory:"};
+    storage.set_dictionaries(true);
+    REQUIRE(storage.dictionaries());
+    const auto series = storage.create_series("");
+
+    // Write the similar arrays with the same name into the time steps. The
+    // first ones are compressed without the dictionary, and the following
+    // ones are compressed with the trained one.
+    std::vector<std::vector<float64_t>> vals(8);
+    std::vector<data::DataTimeStepView<data::DataStorage>> steps;
+    for (const auto& [step, step_vals] : std::views::enumerate(vals)) {
+      step_vals.resize(20'000);
+      for (const auto& [i, val] : std::views::enumerate(step_vals)) {
+        val = std::sin(0.01 * static_cast<float64_t>(i)) +
+              1.0e-3 * static_cast<float64_t>(step);
+      }
+      steps.push_back(series.create_time_step(static_cast<real_t>(step)));
+      steps.back().varyings().create_array("array", step_vals);
+    }
+
+    // Read the arrays back.
+    for (const auto& [step, step_vals] : std::views::zip(steps, vals)) {
+      const auto array = step.varyings().find_array("array");
+      REQUIRE(array.has_value());
+      CHECK_RANGE_EQ(array->open_read<float64_t>(), step_vals);
+      CHECK_RANGE_EQ(array->read_range<float64_t>(100, 10),
+                     std::span{step_vals}.subspan(100, 10));
+      const auto contents = step.read_all();
+      REQUIRE(contents.size() == 1);
+      CHECK_RANGE_EQ(contents.front().data,
+                     std::as_bytes(std::span{step_vals}));
+    }
+  }
+  SUBCASE("external arrays") {
+    const testing::TempDir temp_dir{};
+    data::DataStorage storage{temp_dir / "test_external.ttdb"};
+    const auto payload_path = storage.payload_path();
+    storage.set_external_arrays(true);
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.uniforms();
+
+    // Create the arrays in the payload file.
+    const auto array_1 =
+        dataset.create_array("array_1", std::vector{std::numbers::pi});
+    const std::vector<float32_t> vals{1.0F, 2.0F, 3.0F, 4.0F, 5.0F};
+    const auto array_2 = dataset.create_array("array_2", vals);
+    REQUIRE(storage.check_array(array_1));
+    REQUIRE(storage.check_array(array_2));
+    CHECK(std::filesystem::exists(payload_path));
+    CHECK(array_1.is_external());
+    CHECK(array_2.is_external());
+    CHECK(array_2.size() == vals.size());
+
+    // Read the arrays back.
+    CHECK_RANGE_EQ(array_1.open_read<float64_t>(), {std::numbers::pi});
+    CHECK_RANGE_EQ(array_2.open_read<float32_t>(), vals);
+    CHECK_RANGE_EQ(array_2.read_range<float32_t>(1, 3), {2.0F, 3.0F, 4.0F});
+
+    // Map the array into memory.
+    const auto mapping = array_2.map();
+    CHECK_RANGE_EQ(mapping.data(), std::as_bytes(std::span{vals}));
+
+    // Read the arrays at once.
+    const auto contents = dataset.read_all();
+    REQUIRE(contents.size() == 2);
+    CHECK(contents[0].array == array_1);
+    CHECK_RANGE_EQ(contents[1].data, std::as_bytes(std::span{vals}));
+
+    // Arrays written with the setting disabled are stored in the database.
+    storage.set_external_arrays(false);
+    const auto array_3 =
+        dataset.create_array("array_3", std::vector{std::numbers::e});
+    CHECK_FALSE(array_3.is_external());
+    CHECK_THROWS_MSG(array_3.map(), Exception, "not stored externally");
+    CHECK_RANGE_EQ(array_3.open_read<float64_t>(), {std::numbers::e});
+
+    // Payload of the deleted arrays is reclaimed, and the file is removed
+    // only once no external arrays are left.
+    storage.delete_array(array_1);
+    CHECK(std::filesystem::exists(payload_path));
+    CHECK_RANGE_EQ(array_2.open_read<float32_t>(), vals);
+    {
+      const auto transaction = storage.transaction();
+      storage.delete_array(array_2);
+      CHECK(std::filesystem::exists(payload_path));
+    }
+    CHECK_FALSE(std::filesystem::exists(payload_path));
+  }
+  SUBCASE("array references") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step_1 = series.create_time_step(0.0);
+    const auto step_2 = series.create_time_step(1.0);
+    const auto dataset_1 = step_1.varyings();
+    const auto dataset_2 = step_2.varyings();
+
+    // Create the arrays in the first dataset.
+    const auto static_1 = dataset_1.create_array_or_ref(
+        "static",
+        std::vector{1.0, 2.0, 3.0},
+        std::nullopt);
+    const auto dynamic_1 = dataset_1.create_array_or_ref(
+        "dynamic",
+        std::vector{1.0, 2.0, 3.0},
+        std::nullopt);
+    CHECK_FALSE(storage.array_is_ref(static_1));
+    CHECK_FALSE(storage.array_is_ref(dynamic_1));
+
+    // Unchanged array refers to the previous one, changed one is written.
+    const auto static_2 = dataset_2.create_array_or_ref(
+        "static",
+        std::vector{1.0, 2.0, 3.0},
+        dataset_1);
+    const auto dynamic_2 = dataset_2.create_array_or_ref(
+        "dynamic",
+        std::vector{1.0, 2.0, 4.0},
+        dataset_1);
+    CHECK(storage.array_is_ref(static_2));
+    CHECK_FALSE(storage.array_is_ref(dynamic_2));
+    CHECK(static_2.size() == 3);
+    CHECK(static_2.type() == data::type_of<float64_t>);
+    CHECK_RANGE_EQ(static_2.open_read<float64_t>(), {1.0, 2.0, 3.0});
+    CHECK_RANGE_EQ(static_2.read_range<float64_t>(1, 2), {2.0, 3.0});
+    CHECK_RANGE_EQ(dynamic_2.open_read<float64_t>(), {1.0, 2.0, 4.0});
+
+    // Writing into the reference detaches it from the source.
+    static_2.open_write<float64_t>()->write(std::vector{5.0});
+    CHECK_FALSE(storage.array_is_ref(static_2));
+    CHECK_RANGE_EQ(static_2.open_read<float64_t>(), {5.0});
+    CHECK_RANGE_EQ(static_1.open_read<float64_t>(), {1.0, 2.0, 3.0});
+  }
+  SUBCASE("deleting referenced arrays") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step_1 = series.create_time_step(0.0);
+    const auto step_2 = series.create_time_step(1.0);
+    const auto step_3 = series.create_time_step(2.0);
+    const auto static_1 = step_1.varyings().create_array_or_ref(
+        "static",
+        std::vector{1.0, 2.0, 3.0},
+        std::nullopt);
+    const auto static_2 = step_2.varyings().create_array_or_ref(
+        "static",
+        std::vector{1.0, 2.0, 3.0},
+        step_1.varyings());
+    const auto static_3 = step_3.varyings().create_array_or_ref(
+        "static",
+        std::vector{1.0, 2.0, 3.0},
+        step_2.varyings());
+    CHECK_FALSE(storage.array_is_ref(static_1));
+    CHECK(storage.array_is_ref(static_2));
+    CHECK(storage.array_is_ref(static_3));
+
+    // Deleting the source moves the data into the first of its references,
+    // and the remaining references are re-parented to it.
+    CHECK_NOTHROW(storage.delete_time_step(step_1));
+    CHECK(series.num_time_steps() == 2);
+    CHECK_FALSE(storage.array_is_ref(static_2));
+    CHECK(storage.array_is_ref(static_3));
+    CHECK_RANGE_EQ(static_2.open_read<float64_t>(), {1.0, 2.0, 3.0});
+    CHECK_RANGE_EQ(static_3.open_read<float64_t>(), {1.0, 2.0, 3.0});
+
+    // Deleting the new source leaves the last array on its own.
+    CHECK_NOTHROW(storage.delete_time_step(step_2));
+    CHECK_FALSE(storage.array_is_ref(static_3));
+    CHECK_RANGE_EQ(static_3.open_read<float64_t>(), {1.0, 2.0, 3.0});
+  }
+  SUBCASE("cached reads") {
+    data::DataStorage storage{":memory:"};
+    const auto series = storage.create_series("");
+    const auto step = series.create_time_step(0.0);
+    const auto dataset = step.uniforms();
+    const auto array = dataset.create_array("array", std::vector{1.0, 2.0});
+    const auto read_values = [&array] {
+      const auto buffer = array.read();
+      std::vector<float64_t> values(buffer->size() / sizeof(float64_t));
+      std::memcpy(values.data(), buffer->data(), buffer->size());
+      return values;
+    };
+
+    // Ensure the repeated reads share the cached buffer.
+    const auto buffer = array.read();
+    CHECK(array.read() == buffer);
+    CHECK_RANGE_EQ(read_values(), {1.0, 2.0});
+    CHECK_RANGE_EQ(array.read_range<float64_t>(1, 1), {2.0});
+
+    // Ensure the rewritten data is not read from the cache, while the
+    // previously read buffer stays valid.
+    array.open_write<float64_t>()->write(std::vector{3.0, 4.0, 5.0});
+    CHECK(array.read() != buffer);
+    CHECK_RANGE_EQ(read_values(), {3.0, 4.0, 5.0});
+    CHECK(buffer->size() == 2 * sizeof(float64_t));
+
+    // Ensure nothing is cached if the cache is disabled.
+    storage.set_cache_capacity(0);
+    CHECK(storage.cache_capacity() == 0);
+    CHECK(array.read() != array.read());
+  }
   SUBCASE("delete arrays") {
     data::DataStorage storage{":memory:"};
     const auto series = storage.create_series("");
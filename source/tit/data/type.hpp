@@ -16,6 +16,7 @@
 #include "tit/core/exception.hpp"
 #include "tit/core/mat.hpp"
 #include "tit/core/math.hpp"
+#include "tit/core/simd.hpp"
 #include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
 
@@ -27,7 +28,8 @@ namespace tit::data {
 class DataKind final {
 public:
 
-  /// Kind IDs.
+  /// Kind IDs. IDs are stored along with the data, so the new kinds must
+  /// only be appended.
   enum class ID : uint8_t {
     unknown_,
     int8,
@@ -41,6 +43,8 @@ public:
     float32,
     float64,
     float128,
+    float16,
+    bfloat16,
     count_,
   };
 
@@ -70,7 +74,9 @@ public:
         .option(uint64, 8)
         .option(float32, 4)
         .option(float64, 8)
-        .option(float128, 16);
+        .option(float128, 16)
+        .option(float16, 2)
+        .option(bfloat16, 2);
   }
 
   /// Data kind name.
@@ -87,7 +93,16 @@ public:
         .option(uint64, "uint64_t")
         .option(float32, "float32_t")
         .option(float64, "float64_t")
-        .option(float128, "float128_t");
+        .option(float128, "float128_t")
+        .option(float16, "float16_t")
+        .option(bfloat16, "bfloat16_t");
+  }
+
+  /// Is the data kind a floating-point one?
+  constexpr auto is_float() const -> bool {
+    using enum ID;
+    return id_ == float16 || id_ == bfloat16 || id_ == float32 ||
+           id_ == float64 || id_ == float128;
   }
 
   /// Compare data kinds.
@@ -148,6 +163,12 @@ template<std::floating_point Float>
   requires (sizeof(Float) == 16)
 inline constexpr auto kind_id_of<Float> = DataKind::ID::float128;
 
+template<>
+inline constexpr auto kind_id_of<simd::float16_t> = DataKind::ID::float16;
+
+template<>
+inline constexpr auto kind_id_of<simd::bfloat16_t> = DataKind::ID::bfloat16;
+
 } // namespace impl
 
 /// Class that has a known data kind.
@@ -225,6 +246,11 @@ public:
     return kind().width() * ipow(dim(), std::to_underlying(rank()));
   }
 
+  /// Data type of the same shape, but of a different kind.
+  constexpr auto with_kind(DataKind kind) const -> DataType {
+    return DataType{kind, rank_, dim_};
+  }
+
   /// Data type string representation.
   constexpr auto name() const -> std::string {
     using enum DataRank;
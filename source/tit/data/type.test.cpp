@@ -6,6 +6,7 @@
 #include "tit/core/basic_types.hpp"
 #include "tit/core/exception.hpp"
 #include "tit/core/mat.hpp"
+#include "tit/core/simd.hpp"
 #include "tit/core/vec.hpp"
 
 #include "tit/data/type.hpp"
@@ -38,6 +39,11 @@ TEST_CASE("data::kind_of") {
   CHECK(data::kind_of<int16_t>.id() == data::DataKind::ID::int16);
   CHECK(data::kind_of<float32_t>.id() == data::DataKind::ID::float32);
   CHECK(data::kind_of<uint64_t>.id() == data::DataKind::ID::uint64);
+  CHECK(data::kind_of<simd::float16_t>.id() == data::DataKind::ID::float16);
+  CHECK(data::kind_of<simd::float16_t>.width() == 2);
+  CHECK(data::kind_of<simd::bfloat16_t>.name() == "bfloat16_t");
+  CHECK(data::kind_of<simd::bfloat16_t>.is_float());
+  CHECK_FALSE(data::kind_of<int16_t>.is_float());
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -72,6 +78,16 @@ TEST_CASE("data::DataType") {
       CHECK(type.width() == 3 * 3 * 2);
       CHECK(type.name() == "Mat<int16_t, 3>");
     }
+    SUBCASE("with kind") {
+      const data::DataType type{data::kind_of<float64_t>,
+                                data::DataRank::vector,
+                                3};
+      const auto half_type = type.with_kind(data::kind_of<simd::float16_t>);
+      CHECK(half_type.rank() == data::DataRank::vector);
+      CHECK(half_type.dim() == 3);
+      CHECK(half_type.width() == 3 * 2);
+      CHECK(half_type.name() == "Vec<float16_t, 3>");
+    }
   }
   SUBCASE("incorrect") {
     SUBCASE("invalid rank") {
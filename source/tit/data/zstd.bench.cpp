@@ -0,0 +1,54 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/stream.hpp"
+
+#include "tit/data/zstd.hpp"
+
+#include "tit/testing/benchmark.hpp"
+
+namespace tit {
+namespace {
+
+using data::zstd::make_stream_compressor;
+using data::zstd::make_stream_decompressor;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Compress and decompress the particle positions. Number of threads is used
+// as the number of the compression workers.
+void bench_zstd_round_trip(benchmark::State& state) {
+  const auto count = testing::setup_benchmark(state);
+  const auto num_workers = static_cast<size_t>(state.range(1));
+  const auto points = testing::random_points<double, 3>(count);
+  const auto data = std::as_bytes(std::span{points});
+  std::vector<byte_t> compressed_data;
+  std::vector<byte_t> decompressed_data(data.size());
+  for (auto _ : state) {
+    compressed_data.clear();
+    make_stream_compressor(make_container_output_stream(compressed_data),
+                           /*level=*/0,
+                           num_workers == 1 ? 0 : num_workers)
+        ->write(data);
+    make_stream_decompressor(make_range_input_stream(compressed_data))
+        ->read(decompressed_data);
+    benchmark::DoNotOptimize(decompressed_data.data());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(data.size()));
+  state.counters["ratio"] = static_cast<double>(data.size()) /
+                            static_cast<double>(compressed_data.size());
+}
+
+BENCHMARK(bench_zstd_round_trip)->Apply(testing::sweep_sizes_and_threads);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -4,10 +4,14 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <algorithm>
+#include <functional>
 #include <iterator>
+#include <mutex>
 #include <span>
 #include <utility>
+#include <vector>
 
+#include <zdict.h>
 #include <zstd.h>
 #include <zstd_errors.h>
 
@@ -15,6 +19,7 @@
 #include "tit/core/checks.hpp"
 #include "tit/core/exception.hpp"
 #include "tit/core/stream.hpp"
+#include "tit/core/utils.hpp"
 
 #include "tit/data/zstd.hpp"
 
@@ -22,23 +27,231 @@ namespace tit::data::zstd {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace {
+
+// Maximum number of the idle objects that are kept in a pool.
+constexpr size_t MaxPoolSize = 64;
+
+// Thread-safe pool of the ZSTD contexts.
+template<class Context, auto Create, auto Reset, auto Free>
+class ContextPool final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(ContextPool);
+
+  ContextPool() {
+    contexts_.reserve(MaxPoolSize);
+  }
+
+  ~ContextPool() {
+    for (auto* const context : contexts_) Free(context);
+  }
+
+  // Take an idle context from the pool, or create a new one.
+  auto acquire() -> Context* {
+    {
+      const std::scoped_lock lock{mutex_};
+      if (!contexts_.empty()) {
+        auto* const context = contexts_.back();
+        contexts_.pop_back();
+        return context;
+      }
+    }
+    auto* const context = Create();
+    if (context == nullptr) TIT_THROW("Unable to create a ZSTD context!");
+    return context;
+  }
+
+  // Reset the context and return it into the pool. If the pool is full,
+  // the context is freed.
+  void release(Context* context) noexcept {
+    if (context == nullptr) return;
+    Reset(context, ZSTD_reset_session_and_parameters);
+    {
+      const std::scoped_lock lock{mutex_};
+      if (contexts_.size() < MaxPoolSize) {
+        contexts_.push_back(context);
+        return;
+      }
+    }
+    Free(context);
+  }
+
+private:
+
+  std::mutex mutex_;
+  std::vector<Context*> contexts_;
+
+}; // class ContextPool
+
+using CompressionContextPool =
+    ContextPool<ZSTD_CCtx, &ZSTD_createCCtx, &ZSTD_CCtx_reset, &ZSTD_freeCCtx>;
+using DecompressionContextPool =
+    ContextPool<ZSTD_DCtx, &ZSTD_createDCtx, &ZSTD_DCtx_reset, &ZSTD_freeDCtx>;
+
+auto compression_contexts() -> CompressionContextPool& {
+  static CompressionContextPool pool;
+  return pool;
+}
+
+auto decompression_contexts() -> DecompressionContextPool& {
+  static DecompressionContextPool pool;
+  return pool;
+}
+
+// Context of the calling thread, that keeps its parameters and the dictionary
+// between the one-shot calls, so that they are set up again only once they
+// change.
+template<class Context, auto Create, auto Reset, auto Free>
+class ThreadContext final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(ThreadContext);
+
+  ThreadContext() : context_{Create()} {
+    if (context_ == nullptr) TIT_THROW("Unable to create a ZSTD context!");
+  }
+
+  ~ThreadContext() {
+    Free(context_);
+  }
+
+  // Get the context, that is set up with the parameters and the dictionary.
+  // The setup function is called only if they differ from the ones of the
+  // previous call.
+  template<class Setup>
+  auto get(int level,
+           size_t num_workers,
+           std::span<const byte_t> dictionary,
+           const Setup& setup) -> Context* {
+    if (!is_setup_ || level_ != level || num_workers_ != num_workers ||
+        !std::ranges::equal(dictionary_, dictionary)) {
+      is_setup_ = false;
+      Reset(context_, ZSTD_reset_session_and_parameters);
+      setup(context_);
+      level_ = level;
+      num_workers_ = num_workers;
+      dictionary_.assign(dictionary.begin(), dictionary.end());
+      is_setup_ = true;
+    }
+    return context_;
+  }
+
+private:
+
+  Context* context_;
+  bool is_setup_ = false;
+  int level_ = 0;
+  size_t num_workers_ = 0;
+  std::vector<byte_t> dictionary_;
+
+}; // class ThreadContext
+
+using CompressionContext = ThreadContext<ZSTD_CCtx,
+                                         &ZSTD_createCCtx,
+                                         &ZSTD_CCtx_reset,
+                                         &ZSTD_freeCCtx>;
+using DecompressionContext = ThreadContext<ZSTD_DCtx,
+                                           &ZSTD_createDCtx,
+                                           &ZSTD_DCtx_reset,
+                                           &ZSTD_freeDCtx>;
+
+// Thread-safe pool of the stream buffers.
+class BufferPool final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(BufferPool);
+
+  BufferPool() {
+    buffers_.reserve(MaxPoolSize);
+  }
+
+  // Take an idle buffer from the pool, or an empty one.
+  auto acquire() -> std::vector<byte_t> {
+    const std::scoped_lock lock{mutex_};
+    if (buffers_.empty()) return {};
+    auto buffer = std::move(buffers_.back());
+    buffers_.pop_back();
+    return buffer;
+  }
+
+  // Clear the buffer and return it into the pool, keeping its capacity. If
+  // the pool is full, the buffer is freed.
+  void release(std::vector<byte_t>& buffer) noexcept {
+    if (buffer.capacity() == 0) return;
+    buffer.clear();
+    const std::scoped_lock lock{mutex_};
+    if (buffers_.size() < MaxPoolSize) buffers_.push_back(std::move(buffer));
+  }
+
+private:
+
+  std::mutex mutex_;
+  std::vector<std::vector<byte_t>> buffers_;
+
+}; // class BufferPool
+
+auto buffers() -> BufferPool& {
+  static BufferPool pool;
+  return pool;
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 // NOLINTBEGIN(cert-err58-cpp)
 const size_t StreamCompressor::in_chunk_size_ = ZSTD_CStreamInSize();
 const size_t StreamCompressor::out_chunk_size_ = ZSTD_CStreamOutSize();
 // NOLINTEND(cert-err58-cpp)
 
-StreamCompressor::StreamCompressor(OutputStreamPtr<byte_t> stream)
-    : stream_{std::move(stream)}, context_{ZSTD_createCCtx()} {
+StreamCompressor::StreamCompressor(OutputStreamPtr<byte_t> stream,
+                                   int level,
+                                   size_t num_workers,
+                                   std::span<const byte_t> dictionary)
+    : stream_{std::move(stream)}, context_{compression_contexts().acquire()},
+      in_buffer_{buffers().acquire()}, out_buffer_{buffers().acquire()} {
   TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  TIT_ASSERT(context_ != nullptr, "ZSTD context is null!");
+  const auto set_parameter = [this](ZSTD_cParameter param, int value) {
+    if (const auto status =
+            ZSTD_CCtx_setParameter(context_.get(), param, value);
+        ZSTD_isError(status) != 0) {
+      TIT_THROW("ZSTD compression parameter setup failed ({}): {}.",
+                std::to_underlying(ZSTD_getErrorCode(status)),
+                ZSTD_getErrorName(status));
+    }
+  };
+  if (level != 0) set_parameter(ZSTD_c_compressionLevel, level);
+  if (num_workers != 0) {
+    set_parameter(ZSTD_c_nbWorkers, static_cast<int>(num_workers));
+  }
+  if (!dictionary.empty()) {
+    if (const auto status = ZSTD_CCtx_loadDictionary(context_.get(),
+                                                     dictionary.data(),
+                                                     dictionary.size());
+        ZSTD_isError(status) != 0) {
+      TIT_THROW("ZSTD compression dictionary setup failed ({}): {}.",
+                std::to_underlying(ZSTD_getErrorCode(status)),
+                ZSTD_getErrorName(status));
+    }
+  }
+}
+
+StreamCompressor::~StreamCompressor() {
+  buffers().release(in_buffer_);
+  buffers().release(out_buffer_);
 }
 
 void StreamCompressor::Deleter_::operator()(ZSTD_CCtx_s* context) noexcept {
-  ZSTD_freeCCtx(context);
+  compression_contexts().release(context);
 }
 
 void StreamCompressor::write(std::span<const byte_t> data) {
   // Prepare the buffer.
-  if (in_buffer_.capacity() == 0) in_buffer_.reserve(in_chunk_size_);
+  if (in_buffer_.capacity() < in_chunk_size_) {
+    in_buffer_.reserve(in_chunk_size_);
+  }
 
   // Copy the remaining data into the buffer in chunks.
   while (!data.empty()) {
@@ -110,13 +323,31 @@ const size_t StreamDecompressor::in_chunk_size_ = ZSTD_DStreamInSize();
 const size_t StreamDecompressor::out_chunk_size_ = ZSTD_DStreamOutSize();
 // NOLINTEND(cert-err58-cpp)
 
-StreamDecompressor::StreamDecompressor(InputStreamPtr<byte_t> stream)
-    : stream_{std::move(stream)}, context_{ZSTD_createDCtx()} {
+StreamDecompressor::StreamDecompressor(InputStreamPtr<byte_t> stream,
+                                       std::span<const byte_t> dictionary)
+    : stream_{std::move(stream)}, context_{decompression_contexts().acquire()},
+      in_buffer_{buffers().acquire()}, out_buffer_{buffers().acquire()} {
   TIT_ASSERT(stream_ != nullptr, "Stream is null!");
+  TIT_ASSERT(context_ != nullptr, "ZSTD context is null!");
+  if (!dictionary.empty()) {
+    if (const auto status = ZSTD_DCtx_loadDictionary(context_.get(),
+                                                     dictionary.data(),
+                                                     dictionary.size());
+        ZSTD_isError(status) != 0) {
+      TIT_THROW("ZSTD decompression dictionary setup failed ({}): {}.",
+                std::to_underlying(ZSTD_getErrorCode(status)),
+                ZSTD_getErrorName(status));
+    }
+  }
+}
+
+StreamDecompressor::~StreamDecompressor() {
+  buffers().release(in_buffer_);
+  buffers().release(out_buffer_);
 }
 
 void StreamDecompressor::Deleter_::operator()(ZSTD_DCtx_s* context) noexcept {
-  ZSTD_freeDCtx(context);
+  decompression_contexts().release(context);
 }
 
 auto StreamDecompressor::read(std::span<byte_t> data) -> size_t {
@@ -124,8 +355,12 @@ auto StreamDecompressor::read(std::span<byte_t> data) -> size_t {
   TIT_ASSERT(stream_ != nullptr, "Stream is null!");
 
   // Prepare the buffers.
-  if (in_buffer_.capacity() == 0) in_buffer_.reserve(in_chunk_size_);
-  if (out_buffer_.capacity() == 0) out_buffer_.reserve(out_chunk_size_);
+  if (in_buffer_.capacity() < in_chunk_size_) {
+    in_buffer_.reserve(in_chunk_size_);
+  }
+  if (out_buffer_.capacity() < out_chunk_size_) {
+    out_buffer_.reserve(out_chunk_size_);
+  }
 
   size_t total_copied = 0;
   while (!data.empty()) {
@@ -188,4 +423,118 @@ auto StreamDecompressor::read(std::span<byte_t> data) -> size_t {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+auto compress(std::span<const byte_t> data,
+              std::vector<byte_t>& compressed,
+              int level,
+              size_t num_workers,
+              std::span<const byte_t> dictionary) -> size_t {
+  thread_local CompressionContext thread_context;
+  auto* const context = thread_context.get(
+      level,
+      num_workers,
+      dictionary,
+      [level, num_workers, dictionary](ZSTD_CCtx* ctx) {
+        const auto check = [](size_t status) {
+          if (ZSTD_isError(status) != 0) {
+            TIT_THROW("ZSTD compression setup failed ({}): {}.",
+                      std::to_underlying(ZSTD_getErrorCode(status)),
+                      ZSTD_getErrorName(status));
+          }
+        };
+        if (level != 0) {
+          check(ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, level));
+        }
+        if (num_workers != 0) {
+          check(ZSTD_CCtx_setParameter(ctx,
+                                       ZSTD_c_nbWorkers,
+                                       static_cast<int>(num_workers)));
+        }
+        if (!dictionary.empty()) {
+          check(ZSTD_CCtx_loadDictionary(ctx,
+                                         dictionary.data(),
+                                         dictionary.size()));
+        }
+      });
+  const auto offset = compressed.size();
+  compressed.resize(offset + ZSTD_compressBound(data.size()));
+  const auto status = ZSTD_compress2(context,
+                                     compressed.data() + offset,
+                                     compressed.size() - offset,
+                                     data.data(),
+                                     data.size());
+  if (ZSTD_isError(status) != 0) {
+    compressed.resize(offset);
+    TIT_THROW("ZSTD compression failed ({}): {}.",
+              std::to_underlying(ZSTD_getErrorCode(status)),
+              ZSTD_getErrorName(status));
+  }
+  compressed.resize(offset + status);
+  return status;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto decompress(std::span<const byte_t> source,
+                std::span<byte_t> data,
+                std::span<const byte_t> dictionary) -> size_t {
+  thread_local DecompressionContext thread_context;
+  auto* const context = thread_context.get(
+      /*level=*/0,
+      /*num_workers=*/0,
+      dictionary,
+      [dictionary](ZSTD_DCtx* ctx) {
+        if (dictionary.empty()) return;
+        if (const auto status = ZSTD_DCtx_loadDictionary(ctx,
+                                                         dictionary.data(),
+                                                         dictionary.size());
+            ZSTD_isError(status) != 0) {
+          TIT_THROW("ZSTD decompression dictionary setup failed ({}): {}.",
+                    std::to_underlying(ZSTD_getErrorCode(status)),
+                    ZSTD_getErrorName(status));
+        }
+      });
+  const auto status = ZSTD_decompressDCtx(context,
+                                          data.data(),
+                                          data.size(),
+                                          source.data(),
+                                          source.size());
+  if (ZSTD_isError(status) != 0) {
+    TIT_THROW("ZSTD decompression failed ({}): {}.",
+              std::to_underlying(ZSTD_getErrorCode(status)),
+              ZSTD_getErrorName(status));
+  }
+  return status;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+auto train_dictionary(std::span<const byte_t> samples,
+                      std::span<const size_t> sample_sizes,
+                      size_t max_size) -> std::vector<byte_t> {
+  TIT_ASSERT(std::ranges::fold_left(sample_sizes, size_t{0}, std::plus{}) ==
+                 samples.size(),
+             "Sample sizes do not match the samples!");
+  std::vector<byte_t> dictionary(max_size);
+  const auto size =
+      ZDICT_trainFromBuffer(dictionary.data(),
+                            dictionary.size(),
+                            samples.data(),
+                            sample_sizes.data(),
+                            static_cast<unsigned>(sample_sizes.size()));
+  // Training fails if there are too few samples, or they are too small.
+  if (ZDICT_isError(size) != 0) return {};
+  dictionary.resize(size);
+  return dictionary;
+}
+
+auto dictionary_id(std::span<const byte_t> dictionary) -> uint32_t {
+  return ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size());
+}
+
+auto frame_dictionary_id(std::span<const byte_t> frame) -> uint32_t {
+  return ZSTD_getDictID_fromFrame(frame.data(), frame.size());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::data::zstd
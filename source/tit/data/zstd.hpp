@@ -22,11 +22,29 @@ namespace tit::data::zstd {
 
 /// Stream that compresses data using ZSTD and writes it to the underlying
 /// output stream.
+///
+/// Compression contexts and buffers are taken from a thread-safe pool, and
+/// are returned to it once the stream is destroyed, so that opening a stream
+/// for a small piece of data is cheap.
 class StreamCompressor final : public OutputStream<byte_t> {
 public:
 
   /// Construct a stream compressor.
-  explicit StreamCompressor(OutputStreamPtr<byte_t> stream);
+  ///
+  /// @param stream      Underlying output stream.
+  /// @param level       Compression level. Zero means the ZSTD default.
+  /// @param num_workers Number of the worker threads that compress the data
+  ///                    in parallel. Zero means the compression is performed
+  ///                    on the calling thread.
+  /// @param dictionary  Compression dictionary. Empty means no dictionary.
+  ///                    Data must be decompressed with the same dictionary.
+  explicit StreamCompressor(OutputStreamPtr<byte_t> stream,
+                            int level = 0,
+                            size_t num_workers = 0,
+                            std::span<const byte_t> dictionary = {});
+
+  /// Release the compression context and buffers back to the pool.
+  ~StreamCompressor() override;
 
   /// Compress the data and write it to the underlying stream.
   void write(std::span<const byte_t> data) override;
@@ -50,20 +68,37 @@ private:
 }; // class StreamCompressor
 
 /// Make a stream compressor.
-inline auto make_stream_compressor(OutputStreamPtr<byte_t> stream)
+inline auto make_stream_compressor(OutputStreamPtr<byte_t> stream,
+                                   int level = 0,
+                                   size_t num_workers = 0,
+                                   std::span<const byte_t> dictionary = {})
     -> OutputStreamPtr<byte_t> {
-  return make_flushable<StreamCompressor>(std::move(stream));
+  return make_flushable<StreamCompressor>(std::move(stream),
+                                          level,
+                                          num_workers,
+                                          dictionary);
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Stream that reads data from the underlying input stream and decompresses
 /// it using ZSTD.
+///
+/// Decompression contexts and buffers are taken from a thread-safe pool, the
+/// same way as in the `StreamCompressor`.
 class StreamDecompressor final : public InputStream<byte_t> {
 public:
 
   /// Construct a stream decompressor.
-  explicit StreamDecompressor(InputStreamPtr<byte_t> stream);
+  ///
+  /// @param stream     Underlying input stream.
+  /// @param dictionary Dictionary the data was compressed with. Empty means
+  ///                   no dictionary.
+  explicit StreamDecompressor(InputStreamPtr<byte_t> stream,
+                              std::span<const byte_t> dictionary = {});
+
+  /// Release the decompression context and buffers back to the pool.
+  ~StreamDecompressor() override;
 
   /// Decompress the data.
   auto read(std::span<byte_t> data) -> size_t override;
@@ -87,11 +122,81 @@ private:
 }; // class StreamDecompressor
 
 /// Make a stream decompressor.
-inline auto make_stream_decompressor(InputStreamPtr<byte_t> stream)
+inline auto make_stream_decompressor(InputStreamPtr<byte_t> stream,
+                                     std::span<const byte_t> dictionary = {})
     -> InputStreamPtr<byte_t> {
-  return std::make_unique<StreamDecompressor>(std::move(stream));
+  return std::make_unique<StreamDecompressor>(std::move(stream), dictionary);
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Compress the data into a complete ZSTD frame, that is appended to the
+/// destination buffer.
+///
+/// Unlike the `StreamCompressor`, the compression context is kept per calling
+/// thread, along with its parameters and the dictionary, so compressing many
+/// small pieces of data does not set up the context for each of them.
+///
+/// @param data        Data to compress.
+/// @param compressed  Destination buffer, the frame is appended to it.
+/// @param level       Compression level. Zero means the ZSTD default.
+/// @param num_workers Number of the worker threads that compress the data
+///                    in parallel. Zero means the compression is performed
+///                    on the calling thread.
+/// @param dictionary  Compression dictionary. Empty means no dictionary.
+///
+/// @returns Size of the compressed frame, in bytes.
+auto compress(std::span<const byte_t> data,
+              std::vector<byte_t>& compressed,
+              int level = 0,
+              size_t num_workers = 0,
+              std::span<const byte_t> dictionary = {}) -> size_t;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Decompress the complete ZSTD frames straight into the destination buffer.
+///
+/// Unlike the `StreamDecompressor`, the data is not staged in the internal
+/// buffers, so this is the preferred way to decompress the data whose size
+/// is known upfront. Decompression context is kept per calling thread, the
+/// same way as in `compress`.
+///
+/// @param source     Compressed data, one or more complete frames.
+/// @param data       Destination buffer, must fit the decompressed data.
+/// @param dictionary Dictionary the data was compressed with. Empty means
+///                   no dictionary.
+///
+/// @returns Size of the decompressed data, in bytes.
+auto decompress(std::span<const byte_t> source,
+                std::span<byte_t> data,
+                std::span<const byte_t> dictionary = {}) -> size_t;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Train a compression dictionary on the samples.
+///
+/// @param samples      Concatenated samples.
+/// @param sample_sizes Sizes of the samples, in bytes.
+/// @param max_size     Maximum size of the dictionary, in bytes.
+///
+/// @returns Trained dictionary, or an empty one if there is too little data
+///          to train on.
+auto train_dictionary(std::span<const byte_t> samples,
+                      std::span<const size_t> sample_sizes,
+                      size_t max_size) -> std::vector<byte_t>;
+
+/// Identifier of the compression dictionary.
+///
+/// @returns Dictionary identifier, or zero if the dictionary is not in the
+///          ZSTD format, for example, if it is empty.
+auto dictionary_id(std::span<const byte_t> dictionary) -> uint32_t;
+
+/// Identifier of the dictionary, that the frame was compressed with.
+///
+/// @returns Dictionary identifier, or zero if the frame was compressed
+///          without a dictionary, or the identifier is not recorded.
+auto frame_dictionary_id(std::span<const byte_t> frame) -> uint32_t;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::data::zstd
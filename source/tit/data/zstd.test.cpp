@@ -4,9 +4,11 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <algorithm>
+#include <array>
 #include <numbers>
 #include <random>
 #include <ranges>
+#include <span>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
@@ -65,12 +67,43 @@ TEST_CASE("data::zstd::small_data") {
   auto decompressor =
       make_stream_decompressor(make_range_input_stream(compressed_data));
   REQUIRE(decompressor->read(decompressed_data) == small_data.size());
-  CHECK(decompressed_data >= small_data);
+  CHECK_RANGE_EQ(std::span{decompressed_data}.first(small_data.size()),
+                 small_data);
   CHECK(decompressor->read(decompressed_data) == 0);
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("data::zstd::options") {
+  const auto data =
+      std::views::repeat(to_byte_array(std::numbers::pi), 100'000) |
+      std::views::join | std::ranges::to<std::vector>();
+  const auto run_subcase = [&data](int level, size_t num_workers) {
+    std::vector<byte_t> compressed_data;
+    make_stream_compressor(make_container_output_stream(compressed_data),
+                           level,
+                           num_workers)
+        ->write(data);
+    REQUIRE(!compressed_data.empty());
+
+    std::vector<byte_t> decompressed_data(data.size() * 3 / 2);
+    auto decompressor =
+        make_stream_decompressor(make_range_input_stream(compressed_data));
+    REQUIRE(decompressor->read(decompressed_data) == data.size());
+    CHECK_RANGE_EQ(std::span{decompressed_data}.first(data.size()), data);
+    CHECK(decompressor->read(decompressed_data) == 0);
+  };
+  SUBCASE("level") {
+    run_subcase(/*level=*/1, /*num_workers=*/0);
+    run_subcase(/*level=*/19, /*num_workers=*/0);
+  }
+  SUBCASE("workers") {
+    run_subcase(/*level=*/0, /*num_workers=*/4);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("data::zstd::large_data") {
   constexpr auto run_test = [](size_t size_multiplier) {
     const auto large_data =
@@ -96,7 +129,8 @@ TEST_CASE("data::zstd::large_data") {
       auto decompressor =
           make_stream_decompressor(make_range_input_stream(compressed_data));
       REQUIRE(decompressor->read(decompressed_data) == large_data.size());
-      CHECK(decompressed_data >= large_data);
+      CHECK_RANGE_EQ(std::span{decompressed_data}.first(large_data.size()),
+                     large_data);
       CHECK(decompressor->read(decompressed_data) == 0);
     }
 
@@ -115,7 +149,8 @@ TEST_CASE("data::zstd::large_data") {
         auto decompressor =
             make_stream_decompressor(make_range_input_stream(compressed_data));
         REQUIRE(decompressor->read(decompressed_data) == large_data.size());
-        CHECK(decompressed_data >= large_data);
+        CHECK_RANGE_EQ(std::span{decompressed_data}.first(large_data.size()),
+                       large_data);
         CHECK(decompressor->read(decompressed_data) == 0);
       };
 
@@ -171,6 +206,204 @@ TEST_CASE("data::zstd::large_data") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("data::zstd::decompress") {
+  const auto data =
+      std::views::repeat(to_byte_array(std::numbers::pi), 100'000) |
+      std::views::join | std::ranges::to<std::vector>();
+  const auto half = std::span{data}.first(data.size() / 2);
+
+  // Compress the halves of the data as the separate frames.
+  std::vector<byte_t> compressed_data;
+  make_stream_compressor(make_container_output_stream(compressed_data))
+      ->write(half);
+  make_stream_compressor(make_container_output_stream(compressed_data))
+      ->write(half);
+  REQUIRE(!compressed_data.empty());
+  SUBCASE("success") {
+    std::vector<byte_t> decompressed_data(data.size());
+    CHECK(data::zstd::decompress(compressed_data, decompressed_data) ==
+          data.size());
+    CHECK(decompressed_data == data);
+  }
+  SUBCASE("destination is too small") {
+    std::vector<byte_t> decompressed_data(data.size() - 1);
+    CHECK_THROWS_MSG(
+        data::zstd::decompress(compressed_data, decompressed_data),
+        Exception,
+        "ZSTD decompression failed");
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::zstd::compress") {
+  const auto data =
+      std::views::repeat(to_byte_array(std::numbers::pi), 100'000) |
+      std::views::join | std::ranges::to<std::vector>();
+  const auto half = std::span{data}.first(data.size() / 2);
+
+  // Append the halves of the data as the separate frames, with the different
+  // levels, so that the thread context is set up again.
+  std::vector<byte_t> compressed_data;
+  const auto first_size = data::zstd::compress(half, compressed_data);
+  CHECK(compressed_data.size() == first_size);
+  const auto second_size =
+      data::zstd::compress(half, compressed_data, /*level=*/19);
+  CHECK(compressed_data.size() == first_size + second_size);
+  SUBCASE("decompress") {
+    std::vector<byte_t> decompressed_data(data.size());
+    CHECK(data::zstd::decompress(compressed_data, decompressed_data) ==
+          data.size());
+    CHECK(decompressed_data == data);
+  }
+  SUBCASE("stream") {
+    std::vector<byte_t> decompressed_data(data.size());
+    auto decompressor =
+        make_stream_decompressor(make_range_input_stream(compressed_data));
+    REQUIRE(decompressor->read(decompressed_data) == data.size());
+    CHECK(decompressed_data == data);
+    CHECK(decompressor->read(decompressed_data) == 0);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("data::zstd::dictionary") {
+  // Make the samples, that are composed of the words from a small
+  // vocabulary, so that they are similar, but not identical.
+  std::minstd_rand rng{123};
+  std::vector<std::array<byte_t, 16>> words(32);
+  for (auto& word : words) {
+    std::ranges::generate(word, [&rng] { return static_cast<byte_t>(rng()); });
+  }
+  const auto make_sample = [&rng, &words] {
+    std::vector<byte_t> sample;
+    for (size_t i = 0; i < 64; ++i) {
+      const auto& word = words[rng() % words.size()];
+      sample.insert(sample.end(), word.begin(), word.end());
+    }
+    return sample;
+  };
+  std::vector<byte_t> samples;
+  std::vector<size_t> sample_sizes;
+  for (size_t i = 0; i < 200; ++i) {
+    const auto sample = make_sample();
+    samples.insert(samples.end(), sample.begin(), sample.end());
+    sample_sizes.push_back(sample.size());
+  }
+
+  SUBCASE("train and use") {
+    const auto dictionary =
+        data::zstd::train_dictionary(samples, sample_sizes, 16 * 1024);
+    REQUIRE_FALSE(dictionary.empty());
+    CHECK(dictionary.size() <= 16 * 1024);
+
+    // Compress a new sample with and without the dictionary.
+    const auto data = make_sample();
+    std::vector<byte_t> plain_data;
+    make_stream_compressor(make_container_output_stream(plain_data))
+        ->write(data);
+    std::vector<byte_t> compressed_data;
+    make_stream_compressor(make_container_output_stream(compressed_data),
+                           /*level=*/0,
+                           /*num_workers=*/0,
+                           dictionary)
+        ->write(data);
+    CHECK(compressed_data.size() < plain_data.size());
+
+    // Frames must record the identifier of the dictionary they need.
+    const auto dict_id = data::zstd::dictionary_id(dictionary);
+    CHECK(dict_id != 0);
+    CHECK(data::zstd::frame_dictionary_id(compressed_data) == dict_id);
+    CHECK(data::zstd::frame_dictionary_id(plain_data) == 0);
+
+    // Decompress with the dictionary.
+    std::vector<byte_t> decompressed_data(data.size() * 2);
+    auto decompressor =
+        make_stream_decompressor(make_range_input_stream(compressed_data),
+                                 dictionary);
+    REQUIRE(decompressor->read(decompressed_data) == data.size());
+    CHECK_RANGE_EQ(std::span{decompressed_data}.first(data.size()), data);
+    CHECK(decompressor->read(decompressed_data) == 0);
+
+    // Decompress straight into the buffer with the dictionary.
+    std::vector<byte_t> direct_data(data.size());
+    CHECK(data::zstd::decompress(compressed_data, direct_data, dictionary) ==
+          data.size());
+    CHECK(direct_data == data);
+  }
+  SUBCASE("pooled contexts are reset") {
+    const auto dictionary =
+        data::zstd::train_dictionary(samples, sample_sizes, 16 * 1024);
+    REQUIRE_FALSE(dictionary.empty());
+
+    // Use the contexts with the dictionary, and return them to the pool.
+    const auto data = make_sample();
+    std::vector<byte_t> compressed_data;
+    make_stream_compressor(make_container_output_stream(compressed_data),
+                           /*level=*/19,
+                           /*num_workers=*/0,
+                           dictionary)
+        ->write(data);
+    std::vector<byte_t> decompressed_data(data.size());
+    make_stream_decompressor(make_range_input_stream(compressed_data),
+                             dictionary)
+        ->read(decompressed_data);
+
+    // Reused contexts must not remember the dictionary.
+    compressed_data.clear();
+    make_stream_compressor(make_container_output_stream(compressed_data))
+        ->write(data);
+    auto decompressor =
+        make_stream_decompressor(make_range_input_stream(compressed_data));
+    REQUIRE(decompressor->read(decompressed_data) == data.size());
+    CHECK(decompressed_data == data);
+  }
+  SUBCASE("thread contexts follow the dictionary") {
+    const auto dictionary =
+        data::zstd::train_dictionary(samples, sample_sizes, 16 * 1024);
+    REQUIRE_FALSE(dictionary.empty());
+
+    // Compress the same data with, without, and again with the dictionary,
+    // so that the thread contexts are set up again on each call.
+    const auto data = make_sample();
+    std::vector<byte_t> dict_data;
+    std::vector<byte_t> plain_data;
+    std::vector<byte_t> redict_data;
+    data::zstd::compress(data,
+                         dict_data,
+                         /*level=*/0,
+                         /*num_workers=*/0,
+                         dictionary);
+    data::zstd::compress(data, plain_data);
+    data::zstd::compress(data,
+                         redict_data,
+                         /*level=*/0,
+                         /*num_workers=*/0,
+                         dictionary);
+    CHECK(redict_data == dict_data);
+    CHECK(dict_data.size() < plain_data.size());
+
+    std::vector<byte_t> decompressed_data(data.size());
+    CHECK(data::zstd::decompress(dict_data, decompressed_data, dictionary) ==
+          data.size());
+    CHECK(decompressed_data == data);
+    std::ranges::fill(decompressed_data, byte_t{0});
+    CHECK(data::zstd::decompress(plain_data, decompressed_data) ==
+          data.size());
+    CHECK(decompressed_data == data);
+  }
+  SUBCASE("too few samples") {
+    const auto dictionary =
+        data::zstd::train_dictionary(std::span{samples}.first(16),
+                                     std::vector{16UZ},
+                                     16 * 1024);
+    CHECK(dictionary.empty());
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("data::zstd::errors") {
   static std::minstd_rand rng{std::random_device{}()};
   SUBCASE("completely invalid data") {
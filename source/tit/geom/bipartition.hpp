@@ -13,6 +13,7 @@
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/par/algorithms.hpp"
 #include "tit/core/range_utils.hpp"
 #include "tit/core/tuple_utils.hpp"
 #include "tit/core/utils.hpp"
@@ -39,19 +40,19 @@ public:
     TIT_ASSUME_UNIVERSAL(Points, points);
     TIT_ASSUME_UNIVERSAL(Perm, perm);
     TIT_ASSERT(axis < point_range_dim_v<Points>, "Axis is out of range!");
-    std::ranges::borrowed_subrange_t<Perm> right_perm;
+    std::ranges::iterator_t<Perm> median;
     if (reverse) {
-      right_perm = std::ranges::partition(
+      median = par::partition(
           perm,
           std::bind_back(std::greater{}, pivot),
           [&points, axis](size_t index) { return points[index][axis]; });
     } else {
-      right_perm = std::ranges::partition(
+      median = par::partition(
           perm,
           std::bind_back(std::less{}, pivot),
           [&points, axis](size_t index) { return points[index][axis]; });
     }
-    return {{std::begin(perm), std::begin(right_perm)}, std::move(right_perm)};
+    return {{std::begin(perm), median}, {median, std::end(perm)}};
   }
 
 }; // class CoordBisection
@@ -75,19 +76,19 @@ public:
       -> pair_of_t<std::ranges::borrowed_subrange_t<Perm>> {
     TIT_ASSUME_UNIVERSAL(Points, points);
     TIT_ASSUME_UNIVERSAL(Perm, perm);
-    std::ranges::borrowed_subrange_t<Perm> right_perm;
+    std::ranges::iterator_t<Perm> median;
     if (reverse) {
-      right_perm = std::ranges::partition(
+      median = par::partition(
           perm,
           std::bind_back(std::greater{}, pivot),
           [&points, &dir](size_t index) { return dot(points[index], dir); });
     } else {
-      right_perm = std::ranges::partition(
+      median = par::partition(
           perm,
           std::bind_back(std::less{}, pivot),
           [&points, &dir](size_t index) { return dot(points[index], dir); });
     }
-    return {{std::begin(perm), std::begin(right_perm)}, std::move(right_perm)};
+    return {{std::begin(perm), median}, {median, std::end(perm)}};
   }
 
 }; // class DirBisection
@@ -97,6 +98,47 @@ inline constexpr DirBisection dir_bisection{};
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace impl {
+
+/// Partially sort the permutation with respect to the comparator, so that
+/// the total weight of the points before the returned iterator is as close as
+/// possible to the given weight.
+template<output_index_range Perm, weight_range Weights, class Less>
+constexpr auto weighted_nth_element(Perm&& perm,
+                                    Weights&& weights,
+                                    weight_range_val_t<Weights> left_weight,
+                                    Less less)
+    -> std::ranges::iterator_t<Perm> {
+  TIT_ASSUME_UNIVERSAL(Perm, perm);
+  TIT_ASSUME_UNIVERSAL(Weights, weights);
+  auto first = std::begin(perm);
+  auto last = std::end(perm);
+  if (first == last || left_weight <= 0) return first;
+
+  // Narrow down the range that contains the split point. Each step halves
+  // the range, so the total complexity is still linear.
+  while (last - first > 1) {
+    const auto mid = first + (last - first) / 2;
+    par::nth_element(std::ranges::subrange{first, last}, mid, less);
+    weight_range_val_t<Weights> mid_weight{};
+    for (auto iter = first; iter != mid; ++iter) mid_weight += weights[*iter];
+    if (mid_weight >= left_weight) {
+      last = mid;
+    } else {
+      left_weight -= mid_weight;
+      first = mid;
+    }
+  }
+
+  // The remaining point crosses the given weight, so put it to the side
+  // that results into the smaller error.
+  return 2 * left_weight < weights[*first] ? first : last;
+}
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Coordinate median split function.
 class CoordMedianSplit final {
 public:
@@ -112,7 +154,7 @@ public:
     TIT_ASSUME_UNIVERSAL(Points, points);
     TIT_ASSUME_UNIVERSAL(Perm, perm);
     TIT_ASSERT(axis < point_range_dim_v<Points>, "Axis is out of range!");
-    std::ranges::nth_element(
+    par::nth_element(
         perm,
         median,
         std::less{},
@@ -134,6 +176,46 @@ public:
     return (*this)(points, perm, median, axis);
   }
 
+  /// Split the points into two parts along the given coordinate axis, so that
+  /// the total weight of the left part is close to the given weight.
+  template<point_range Points, output_index_range Perm, weight_range Weights>
+  constexpr auto operator()(Points&& points,
+                            Perm&& perm,
+                            Weights&& weights,
+                            weight_range_val_t<Weights> left_weight,
+                            size_t axis) const
+      -> pair_of_t<std::ranges::borrowed_subrange_t<Perm>> {
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Perm, perm);
+    TIT_ASSUME_UNIVERSAL(Weights, weights);
+    TIT_ASSERT(axis < point_range_dim_v<Points>, "Axis is out of range!");
+    const auto median = impl::weighted_nth_element(
+        perm,
+        weights,
+        left_weight,
+        [&points, axis](size_t i, size_t j) {
+          return points[i][axis] < points[j][axis];
+        });
+    return {{std::begin(perm), median}, {median, std::end(perm)}};
+  }
+
+  /// Split the points into two parts along the longest axis of the points
+  /// bounding box, so that the total weight of the left part is close to the
+  /// given weight.
+  template<point_range Points, output_index_range Perm, weight_range Weights>
+  constexpr auto operator()(Points&& points,
+                            Perm&& perm,
+                            Weights&& weights,
+                            weight_range_val_t<Weights> left_weight) const
+      -> pair_of_t<std::ranges::borrowed_subrange_t<Perm>> {
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Perm, perm);
+    TIT_ASSUME_UNIVERSAL(Weights, weights);
+    const auto box = compute_bbox(points, perm);
+    const auto axis = max_value_index(box.extents());
+    return (*this)(points, perm, weights, left_weight, axis);
+  }
+
 }; // class CoordMedianSplit
 
 /// Coordinate median split.
@@ -155,7 +237,7 @@ public:
       -> pair_of_t<std::ranges::borrowed_subrange_t<Perm>> {
     TIT_ASSUME_UNIVERSAL(Points, points);
     TIT_ASSUME_UNIVERSAL(Perm, perm);
-    std::ranges::nth_element( //
+    par::nth_element( //
         perm,
         median,
         [&points, &dir](size_t i, size_t j) {
@@ -164,6 +246,29 @@ public:
     return {{std::begin(perm), median}, {median, std::end(perm)}};
   }
 
+  /// Split the points into two parts along the axis, spaned by the given
+  /// direction, so that the total weight of the left part is close to the
+  /// given weight.
+  template<point_range Points, output_index_range Perm, weight_range Weights>
+  constexpr auto operator()(Points&& points,
+                            Perm&& perm,
+                            Weights&& weights,
+                            weight_range_val_t<Weights> left_weight,
+                            const point_range_vec_t<Points>& dir) const
+      -> pair_of_t<std::ranges::borrowed_subrange_t<Perm>> {
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Perm, perm);
+    TIT_ASSUME_UNIVERSAL(Weights, weights);
+    const auto median = impl::weighted_nth_element(
+        perm,
+        weights,
+        left_weight,
+        [&points, &dir](size_t i, size_t j) {
+          return dot(points[i] - points[j], dir) < 0;
+        });
+    return {{std::begin(perm), median}, {median, std::end(perm)}};
+  }
+
 }; // class DirMedianSplit
 
 /// Directional median split.
@@ -192,6 +297,26 @@ public:
     return dir_median_split(points, perm, median, dir);
   }
 
+  /// Split the points into two parts along the "largest" inertial axis of the
+  /// point cloud, so that the total weight of the left part is close to the
+  /// given weight. If the inertia analysis fails, the given fallback vector is
+  /// used instead.
+  template<point_range Points, output_index_range Perm, weight_range Weights>
+  constexpr auto operator()(Points&& points,
+                            Perm&& perm,
+                            Weights&& weights,
+                            weight_range_val_t<Weights> left_weight,
+                            const point_range_vec_t<Points>& fallback_dir =
+                                unit(point_range_vec_t<Points>{})) const
+      -> pair_of_t<std::ranges::borrowed_subrange_t<Perm>> {
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Perm, perm);
+    TIT_ASSUME_UNIVERSAL(Weights, weights);
+    const auto dir =
+        compute_largest_inertia_axis(points, perm).value_or(fallback_dir);
+    return dir_median_split(points, perm, weights, left_weight, dir);
+  }
+
 }; // class InertialMedianSplit
 
 /// Inertial median split.
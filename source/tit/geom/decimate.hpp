@@ -0,0 +1,68 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <limits>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/grid.hpp"
+#include "tit/geom/point_range.hpp"
+
+namespace tit::geom {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Decimate the points over the grid.
+///
+/// For each non-empty grid cell, the point that is closest to the cell center
+/// is selected. Points outside of the grid bounding box are ignored. Indices
+/// of the selected points are returned in the order of the flat cell indices,
+/// so that decimating the same points over the same grid always selects the
+/// same points in the same order.
+template<point_range Points>
+auto grid_decimate(Points&& points, const Grid<point_range_vec_t<Points>>& grid)
+    -> std::vector<size_t> {
+  TIT_ASSUME_UNIVERSAL(Points, points);
+  using Vec = point_range_vec_t<Points>;
+  using Num = point_range_num_t<Points>;
+  using VecIndex = typename Grid<Vec>::VecIndex;
+  static constexpr auto npos = std::numeric_limits<size_t>::max();
+
+  // Find the point closest to the center of each cell.
+  const auto& box = grid.box();
+  const auto& num_cells = grid.num_cells();
+  const auto& cell_extents = grid.cell_extents();
+  std::vector<size_t> cell_points(grid.flat_num_cells(), npos);
+  std::vector<Num> cell_dists(grid.flat_num_cells());
+  for (const auto& [i, point] : std::views::enumerate(points)) {
+    if (!(box.low() <= point && point < box.high())) continue;
+    // Rounding may push the points near the upper bound out of the grid.
+    const auto cell_index =
+        minimum(vec_cast<size_t>((point - box.low()) / cell_extents),
+                num_cells - VecIndex(1));
+    const auto cell_center =
+        box.low() + (vec_cast<Num>(cell_index) + Vec(Num{0.5})) * cell_extents;
+    const auto dist = norm2(point - cell_center);
+    const auto flat_index = grid.flatten_cell_index(cell_index);
+    if (cell_points[flat_index] == npos || dist < cell_dists[flat_index]) {
+      cell_points[flat_index] = static_cast<size_t>(i);
+      cell_dists[flat_index] = dist;
+    }
+  }
+
+  // Collect the points of the non-empty cells.
+  std::erase(cell_points, npos);
+  return cell_points;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::geom
@@ -0,0 +1,39 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/decimate.hpp"
+#include "tit/geom/grid.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("geom::grid_decimate") {
+  const std::vector points{
+      Vec{0.1, 0.1}, // Cell (0, 0).
+      Vec{0.6, 0.4}, // Cell (0, 0), closest to the center.
+      Vec{1.9, 0.1}, // Cell (1, 0).
+      Vec{2.0, 2.0}, // Upper bound, outside of the grid.
+      Vec{1.5, 1.5}, // Cell (1, 1).
+      Vec{1.4, 1.6}, // Cell (1, 1).
+      Vec{5.0, 5.0}, // Outside of the grid.
+  };
+  const geom::Grid grid{geom::BBox{Vec{0.0, 0.0}, Vec{2.0, 2.0}}, {2, 2}};
+  CHECK(geom::grid_decimate(points, grid) == std::vector<size_t>{1, 2, 4});
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -5,12 +5,16 @@
 
 #pragma once
 
+#include <concepts>
+#include <iterator>
 #include <ranges>
 #include <utility>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/missing.hpp" // IWYU pragma: keep
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
 
 #include "tit/geom/bbox.hpp"
@@ -129,6 +133,36 @@ public:
     return flat_index;
   }
 
+  /// Flat indices of the cells containing the given points.
+  ///
+  /// Same as `flat_cell_index` of each point, but the grid parameters are
+  /// loaded once, and the flat index is a dot product with the cell strides
+  /// rather than a chain of the dependent multiply-adds, so that the index
+  /// computation is vectorized. Points are processed in parallel.
+  template<std::ranges::random_access_range Points,
+           std::random_access_iterator OutIter>
+    requires std::ranges::sized_range<Points> &&
+             std::convertible_to<std::ranges::range_reference_t<Points>,
+                                 Vec> &&
+             std::output_iterator<OutIter, size_t>
+  void flat_cell_indices(Points&& points, OutIter out) const {
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    par::transform(points,
+                   out,
+                   [origin = box_.low(),
+                    inv_extents = inv_cell_extents_,
+                    strides = cell_strides_(),
+                    this](const Vec& point) {
+                     const auto index_float = (point - origin) * inv_extents;
+                     TIT_ASSERT(index_float >= Vec(0),
+                                "Point is out of range!");
+                     TIT_ASSERT(index_float <
+                                    vec_cast<vec_num_t<Vec>>(num_cells_),
+                                "Point is out of range!");
+                     return dot(vec_cast<size_t>(index_float), strides);
+                   });
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Range of cell indices, such that `low <= index < high`.
@@ -173,6 +207,15 @@ public:
 
 private:
 
+  // Strides of the flat cell index along each axis.
+  constexpr auto cell_strides_() const noexcept -> VecIndex {
+    VecIndex strides(1);
+    for (size_t i = vec_dim_v<Vec> - 1; i > 0; --i) {
+      strides[i - 1] = strides[i] * num_cells_[i];
+    }
+    return strides;
+  }
+
   Box box_;
   VecIndex num_cells_;
   Vec cell_extents_;
@@ -3,6 +3,9 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
 #include "tit/core/vec.hpp"
 
 #include "tit/geom/bbox.hpp"
@@ -114,6 +117,23 @@ TEST_CASE("geom::Grid::cell_index") {
   CHECK(grid.flatten_cell_index({1, 1}) == 3);
 }
 
+TEST_CASE("geom::Grid::flat_cell_indices") {
+  // Batch indices match the ones of the individual points.
+  const geom::BBox box{Vec{0.0, 0.0, 0.0}, Vec{4.0, 6.0, 2.0}};
+  const geom::Grid grid{box, {4, 3, 2}};
+  std::vector<Vec<double, 3>> points;
+  for (double x = 0.5; x < 4.0; x += 1.0) {
+    for (double y = 0.5; y < 6.0; y += 1.0) {
+      for (double z = 0.25; z < 2.0; z += 0.5) points.push_back({x, y, z});
+    }
+  }
+  std::vector<size_t> indices(points.size());
+  grid.flat_cell_indices(points, indices.begin());
+  for (size_t i = 0; i < points.size(); ++i) {
+    CHECK(indices[i] == grid.flat_cell_index(points[i]));
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("geom::Grid::cells") {
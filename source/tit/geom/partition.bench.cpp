@@ -0,0 +1,43 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/control.hpp"
+
+#include "tit/geom/partition.hpp"
+
+#include "tit/testing/benchmark.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Partition the points into one part per thread.
+template<geom::partition_func PartitionFunc>
+void bench_partition(benchmark::State& state) {
+  const auto count = testing::setup_benchmark(state);
+  const auto points = testing::random_points<double, 3>(count);
+  const PartitionFunc partition{};
+  std::vector<size_t> parts(count);
+  for (auto _ : state) {
+    partition(points, parts, par::num_threads());
+    benchmark::DoNotOptimize(parts.data());
+    benchmark::ClobberMemory();
+  }
+  testing::report_items(state, count);
+}
+
+BENCHMARK_TEMPLATE(bench_partition, geom::RecursiveInertialBisection)
+    ->Apply(testing::sweep_sizes_and_threads);
+BENCHMARK_TEMPLATE(bench_partition, geom::HilbertCurvePartition)
+    ->Apply(testing::sweep_sizes_and_threads);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <ranges>
 #include <vector>
 
@@ -19,17 +21,21 @@
 
 #include "tit/geom/grid.hpp"
 #include "tit/geom/point_range.hpp"
+#include "tit/geom/sort/hilbert_curve_sort.hpp"
 
 #include "tit/graph/graph.hpp"
-#include "tit/graph/simple_partition.hpp"
+#include "tit/graph/partition.hpp"
 
 namespace tit::geom {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Partitioning based on a graph partitioning of a grid cell connectivity.
-/// @todo Replace `UniformPartition` with a proper graph partitioning function.
-template<graph::partition_func GraphPartition = graph::UniformPartition>
+///
+/// Graph nodes are the non-empty grid cells, numbered along the Hilbert
+/// curve. Graph is partitioned by the multilevel METIS partitioner by
+/// default, any other graph partitioning function can be plugged in.
+template<graph::partition_func GraphPartition = graph::MetisPartition>
 class GridGraphPartition final {
 public:
 
@@ -49,8 +55,27 @@ public:
                   Parts&& parts,
                   size_t num_parts,
                   size_t init_part = 0) const {
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Parts, parts);
+    (*this)(points,
+            std::views::repeat(graph::weight_t{1}, std::size(points)),
+            parts,
+            num_parts,
+            init_part);
+  }
+
+  /// Partition the points using the grid graph partitioning algorithm, so
+  /// that the parts have roughly equal total weights. Weights are rounded to
+  /// the nearest positive integers.
+  template<point_range Points, weight_range Weights, output_index_range Parts>
+  void operator()(Points&& points,
+                  Weights&& weights,
+                  Parts&& parts,
+                  size_t num_parts,
+                  size_t init_part = 0) const {
     TIT_PROFILE_SECTION("GridGraphPartition::operator()");
     TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Weights, weights);
     TIT_ASSUME_UNIVERSAL(Parts, parts);
     static constexpr auto Dim = point_range_dim_v<Points>;
 
@@ -58,6 +83,8 @@ public:
     TIT_ASSERT(num_parts > 0, "Number of parts must be positive!");
     TIT_ASSERT(std::size(points) >= num_parts,
                "Number of points cannot be less than the number of parts!");
+    TIT_ASSERT(std::size(points) == std::size(weights),
+               "Size of weights range must be equal to the number of points!");
     if constexpr (std::ranges::sized_range<Parts>) {
       TIT_ASSERT(std::size(points) == std::size(parts),
                  "Size of parts range must be equal to the number of points!");
@@ -73,7 +100,8 @@ public:
     const auto grid = Grid{box}.set_cell_extents(size_hint_).extend(1);
 
     // Index the cells that contain the points. Thouse would be used as nodes
-    // in the graph. We'll use amount of points in each cell as the node weight.
+    // in the graph. We'll use total weight of points in each cell as the node
+    // weight.
     //
     // Since the typical SPH adjacency graph is heavily connected, we'll use
     // the product of the node weights as the edge weight, as if each particle
@@ -83,14 +111,55 @@ public:
       graph::weight_t weight = 0;
     };
     Mdvector<NodeAndWeight, Dim> cells{grid.num_cells().elems()};
-    par::for_each(points, [&grid, &cells](const auto& point) {
-      auto& weight = cells[grid.cell_index(point).elems()].weight;
-      par::fetch_and_add(weight, 1);
+    par::for_each(
+        std::views::zip(points, weights),
+        [&grid, &cells](const auto& point_and_weight) {
+          const auto& [point, point_weight] = point_and_weight;
+          const auto rounded_weight =
+              std::max(static_cast<graph::weight_t>(std::round(point_weight)),
+                       graph::weight_t{1});
+          auto& weight = cells[grid.cell_index(point).elems()].weight;
+          par::fetch_and_add(weight, rounded_weight);
+        });
+
+    // Gather the non-empty cells. Cells next to the boundary are always
+    // empty, so only the interior ones are visited. Positions of the
+    // non-empty cells are computed by the parallel scan of their flags.
+    const auto interior_cells = grid.cells(1);
+    const auto num_interior_cells = std::size(interior_cells);
+    std::vector<size_t> cell_flags(num_interior_cells);
+    par::transform(interior_cells,
+                   cell_flags.begin(),
+                   [&cells](const auto& cell_index) -> size_t {
+                     return cells[cell_index.elems()].weight > 0 ? 1 : 0;
+                   });
+    std::vector<size_t> cell_offsets(num_interior_cells);
+    par::exclusive_scan(cell_flags, cell_offsets.begin(), size_t{0});
+    const auto num_nodes = cell_offsets.back() + cell_flags.back();
+    using CellIndex = std::ranges::range_value_t<decltype(interior_cells)>;
+    std::vector<CellIndex> node_cells(num_nodes);
+    par::for_each(
+        std::views::iota(size_t{0}, num_interior_cells),
+        [&interior_cells, &cell_flags, &cell_offsets, &node_cells](size_t i) {
+          if (cell_flags[i] == 0) return;
+          node_cells[cell_offsets[i]] = interior_cells[i];
+        });
+
+    // Number the nodes along the Hilbert curve, so that the nodes with the
+    // close indices are close in space. Partitions that slice the index
+    // range, such as `graph::UniformPartition`, are then spatially compact,
+    // and the multilevel partitioners start from a better ordering.
+    using Vec = point_range_vec_t<Points>;
+    std::vector<Vec> node_centers(num_nodes);
+    par::transform(node_cells, node_centers.begin(), [](const auto& index) {
+      return vec_cast<vec_num_t<Vec>>(index);
     });
-    size_t num_nodes = 0;
-    for (auto& [node, weight] : cells) {
-      if (weight > 0) node = num_nodes++;
-    }
+    std::vector<size_t> node_perm(num_nodes);
+    hilbert_key_sort(node_centers, node_perm);
+    par::for_each(std::views::iota(size_t{0}, num_nodes),
+                  [&cells, &node_cells, &node_perm](size_t node) {
+                    cells[node_cells[node_perm[node]].elems()].node = node;
+                  });
 
     // Build the graph connecting the cells.
     /// @todo I wish this code to be cleaner. Once we have a proper graph
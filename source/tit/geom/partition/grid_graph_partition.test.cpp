@@ -4,11 +4,13 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <array>
+#include <optional>
 #include <ranges>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/vec.hpp"
 
+#include "tit/geom/bbox.hpp"
 #include "tit/geom/partition/grid_graph_partition.hpp"
 
 #include "tit/graph/simple_partition.hpp"
@@ -23,35 +25,40 @@ using Vec2D = Vec<double, 2>;
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("geom::GridGraphPartition") {
-  // Create points on a 8x16 lattice.
-  std::array<Vec2D, 128> points{};
-  for (size_t i = 0; i < 128; ++i) points[i] = {i % 16, i / 16};
+  // Create points on a 16x16 lattice.
+  std::array<Vec2D, 256> points{};
+  for (size_t i = 0; i < 256; ++i) points[i] = {i % 16, i / 16};
 
-  // Partition the points using the coordinate bisection algorithm.
+  // Partition the points using the grid graph partitioning algorithm.
   // Since here we are testing the geometrical partitioning, we'll use the
-  // simplest possible graph partitioning algorithm.
-  std::array<size_t, 128> parts{};
+  // simplest possible graph partitioning algorithm, that slices the nodes.
+  std::array<size_t, 256> parts{};
   const geom::GridGraphPartition grid_graph_partition{
       /*size_hint=*/2.0,
       graph::UniformPartition{}};
-  grid_graph_partition(points, parts, 8);
-
-  // Ensure the resulting partitioning is correct.
-  //
-  // 0 --------------------------------->
-  // | 0 0 1 1 2 2 3 3 4 4 5 5 6 6 7 7    X
-  // | 0 0 1 1 2 2 3 3 4 4 5 5 6 6 7 7
-  // | 0 0 1 1 2 2 3 3 4 4 5 5 6 6 7 7
-  // | 0 0 1 1 2 2 3 3 4 4 5 5 6 6 7 7
-  // | 0 0 1 1 2 2 3 3 4 4 5 5 6 6 7 7
-  // | 0 0 1 1 2 2 3 3 4 4 5 5 6 6 7 7
-  // | 0 0 1 1 2 2 3 3 4 4 5 5 6 6 7 7
-  // | 0 0 1 1 2 2 3 3 4 4 5 5 6 6 7 7
-  // |
-  // v
-  //   Y
+  grid_graph_partition(points, parts, 16);
+
+  // Ensure the resulting partitioning is correct. Grid cells contain 2x2
+  // points, and they are numbered along the Hilbert curve, so each slice of
+  // four cells is a 4x4 block of points.
+  std::array<size_t, 16> part_sizes{};
+  std::array<std::optional<geom::BBox<Vec2D>>, 16> part_boxes{};
   for (const auto& [part, point] : std::views::zip(parts, points)) {
-    CHECK(part == static_cast<size_t>(point[0]) / 2);
+    REQUIRE(part < 16);
+    part_sizes[part] += 1;
+    auto& box = part_boxes[part];
+    if (box.has_value()) {
+      box->expand(point);
+    } else {
+      box.emplace(point);
+    }
+  }
+  for (size_t part = 0; part < 16; ++part) {
+    CHECK(part_sizes[part] == 16);
+    REQUIRE(part_boxes[part].has_value());
+    CHECK(part_boxes[part]->extents() == Vec2D{3.0, 3.0});
+    CHECK(static_cast<size_t>(part_boxes[part]->low()[0]) % 4 == 0);
+    CHECK(static_cast<size_t>(part_boxes[part]->low()[1]) % 4 == 0);
   }
 }
 
@@ -47,7 +47,82 @@ public:
     TIT_PROFILE_SECTION("RecursiveBisection::operator()");
     TIT_ASSUME_UNIVERSAL(Points, points);
     TIT_ASSUME_UNIVERSAL(Parts, parts);
+    partition_(
+        points,
+        parts,
+        num_parts,
+        init_part,
+        [&points, this](std::span<size_t> perm,
+                        size_t left_num_parts,
+                        size_t my_num_parts) {
+          // Split the points into the roughly equal halves.
+          const auto median_index = left_num_parts * perm.size() / my_num_parts;
+          const auto median = perm.begin() + static_cast<ssize_t>(median_index);
+          return bisection_(points, perm, median);
+        });
+  }
+
+  /// Partition the points recursively using the bisector function, so that
+  /// the parts have roughly equal total weights.
+  template<point_range Points, weight_range Weights, output_index_range Parts>
+  void operator()(Points&& points,
+                  Weights&& weights,
+                  Parts&& parts,
+                  size_t num_parts,
+                  size_t init_part = 0) const {
+    TIT_PROFILE_SECTION("RecursiveBisection::operator()");
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Weights, weights);
+    TIT_ASSUME_UNIVERSAL(Parts, parts);
+    TIT_ASSERT(std::size(points) == std::size(weights),
+               "Size of weights range must be equal to the number of points!");
+    using Weight = weight_range_val_t<Weights>;
+    partition_(
+        points,
+        parts,
+        num_parts,
+        init_part,
+        [&points, &weights, this](std::span<size_t> perm,
+                                  size_t left_num_parts,
+                                  size_t my_num_parts) {
+          // Split the points into the halves of the roughly equal weight.
+          const auto total_weight = std::ranges::fold_left(
+              permuted_view(weights, perm),
+              Weight{},
+              std::plus{});
+          const auto left_weight = total_weight *
+                                   static_cast<Weight>(left_num_parts) /
+                                   static_cast<Weight>(my_num_parts);
+          auto halves = bisection_(points, perm, weights, left_weight);
+
+          // Each half must contain at least as many points as parts. This
+          // could be violated only by the extremely skewed weights, so we
+          // fall back to the split closest to the weighted one.
+          const auto right_num_parts = my_num_parts - left_num_parts;
+          const auto left_size = std::size(halves.first);
+          if (left_size < left_num_parts ||
+              perm.size() - left_size < right_num_parts) {
+            const auto median_index = std::clamp(left_size,
+                                                 left_num_parts,
+                                                 perm.size() - right_num_parts);
+            const auto median =
+                perm.begin() + static_cast<ssize_t>(median_index);
+            halves = bisection_(points, perm, median);
+          }
+          return halves;
+        });
+  }
 
+private:
+
+  // Partition the points recursively, using the given function to split the
+  // permutation into the halves.
+  template<class Points, class Parts, class Split>
+  static void partition_(Points& points,
+                         Parts& parts,
+                         size_t num_parts,
+                         size_t init_part,
+                         const Split& split) {
     // Validate the arguments.
     TIT_ASSERT(num_parts > 0, "Number of parts must be positive!");
     if constexpr (std::ranges::sized_range<Parts>) {
@@ -60,11 +135,10 @@ public:
 
     // Partition the points.
     par::TaskGroup tasks{};
-    const auto impl = [&points, &parts, &tasks, &bisection = this->bisection_](
-                          this const auto& self,
-                          size_t my_num_parts,
-                          size_t my_part,
-                          std::span<size_t> my_perm) {
+    const auto impl = [&parts, &tasks, &split](this const auto& self,
+                                               size_t my_num_parts,
+                                               size_t my_part,
+                                               std::span<size_t> my_perm) {
       TIT_ASSERT(my_perm.size() >= my_num_parts,
                  "Number of points cannot be less than the number of parts!");
       if (my_num_parts == 1) {
@@ -73,14 +147,13 @@ public:
         return;
       }
 
-      // Split the points into the roughly equal halves.
+      // Split the points into the halves.
       const auto left_num_parts = my_num_parts / 2;
       const auto right_num_parts = my_num_parts - left_num_parts;
       const auto left_part = my_part;
       const auto right_part = my_part + left_num_parts;
-      const auto median_index = left_num_parts * my_perm.size() / my_num_parts;
-      const auto median = my_perm.begin() + static_cast<ssize_t>(median_index);
-      const auto [left_perm, right_perm] = bisection(points, my_perm, median);
+      const auto [left_perm, right_perm] =
+          split(my_perm, left_num_parts, my_num_parts);
 
       // Recursively partition the halves.
       tasks.run(std::bind_front(self, left_num_parts, left_part, left_perm));
@@ -90,8 +163,6 @@ public:
     tasks.wait();
   }
 
-private:
-
   [[no_unique_address]] Bisection bisection_;
 
 }; // class RecursiveBisection
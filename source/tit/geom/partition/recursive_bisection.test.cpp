@@ -49,6 +49,27 @@ TEST_CASE("geom::CoordBisection") {
   }
 }
 
+TEST_CASE("geom::CoordBisection (weighted)") {
+  // Create points on a 4x16 lattice. Points in the first four columns are
+  // three times heavier than the rest.
+  std::array<Vec2D, 64> points{};
+  std::array<size_t, 64> weights{};
+  for (size_t i = 0; i < 64; ++i) {
+    points[i] = {i % 16, i / 16};
+    weights[i] = i % 16 < 4 ? 3 : 1;
+  }
+
+  // Partition the points using the weighted coordinate bisection algorithm.
+  std::array<size_t, 64> parts{};
+  geom::recursive_coord_bisection(points, weights, parts, 2);
+
+  // Ensure the heavy columns form a separate part, since their weight is
+  // exactly a half of the total weight.
+  for (const auto& [part, point] : std::views::zip(parts, points)) {
+    CHECK(part == (point[0] < 4.0 ? 0 : 1));
+  }
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 TEST_CASE("geom::InertialBisection") {
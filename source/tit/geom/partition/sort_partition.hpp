@@ -6,6 +6,7 @@
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <ranges>
 #include <vector>
 
@@ -68,6 +69,59 @@ public:
     }
   }
 
+  /// Partition the points using the spatial sort algorithm, so that the parts
+  /// have roughly equal total weights.
+  template<point_range Points, weight_range Weights, output_index_range Parts>
+  void operator()(Points&& points,
+                  Weights&& weights,
+                  Parts&& parts,
+                  size_t num_parts,
+                  size_t init_part = 0) const {
+    TIT_PROFILE_SECTION("SortPartition::operator()");
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Weights, weights);
+    TIT_ASSUME_UNIVERSAL(Parts, parts);
+
+    // Validate the arguments.
+    TIT_ASSERT(num_parts > 0, "Number of parts must be positive!");
+    TIT_ASSERT(std::size(points) >= num_parts,
+               "Number of points cannot be less than the number of parts!");
+    TIT_ASSERT(std::size(points) == std::size(weights),
+               "Size of weights range must be equal to the number of points!");
+    if constexpr (std::ranges::sized_range<Parts>) {
+      TIT_ASSERT(std::size(points) == std::size(parts),
+                 "Size of parts range must be equal to the number of points!");
+    }
+
+    // Build the permutation using the spatial sort.
+    const auto num_points = std::size(points);
+    std::vector<size_t> perm(num_points);
+    sort_(points, perm);
+
+    // Assign the partitions by the cumulative weight along the sorted points.
+    // Point goes to the part that contains the middle of its weight interval,
+    // but each part receives at least one point.
+    const auto total_weight = static_cast<real_t>(std::ranges::fold_left(
+        weights, weight_range_val_t<Weights>{}, std::plus{}));
+    TIT_ASSERT(total_weight > 0.0, "Total weight must be positive!");
+    const auto weight_per_part = total_weight / static_cast<real_t>(num_parts);
+    real_t cumulative_weight = 0.0;
+    size_t part = 0;
+    for (size_t i = 0; i < num_points; ++i) {
+      const auto weight = static_cast<real_t>(weights[perm[i]]);
+      const auto target_part =
+          static_cast<size_t>((cumulative_weight + weight / 2) /
+                              weight_per_part);
+      const auto num_parts_left = num_parts - 1 - part;
+      if (i > 0 && num_parts_left > 0 &&
+          (target_part > part || num_points - i == num_parts_left)) {
+        ++part;
+      }
+      parts[perm[i]] = init_part + part;
+      cumulative_weight += weight;
+    }
+  }
+
 private:
 
   [[no_unique_address]] Sort sort_;
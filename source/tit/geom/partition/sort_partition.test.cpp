@@ -4,6 +4,7 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <array>
+#include <ranges>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/vec.hpp"
@@ -64,6 +65,29 @@ TEST_CASE("geom::MortonCurvePartition") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("geom::MortonCurvePartition (weighted)") {
+  // Create points on a 8x8 lattice. Points in the first quadrant are three
+  // times heavier than the rest.
+  std::array<Vec2D, 64> points{};
+  std::array<size_t, 64> weights{};
+  for (size_t i = 0; i < 64; ++i) {
+    points[i] = {i % 8, i / 8};
+    weights[i] = (i % 8 < 4 && i / 8 < 4) ? 3 : 1;
+  }
+
+  // Partition the points using the weighted Morton curve algorithm.
+  std::array<size_t, 64> parts{};
+  geom::morton_curve_partition(points, weights, parts, 2);
+
+  // Ensure the first quadrant forms a separate part, since it goes first
+  // along the curve, and its weight is exactly a half of the total weight.
+  for (const auto& [part, point] : std::views::zip(parts, points)) {
+    CHECK(part == ((point[0] < 4.0 && point[1] < 4.0) ? 0 : 1));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("geom::HilbertCurvePartition") {
   // Create points on a 8x8 lattice.
   std::array<Vec2D, 64> points{};
@@ -0,0 +1,101 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <array>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+
+namespace tit::geom {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Box with the periodic boundaries along some of the axes.
+///
+/// Along the periodic axes, the points are wrapped into the box, and the
+/// differences between the points are taken for their closest images. Other
+/// axes are not affected, so the default-constructed box, that has no
+/// periodic axes, leaves all the points and differences as they are.
+template<class Vec>
+class PeriodicBox final {
+public:
+
+  /// Number of the spatial dimensions.
+  static constexpr size_t Dim = vec_dim_v<Vec>;
+
+  /// Construct a box without any periodic axes.
+  constexpr PeriodicBox() = default;
+
+  /// Construct a box, that is periodic along the specified @p axes.
+  constexpr PeriodicBox(const BBox<Vec>& box,
+                        const std::array<bool, Dim>& axes)
+      : low_{box.low()} {
+    const auto extents = box.extents();
+    for (size_t i = 0; i < Dim; ++i) {
+      if (!axes[i]) continue;
+      TIT_ASSERT(extents[i] > 0, "Periodic box must have positive extents!");
+      period_[i] = extents[i];
+      inv_period_[i] = vec_num_t<Vec>{1} / extents[i];
+      periodic_ = true;
+    }
+  }
+
+  /// Is the box periodic along any of the axes?
+  constexpr auto is_periodic() const noexcept -> bool {
+    return periodic_;
+  }
+
+  /// Is the box periodic along the axis?
+  constexpr auto is_periodic(size_t axis) const noexcept -> bool {
+    TIT_ASSERT(axis < Dim, "Axis index is out of range!");
+    return period_[axis] != 0;
+  }
+
+  /// Low point of the box.
+  constexpr auto low() const noexcept -> const Vec& {
+    return low_;
+  }
+
+  /// Periods along the axes, zero for the non-periodic ones.
+  constexpr auto period() const noexcept -> const Vec& {
+    return period_;
+  }
+
+  /// Wrap the point into the box along the periodic axes.
+  constexpr auto wrap(const Vec& point) const -> Vec {
+    if (!periodic_) return point;
+    return point - period_ * floor((point - low_) * inv_period_);
+  }
+
+  /// Difference between the points, taken for their closest images along
+  /// the periodic axes.
+  constexpr auto delta(const Vec& a, const Vec& b) const -> Vec {
+    return min_image(a - b);
+  }
+
+  /// Closest image of the difference between the points along the periodic
+  /// axes.
+  constexpr auto min_image(const Vec& delta) const -> Vec {
+    if (!periodic_) return delta;
+    return delta - period_ * round(delta * inv_period_);
+  }
+
+private:
+
+  Vec low_{};
+  Vec period_{};
+  Vec inv_period_{};
+  bool periodic_ = false;
+
+}; // class PeriodicBox
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::geom
@@ -14,6 +14,8 @@
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/mat.hpp"
+#include "tit/core/missing.hpp" // IWYU pragma: keep
+#include "tit/core/par/algorithms.hpp"
 #include "tit/core/range_utils.hpp"
 #include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
@@ -50,6 +52,18 @@ using point_range_bbox_t = BBox<point_range_vec_t<Points>>;
 template<point_range Points>
 inline constexpr auto point_range_dim_v = vec_dim_v<point_range_vec_t<Points>>;
 
+/// Range of the point weights, such as the computational cost of each point.
+template<class Weights>
+concept weight_range =
+    std::ranges::sized_range<Weights> &&
+    std::ranges::random_access_range<Weights> &&
+    (std::integral<std::ranges::range_value_t<Weights>> ||
+     std::floating_point<std::ranges::range_value_t<Weights>>);
+
+/// Weight range value type.
+template<weight_range Weights>
+using weight_range_val_t = std::ranges::range_value_t<Weights>;
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Count the number of points in the given range as a point range number type.
@@ -82,15 +96,69 @@ constexpr auto compute_center(Points&& points, Perm&& perm)
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace impl {
+
+/// Point ranges larger than this size are processed in parallel.
+inline constexpr size_t ParallelBBoxThreshold = 16384;
+
+/// Number of points in a block of the parallel bounding box computation.
+inline constexpr size_t BBoxBlockSize = 4096;
+
+/// Merge the bounding boxes.
+template<class Box>
+constexpr auto merge_bbox(Box box, const Box& other_box) -> Box {
+  return box.expand(other_box.low()).expand(other_box.high());
+}
+
+/// Compute the bounding box of the given non-empty point range serially.
+///
+/// Consecutive points are distributed between four independent boxes, so
+/// that each SIMD minimum and maximum does not wait for the result of the
+/// previous one, and they are pipelined.
+template<point_range Points>
+constexpr auto serial_bbox(Points&& points) -> point_range_bbox_t<Points> {
+  TIT_ASSUME_UNIVERSAL(Points, points);
+  TIT_ASSERT(!std::ranges::empty(points), "Points must not be empty!");
+  auto iter = std::begin(points);
+  const auto last = std::end(points);
+  point_range_bbox_t<Points> box_0{*iter};
+  auto box_1 = box_0;
+  auto box_2 = box_0;
+  auto box_3 = box_0;
+  for (++iter; last - iter >= 4; iter += 4) {
+    box_0.expand(iter[0]);
+    box_1.expand(iter[1]);
+    box_2.expand(iter[2]);
+    box_3.expand(iter[3]);
+  }
+  for (; iter != last; ++iter) box_0.expand(*iter);
+  return merge_bbox(merge_bbox(box_0, box_1), merge_bbox(box_2, box_3));
+}
+
+} // namespace impl
+
 /// Compute the bounding box of the given non-empty point range.
+///
+/// Large point ranges are processed in parallel, by blocks.
 /// @{
 template<point_range Points>
 constexpr auto compute_bbox(Points&& points) -> point_range_bbox_t<Points> {
   TIT_ASSUME_UNIVERSAL(Points, points);
   TIT_ASSERT(!std::ranges::empty(points), "Points must not be empty!");
-  BBox box{*std::begin(points)};
-  for (const auto& point : points | std::views::drop(1)) box.expand(point);
-  return box;
+  if (std::size(points) < impl::ParallelBBoxThreshold) {
+    return impl::serial_bbox(points);
+  }
+
+  // Box of the first point is the identity of the merge, since it is
+  // contained in any other box.
+  using Box = point_range_bbox_t<Points>;
+  return par::fold(
+      points | std::views::chunk(impl::BBoxBlockSize),
+      Box{*std::begin(points)},
+      [](const Box& box, const auto& block) {
+        return impl::merge_bbox(box, impl::serial_bbox(block));
+      },
+      impl::merge_bbox<Box>);
 }
 template<point_range Points, index_range Perm>
 constexpr auto compute_bbox(Points&& points, Perm&& perm)
@@ -142,7 +210,7 @@ constexpr auto compute_largest_inertia_axis(Points&& points)
     -> std::expected<point_range_vec_t<Points>, MatEigError> {
   TIT_ASSUME_UNIVERSAL(Points, points);
   const auto inertia_tensor = compute_inertia_tensor(points);
-  return jacobi(inertia_tensor).transform([](const auto& eig) {
+  return sym_eig(inertia_tensor).transform([](const auto& eig) {
     const auto& [V, d] = eig;
     return V[max_value_index(d)];
   });
@@ -66,6 +66,30 @@ TEST_CASE("geom::compute_bbox") {
     CHECK(box.low() == expected_bbox.low());
     CHECK(box.high() == expected_bbox.high());
   }
+  SUBCASE("extremes anywhere") {
+    // Extremes are found regardless of the position within the range.
+    for (size_t size = 1; size < 12; ++size) {
+      for (size_t i = 0; i < size; ++i) {
+        std::vector<Vec2D> many_points(size, Vec2D{0, 0});
+        many_points[i] = Vec2D{-1, 2};
+        const auto box = geom::compute_bbox(many_points);
+        CHECK(box.low() == Vec2D{-1, 0});
+        CHECK(box.high() == Vec2D{0, 2});
+      }
+    }
+  }
+  SUBCASE("large") {
+    // Large ranges are processed in parallel, by blocks.
+    constexpr size_t size = 100'003;
+    std::vector<Vec2D> many_points(size);
+    for (size_t i = 0; i < size; ++i) {
+      const auto x = static_cast<double>(i);
+      many_points[i] = Vec2D{x, -x};
+    }
+    const auto box = geom::compute_bbox(many_points);
+    CHECK(box.low() == Vec2D{0, -(size - 1.0)});
+    CHECK(box.high() == Vec2D{size - 1.0, 0});
+  }
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
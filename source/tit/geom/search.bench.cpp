@@ -0,0 +1,104 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <iterator>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/range_utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/search.hpp"
+
+#include "tit/testing/benchmark.hpp"
+
+namespace tit {
+namespace {
+
+using Vec3D = Vec<double, 3>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Search radius for the points, so that each point has ~30 neighbors.
+auto search_radius(size_t count) -> double {
+  return 2.0 * testing::random_points_spacing<double, 3>(count);
+}
+
+// Build the search index.
+template<class MakeSearch>
+void bench_search_build(benchmark::State& state, MakeSearch make_search) {
+  const auto count = testing::setup_benchmark(state);
+  const auto points = testing::random_points<double, 3>(count);
+  const auto search = make_search(search_radius(count));
+  for (auto _ : state) {
+    const auto index = search(points);
+    benchmark::DoNotOptimize(&index);
+  }
+  testing::report_items(state, count);
+}
+
+// Find the neighbors of each point, one query at a time.
+template<class MakeSearch>
+void bench_search_query(benchmark::State& state, MakeSearch make_search) {
+  const auto count = testing::setup_benchmark(state);
+  const auto points = testing::random_points<double, 3>(count);
+  const auto radius = search_radius(count);
+  const auto index = make_search(radius)(points);
+  for (auto _ : state) {
+    par::for_each(iota_perm(points), [&points, &index, radius](size_t i) {
+      thread_local std::vector<size_t> result{};
+      result.clear();
+      index.search(points[i], radius, std::back_inserter(result));
+      benchmark::DoNotOptimize(result.data());
+    });
+  }
+  testing::report_items(state, count);
+}
+
+// Find the neighbors of all the points in batches.
+template<class MakeSearch>
+void bench_search_batch(benchmark::State& state, MakeSearch make_search) {
+  const auto count = testing::setup_benchmark(state);
+  const auto points = testing::random_points<double, 3>(count);
+  const auto radius = search_radius(count);
+  const std::vector<double> radii(count, radius);
+  const auto index = make_search(radius)(points);
+  Multivector<size_t> result;
+  for (auto _ : state) {
+    index.search_batch(points, radii, result);
+    benchmark::DoNotOptimize(result.vals().data());
+  }
+  testing::report_items(state, count);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+constexpr auto make_grid_search = [](double radius) {
+  return geom::GridSearch{radius};
+};
+
+constexpr auto make_kd_tree_search = [](double /*radius*/) {
+  return geom::KDTreeSearch{};
+};
+
+BENCHMARK_CAPTURE(bench_search_build, grid, make_grid_search)
+    ->Apply(testing::sweep_sizes_and_threads);
+BENCHMARK_CAPTURE(bench_search_build, kd_tree, make_kd_tree_search)
+    ->Apply(testing::sweep_sizes_and_threads);
+BENCHMARK_CAPTURE(bench_search_query, grid, make_grid_search)
+    ->Apply(testing::sweep_sizes_and_threads);
+BENCHMARK_CAPTURE(bench_search_query, kd_tree, make_kd_tree_search)
+    ->Apply(testing::sweep_sizes_and_threads);
+BENCHMARK_CAPTURE(bench_search_batch, grid, make_grid_search)
+    ->Apply(testing::sweep_sizes_and_threads);
+BENCHMARK_CAPTURE(bench_search_batch, kd_tree, make_kd_tree_search)
+    ->Apply(testing::sweep_sizes_and_threads);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
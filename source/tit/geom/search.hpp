@@ -9,6 +9,7 @@
 
 // IWYU pragma: begin_exports
 #include "tit/geom/search/grid_search.hpp"
+#include "tit/geom/search/hierarchical_grid_search.hpp"
 #include "tit/geom/search/kd_tree_search.hpp"
 // IWYU pragma: end_exports
 
@@ -18,7 +19,8 @@ namespace tit::geom {
 
 /// Spatial search indexing function type.
 template<class SF>
-concept search_func = std::same_as<SF, GridSearch> || //
+concept search_func = std::same_as<SF, GridSearch> ||
+                      std::same_as<SF, HierarchicalGridSearch> ||
                       std::same_as<SF, KDTreeSearch>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -3,6 +3,8 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
+#include <array>
 #include <iterator>
 #include <random>
 #include <ranges>
@@ -10,10 +12,15 @@
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/containers/multivector.hpp"
 #include "tit/core/math.hpp"
+#include "tit/core/range_utils.hpp"
 #include "tit/core/vec.hpp"
 
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/periodic_box.hpp"
 #include "tit/geom/search.hpp"
+#include "tit/geom/sort.hpp"
 
 #include "tit/testing/test.hpp"
 
@@ -78,6 +85,25 @@ auto search_grid(const std::vector<Vec3D>& points,
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+// Nearest neighbor search via a hierarchical grid.
+auto search_hierarchical_grid(const std::vector<Vec3D>& points,
+                              double search_radius,
+                              double size_hint,
+                              size_t num_levels) -> SearchResult {
+  // Construct the grid hierarchy.
+  const geom::HierarchicalGridSearch grid_search{size_hint, num_levels};
+  const auto grid_index = grid_search(points);
+
+  // Perform the nearest neighbor search.
+  SearchResult result(points.size());
+  for (const auto& [point, result_row] : std::views::zip(points, result)) {
+    grid_index.search(point, search_radius, std::back_inserter(result_row));
+  }
+  return result;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 // Nearest neighbor search via a K-dimensional tree.
 auto search_kd_tree(const std::vector<Vec3D>& points,
                     double search_radius,
@@ -96,6 +122,30 @@ auto search_kd_tree(const std::vector<Vec3D>& points,
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+// Batched nearest neighbor search with the queries in the given order.
+template<class SearchIndex>
+auto search_batch(const SearchIndex& search_index,
+                  const std::vector<Vec3D>& points,
+                  const std::vector<size_t>& perm,
+                  double search_radius) -> SearchResult {
+  // Perform the nearest neighbor search.
+  Multivector<size_t> batch_result;
+  search_index.search_batch(permuted_view(points, perm),
+                            std::views::repeat(search_radius, points.size()),
+                            batch_result);
+  REQUIRE(batch_result.size() == points.size());
+
+  // Unpermute the results.
+  SearchResult result(points.size());
+  for (const auto& [index, result_row] : std::views::zip(perm, batch_result)) {
+    CHECK(std::ranges::is_sorted(result_row));
+    result[index] = result_row | std::ranges::to<std::vector>();
+  }
+  return result;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 TEST_CASE("geom::Search") {
   // Generate random points in the unit cube.
   static const auto points = [] {
@@ -129,6 +179,22 @@ TEST_CASE("geom::Search") {
     }
   }
 
+  // Nearest neighbor search with a hierarchical grid.
+  SUBCASE("hierarchical grid") {
+    SUBCASE("single level") {
+      const auto result_grid =
+          search_hierarchical_grid(points, search_radius, search_radius, 1);
+      match_search_results(result_naive, result_grid);
+    }
+    SUBCASE("multiple levels") {
+      const auto result_grid = search_hierarchical_grid(points,
+                                                        search_radius,
+                                                        0.1 * search_radius,
+                                                        5);
+      match_search_results(result_naive, result_grid);
+    }
+  }
+
   // Nearest neighbor search with a K-dimensional tree.
   SUBCASE("KD tree") {
     SUBCASE("max leaf size = 1") {
@@ -139,6 +205,207 @@ TEST_CASE("geom::Search") {
       const auto result_kd_tree = search_kd_tree(points, search_radius, 10);
       match_search_results(result_naive, result_kd_tree);
     }
+    SUBCASE("max leaf size = 32") {
+      const auto result_kd_tree = search_kd_tree(points, search_radius, 32);
+      match_search_results(result_naive, result_kd_tree);
+    }
+  }
+}
+
+TEST_CASE("geom::GridIndex::update") {
+  // Generate random points in the unit cube.
+  std::mt19937 random_engine{/*seed=*/123};
+  std::uniform_real_distribution<double> dist{0.0, 1.0};
+  std::vector<Vec3D> points(1000);
+  for (auto& point : points) {
+    for (size_t i = 0; i < 3; ++i) point[i] = dist(random_engine);
+  }
+
+  // Build the index.
+  constexpr double search_radius = 0.1;
+  auto grid_index = geom::GridSearch{search_radius}(points);
+  const auto search_all = [&points, &grid_index] {
+    SearchResult result(points.size());
+    for (const auto& [point, result_row] : std::views::zip(points, result)) {
+      grid_index.search(point, search_radius, std::back_inserter(result_row));
+    }
+    return result;
+  };
+
+  // Move the points, so that some of them end up in the different cells, but
+  // all of them stay within the grid.
+  SUBCASE("small displacement") {
+    std::uniform_real_distribution<double> shift_dist{-0.01, 0.01};
+    for (auto& point : points) {
+      for (size_t i = 0; i < 3; ++i) {
+        point[i] = std::clamp(point[i] + shift_dist(random_engine), 0.0, 1.0);
+      }
+    }
+    grid_index.update(points);
+    match_search_results(search_naive(points, search_radius), search_all());
+  }
+
+  // Move the points outside of the grid, so that it must be rebuilt.
+  SUBCASE("large displacement") {
+    for (auto& point : points) point *= 2.0;
+    grid_index.update(points);
+    match_search_results(search_naive(points, search_radius), search_all());
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("geom::Search (batched)") {
+  // Generate random points in the unit cube.
+  static const auto points = [] {
+    std::mt19937 random_engine{/*seed=*/123};
+    std::uniform_real_distribution<double> dist{0.0, 1.0};
+    std::vector<Vec3D> points_(4000);
+    for (auto& point : points_) {
+      for (size_t i = 0; i < 3; ++i) point[i] = dist(random_engine);
+    }
+    return points_;
+  }();
+
+  // Nearest neighbor search using a naive approach.
+  constexpr double search_radius = 0.2;
+  static const auto result_naive = search_naive(points, search_radius);
+
+  // Queries are either spatially sorted, so that the batches are searched
+  // together, or in the original order, so that they are searched one by one.
+  static const auto perms = [] {
+    std::vector<size_t> sorted_perm(points.size());
+    geom::morton_curve_sort(points, sorted_perm);
+    return std::array{sorted_perm,
+                      iota_perm(points) | std::ranges::to<std::vector>()};
+  }();
+
+  // Nearest neighbor search with a grid.
+  SUBCASE("grid") {
+    const auto grid_index = geom::GridSearch{search_radius}(points);
+    for (const auto& perm : perms) {
+      const auto result_grid =
+          search_batch(grid_index, points, perm, search_radius);
+      match_search_results(result_naive, result_grid);
+    }
+  }
+
+  // Nearest neighbor search with a K-dimensional tree.
+  SUBCASE("KD tree") {
+    const auto kd_tree_index = geom::KDTreeSearch{}(points);
+    for (const auto& perm : perms) {
+      const auto result_kd_tree =
+          search_batch(kd_tree_index, points, perm, search_radius);
+      match_search_results(result_naive, result_kd_tree);
+    }
+  }
+}
+
+TEST_CASE("geom::HierarchicalGridSearch") {
+  // Generate random points in the unit cube with the random search radii,
+  // that vary by 10x.
+  std::mt19937 random_engine{/*seed=*/123};
+  std::uniform_real_distribution<double> dist{0.0, 1.0};
+  std::uniform_real_distribution<double> radius_dist{0.02, 0.2};
+  std::vector<Vec3D> points(1000);
+  std::vector<double> search_radii(points.size());
+  for (auto& point : points) {
+    for (size_t i = 0; i < 3; ++i) point[i] = dist(random_engine);
+  }
+  for (auto& search_radius : search_radii) {
+    search_radius = radius_dist(random_engine);
+  }
+
+  // Nearest neighbor search using a naive approach.
+  SearchResult result_naive(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    for (size_t j = 0; j < points.size(); ++j) {
+      if (norm2(points[i] - points[j]) < pow2(search_radii[i])) {
+        result_naive[i].push_back(j);
+      }
+    }
+  }
+
+  // Search with the hierarchical grid.
+  const geom::HierarchicalGridSearch grid_search{0.02};
+  const auto grid_index = grid_search(points);
+  REQUIRE(grid_index.num_levels() == 5);
+  CHECK(grid_index.level_of(0.01) == 0);
+  CHECK(grid_index.level_of(0.05) == 1);
+  CHECK(grid_index.level_of(0.2) == 3);
+  CHECK(grid_index.level_of(1.0) == 4);
+  Multivector<size_t> result_grid;
+  grid_index.search_batch(points, search_radii, result_grid);
+  match_search_results(
+      result_naive,
+      result_grid.buckets() |
+          std::views::transform([](auto bucket) {
+            return bucket | std::ranges::to<std::vector>();
+          }) |
+          std::ranges::to<std::vector>());
+
+  // Search with the 32-bit result indices.
+  Multivector<uint32_t> result_compact;
+  grid_index.search_batch(points, search_radii, result_compact);
+  match_search_results(
+      result_naive,
+      result_compact.buckets() |
+          std::views::transform([](auto bucket) {
+            return bucket | std::ranges::to<std::vector<size_t>>();
+          }) |
+          std::ranges::to<std::vector>());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("geom::GridSearch (periodic)") {
+  // Generate random points in the unit cube, that is periodic along the first
+  // two axes.
+  std::mt19937 random_engine{/*seed=*/123};
+  std::uniform_real_distribution<double> dist{0.0, 1.0};
+  std::vector<Vec3D> points(1000);
+  for (auto& point : points) {
+    for (size_t i = 0; i < 3; ++i) point[i] = dist(random_engine);
+  }
+  const geom::PeriodicBox<Vec3D> periodic_box{
+      geom::BBox{Vec3D(0.0), Vec3D(1.0)},
+      {true, true, false}};
+
+  // Nearest neighbor search using a naive approach.
+  constexpr double search_radius = 0.1;
+  SearchResult result_naive(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    for (size_t j = 0; j < points.size(); ++j) {
+      if (norm2(periodic_box.delta(points[i], points[j])) <
+          pow2(search_radius)) {
+        result_naive[i].push_back(j);
+      }
+    }
+  }
+
+  // Search with the grid, the points that are outside of the box must be
+  // wrapped into it.
+  SUBCASE("wrapped") {
+    const auto grid_index =
+        geom::GridSearch{search_radius}(points, periodic_box);
+    SearchResult result_grid(points.size());
+    for (const auto& [point, result_row] :
+         std::views::zip(points, result_grid)) {
+      grid_index.search(point, search_radius, std::back_inserter(result_row));
+    }
+    match_search_results(result_naive, result_grid);
+  }
+  SUBCASE("shifted") {
+    auto shifted_points = points;
+    for (auto& point : shifted_points) point += Vec3D{2.0, -3.0, 0.0};
+    const auto grid_index =
+        geom::GridSearch{search_radius}(shifted_points, periodic_box);
+    SearchResult result_grid(points.size());
+    for (const auto& [point, result_row] :
+         std::views::zip(shifted_points, result_grid)) {
+      grid_index.search(point, search_radius, std::back_inserter(result_row));
+    }
+    match_search_results(result_naive, result_grid);
   }
 }
 
@@ -7,28 +7,42 @@
 
 #include <algorithm>
 #include <concepts>
+#include <functional>
 #include <iterator>
 #include <ranges>
+#include <span>
 #include <utility>
+#include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/containers/multivector.hpp"
 #include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/scratch_arena.hpp"
 #include "tit/core/profiler.hpp"
+#include "tit/core/range_utils.hpp"
 #include "tit/core/type_utils.hpp"
 #include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
 
 #include "tit/geom/bbox.hpp"
 #include "tit/geom/grid.hpp"
+#include "tit/geom/periodic_box.hpp"
 #include "tit/geom/point_range.hpp"
+#include "tit/geom/search/search_batch.hpp"
 
 namespace tit::geom {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Uniform multidimensional grid spatial search index.
+///
+/// Along the periodic axes of the periodic box, if any, the points are
+/// wrapped into the box, and the neighbors are also searched for the images
+/// of the search points, so that the neighbors across the periodic
+/// boundaries are found. Search radii must be less than a half of the
+/// periods.
 template<point_range Points>
   requires std::ranges::view<Points>
 class GridIndex final {
@@ -42,22 +56,56 @@ public:
   /// Index the points for search using a grid.
   ///
   /// @param size_hint Cell size hint, typically 2x of the particle spacing.
-  GridIndex(Points points, vec_num_t<Vec> size_hint)
-      : points_{std::move(points)} {
-    TIT_ASSERT(size_hint > 0.0, "Cell size hint must be positive!");
+  /// @param periodic_box Periodic box of the points.
+  GridIndex(Points points,
+            vec_num_t<Vec> size_hint,
+            PeriodicBox<Vec> periodic_box = {})
+      : points_{std::move(points)}, size_hint_{size_hint},
+        periodic_box_{std::move(periodic_box)} {
+    TIT_ASSERT(size_hint_ > 0.0, "Cell size hint must be positive!");
+    build_();
+  }
 
-    // Compute bounding box and initialize the grid.
-    const auto box = compute_bbox(points_).grow(size_hint / 2);
-    // NOLINTNEXTLINE(*-prefer-member-initializer)
-    grid_ = Grid{box}.set_cell_extents(size_hint);
+  /// Update the index after the points have moved.
+  ///
+  /// The grid is kept as long as all the points stay within it, and the
+  /// points are only repacked into the cells if any of them has moved into a
+  /// different cell. Otherwise, only the stored coordinates are refreshed.
+  /// In either case, the allocations of the index are reused.
+  void update(Points points) {
+    TIT_PROFILE_SECTION("GridIndex::update()");
+    points_ = std::move(points);
 
-    // Pack the points into a multivector.
-    cell_points_.assign_pairs_par_tall(
-        grid_.flat_num_cells(),
-        iota_perm(points_) | std::views::transform([this](size_t point) {
-          const auto cell = grid_.flat_cell_index(points_[point]);
-          return std::pair{cell, point};
-        }));
+    // Rebuild the index from scratch if the points no longer fit the grid.
+    const auto& box = grid_.box();
+    const auto fits_grid =
+        std::size(points_) == point_cells_.size() &&
+        par::fold(
+            iota_perm(points_),
+            true,
+            [&box, this](bool fits, size_t point) {
+              const auto p = point_(point);
+              return fits && all(box.low() <= p) && all(p < box.high());
+            },
+            std::logical_and{});
+    if (!fits_grid) {
+      build_();
+      return;
+    }
+
+    // Update the cells of the points, and repack them only if needed.
+    const auto num_moved = par::fold(
+        iota_perm(points_),
+        size_t{0},
+        [this](size_t count, size_t point) {
+          const auto cell = grid_.flat_cell_index(point_(point));
+          if (point_cells_[point] == cell) return count;
+          point_cells_[point] = cell;
+          return count + 1;
+        },
+        std::plus{});
+    if (num_moved != 0) pack_points_();
+    store_coords_();
   }
 
   /// Find the points within the radius to the given point.
@@ -68,7 +116,139 @@ public:
               OutIter out,
               Pred pred = {}) const -> OutIter {
     TIT_ASSERT(search_radius > 0.0, "Search radius should be positive.");
+    if (!periodic_box_.is_periodic()) {
+      return search_image_(search_point, search_radius, out, pred);
+    }
 
+    // Search around each of the images of the search point, that is close
+    // enough to the grid. Shifts along the axis are encoded in the base-3
+    // digits of the image index: no shift, shift forward and backward.
+    const auto point = periodic_box_.wrap(search_point);
+    const auto& period = periodic_box_.period();
+    TIT_ASSERT(std::ranges::all_of(std::views::iota(size_t{0}, Dim_),
+                                   [search_radius, &period](size_t i) {
+                                     return period[i] == 0 ||
+                                            2 * search_radius < period[i];
+                                   }),
+               "Search radius must be less than a half of the period!");
+    const auto& box = grid_.box();
+    for (size_t image = 0; image < ipow(3UZ, Dim_); ++image) {
+      auto image_point = point;
+      bool is_close = true;
+      for (size_t i = 0, digits = image; i < Dim_; ++i, digits /= 3) {
+        const auto shift = digits % 3;
+        if (shift == 0) continue;
+        if (!periodic_box_.is_periodic(i)) {
+          is_close = false;
+          break;
+        }
+        image_point[i] += shift == 1 ? period[i] : -period[i];
+        is_close = image_point[i] - search_radius < box.high()[i] &&
+                   box.low()[i] < image_point[i] + search_radius;
+        if (!is_close) break;
+      }
+      if (is_close) out = search_image_(image_point, search_radius, out, pred);
+    }
+    return out;
+  }
+
+  /// Find the points within the radii to each of the given points, and store
+  /// the sorted results into the multivector.
+  ///
+  /// Consecutive query points are searched in batches: if the batch points
+  /// are close to each other, the cells around them are scanned only once,
+  /// and the predicate is evaluated only once per candidate point. Spatially
+  /// sorted queries are therefore searched the fastest.
+  ///
+  /// Intermediate results are allocated from the @p scratch arenas, if any.
+  template<impl::query_range<Vec> Queries,
+           impl::radius_range<Vec> Radii,
+           std::unsigned_integral Index,
+           std::predicate<size_t> Pred = AlwaysTrue>
+  void search_batch(Queries&& search_points,
+                    Radii&& search_radii,
+                    Multivector<Index>& out,
+                    Pred pred = {},
+                    par::ScratchArenas* scratch = nullptr) const {
+    TIT_ASSUME_UNIVERSAL(Queries, search_points);
+    TIT_ASSUME_UNIVERSAL(Radii, search_radii);
+    TIT_ASSERT(std::size(search_points) == std::size(search_radii),
+               "Number of the search points and radii must match!");
+    impl::search_batches(
+        std::size(search_points),
+        out,
+        [&search_points, &search_radii, &pred, this](
+            size_t first,
+            size_t last,
+            par::ScratchVector<size_t>& results,
+            std::span<size_t> result_ends) {
+          // Search the queries one by one if they are too far apart.
+          const auto batch_box =
+              impl::batch_search_box<Vec>(search_points,
+                                          search_radii,
+                                          first,
+                                          last);
+          if (!batch_box.has_value() || crosses_period_(*batch_box)) {
+            for (size_t q = first; q < last; ++q) {
+              search(search_points[q],
+                     static_cast<vec_num_t<Vec>>(search_radii[q]),
+                     std::back_inserter(results),
+                     pred);
+              result_ends[q - first] = results.size();
+            }
+            return;
+          }
+
+          // Collect the candidate points within the batch search box.
+          thread_local std::vector<size_t> candidate_points{};
+          thread_local std::vector<Vec> candidate_coords{};
+          candidate_points.clear(), candidate_coords.clear();
+          for (const auto& cell_index : grid_.cells_intersecting(*batch_box)) {
+            const auto flat_cell_index = grid_.flatten_cell_index(cell_index);
+            const auto cell_points = cell_points_[flat_cell_index];
+            const auto cell_coords = cell_coords_of_(cell_points);
+            for (size_t i = 0; i < cell_points.size(); ++i) {
+              if (!pred(cell_points[i])) continue;
+              candidate_points.push_back(cell_points[i]);
+              candidate_coords.push_back(cell_coords[i]);
+            }
+          }
+
+          // Test the candidates against each of the batch queries.
+          for (size_t q = first; q < last; ++q) {
+            const Vec& search_point = search_points[q];
+            const auto search_dist =
+                pow2(static_cast<vec_num_t<Vec>>(search_radii[q]));
+            for (size_t i = 0; i < candidate_points.size(); ++i) {
+              if (norm2(candidate_coords[i] - search_point) >= search_dist) {
+                continue;
+              }
+              results.push_back(candidate_points[i]);
+            }
+            result_ends[q - first] = results.size();
+          }
+        },
+        scratch);
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+private:
+
+  static constexpr auto Dim_ = vec_dim_v<Vec>;
+
+  // Point, wrapped into the periodic box.
+  auto point_(size_t point) const -> Vec {
+    return periodic_box_.wrap(points_[point]);
+  }
+
+  // Find the points within the radius to the given image of the search
+  // point.
+  template<class OutIter, class Pred>
+  auto search_image_(const Vec& search_point,
+                     vec_num_t<Vec> search_radius,
+                     OutIter out,
+                     Pred& pred) const -> OutIter {
     // Calculate the search box.
     const auto search_box = BBox{search_point}.grow(search_radius);
 
@@ -76,24 +256,84 @@ public:
     const auto search_dist = pow2(search_radius);
     for (const auto& cell_index : grid_.cells_intersecting(search_box)) {
       const auto flat_cell_index = grid_.flatten_cell_index(cell_index);
-      out = copy_points_near(points_,
-                             cell_points_[flat_cell_index],
-                             out,
-                             search_point,
-                             search_dist,
-                             pred);
+      const auto cell_points = cell_points_[flat_cell_index];
+      const auto cell_coords = cell_coords_of_(cell_points);
+      for (size_t i = 0; i < cell_points.size(); ++i) {
+        if (norm2(cell_coords[i] - search_point) >= search_dist) continue;
+        if (const auto point = cell_points[i]; pred(point)) *out++ = point;
+      }
     }
 
     return out;
   }
 
-  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  // Does the box cross the periodic boundaries? Such batches are searched
+  // query by query, since their neighbors may be found through the images.
+  auto crosses_period_(const BBox<Vec>& box) const -> bool {
+    if (!periodic_box_.is_periodic()) return false;
+    const auto& low = periodic_box_.low();
+    const auto high = low + periodic_box_.period();
+    for (size_t i = 0; i < Dim_; ++i) {
+      if (!periodic_box_.is_periodic(i)) continue;
+      if (box.low()[i] < low[i] || high[i] < box.high()[i]) return true;
+    }
+    return false;
+  }
 
-private:
+  // Build the index from scratch.
+  void build_() {
+    // Compute bounding box and initialize the grid.
+    const auto box =
+        compute_bbox(iota_perm(points_) |
+                     std::views::transform(
+                         [this](size_t point) { return point_(point); }))
+            .grow(size_hint_ / 2);
+    grid_ = Grid{box}.set_cell_extents(size_hint_);
+
+    // Compute the cells of the points and pack the points into them.
+    point_cells_.resize(std::size(points_));
+    grid_.flat_cell_indices(iota_perm(points_) |
+                                std::views::transform([this](size_t point) {
+                                  return point_(point);
+                                }),
+                            point_cells_.begin());
+    pack_points_();
+    store_coords_();
+  }
+
+  // Pack the points into a multivector.
+  void pack_points_() {
+    cell_points_.assign_pairs_par_tall(
+        grid_.flat_num_cells(),
+        iota_perm(points_) | std::views::transform([this](size_t point) {
+          return std::pair{point_cells_[point], point};
+        }));
+  }
+
+  // Store the point coordinates in the cell order, so that the search reads
+  // them contiguously, without indirection through the point indices.
+  void store_coords_() {
+    cell_coords_.resize(cell_points_.vals().size());
+    par::transform(cell_points_.vals(),
+                   cell_coords_.begin(),
+                   [this](size_t point) { return point_(point); });
+  }
+
+  // Coordinates of the points of the cell.
+  auto cell_coords_of_(std::span<const size_t> cell_points) const noexcept
+      -> std::span<const Vec> {
+    const auto offset = cell_points.data() - cell_points_.vals().data();
+    return std::span{cell_coords_}.subspan(static_cast<size_t>(offset),
+                                           cell_points.size());
+  }
 
   Points points_;
+  vec_num_t<Vec> size_hint_;
+  PeriodicBox<Vec> periodic_box_;
   Grid<Vec> grid_;
+  std::vector<size_t> point_cells_;
   Multivector<size_t> cell_points_;
+  std::vector<Vec> cell_coords_;
 
 }; // class GridIndex
 
@@ -122,6 +362,20 @@ public:
     return GridIndex{std::forward<Points>(points), size_hint_};
   }
 
+  /// Index the points for search using a grid, with the periodic boundaries.
+  template<std::ranges::viewable_range Points, class Vec>
+    requires deduce_constructible_from<GridIndex,
+                                       Points&&,
+                                       real_t,
+                                       PeriodicBox<Vec>>
+  [[nodiscard]] auto operator()(Points&& points,
+                                PeriodicBox<Vec> periodic_box) const {
+    TIT_PROFILE_SECTION("GridSearch::operator()");
+    return GridIndex{std::forward<Points>(points),
+                     size_hint_,
+                     std::move(periodic_box)};
+  }
+
 private:
 
   real_t size_hint_;
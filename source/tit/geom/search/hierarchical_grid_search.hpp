@@ -0,0 +1,194 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <concepts>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/par/scratch_arena.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/type_utils.hpp"
+#include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/point_range.hpp"
+#include "tit/geom/search/grid_search.hpp"
+#include "tit/geom/search/search_batch.hpp"
+
+namespace tit::geom {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Hierarchical multidimensional grid spatial search index.
+///
+/// Points are indexed by a stack of uniform grids, cell size of each next
+/// level is twice as large as the previous one. Each query is answered by the
+/// coarsest level whose cell size does not exceed the search radius, so the
+/// amount of the scanned cells stays bounded even if the search radii vary
+/// significantly across the domain.
+template<point_range Points>
+  requires std::ranges::view<Points>
+class HierarchicalGridIndex final {
+public:
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Point type.
+  using Vec = std::ranges::range_value_t<Points>;
+
+  /// Point coordinate type.
+  using Num = vec_num_t<Vec>;
+
+  /// Index the points for search using a hierarchy of grids.
+  ///
+  /// @param size_hint  Cell size hint of the finest level, typically 2x of
+  ///                   the smallest particle spacing.
+  /// @param num_levels Number of the grid levels.
+  HierarchicalGridIndex(Points points, Num size_hint, size_t num_levels)
+      : size_hint_{size_hint} {
+    TIT_ASSERT(size_hint_ > 0.0, "Cell size hint must be positive!");
+    TIT_ASSERT(num_levels > 0, "Number of levels must be positive!");
+    levels_.reserve(num_levels);
+    auto level_size_hint = size_hint_;
+    for (size_t level = 0; level < num_levels; ++level) {
+      levels_.emplace_back(points, level_size_hint);
+      level_size_hint *= 2;
+    }
+  }
+
+  /// Update the index after the points have moved, see `GridIndex::update`.
+  void update(Points points) {
+    for (auto& level : levels_) level.update(points);
+  }
+
+  /// Number of the grid levels.
+  auto num_levels() const noexcept -> size_t {
+    return levels_.size();
+  }
+
+  /// Level of the grid that is used to search with the given radius.
+  auto level_of(Num search_radius) const noexcept -> size_t {
+    size_t level = 0;
+    auto level_size = 2 * size_hint_;
+    while (level + 1 < levels_.size() && level_size <= search_radius) {
+      ++level, level_size *= 2;
+    }
+    return level;
+  }
+
+  /// Find the points within the radius to the given point.
+  template<std::output_iterator<size_t> OutIter,
+           std::predicate<size_t> Pred = AlwaysTrue>
+  auto search(const Vec& search_point,
+              Num search_radius,
+              OutIter out,
+              Pred pred = {}) const -> OutIter {
+    TIT_ASSERT(search_radius > 0.0, "Search radius should be positive.");
+    return levels_[level_of(search_radius)].search(search_point,
+                                                   search_radius,
+                                                   out,
+                                                   std::move(pred));
+  }
+
+  /// Find the points within the radii to each of the given points, and store
+  /// the sorted results into the multivector.
+  ///
+  /// Intermediate results are allocated from the @p scratch arenas, if any.
+  template<impl::query_range<Vec> Queries,
+           impl::radius_range<Vec> Radii,
+           std::unsigned_integral Index,
+           std::predicate<size_t> Pred = AlwaysTrue>
+  void search_batch(Queries&& search_points,
+                    Radii&& search_radii,
+                    Multivector<Index>& out,
+                    Pred pred = {},
+                    par::ScratchArenas* scratch = nullptr) const {
+    TIT_ASSUME_UNIVERSAL(Queries, search_points);
+    TIT_ASSUME_UNIVERSAL(Radii, search_radii);
+    TIT_ASSERT(std::size(search_points) == std::size(search_radii),
+               "Number of the search points and radii must match!");
+    impl::search_batches(
+        std::size(search_points),
+        out,
+        [&search_points, &search_radii, &pred, this](
+            size_t first,
+            size_t last,
+            par::ScratchVector<size_t>& results,
+            std::span<size_t> result_ends) {
+          for (size_t q = first; q < last; ++q) {
+            search(search_points[q],
+                   static_cast<Num>(search_radii[q]),
+                   std::back_inserter(results),
+                   pred);
+            result_ends[q - first] = results.size();
+          }
+        },
+        scratch);
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+private:
+
+  Num size_hint_;
+  std::vector<GridIndex<Points>> levels_;
+
+}; // class HierarchicalGridIndex
+
+// Wrap a viewable range into a view on construction.
+template<std::ranges::viewable_range Points, class... Args>
+HierarchicalGridIndex(Points&&, Args...)
+    -> HierarchicalGridIndex<std::views::all_t<Points>>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Hierarchical grid based spatial search indexing function.
+class HierarchicalGridSearch final {
+public:
+
+  /// Construct a hierarchical grid search indexing function.
+  ///
+  /// @param size_hint  Cell size of the finest level, typically 2x of the
+  ///                   smallest particle spacing.
+  /// @param num_levels Number of the grid levels. Five levels cover the
+  ///                   search radii that vary by 16x.
+  constexpr explicit HierarchicalGridSearch(real_t size_hint,
+                                            size_t num_levels = 5)
+      : size_hint_{size_hint}, num_levels_{num_levels} {
+    TIT_ASSERT(size_hint_ > 0.0, "Cell size hint must be positive!");
+    TIT_ASSERT(num_levels_ > 0, "Number of levels must be positive!");
+  }
+
+  /// Index the points for search using a hierarchy of grids.
+  template<std::ranges::viewable_range Points>
+    requires deduce_constructible_from<HierarchicalGridIndex,
+                                       Points&&,
+                                       real_t,
+                                       size_t>
+  [[nodiscard]] auto operator()(Points&& points) const {
+    TIT_PROFILE_SECTION("HierarchicalGridSearch::operator()");
+    return HierarchicalGridIndex{std::forward<Points>(points),
+                                 size_hint_,
+                                 num_levels_};
+  }
+
+private:
+
+  real_t size_hint_;
+  size_t num_levels_;
+
+}; // class HierarchicalGridSearch
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::geom
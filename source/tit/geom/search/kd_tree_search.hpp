@@ -6,8 +6,10 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <concepts>
 #include <iterator>
+#include <optional>
 #include <ranges>
 #include <span>
 #include <tuple>
@@ -16,10 +18,14 @@
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/containers/multivector.hpp"
 #include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
 #include "tit/core/par/memory_pool.hpp"
+#include "tit/core/par/scratch_arena.hpp"
 #include "tit/core/par/task_group.hpp"
 #include "tit/core/profiler.hpp"
+#include "tit/core/simd.hpp"
 #include "tit/core/type_utils.hpp"
 #include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
@@ -27,6 +33,7 @@
 #include "tit/geom/bbox.hpp"
 #include "tit/geom/bipartition.hpp"
 #include "tit/geom/point_range.hpp"
+#include "tit/geom/search/search_batch.hpp"
 
 namespace tit::geom {
 
@@ -34,6 +41,11 @@ namespace tit::geom {
 
 /// K-dimensional tree spatial search index.
 /// Inspired by nanoflann: https://github.com/jlblancoc/nanoflann
+///
+/// Tree nodes are stored in a flat array in the depth-first order, so that
+/// the left child of each inner node immediately follows it. Leaf nodes refer
+/// to the contiguous ranges of the point coordinates, which are stored
+/// separately per each dimension and are scanned with the SIMD registers.
 template<point_range Points>
   requires std::ranges::view<Points>
 class KDTreeIndex final {
@@ -42,12 +54,18 @@ public:
   /// Point type.
   using Vec = std::ranges::range_value_t<Points>;
 
+  /// Point coordinate type.
+  using Num = vec_num_t<Vec>;
+
+  /// Number of points that are tested at once while scanning the leaves.
+  static constexpr size_t BatchSize = simd::max_reg_size_v<Num>;
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Index the points for search using a K-dimensional tree.
   ///
   /// @param max_leaf_size Maximum amount of points in the leaf node.
-  explicit KDTreeIndex(Points points, size_t max_leaf_size = 1)
+  explicit KDTreeIndex(Points points, size_t max_leaf_size = 16)
       : points_{std::move(points)}, max_leaf_size_{max_leaf_size} {
     TIT_ASSERT(max_leaf_size_ > 0, "Maximal leaf size should be positive.");
     build_tree_();
@@ -57,31 +75,103 @@ public:
   template<std::output_iterator<size_t> OutIter,
            std::predicate<size_t> Pred = AlwaysTrue>
   auto search(const Vec& search_point,
-              vec_num_t<Vec> search_radius,
+              Num search_radius,
               OutIter out,
               Pred pred = {}) const -> OutIter {
     TIT_ASSERT(search_radius > 0.0, "Search radius should be positive.");
     return search_tree_(search_point, search_radius, out, pred);
   }
 
+  /// Find the points within the radii to each of the given points, and store
+  /// the sorted results into the multivector.
+  ///
+  /// Consecutive query points are searched in batches: if the batch points
+  /// are close to each other, the tree is traversed only once for the whole
+  /// batch, and the collected leaves are scanned for each of the queries.
+  /// Spatially sorted queries are therefore searched the fastest.
+  ///
+  /// Intermediate results are allocated from the @p scratch arenas, if any.
+  template<impl::query_range<Vec> Queries,
+           impl::radius_range<Vec> Radii,
+           std::unsigned_integral Index,
+           std::predicate<size_t> Pred = AlwaysTrue>
+  void search_batch(Queries&& search_points,
+                    Radii&& search_radii,
+                    Multivector<Index>& out,
+                    Pred pred = {},
+                    par::ScratchArenas* scratch = nullptr) const {
+    TIT_ASSUME_UNIVERSAL(Queries, search_points);
+    TIT_ASSUME_UNIVERSAL(Radii, search_radii);
+    TIT_ASSERT(std::size(search_points) == std::size(search_radii),
+               "Number of the search points and radii must match!");
+    impl::search_batches(
+        std::size(search_points),
+        out,
+        [&search_points, &search_radii, &pred, this](
+            size_t first,
+            size_t last,
+            par::ScratchVector<size_t>& results,
+            std::span<size_t> result_ends) {
+          // Search the queries one by one if they are too far apart.
+          const auto batch_box =
+              impl::batch_search_box<Vec>(search_points,
+                                          search_radii,
+                                          first,
+                                          last);
+          if (!batch_box.has_value()) {
+            for (size_t q = first; q < last; ++q) {
+              search(search_points[q],
+                     static_cast<Num>(search_radii[q]),
+                     std::back_inserter(results),
+                     pred);
+              result_ends[q - first] = results.size();
+            }
+            return;
+          }
+
+          // Collect the leaves that intersect the batch search box.
+          thread_local std::vector<size_t> leaves{};
+          leaves.clear();
+          TIT_ASSERT(!nodes_.empty(), "Tree was not built!");
+          collect_leaves_(0, *batch_box, leaves);
+
+          // Scan the leaves for each of the batch queries.
+          for (size_t q = first; q < last; ++q) {
+            const Vec& search_point = search_points[q];
+            const auto search_dist = pow2(static_cast<Num>(search_radii[q]));
+            auto out_iter = std::back_inserter(results);
+            for (const auto leaf : leaves) {
+              out_iter = search_leaf_(nodes_[leaf],
+                                      search_point,
+                                      search_dist,
+                                      out_iter,
+                                      pred);
+            }
+            result_ends[q - first] = results.size();
+          }
+        },
+        scratch);
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 private:
 
   // K-dimensional tree node structure.
-  union KDTreeNode_ {
-    std::span<const size_t> perm{};
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wpedantic"
-    struct {
-      size_t cut_axis;
-      vec_num_t<Vec> cut_left;
-      vec_num_t<Vec> cut_right;
-      KDTreeNode_* left_subtree;
-      KDTreeNode_* right_subtree;
-    };
-#pragma GCC diagnostic pop
-  }; // union KDTreeNode_
+  struct Node_ {
+    size_t cut_axis; // Cut axis, or `npos` for the leaf nodes.
+    size_t first;    // Index of the right child, or the first leaf point.
+    size_t last;     // Past the last leaf point, unused for the inner nodes.
+    Num cut_left;
+    Num cut_right;
+  }; // struct Node_
+
+  // K-dimensional tree node structure, that is used while building the tree.
+  struct BuildNode_ {
+    Node_ node;
+    const BuildNode_* left_subtree;
+    const BuildNode_* right_subtree;
+  }; // struct BuildNode_
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -92,24 +182,54 @@ private:
     // Initialize identity points permutation.
     perm_ = iota_perm(points_) | std::ranges::to<std::vector>();
 
-    // Compute the root tree node (and bounding box).
+    // Build the linked tree in parallel. Build nodes are only needed until
+    // the tree is flattened, so the pool memory of the thread is reused by
+    // its following builds. A build that is started while the thread waits
+    // for the other one to complete uses a pool of its own.
+    thread_local par::MemoryPool<BuildNode_> thread_pool{};
+    thread_local bool thread_pool_busy = false;
+    std::optional<par::MemoryPool<BuildNode_>> own_pool;
+    const bool use_thread_pool = !std::exchange(thread_pool_busy, true);
+    auto& pool = use_thread_pool ? thread_pool : own_pool.emplace();
+    if (use_thread_pool) pool.reset();
     par::TaskGroup tasks{};
-    std::tie(root_node_, tree_box_) = build_subtree_(tasks, perm_);
+    const auto [root_node, tree_box] = build_subtree_(tasks, pool, perm_);
     tasks.wait();
+    tree_box_ = tree_box;
+
+    // Flatten the tree.
+    nodes_.clear();
+    flatten_subtree_(*root_node);
+    if (use_thread_pool) thread_pool_busy = false;
+
+    // Store the point coordinates in the leaf order. Coordinates are padded,
+    // so that the whole batch could always be loaded.
+    for (auto& coords : coords_) coords.assign(perm_.size() + BatchSize, Num{});
+    par::for_each(std::views::iota(size_t{0}, perm_.size()), [this](size_t k) {
+      const auto& point = points_[perm_[k]];
+      for (size_t d = 0; d < Dim_; ++d) coords_[d][k] = point[d];
+    });
   }
 
   // Build the K-dimensional subtree.
-  auto build_subtree_(par::TaskGroup& tasks, std::span<size_t> perm)
-      -> std::pair<KDTreeNode_*, BBox<Vec>> {
+  auto build_subtree_(par::TaskGroup& tasks,
+                      par::MemoryPool<BuildNode_>& pool,
+                      std::span<size_t> perm)
+      -> std::pair<const BuildNode_*, BBox<Vec>> {
     // Compute bounding box.
     const auto box = compute_bbox(points_, perm);
 
     // Is leaf node reached?
-    const auto node = pool_.create();
+    const auto node = pool.create();
+    node->left_subtree = node->right_subtree = nullptr;
     if (perm.size() <= max_leaf_size_) {
       // Fill the leaf node and end partitioning.
-      node->perm = perm;
-      node->left_subtree = node->right_subtree = nullptr;
+      const auto first = static_cast<size_t>(perm.data() - perm_.data());
+      node->node = {.cut_axis = npos,
+                    .first = first,
+                    .last = first + perm.size(),
+                    .cut_left = Num{},
+                    .cut_right = Num{}};
       return {node, box};
     }
 
@@ -120,16 +240,18 @@ private:
         coord_bisection(points_, perm, center_coord, cut_axis);
 
     // Build subtrees.
-    node->cut_axis = cut_axis;
-    tasks.run(is_async_(left_perm), [left_perm, node, &tasks, this] {
-      const auto [left_tree, left_box] = build_subtree_(tasks, left_perm);
+    node->node.cut_axis = cut_axis;
+    tasks.run(is_async_(left_perm), [left_perm, node, &tasks, &pool, this] {
+      const auto [left_tree, left_box] =
+          build_subtree_(tasks, pool, left_perm);
       node->left_subtree = left_tree;
-      node->cut_left = left_box.high()[node->cut_axis];
+      node->node.cut_left = left_box.high()[node->node.cut_axis];
     });
-    tasks.run(is_async_(right_perm), [right_perm, node, &tasks, this] {
-      const auto [right_tree, right_box] = build_subtree_(tasks, right_perm);
+    tasks.run(is_async_(right_perm), [right_perm, node, &tasks, &pool, this] {
+      const auto [right_tree, right_box] =
+          build_subtree_(tasks, pool, right_perm);
       node->right_subtree = right_tree;
-      node->cut_right = right_box.low()[node->cut_axis];
+      node->node.cut_right = right_box.low()[node->node.cut_axis];
     });
 
     return {node, box};
@@ -141,15 +263,25 @@ private:
     return std::size(perm) >= parallel_threshold;
   }
 
+  // Append the K-dimensional subtree to the flat node array.
+  void flatten_subtree_(const BuildNode_& build_node) {
+    const auto index = nodes_.size();
+    nodes_.push_back(build_node.node);
+    if (build_node.node.cut_axis == npos) return;
+    TIT_ASSERT(build_node.left_subtree != nullptr, "Missing left subtree!");
+    TIT_ASSERT(build_node.right_subtree != nullptr, "Missing right subtree!");
+    flatten_subtree_(*build_node.left_subtree);
+    nodes_[index].first = nodes_.size();
+    flatten_subtree_(*build_node.right_subtree);
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   // Search for the point neighbors in the K-dimensional tree.
-  //
-  /// @todo Search is slow for some reason. Investigate.
   template<std::output_iterator<size_t> OutIter,
            std::predicate<size_t> Pred = AlwaysTrue>
   auto search_tree_(const Vec& search_point,
-                    vec_num_t<Vec> search_radius,
+                    Num search_radius,
                     OutIter out,
                     Pred pred = {}) const -> OutIter {
     // Compute distance from the query point to the root bounding box
@@ -158,57 +290,44 @@ private:
     auto dists = pow2(search_point - tree_box_.clamp(search_point));
 
     // Recursively search the tree.
-    TIT_ASSERT(root_node_ != nullptr, "Tree was not built!");
-    return search_subtree_(root_node_,
-                           dists,
-                           search_point,
-                           search_dist,
-                           out,
-                           pred);
+    TIT_ASSERT(!nodes_.empty(), "Tree was not built!");
+    return search_subtree_(0, dists, search_point, search_dist, out, pred);
   }
 
   // Search for the point neighbors in the K-dimensional subtree.
   // Parameters are passed by references in order to minimize stack usage.
   template<std::output_iterator<size_t> OutIter,
            std::predicate<size_t> Pred = AlwaysTrue>
-  auto search_subtree_(const KDTreeNode_* node,
+  auto search_subtree_(size_t node_index,
                        Vec& dists,
                        const Vec& search_point,
-                       vec_num_t<Vec> search_dist,
+                       Num search_dist,
                        OutIter out,
                        Pred pred) const -> OutIter {
-    if (node->left_subtree == nullptr) {
-      TIT_ASSERT(node->right_subtree == nullptr, "Invalid leaf node!");
+    const auto& node = nodes_[node_index];
+    if (node.cut_axis == npos) {
       // Collect points within the leaf node.
-      out = copy_points_near(points_,
-                             node->perm,
-                             out,
-                             search_point,
-                             search_dist,
-                             pred);
-      return out;
+      return search_leaf_(node, search_point, search_dist, out, pred);
     }
 
     // Determine which branch should be taken first.
-    const auto cut_axis = node->cut_axis;
-    const auto [cut_dist, first_node, second_node] = [&] {
-      const auto delta_left = search_point[cut_axis] - node->cut_left;
-      const auto delta_right = node->cut_right - search_point[cut_axis];
+    const auto cut_axis = node.cut_axis;
+    const auto left_index = node_index + 1;
+    const auto right_index = node.first;
+    const auto [cut_dist, first_index, second_index] = [&] {
+      const auto delta_left = search_point[cut_axis] - node.cut_left;
+      const auto delta_right = node.cut_right - search_point[cut_axis];
       return delta_left < delta_right ?
                  // Point is on the left to the cut plane, so the
                  // corresponding subtree should be searched first.
-                 std::tuple{pow2(delta_right),
-                            node->left_subtree,
-                            node->right_subtree} :
+                 std::tuple{pow2(delta_right), left_index, right_index} :
                  // Point is on the right to the cut plane, so the
                  // corresponding subtree should be searched first.
-                 std::tuple{pow2(delta_left),
-                            node->right_subtree,
-                            node->left_subtree};
+                 std::tuple{pow2(delta_left), right_index, left_index};
     }();
 
     // Search in the first subtree.
-    out = search_subtree_(first_node,
+    out = search_subtree_(first_index,
                           dists,
                           search_point,
                           search_dist,
@@ -218,7 +337,7 @@ private:
     // Search in the second subtree (if it not too far).
     if (const auto dist = sum(dists); dist < search_dist) {
       const auto old_cut_dist = std::exchange(dists[cut_axis], cut_dist);
-      out = search_subtree_(second_node,
+      out = search_subtree_(second_index,
                             dists,
                             search_point,
                             search_dist,
@@ -230,14 +349,67 @@ private:
     return out;
   }
 
+  // Collect the leaves of the K-dimensional subtree that intersect the box.
+  void collect_leaves_(size_t node_index,
+                       const BBox<Vec>& box,
+                       std::vector<size_t>& leaves) const {
+    const auto& node = nodes_[node_index];
+    if (node.cut_axis == npos) {
+      leaves.push_back(node_index);
+      return;
+    }
+    const auto cut_axis = node.cut_axis;
+    if (box.low()[cut_axis] <= node.cut_left) {
+      collect_leaves_(node_index + 1, box, leaves);
+    }
+    if (box.high()[cut_axis] >= node.cut_right) {
+      collect_leaves_(node.first, box, leaves);
+    }
+  }
+
+  // Search for the point neighbors in the leaf node.
+  template<std::output_iterator<size_t> OutIter, std::predicate<size_t> Pred>
+  auto search_leaf_(const Node_& node,
+                    const Vec& search_point,
+                    Num search_dist,
+                    OutIter out,
+                    Pred& pred) const -> OutIter {
+    using Reg = simd::Reg<Num, BatchSize>;
+    const Reg search_dist_reg{search_dist};
+    for (size_t k = node.first; k < node.last; k += BatchSize) {
+      // Compute the distances for the whole batch.
+      Reg dist{};
+      for (size_t d = 0; d < Dim_; ++d) {
+        const auto delta = Reg{std::span<const Num>{coords_[d]}.subspan(k)} -
+                           Reg{search_point[d]};
+        dist += delta * delta;
+      }
+      const auto is_near = dist < search_dist_reg;
+      if (!simd::any(is_near)) continue;
+
+      // Collect the points within the batch. Lanes past the leaf end belong
+      // to the other leaves, and are ignored.
+      std::array<simd::Mask<Num>, BatchSize> is_near_lanes{};
+      is_near.store(is_near_lanes);
+      const auto count = std::min(BatchSize, node.last - k);
+      for (size_t i = 0; i < count; ++i) {
+        const auto index = perm_[k + i];
+        if (is_near_lanes[i] && pred(index)) *out++ = index;
+      }
+    }
+    return out;
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+  static constexpr auto Dim_ = vec_dim_v<Vec>;
+
   Points points_;
   size_t max_leaf_size_;
-  par::MemoryPool<KDTreeNode_> pool_;
-  const KDTreeNode_* root_node_ = nullptr;
+  std::vector<Node_> nodes_;
   BBox<Vec> tree_box_;
   std::vector<size_t> perm_;
+  std::array<std::vector<Num>, Dim_> coords_;
 
 }; // class KDTreeIndex
 
@@ -253,8 +425,10 @@ public:
 
   /// Construct a K-dimensional tree search indexing function.
   ///
-  /// @param max_leaf_size Maximum amount of points in the leaf node.
-  constexpr explicit KDTreeSearch(size_t max_leaf_size = 1)
+  /// @param max_leaf_size Maximum amount of points in the leaf node. Leaves
+  ///                      are scanned with the SIMD registers, so the values
+  ///                      of 16-64 are typically the fastest.
+  constexpr explicit KDTreeSearch(size_t max_leaf_size = 16)
       : max_leaf_size_{max_leaf_size} {
     TIT_ASSERT(max_leaf_size_ > 0, "Maximal leaf size should be positive!");
   }
@@ -0,0 +1,129 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <optional>
+#include <ranges>
+#include <span>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/scratch_arena.hpp"
+#include "tit/core/uint_utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+
+namespace tit::geom::impl {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Number of the consecutive queries that are searched together.
+inline constexpr size_t SearchBatchSize = 16;
+
+/// Range of the query points.
+template<class Queries, class Vec>
+concept query_range =
+    par::range<Queries> &&
+    std::convertible_to<std::ranges::range_reference_t<Queries>, Vec>;
+
+/// Range of the query search radii.
+template<class Radii, class Vec>
+concept radius_range =
+    par::range<Radii> &&
+    std::convertible_to<std::ranges::range_reference_t<Radii>, vec_num_t<Vec>>;
+
+/// Compute the box that contains the search spheres of the batch queries.
+///
+/// Nothing is returned if the query points are too far from each other, so
+/// that the shared search box would be much larger than the individual ones.
+template<class Vec, class Queries, class Radii>
+auto batch_search_box(const Queries& search_points,
+                      const Radii& search_radii,
+                      size_t first,
+                      size_t last) -> std::optional<BBox<Vec>> {
+  TIT_ASSERT(first < last, "Batch must not be empty!");
+  BBox<Vec> box{static_cast<Vec>(search_points[first])};
+  auto max_radius = static_cast<vec_num_t<Vec>>(search_radii[first]);
+  for (size_t q = first + 1; q < last; ++q) {
+    box.expand(static_cast<Vec>(search_points[q]));
+    max_radius = std::max(max_radius,
+                          static_cast<vec_num_t<Vec>>(search_radii[q]));
+  }
+  TIT_ASSERT(max_radius > 0.0, "Search radius should be positive.");
+  if (max_value(box.extents()) > max_radius) return std::nullopt;
+  return box.grow(max_radius);
+}
+
+/// Search for the neighbors of the queries in batches, and store the sorted
+/// results into the multivector. Results are stored as @p Index values,
+/// which must be wide enough to hold the indices of the points.
+///
+/// @param count        Number of the queries.
+/// @param search_batch Function that appends the results of the queries
+///                     `[first, last)` to the given vector, and stores the
+///                     end offset of the results of each query into the span.
+/// @param scratch      Arenas for the intermediate results. They must not be
+///                     reset until the function returns. If none are given,
+///                     temporary arenas are used.
+template<std::invocable<size_t,
+                        size_t,
+                        par::ScratchVector<size_t>&,
+                        std::span<size_t>> SearchBatch,
+         std::unsigned_integral Index>
+void search_batches(size_t count,
+                    Multivector<Index>& out,
+                    const SearchBatch& search_batch,
+                    par::ScratchArenas* scratch = nullptr) {
+  std::optional<par::ScratchArenas> temp_scratch;
+  if (scratch == nullptr) scratch = &temp_scratch.emplace();
+  const par::ScratchAllocator<size_t> alloc{*scratch};
+
+  // Search the batches, results of each batch are stored separately.
+  const auto num_batches = divide_up(count, SearchBatchSize);
+  par::ScratchVector<par::ScratchVector<size_t>> batch_results(
+      num_batches,
+      par::ScratchVector<size_t>{alloc},
+      alloc);
+  par::ScratchVector<size_t> result_ends(count, alloc);
+  par::for_each(
+      std::views::iota(size_t{0}, num_batches),
+      [count, &search_batch, &batch_results, &result_ends](size_t batch) {
+        const auto first = batch * SearchBatchSize;
+        const auto last = std::min(first + SearchBatchSize, count);
+        search_batch(first,
+                     last,
+                     batch_results[batch],
+                     std::span{result_ends}.subspan(first, last - first));
+      });
+
+  // Pack the results into the multivector.
+  const auto result_begin = [&result_ends](size_t q) -> size_t {
+    return q % SearchBatchSize == 0 ? 0 : result_ends[q - 1];
+  };
+  out.assign_buckets_par(
+      count,
+      [&result_ends, &result_begin](size_t q) {
+        return result_ends[q] - result_begin(q);
+      },
+      [&batch_results, &result_begin](size_t q, std::span<Index> bucket) {
+        const auto& results = batch_results[q / SearchBatchSize];
+        std::ranges::transform(
+            std::span{results}.subspan(result_begin(q), bucket.size()),
+            bucket.begin(),
+            [](size_t i) { return static_cast<Index>(i); });
+        std::ranges::sort(bucket);
+      });
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::geom::impl
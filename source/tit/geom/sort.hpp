@@ -18,8 +18,10 @@ namespace tit::geom {
 
 /// Spatial sort function type.
 template<class SF>
-concept sort_func = std::same_as<SF, HilbertCurveSort> || //
-                    std::same_as<SF, MortonCurveSort>;
+concept sort_func = std::same_as<SF, HilbertCurveSort> ||
+                    std::same_as<SF, HilbertKeySort> ||
+                    std::same_as<SF, MortonCurveSort> ||
+                    std::same_as<SF, MortonKeySort>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -16,9 +16,12 @@
 #include "tit/core/range_utils.hpp"
 #include "tit/core/tuple_utils.hpp"
 #include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
 
+#include "tit/geom/bbox.hpp"
 #include "tit/geom/bipartition.hpp"
 #include "tit/geom/point_range.hpp"
+#include "tit/geom/sort/key_sort.hpp"
 
 namespace tit::geom {
 
@@ -204,4 +207,72 @@ inline constexpr HilbertCurveSort hilbert_curve_sort{};
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace impl {
+
+// Compute the Hilbert curve key of the point.
+// See J. Skilling, "Programming the Hilbert curve", AIP Conf. Proc. 707, 2004.
+template<class Vec>
+auto hilbert_key(const BBox<Vec>& box, const Vec& point) -> curve_key_t {
+  static constexpr auto Dim = vec_dim_v<Vec>;
+  static constexpr auto axes = [] {
+    std::array<size_t, Dim> result{};
+    for (size_t i = 0; i < Dim; ++i) result[i] = i;
+    return result;
+  }();
+  auto coords = quantize_point(box, point);
+
+  // Undo the excess work of the inverse transform.
+  constexpr auto high_bit = curve_key_t{1} << (curve_key_bits_v<Dim> - 1);
+  for (auto bit = high_bit; bit > 1; bit >>= 1) {
+    const auto mask = bit - 1;
+    for (size_t i = 0; i < Dim; ++i) {
+      if ((coords[i] & bit) != 0) {
+        coords[0] ^= mask;
+      } else {
+        const auto swap = (coords[0] ^ coords[i]) & mask;
+        coords[0] ^= swap, coords[i] ^= swap;
+      }
+    }
+  }
+
+  // Gray encode the coordinates.
+  for (size_t i = 1; i < Dim; ++i) coords[i] ^= coords[i - 1];
+  curve_key_t flip = 0;
+  for (auto bit = high_bit; bit > 1; bit >>= 1) {
+    if ((coords[Dim - 1] & bit) != 0) flip ^= bit - 1;
+  }
+  for (auto& coord : coords) coord ^= flip;
+
+  // Interleave the transposed coordinates into the key.
+  return interleave_bits(coords, axes);
+}
+
+} // namespace impl
+
+/// Hilbert space filling curve spatial sort function, based on the keys.
+///
+/// Computes the curve keys for all the points in parallel and then sorts
+/// them with the radix sort, which is faster for the large point sets. The
+/// curve orientation may differ from the one of `HilbertCurveSort`.
+class HilbertKeySort final {
+public:
+
+  /// Order the points along the Hilbert space filling curve.
+  template<point_range Points, output_index_range Perm>
+  void operator()(Points&& points, Perm&& perm) const {
+    TIT_PROFILE_SECTION("HilbertKeySort::operator()");
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Perm, perm);
+    impl::key_sort(points, perm, [](const auto& box, const auto& point) {
+      return impl::hilbert_key(box, point);
+    });
+  }
+
+}; // class HilbertKeySort
+
+/// Hilbert space filling curve spatial sort, based on the keys.
+inline constexpr HilbertKeySort hilbert_key_sort{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::geom
@@ -6,6 +6,7 @@
 #include <array>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
 #include "tit/core/vec.hpp"
 
 #include "tit/geom/sort/hilbert_curve_sort.hpp"
@@ -84,5 +85,36 @@ TEST_CASE("geom::HilbertCurveSort") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("geom::HilbertKeySort") {
+  // Consecutive points on the Hilbert curve must be adjacent lattice nodes.
+  const auto check_adjacent = [](const auto& points, const auto& perm) {
+    for (size_t i = 1; i < perm.size(); ++i) {
+      CHECK(norm2(points[perm[i]] - points[perm[i - 1]]) == 1.0);
+    }
+  };
+  SUBCASE("2D") {
+    // Create points on a 8x8 lattice.
+    std::array<Vec2D, 64> points{};
+    for (size_t i = 0; i < 64; ++i) points[i] = {i % 8, i / 8};
+
+    // Sort points using the Hilbert curve.
+    std::array<size_t, 64> perm{};
+    geom::hilbert_key_sort(points, perm);
+    check_adjacent(points, perm);
+  }
+  SUBCASE("3D") {
+    // Create points on a 4x4x4 lattice.
+    std::array<Vec3D, 64> points{};
+    for (size_t i = 0; i < 64; ++i) points[i] = {i % 4, i / 4 % 4, i / 16};
+
+    // Sort points using the Hilbert curve.
+    std::array<size_t, 64> perm{};
+    geom::hilbert_key_sort(points, perm);
+    check_adjacent(points, perm);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
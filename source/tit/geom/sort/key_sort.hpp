@@ -0,0 +1,105 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/range_utils.hpp"
+#include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/point_range.hpp"
+
+namespace tit::geom::impl {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Space filling curve key type.
+using curve_key_t = uint64_t;
+
+/// Number of bits per coordinate in the space filling curve key.
+template<size_t Dim>
+inline constexpr size_t curve_key_bits_v =
+    std::min<size_t>(8 * sizeof(curve_key_t) / Dim, 32);
+
+/// Quantized point coordinates.
+template<size_t Dim>
+using QuantizedPoint = std::array<curve_key_t, Dim>;
+
+/// Quantize the point coordinates within the bounding box, so that the
+/// most significant bits of the coordinates select the halves of the box.
+template<class Vec>
+auto quantize_point(const BBox<Vec>& box, const Vec& point)
+    -> QuantizedPoint<vec_dim_v<Vec>> {
+  using Num = vec_num_t<Vec>;
+  static constexpr auto Dim = vec_dim_v<Vec>;
+  static constexpr auto max_coord =
+      (curve_key_t{1} << curve_key_bits_v<Dim>) - 1;
+  static constexpr auto scale = static_cast<Num>(max_coord + 1);
+  const auto extents = box.extents();
+  QuantizedPoint<Dim> coords{};
+  for (size_t d = 0; d < Dim; ++d) {
+    if (extents[d] <= Num{0}) continue;
+    const auto t = (point[d] - box.low()[d]) / extents[d];
+    coords[d] = std::min(static_cast<curve_key_t>(std::max(t, Num{0}) * scale),
+                         max_coord);
+  }
+  return coords;
+}
+
+/// Interleave the bits of the quantized coordinates, starting from the
+/// most significant ones, visiting the axes in the given order.
+template<size_t Dim>
+constexpr auto interleave_bits(const QuantizedPoint<Dim>& coords,
+                               const std::array<size_t, Dim>& axes) noexcept
+    -> curve_key_t {
+  curve_key_t key = 0;
+  for (size_t bit = curve_key_bits_v<Dim>; bit-- > 0;) {
+    for (const auto axis : axes) key = (key << 1) | ((coords[axis] >> bit) & 1);
+  }
+  return key;
+}
+
+/// Order the points by the space filling curve keys.
+///
+/// Keys are computed in parallel from the bounding box and the point by the
+/// key function, and then the points are sorted by the keys with the radix
+/// sort. Points with the equal keys keep their original order.
+template<point_range Points,
+         output_index_range Perm,
+         std::regular_invocable<const point_range_bbox_t<Points>&,
+                                const point_range_vec_t<Points>&> KeyFunc>
+void key_sort(Points&& points, Perm&& perm, const KeyFunc& key_func) {
+  TIT_ASSUME_UNIVERSAL(Points, points);
+  TIT_ASSUME_UNIVERSAL(Perm, perm);
+
+  // Compute the keys.
+  const auto box = compute_bbox(points);
+  std::vector<curve_key_t> keys(std::size(points));
+  par::transform(iota_perm(points),
+                 keys.begin(),
+                 [&points, &box, &key_func](size_t index) {
+                   return key_func(box, points[index]);
+                 });
+
+  // Sort the points by the keys.
+  std::vector<size_t> indices(std::size(points));
+  iota_perm(points, indices);
+  par::radix_sort(std::span{keys}, std::span{indices});
+  std::ranges::copy(indices, std::begin(perm));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::geom::impl
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <array>
 #include <functional>
 #include <ranges>
 
@@ -13,9 +14,12 @@
 #include "tit/core/profiler.hpp"
 #include "tit/core/range_utils.hpp"
 #include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
 
+#include "tit/geom/bbox.hpp"
 #include "tit/geom/bipartition.hpp"
 #include "tit/geom/point_range.hpp"
+#include "tit/geom/sort/key_sort.hpp"
 
 namespace tit::geom {
 
@@ -78,4 +82,47 @@ inline constexpr MortonCurveSort morton_curve_sort{};
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace impl {
+
+// Compute the Morton curve key of the point.
+template<class Vec>
+auto morton_key(const BBox<Vec>& box, const Vec& point) -> curve_key_t {
+  static constexpr auto Dim = vec_dim_v<Vec>;
+  // Axes start from Y to match the `MortonCurveSort` ordering.
+  static constexpr auto axes = [] {
+    std::array<size_t, Dim> result{};
+    for (size_t i = 0; i < Dim; ++i) result[i] = (i + 1) % Dim;
+    return result;
+  }();
+  return interleave_bits(quantize_point(box, point), axes);
+}
+
+} // namespace impl
+
+/// Morton space filling curve spatial sort function, based on the keys.
+///
+/// Produces the same ordering as `MortonCurveSort` up to the key resolution,
+/// but computes the curve keys for all the points in parallel and then sorts
+/// them with the radix sort, which is faster for the large point sets.
+class MortonKeySort final {
+public:
+
+  /// Order the points along the Morton space filling curve.
+  template<point_range Points, output_index_range Perm>
+  void operator()(Points&& points, Perm&& perm) const {
+    TIT_PROFILE_SECTION("MortonKeySort::operator()");
+    TIT_ASSUME_UNIVERSAL(Points, points);
+    TIT_ASSUME_UNIVERSAL(Perm, perm);
+    impl::key_sort(points, perm, [](const auto& box, const auto& point) {
+      return impl::morton_key(box, point);
+    });
+  }
+
+}; // class MortonKeySort
+
+/// Morton space filling curve spatial sort, based on the keys.
+inline constexpr MortonKeySort morton_key_sort{};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::geom
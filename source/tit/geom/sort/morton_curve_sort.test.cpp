@@ -61,5 +61,24 @@ TEST_CASE("geom::MortonCurveSort") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("geom::MortonKeySort") {
+  // Create points on a 8x8 lattice.
+  std::array<Vec2D, 64> points{};
+  for (size_t i = 0; i < 64; ++i) points[i] = {i % 8, i / 8};
+
+  // Sort points using the Morton curve.
+  std::array<size_t, 64> perm{};
+  geom::morton_key_sort(points, perm);
+
+  // Ensure the permutation matches the one of `MortonCurveSort`.
+  CHECK_RANGE_EQ(perm, {0,  1,  8,  9,  2,  3,  10, 11, 16, 17, 24, 25, 18,
+                        19, 26, 27, 4,  5,  12, 13, 6,  7,  14, 15, 20, 21,
+                        28, 29, 22, 23, 30, 31, 32, 33, 40, 41, 34, 35, 42,
+                        43, 48, 49, 56, 57, 50, 51, 58, 59, 36, 37, 44, 45,
+                        38, 39, 46, 47, 52, 53, 60, 61, 54, 55, 62, 63});
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
@@ -0,0 +1,148 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <ranges>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/containers/multivector.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/rand_utils.hpp"
+
+namespace tit::graph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Parallel greedy edge coloring. Edges of the same color do not share any
+/// nodes, so they can be processed concurrently without conflicts.
+///
+/// Jones-Plassmann scheme is applied to the line graph: in each round, the
+/// uncolored edges, that have the highest pseudo-random priority among their
+/// uncolored incident edges, take the smallest color that is not used by
+/// their incident edges. Such edges never share a node, so the rounds need
+/// no synchronization, and the result does not depend on the number of
+/// threads. Number of colors is at most `2 * max_degree - 1`.
+class EdgeColoring final {
+public:
+
+  /// Color the edges.
+  ///
+  /// @param num_nodes Number of the graph nodes.
+  /// @param edges     Edges, pairs of the node indices. Self loops are not
+  ///                  allowed.
+  /// @param colors    Indices of the edges, grouped by the color, in the
+  ///                  increasing order within each color.
+  template<par::range Edges>
+  void operator()(size_t num_nodes,
+                  const Edges& edges,
+                  Multivector<size_t>& colors) {
+    TIT_PROFILE_SECTION("EdgeColoring::operator()");
+    const auto num_edges = std::size(edges);
+
+    // Collect the incident edges of each node.
+    incident_.assign_pairs_par_tall(
+        num_nodes,
+        std::views::iota(size_t{0}, 2 * num_edges) |
+            std::views::transform([&edges](size_t k) {
+              const auto [a, b] = edges[k / 2];
+              TIT_ASSERT(a != b, "Self loops are not allowed!");
+              return std::pair{static_cast<size_t>(k % 2 == 0 ? a : b), k / 2};
+            }));
+
+    // Color the edges round by round.
+    edge_colors_.assign(num_edges, NoColor);
+    is_max_.resize(num_edges);
+    active_.resize(num_edges);
+    std::ranges::copy(std::views::iota(size_t{0}, num_edges), active_.begin());
+    thread_colors_.resize(par::num_threads());
+    while (!active_.empty()) {
+      // Find the edges of the highest priority among their uncolored incident
+      // edges. Colors are not changed here, so there is no race.
+      par::for_each(active_, [&edges, this](size_t e) {
+        const auto [a, b] = edges[e];
+        const auto is_dominated = [e, this](size_t f) {
+          return edge_colors_[f] != NoColor || !has_lower_priority_(e, f);
+        };
+        const auto is_max = std::ranges::all_of(incident_[a], is_dominated) &&
+                            std::ranges::all_of(incident_[b], is_dominated);
+        is_max_[e] = is_max ? 1 : 0;
+      });
+
+      // Color the found edges. They do not share the incident edges, so each
+      // edge only reads the colors set in the previous rounds.
+      par::static_for_each(active_, [&edges, this](size_t thread, size_t e) {
+        if (is_max_[e] == 0) return;
+        const auto [a, b] = edges[e];
+        auto& used = thread_colors_[thread];
+        used.clear();
+        for (const auto node : {a, b}) {
+          for (const auto f : incident_[node]) {
+            if (edge_colors_[f] != NoColor) used.push_back(edge_colors_[f]);
+          }
+        }
+        std::ranges::sort(used);
+        uint32_t color = 0;
+        for (const auto c : used) {
+          if (c > color) break;
+          if (c == color) ++color;
+        }
+        edge_colors_[e] = color;
+      });
+
+      // Remove the colored edges.
+      const auto colored_iter =
+          par::remove_if(active_, [this](size_t e) { return is_max_[e] != 0; });
+      active_.erase(colored_iter, active_.end());
+    }
+
+    // Group the edges by the color.
+    const auto num_colors = par::transform_reduce(
+        edge_colors_,
+        size_t{0},
+        [](size_t x, size_t y) { return std::max(x, y); },
+        [](uint32_t color) { return static_cast<size_t>(color) + 1; });
+    colors.assign_pairs_par_wide(
+        num_colors,
+        std::views::iota(size_t{0}, num_edges) |
+            std::views::transform([this](size_t e) {
+              return std::pair{static_cast<size_t>(edge_colors_[e]), e};
+            }));
+  }
+
+private:
+
+  static constexpr auto NoColor = std::numeric_limits<uint32_t>::max();
+
+  // Pseudo-random edge priority.
+  static constexpr auto priority_(size_t e) noexcept -> uint64_t {
+    return SplitMix64{e}();
+  }
+
+  // Does the edge `e` have the lower priority than the edge `f`?
+  static constexpr auto has_lower_priority_(size_t e, size_t f) noexcept
+      -> bool {
+    return std::pair{priority_(e), e} < std::pair{priority_(f), f};
+  }
+
+  Multivector<size_t> incident_;
+  std::vector<uint32_t> edge_colors_;
+  std::vector<uint8_t> is_max_;
+  std::vector<size_t> active_;
+  std::vector<std::vector<uint32_t>> thread_colors_;
+
+}; // class EdgeColoring
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::graph
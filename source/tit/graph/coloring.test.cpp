@@ -0,0 +1,62 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/containers/multivector.hpp"
+
+#include "tit/graph/coloring.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("graph::EdgeColoring") {
+  // Grid graph of 8x8 nodes, each node is connected to its right, upper and
+  // upper-right neighbors, so the maximum degree is 6.
+  constexpr size_t n = 8;
+  std::vector<std::pair<uint32_t, uint32_t>> edges;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      const auto a = static_cast<uint32_t>(i * n + j);
+      if (j + 1 < n) edges.emplace_back(a, a + 1);
+      if (i + 1 < n) edges.emplace_back(a, a + n);
+      if (i + 1 < n && j + 1 < n) edges.emplace_back(a, a + n + 1);
+    }
+  }
+  Multivector<size_t> colors;
+  graph::EdgeColoring{}(n * n, edges, colors);
+  REQUIRE(colors.size() >= 6);
+  CHECK(colors.size() <= 2 * 6 - 1);
+  SUBCASE("each edge is colored once") {
+    std::vector<size_t> colored(colors.vals().begin(), colors.vals().end());
+    std::ranges::sort(colored);
+    CHECK(colored.size() == edges.size());
+    CHECK(std::ranges::adjacent_find(colored) == colored.end());
+  }
+  SUBCASE("edges of the same color do not share nodes") {
+    for (const auto color : colors.buckets()) {
+      CHECK(std::ranges::is_sorted(color));
+      std::vector<uint32_t> nodes;
+      for (const auto e : color) {
+        nodes.push_back(edges[e].first);
+        nodes.push_back(edges[e].second);
+      }
+      std::ranges::sort(nodes);
+      CHECK(std::ranges::adjacent_find(nodes) == nodes.end());
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,275 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <iterator>
+#include <ranges>
+#include <tuple>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/memory_stats.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/first_touch.hpp"
+
+#include "tit/graph/graph.hpp"
+
+namespace tit::graph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Compressed sparse adjacency graph with the delta-encoded rows.
+///
+/// Each row is stored as its size, followed by the first node and the
+/// differences between the consecutive nodes, all in the variable-byte
+/// encoding: seven bits per byte, with the high bit set on all the bytes but
+/// the last one. Rows of a spatially sorted graph are locally dense, so most
+/// of the differences fit into a single byte. Rows are decoded on the fly
+/// while they are iterated.
+class CompressedGraph final {
+public:
+
+  /// Forward iterator over the nodes of a row.
+  class RowIterator final {
+  public:
+
+    /// Iterator value type.
+    using value_type = node_t;
+
+    /// Iterator difference type.
+    using difference_type = ptrdiff_t;
+
+    /// Construct a past-the-end iterator.
+    constexpr RowIterator() = default;
+
+    /// Construct an iterator to the row of @p size nodes, that are encoded
+    /// at @p data.
+    constexpr RowIterator(const uint8_t* data, size_t size) noexcept
+        : data_{data}, remaining_{size} {
+      if (remaining_ != 0) node_ = decode_(data_);
+    }
+
+    /// Current node.
+    constexpr auto operator*() const noexcept -> node_t {
+      TIT_ASSERT(remaining_ != 0, "Iterator is past the end!");
+      return node_;
+    }
+
+    /// Advance to the next node.
+    /// @{
+    constexpr auto operator++() noexcept -> RowIterator& {
+      TIT_ASSERT(remaining_ != 0, "Iterator is past the end!");
+      if (--remaining_ != 0) node_ += decode_(data_);
+      return *this;
+    }
+    constexpr auto operator++(int) noexcept -> RowIterator {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+    /// @}
+
+    /// Compare the iterators.
+    constexpr auto operator==(const RowIterator& other) const noexcept
+        -> bool {
+      return remaining_ == other.remaining_;
+    }
+
+    /// Is the iterator past the end?
+    constexpr auto operator==(std::default_sentinel_t /*end*/) const noexcept
+        -> bool {
+      return remaining_ == 0;
+    }
+
+  private:
+
+    const uint8_t* data_ = nullptr;
+    size_t remaining_ = 0;
+    node_t node_ = 0;
+
+  }; // class RowIterator
+
+  /// Row of the graph.
+  class Row final : public std::ranges::view_interface<Row> {
+  public:
+
+    /// Construct an empty row.
+    constexpr Row() = default;
+
+    /// Construct the row, that is encoded at @p data.
+    constexpr explicit Row(const uint8_t* data) noexcept : data_{data} {}
+
+    /// Number of the nodes in the row.
+    constexpr auto size() const noexcept -> size_t {
+      if (data_ == nullptr) return 0;
+      const auto* data = data_;
+      return decode_(data);
+    }
+
+    /// Iterator to the first node of the row.
+    constexpr auto begin() const noexcept -> RowIterator {
+      if (data_ == nullptr) return {};
+      const auto* data = data_;
+      const auto size = decode_(data);
+      return {data, size};
+    }
+
+    /// Sentinel of the row.
+    static constexpr auto end() noexcept -> std::default_sentinel_t {
+      return std::default_sentinel;
+    }
+
+  private:
+
+    const uint8_t* data_ = nullptr;
+
+  }; // class Row
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Construct an empty graph.
+  CompressedGraph() = default;
+
+  /// Compress the graph. Rows of the graph must be sorted.
+  template<std::unsigned_integral Node>
+  explicit CompressedGraph(const BasicGraph<Node>& graph) {
+    assign(graph);
+  }
+
+  /// Number of graph nodes.
+  constexpr auto num_nodes() const noexcept -> size_t {
+    return row_offsets_.size() - 1;
+  }
+
+  /// Number of graph nodes.
+  constexpr auto size() const noexcept -> size_t {
+    return num_nodes();
+  }
+
+  /// Size of the encoded rows, in bytes.
+  constexpr auto num_bytes() const noexcept -> size_t {
+    return bytes_.size();
+  }
+
+  /// Number of bytes allocated on the heap.
+  constexpr auto heap_bytes() const noexcept -> size_t {
+    return tit::heap_bytes(row_offsets_) + tit::heap_bytes(bytes_);
+  }
+
+  /// Row of the graph.
+  constexpr auto operator[](size_t node) const noexcept -> Row {
+    TIT_ASSERT(node < num_nodes(), "Node index is out of range!");
+    return Row{bytes_.data() + row_offsets_[node]};
+  }
+
+  /// Range of the row sizes.
+  constexpr auto bucket_sizes() const noexcept {
+    return std::views::iota(size_t{0}, num_nodes()) |
+           std::views::transform(
+               [this](size_t node) { return (*this)[node].size(); });
+  }
+
+  /// Range of the unique graph edges, transformed by the function.
+  template<class Func>
+  constexpr auto transform_edges(Func fn) const noexcept {
+    return std::views::iota(size_t{0}, num_nodes()) |
+           std::views::transform([this, fn](size_t row_index) {
+             return (*this)[row_index] |
+                    // Take only lower part of the row.
+                    std::views::take_while([row_index](size_t col_index) {
+                      return col_index < row_index;
+                    }) |
+                    // Pack row and column indices into a tuple.
+                    std::views::transform([row_index](size_t col_index) {
+                      return std::tuple{col_index, row_index};
+                    }) |
+                    // Apply the transformation function.
+                    std::views::transform(fn);
+           }) |
+           std::views::join;
+  }
+
+  /// Range of the unique graph edges.
+  constexpr auto edges() const noexcept {
+    return transform_edges([](const auto& edge) { return edge; });
+  }
+
+  /// Compress the graph. Rows of the graph must be sorted.
+  template<std::unsigned_integral Node>
+  void assign(const BasicGraph<Node>& graph) {
+    // Compute the row sizes in bytes, and the row offsets from them.
+    const auto num_nodes = graph.num_nodes();
+    row_offsets_.clear(), row_offsets_.resize(num_nodes + 1);
+    par::for_each(std::views::iota(size_t{0}, num_nodes),
+                  [&graph, this](size_t node) {
+                    const auto row = graph[node];
+                    TIT_ASSERT(std::ranges::is_sorted(row),
+                               "Graph rows must be sorted!");
+                    auto size = encoded_size_(row.size());
+                    for (size_t i = 0; i < row.size(); ++i) {
+                      size += encoded_size_(row[i] - (i == 0 ? 0 : row[i - 1]));
+                    }
+                    row_offsets_[node + 1] = size;
+                  });
+    par::inclusive_scan(row_offsets_, row_offsets_.begin());
+
+    // Encode the rows.
+    bytes_.clear(), bytes_.resize(row_offsets_.back());
+    par::for_each(std::views::iota(size_t{0}, num_nodes),
+                  [&graph, this](size_t node) {
+                    const auto row = graph[node];
+                    auto* data = bytes_.data() + row_offsets_[node];
+                    encode_(data, row.size());
+                    for (size_t i = 0; i < row.size(); ++i) {
+                      encode_(data, row[i] - (i == 0 ? 0 : row[i - 1]));
+                    }
+                    TIT_ASSERT(data == bytes_.data() + row_offsets_[node + 1],
+                               "Row size mismatch!");
+                  });
+  }
+
+  /// Clear the graph and release its memory.
+  void clear() {
+    row_offsets_ = {0};
+    bytes_ = {};
+  }
+
+private:
+
+  // Number of bytes that are needed to encode the value.
+  static constexpr auto encoded_size_(size_t value) noexcept -> size_t {
+    size_t size = 1;
+    for (; value >= 0x80; value >>= 7) size += 1;
+    return size;
+  }
+
+  // Encode the value and advance the pointer.
+  static constexpr void encode_(uint8_t*& data, size_t value) noexcept {
+    for (; value >= 0x80; value >>= 7) {
+      *data++ = static_cast<uint8_t>(value | 0x80);
+    }
+    *data++ = static_cast<uint8_t>(value);
+  }
+
+  // Decode the value and advance the pointer.
+  static constexpr auto decode_(const uint8_t*& data) noexcept -> size_t {
+    size_t value = *data & 0x7F;
+    for (size_t shift = 7; (*data++ & 0x80) != 0; shift += 7) {
+      value |= static_cast<size_t>(*data & 0x7F) << shift;
+    }
+    return value;
+  }
+
+  par::FirstTouchVector<size_t> row_offsets_{0};
+  par::FirstTouchVector<uint8_t> bytes_;
+
+}; // class CompressedGraph
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::graph
@@ -0,0 +1,57 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <ranges>
+#include <tuple>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+
+#include "tit/graph/compressed_graph.hpp"
+#include "tit/graph/graph.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("graph::CompressedGraph") {
+  // Rows with the small and the large differences, and an empty row.
+  graph::BasicGraph<uint32_t> graph;
+  graph.append_bucket(std::vector<uint32_t>{0, 1, 3});
+  graph.append_bucket(std::vector<uint32_t>{});
+  graph.append_bucket(std::vector<uint32_t>{0, 2, 200, 100000});
+  graph.append_bucket(std::vector<uint32_t>{2, 3});
+  const graph::CompressedGraph compressed{graph};
+  REQUIRE(compressed.num_nodes() == graph.num_nodes());
+  CHECK(compressed.num_bytes() == 16);
+  SUBCASE("rows") {
+    for (size_t node = 0; node < graph.num_nodes(); ++node) {
+      CHECK(compressed[node].size() == graph[node].size());
+      CHECK(std::ranges::equal(compressed[node], graph[node]));
+    }
+    CHECK(std::ranges::equal(compressed.bucket_sizes(),
+                             std::vector<size_t>{3, 0, 4, 2}));
+  }
+  SUBCASE("edges") {
+    CHECK(std::ranges::equal(
+        compressed.edges(),
+        std::vector<std::tuple<size_t, size_t>>{{0, 2}, {2, 3}}));
+  }
+  SUBCASE("clear") {
+    auto copy = compressed;
+    copy.clear();
+    CHECK(copy.num_nodes() == 0);
+    CHECK(copy.num_bytes() == 0);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
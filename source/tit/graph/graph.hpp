@@ -5,11 +5,18 @@
 
 #pragma once
 
+#include <algorithm>
+#include <concepts>
 #include <ranges>
+#include <span>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
 #include "tit/core/containers/multivector.hpp"
+#include "tit/core/par/algorithms.hpp"
 
 namespace tit::graph {
 
@@ -24,25 +31,29 @@ using weight_t = ssize_t;
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Compressed sparse adjacency graph.
-class Graph : public Multivector<size_t> {
+///
+/// Node indices are stored as @p Node values, so that graphs with less than
+/// 2^32 nodes may use 32-bit indices and take half of the memory.
+template<std::unsigned_integral Node = node_t>
+class BasicGraph : public Multivector<Node> {
 public:
 
   /// Number of graph nodes.
   constexpr auto num_nodes() const noexcept -> size_t {
-    return size();
+    return this->size();
   }
 
   /// Range of the unique graph edges.
   constexpr auto edges() const noexcept {
-    return std::views::iota(0UZ, num_nodes()) |
-           std::views::transform([this](size_t row_index) {
+    return std::views::iota(Node{0}, static_cast<Node>(num_nodes())) |
+           std::views::transform([this](Node row_index) {
              return (*this)[row_index] |
                     // Take only lower part of the row.
-                    std::views::take_while([row_index](size_t col_index) {
+                    std::views::take_while([row_index](Node col_index) {
                       return col_index < row_index;
                     }) |
                     // Pack row and column indices into a tuple.
-                    std::views::transform([row_index](size_t col_index) {
+                    std::views::transform([row_index](Node col_index) {
                       return std::tuple{col_index, row_index};
                     });
            }) |
@@ -51,15 +62,15 @@ public:
 
   template<class Func>
   constexpr auto transform_edges(Func fn) const noexcept {
-    return std::views::iota(0UZ, num_nodes()) |
-           std::views::transform([this, fn](size_t row_index) {
+    return std::views::iota(Node{0}, static_cast<Node>(num_nodes())) |
+           std::views::transform([this, fn](Node row_index) {
              return (*this)[row_index] |
                     // Take only lower part of the row.
-                    std::views::take_while([row_index](size_t col_index) {
+                    std::views::take_while([row_index](Node col_index) {
                       return col_index < row_index;
                     }) |
                     // Pack row and column indices into a tuple.
-                    std::views::transform([row_index](size_t col_index) {
+                    std::views::transform([row_index](Node col_index) {
                       return std::tuple{col_index, row_index};
                     }) |
                     // Apply the transformation function.
@@ -68,7 +79,43 @@ public:
            std::views::join;
   }
 
-}; // class Graph
+  /// Renumber the graph nodes.
+  ///
+  /// @param perm Permutation, such that the node `i` after the renumbering
+  ///             is the node `perm[i]` before it. Neighbors of each node are
+  ///             renumbered and kept sorted.
+  template<std::ranges::random_access_range Perm>
+    requires std::convertible_to<std::ranges::range_value_t<Perm>, size_t>
+  void permute_nodes(const Perm& perm) {
+    const auto count = num_nodes();
+    TIT_ASSERT(std::size(perm) == count,
+               "Permutation size must match the number of nodes!");
+    std::vector<Node> inverse_perm(count);
+    par::for_each(std::views::iota(size_t{0}, count),
+                  [&perm, &inverse_perm](size_t node) {
+                    inverse_perm[perm[node]] = static_cast<Node>(node);
+                  });
+    const BasicGraph old_graph{std::move(*this)};
+    this->assign_buckets_par(
+        count,
+        [&old_graph, &perm](size_t node) {
+          return std::size(old_graph[perm[node]]);
+        },
+        [&old_graph, &perm, &inverse_perm](size_t node,
+                                           std::span<Node> neighbors) {
+          std::ranges::transform(old_graph[perm[node]],
+                                 neighbors.begin(),
+                                 [&inverse_perm](Node neighbor) {
+                                   return inverse_perm[neighbor];
+                                 });
+          std::ranges::sort(neighbors);
+        });
+  }
+
+}; // class BasicGraph
+
+/// Compressed sparse adjacency graph with the default node indices.
+using Graph = BasicGraph<>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
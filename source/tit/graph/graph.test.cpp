@@ -0,0 +1,42 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+
+#include "tit/graph/graph.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("graph::Graph::permute_nodes") {
+  // Path graph 0 - 1 - 2 - 3.
+  graph::Graph graph;
+  graph.append_bucket(std::vector<size_t>{1});
+  graph.append_bucket(std::vector<size_t>{0, 2});
+  graph.append_bucket(std::vector<size_t>{1, 3});
+  graph.append_bucket(std::vector<size_t>{2});
+
+  // Node `i` after the renumbering is the node `perm[i]` before it, so the
+  // path becomes 2 - 0 - 3 - 1.
+  const std::vector<size_t> perm{1, 3, 0, 2};
+  graph.permute_nodes(perm);
+  REQUIRE(graph.num_nodes() == 4);
+  CHECK(std::ranges::equal(graph[0], std::vector<size_t>{2, 3}));
+  CHECK(std::ranges::equal(graph[1], std::vector<size_t>{3}));
+  CHECK(std::ranges::equal(graph[2], std::vector<size_t>{0}));
+  CHECK(std::ranges::equal(graph[3], std::vector<size_t>{0, 1}));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
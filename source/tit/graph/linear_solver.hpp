@@ -0,0 +1,368 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <concepts>
+#include <functional>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+
+namespace tit::graph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Matrix-free linear operator, that computes `y = A * x` as `op(x, y)`.
+template<class Op, class Num>
+concept linear_operator =
+    std::floating_point<Num> &&
+    std::invocable<const Op&, std::span<const Num>, std::span<Num>> &&
+    requires(const Op& op) {
+      { op.num_rows() } -> std::convertible_to<size_t>;
+    };
+
+/// Linear operator, that also provides its diagonal.
+template<class Op, class Num>
+concept diagonal_operator =
+    linear_operator<Op, Num> && requires(const Op& op, size_t row) {
+      { op.diagonal(row) } -> std::convertible_to<Num>;
+    };
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Matrix-free linear operator over the graph adjacency.
+///
+/// Row `i` of the operator is `diag(i) * x[i] + sum(coeff(i, j) * x[j])`,
+/// where the sum is taken over the neighbors `j` of the node `i`. Self loops
+/// of the graph are skipped, since the diagonal is provided separately. Rows
+/// are computed in parallel, each row gathers the contributions of its
+/// neighbors, so no synchronization is needed. Coefficients are evaluated on
+/// each application, and are never stored.
+template<class Graph, class Diag, class Coeff>
+  requires std::regular_invocable<const Diag&, size_t> &&
+           std::regular_invocable<const Coeff&, size_t, size_t>
+class GraphOperator final {
+public:
+
+  /// Construct the operator.
+  ///
+  /// @param graph Adjacency graph. Must outlive the operator.
+  /// @param diag  Diagonal coefficient function.
+  /// @param coeff Off-diagonal coefficient function.
+  constexpr GraphOperator(const Graph& graph, Diag diag, Coeff coeff) noexcept
+      : graph_{&graph}, diag_{std::move(diag)}, coeff_{std::move(coeff)} {}
+
+  /// Number of the operator rows.
+  constexpr auto num_rows() const noexcept -> size_t {
+    return graph_->num_nodes();
+  }
+
+  /// Diagonal coefficient of the row.
+  constexpr auto diagonal(size_t row) const {
+    TIT_ASSERT(row < num_rows(), "Row index is out of range!");
+    return std::invoke(diag_, row);
+  }
+
+  /// Apply the operator.
+  template<std::floating_point Num>
+  void operator()(std::span<const Num> x, std::span<Num> y) const {
+    TIT_ASSERT(x.size() == num_rows(), "Operand size mismatch!");
+    TIT_ASSERT(y.size() == num_rows(), "Result size mismatch!");
+    par::for_each(std::views::iota(size_t{0}, num_rows()),
+                  [x, y, this](size_t row) {
+                    auto y_row = static_cast<Num>(diagonal(row)) * x[row];
+                    for (const auto col : (*graph_)[row]) {
+                      if (col == row) continue;
+                      const auto c = std::invoke(coeff_, row, size_t{col});
+                      y_row += static_cast<Num>(c) * x[col];
+                    }
+                    y[row] = y_row;
+                  });
+  }
+
+private:
+
+  const Graph* graph_;
+  [[no_unique_address]] Diag diag_;
+  [[no_unique_address]] Coeff coeff_;
+
+}; // class GraphOperator
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Identity preconditioner.
+class NoPreconditioner final {
+public:
+
+  /// Apply the preconditioner, `z = r`.
+  template<std::floating_point Num>
+  static void operator()(std::span<const Num> r, std::span<Num> z) {
+    TIT_ASSERT(r.size() == z.size(), "Size mismatch!");
+    par::for_each(std::views::iota(size_t{0}, r.size()),
+                  [r, z](size_t i) { z[i] = r[i]; });
+  }
+
+}; // class NoPreconditioner
+
+/// Jacobi (diagonal) preconditioner.
+template<std::floating_point Num>
+class JacobiPreconditioner final {
+public:
+
+  /// Construct the preconditioner from the operator diagonal.
+  template<diagonal_operator<Num> Op>
+  explicit JacobiPreconditioner(const Op& op)
+      : inv_diag_(op.num_rows()) {
+    par::for_each(std::views::iota(size_t{0}, op.num_rows()),
+                  [&op, this](size_t row) {
+                    const auto diag = static_cast<Num>(op.diagonal(row));
+                    TIT_ASSERT(diag != 0.0, "Diagonal must be nonzero!");
+                    inv_diag_[row] = inverse(diag);
+                  });
+  }
+
+  /// Apply the preconditioner, `z = r / diag(A)`.
+  void operator()(std::span<const Num> r, std::span<Num> z) const {
+    TIT_ASSERT(r.size() == inv_diag_.size(), "Residual size mismatch!");
+    TIT_ASSERT(z.size() == inv_diag_.size(), "Result size mismatch!");
+    par::for_each(std::views::iota(size_t{0}, r.size()),
+                  [r, z, this](size_t i) { z[i] = inv_diag_[i] * r[i]; });
+  }
+
+private:
+
+  std::vector<Num> inv_diag_;
+
+}; // class JacobiPreconditioner
+
+/// Preconditioner type.
+template<class Precond, class Num>
+concept preconditioner =
+    std::invocable<const Precond&, std::span<const Num>, std::span<Num>>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Outcome of the iterative linear solve.
+struct SolveResult final {
+  size_t num_iterations = 0; ///< Number of the iterations made.
+  real_t residual = 0.0;     ///< Relative norm of the final residual.
+  bool converged = false;    ///< Has the tolerance been reached?
+};
+
+namespace impl {
+
+// Parallel dot product.
+template<std::floating_point Num>
+auto dot(std::span<const Num> x, std::span<const Num> y) -> Num {
+  TIT_ASSERT(x.size() == y.size(), "Size mismatch!");
+  return par::transform_reduce(std::views::iota(size_t{0}, x.size()),
+                               Num{0.0},
+                               std::plus{},
+                               [x, y](size_t i) { return x[i] * y[i]; });
+}
+
+// Parallel Euclidean norm.
+template<std::floating_point Num>
+auto norm(std::span<const Num> x) -> Num {
+  return sqrt(dot(x, x));
+}
+
+// Parallel element-wise update, `x[i] = func(i)`.
+template<std::floating_point Num, class Func>
+void update(std::span<Num> x, const Func& func) {
+  par::for_each(std::views::iota(size_t{0}, x.size()),
+                [x, &func](size_t i) { x[i] = func(i); });
+}
+
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Preconditioned conjugate gradient solver, for the symmetric positive
+/// definite operators.
+class ConjugateGradient final {
+public:
+
+  /// Construct the solver.
+  ///
+  /// @param max_iterations Maximum number of the iterations.
+  /// @param tolerance      Relative tolerance of the residual norm.
+  constexpr explicit ConjugateGradient(size_t max_iterations = 1000,
+                                       real_t tolerance = 1.0e-8) noexcept
+      : max_iterations_{max_iterations}, tolerance_{tolerance} {
+    TIT_ASSERT(tolerance_ > 0.0, "Tolerance must be positive!");
+  }
+
+  /// Solve `A * x = b`, starting from the initial guess in @p x.
+  template<std::floating_point Num,
+           linear_operator<Num> Op,
+           preconditioner<Num> Precond = NoPreconditioner>
+  auto operator()(const Op& A,
+                  std::span<const Num> b,
+                  std::span<Num> x,
+                  const Precond& M = {}) const -> SolveResult {
+    TIT_PROFILE_SECTION("ConjugateGradient::operator()");
+    const auto n = A.num_rows();
+    TIT_ASSERT(b.size() == n, "Right hand side size mismatch!");
+    TIT_ASSERT(x.size() == n, "Solution size mismatch!");
+    std::vector<Num> work(4 * n);
+    const auto r = std::span{work}.subspan(0 * n, n);
+    const auto z = std::span{work}.subspan(1 * n, n);
+    const auto p = std::span{work}.subspan(2 * n, n);
+    const auto Ap = std::span{work}.subspan(3 * n, n);
+
+    // Compute the initial residual.
+    const auto b_norm = impl::norm(b);
+    if (b_norm == 0.0) {
+      impl::update(x, [](size_t /*i*/) { return Num{0.0}; });
+      return {.converged = true};
+    }
+    A(std::span<const Num>{x}, Ap);
+    impl::update(r, [b, Ap](size_t i) { return b[i] - Ap[i]; });
+    M(std::span<const Num>{r}, z);
+    impl::update(p, [z](size_t i) { return z[i]; });
+    auto rz = impl::dot<Num>(r, z);
+
+    // Iterate.
+    SolveResult result{.residual = impl::norm<Num>(r) / b_norm};
+    while (result.residual > tolerance_ &&
+           result.num_iterations < max_iterations_) {
+      A(std::span<const Num>{p}, Ap);
+      const auto pAp = impl::dot<Num>(p, Ap);
+      if (pAp == 0.0) break;
+      const auto alpha = rz / pAp;
+      impl::update(x, [alpha, x, p](size_t i) { return x[i] + alpha * p[i]; });
+      impl::update(r, [alpha, r, Ap](size_t i) {
+        return r[i] - alpha * Ap[i];
+      });
+      result.num_iterations += 1;
+      result.residual = impl::norm<Num>(r) / b_norm;
+      M(std::span<const Num>{r}, z);
+      const auto rz_new = impl::dot<Num>(r, z);
+      const auto beta = rz_new / rz;
+      impl::update(p, [beta, z, p](size_t i) { return z[i] + beta * p[i]; });
+      rz = rz_new;
+    }
+    result.converged = result.residual <= tolerance_;
+    return result;
+  }
+
+private:
+
+  size_t max_iterations_;
+  real_t tolerance_;
+
+}; // class ConjugateGradient
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Right-preconditioned stabilized bi-conjugate gradient solver, for the
+/// general non-symmetric operators.
+class BiCGStab final {
+public:
+
+  /// Construct the solver.
+  ///
+  /// @param max_iterations Maximum number of the iterations.
+  /// @param tolerance      Relative tolerance of the residual norm.
+  constexpr explicit BiCGStab(size_t max_iterations = 1000,
+                              real_t tolerance = 1.0e-8) noexcept
+      : max_iterations_{max_iterations}, tolerance_{tolerance} {
+    TIT_ASSERT(tolerance_ > 0.0, "Tolerance must be positive!");
+  }
+
+  /// Solve `A * x = b`, starting from the initial guess in @p x.
+  template<std::floating_point Num,
+           linear_operator<Num> Op,
+           preconditioner<Num> Precond = NoPreconditioner>
+  auto operator()(const Op& A,
+                  std::span<const Num> b,
+                  std::span<Num> x,
+                  const Precond& M = {}) const -> SolveResult {
+    TIT_PROFILE_SECTION("BiCGStab::operator()");
+    const auto n = A.num_rows();
+    TIT_ASSERT(b.size() == n, "Right hand side size mismatch!");
+    TIT_ASSERT(x.size() == n, "Solution size mismatch!");
+    std::vector<Num> work(7 * n, Num{0.0});
+    const auto r = std::span{work}.subspan(0 * n, n);
+    const auto r_hat = std::span{work}.subspan(1 * n, n);
+    const auto p = std::span{work}.subspan(2 * n, n);
+    const auto p_hat = std::span{work}.subspan(3 * n, n);
+    const auto s_hat = std::span{work}.subspan(4 * n, n);
+    const auto v = std::span{work}.subspan(5 * n, n);
+    const auto t = std::span{work}.subspan(6 * n, n);
+
+    // Compute the initial residual. Residual is updated in place, so that it
+    // also holds the intermediate residual `s`.
+    const auto b_norm = impl::norm(b);
+    if (b_norm == 0.0) {
+      impl::update(x, [](size_t /*i*/) { return Num{0.0}; });
+      return {.converged = true};
+    }
+    A(std::span<const Num>{x}, t);
+    impl::update(r, [b, t](size_t i) { return b[i] - t[i]; });
+    impl::update(r_hat, [r](size_t i) { return r[i]; });
+    Num rho{1.0};
+    Num alpha{1.0};
+    Num omega{1.0};
+
+    // Iterate.
+    SolveResult result{.residual = impl::norm<Num>(r) / b_norm};
+    while (result.residual > tolerance_ &&
+           result.num_iterations < max_iterations_) {
+      const auto rho_new = impl::dot<Num>(r_hat, r);
+      if (rho_new == 0.0) break; // Breakdown.
+      const auto beta = (rho_new / rho) * (alpha / omega);
+      impl::update(p, [beta, omega, r, p, v](size_t i) {
+        return r[i] + beta * (p[i] - omega * v[i]);
+      });
+      M(std::span<const Num>{p}, p_hat);
+      A(std::span<const Num>{p_hat}, v);
+      const auto r_hat_v = impl::dot<Num>(r_hat, v);
+      if (r_hat_v == 0.0) break; // Breakdown.
+      alpha = rho_new / r_hat_v;
+      impl::update(r, [alpha, r, v](size_t i) { return r[i] - alpha * v[i]; });
+      result.num_iterations += 1;
+      result.residual = impl::norm<Num>(r) / b_norm;
+      if (result.residual <= tolerance_) {
+        impl::update(x, [alpha, x, p_hat](size_t i) {
+          return x[i] + alpha * p_hat[i];
+        });
+        break;
+      }
+      M(std::span<const Num>{r}, s_hat);
+      A(std::span<const Num>{s_hat}, t);
+      const auto tt = impl::dot<Num>(t, t);
+      omega = tt == 0.0 ? Num{0.0} : impl::dot<Num>(t, r) / tt;
+      impl::update(x, [alpha, omega, x, p_hat, s_hat](size_t i) {
+        return x[i] + alpha * p_hat[i] + omega * s_hat[i];
+      });
+      impl::update(r, [omega, r, t](size_t i) { return r[i] - omega * t[i]; });
+      result.residual = impl::norm<Num>(r) / b_norm;
+      if (omega == 0.0) break; // Breakdown.
+      rho = rho_new;
+    }
+    result.converged = result.residual <= tolerance_;
+    return result;
+  }
+
+private:
+
+  size_t max_iterations_;
+  real_t tolerance_;
+
+}; // class BiCGStab
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::graph
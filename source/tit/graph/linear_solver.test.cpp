@@ -0,0 +1,131 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
+
+#include "tit/graph/graph.hpp"
+#include "tit/graph/linear_solver.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+constexpr size_t NumNodes = 32;
+
+// Path graph, where each node is connected to its predecessor and successor.
+// Self loops are included, to check that they are skipped.
+auto make_path_graph() -> graph::Graph {
+  graph::Graph graph;
+  for (size_t node = 0; node < NumNodes; ++node) {
+    std::vector<size_t> row;
+    if (node > 0) row.push_back(node - 1);
+    row.push_back(node);
+    if (node + 1 < NumNodes) row.push_back(node + 1);
+    graph.append_bucket(row);
+  }
+  return graph;
+}
+
+// Check that the solution satisfies the system.
+template<class Op>
+void check_solution(const Op& A,
+                    const std::vector<double>& b,
+                    const std::vector<double>& x) {
+  std::vector<double> Ax(NumNodes);
+  A(std::span<const double>{x}, std::span{Ax});
+  for (size_t i = 0; i < NumNodes; ++i) CHECK_APPROX_EQ(Ax[i], b[i]);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("graph::GraphOperator") {
+  const auto graph = make_path_graph();
+  const graph::GraphOperator A{graph,
+                               [](size_t /*row*/) { return 2.0; },
+                               [](size_t /*row*/, size_t /*col*/) {
+                                 return -1.0;
+                               }};
+  REQUIRE(A.num_rows() == NumNodes);
+  CHECK(A.diagonal(0) == 2.0);
+  const std::vector<double> x(NumNodes, 1.0);
+  std::vector<double> y(NumNodes);
+  A(std::span<const double>{x}, std::span{y});
+  CHECK(y.front() == 1.0);
+  CHECK(y[NumNodes / 2] == 0.0);
+  CHECK(y.back() == 1.0);
+}
+
+TEST_CASE("graph::ConjugateGradient") {
+  // Discrete 1D Laplacian with the Dirichlet boundaries is symmetric and
+  // positive definite.
+  const auto graph = make_path_graph();
+  const graph::GraphOperator A{graph,
+                               [](size_t row) { return 2.0 + 0.1 * row; },
+                               [](size_t /*row*/, size_t /*col*/) {
+                                 return -1.0;
+                               }};
+  std::vector<double> b(NumNodes);
+  for (size_t i = 0; i < NumNodes; ++i) b[i] = sin(static_cast<double>(i));
+  std::vector<double> x(NumNodes, 0.0);
+  const graph::ConjugateGradient solve{100, 1.0e-12};
+  SUBCASE("no preconditioner") {
+    const auto result = solve(A, std::span<const double>{b}, std::span{x});
+    CHECK(result.converged);
+    CHECK(result.num_iterations <= NumNodes);
+    check_solution(A, b, x);
+  }
+  SUBCASE("Jacobi preconditioner") {
+    const graph::JacobiPreconditioner<double> M{A};
+    const auto result = solve(A, std::span<const double>{b}, std::span{x}, M);
+    CHECK(result.converged);
+    check_solution(A, b, x);
+  }
+  SUBCASE("zero right hand side") {
+    std::ranges::fill(b, 0.0);
+    std::ranges::fill(x, 1.0);
+    const auto result = solve(A, std::span<const double>{b}, std::span{x});
+    CHECK(result.converged);
+    CHECK(result.num_iterations == 0);
+    CHECK(x == std::vector<double>(NumNodes, 0.0));
+  }
+}
+
+TEST_CASE("graph::BiCGStab") {
+  // Discrete 1D convection-diffusion-reaction operator is not symmetric.
+  const auto graph = make_path_graph();
+  const graph::GraphOperator A{graph,
+                               [](size_t /*row*/) { return 2.5; },
+                               [](size_t row, size_t col) {
+                                 return col < row ? -1.5 : -0.5;
+                               }};
+  std::vector<double> b(NumNodes);
+  for (size_t i = 0; i < NumNodes; ++i) b[i] = cos(static_cast<double>(i));
+  std::vector<double> x(NumNodes, 0.0);
+  const graph::BiCGStab solve{200, 1.0e-12};
+  SUBCASE("no preconditioner") {
+    const auto result = solve(A, std::span<const double>{b}, std::span{x});
+    CHECK(result.converged);
+    check_solution(A, b, x);
+  }
+  SUBCASE("Jacobi preconditioner") {
+    const graph::JacobiPreconditioner<double> M{A};
+    const auto result = solve(A, std::span<const double>{b}, std::span{x}, M);
+    CHECK(result.converged);
+    check_solution(A, b, x);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
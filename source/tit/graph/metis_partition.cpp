@@ -0,0 +1,97 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+
+#include <metis.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+
+#include "tit/graph/graph.hpp"
+#include "tit/graph/metis_partition.hpp"
+
+namespace tit::graph::impl {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Converts the range of integers into the METIS index type.
+template<class Int>
+auto to_idx(std::span<const Int> vals) -> std::vector<idx_t> {
+  return {std::begin(vals), std::end(vals)};
+}
+
+} // namespace
+
+void metis_partition(std::span<const size_t> offsets,
+                     std::span<const node_t> neighbors,
+                     std::span<const weight_t> edge_weights,
+                     std::span<const weight_t> node_weights,
+                     std::span<size_t> parts,
+                     size_t num_parts) {
+  TIT_ASSERT(num_parts > 0, "Number of parts must be positive!");
+  TIT_ASSERT(!offsets.empty(), "Offsets must contain at least one element!");
+  TIT_ASSERT(neighbors.size() == edge_weights.size(),
+             "Edge weights size must match the number of neighbors!");
+  TIT_ASSERT(node_weights.size() == parts.size(),
+             "Node weights size must match the number of parts!");
+
+  // METIS does not handle the trivial cases well, so we handle them here.
+  const auto num_nodes = parts.size();
+  if (num_nodes == 0) return;
+  if (num_parts == 1) {
+    std::ranges::fill(parts, 0);
+    return;
+  }
+
+  auto xadj = to_idx(offsets);
+  auto adjncy = to_idx(neighbors);
+  auto adjwgt = to_idx(edge_weights);
+  auto vwgt = to_idx(node_weights);
+  std::vector<idx_t> part(num_nodes);
+  auto nvtxs = static_cast<idx_t>(num_nodes);
+  auto nparts = static_cast<idx_t>(num_parts);
+  idx_t ncon = 1;
+  idx_t objval = 0;
+
+  std::array<idx_t, METIS_NOPTIONS> options{};
+  METIS_SetDefaultOptions(options.data());
+  options[METIS_OPTION_NUMBERING] = 0;
+
+  // Recursive bisection produces better partitions for the small number of
+  // parts, while the k-way partitioning is faster for the large ones.
+  static constexpr size_t MaxRecursiveParts = 8;
+  const auto partition_graph = num_parts <= MaxRecursiveParts ?
+                                   &METIS_PartGraphRecursive :
+                                   &METIS_PartGraphKway;
+  const auto status = partition_graph(&nvtxs,
+                                      &ncon,
+                                      xadj.data(),
+                                      adjncy.data(),
+                                      vwgt.data(),
+                                      /*vsize=*/nullptr,
+                                      adjwgt.data(),
+                                      &nparts,
+                                      /*tpwgts=*/nullptr,
+                                      /*ubvec=*/nullptr,
+                                      options.data(),
+                                      &objval,
+                                      part.data());
+  if (status != METIS_OK) {
+    TIT_THROW("METIS graph partitioning failed with status {}!", status);
+  }
+
+  std::ranges::copy(part, std::begin(parts));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::graph::impl
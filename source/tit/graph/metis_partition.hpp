@@ -0,0 +1,82 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+
+#include "tit/graph/graph.hpp"
+
+namespace tit::graph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace impl {
+
+/// Partition the graph in the compressed sparse row format with METIS.
+void metis_partition(std::span<const size_t> offsets,
+                     std::span<const node_t> neighbors,
+                     std::span<const weight_t> edge_weights,
+                     std::span<const weight_t> node_weights,
+                     std::span<size_t> parts,
+                     size_t num_parts);
+
+} // namespace impl
+
+/// Multilevel graph partitioning function, that uses METIS.
+///
+/// Graph is coarsened by the heavy edge matching, the coarsest graph is
+/// partitioned, and the partitioning is projected back and refined at each
+/// level. Partitions are balanced with respect to the node weights, while
+/// the total weight of the cut edges is minimized.
+struct MetisPartition final {
+  static void operator()(const auto& graph,
+                         const auto& weights,
+                         auto& parts,
+                         size_t num_parts) {
+    TIT_ASSERT(num_parts > 0, "Number of parts must be positive!");
+    const auto num_nodes = graph.num_nodes();
+    TIT_ASSERT(std::size(weights) == num_nodes,
+               "Weights size must match the number of nodes!");
+    TIT_ASSERT(std::size(parts) == num_nodes,
+               "Parts size must match the number of nodes!");
+
+    // Convert the graph into the compressed sparse row format.
+    std::vector<size_t> offsets{0};
+    std::vector<node_t> neighbors;
+    std::vector<weight_t> edge_weights;
+    offsets.reserve(num_nodes + 1);
+    for (node_t node = 0; node < num_nodes; ++node) {
+      for (const auto& [neighbor, weight] : graph[node]) {
+        TIT_ASSERT(neighbor != node, "Self loops are not supported!");
+        neighbors.push_back(neighbor);
+        edge_weights.push_back(weight);
+      }
+      offsets.push_back(neighbors.size());
+    }
+    const std::vector<weight_t> node_weights(std::begin(weights),
+                                             std::end(weights));
+
+    // Partition the graph.
+    std::vector<size_t> graph_parts(num_nodes);
+    impl::metis_partition(offsets,
+                          neighbors,
+                          edge_weights,
+                          node_weights,
+                          graph_parts,
+                          num_parts);
+    std::ranges::copy(graph_parts, std::begin(parts));
+  }
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::graph
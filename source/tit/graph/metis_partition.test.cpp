@@ -0,0 +1,96 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+
+#include "tit/graph/graph.hpp"
+#include "tit/graph/metis_partition.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Build a graph of two cliques, connected with a single light edge.
+auto make_two_cliques() -> graph::WeightedGraph {
+  static constexpr size_t CliqueSize = 4;
+  graph::WeightedGraph graph;
+  for (size_t node = 0; node < 2 * CliqueSize; ++node) {
+    const auto first = node < CliqueSize ? size_t{0} : CliqueSize;
+    std::vector<std::tuple<graph::node_t, graph::weight_t>> edges;
+    if (node == CliqueSize) edges.emplace_back(CliqueSize - 1, 1);
+    for (size_t neighbor = first; neighbor < first + CliqueSize; ++neighbor) {
+      if (neighbor != node) edges.emplace_back(neighbor, 10);
+    }
+    if (node == CliqueSize - 1) edges.emplace_back(CliqueSize, 1);
+    graph.append_bucket(edges);
+  }
+  return graph;
+}
+
+// Build a graph of the `Width x Height` grid.
+template<size_t Width, size_t Height>
+auto make_grid() -> graph::WeightedGraph {
+  graph::WeightedGraph graph;
+  for (size_t j = 0; j < Height; ++j) {
+    for (size_t i = 0; i < Width; ++i) {
+      std::vector<std::tuple<graph::node_t, graph::weight_t>> edges;
+      if (j > 0) edges.emplace_back((j - 1) * Width + i, 1);
+      if (i > 0) edges.emplace_back(j * Width + i - 1, 1);
+      if (i + 1 < Width) edges.emplace_back(j * Width + i + 1, 1);
+      if (j + 1 < Height) edges.emplace_back((j + 1) * Width + i, 1);
+      graph.append_bucket(edges);
+    }
+  }
+  return graph;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("graph::MetisPartition") {
+  SUBCASE("single part") {
+    const auto graph = make_two_cliques();
+    const std::vector<graph::weight_t> weights(graph.num_nodes(), 1);
+    std::vector<size_t> parts(graph.num_nodes(), 1);
+    graph::MetisPartition{}(graph, weights, parts, 1);
+    CHECK(std::ranges::all_of(parts, [](size_t part) { return part == 0; }));
+  }
+  SUBCASE("minimal cut") {
+    // Ensure the light edge is cut, and the cliques are kept intact.
+    const auto graph = make_two_cliques();
+    const std::vector<graph::weight_t> weights(graph.num_nodes(), 1);
+    std::vector<size_t> parts(graph.num_nodes());
+    graph::MetisPartition{}(graph, weights, parts, 2);
+    CHECK(parts[0] != parts[4]);
+    CHECK_RANGE_EQ(parts,
+                   std::vector{parts[0], parts[0], parts[0], parts[0],
+                               parts[4], parts[4], parts[4], parts[4]});
+  }
+  SUBCASE("balance") {
+    // Ensure all the parts are used and have the same weight.
+    const auto graph = make_grid<8, 8>();
+    const std::vector<graph::weight_t> weights(graph.num_nodes(), 1);
+    std::vector<size_t> parts(graph.num_nodes());
+    graph::MetisPartition{}(graph, weights, parts, 4);
+    std::array<size_t, 4> part_sizes{};
+    for (const auto part : parts) {
+      REQUIRE(part < 4);
+      part_sizes[part] += 1;
+    }
+    CHECK_RANGE_EQ(part_sizes, std::array<size_t, 4>{16, 16, 16, 16});
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
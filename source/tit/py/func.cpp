@@ -32,7 +32,7 @@ auto make_func_def(std::string name, CppFuncPtr func) -> PyMethodDef& {
   return defs.emplace_front(PyMethodDef{
       .ml_name = names.emplace_front(std::move(name)).c_str(),
       .ml_meth = std::bit_cast<PyCFunction>(func),
-      .ml_flags = METH_VARARGS | METH_KEYWORDS,
+      .ml_flags = METH_FASTCALL | METH_KEYWORDS,
       .ml_doc = nullptr,
   });
 }
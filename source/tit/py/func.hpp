@@ -10,8 +10,10 @@
 #include <concepts>
 #include <cstddef>
 #include <exception>
+#include <functional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -22,8 +24,9 @@
 
 #include "tit/py/cast.hpp"
 #include "tit/py/error.hpp"
-#include "tit/py/mapping.hpp"
+#include "tit/py/gil.hpp"
 #include "tit/py/object.hpp"
+#include "tit/py/sequence.hpp"
 #include "tit/py/type.hpp"
 
 namespace tit::py {
@@ -89,66 +92,101 @@ concept param_spec = impl::is_param<Param>::value;
 
 namespace impl {
 
+// Compile-time lookup table of the parameter names.
+template<StrLiteral... ParamNames>
+class ParamTable final {
+public:
+
+  // Sentinel index, returned for the unknown names.
+  static constexpr auto npos = sizeof...(ParamNames);
+
+  // Find the index of the parameter by its name.
+  static constexpr auto find(std::string_view name) noexcept -> size_t {
+    const auto iter =
+        std::ranges::lower_bound(entries_, name, {}, &Entry_::name);
+    if (iter == entries_.end() || iter->name != name) return npos;
+    return iter->index;
+  }
+
+private:
+
+  struct Entry_ final {
+    std::string_view name;
+    size_t index;
+  };
+
+  // Parameter names, sorted for the binary search.
+  static constexpr auto entries_ = [] {
+    size_t index = 0;
+    std::array<Entry_, sizeof...(ParamNames)> result{
+        Entry_{CStrView{ParamNames}, index++}...};
+    std::ranges::sort(result, {}, &Entry_::name);
+    return result;
+  }();
+
+}; // class ParamTable
+
 // Count the number of arguments.
-inline auto count_args(PyObject* posargs, PyObject* kwargs) -> size_t {
-  TIT_ASSERT(posargs != nullptr, "Positional arguments must not be null!");
-  auto result = len(borrow<Tuple>(posargs));
-  if (kwargs != nullptr) result += len(borrow<Dict>(kwargs));
+inline auto count_args(size_t num_posargs, PyObject* kwnames) -> size_t {
+  auto result = num_posargs;
+  if (kwnames != nullptr) result += len(borrow<Tuple>(kwnames));
   return result;
 }
 
-// Unpack the variadic and keyword arguments into an array.
+// Unpack the positional and keyword arguments of a vectorcall into an array.
+// Keyword argument values follow the positional ones, and their names are
+// stored in a separate tuple.
 template<StrLiteral... ParamNames>
-auto unpack_args(PyObject* posargs, PyObject* kwargs)
-    -> std::array<Object, sizeof...(ParamNames)> {
+auto unpack_args(PyObject* const* args, size_t num_posargs, PyObject* kwnames)
+    -> std::array<PyObject*, sizeof...(ParamNames)> {
   static constexpr auto num_params = sizeof...(ParamNames);
-  std::array<Object, num_params> result;
+  std::array<PyObject*, num_params> result{};
 
   // Parse positional arguments.
-  TIT_ASSERT(posargs != nullptr, "Positional arguments must not be null!");
-  const auto posargs_ = borrow<Tuple>(posargs);
-  const auto num_posargs = len(posargs_);
   if (num_posargs > num_params) {
     raise_type_error("function takes at most {} arguments ({} given)",
                      num_params,
-                     count_args(posargs, kwargs));
+                     count_args(num_posargs, kwnames));
   }
-  for (size_t i = 0; i < num_posargs; ++i) result[i] = posargs_[i];
+  TIT_ASSERT(num_posargs == 0 || args != nullptr,
+             "Positional arguments must not be null!");
+  std::copy_n(args, num_posargs, result.begin());
 
   // Parse keyword arguments.
-  static constexpr auto param_names = std::to_array<CStrView>({ParamNames...});
-  if (kwargs != nullptr) {
-    const auto kwargs_ = borrow<Dict>(kwargs);
-    kwargs_.for_each([&result](const Object& arg_name, const Object& arg_val) {
-      const auto arg_name_str = extract<CStrView>(arg_name);
-      const auto param_iter = std::ranges::find(param_names, arg_name_str);
-      if (param_iter == param_names.end()) {
-        raise_type_error("unexpected argument '{}'", arg_name_str);
+  if (kwnames != nullptr) {
+    const auto kwnames_ = borrow<Tuple>(kwnames);
+    const auto num_kwargs = len(kwnames_);
+    for (size_t i = 0; i < num_kwargs; ++i) {
+      const auto arg_name = extract<CStrView>(kwnames_[i]);
+      using Table = ParamTable<ParamNames...>;
+      const auto param_index = Table::find(arg_name);
+      if (param_index == Table::npos) {
+        raise_type_error("unexpected argument '{}'", arg_name);
       }
-      const auto param_index = std::distance(param_names.begin(), param_iter);
-      if (result[param_index].valid()) {
-        raise_type_error("duplicate argument '{}'", arg_name_str);
+      if (result[param_index] != nullptr) {
+        raise_type_error("duplicate argument '{}'", arg_name);
       }
-      result[param_index] = arg_val;
-    });
+      result[param_index] = args[num_posargs + i];
+    }
   }
 
   return result;
 }
 template<>
-inline auto unpack_args(PyObject* posargs, PyObject* kwargs)
-    -> std::array<Object, 0> {
-  if (const auto num_args = count_args(posargs, kwargs); num_args > 0) {
+inline auto unpack_args(PyObject* const* /*args*/,
+                        size_t num_posargs,
+                        PyObject* kwnames) -> std::array<PyObject*, 0> {
+  if (const auto num_args = count_args(num_posargs, kwnames); num_args > 0) {
     raise_type_error("function takes no arguments ({} given)", num_args);
   }
-  return std::array<Object, 0>{};
+  return std::array<PyObject*, 0>{};
 }
 
 // Parse a single argument.
 template<param_spec Param>
-auto parse_single_arg(const Object& arg) {
+auto parse_single_arg(PyObject* arg) {
   // Fill the default argument value.
-  if (!arg.valid()) {
+  if (arg == nullptr) {
     if constexpr (Param::default_ == nullptr) {
       raise_type_error("missing argument '{}'", Param::name);
     }
@@ -158,7 +196,7 @@ auto parse_single_arg(const Object& arg) {
   // Extract the argument value.
   try {
     using ParamType = typename Param::type;
-    return ParamType{extract<ParamType>(arg)};
+    return ParamType{extract<ParamType>(borrow(arg))};
   } catch (ErrorException& e) {
     e.prefix_message("argument '{}'", Param::name);
     throw;
@@ -167,9 +205,10 @@ auto parse_single_arg(const Object& arg) {
 
 // Parse the function arguments.
 template<param_spec... Params>
-auto parse_args(PyObject* posargs, PyObject* kwargs) {
+auto parse_args(PyObject* const* args, size_t num_posargs, PyObject* kwnames) {
   // Parse the arguments into an array, and then unpack it into a tuple.
-  const auto unpacked_args = unpack_args<Params::name...>(posargs, kwargs);
+  const auto unpacked_args =
+      unpack_args<Params::name...>(args, num_posargs, kwnames);
   return [&]<size_t... Is>(std::index_sequence<Is...> /*indices*/) {
     return std::tuple{parse_single_arg<Params>(unpacked_args[Is])...};
   }(std::make_index_sequence<sizeof...(Params)>{});
@@ -215,20 +254,55 @@ template<auto Func, class... Params>
 concept func_spec = (param_spec<Params> && ...) &&
                     (std::invocable<decltype(Func), typename Params::type...>);
 
-/// C++ function pointer.
-using CppFuncPtr = PyObject* (*) (PyObject*, PyObject*, PyObject*);
+/// Function wrapper, that calls the function with the Python GIL released.
+///
+/// Arguments are converted before the GIL is released, and the result is
+/// converted after it is reacquired. The function itself must not touch any
+/// Python objects, so it can neither accept nor return them.
+template<auto Func>
+struct WithoutGIL final {
+  template<class... Args>
+    requires std::invocable<decltype(Func), Args...>
+  auto operator()(Args&&... args) const -> decltype(auto) {
+    static_assert(
+        !(std::derived_from<std::remove_cvref_t<Args>, Object> || ...),
+        "Function without the GIL must not accept Python objects!");
+    using Result = std::invoke_result_t<decltype(Func), Args...>;
+    static_assert(!std::derived_from<std::remove_cvref_t<Result>, Object>,
+                  "Function without the GIL must not return Python objects!");
+    const ReleaseGIL release_gil{};
+    return std::invoke(Func, std::forward<Args>(args)...);
+  }
+};
+
+/// Release the Python GIL while the function is called, see `WithoutGIL`.
+/// For example, `make_func<"run", without_gil<&run>, Param<size_t, "n">>()`.
+template<auto Func>
+inline constexpr WithoutGIL<Func> without_gil{};
+
+/// C++ function pointer, that follows the vectorcall calling convention:
+/// `self`, the argument array, the number of the positional arguments, and
+/// the tuple of the keyword argument names.
+using CppFuncPtr = PyObject* (*) (PyObject*, PyObject* const*, ssize_t,
+                                  PyObject*);
 
 /// Make a Python function pointer.
 template<StrLiteral Name, auto Func, param_spec... Params>
   requires func_spec<Func, Params...>
 consteval auto make_func_ptr() noexcept -> CppFuncPtr {
-  return [](PyObject* self, PyObject* posargs, PyObject* kwargs) -> PyObject* {
+  return [](PyObject* self,
+            PyObject* const* args,
+            ssize_t nargs,
+            PyObject* kwnames) -> PyObject* {
     TIT_ASSERT(self == nullptr, "`self` must be null for a function!");
-    return impl::translate_exceptions<nullptr>([posargs, kwargs]() {
+    TIT_ASSERT(nargs >= 0, "Number of arguments must be non-negative!");
+    return impl::translate_exceptions<nullptr>([args, nargs, kwnames]() {
       // Parse the arguments.
-      auto args = [posargs, kwargs] {
+      auto parsed_args = [args, nargs, kwnames] {
         try {
-          return impl::parse_args<Params...>(posargs, kwargs);
+          return impl::parse_args<Params...>(args,
+                                             static_cast<size_t>(nargs),
+                                             kwnames);
         } catch (ErrorException& e) {
           e.prefix_message("function '{}'", Name);
           throw;
@@ -236,7 +310,7 @@ consteval auto make_func_ptr() noexcept -> CppFuncPtr {
       }();
 
       // Call the function.
-      return impl::call_func<Func>(std::move(args)).release();
+      return impl::call_func<Func>(std::move(parsed_args)).release();
     });
   };
 }
@@ -5,9 +5,12 @@
 
 #include <filesystem>
 #include <string>
+#include <thread>
 
+#include "tit/py/cast.hpp"
 #include "tit/py/error.hpp"
 #include "tit/py/func.hpp"
+#include "tit/py/gil.hpp"
 #include "tit/py/number.hpp"
 #include "tit/py/object.hpp"
 
@@ -20,6 +23,16 @@ namespace {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+// Extract the value in another thread, which would deadlock if GIL is held.
+auto extract_in_thread(int a) -> int {
+  int result = 0;
+  std::jthread{[a, &result] {
+    const py::AcquireGIL acquire_gil{};
+    result = py::extract<int>(py::Int{a});
+  }}.join();
+  return result;
+}
+
 TEST_CASE("py::CFunction") {
   SUBCASE("typing") {
     CHECK(py::CFunction::type().fully_qualified_name() ==
@@ -109,6 +122,7 @@ TEST_CASE("py::CFunction") {
         CHECK(func(1, 3) == py::Int{7});
         CHECK(func(1, 3, 4) == py::Int{8});
         CHECK(func(1, py::kwarg("c", 4)) == py::Int{7});
+        CHECK(func(py::kwarg("c", 4), py::kwarg("a", 1)) == py::Int{7});
       }
       SUBCASE("failure") {
         SUBCASE("missing argument") {
@@ -118,6 +132,12 @@ TEST_CASE("py::CFunction") {
         }
       }
     }
+    SUBCASE("without GIL") {
+      const auto func = py::make_func<"func",
+                                      py::without_gil<&extract_in_thread>,
+                                      py::Param<int, "a">>();
+      CHECK(func(1) == py::Int{1});
+    }
   }
   SUBCASE("exceptions") {
     SUBCASE("assertion error") {
@@ -106,6 +106,28 @@ auto dedent(CStrView str) -> std::string {
   return extract<std::string>(result);
 }
 
+// Evaluate the Python expression within the given globals.
+auto eval_in(const Dict& globals, CStrView expr) -> Object {
+  return steal(ensure(PyRun_String(dedent(expr).c_str(),
+                                   /*start=*/Py_eval_input,
+                                   /*globals=*/globals.get(),
+                                   /*locals=*/globals.get())));
+}
+
+// Execute the Python statement within the given globals.
+auto exec_in(const Dict& globals, CStrView stmt) -> bool {
+  auto* const result = PyRun_String(dedent(stmt).c_str(),
+                                    /*start=*/Py_file_input,
+                                    /*globals=*/globals.get(),
+                                    /*locals=*/globals.get());
+  if (result == nullptr) {
+    PyErr_Print();
+    return false;
+  }
+  Py_DECREF(result);
+  return true;
+}
+
 } // namespace
 
 Interpreter::Interpreter(Config config)
@@ -138,23 +160,11 @@ auto Interpreter::globals() const -> const Dict& {
 }
 
 auto Interpreter::eval(CStrView expr) const -> Object {
-  return steal(ensure(PyRun_String(dedent(expr).c_str(),
-                                   /*start=*/Py_eval_input,
-                                   /*globals=*/globals_.get(),
-                                   /*locals=*/globals_.get())));
+  return eval_in(globals_, expr);
 }
 
 auto Interpreter::exec(CStrView stmt) const -> bool {
-  auto* const result = PyRun_String(dedent(stmt).c_str(),
-                                    /*start=*/Py_file_input,
-                                    /*globals=*/globals_.get(),
-                                    /*locals=*/globals_.get());
-  if (result == nullptr) {
-    PyErr_Print();
-    return false;
-  }
-  Py_DECREF(result);
-  return true;
+  return exec_in(globals_, stmt);
 }
 
 auto Interpreter::exec_file(CStrView file_name) const -> bool {
@@ -204,6 +214,80 @@ void Interpreter::stop_coverage_report_() const {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+auto SubInterpreter::supported() noexcept -> bool {
+  return PY_VERSION_HEX >= 0x030C0000;
+}
+
+SubInterpreter::SubInterpreter() {
+#if PY_VERSION_HEX >= 0x030C0000
+  TIT_ASSERT(PyGILState_Check() != 0, "GIL must be held!");
+  auto* const parent_state = PyThreadState_Get();
+
+  // Create the interpreter. On success, it becomes current for the calling
+  // thread, with its own GIL held.
+  const PyInterpreterConfig config{
+      .use_main_obmalloc = 0,
+      .allow_fork = 0,
+      .allow_exec = 0,
+      .allow_threads = 1,
+      .allow_daemon_threads = 0,
+      .check_multi_interp_extensions = 1,
+      .gil = PyInterpreterConfig_OWN_GIL,
+  };
+  const auto status = Py_NewInterpreterFromConfig(&state_, &config);
+  if (PyStatus_IsError(status) != 0) {
+    TIT_THROW("Failed to initialize Python subinterpreter: {}: {}.",
+              status.func,
+              status.err_msg);
+  }
+  try {
+    globals_ = import_("__main__").dict();
+  } catch (...) {
+    Py_EndInterpreter(state_);
+    PyThreadState_Swap(parent_state);
+    throw;
+  }
+
+  // Switch back to the main interpreter.
+  PyThreadState_Swap(parent_state);
+#else
+  TIT_THROW("Python subinterpreters require Python 3.12 or newer.");
+#endif
+}
+
+SubInterpreter::~SubInterpreter() {
+  PyEval_RestoreThread(state_);
+  globals_ = {};
+  Py_EndInterpreter(state_);
+}
+
+auto SubInterpreter::globals() const -> const Dict& {
+  TIT_ASSERT(PyThreadState_Get() == state_, "Subinterpreter is not entered!");
+  return globals_;
+}
+
+auto SubInterpreter::eval(CStrView expr) const -> Object {
+  return eval_in(globals(), expr);
+}
+
+auto SubInterpreter::exec(CStrView stmt) const -> bool {
+  return exec_in(globals(), stmt);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+EnterInterpreter::EnterInterpreter(const SubInterpreter& interpreter)
+    : state_{interpreter.state_} {
+  TIT_ASSERT(state_ != nullptr, "Subinterpreter is not initialized!");
+  PyEval_RestoreThread(state_);
+}
+
+EnterInterpreter::~EnterInterpreter() noexcept {
+  PyEval_SaveThread();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 // NOLINTEND(*-include-cleaner)
 
 } // namespace tit::py::embed
@@ -15,6 +15,7 @@
 #include "tit/py/object.hpp"
 
 struct PyConfig; // Not available under limited API.
+using PyThreadState = struct _ts; // NOLINT(*-reserved-identifier, cert-*)
 
 namespace tit::py::embed {
 
@@ -115,4 +116,68 @@ private:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Embedded Python subinterpreter with its own GIL.
+///
+/// Subinterpreters run in parallel with the main interpreter and with each
+/// other. Only the extension modules that support the per-interpreter GIL
+/// can be imported in them. Requires Python 3.12 or newer.
+class SubInterpreter final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(SubInterpreter);
+
+  /// Are the subinterpreters supported by the Python version?
+  static auto supported() noexcept -> bool;
+
+  /// Construct the subinterpreter. Calling thread must hold the GIL of the
+  /// main interpreter, which is held again once the construction is done.
+  SubInterpreter();
+
+  /// Destroy the subinterpreter. Calling thread must not hold any GIL.
+  ~SubInterpreter();
+
+  /// Get the global variables.
+  /// Subinterpreter must be entered by the calling thread.
+  auto globals() const -> const Dict&;
+
+  /// Evaluate the Python expression.
+  /// Subinterpreter must be entered by the calling thread.
+  /// If evaluation fails, an exception is thrown.
+  auto eval(CStrView expr) const -> Object;
+
+  /// Execute the Python statement.
+  /// Subinterpreter must be entered by the calling thread.
+  /// If execution fails, an error is printed and `false` is returned.
+  auto exec(CStrView stmt) const -> bool;
+
+private:
+
+  friend class EnterInterpreter;
+
+  PyThreadState* state_ = nullptr;
+  Dict globals_;
+
+}; // class SubInterpreter
+
+/// Enter the Python subinterpreter for the current scope: acquire its GIL,
+/// and make it current for the calling thread.
+class EnterInterpreter final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(EnterInterpreter);
+
+  /// Enter the subinterpreter. Calling thread must not hold any GIL.
+  explicit EnterInterpreter(const SubInterpreter& interpreter);
+
+  /// Leave the subinterpreter.
+  ~EnterInterpreter() noexcept;
+
+private:
+
+  PyThreadState* state_;
+
+}; // class EnterInterpreter
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::py::embed
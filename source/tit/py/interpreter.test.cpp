@@ -5,11 +5,14 @@
 
 #include <filesystem>
 #include <fstream>
+#include <optional>
 
 #include "tit/core/exception.hpp"
 
 #include "tit/py/cast.hpp"
 #include "tit/py/error.hpp"
+#include "tit/py/gil.hpp"
+#include "tit/py/interpreter.hpp"
 
 #include "tit/py/interpreter.testing.hpp"
 #include "tit/testing/test.hpp"
@@ -75,5 +78,23 @@ TEST_CASE("py::embed::Interpreter::exec_file") {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE("py::embed::SubInterpreter") {
+  if (!py::embed::SubInterpreter::supported()) return;
+  std::optional<py::embed::SubInterpreter> sub_interpreter;
+  sub_interpreter.emplace();
+  CHECK(testing::interpreter().exec("import sys"));
+  const py::ReleaseGIL release_gil{};
+  {
+    const py::embed::EnterInterpreter enter{*sub_interpreter};
+    CHECK(sub_interpreter->exec("x = 1"));
+    CHECK(extract<int>(sub_interpreter->eval("x + 2")) == 3);
+    // Globals of the subinterpreter are separate from the main ones.
+    CHECK(extract<bool>(sub_interpreter->eval("'sys' not in globals()")));
+  }
+  sub_interpreter.reset();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
@@ -4,12 +4,15 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 #include <algorithm> // IWYU pragma: keep
+#include <array>
+#include <bit>
 #include <functional>
 #include <span>
 #include <utility>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/simd.hpp"
 #include "tit/core/utils.hpp"
 
 #include "tit/py/_python.hpp"
@@ -49,7 +52,12 @@ auto data_kind_to_numpy(data::DataKind kind) -> NPY_TYPES {
       .option(data::kind_of<unsigned long long>, NPY_ULONGLONG)
       .option(data::kind_of<float>, NPY_FLOAT)
       .option(data::kind_of<double>, NPY_DOUBLE)
-      .option(data::kind_of<long double>, NPY_LONGDOUBLE);
+      .option(data::kind_of<long double>, NPY_LONGDOUBLE)
+      .option(data::kind_of<simd::float16_t>, NPY_HALF)
+      .fallback([](data::DataKind k) {
+        // Note: NumPy has no `bfloat16` type.
+        raise_type_error("Data kind '{}' has no NumPy type.", k.name());
+      });
 }
 
 // Construct a data kind from NumPy type.
@@ -68,6 +76,7 @@ auto data_kind_from_numpy(NPY_TYPES dtype) -> data::DataKind {
       .option(NPY_FLOAT, data::kind_of<float>)
       .option(NPY_DOUBLE, data::kind_of<double>)
       .option(NPY_LONGDOUBLE, data::kind_of<long double>)
+      .option(NPY_HALF, data::kind_of<simd::float16_t>)
       .fallback([](NPY_TYPES t) {
         raise_type_error("Unsupported NumPy type '{}'.", std::to_underlying(t));
       });
@@ -103,6 +112,35 @@ NDArray::NDArray(data::DataKind kind,
       data)));
 }
 
+NDArray::NDArray(data::DataType type, std::span<const byte_t> bytes)
+    : NDArray{[type, bytes] {
+      TIT_ASSERT(bytes.size() % type.width() == 0, "Invalid number of bytes!");
+      std::array<size_t, 3> shape{bytes.size() / type.width(),
+                                  type.dim(),
+                                  type.dim()};
+      const auto rank = 1 + std::to_underlying(type.rank());
+      return NDArray{type.kind(),
+                     const_cast<byte_t*>(bytes.data()),
+                     bytes.size(),
+                     std::span{shape}.first(rank)};
+    }()} {}
+
+NDArray::NDArray(const Layout_& layout) {
+  TIT_ASSERT(layout.shape[0] == 0 || layout.data != nullptr,
+             "Invalid data pointer!");
+  ensure_numpy_imported();
+  reset(ensure(PyArray_New( //
+      &PyArray_Type,
+      static_cast<int>(layout.rank),
+      std::bit_cast<const ssize_t*>(layout.shape.data()),
+      data_kind_to_numpy(layout.kind),
+      layout.strides.data(),
+      layout.data,
+      /*itemsize=*/0,
+      NPY_ARRAY_ALIGNED | NPY_ARRAY_WRITEABLE,
+      /*obj=*/nullptr)));
+}
+
 auto NDArray::get_array() const -> PyArrayObject* {
   return std::bit_cast<PyArrayObject*>(get());
 }
@@ -119,6 +157,24 @@ auto NDArray::kind() const -> data::DataKind {
   return data_kind_from_numpy(ensure<NPY_TYPES>(PyArray_TYPE(get_array())));
 }
 
+auto NDArray::is_contiguous() const -> bool {
+  return PyArray_IS_C_CONTIGUOUS(get_array());
+}
+
+auto NDArray::data() const -> std::span<byte_t> {
+  TIT_ASSERT(is_contiguous(), "Array must be contiguous!");
+  return std::span{ensure<byte_t*>(PyArray_BYTES(get_array())),
+                   ensure<size_t>(PyArray_NBYTES(get_array()))};
+}
+
+auto NDArray::writeable() const -> bool {
+  return PyArray_ISWRITEABLE(get_array());
+}
+void NDArray::set_writeable(bool writeable) const {
+  if (writeable) PyArray_ENABLEFLAGS(get_array(), NPY_ARRAY_WRITEABLE);
+  else PyArray_CLEARFLAGS(get_array(), NPY_ARRAY_WRITEABLE);
+}
+
 auto NDArray::elem(std::span<const ssize_t> mdindex) const
     -> std::span<byte_t> {
   TIT_ASSERT(mdindex.size() == rank(), "Invalid index size!");
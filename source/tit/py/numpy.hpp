@@ -6,9 +6,12 @@
 #pragma once
 
 #include <array>
+#include <bit>
 #include <concepts>
 #include <memory>
+#include <ranges>
 #include <span>
+#include <type_traits>
 #include <utility>
 
 #include "tit/core/basic_types.hpp"
@@ -48,6 +51,37 @@ public:
     set_base(Capsule{std::make_unique<Mdvector<Val, Rank>>(std::move(mdvec))});
   }
 
+  /// Create a NumPy array that refers to the existing values, without copying.
+  ///
+  /// Vector and matrix values are exposed as the trailing axes of the array,
+  /// so the shape is `(N,)`, `(N, Dim)` or `(N, Dim, Dim)`. Padding of the
+  /// SIMD vector layouts is skipped with the strides, so such arrays are not
+  /// contiguous. The @p base object must keep the values alive, it is
+  /// referenced by the array until the array is destroyed. Array over the
+  /// constant values is not writeable.
+  template<data::known_type_of Val>
+  NDArray(std::span<Val> vals, Object base) : NDArray{layout_(vals)} {
+    if constexpr (std::is_const_v<Val>) set_writeable(false);
+    set_base(std::move(base));
+  }
+
+  /// Create a NumPy array that refers to the bytes of the buffer, without
+  /// copying.
+  ///
+  /// Buffer is moved into the array base, for example, a decompressed data
+  /// array or a memory mapping of the external array payload could be passed
+  /// here. Buffer must contain a whole number of values of type @p type.
+  /// Array is writeable only if the buffer is.
+  template<class Buffer>
+    requires std::ranges::contiguous_range<const Buffer&> ||
+             requires (const Buffer& buffer) {
+               {
+                 buffer.data()
+               } -> std::convertible_to<std::span<const byte_t>>;
+             }
+  NDArray(data::DataType type, Buffer buffer)
+      : NDArray{type, std::make_unique<Buffer>(std::move(buffer))} {}
+
   /// Get pointer to the object as `PyArrayObject*`.
   auto get_array() const -> PyArrayObject*;
 
@@ -60,6 +94,18 @@ public:
   /// Get the array data kind.
   auto kind() const -> data::DataKind;
 
+  /// Check if the array data is stored contiguously, in the row-major order.
+  auto is_contiguous() const -> bool;
+
+  /// Get the array data. Array must be contiguous.
+  auto data() const -> std::span<byte_t>;
+
+  /// Check if the array data can be modified.
+  /// @{
+  auto writeable() const -> bool;
+  void set_writeable(bool writeable) const;
+  /// @}
+
   /// Get the array element at the given index.
   /// @{
   auto elem(std::span<const ssize_t> mdindex) const -> std::span<byte_t>;
@@ -92,6 +138,64 @@ private:
           size_t num_bytes,
           std::span<const size_t> shape);
 
+  // Create a new NumPy array of values of the given type from raw bytes.
+  NDArray(data::DataType type, std::span<const byte_t> bytes);
+
+  // Layout of the strided array.
+  struct Layout_ {
+    data::DataKind kind;
+    byte_t* data;
+    size_t rank;
+    std::array<size_t, 3> shape;
+    std::array<ssize_t, 3> strides;
+  };
+
+  // Create a new NumPy array with the given layout from a raw pointer.
+  explicit NDArray(const Layout_& layout);
+
+  // Get the layout of the values. Rows of the matrices are vectors, so
+  // strides of both are multiples of the vector size.
+  template<class Val>
+  static auto layout_(std::span<Val> vals) -> Layout_ {
+    using Value = std::remove_const_t<Val>;
+    constexpr auto type = data::type_of<Value>;
+    constexpr auto width = static_cast<ssize_t>(type.kind().width());
+    constexpr auto dim = static_cast<ssize_t>(type.dim());
+    constexpr auto elem_stride = static_cast<ssize_t>(sizeof(Value));
+    Layout_ layout{
+        .kind = type.kind(),
+        // NOLINTNEXTLINE(*-const-cast)
+        .data = const_cast<byte_t*>(std::bit_cast<const byte_t*>(vals.data())),
+        .rank = 1 + std::to_underlying(type.rank()),
+        .shape = {vals.size(), type.dim(), type.dim()},
+        .strides = {elem_stride, width, width},
+    };
+    if constexpr (type.rank() == data::DataRank::matrix) {
+      layout.strides[1] = elem_stride / dim;
+    }
+    return layout;
+  }
+
+  // Create a new NumPy array that owns the buffer.
+  template<class Buffer>
+  NDArray(data::DataType type, std::unique_ptr<Buffer> buffer)
+      : NDArray{type, buffer_bytes_(*buffer)} {
+    if constexpr (!std::ranges::output_range<Buffer&, byte_t>) {
+      set_writeable(false);
+    }
+    set_base(Capsule{std::move(buffer)});
+  }
+
+  // Get the bytes of the buffer.
+  template<class Buffer>
+  static auto buffer_bytes_(const Buffer& buffer) -> std::span<const byte_t> {
+    if constexpr (std::ranges::contiguous_range<const Buffer&>) {
+      return std::as_bytes(std::span{buffer});
+    } else {
+      return buffer.data();
+    }
+  }
+
 }; // class NDArray
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -3,10 +3,18 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <span>
+#include <utility>
+#include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/containers/mdvector.hpp"
+#include "tit/core/mat.hpp"
+#include "tit/core/simd.hpp"
+#include "tit/core/vec.hpp"
 
 #include "tit/data/type.hpp"
 
@@ -42,6 +50,80 @@ TEST_CASE("py::NDArray") {
       CHECK(array.elem<double>(1, 1) == 4.0);
       CHECK(py::Capsule::isinstance(array.base()));
     }
+    SUBCASE("from span") {
+      std::array vals{1.0, 2.0, 3.0};
+      const py::NDArray array{std::span{vals}, py::None()};
+      REQUIRE(array.rank() == 1);
+      REQUIRE_RANGE_EQ(array.shape(), {3});
+      CHECK(array.writeable());
+      array.elem<double>(1) = 4.0;
+      CHECK(vals[1] == 4.0);
+      CHECK(array.is_contiguous());
+      CHECK(array.data().data() == std::bit_cast<byte_t*>(vals.data()));
+      CHECK(array.data().size() == sizeof(vals));
+      CHECK(array.base() == py::None());
+    }
+    SUBCASE("from span of constant vectors") {
+      const std::array vals{Vec{1.0, 2.0}, Vec{3.0, 4.0}, Vec{5.0, 6.0}};
+      const py::NDArray array{std::span{vals}, py::None()};
+      REQUIRE(array.rank() == 2);
+      REQUIRE_RANGE_EQ(array.shape(), {3, 2});
+      CHECK(array.elem<double>(1, 0) == 3.0);
+      CHECK(array.elem<double>(2, 1) == 6.0);
+      CHECK_FALSE(array.writeable());
+      CHECK_THROWS_MSG((array[0, 0] = py::Float{7.0}),
+                       py::ErrorException,
+                       "ValueError: assignment destination is read-only");
+    }
+    SUBCASE("from span of padded vectors") {
+      // Padding of the vectors is skipped with the strides.
+      std::array vals{Vec{1.0, 2.0, 3.0}, Vec{4.0, 5.0, 6.0}};
+      const py::NDArray array{std::span{vals}, py::None()};
+      REQUIRE(array.rank() == 2);
+      REQUIRE_RANGE_EQ(array.shape(), {2, 3});
+      CHECK(array.elem<double>(0, 2) == 3.0);
+      CHECK(array.elem<double>(1, 0) == 4.0);
+      array.elem<double>(1, 2) = 7.0;
+      CHECK(vals[1][2] == 7.0);
+      CHECK(array.is_contiguous() == (sizeof(vals[0]) == 3 * sizeof(double)));
+    }
+    SUBCASE("from span of matrices") {
+      const std::array vals{Mat{{1.0, 2.0}, {3.0, 4.0}},
+                            Mat{{5.0, 6.0}, {7.0, 8.0}}};
+      const py::NDArray array{std::span{vals}, py::None()};
+      REQUIRE(array.rank() == 3);
+      REQUIRE_RANGE_EQ(array.shape(), {2, 2, 2});
+      CHECK(array.elem<double>(0, 0, 1) == 2.0);
+      CHECK(array.elem<double>(0, 1, 0) == 3.0);
+      CHECK(array.elem<double>(1, 1, 1) == 8.0);
+      CHECK_FALSE(array.writeable());
+    }
+    SUBCASE("from buffer") {
+      std::vector<byte_t> bytes(4 * sizeof(int));
+      std::ranges::copy(std::as_bytes(std::span{std::array{1, 2, 3, 4}}),
+                        bytes.begin());
+      const auto* const data = bytes.data();
+      const py::NDArray array{data::type_of<int>, std::move(bytes)};
+      REQUIRE(array.rank() == 1);
+      REQUIRE_RANGE_EQ(array.shape(), {4});
+      CHECK(array.elem(std::to_array<ssize_t>({0})).data() == data);
+      CHECK(array.elem<int>(3) == 4);
+      CHECK(array.writeable());
+      CHECK(py::Capsule::isinstance(array.base()));
+    }
+    SUBCASE("from buffer of 16-bit floats") {
+      // Half-precision floats map to `numpy.float16`, and brain floats have
+      // no NumPy type at all.
+      const py::NDArray array{data::type_of<simd::float16_t>,
+                              std::vector<byte_t>(2 * sizeof(uint16_t))};
+      REQUIRE_RANGE_EQ(array.shape(), {2});
+      CHECK(array.kind() == data::kind_of<simd::float16_t>);
+      CHECK_THROWS_MSG(
+          (py::NDArray{data::type_of<simd::bfloat16_t>,
+                       std::vector<byte_t>(2 * sizeof(uint16_t))}),
+          py::ErrorException,
+          "TypeError: Data kind 'bfloat16_t' has no NumPy type.");
+    }
   }
   SUBCASE("data access") {
     const std::array vals{1, 2, 3, 4, 5, 6, 7, 8};
@@ -0,0 +1,466 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <concepts>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/mat.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/type_utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Projection of a fixed particle onto the walls.
+template<class Vec>
+struct BoundaryProjection final {
+  Vec mirror;                ///< Mirror image of the point across the wall.
+  Vec normal;                ///< Wall normal, directed towards the point.
+  vec_num_t<Vec> dist = 0.0; ///< Distance between the point and its mirror.
+};
+
+/// Walls geometry type.
+template<class Walls>
+concept wall_geometry =
+    requires(const Walls& walls, const typename Walls::Point& point) {
+      {
+        walls.project(point)
+      } -> std::same_as<BoundaryProjection<typename Walls::Point>>;
+    };
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Walls of a box-shaped domain, the fluid is inside of the box.
+template<class Vec>
+class BoxWalls final {
+public:
+
+  /// Point type.
+  using Point = Vec;
+
+  /// Construct the box walls.
+  constexpr explicit BoxWalls(geom::BBox<Vec> box) noexcept
+      : box_{std::move(box)} {}
+
+  /// Box, that is occupied by the fluid.
+  constexpr auto box() const noexcept -> const geom::BBox<Vec>& {
+    return box_;
+  }
+
+  /// Project the point onto the closest wall.
+  constexpr auto project(const Vec& point) const -> BoundaryProjection<Vec> {
+    const auto point_on_wall = box_.clamp(point);
+    const auto mirror = 2 * point_on_wall - point;
+    return {.mirror = mirror,
+            .normal = normalize(point - point_on_wall),
+            .dist = norm(mirror - point)};
+  }
+
+private:
+
+  geom::BBox<Vec> box_;
+
+}; // class BoxWalls
+
+/// Walls defined by a signed distance function, that is negative inside of
+/// the fluid and positive inside of the walls.
+template<class Vec, std::regular_invocable<const Vec&> SDF>
+class SDFWalls final {
+public:
+
+  /// Point type.
+  using Point = Vec;
+
+  /// Numeric type.
+  using Num = vec_num_t<Vec>;
+
+  /// Construct the walls.
+  ///
+  /// @param sdf Signed distance function.
+  /// @param eps Step of the finite differences, used to compute the normal.
+  constexpr explicit SDFWalls(SDF sdf, Num eps) noexcept
+      : sdf_{std::move(sdf)}, eps_{eps} {
+    TIT_ASSERT(eps_ > 0.0, "Finite difference step must be positive!");
+  }
+
+  /// Project the point onto the closest wall.
+  constexpr auto project(const Vec& point) const -> BoundaryProjection<Vec> {
+    // Compute the normal as the normalized gradient of the distance.
+    Vec grad{};
+    for (size_t i = 0; i < vec_dim_v<Vec>; ++i) {
+      Vec delta{};
+      delta[i] = eps_;
+      grad[i] = sdf_(point + delta) - sdf_(point - delta);
+    }
+    const auto normal = normalize(grad);
+    const auto dist = static_cast<Num>(sdf_(point));
+    return {.mirror = point - 2 * dist * normal,
+            .normal = normal,
+            .dist = 2 * abs(dist)};
+  }
+
+private:
+
+  [[no_unique_address]] SDF sdf_;
+  Num eps_;
+
+}; // class SDFWalls
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Motion state of a rigid body.
+///
+/// Point with the body-local coordinates `x` is located at
+/// `center + rotation * x`, and moves with the velocity
+/// `velocity + spin * (point - center)`, where the skew-symmetric spin tensor
+/// is the angular velocity, e.g., `spin = {{0, -w}, {w, 0}}` in 2D.
+template<class Vec>
+struct RigidBodyState final {
+  /// Tensor type.
+  using Tensor = Mat<vec_num_t<Vec>, vec_dim_v<Vec>>;
+
+  Vec center;                                  ///< Body origin.
+  Tensor rotation = Tensor(vec_num_t<Vec>{1}); ///< Rotation of the body axes.
+  Vec velocity;                                ///< Velocity of the origin.
+  Tensor spin;                                 ///< Angular velocity tensor.
+};
+
+/// Loads, that the fluid exerts on a rigid body.
+template<class Vec>
+struct RigidBodyLoads final {
+  /// Tensor type.
+  using Tensor = Mat<vec_num_t<Vec>, vec_dim_v<Vec>>;
+
+  Vec force;     ///< Total force.
+  Tensor torque; ///< Total skew-symmetric torque around the body origin.
+};
+
+/// Rigid bodies, that move through the fluid.
+///
+/// Each body is represented by the fixed particles, which body-local
+/// positions and projections onto the body walls are cached on creation.
+/// Once per step, the bodies are moved, and their particles are transformed
+/// into the global coordinates in a single parallel pass. Projections of the
+/// body particles are transformed on request, see `DomainBoundary`.
+///
+/// Particle field `body` refers to the cached geometry of the particle, so
+/// that the particles may be reordered freely.
+template<class Vec>
+class RigidBodies final {
+public:
+
+  /// Numeric type.
+  using Num = vec_num_t<Vec>;
+
+  /// Body state type.
+  using State = RigidBodyState<Vec>;
+
+  /// Body loads type.
+  using Loads = RigidBodyLoads<Vec>;
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{r, m, dv_dt, body};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{r, body};
+
+  /// Number of the bodies.
+  constexpr auto size() const noexcept -> size_t {
+    return states_.size();
+  }
+
+  /// Motion state of the body.
+  constexpr auto state(this auto& self, size_t index) noexcept -> auto& {
+    TIT_ASSERT(index < self.size(), "Body index is out of range!");
+    return self.states_[index];
+  }
+
+  /// Add a new body.
+  ///
+  /// @param state           Initial motion state.
+  /// @param local_positions Body-local positions of the body particles.
+  /// @param local_walls     Body walls in the body-local coordinates, the
+  ///                        fluid is outside of the body.
+  ///
+  /// @returns Range of the appended fixed particles.
+  template<particle_array<required_fields> ParticleArray,
+           wall_geometry Walls>
+    requires std::same_as<typename Walls::Point, Vec>
+  auto add(ParticleArray& particles,
+           const State& state,
+           std::span<const Vec> local_positions,
+           const Walls& local_walls) {
+    const auto first = local_positions_.size();
+    const auto count = local_positions.size();
+    TIT_ASSERT(first + count < std::numeric_limits<uint32_t>::max(),
+               "Number of the body particles exceeded the limit!");
+    states_.push_back(state);
+    for (const auto& local_position : local_positions) {
+      local_positions_.push_back(local_position);
+      local_projs_.push_back(local_walls.project(local_position));
+      body_indices_.push_back(states_.size() - 1);
+    }
+    const auto appended = particles.append_n(ParticleType::fixed, count);
+    for (size_t i = 0; const auto a : appended) {
+      body[a] = static_cast<uint32_t>(first + i + 1);
+      r[a] = state.center + state.rotation * local_positions[i];
+      i += 1;
+    }
+    return appended;
+  }
+
+  /// Move the bodies with their velocities over the time step @p dt, and
+  /// transform their particles into the new positions.
+  ///
+  /// Rotations are advanced with the Cayley transform of the spin, which
+  /// keeps them orthogonal.
+  template<particle_array<required_fields> ParticleArray>
+  void update(Num dt, ParticleArray& particles) {
+    TIT_PROFILE_SECTION("RigidBodies::update()");
+    using PV = ParticleView<ParticleArray>;
+    for (auto& state : states_) {
+      const auto half_spin = (dt / 2) * state.spin;
+      const auto fact = lu(Tensor_(Num{1}) - half_spin);
+      TIT_ASSERT(fact, "Cayley transform of the spin must be invertible!");
+      state.center += dt * state.velocity;
+      state.rotation =
+          fact->inverse() * (Tensor_(Num{1}) + half_spin) * state.rotation;
+    }
+    par::for_each(particles.fixed(), [this](PV a) {
+      if (body[a] == 0) return;
+      const auto& state = state_of_(a);
+      r[a] = state.center + state.rotation * local_positions_[body[a] - 1];
+    });
+  }
+
+  /// Projection of the body particle onto the body walls.
+  template<particle_view<body> PV>
+  constexpr auto project(PV a) const -> BoundaryProjection<Vec> {
+    TIT_ASSERT(body[a] != 0, "Particle must belong to a body!");
+    const auto& state = state_of_(a);
+    const auto& local_proj = local_projs_[body[a] - 1];
+    return {.mirror = state.center + state.rotation * local_proj.mirror,
+            .normal = state.rotation * local_proj.normal,
+            .dist = local_proj.dist};
+  }
+
+  /// Velocity of the body at the body particle.
+  template<particle_view<r, body> PV>
+  constexpr auto velocity(PV a) const -> Vec {
+    TIT_ASSERT(body[a] != 0, "Particle must belong to a body!");
+    const auto& state = state_of_(a);
+    return state.velocity + state.spin * (r[a] - state.center);
+  }
+
+  /// Compute the loads, that the fluid exerts on the bodies, with a parallel
+  /// reduction over the body particles. Accelerations of the particles must
+  /// be computed, so the loads include the momentum sources (e.g., gravity)
+  /// applied to the body particles.
+  template<particle_array<required_fields> ParticleArray>
+  auto compute_loads(ParticleArray& particles) const -> std::vector<Loads> {
+    TIT_PROFILE_SECTION("RigidBodies::compute_loads()");
+    using PV = ParticleView<ParticleArray>;
+    return par::fold(
+        particles.fixed(),
+        std::vector<Loads>(size()),
+        [this](std::vector<Loads> loads, PV a) {
+          if (body[a] == 0) return loads;
+          const auto& state = state_of_(a);
+          const auto force = m[a] * dv_dt[a];
+          const auto arm = r[a] - state.center;
+          auto& body_loads = loads[body_indices_[body[a] - 1]];
+          body_loads.force += force;
+          add_outer(body_loads.torque, force, arm);
+          add_outer(body_loads.torque, arm, force, -Num{1});
+          return loads;
+        },
+        [](std::vector<Loads> loads, const std::vector<Loads>& other) {
+          for (size_t i = 0; i < loads.size(); ++i) {
+            loads[i].force += other[i].force;
+            loads[i].torque += other[i].torque;
+          }
+          return loads;
+        });
+  }
+
+private:
+
+  using Tensor_ = typename State::Tensor;
+
+  // Motion state of the body of the particle.
+  template<particle_view<body> PV>
+  constexpr auto state_of_(PV a) const noexcept -> const State& {
+    TIT_ASSERT(body[a] - 1 < body_indices_.size(),
+               "Particle body index is out of range!");
+    return states_[body_indices_[body[a] - 1]];
+  }
+
+  std::vector<State> states_;
+  std::vector<Vec> local_positions_;
+  std::vector<BoundaryProjection<Vec>> local_projs_;
+  std::vector<size_t> body_indices_;
+
+}; // class RigidBodies
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Slip wall boundary of the fluid domain.
+///
+/// Fixed particles are placed inside of the walls. Field values of each fixed
+/// particle are interpolated around its mirror image across the closest wall,
+/// then corrected for the hydrostatic density gradient, and the velocity is
+/// reflected to satisfy the slip wall condition. Fixed particles of the walls
+/// never move, so their projections onto the walls are computed only when
+/// the particle mesh is rebuilt, see `ParticleMesh::fixed_projection`.
+///
+/// Fixed particles of the moving rigid bodies, if any, are projected onto the
+/// body walls on each step, and the slip wall condition is applied relative
+/// to the body velocity, see `RigidBodies`.
+template<wall_geometry Walls>
+class DomainBoundary final {
+public:
+
+  /// Point type.
+  using Vec = Walls::Point;
+
+  /// Numeric type.
+  using Num = vec_num_t<Vec>;
+
+  /// Number of the spatial dimensions.
+  static constexpr size_t Dim = vec_dim_v<Vec>;
+
+  /// Default ratio of the interpolation radius to the kernel radius.
+  static constexpr Num DefaultInterpRadiusScale = 3;
+
+  /// Construct a domain boundary.
+  ///
+  /// @param walls Walls geometry.
+  /// @param rho_0 Reference density.
+  /// @param cs_0 Reference sound speed.
+  /// @param g Gravitational acceleration vector.
+  /// @param interp_radius_scale Ratio of the interpolation radius around the
+  ///                            mirror point to the kernel radius.
+  constexpr DomainBoundary(
+      Walls walls,
+      Num rho_0,
+      Num cs_0,
+      const Vec& g,
+      Num interp_radius_scale = DefaultInterpRadiusScale) noexcept
+      : walls_{std::move(walls)}, rho_0_{rho_0}, cs_0_{cs_0}, g_{g},
+        interp_radius_scale_{interp_radius_scale} {
+    TIT_ASSERT(rho_0_ > 0.0, "Reference density must be positive!");
+    TIT_ASSERT(cs_0_ > 0.0, "Reference sound speed must be positive!");
+    TIT_ASSERT(interp_radius_scale_ > 0.0,
+               "Interpolation radius scale must be positive!");
+  }
+
+  /// Construct a boundary of the box-shaped domain.
+  constexpr DomainBoundary(
+      geom::BBox<Vec> box,
+      Num rho_0,
+      Num cs_0,
+      const Vec& g,
+      Num interp_radius_scale = DefaultInterpRadiusScale) noexcept
+    requires std::same_as<Walls, BoxWalls<Vec>>
+      : DomainBoundary{Walls{std::move(box)},
+                       rho_0,
+                       cs_0,
+                       g,
+                       interp_radius_scale} {}
+
+  /// Walls geometry.
+  constexpr auto walls() const noexcept -> const Walls& {
+    return walls_;
+  }
+
+  /// Ratio of the interpolation radius to the kernel radius.
+  constexpr auto interp_radius_scale() const noexcept -> Num {
+    return interp_radius_scale_;
+  }
+
+  /// Moving rigid bodies, if any.
+  constexpr auto bodies() const noexcept -> RigidBodies<Vec>* {
+    return bodies_;
+  }
+
+  /// Set the moving rigid bodies. Bodies must outlive the boundary. Bodies
+  /// are moved by the time integrators, see `FluidEquations::move_bodies`.
+  constexpr void set_bodies(RigidBodies<Vec>* bodies) noexcept {
+    bodies_ = bodies;
+  }
+
+  /// Does the fixed particle move with a rigid body?
+  template<particle_view PV>
+  constexpr auto is_moving(PV b) const noexcept -> bool {
+    if constexpr (has<PV>(body)) return bodies_ != nullptr && body[b] != 0;
+    else return false;
+  }
+
+  /// Project the point onto the closest wall.
+  constexpr auto project(const Vec& point) const -> BoundaryProjection<Vec> {
+    return walls_.project(point);
+  }
+
+  /// Project the fixed particle onto the walls of the domain, or onto the
+  /// walls of its body, if it moves with a rigid body.
+  template<particle_view<r> PV>
+  constexpr auto project(PV b) const -> BoundaryProjection<Vec> {
+    if (is_moving(b)) return bodies_->project(b);
+    return walls_.project(r[b]);
+  }
+
+  /// Velocity of the walls at the fixed particle.
+  template<particle_view<r> PV>
+  constexpr auto wall_velocity(PV b) const -> Vec {
+    if (is_moving(b)) return bodies_->velocity(b);
+    return Vec{};
+  }
+
+  /// Hydrostatic density difference between the points, that are separated
+  /// by the distance @p dist along the wall normal @p normal:
+  /// `drho/dn = rho_0 / cs_0^2 * dot(g, n)`.
+  constexpr auto hydrostatic_density_jump(Num dist, const Vec& normal) const
+      -> Num {
+    return dist * rho_0_ / pow2(cs_0_) * dot(g_, normal);
+  }
+
+private:
+
+  Walls walls_;
+  Num rho_0_;
+  Num cs_0_;
+  Vec g_;
+  Num interp_radius_scale_;
+  RigidBodies<Vec>* bodies_ = nullptr;
+
+}; // class DomainBoundary
+
+template<class Vec, class... Args>
+DomainBoundary(geom::BBox<Vec>, Args...) -> DomainBoundary<BoxWalls<Vec>>;
+
+/// Domain boundary type.
+template<class DB>
+concept domain_boundary = specialization_of<DB, DomainBoundary>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,134 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <array>
+#include <span>
+
+#include "tit/core/mat.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+
+#include "tit/sph/boundary.hpp"
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::DomainBoundary") {
+  const sph::DomainBoundary boundary{
+      geom::BBox{Vec{0.0, 0.0, 0.0}, Vec{4.0, 2.0, 1.0}},
+      /*rho_0=*/1000.0,
+      /*cs_0=*/10.0,
+      /*g=*/Vec{0.0, -10.0, 0.0},
+  };
+  static_assert(decltype(boundary)::Dim == 3);
+  CHECK(boundary.interp_radius_scale() == 3.0);
+  SUBCASE("box walls") {
+    // Points outside of the domain are mirrored across the closest walls.
+    const auto [mirror, normal, dist] = boundary.project(Vec{1.0, -0.5, 0.5});
+    CHECK(mirror == Vec{1.0, 0.5, 0.5});
+    CHECK(normal == Vec{0.0, -1.0, 0.0});
+    CHECK(dist == 1.0);
+    CHECK(boundary.project(Vec{5.0, 1.0, 1.5}).mirror == Vec{3.0, 1.0, 0.5});
+  }
+  SUBCASE("SDF walls") {
+    // Fluid is inside of the unit circle.
+    using Point = Vec<double, 2>;
+    auto sdf = [](const Point& point) { return norm(point) - 1.0; };
+    const sph::SDFWalls<Point, decltype(sdf)> walls{sdf, /*eps=*/1.0e-6};
+    const auto [mirror, normal, dist] = walls.project(Vec{0.0, 1.5});
+    CHECK_APPROX_EQ(mirror, Vec{0.0, 0.5});
+    CHECK_APPROX_EQ(normal, Vec{0.0, 1.0});
+    CHECK_APPROX_EQ(dist, 1.0);
+  }
+  SUBCASE("hydrostatic density jump") {
+    // Density grows downwards: drho/dn = rho_0 / cs_0^2 * dot(g, n).
+    CHECK(boundary.hydrostatic_density_jump(0.5, Vec{0.0, -1.0, 0.0}) ==
+          50.0);
+    CHECK(boundary.hydrostatic_density_jump(0.5, Vec{1.0, 0.0, 0.0}) == 0.0);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::RigidBodies") {
+  using sph::r;
+  using Vec2D = Vec<double, 2>;
+  using Mat2D = Mat<double, 2>;
+  using Space2D = sph::Space<double, 2>;
+  sph::ParticleArray<Space2D,
+                     meta::Set<>,
+                     decltype(meta::Set{r, m, dv_dt, body})>
+      particles{Space2D{}, meta::Set<>{}};
+
+  // Static fixed particle of the domain walls.
+  const auto wall = particles.append(sph::ParticleType::fixed);
+  r[wall] = Vec2D{0.0, -0.5};
+
+  // Body, that moves to the right and rotates counterclockwise.
+  sph::RigidBodies<Vec2D> bodies;
+  const std::array local_positions{Vec2D{0.5, 0.0}};
+  const sph::BoxWalls local_walls{
+      geom::BBox{Vec2D{-0.25, -0.25}, Vec2D{0.25, 0.25}}};
+  const auto appended = bodies.add(particles,
+                                   {.center = {1.0, 0.0}},
+                                   std::span{local_positions},
+                                   local_walls);
+  REQUIRE(bodies.size() == 1);
+  REQUIRE(std::size(appended) == 1);
+  const auto a = particles[1];
+  CHECK(body[a] == 1);
+  CHECK(r[a] == Vec2D{1.5, 0.0});
+
+  // Spin rate is chosen so that the Cayley transform is exactly a quarter
+  // turn over the unit step.
+  bodies.state(0).velocity = {1.0, 0.0};
+  bodies.state(0).spin = Mat2D{{0.0, -2.0}, {2.0, 0.0}};
+  bodies.update(1.0, particles);
+  CHECK(bodies.state(0).center == Vec2D{2.0, 0.0});
+  CHECK_APPROX_EQ(bodies.state(0).rotation, Mat2D{{0.0, -1.0}, {1.0, 0.0}});
+  CHECK_APPROX_EQ(r[a], Vec2D{2.0, 0.5});
+  CHECK(r[wall] == Vec2D{0.0, -0.5});
+
+  // Projections and velocities are transformed with the body.
+  sph::DomainBoundary boundary{
+      geom::BBox{Vec2D{0.0, 0.0}, Vec2D{4.0, 2.0}},
+      /*rho_0=*/1000.0,
+      /*cs_0=*/10.0,
+      /*g=*/Vec2D{0.0, -10.0},
+  };
+  CHECK_FALSE(boundary.is_moving(a));
+  boundary.set_bodies(&bodies);
+  CHECK(boundary.is_moving(a));
+  CHECK_FALSE(boundary.is_moving(wall));
+  const auto [mirror, normal, dist] = boundary.project(a);
+  CHECK_APPROX_EQ(mirror, Vec2D{2.0, 0.0});
+  CHECK_APPROX_EQ(normal, Vec2D{0.0, 1.0});
+  CHECK(dist == 0.5);
+  CHECK_APPROX_EQ(boundary.wall_velocity(a), Vec2D{0.0, 0.0});
+  CHECK(boundary.project(wall).mirror == Vec2D{0.0, 0.5});
+  CHECK(boundary.wall_velocity(wall) == Vec2D{0.0, 0.0});
+
+  // Loads are summed over the body particles.
+  m[a] = 2.0, dv_dt[a] = {1.0, 0.0};
+  m[wall] = 1.0, dv_dt[wall] = {5.0, 5.0};
+  const auto loads = bodies.compute_loads(particles);
+  REQUIRE(loads.size() == 1);
+  CHECK_APPROX_EQ(loads[0].force, Vec2D{2.0, 0.0});
+  CHECK_APPROX_EQ(loads[0].torque, Mat2D{{0.0, 1.0}, {-1.0, 0.0}});
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,216 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/par/algorithms.hpp"
+
+#include "tit/sph/checkpoint.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+// Checkpoint file signature, the last byte is the format version. Version 2
+// stores the range of the buffer particles.
+constexpr std::array<char, 8> checkpoint_magic{
+    'T', 'I', 'T', 'C', 'K', 'P', 'T', 2};
+
+// Records larger than this are written and read in parallel chunks.
+constexpr size_t chunk_size = size_t{16} << 20;
+
+// Split the record into chunks and apply the function to each of them in
+// parallel, passing the chunk and its offset within the record.
+template<class Byte, class Func>
+void for_each_chunk(std::span<Byte> bytes, const Func& func) {
+  const auto num_chunks = (bytes.size() + chunk_size - 1) / chunk_size;
+  if (num_chunks <= 1) {
+    func(bytes, 0);
+    return;
+  }
+  par::for_each(std::views::iota(size_t{0}, num_chunks),
+                [bytes, &func](size_t i) {
+                  const auto first = i * chunk_size;
+                  const auto count = std::min(chunk_size, bytes.size() - first);
+                  func(bytes.subspan(first, count), first);
+                });
+}
+
+} // namespace
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+CheckpointWriter::CheckpointWriter(std::filesystem::path path)
+    : path_{std::move(path)}, temp_path_{path_.string() + ".tmp"} {
+  // NOLINTNEXTLINE(*-vararg)
+  fd_ = open(temp_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    TIT_THROW("Unable to create the checkpoint file '{}'!",
+              temp_path_.c_str());
+  }
+  write_at_(std::as_bytes(std::span{checkpoint_magic}), 0);
+  offset_ = checkpoint_magic.size();
+}
+
+CheckpointWriter::~CheckpointWriter() {
+  if (fd_ < 0) return;
+  close(fd_);
+  std::error_code error;
+  std::filesystem::remove(temp_path_, error);
+}
+
+void CheckpointWriter::commit() {
+  TIT_ASSERT(fd_ >= 0, "Checkpoint was already committed!");
+  if (fsync(fd_) != 0) {
+    TIT_THROW("Unable to flush the checkpoint file '{}'!", temp_path_.c_str());
+  }
+  close(std::exchange(fd_, -1));
+  std::error_code error;
+  std::filesystem::rename(temp_path_, path_, error);
+  if (error) {
+    TIT_THROW("Unable to replace the checkpoint file '{}': {}",
+              path_.c_str(),
+              error.message());
+  }
+}
+
+void CheckpointWriter::write_bytes_(std::string_view tag,
+                                    size_t val_size,
+                                    std::span<const byte_t> bytes) {
+  TIT_ASSERT(fd_ >= 0, "Checkpoint was already committed!");
+  TIT_ASSERT(val_size > 0, "Value size must be positive!");
+
+  // Write the record header: tag, value size and number of values.
+  const std::array<uint64_t, 3> header{tag.size(),
+                                       val_size,
+                                       bytes.size() / val_size};
+  write_at_(std::as_bytes(std::span{header}), offset_);
+  offset_ += sizeof(header);
+  write_at_(std::as_bytes(std::span{tag}), offset_);
+  offset_ += tag.size();
+
+  // Write the values.
+  for_each_chunk(bytes,
+                 [offset = offset_, this](std::span<const byte_t> chunk,
+                                          size_t chunk_offset) {
+                   write_at_(chunk, offset + chunk_offset);
+                 });
+  offset_ += bytes.size();
+}
+
+void CheckpointWriter::write_at_(std::span<const byte_t> bytes,
+                                 size_t offset) const {
+  while (!bytes.empty()) {
+    const auto written = pwrite(fd_,
+                                bytes.data(),
+                                bytes.size(),
+                                static_cast<off_t>(offset));
+    if (written <= 0) {
+      TIT_THROW("Unable to write the checkpoint file '{}'!",
+                temp_path_.c_str());
+    }
+    const auto count = static_cast<size_t>(written);
+    bytes = bytes.subspan(count), offset += count;
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+CheckpointReader::CheckpointReader(std::filesystem::path path)
+    : path_{std::move(path)} {
+  // NOLINTNEXTLINE(*-vararg)
+  fd_ = open(path_.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    TIT_THROW("Unable to open the checkpoint file '{}'!", path_.c_str());
+  }
+  std::array<char, checkpoint_magic.size()> magic{};
+  read_bytes_(std::as_writable_bytes(std::span{magic}));
+  if (magic != checkpoint_magic) {
+    TIT_THROW("File '{}' is not a checkpoint, or its format version is not "
+              "supported.",
+              path_.c_str());
+  }
+}
+
+CheckpointReader::~CheckpointReader() {
+  if (fd_ >= 0) close(fd_);
+}
+
+auto CheckpointReader::read_header_(std::string_view tag, size_t val_size)
+    -> size_t {
+  std::array<uint64_t, 3> header{};
+  read_bytes_(std::as_writable_bytes(std::span{header}));
+  const auto [tag_size, stored_val_size, count] = header;
+  std::string stored_tag(tag_size, '\0');
+  read_bytes_(std::as_writable_bytes(std::span{stored_tag}));
+  if (stored_tag != tag) {
+    TIT_THROW("Checkpoint '{}': expected record '{}', got '{}'.",
+              path_.c_str(),
+              tag,
+              stored_tag);
+  }
+  if (stored_val_size != val_size) {
+    TIT_THROW("Checkpoint '{}': record '{}' has value size {}, expected {}.",
+              path_.c_str(),
+              tag,
+              stored_val_size,
+              val_size);
+  }
+  return count;
+}
+
+void CheckpointReader::check_count_(std::string_view tag,
+                                    size_t count,
+                                    size_t expected) const {
+  if (count == expected) return;
+  TIT_THROW("Checkpoint '{}': record '{}' has {} values, expected {}.",
+            path_.c_str(),
+            tag,
+            count,
+            expected);
+}
+
+void CheckpointReader::read_bytes_(std::span<byte_t> bytes) {
+  for_each_chunk(bytes,
+                 [offset = offset_, this](std::span<byte_t> chunk,
+                                          size_t chunk_offset) {
+                   read_at_(chunk, offset + chunk_offset);
+                 });
+  offset_ += bytes.size();
+}
+
+void CheckpointReader::read_at_(std::span<byte_t> bytes, size_t offset) const {
+  while (!bytes.empty()) {
+    const auto count = pread(fd_,
+                             bytes.data(),
+                             bytes.size(),
+                             static_cast<off_t>(offset));
+    if (count <= 0) {
+      TIT_THROW("Checkpoint '{}' is truncated or unreadable.", path_.c_str());
+    }
+    const auto num_read = static_cast<size_t>(count);
+    bytes = bytes.subspan(num_read), offset += num_read;
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
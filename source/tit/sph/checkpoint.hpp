@@ -0,0 +1,125 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Checkpoint file writer.
+///
+/// Checkpoint is a sequence of tagged records, each holding the raw memory
+/// representation of a contiguous array of trivially copyable values. Large
+/// records are written in parallel chunks, no compression is applied. The
+/// data is written into a temporary file, that replaces the target file only
+/// when the checkpoint is committed, so that a crash while writing never
+/// corrupts the previous checkpoint.
+class CheckpointWriter final {
+public:
+
+  /// Start writing a checkpoint into the file.
+  explicit CheckpointWriter(std::filesystem::path path);
+
+  /// Checkpoint writer is not copyable.
+  CheckpointWriter(const CheckpointWriter&) = delete;
+  auto operator=(const CheckpointWriter&) -> CheckpointWriter& = delete;
+
+  /// Remove the temporary file, if the checkpoint was not committed.
+  ~CheckpointWriter();
+
+  /// Write a record with the values.
+  template<class Val>
+  void write(std::string_view tag, std::span<const Val> vals) {
+    static_assert(std::is_trivially_copyable_v<Val>,
+                  "Checkpointed values must be trivially copyable!");
+    write_bytes_(tag, sizeof(Val), std::as_bytes(vals));
+  }
+
+  /// Write a record with a single value.
+  template<class Val>
+  void write(std::string_view tag, const Val& val) {
+    write(tag, std::span{&val, 1});
+  }
+
+  /// Flush the data onto the disk and replace the target file.
+  void commit();
+
+private:
+
+  void write_bytes_(std::string_view tag,
+                    size_t val_size,
+                    std::span<const byte_t> bytes);
+  void write_at_(std::span<const byte_t> bytes, size_t offset) const;
+
+  std::filesystem::path path_;
+  std::filesystem::path temp_path_;
+  int fd_ = -1;
+  size_t offset_ = 0;
+
+}; // class CheckpointWriter
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Checkpoint file reader.
+///
+/// Records must be read in the same order they were written. Tag or value
+/// size mismatch means that the checkpoint was written by a different solver
+/// configuration, and results in an exception.
+class CheckpointReader final {
+public:
+
+  /// Open a checkpoint file.
+  explicit CheckpointReader(std::filesystem::path path);
+
+  /// Checkpoint reader is not copyable.
+  CheckpointReader(const CheckpointReader&) = delete;
+  auto operator=(const CheckpointReader&) -> CheckpointReader& = delete;
+
+  /// Close the file.
+  ~CheckpointReader();
+
+  /// Read a record into the vector, resizing it to the stored size.
+  template<class Val, class Alloc>
+  void read(std::string_view tag, std::vector<Val, Alloc>& vals) {
+    static_assert(std::is_trivially_copyable_v<Val>,
+                  "Checkpointed values must be trivially copyable!");
+    vals.resize(read_header_(tag, sizeof(Val)));
+    read_bytes_(std::as_writable_bytes(std::span{vals}));
+  }
+
+  /// Read a record with a single value.
+  template<class Val>
+  void read(std::string_view tag, Val& val) {
+    static_assert(std::is_trivially_copyable_v<Val>,
+                  "Checkpointed values must be trivially copyable!");
+    check_count_(tag, read_header_(tag, sizeof(Val)), 1);
+    read_bytes_(std::as_writable_bytes(std::span{&val, 1}));
+  }
+
+private:
+
+  auto read_header_(std::string_view tag, size_t val_size) -> size_t;
+  void check_count_(std::string_view tag, size_t count, size_t expected) const;
+  void read_bytes_(std::span<byte_t> bytes);
+  void read_at_(std::span<byte_t> bytes, size_t offset) const;
+
+  std::filesystem::path path_;
+  int fd_ = -1;
+  size_t offset_ = 0;
+
+}; // class CheckpointReader
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
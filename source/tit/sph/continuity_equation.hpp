@@ -35,6 +35,10 @@ public:
   static constexpr auto modified_fields =
       (MassSources::modified_fields | ... | meta::Set{/*empty*/});
 
+  /// Set of particle fields that are read by the source terms.
+  static constexpr auto source_fields =
+      (MassSources::required_fields | ... | meta::Set{/*empty*/});
+
   /// Construct the continuity equation.
   constexpr explicit ContinuityEquation(MassSources... mass_sources) noexcept
       : mass_sources_{std::move(mass_sources)...} {}
@@ -0,0 +1,159 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <numbers>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+
+#include "tit/sph/lattice.hpp"
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Dam break case setup, shared by the drivers.
+///
+/// Water column of height `H` and length `2 H` collapses in the corner of the
+/// pool of width `5.366 H` and height `2.5 H`, that is surrounded by the
+/// layers of the fixed particles, except for the top. Initial pressure of the
+/// water is hydrostatic.
+template<class Real>
+class DamBreakCase final {
+public:
+
+  /// Gravitational acceleration.
+  static constexpr Real g = 9.81;
+
+  /// Reference density of the water.
+  static constexpr Real rho_0 = 1000.0;
+
+  /// Number of the fixed particle layers around the pool.
+  static constexpr size_t num_fixed_layers = 4;
+
+  /// Set up the case for the water column of height @p H, resolved with
+  /// @p resolution particles along the height.
+  constexpr DamBreakCase(Real H, size_t resolution)
+      : H_{H}, dr_{H / static_cast<Real>(resolution)} {
+    TIT_ASSERT(H_ > Real{0}, "Water column height must be positive!");
+    TIT_ASSERT(resolution > 0, "Resolution must be positive!");
+  }
+
+  /// Water column height.
+  constexpr auto height() const noexcept -> Real {
+    return H_;
+  }
+
+  /// Water column length.
+  constexpr auto length() const noexcept -> Real {
+    return 2 * H_;
+  }
+
+  /// Pool width.
+  constexpr auto pool_width() const noexcept -> Real {
+    return Real{5.366} * H_;
+  }
+
+  /// Pool height.
+  constexpr auto pool_height() const noexcept -> Real {
+    return Real{2.5} * H_;
+  }
+
+  /// Pool, that is the computational domain.
+  constexpr auto domain() const -> geom::BBox<Vec<Real, 2>> {
+    return {Vec{Real{0.0}, Real{0.0}}, Vec{pool_width(), pool_height()}};
+  }
+
+  /// Particle spacing.
+  constexpr auto spacing() const noexcept -> Real {
+    return dr_;
+  }
+
+  /// Number of the particle rows along the pool height.
+  auto num_pool_rows() const -> size_t {
+    return static_cast<size_t>(round(pool_height() / dr_));
+  }
+
+  /// Sound speed.
+  auto sound_speed() const -> Real {
+    return 20 * sqrt(g * H_);
+  }
+
+  /// Kernel width.
+  constexpr auto width() const noexcept -> Real {
+    return 2 * dr_;
+  }
+
+  /// Particle mass.
+  constexpr auto mass() const noexcept -> Real {
+    return rho_0 * pow2(dr_);
+  }
+
+  /// Time step for the given CFL number.
+  auto time_step(Real cfl) const -> Real {
+    const auto h_0 = width();
+    return std::min(cfl * h_0 / sound_speed(), Real{0.25} * sqrt(h_0 / g));
+  }
+
+  /// Dimensionless time, `t * sqrt(g / H)`.
+  auto dimensionless_time(Real time) const -> Real {
+    return time * sqrt(g / H_);
+  }
+
+  /// Lattice of the case particles: the fixed particle layers around the
+  /// pool, with the open top, and the water column in the corner.
+  auto lattice() const -> LatticeFill<Real, 2> {
+    LatticeFill<Real, 2> fill{dr_};
+    fill.walls(ParticleType::fixed,
+               domain(),
+               num_fixed_layers,
+               /*open_low=*/{false, false},
+               /*open_high=*/{false, true});
+    fill.box(ParticleType::fluid,
+             {Vec{Real{0.0}, Real{0.0}}, Vec{length(), H_}});
+    return fill;
+  }
+
+  /// Hydrostatic pressure at the point of the water column. Pressure is the
+  /// series solution of the Poisson problem.
+  auto hydrostatic_pressure(const Vec<Real, 2>& point) const -> Real {
+    const auto L = length();
+    const auto x = point[0];
+    const auto y = point[1];
+    auto p_a = rho_0 * g * (H_ - y);
+    for (size_t N = 1; N < 100; N += 2) {
+      constexpr auto pi = std::numbers::pi_v<Real>;
+      const auto n = static_cast<Real>(N);
+      p_a -= 8 * rho_0 * g * H_ / pow2(pi) *
+             (exp(n * pi * (x - L) / (2 * H_)) * cos(n * pi * y / (2 * H_))) /
+             pow2(n);
+    }
+    return p_a;
+  }
+
+  /// Density, that corresponds to the pressure, according to the linear
+  /// equation of state.
+  auto density(Real p) const -> Real {
+    return rho_0 + p / pow2(sound_speed());
+  }
+
+private:
+
+  Real H_;
+  Real dr_;
+
+}; // class DamBreakCase
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,107 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <span>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/accum_buffer.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Global diagnostics of the fluid particles.
+template<class Vec>
+struct FluidDiagnostics final {
+  /// Numeric type.
+  using Num = vec_num_t<Vec>;
+
+  Num mass{};             ///< Total mass.
+  Num kinetic_energy{};   ///< Total kinetic energy.
+  Num potential_energy{}; ///< Potential energy in the gravity field.
+  Vec momentum{};         ///< Total momentum.
+  Num max_speed{};        ///< Maximum speed.
+
+  /// Combine with the diagnostics of the other particles.
+  constexpr auto operator+=(const FluidDiagnostics& other) noexcept
+      -> FluidDiagnostics& {
+    mass += other.mass;
+    kinetic_energy += other.kinetic_energy;
+    potential_energy += other.potential_energy;
+    momentum += other.momentum;
+    max_speed = std::max(max_speed, other.max_speed);
+    return *this;
+  }
+};
+
+/// Accumulator of the global diagnostics of the fluid particles.
+///
+/// Each worker thread accumulates the partial sums of its particles into its
+/// own copy, see `par::AccumBuffer`, and the copies are combined on request.
+/// The fluid particles are added from a particle pass that is made anyway,
+/// e.g., the last pass of the time integrator, see `observer()`, so the
+/// diagnostics cost no extra pass over the particle fields.
+template<class Vec>
+class Diagnostics final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{r, v, m};
+
+  /// Construct the diagnostics with the gravitational acceleration, that the
+  /// potential energy is computed for.
+  constexpr explicit Diagnostics(const Vec& gravity) noexcept
+      : gravity_{gravity} {}
+
+  /// Clear the accumulated diagnostics.
+  void reset() {
+    buffer_.reset(1);
+  }
+
+  /// Add the fluid particle to the diagnostics. Thread-safe.
+  template<particle_view<required_fields> PV>
+  void add(PV a) {
+    auto& partial = buffer_.local()[0];
+    const auto speed2 = norm2(v[a]);
+    partial.mass += m[a];
+    partial.kinetic_energy += m[a] * speed2 / 2;
+    partial.potential_energy -= m[a] * dot(gravity_, r[a]);
+    partial.momentum += m[a] * v[a];
+    // Squared speeds are accumulated, the root is taken in `result`.
+    partial.max_speed = std::max(partial.max_speed, speed2);
+  }
+
+  /// Observer of the time integrator step, that adds the particles.
+  auto observer() {
+    return [this](auto a) { add(a); };
+  }
+
+  /// Diagnostics of the particles added since the last reset.
+  auto result() const -> FluidDiagnostics<Vec> {
+    FluidDiagnostics<Vec> total{};
+    buffer_.reduce_into(std::span{&total, 1});
+    total.max_speed = sqrt(total.max_speed);
+    return total;
+  }
+
+private:
+
+  Vec gravity_;
+  par::AccumBuffer<FluidDiagnostics<Vec>> buffer_;
+
+}; // class Diagnostics
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
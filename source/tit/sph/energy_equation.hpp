@@ -34,6 +34,9 @@ public:
   /// Set of particle fields that are modified.
   static constexpr meta::Set modified_fields{/*empty*/};
 
+  /// Set of particle fields that are read by the source terms.
+  static constexpr meta::Set source_fields{/*empty*/};
+
 }; // class NoEnergyEquation
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -53,6 +56,10 @@ public:
       HeatConductivity::modified_fields |
       (EnergySources::modified_fields | ... | meta::Set{/*empty*/});
 
+  /// Set of particle fields that are read by the source terms.
+  static constexpr auto source_fields =
+      (EnergySources::required_fields | ... | meta::Set{/*empty*/});
+
   /// Construct the energy equation.
   constexpr EnergyEquation(HeatConductivity heat_conductivity,
                            EnergySources... energy_sources) noexcept
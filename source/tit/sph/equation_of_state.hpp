@@ -8,9 +8,11 @@
 #include <algorithm>
 #include <concepts>
 #include <utility>
+#include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/containers/mdvector.hpp"
 #include "tit/core/math.hpp"
 #include "tit/core/meta.hpp"
 #include "tit/core/type_utils.hpp"
@@ -241,13 +243,308 @@ private:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Uniform axis of an equation of state table.
+class TableAxis final {
+public:
+
+  /// Construct the axis.
+  ///
+  /// @param min        Lowest point of the axis.
+  /// @param max        Highest point of the axis.
+  /// @param num_points Number of the axis points, at least two.
+  TableAxis(real_t min, real_t max, size_t num_points)
+      : min_{min}, step_{(max - min) / static_cast<real_t>(num_points - 1)},
+        inv_step_{1.0 / step_}, num_points_{num_points} {
+    TIT_ASSERT(num_points_ >= 2, "Axis must have at least two points!");
+    TIT_ASSERT(max > min, "Axis range must not be empty!");
+  }
+
+  /// Number of the axis points.
+  auto size() const noexcept -> size_t {
+    return num_points_;
+  }
+
+  /// Distance between the neighboring axis points.
+  auto step() const noexcept -> real_t {
+    return step_;
+  }
+
+  /// Axis point at the index.
+  auto point(size_t index) const noexcept -> real_t {
+    TIT_ASSERT(index < num_points_, "Point index is out of range!");
+    return min_ + static_cast<real_t>(index) * step_;
+  }
+
+  /// Index of the axis cell, that contains the value, and the linear
+  /// interpolation weight of its right point. Values out of the axis range
+  /// are clamped to it. No branches are involved.
+  template<class Num>
+  auto locate(Num x) const noexcept -> std::pair<size_t, Num> {
+    const auto t = std::clamp(static_cast<Num>((x - min_) * inv_step_),
+                              Num{0.0},
+                              static_cast<Num>(num_points_ - 1));
+    const auto index = std::min(static_cast<size_t>(t), num_points_ - 2);
+    return {index, t - static_cast<Num>(index)};
+  }
+
+private:
+
+  real_t min_;
+  real_t step_;
+  real_t inv_step_;
+  size_t num_points_;
+
+}; // class TableAxis
+
+/// Tabulated barotropic equation of state, for the weakly-compressible fluids
+/// with the expensive pressure functions.
+///
+/// Pressure is tabulated on a uniform density axis, and the sound speed is
+/// derived from it as `sqrt(dp/drho)`, so that the two are consistent. Values
+/// are linearly interpolated, densities out of the table range are clamped.
+class TabulatedBarotropicEquationOfState final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{rho};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{/*empty*/};
+
+  /// Construct an equation of state from the tabulated values.
+  ///
+  /// @param rho_axis  Density axis of the table.
+  /// @param pressures Pressure values at the axis points.
+  TabulatedBarotropicEquationOfState(TableAxis rho_axis,
+                                     std::vector<real_t> pressures)
+      : rho_axis_{std::move(rho_axis)}, p_{std::move(pressures)},
+        cs_(p_.size()) {
+    TIT_ASSERT(p_.size() == rho_axis_.size(), "Table size mismatch!");
+    const auto n = p_.size();
+    for (size_t i = 0; i < n; ++i) {
+      const auto prev = i == 0 ? 0 : i - 1;
+      const auto next = i + 1 == n ? i : i + 1;
+      const auto d_rho = static_cast<real_t>(next - prev) * rho_axis_.step();
+      const auto dp_drho = (p_[next] - p_[prev]) / d_rho;
+      cs_[i] = sqrt(std::max(dp_drho, 0.0));
+    }
+  }
+
+  /// Construct an equation of state by tabulating the pressure function.
+  ///
+  /// @param rho_axis Density axis of the table.
+  /// @param pressure Pressure as a function of density.
+  template<std::regular_invocable<real_t> Func>
+  TabulatedBarotropicEquationOfState(TableAxis rho_axis, const Func& pressure)
+      : TabulatedBarotropicEquationOfState{rho_axis,
+                                           tabulate_(rho_axis, pressure)} {}
+
+  /// Pressure value.
+  template<particle_view<required_fields> PV>
+  auto pressure(PV a) const noexcept {
+    return interpolate_(p_, rho[a]);
+  }
+
+  /// Sound speed value.
+  template<particle_view<required_fields> PV>
+  auto sound_speed(PV a) const noexcept {
+    return interpolate_(cs_, rho[a]);
+  }
+
+private:
+
+  template<class Func>
+  static auto tabulate_(const TableAxis& rho_axis, const Func& pressure)
+      -> std::vector<real_t> {
+    std::vector<real_t> pressures(rho_axis.size());
+    for (size_t i = 0; i < pressures.size(); ++i) {
+      pressures[i] = static_cast<real_t>(pressure(rho_axis.point(i)));
+    }
+    return pressures;
+  }
+
+  template<class Num>
+  auto interpolate_(const std::vector<real_t>& table, Num rho_a) const
+      -> Num {
+    const auto [i, w] = rho_axis_.locate(rho_a);
+    return (Num{1.0} - w) * static_cast<Num>(table[i]) +
+           w * static_cast<Num>(table[i + 1]);
+  }
+
+  TableAxis rho_axis_;
+  std::vector<real_t> p_;
+  std::vector<real_t> cs_;
+
+}; // class TabulatedBarotropicEquationOfState
+
+/// Tabulated equation of state, for the real fluids, whose pressure depends
+/// on both density and internal energy.
+///
+/// Pressure is tabulated on a uniform density and internal energy grid, and
+/// the sound speed is derived from it as
+/// `sqrt(dp/drho + p / rho^2 * dp/du)`, so that the two are consistent.
+/// Values are bilinearly interpolated, arguments out of the table range are
+/// clamped.
+class TabulatedEquationOfState final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{rho, u};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{/*empty*/};
+
+  /// Construct an equation of state from the tabulated values.
+  ///
+  /// @param rho_axis  Density axis of the table, must be positive.
+  /// @param u_axis    Internal energy axis of the table.
+  /// @param pressures Pressure values at the grid points, indexed by density
+  ///                  and internal energy point indices.
+  TabulatedEquationOfState(TableAxis rho_axis,
+                           TableAxis u_axis,
+                           const Mdvector<real_t, 2>& pressures)
+      : rho_axis_{std::move(rho_axis)}, u_axis_{std::move(u_axis)},
+        p_(pressures.begin(), pressures.end()), cs_(p_.size()) {
+    const auto n = rho_axis_.size();
+    const auto k = u_axis_.size();
+    TIT_ASSERT(pressures.shape()[0] == n && pressures.shape()[1] == k,
+               "Table shape mismatch!");
+    TIT_ASSERT(rho_axis_.point(0) > 0.0, "Densities must be positive!");
+    for (size_t i = 0; i < n; ++i) {
+      const auto i_prev = i == 0 ? 0 : i - 1;
+      const auto i_next = i + 1 == n ? i : i + 1;
+      const auto d_rho =
+          static_cast<real_t>(i_next - i_prev) * rho_axis_.step();
+      for (size_t j = 0; j < k; ++j) {
+        const auto j_prev = j == 0 ? 0 : j - 1;
+        const auto j_next = j + 1 == k ? j : j + 1;
+        const auto d_u = static_cast<real_t>(j_next - j_prev) * u_axis_.step();
+        const auto dp_drho = (p_[i_next * k + j] - p_[i_prev * k + j]) / d_rho;
+        const auto dp_du = (p_[i * k + j_next] - p_[i * k + j_prev]) / d_u;
+        const auto p_rho2 = p_[i * k + j] / pow2(rho_axis_.point(i));
+        cs_[i * k + j] = sqrt(std::max(dp_drho + p_rho2 * dp_du, 0.0));
+      }
+    }
+  }
+
+  /// Construct an equation of state by tabulating the pressure function.
+  ///
+  /// @param rho_axis Density axis of the table, must be positive.
+  /// @param u_axis   Internal energy axis of the table.
+  /// @param pressure Pressure as a function of density and internal energy.
+  template<std::regular_invocable<real_t, real_t> Func>
+  TabulatedEquationOfState(TableAxis rho_axis,
+                           TableAxis u_axis,
+                           const Func& pressure)
+      : TabulatedEquationOfState{rho_axis,
+                                 u_axis,
+                                 tabulate_(rho_axis, u_axis, pressure)} {}
+
+  /// Pressure value.
+  template<particle_view<required_fields> PV>
+  auto pressure(PV a) const noexcept {
+    return interpolate_(p_, rho[a], u[a]);
+  }
+
+  /// Sound speed value.
+  template<particle_view<required_fields> PV>
+  auto sound_speed(PV a) const noexcept {
+    return interpolate_(cs_, rho[a], u[a]);
+  }
+
+private:
+
+  template<class Func>
+  static auto tabulate_(const TableAxis& rho_axis,
+                        const TableAxis& u_axis,
+                        const Func& pressure) -> Mdvector<real_t, 2> {
+    Mdvector<real_t, 2> pressures(rho_axis.size(), u_axis.size());
+    for (size_t i = 0; i < rho_axis.size(); ++i) {
+      for (size_t j = 0; j < u_axis.size(); ++j) {
+        pressures[i, j] =
+            static_cast<real_t>(pressure(rho_axis.point(i), u_axis.point(j)));
+      }
+    }
+    return pressures;
+  }
+
+  template<class Num>
+  auto interpolate_(const std::vector<real_t>& table,
+                    Num rho_a,
+                    Num u_a) const -> Num {
+    const auto [i, w_rho] = rho_axis_.locate(rho_a);
+    const auto [j, w_u] = u_axis_.locate(u_a);
+    const auto k = u_axis_.size();
+    const auto lerp = [j, w_u, &table](size_t row) {
+      return (Num{1.0} - w_u) * static_cast<Num>(table[row + j]) +
+             w_u * static_cast<Num>(table[row + j + 1]);
+    };
+    return (Num{1.0} - w_rho) * lerp(i * k) + w_rho * lerp((i + 1) * k);
+  }
+
+  TableAxis rho_axis_;
+  TableAxis u_axis_;
+  std::vector<real_t> p_;
+  std::vector<real_t> cs_;
+
+}; // class TabulatedEquationOfState
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Equation of state of the incompressible fluid.
+///
+/// Pressure is not a function of the density, but the solution of the
+/// pressure Poisson equation, that is stored in the pressure field by the
+/// pressure projection integrator, so it is passed through as is.
+class IncompressibleEquationOfState final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{p};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{/*empty*/};
+
+  /// Construct an equation of state.
+  ///
+  /// @param cs_0 Numerical sound speed, that is only used by the artificial
+  ///             viscosity and the time step estimate, typically of the
+  ///             order of the expected velocity.
+  constexpr explicit IncompressibleEquationOfState(real_t cs_0) noexcept
+      : cs_0_{cs_0} {
+    TIT_ASSERT(cs_0_ > 0.0, "Numerical sound speed must be positive!");
+  }
+
+  /// Pressure value.
+  template<particle_view<required_fields> PV>
+  constexpr auto pressure(PV a) const noexcept {
+    return p[a];
+  }
+
+  /// Sound speed value.
+  template<particle_view<required_fields> PV>
+  constexpr auto sound_speed(PV /*a*/) const noexcept {
+    return cs_0_;
+  }
+
+private:
+
+  real_t cs_0_;
+
+}; // class IncompressibleEquationOfState
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Equation of state type.
 template<class EOS>
 concept equation_of_state =
     std::same_as<EOS, IdealGasEquationOfState> ||
     std::same_as<EOS, AdiabaticIdealGasEquationOfState> ||
     specialization_of<EOS, TaitEquationOfState> ||
-    specialization_of<EOS, LinearTaitEquationOfState>;
+    specialization_of<EOS, LinearTaitEquationOfState> ||
+    std::same_as<EOS, TabulatedBarotropicEquationOfState> ||
+    std::same_as<EOS, TabulatedEquationOfState> ||
+    std::same_as<EOS, IncompressibleEquationOfState>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -0,0 +1,75 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+
+#include "tit/sph/equation_of_state.hpp"
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+using Space2D = sph::Space<double, 2>;
+using ParticleArray2D =
+    sph::ParticleArray<Space2D, meta::Set<>, decltype(meta::Set{rho, u})>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::TabulatedBarotropicEquationOfState") {
+  // Quadratic pressure, whose sound speed is `sqrt(2 * rho)`.
+  const sph::TabulatedBarotropicEquationOfState eos{
+      sph::TableAxis{1.0, 3.0, 201},
+      [](double rho_a) { return pow2(rho_a); }};
+  ParticleArray2D particles{Space2D{}, meta::Set<>{}};
+  const auto a = particles.append(sph::ParticleType::fluid);
+  SUBCASE("inside") {
+    rho[a] = 2.0;
+    CHECK_APPROX_EQ(eos.pressure(a), 4.0);
+    CHECK_APPROX_EQ(eos.sound_speed(a), 2.0);
+    rho[a] = 2.005;
+    CHECK(abs(eos.pressure(a) - pow2(2.005)) < 1.0e-4);
+  }
+  SUBCASE("clamped") {
+    rho[a] = 0.5;
+    CHECK_APPROX_EQ(eos.pressure(a), 1.0);
+    rho[a] = 4.0;
+    CHECK_APPROX_EQ(eos.pressure(a), 9.0);
+  }
+}
+
+TEST_CASE("sph::TabulatedEquationOfState") {
+  // Ideal gas pressure is bilinear, so it is interpolated exactly.
+  static constexpr double gamma = 1.4;
+  const sph::TabulatedEquationOfState eos{
+      sph::TableAxis{0.5, 2.0, 16},
+      sph::TableAxis{1.0, 5.0, 9},
+      [](double rho_a, double u_a) { return (gamma - 1.0) * rho_a * u_a; }};
+  const sph::IdealGasEquationOfState ideal_gas{gamma};
+  ParticleArray2D particles{Space2D{}, meta::Set<>{}};
+  const auto a = particles.append(sph::ParticleType::fluid);
+  SUBCASE("inside") {
+    rho[a] = 1.23, u[a] = 2.71;
+    CHECK_APPROX_EQ(eos.pressure(a), ideal_gas.pressure(a));
+    // Sound speed is exact at the grid points only.
+    CHECK(abs(eos.sound_speed(a) - ideal_gas.sound_speed(a)) < 1.0e-2);
+    rho[a] = 1.0, u[a] = 3.0;
+    CHECK_APPROX_EQ(eos.sound_speed(a), ideal_gas.sound_speed(a));
+  }
+  SUBCASE("clamped") {
+    rho[a] = 3.0, u[a] = 0.0;
+    CHECK_APPROX_EQ(eos.pressure(a), (gamma - 1.0) * 2.0 * 1.0);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
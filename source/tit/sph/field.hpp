@@ -24,6 +24,10 @@ namespace tit {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace sph {
+class r_t;
+} // namespace sph
+
 namespace impl {
 
 template<class PV>
@@ -59,10 +63,17 @@ public:
     else return std::forward<Default>(default_val);
   }
 
-  /// Field value delta for the specified particle view.
+  /// Field value delta for the specified particle view. Position deltas are
+  /// taken for the closest images in the periodic box of the particle array.
   template<class Self, impl::has_field_<Self> PVa, impl::has_field_<Self> PVb>
   constexpr auto operator[](this const Self& self, PVa&& a, PVb&& b) noexcept {
-    return std::forward<PVa>(a)[self] - std::forward<PVb>(b)[self];
+    if constexpr (std::same_as<Self, sph::r_t> && requires {
+                    a.array().periodic_box().delta(a[self], b[self]);
+                  }) {
+      return a.array().periodic_box().delta(a[self], b[self]);
+    } else {
+      return std::forward<PVa>(a)[self] - std::forward<PVb>(b)[self];
+    }
   }
 
   /// Average of the field values over the specified particle views.
@@ -133,20 +144,29 @@ constexpr void clear([[maybe_unused]] PV& particle, Fields... fields) {
 #define TIT_DEFINE_MATRIX_FIELD(name, ...)                                     \
   TIT_DEFINE_FIELD(TIT_PASS(Mat<Real, Dim>), name __VA_OPT__(, __VA_ARGS__))
 
+/// Declare a symmetric matrix particle field.
+#define TIT_DEFINE_SYMMETRIC_MATRIX_FIELD(name, ...)                           \
+  TIT_DEFINE_FIELD(TIT_PASS(SymMat<Real, Dim>), name __VA_OPT__(, __VA_ARGS__))
+
 /// Field name.
 template<meta::type Field>
 inline constexpr auto field_name_v = std::remove_cvref_t<Field>::field_name;
 
 /// Space specification.
+///
+/// Particle fields are stored using the numeric type `Num`. Pair contributions
+/// to the fields may be accumulated using a wider numeric type `AccumNum`, for
+/// example, fields could be stored in `float` and summed in `double`.
+///
 /// @todo We shall think more about the concept of space.
-template<class Num, size_t Dim>
+template<class Num, size_t Dim, class AccumNum = Num>
 struct Space {};
 
 namespace impl {
 template<class T>
 struct is_space : std::false_type {};
-template<class Num, size_t Dim>
-struct is_space<Space<Num, Dim>> : std::true_type {};
+template<class Num, size_t Dim, class AccumNum>
+struct is_space<Space<Num, Dim, AccumNum>> : std::true_type {};
 } // namespace impl
 
 /// Space type.
@@ -156,8 +176,8 @@ concept space = impl::is_space<S>::value;
 template<meta::type Field, class Space>
 struct field_value;
 
-template<meta::type Field, class Real, size_t Dim>
-struct field_value<Field, Space<Real, Dim>> {
+template<meta::type Field, class Real, size_t Dim, class AccumReal>
+struct field_value<Field, Space<Real, Dim, AccumReal>> {
   using type =
       typename std::remove_cvref_t<Field>::template field_value_type<Real, Dim>;
 };
@@ -166,17 +186,33 @@ struct field_value<Field, Space<Real, Dim>> {
 template<meta::type Field, class Space>
 using field_value_t = typename field_value<Field, Space>::type;
 
+template<meta::type Field, class Space>
+struct field_accum_value;
+
+template<meta::type Field, class Real, size_t Dim, class AccumReal>
+struct field_accum_value<Field, Space<Real, Dim, AccumReal>> {
+  using type = field_value_t<Field, Space<AccumReal, Dim>>;
+};
+
+/// Field accumulation value type.
+template<meta::type Field, class Space>
+using field_accum_value_t = typename field_accum_value<Field, Space>::type;
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Particle partition index.
-using PartIndex = uint8_t;
+using PartIndex = uint16_t;
 
 /// Particle multilevel partition index.
+///
+/// Partition indices of all the levels fit into a single 64-bit word, so
+/// that the first common level of two particles is found with a single
+/// vector comparison.
 class PartVec final {
 public:
 
   /// Number of partition levels.
-  static constexpr size_t MaxNumLevels = 8;
+  static constexpr size_t MaxNumLevels = 4;
 
   /// Construct a multilevel partition index.
   /// @{
@@ -250,6 +286,8 @@ TIT_DEFINE_SCALAR_FIELD(rho)
 TIT_DEFINE_VECTOR_FIELD(grad_rho)
 /// Particle density time derivative.
 TIT_DEFINE_SCALAR_FIELD(drho_dt)
+/// Particle volume, the mass divided by the density.
+TIT_DEFINE_SCALAR_FIELD(vol)
 
 /// Particle width.
 TIT_DEFINE_SCALAR_FIELD(h)
@@ -258,6 +296,8 @@ TIT_DEFINE_SCALAR_FIELD(h)
 TIT_DEFINE_SCALAR_FIELD(p)
 /// Particle sound speed.
 TIT_DEFINE_SCALAR_FIELD(cs)
+/// Particle pressure divided by the squared density.
+TIT_DEFINE_SCALAR_FIELD(p_rho2)
 
 /// Particle thermal energy.
 TIT_DEFINE_SCALAR_FIELD(u)
@@ -280,11 +320,18 @@ TIT_DEFINE_SCALAR_FIELD(C)
 /// Particle normal vector.
 TIT_DEFINE_VECTOR_FIELD(N)
 /// Particle renormalization matrix.
-TIT_DEFINE_MATRIX_FIELD(L)
+TIT_DEFINE_SYMMETRIC_MATRIX_FIELD(L)
 
 /// Particle free surface flag.
 TIT_DEFINE_SCALAR_FIELD(FS)
 
+/// Particle number of the consecutive quiet steps.
+TIT_DEFINE_FIELD(uint32_t, quiet)
+
+/// Particle index in the rigid body geometry, starting from one. Zero for the
+/// particles, that do not belong to any body.
+TIT_DEFINE_FIELD(uint32_t, body)
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 } // namespace tit
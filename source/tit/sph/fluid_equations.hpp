@@ -6,17 +6,37 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <concepts>
+#include <functional>
 #include <limits>
 #include <numbers>
+#include <optional>
 #include <ranges>
-
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/log.hpp"
 #include "tit/core/mat.hpp"
 #include "tit/core/math.hpp"
 #include "tit/core/meta.hpp"
+#include "tit/core/par/accum_buffer.hpp"
 #include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/atomic.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/par/task_group.hpp"
 #include "tit/core/profiler.hpp"
+#include "tit/core/simd.hpp"
+#include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
 
+#include "tit/graph/linear_solver.hpp"
+
+#include "tit/sph/boundary.hpp"
 #include "tit/sph/continuity_equation.hpp"
 #include "tit/sph/energy_equation.hpp"
 #include "tit/sph/equation_of_state.hpp"
@@ -26,18 +46,59 @@
 #include "tit/sph/motion_equation.hpp"
 #include "tit/sph/particle_array.hpp"
 #include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/particle_shifting.hpp"
+#include "tit/sph/viscosity.hpp"
 
 namespace tit::sph {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-/// Fluid equations with fixed kernel width and continuity equation.
+/// Pair interaction loop execution strategy.
+enum class PairLoop : uint8_t {
+  /// Blocks of pairs are processed in parallel level by level, so that no
+  /// two threads write into the same particle.
+  blocked,
+
+  /// All pairs are processed in parallel, and the contributions are
+  /// accumulated into the thread-private buffers, that are reduced afterwards.
+  /// Loops that write into the matrix fields are still blocked, since the
+  /// per-thread copies of those would be too large.
+  privatized,
+
+  /// Particles are processed in parallel, and each particle gathers the
+  /// contributions from all of its neighbors. Each pair is computed twice,
+  /// once for each particle, but no synchronization is needed, and each
+  /// particle field is written only once.
+  gather,
+
+  /// Pairs are processed color by color, and the pairs of each color are
+  /// processed in parallel, since they do not share any particles. Exposes
+  /// more parallelism than the blocks, regardless of the partitioning
+  /// quality, at the cost of a barrier per color.
+  colored,
+
+  /// Pairs are processed in parallel over the rows of the adjacency graph,
+  /// without any partitioning, and the contributions are added to the
+  /// particle fields atomically. Loops that write into the matrix fields are
+  /// still blocked, like with the privatized loops.
+  atomic,
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Fluid equations with uniform kernel width and continuity equation.
+///
+/// Kernel width is the same for all the particles. It is fixed, unless the
+/// target number of neighbors is given, and then it is adapted on the mesh
+/// rebuilds.
 template<motion_equation MotionEquation,
          continuity_equation ContinuityEquation,
          momentum_equation MomentumEquation,
          energy_equation EnergyEquation,
          equation_of_state EquationOfState,
-         kernel Kernel>
+         kernel Kernel,
+         domain_boundary Boundary,
+         particle_shifting ParticleShifting = NoParticleShifting>
 class FluidEquations final {
 public:
 
@@ -48,9 +109,11 @@ public:
       MomentumEquation::required_fields |   //
       EnergyEquation::required_fields |     //
       EquationOfState::required_fields |    //
-      Kernel::required_fields |
-      meta::Set{parinfo, dr, N, FS} | // TODO: these should not be here.
-      meta::Set{h, m, r, rho, p, v, dv_dt};
+      Kernel::required_fields |             //
+      meta::Set{parinfo} |                  //
+      ParticleShifting::required_fields |   //
+      meta::Set{h, m, r, rho, p, v, dv_dt} | //
+      meta::Set{vol, p_rho2};
 
   /// Set of particle fields that are modified.
   static constexpr auto modified_fields =
@@ -61,9 +124,19 @@ public:
       EquationOfState::modified_fields |           //
       Kernel::modified_fields |                    //
       meta::Set{rho, drho_dt, grad_rho, C, N, L} | //
-      meta::Set{p, v, dv_dt, div_v, curl_v} |      //
+      meta::Set{vol, p, p_rho2} |                  //
+      meta::Set{v, dv_dt, div_v, curl_v} |         //
       meta::Set{u, du_dt} |                        //
-      meta::Set{dr, FS};
+      ParticleShifting::modified_fields;
+
+  /// Set of particle fields that the pair loops read together for each
+  /// neighbor, see `ParticleArray` for the interleaved storage. Positions are
+  /// not included, since the neighbor search needs them contiguous.
+  static constexpr meta::Set pair_fields{h, m, rho, vol, p, p_rho2, v};
+
+  /// Is the viscosity applied implicitly, see `apply_implicit_viscosity`?
+  static constexpr bool has_implicit_viscosity =
+      MomentumEquation::has_implicit_viscosity;
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -75,18 +148,37 @@ public:
   /// @param energy_equation     Energy equation.
   /// @param equation_of_state   Equation of state.
   /// @param kernel              Kernel.
-  constexpr explicit FluidEquations(MotionEquation motion_equation,
-                                    ContinuityEquation continuity_equation,
-                                    MomentumEquation momentum_equation,
-                                    EnergyEquation energy_equation,
-                                    EquationOfState eos,
-                                    Kernel kernel) noexcept
+  /// @param boundary            Domain boundary.
+  /// @param particle_shifting   Particle shifting.
+  /// @param pair_loop           Pair interaction loop execution strategy.
+  /// @param target_neighbors    Target mean number of the fluid particle
+  ///                            neighbors, see `adapt_width_`. Zero keeps
+  ///                            the kernel width fixed.
+  constexpr explicit FluidEquations(
+      MotionEquation motion_equation,
+      ContinuityEquation continuity_equation,
+      MomentumEquation momentum_equation,
+      EnergyEquation energy_equation,
+      EquationOfState eos,
+      Kernel kernel,
+      Boundary boundary,
+      ParticleShifting particle_shifting = ParticleShifting{},
+      PairLoop pair_loop = PairLoop::blocked,
+      size_t target_neighbors = 0) noexcept
       : motion_equation_{std::move(motion_equation)},
         continuity_equation_{std::move(continuity_equation)},
         momentum_equation_{std::move(momentum_equation)},
         energy_equation_{std::move(energy_equation)}, //
         eos_{std::move(eos)},                         //
-        kernel_{std::move(kernel)} {}
+        kernel_{std::move(kernel)},                   //
+        boundary_{std::move(boundary)},               //
+        particle_shifting_{std::move(particle_shifting)},
+        pair_loop_{pair_loop}, target_neighbors_{target_neighbors} {}
+
+  /// Kernel.
+  constexpr auto kernel() const noexcept -> const Kernel& {
+    return kernel_;
+  }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -107,7 +199,24 @@ public:
            particle_array<required_fields> ParticleArray>
   auto index(ParticleMesh& mesh, ParticleArray& particles) const {
     using PV = ParticleView<ParticleArray>;
-    mesh.update(particles, [this](PV a) { return kernel_.radius(a); });
+    if (pair_loop_ == PairLoop::colored) mesh.set_pair_coloring(true);
+    const auto radius_func = [this](PV a) { return kernel_.radius(a); };
+    [[maybe_unused]] const auto num_rebuilds = mesh.num_rebuilds();
+    mesh.update(particles, radius_func, boundary_);
+
+    // Adapt the kernel width after the rebuild, and rebuild the mesh again
+    // with the new search radii if the width was changed. Varying widths are
+    // managed by the particles themselves and are never adapted.
+    if constexpr (has_uniform<ParticleArray>(h)) {
+      if (target_neighbors_ != 0 && mesh.num_rebuilds() != num_rebuilds &&
+          adapt_width_(mesh, particles)) {
+        mesh.invalidate();
+        mesh.update(particles, radius_func, boundary_);
+      }
+    } else {
+      TIT_ASSERT(target_neighbors_ == 0,
+                 "Varying kernel widths cannot be adapted!");
+    }
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -119,270 +228,368 @@ public:
     TIT_PROFILE_SECTION("FluidEquations::setup_boundary()");
     using PV = ParticleView<ParticleArray>;
     using Num = particle_num_t<ParticleArray>;
-    static constexpr auto Dim = particle_dim_v<ParticleArray>;
 
-    // Interpolate the field values on the boundary.
-    par::for_each(particles.fixed(), [this, &mesh](PV b) {
-      /// @todo Once we have a proper geometry library, we should use
-      ///       here and clean up the code.
-      const auto& search_point = r[b];
-      const auto clipped_point = Domain.clamp(search_point);
-      const auto r_ghost = 2 * clipped_point - search_point;
-      const auto SN = normalize(search_point - clipped_point);
-      const auto SD = norm(r_ghost - r[b]);
-
-      // Compute the interpolation weights, both for the constant and
-      // linear interpolations.
-      Num S{};
-      Mat<Num, Dim + 1> M{};
-      const auto h_ghost = RADIUS_SCALE * h[b];
-      for (const PV a : mesh.fixed_interp(b)) {
-        const auto r_delta = r_ghost - r[a];
-        const auto B_delta = vec_cat(Vec{Num{1.0}}, r_delta);
-        const auto W_delta = kernel_(r_delta, h_ghost);
-        S += W_delta * m[a] / rho[a];
-        M += outer(B_delta, B_delta * W_delta * m[a] / rho[a]);
-      }
+    // Fill the interpolation weights cache, if it is enabled and the mesh was
+    // rebuilt. Particles of the moving bodies are never cached.
+    if (mesh.interp_cache() && !mesh.has_cached_interp()) {
+      mesh.cache_interp(particles, [this, &mesh](PV b, std::span<real_t> W) {
+        if (!mesh.is_active(b) || boundary_.is_moving(b)) return false;
+        const auto r_ghost = mesh.fixed_projection(b).mirror;
+        const auto E = interp_coeffs_(mesh, b, r_ghost);
+        if (!E) return false;
+        for (auto&& [a, W_delta] : std::views::zip(mesh.fixed_interp(b), W)) {
+          W_delta = interp_weight_(*E, b, r_ghost - r[a]);
+        }
+        return true;
+      });
+    }
 
-      if (const auto fact = ldl(M); fact) {
-        // Linear interpolation succeeds, use it.
+    // Interpolate the field values on the boundary. Projections of the fixed
+    // particles onto the walls are computed by the mesh on each rebuild,
+    // while the particles of the moving bodies are projected on each step.
+    // Interpolation weights of the fixed particles are taken from the cache,
+    // if it is enabled. Inactive fixed particles do not interact with the
+    // fluid, so they are skipped.
+    par::for_each(mesh.active_fixed(particles), [this, &mesh](PV b) {
+      const auto is_moving = boundary_.is_moving(b);
+      const auto [r_ghost, SN, SD] =
+          is_moving ? boundary_.project(b) : mesh.fixed_projection(b);
+      const auto accumulate = [b](PV a, Num W_delta) {
+        rho[b] += m[a] * W_delta;
+        v[b] += m[a] / rho[a] * v[a] * W_delta;
+        if constexpr (has<PV>(u)) u[b] += m[a] / rho[a] * u[a] * W_delta;
+      };
+      if (!is_moving && mesh.has_cached_interp()) {
+        const auto W = mesh.cached_interp_weights(b);
+        if (!W) return; // Interpolation fails, leave the particle as it is.
         clear(b, rho, v, u);
-        const auto E = fact->solve(unit<0>(M[0]));
-        for (const PV a : mesh.fixed_interp(b)) {
-          const auto r_delta = r_ghost - r[a];
-          const auto B_delta = vec_cat(Vec{Num{1.0}}, r_delta);
-          const auto W_delta = dot(E, B_delta) * kernel_(r_delta, h_ghost);
-          rho[b] += m[a] * W_delta;
-          v[b] += m[a] / rho[a] * v[a] * W_delta;
-          if constexpr (has<PV>(u)) u[b] += m[a] / rho[a] * u[a] * W_delta;
+        for (auto&& [a, W_delta] : std::views::zip(mesh.fixed_interp(b), *W)) {
+          accumulate(a, static_cast<Num>(W_delta));
         }
-      } else if (!is_tiny(S)) {
-        // Constant interpolation succeeds, use it.
+      } else {
+        const auto E = interp_coeffs_(mesh, b, r_ghost);
+        if (!E) return; // Interpolation fails, leave the particle as it is.
         clear(b, rho, v, u);
-        const auto E = inverse(S);
         for (const PV a : mesh.fixed_interp(b)) {
-          const auto r_delta = r_ghost - r[a];
-          const auto W_delta = E * kernel_(r_delta, h_ghost);
-          rho[b] += m[a] * W_delta;
-          v[b] += m[a] / rho[a] * v[a] * W_delta;
-          if constexpr (has<PV>(u)) u[b] += m[a] / rho[a] * u[a] * W_delta;
+          accumulate(a, interp_weight_(*E, b, r_ghost - r[a]));
         }
-      } else {
-        // Both interpolations fail, leave the particle as it is.
-        return;
       }
 
       // Compute the density at the boundary.
-      // drho/dn = rho_0/(cs_0^2)*dot(g,n).
-      constexpr auto rho_0 = 1000.0;
-      constexpr auto cs_0 = 20 * sqrt(9.81 * 0.6);
-      constexpr auto G = Vec{0.0, -9.81};
-      rho[b] += SD * rho_0 / pow2(cs_0) * dot(G, SN);
-
-      // Compute the velocity at the boundary (slip wall boundary condition).
-      const auto Vn = dot(v[b], SN) * SN;
-      const auto Vt = v[b] - Vn;
-      v[b] = Vt - Vn;
+      rho[b] += boundary_.hydrostatic_density_jump(SD, SN);
+
+      // Compute the velocity at the boundary (slip wall boundary condition),
+      // relative to the velocity of the walls.
+      const auto V_wall = boundary_.wall_velocity(b);
+      const auto Vn = dot(v[b] - V_wall, SN) * SN;
+      const auto Vt = v[b] - V_wall - Vn;
+      v[b] = V_wall + Vt - Vn;
     });
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+  /// Move the rigid bodies of the boundary, if any, over the time step, and
+  /// update the mesh. Mesh is only rebuilt if the body particles or their
+  /// mirror images have moved further than the skin allows, so that the
+  /// interpolation adjacency follows the bodies. Should be called at the end
+  /// of each step, once the fluid particles are moved.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void move_bodies([[maybe_unused]] particle_num_t<ParticleArray> dt,
+                   [[maybe_unused]] ParticleMesh& mesh,
+                   [[maybe_unused]] ParticleArray& particles) const {
+    if constexpr (has<ParticleArray>(body)) {
+      const auto bodies = boundary_.bodies();
+      if (bodies == nullptr || bodies->size() == 0) return;
+      TIT_PROFILE_SECTION("FluidEquations::move_bodies()");
+      bodies->update(dt, particles);
+      index(mesh, particles);
+    }
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
   /// Compute density-related fields.
   template<particle_mesh ParticleMesh,
            particle_array<required_fields> ParticleArray>
   void compute_density(ParticleMesh& mesh, ParticleArray& particles) const {
     TIT_PROFILE_SECTION("FluidEquations::compute_density()");
-    using PV = ParticleView<ParticleArray>;
+    cache_kernel_and_clear_density_(mesh, particles);
+    prepare_density_(mesh, particles);
 
-    // Clean-up continuity equation fields and apply source terms.
-    par::for_each(particles.all(), [this](PV a) {
-      // Clean-up continuity equation fields.
-      clear(a, drho_dt, grad_rho, C, N, L);
-
-      // Apply continuity equation source terms.
-      std::apply([a](const auto&... f) { ((drho_dt[a] += f(a)), ...); },
-                 continuity_equation_.mass_sources());
-    });
+    // Compute density time derivative.
+    pair_for_each_(mesh,
+                   particles,
+                   meta::Set{drho_dt},
+                   [this](auto ab, auto kernel_ab, auto out) {
+                     const auto [a, b] = ab;
+                     const auto grad_W_ab = kernel_ab.grad_W();
+                     density_rate_pair_(a, b, grad_W_ab, out);
+                   });
+  }
 
-    // Compute density gradient and renormalization fields.
-    if constexpr (has<PV>(grad_rho) || has<PV>(C) || has<PV>(N) || has<PV>(L)) {
-      // Precompute the fields.
-      par::block_for_each(mesh.block_pairs(particles), [this](auto ab) {
-        const auto [a, b] = ab;
-        const auto V_a = m[a] / rho[a];
-        const auto V_b = m[b] / rho[b];
-        [[maybe_unused]] const auto W_ab = kernel_(a, b);
-        [[maybe_unused]] const auto grad_W_ab = kernel_.grad(a, b);
-
-        // Update density gradient.
-        if constexpr (has<PV>(grad_rho)) {
-          const auto grad_flux = rho[b, a] * grad_W_ab;
-          grad_rho[a] += V_b * grad_flux;
-          grad_rho[b] += V_a * grad_flux;
-        }
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-        // Update concentration.
-        if constexpr (has<PV>(C)) {
-          const auto C_flux = W_ab;
-          C[a] += V_b * C_flux;
-          C[b] += V_a * C_flux;
-        }
+  /// Compute velocity related fields.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void compute_forces(ParticleMesh& mesh, ParticleArray& particles) const {
+    TIT_PROFILE_SECTION("FluidEquations::compute_forces()");
+    using PV = ParticleView<ParticleArray>;
 
-        // Update normal vector.
-        if constexpr (has<PV>(N)) {
-          N[a] += V_b * grad_W_ab;
-          N[b] -= V_a * grad_W_ab;
-        }
+    // Compute velocity divergence and curl, those fields may be required by
+    // the artificial viscosity. Pressure and source terms do not depend on
+    // them, so they are computed at the same time.
+    run_phases_(
+        meta::Set{r, h, m, rho, v},
+        meta::Set{vol, div_v, curl_v},
+        [&mesh, &particles, this] {
+          cache_kernel_(mesh, particles);
+          if constexpr (has<PV>(div_v) || has<PV>(curl_v)) {
+            par::for_each(particles.all(), [](PV a) {
+              vol[a] = m[a] / rho[a];
+              clear(a, div_v, curl_v);
+            });
+            pair_for_each_(mesh,
+                           particles,
+                           meta::Set{div_v, curl_v},
+                           [this](auto ab, auto kernel_ab, auto out) {
+                             const auto [a, b] = ab;
+                             const auto grad_W_ab = kernel_ab.grad_W();
+                             velocity_gradient_pair_(a, b, grad_W_ab, out);
+                           });
+          }
+        },
+        prepare_forces_reads_,
+        meta::Set{p, p_rho2, cs, dv_dt, du_dt},
+        [&particles, this] {
+          prepare_forces_(particles, meta::Set{dv_dt, du_dt});
+        });
 
-        // Update renormalization matrix.
-        if constexpr (has<PV>(L)) {
-          const auto L_flux = outer(r[b, a], grad_W_ab);
-          L[a] += V_b * L_flux;
-          L[b] += V_a * L_flux;
-        }
-      });
+    // Compute velocity and internal energy time derivatives.
+    pair_for_each_(mesh,
+                   particles,
+                   meta::Set{dv_dt, du_dt},
+                   [this](auto ab, auto kernel_ab, auto out) {
+                     const auto [a, b] = ab;
+                     const auto grad_W_ab = kernel_ab.grad_W();
+                     force_pair_(a, b, grad_W_ab, out);
+                   });
+
+    finish_forces_(particles);
+  }
 
-      // Renormalize fields.
-      par::for_each(particles.all(), [](PV a) {
-        // Renormalize density, if possible.
-        if constexpr (has<PV>(C)) {
-          if (!is_tiny(C[a])) rho[a] /= C[a];
-        }
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-        // Renormalize density gradient and normal vector, if possible.
-        if constexpr (has<PV>(L) && (has<PV>(N) || has<PV>(grad_rho))) {
-          if (const auto fact = ldl(L[a]); fact) {
-            if constexpr (has<PV>(N)) N[a] = fact->solve(N[a]);
-            if constexpr (has<PV>(grad_rho))
-              grad_rho[a] = fact->solve(grad_rho[a]);
-          }
-        }
+  /// Compute density and velocity related fields.
+  ///
+  /// Same as `compute_density` immediately followed by `compute_forces`, but
+  /// the pair passes that do not depend on each other are fused, so the
+  /// adjacency is traversed less times and the kernel gradient is evaluated
+  /// once per pair for all of them. Should only be used when the particles
+  /// are not updated between the two computations.
+  ///
+  /// @param renormalize Compute the density gradient and the renormalization
+  ///                    fields, and renormalize the density. Otherwise, the
+  ///                    fields of the previous computation are reused.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void compute_rates(ParticleMesh& mesh,
+                     ParticleArray& particles,
+                     bool renormalize = true) const {
+    compute_rates(mesh, particles, AlwaysTrue{}, renormalize);
+  }
 
-        // Finalize the normal vector.
-        if constexpr (has<PV>(N)) N[a] = normalize(N[a]);
-      });
+  /// Compute density and velocity related fields for the active particles.
+  ///
+  /// Same as `compute_rates`, but only the neighbors of the particles marked
+  /// by @p is_active are traversed, so the work is proportional to the
+  /// number of the active pairs, and the time derivatives of the inactive
+  /// particles are left in an unspecified state. Fields that active particles
+  /// read from their neighbors, such as density gradient, renormalization
+  /// fields, and velocity divergence and curl, if the forces need them, are
+  /// computed for all the particles.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           std::predicate<ParticleView<ParticleArray>> ActiveFunc>
+  void compute_rates(ParticleMesh& mesh,
+                     ParticleArray& particles,
+                     const ActiveFunc& is_active,
+                     bool renormalize = true) const {
+    TIT_PROFILE_SECTION("FluidEquations::compute_rates()");
+    cache_kernel_and_clear_density_(mesh, particles, renormalize);
+    if (renormalize) prepare_density_(mesh, particles);
+    prepare_forces_(particles);
+
+    // Velocity divergence and curl must be known before the forces are
+    // computed if the momentum equation uses them.
+    static constexpr bool forces_need_velocity_gradient =
+        MomentumEquation::required_fields.contains(div_v) ||
+        MomentumEquation::required_fields.contains(curl_v);
+    if constexpr (forces_need_velocity_gradient) {
+      // Compute density time derivative, velocity divergence and curl.
+      pair_for_each_(mesh,
+                     particles,
+                     meta::Set{drho_dt, div_v, curl_v},
+                     [this](auto ab, auto kernel_ab, auto out) {
+                       const auto [a, b] = ab;
+                       const auto grad_W_ab = kernel_ab.grad_W();
+                       density_rate_pair_(a, b, grad_W_ab, out);
+                       velocity_gradient_pair_(a, b, grad_W_ab, out);
+                     });
+
+      // Compute velocity and internal energy time derivatives of the active
+      // particles.
+      active_pair_for_each_(mesh,
+                            particles,
+                            meta::Set{dv_dt, du_dt},
+                            is_active,
+                            [this](auto ab, auto kernel_ab, auto out) {
+                              const auto [a, b] = ab;
+                              const auto grad_W_ab = kernel_ab.grad_W();
+                              force_pair_(a, b, grad_W_ab, out);
+                            });
+    } else {
+      // Compute all the time derivatives, velocity divergence and curl of the
+      // active particles.
+      active_pair_for_each_(mesh,
+                            particles,
+                            meta::Set{drho_dt, div_v, curl_v, dv_dt, du_dt},
+                            is_active,
+                            [this](auto ab, auto kernel_ab, auto out) {
+                              const auto [a, b] = ab;
+                              const auto grad_W_ab = kernel_ab.grad_W();
+                              density_rate_pair_(a, b, grad_W_ab, out);
+                              velocity_gradient_pair_(a, b, grad_W_ab, out);
+                              force_pair_(a, b, grad_W_ab, out);
+                            });
     }
 
-    // Compute density time derivative.
-    par::block_for_each(mesh.block_pairs(particles), [this](auto ab) {
-      const auto [a, b] = ab;
-      const auto grad_W_ab = kernel_.grad(a, b);
-
-      // Update density time derivative.
-      const auto Psi_ab =
-          momentum_equation_.artificial_viscosity().density_term(a, b);
-      drho_dt[a] -= m[b] * dot(v[b, a] - Psi_ab / rho[b], grad_W_ab);
-      drho_dt[b] -= m[a] * dot(v[b, a] + Psi_ab / rho[a], grad_W_ab);
-    });
+    finish_forces_(particles);
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-  /// Compute velocity related fields.
+  /// Apply the implicit viscosity to the fluid particle velocities.
+  ///
+  /// Velocities are updated with the backward Euler step of the viscous term,
+  /// `v_new - dt * L(v_new) = v`, that is solved with BiCGStab. Does nothing
+  /// unless the viscosity is implicit. Should be called after the particle
+  /// velocities are updated with the explicit forces.
   template<particle_mesh ParticleMesh,
            particle_array<required_fields> ParticleArray>
-  void compute_forces(ParticleMesh& mesh, ParticleArray& particles) const {
-    TIT_PROFILE_SECTION("FluidEquations::compute_forces()");
-    using PV = ParticleView<ParticleArray>;
+  void apply_implicit_viscosity(
+      [[maybe_unused]] particle_num_t<ParticleArray> dt,
+      [[maybe_unused]] ParticleMesh& mesh,
+      [[maybe_unused]] ParticleArray& particles) const {
+    if constexpr (has_implicit_viscosity) {
+      TIT_PROFILE_SECTION("FluidEquations::apply_implicit_viscosity()");
+      using PV = ParticleView<ParticleArray>;
+      using Num = particle_num_t<PV>;
+      static constexpr auto Dim = particle_dim_v<PV>;
+
+      // Assemble the operator, the velocities are both the right hand side
+      // and the initial guess.
+      ImplicitViscosityOperator<Num, Dim> A{};
+      A.assemble(dt, kernel_, mesh, particles);
+      std::vector<Num> b(A.num_rows());
+      par::for_each(particles.all(), [&b](PV a) {
+        for (size_t i = 0; i < Dim; ++i) b[Dim * a.index() + i] = v[a][i];
+      });
+      auto x = b;
+
+      // Solve and store the velocities.
+      const auto& viscosity = momentum_equation_.viscosity();
+      const graph::BiCGStab solve{viscosity.max_iterations(),
+                                  viscosity.tolerance()};
+      const graph::JacobiPreconditioner<Num> M{A};
+      const auto result =
+          solve(A, std::span<const Num>{b}, std::span<Num>{x}, M);
+      if (!result.converged) {
+        TIT_WARN("Implicit viscosity did not converge in {} iterations, "
+                 "relative residual is {}.",
+                 result.num_iterations,
+                 result.residual);
+      }
+      par::for_each(particles.fluid(), [&x](PV a) {
+        for (size_t i = 0; i < Dim; ++i) v[a][i] = x[Dim * a.index() + i];
+      });
+    }
+  }
 
-    // Clean-up momentum and energy equation fields, compute pressure,
-    // sound speed and apply source terms.
-    par::for_each(particles.all(), [this](PV a) {
-      // Clean-up momentum and energy equation fields.
-      clear(a, dv_dt, div_v, curl_v, du_dt);
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-      // Apply source terms.
-      std::apply(
-          [a](const auto&... g) {
-            ((dv_dt[a] += g(a)), ...);
-            if constexpr (has<PV>(du_dt)) ((du_dt[a] += dot(g(a), v[a])), ...);
-          },
-          momentum_equation_.momentum_sources());
-      if constexpr (has<PV>(du_dt)) {
-        std::apply([a](const auto&... q) { ((du_dt[a] += q(a)), ...); },
-                   energy_equation_.energy_sources());
-      }
+  /// Compute the maximum stable time step.
+  ///
+  /// Time step is limited by the acoustic CFL condition, the force condition,
+  /// and, for the explicitly viscous flows, by the viscous diffusion
+  /// condition. Forces computed on the previous step are used.
+  ///
+  /// @param max_dt Upper bound of the time step.
+  template<particle_array<required_fields> ParticleArray>
+  auto time_step(ParticleArray& particles,
+                 particle_num_t<ParticleArray> max_dt) const
+      -> particle_num_t<ParticleArray> {
+    TIT_PROFILE_SECTION("FluidEquations::time_step()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<PV>;
 
-      // Compute pressure and sound speed.
-      p[a] = eos_.pressure(a);
-      if constexpr (has<PV>(cs)) cs[a] = eos_.sound_speed(a);
-    });
+    // Compute the time step for each thread, and then take the minimum.
+    std::vector<Num> thread_dts(par::num_threads(), max_dt);
+    par::static_for_each(particles.fluid(),
+                         [&thread_dts, this](size_t thread_index, PV a) {
+                           auto& dt = thread_dts[thread_index];
+                           dt = std::min(dt, time_step(a));
+                         });
+    return std::ranges::min(thread_dts);
+  }
 
-    // Compute velocity divergence and curl.
-    // Those fields may be required by the artificial viscosity.
-    if constexpr (has<PV>(div_v) || has<PV>(curl_v)) {
-      par::block_for_each(mesh.block_pairs(particles), [this](auto ab) {
-        const auto [a, b] = ab;
-        const auto V_a = m[a] / rho[a];
-        const auto V_b = m[b] / rho[b];
-        const auto grad_W_ab = kernel_.grad(a, b);
-
-        // Update velocity divergence.
-        if constexpr (has<PV>(div_v)) {
-          const auto div_flux = dot(v[b, a], grad_W_ab);
-          div_v[a] += V_b * div_flux;
-          div_v[b] += V_a * div_flux;
-        }
+  /// Compute the maximum stable time step for the particle.
+  template<particle_view<required_fields> PV>
+  auto time_step(PV a) const -> particle_num_t<PV> {
+    using Num = particle_num_t<PV>;
 
-        // Update velocity curl.
-        if constexpr (has<PV>(curl_v)) {
-          const auto curl_flux = -cross(v[b, a], grad_W_ab);
-          curl_v[a] += V_b * curl_flux;
-          curl_v[b] += V_a * curl_flux;
-        }
-      });
-    }
+    static constexpr Num CFL{0.8};
+    static constexpr Num ForceNumber{0.25};
+    static constexpr Num ViscousNumber{0.125};
 
-    // Compute velocity and internal energy time derivatives.
-    par::block_for_each(mesh.block_pairs(particles), [this](auto ab) {
-      const auto [a, b] = ab;
-      const auto grad_W_ab = kernel_.grad(a, b);
-
-      // Update velocity time derivative.
-      const auto P_a = p[a] / pow2(rho[a]);
-      const auto P_b = p[b] / pow2(rho[b]);
-      const auto Pi_ab =
-          momentum_equation_.viscosity()(a, b) +
-          momentum_equation_.artificial_viscosity().velocity_term(a, b);
-      const auto v_flux = (-P_a - P_b + Pi_ab) * grad_W_ab;
-      dv_dt[a] += m[b] * v_flux;
-      dv_dt[b] -= m[a] * v_flux;
-
-      // Update internal energy time derivative.
-      if constexpr (has<PV>(du_dt)) {
-        const auto Q_ab = energy_equation_.heat_conductivity()(a, b);
-        du_dt[a] -= m[b] * dot((P_a - Pi_ab / 2) * v[b, a] - Q_ab, grad_W_ab);
-        du_dt[b] -= m[a] * dot((P_b - Pi_ab / 2) * v[b, a] + Q_ab, grad_W_ab);
+    auto dt = CFL * h[a] / eos_.sound_speed(a);
+    if (const auto dv_dt_a = norm(dv_dt[a]); !is_tiny(dv_dt_a)) {
+      dt = std::min(dt, ForceNumber * sqrt(h[a] / dv_dt_a));
+    }
+    if constexpr (has<PV>(mu) && !has_implicit_viscosity) {
+      if (!is_tiny(mu[a])) {
+        dt = std::min(dt, ViscousNumber * rho[a] * pow2(h[a]) / mu[a]);
       }
-    });
-
-    // Compute artificial viscosity switch.
-    if constexpr (has<PV>(dalpha_dt)) {
-      par::for_each(particles.fluid(), [this](PV a) {
-        dalpha_dt[a] =
-            momentum_equation_.artificial_viscosity().switch_source(a);
-      });
     }
+    return dt;
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Compute particle shifts.
+  ///
+  /// Free surface is detected only on the steps, whose @p step_index is a
+  /// multiple of the detection frequency of the particle shifting, and the
+  /// particle classification of the last detection is used otherwise.
   template<particle_mesh ParticleMesh,
            particle_array<required_fields> ParticleArray>
   constexpr void compute_shifts(ParticleMesh& mesh,
-                                ParticleArray& particles) const {
+                                ParticleArray& particles,
+                                size_t step_index = 0) const {
     TIT_PROFILE_SECTION("FluidEquations::compute_shifts()");
+    static_assert(!std::same_as<ParticleShifting, NoParticleShifting>,
+                  "Particle shifting is disabled!");
     using PV = ParticleView<ParticleArray>;
     using Num = particle_num_t<PV>;
+    cache_kernel_(mesh, particles);
 
-    /// @todo Factor out the constants.
-    static constexpr Num R{0.2};
-    static constexpr Num Ma{0.1};
-    static constexpr Num CFL{0.8};
+    const auto R = static_cast<Num>(particle_shifting_.R());
+    const auto Ma = static_cast<Num>(particle_shifting_.Ma());
+    const auto CFL = static_cast<Num>(particle_shifting_.CFL());
 
-    // Initialize the free surface flag values and clear the particle shifts.
+    // Free surface flag values:
     // - Positive value `FS_FAR` means that the particle is far from the free
     //   surface.
     // - Any positive value in the range `(FS_FAR, FS_ON)` means that the
@@ -394,37 +601,109 @@ public:
     const auto a_0 = particles[0];
     const auto FS_FAR = 2 * CFL * Ma * pow2(h[a_0]);
     static constexpr auto FS_ON = std::numeric_limits<Num>::min();
-    par::for_each(particles.fluid(), [](PV a) { FS[a] = FS_ON, dr[a] = {}; });
-    par::for_each(particles.fixed(), [FS_FAR](PV a) { FS[a] = FS_FAR; });
+    par::for_each(particles.fluid(), [](PV a) { dr[a] = {}; });
+    if (step_index % particle_shifting_.detection_freq() == 0) {
+      detect_free_surface_(FS_ON, FS_FAR, mesh, particles);
+    }
 
-    // Classify the particles into free surface and non-free surface.
-    //
-    // Here we are reading and writing the same field `FS` in the parallel loop.
-    // There is no race condition because we read the neighbor to compare it
-    // with `FS_ON`, and non-free-surface particles are updated in the loop.
-    par::block_for_each(mesh.block_pairs(particles), [FS_FAR](auto ab) {
-      const auto [a, b] = ab;
+    // Compute the particle shifts.
+    const auto inv_W_0 = inverse(kernel_(unit(r[a_0], h[a_0] / 2), h[a_0]));
+    pair_for_each_(
+        mesh,
+        particles,
+        meta::Set{dr},
+        [inv_W_0, FS_FAR, R](auto ab, auto kernel_ab, auto out) {
+          const auto [a, b] = ab;
+          const auto W_ab = kernel_ab.W();
+          const auto grad_W_ab = kernel_ab.grad_W();
 
-      // Skip the particles that are too far away.
-      const auto r_ab = norm2(r[a, b]);
-      const auto dist_threshold = pow2(2 * h[a]);
-      if (r_ab > dist_threshold) return;
+          // Update the particle shifts.
+          const auto Chi_ab = R * pow<4>(W_ab * inv_W_0);
+          const auto Xi_a = static_cast<Num>(bitwise_equal(FS[a], FS_FAR));
+          const auto Xi_b = static_cast<Num>(bitwise_equal(FS[b], FS_FAR));
+          out(dr, a) -= (Xi_a + Chi_ab) * FS[a] * m[b] / rho[b] * grad_W_ab;
+          out(dr, b) += (Xi_b + Chi_ab) * FS[b] * m[a] / rho[a] * grad_W_ab;
+        });
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+private:
+
+  // Coefficients of the interpolation onto the ghost particle of the fixed
+  // particle. Linear interpolation is used, if it succeeds, otherwise the
+  // constant interpolation is used. Nothing is returned if both fail.
+  template<particle_mesh ParticleMesh, particle_view PV>
+  auto interp_coeffs_(const ParticleMesh& mesh,
+                      PV b,
+                      const particle_vec_t<PV>& r_ghost) const
+      -> std::optional<Vec<particle_num_t<PV>, particle_dim_v<PV> + 1>> {
+    using Num = particle_num_t<PV>;
+    static constexpr auto Dim = particle_dim_v<PV>;
+    Num S{};
+    Mat<Num, Dim + 1> M{};
+    const auto h_ghost = boundary_.interp_radius_scale() * h[b];
+    for (const PV a : mesh.fixed_interp(b)) {
+      const auto r_delta = r_ghost - r[a];
+      const auto B_delta = vec_cat(Vec{Num{1.0}}, r_delta);
+      const auto W_delta = kernel_(r_delta, h_ghost);
+      const auto V_delta = W_delta * m[a] / rho[a];
+      S += V_delta;
+      add_outer(M, B_delta, B_delta, V_delta);
+    }
+    if (const auto fact = ldl(M); fact) return fact->solve(unit<0>(M[0]));
+    if (!is_tiny(S)) return unit<0>(M[0]) * inverse(S);
+    return std::nullopt;
+  }
 
-      // Perform "visibility" test. The actual test is just an optimized
-      // version of `acos(n_{a,b} / sqrt(r_ab)) <= fov`.
-      constexpr Num cos_fov{cos(std::numbers::pi / 4)};
-      const auto fov_threshold = cos_fov * r_ab;
-      if (bitwise_equal(FS[a], FS_ON)) {
+  // Interpolation weight of the particle, displaced by `r_delta` from the
+  // ghost particle of the fixed particle.
+  template<particle_view PV>
+  auto interp_weight_(
+      const Vec<particle_num_t<PV>, particle_dim_v<PV> + 1>& E,
+      PV b,
+      const particle_vec_t<PV>& r_delta) const -> particle_num_t<PV> {
+    using Num = particle_num_t<PV>;
+    const auto h_ghost = boundary_.interp_radius_scale() * h[b];
+    const auto B_delta = vec_cat(Vec{Num{1.0}}, r_delta);
+    return dot(E, B_delta) * kernel_(r_delta, h_ghost);
+  }
+
+  // Classify the particles into the ones on, near and far from the free
+  // surface, see `compute_shifts` for the flag values.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void detect_free_surface_(particle_num_t<ParticleArray> FS_ON,
+                            particle_num_t<ParticleArray> FS_FAR,
+                            ParticleMesh& mesh,
+                            ParticleArray& particles) const {
+    TIT_PROFILE_SECTION("FluidEquations::detect_free_surface_()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<PV>;
+
+    // Particle is on the free surface unless some neighbor within the reduced
+    // radius of `2h` passes the "visibility" test, that is an optimized
+    // version of `acos(n_{a,b} / sqrt(r_ab)) <= fov`. Each particle gathers
+    // from its own neighbors and stops at the first visible one, so there is
+    // no synchronization, and most of the interior particles only look at a
+    // few of the neighbors. Fixed and buffer particles are never on the free
+    // surface.
+    par::for_each(particles.fixed(), [FS_FAR](PV a) { FS[a] = FS_FAR; });
+    par::for_each(particles.buffer(), [FS_FAR](PV a) { FS[a] = FS_FAR; });
+    heavy_for_each(particles.fluid(), [FS_ON, FS_FAR, &mesh](PV a) {
+      const auto dist_threshold = pow2(2 * h[a]);
+      const auto is_visible = [a, dist_threshold](PV b) {
+        const auto r_ab = norm2(r[a, b]);
+        if (b == a || r_ab > dist_threshold) return false;
+        constexpr Num cos_fov{cos(std::numbers::pi / 4)};
         const auto n_a = dot(N[a], r[a, b]);
-        if (n_a > 0 && pow2(n_a) >= fov_threshold) FS[a] = FS_FAR;
-      }
-      if (bitwise_equal(FS[b], FS_ON)) {
-        const auto n_b = dot(N[b], r[a, b]);
-        if (n_b < 0 && pow2(n_b) >= fov_threshold) FS[b] = FS_FAR;
-      }
+        return n_a > 0 && pow2(n_a) >= cos_fov * r_ab;
+      };
+      FS[a] = std::ranges::any_of(mesh[a], is_visible) ? FS_FAR : FS_ON;
     });
 
-    // Classify the non-free surface particles into near and far categories.
+    // Classify the non-free surface particles into near and far categories,
+    // in a single pass over the neighbors.
     //
     // Here we are reading and writing the same field `FS` in the parallel loop.
     // There is no race condition because we update the field only when
@@ -436,46 +715,727 @@ public:
     // some other thread, and the chances of a false positive comparison with
     // distinct bits are very small, at least orders of magnitude smaller than
     // if we used zero.
-    par::for_each(particles.fluid(), [FS_FAR, &mesh, this](PV a) {
+    heavy_for_each(particles.fluid(), [FS_ON, FS_FAR, &mesh, this](PV a) {
       if (!bitwise_equal(FS[a], FS_FAR)) return;
+      std::optional<PV> nearest_fs;
+      auto nearest_dist = std::numeric_limits<Num>::max();
+      for (const PV b : mesh[a]) {
+        // Do not apply the shifts to the particles near the walls.
+        /// @todo No article mentions this. We shall investigate it.
+        if (b.is_fixed()) {
+          FS[a] = Num{1.0e-30} * FS_FAR;
+          return;
+        }
+        if (!bitwise_equal(FS[b], FS_ON)) continue;
+        if (const auto dist = norm2(r[a, b]); dist < nearest_dist) {
+          nearest_fs = b, nearest_dist = dist;
+        }
+      }
+      if (nearest_fs.has_value()) {
+        const auto b = *nearest_fs;
+        FS[a] *= abs(dot(N[b], r[a, b])) / kernel_.radius(a);
+      }
+    });
+  }
 
-      // Do not apply the shifts to the particles near the walls.
-      /// @todo No article mentions this. We shall investigate it.
-      if (std::ranges::any_of(mesh[a], [](PV b) { return b.is_fixed(); })) {
-        FS[a] = Num{1.0e-30} * FS_FAR;
-        return;
+  // Fill the kernel cache, and, at the same time, clean-up the continuity
+  // equation fields and apply the source terms. Density gradient and
+  // renormalization fields are kept, unless they are to be recomputed.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void cache_kernel_and_clear_density_(ParticleMesh& mesh,
+                                       ParticleArray& particles,
+                                       bool renormalize = true) const {
+    using PV = ParticleView<ParticleArray>;
+    run_phases_(
+        meta::Set{r, h},
+        meta::Set{/*empty*/},
+        [&mesh, &particles, this] { cache_kernel_(mesh, particles); },
+        ContinuityEquation::source_fields | meta::Set{m, rho},
+        meta::Set{vol, drho_dt, grad_rho, C, N, L},
+        [&particles, renormalize, this] {
+          par::for_each(particles.all(), [renormalize, this](PV a) {
+            // Compute the particle volume, that is read by the pair loops.
+            vol[a] = m[a] / rho[a];
+
+            // Clean-up continuity equation fields.
+            if (renormalize) clear(a, drho_dt, grad_rho, C, N, L);
+            else clear(a, drho_dt);
+
+            // Apply continuity equation source terms.
+            std::apply([a](const auto&... f) { ((drho_dt[a] += f(a)), ...); },
+                       continuity_equation_.mass_sources());
+          });
+        });
+  }
+
+  // Compute the density gradient and renormalization fields. Continuity
+  // equation fields must be cleaned-up.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void prepare_density_(ParticleMesh& mesh, ParticleArray& particles) const {
+    using PV = ParticleView<ParticleArray>;
+
+    // Compute density gradient and renormalization fields.
+    if constexpr (has<PV>(grad_rho) || has<PV>(C) || has<PV>(N) || has<PV>(L)) {
+      // Precompute the fields.
+      pair_for_each_(
+          mesh,
+          particles,
+          meta::Set{grad_rho, C, N, L},
+          [](auto ab, auto kernel_ab, auto out) {
+            const auto [a, b] = ab;
+            const auto V_a = vol[a];
+            const auto V_b = vol[b];
+            [[maybe_unused]] const auto W_ab = kernel_ab.W();
+            [[maybe_unused]] const auto grad_W_ab = kernel_ab.grad_W();
+
+            // Update density gradient.
+            if constexpr (has<PV>(grad_rho)) {
+              const auto grad_flux = rho[b, a] * grad_W_ab;
+              out(grad_rho, a) += V_b * grad_flux;
+              out(grad_rho, b) += V_a * grad_flux;
+            }
+
+            // Update concentration.
+            if constexpr (has<PV>(C)) {
+              const auto C_flux = W_ab;
+              out(C, a) += V_b * C_flux;
+              out(C, b) += V_a * C_flux;
+            }
+
+            // Update normal vector.
+            if constexpr (has<PV>(N)) {
+              out(N, a) += V_b * grad_W_ab;
+              out(N, b) -= V_a * grad_W_ab;
+            }
+
+            // Update renormalization matrix. Kernel gradient is parallel to
+            // the position difference, so the flux is symmetric.
+            if constexpr (has<PV>(L)) {
+              const auto L_flux = sym_outer(r[b, a], grad_W_ab);
+              out(L, a) += V_b * L_flux;
+              out(L, b) += V_a * L_flux;
+            }
+          });
+
+      // Renormalize fields. Particles are processed in batches, so that the
+      // renormalization matrices of the whole batch are factorized at once.
+      using Num = particle_num_t<ParticleArray>;
+      static constexpr auto Dim = particle_dim_v<ParticleArray>;
+      static constexpr auto Lanes = simd::max_reg_size_v<Num>;
+      par::for_each_batch(particles.all(), Lanes, [](auto batch) {
+        // Renormalize density, if possible.
+        if constexpr (has<PV>(C)) {
+          for (const PV a : batch) {
+            if (is_tiny(C[a])) continue;
+            rho[a] /= C[a];
+            vol[a] = m[a] / rho[a];
+          }
+        }
+
+        // Renormalize density gradient and normal vector, if possible.
+        if constexpr (has<PV>(L) && (has<PV>(N) || has<PV>(grad_rho))) {
+          const auto count = std::size(batch);
+          std::array<SymMat<Num, Dim>, Lanes> Ls{};
+          for (size_t l = 0; l < count; ++l) Ls[l] = L[batch[l]];
+          const auto fact = ldl_batch<Lanes>(
+              std::span<const SymMat<Num, Dim>>{Ls.data(), count});
+          const auto renormalize = [&batch, &fact, count](auto field) {
+            const auto x = fact.solve(VecPack<Num, Dim, Lanes>{
+                count,
+                [&batch, field](size_t l) { return field[batch[l]]; }});
+            for (size_t l = 0; l < count; ++l) {
+              if (fact.success(l)) field[batch[l]] = x.unpack(l);
+            }
+          };
+          if constexpr (has<PV>(N)) renormalize(N);
+          if constexpr (has<PV>(grad_rho)) renormalize(grad_rho);
+        }
+
+        // Finalize the normal vector.
+        if constexpr (has<PV>(N)) {
+          for (const PV a : batch) N[a] = normalize(N[a]);
+        }
+      });
+    }
+  }
+
+  // Fields that are read by `prepare_forces_`.
+  static constexpr auto prepare_forces_reads_ =
+      EquationOfState::required_fields | MomentumEquation::source_fields |
+      EnergyEquation::source_fields | meta::Set{rho, v};
+
+  // Clean-up the momentum and energy equation fields, compute pressure,
+  // sound speed and apply the source terms.
+  template<particle_array<required_fields> ParticleArray,
+           class Fields = decltype(meta::Set{dv_dt, div_v, curl_v, du_dt})>
+  void prepare_forces_(ParticleArray& particles,
+                       Fields cleared_fields = {}) const {
+    using PV = ParticleView<ParticleArray>;
+    par::for_each(particles.all(), [cleared_fields, this](PV a) {
+      // Clean-up momentum and energy equation fields.
+      cleared_fields.for_each([&a](auto field) { clear(a, field); });
+
+      // Apply source terms.
+      std::apply(
+          [a](const auto&... g) {
+            ((dv_dt[a] += g(a)), ...);
+            if constexpr (has<PV>(du_dt)) ((du_dt[a] += dot(g(a), v[a])), ...);
+          },
+          momentum_equation_.momentum_sources());
+      if constexpr (has<PV>(du_dt)) {
+        std::apply([a](const auto&... q) { ((du_dt[a] += q(a)), ...); },
+                   energy_equation_.energy_sources());
       }
 
-      constexpr auto on_fs = [](PV b) { return bitwise_equal(FS[b], FS_ON); };
-      if (std::ranges::any_of(mesh[a], on_fs)) {
-        auto fs_neighbors = std::views::filter(mesh[a], on_fs);
-        const auto dist_to_a = [a](PV b) { return norm2(r[a, b]); };
-        const auto b = *std::ranges::min_element(fs_neighbors, {}, dist_to_a);
-        FS[a] *= abs(dot(N[b], r[a, b])) / kernel_.radius(a);
+      // Compute pressure and sound speed.
+      p[a] = eos_.pressure(a);
+      p_rho2[a] = p[a] / pow2(rho[a]);
+      if constexpr (has<PV>(cs)) cs[a] = eos_.sound_speed(a);
+    });
+  }
+
+  // Compute the artificial viscosity switch.
+  template<particle_array<required_fields> ParticleArray>
+  void finish_forces_(ParticleArray& particles) const {
+    using PV = ParticleView<ParticleArray>;
+    if constexpr (has<PV>(dalpha_dt)) {
+      par::for_each(particles.fluid(), [this](PV a) {
+        dalpha_dt[a] =
+            momentum_equation_.artificial_viscosity().switch_source(a);
+      });
+    }
+  }
+
+  // Add the density time derivative contributions of the pair.
+  template<class PV>
+  void density_rate_pair_(PV a,
+                          PV b,
+                          const auto& grad_W_ab,
+                          const auto& out) const {
+    const auto Psi_ab =
+        momentum_equation_.artificial_viscosity().density_term(a, b);
+    out(drho_dt, a) -= dot(m[b] * v[b, a] - vol[b] * Psi_ab, grad_W_ab);
+    out(drho_dt, b) -= dot(m[a] * v[b, a] + vol[a] * Psi_ab, grad_W_ab);
+  }
+
+  // Add the velocity divergence and curl contributions of the pair.
+  template<class PV>
+  void velocity_gradient_pair_(PV a,
+                               PV b,
+                               const auto& grad_W_ab,
+                               const auto& out) const {
+    if constexpr (has<PV>(div_v) || has<PV>(curl_v)) {
+      const auto V_a = vol[a];
+      const auto V_b = vol[b];
+
+      // Update velocity divergence.
+      if constexpr (has<PV>(div_v)) {
+        const auto div_flux = dot(v[b, a], grad_W_ab);
+        out(div_v, a) += V_b * div_flux;
+        out(div_v, b) += V_a * div_flux;
+      }
+
+      // Update velocity curl.
+      if constexpr (has<PV>(curl_v)) {
+        const auto curl_flux = -cross(v[b, a], grad_W_ab);
+        out(curl_v, a) += V_b * curl_flux;
+        out(curl_v, b) += V_a * curl_flux;
+      }
+    }
+  }
+
+  // Add the velocity and internal energy time derivative contributions of
+  // the pair.
+  template<class PV>
+  void force_pair_(PV a,
+                   PV b,
+                   const auto& grad_W_ab,
+                   const auto& out) const {
+    // Update velocity time derivative.
+    const auto P_a = p_rho2[a];
+    const auto P_b = p_rho2[b];
+    const auto Pi_ab =
+        momentum_equation_.viscosity()(a, b) +
+        momentum_equation_.artificial_viscosity().velocity_term(a, b);
+    const auto v_flux = (-P_a - P_b + Pi_ab) * grad_W_ab;
+    out(dv_dt, a) += m[b] * v_flux;
+    out(dv_dt, b) -= m[a] * v_flux;
+
+    // Update internal energy time derivative.
+    if constexpr (has<PV>(du_dt)) {
+      const auto Q_ab = energy_equation_.heat_conductivity()(a, b);
+      out(du_dt, a) -=
+          m[b] * dot((P_a - Pi_ab / 2) * v[b, a] - Q_ab, grad_W_ab);
+      out(du_dt, b) -=
+          m[a] * dot((P_b - Pi_ab / 2) * v[b, a] + Q_ab, grad_W_ab);
+    }
+  }
+
+  // Maximum number of the kernel width iterations per rebuild.
+  static constexpr size_t MaxWidthIterations = 4;
+
+  // Relative deviation of the mean number of neighbors from the target, that
+  // is tolerated without changing the kernel width. Hysteresis keeps the
+  // width, and thus the mesh, unchanged on most of the rebuilds.
+  static constexpr real_t WidthTolerance = 0.1;
+
+  // Maximum kernel width change ratio per iteration.
+  static constexpr real_t MaxWidthRatio = 1.25;
+
+  // Adapt the kernel width, so that the mean number of the neighbors of the
+  // fluid particles is close to the target. Kernel width is uniform, so it
+  // bounds the mean work per particle, and the total work of the pair loops,
+  // as the particles compress or spread out. Width is iterated against the
+  // neighbor counts within the candidates of the last search, that are exact
+  // as long as the support radius does not exceed the search radius. Returns
+  // true if the width was changed.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  auto adapt_width_(const ParticleMesh& mesh, ParticleArray& particles) const
+      -> bool {
+    TIT_PROFILE_SECTION("FluidEquations::adapt_width()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    const auto fluid = particles.fluid();
+    const auto num_fluid = std::size(fluid);
+    if (num_fluid == 0) return false;
+
+    // Mean number of the neighbors within the radius, including the
+    // particle itself.
+    const auto mean_neighbors = [&mesh, fluid, num_fluid](Num radius) {
+      const auto radius_sqr = pow2(radius);
+      const auto total = par::transform_reduce(
+          fluid,
+          size_t{0},
+          std::plus{},
+          [&mesh, radius_sqr](PV a) {
+            return static_cast<size_t>(
+                std::ranges::count_if(mesh[a], [a, radius_sqr](PV b) {
+                  return norm2(r[a, b]) < radius_sqr;
+                }));
+          });
+      return static_cast<Num>(total) / static_cast<Num>(num_fluid);
+    };
+
+    // Iterate the width with the estimate of the neighbor count, that is
+    // proportional to the volume of the support.
+    const auto h_0 = h[particles];
+    const auto max_radius = kernel_.radius(h_0) + static_cast<Num>(mesh.skin());
+    const auto target = static_cast<Num>(target_neighbors_);
+    auto h_a = h_0;
+    for (size_t iter = 0; iter < MaxWidthIterations; ++iter) {
+      const auto radius = kernel_.radius(h_a);
+      if (radius > max_radius) break;
+      const auto count = mean_neighbors(radius);
+      if (abs(count - target) <= static_cast<Num>(WidthTolerance) * target) {
+        break;
+      }
+      const auto ratio = pow(target / std::max(count, Num{1.0}), Num{1} / Dim);
+      h_a *= std::clamp(ratio,
+                        Num{1.0} / static_cast<Num>(MaxWidthRatio),
+                        static_cast<Num>(MaxWidthRatio));
+    }
+    if (h_a == h_0) return false;
+    h[particles] = h_a;
+    return true;
+  }
+
+  // Run two phases of the computation, given the sets of the particle fields
+  // each of them reads and writes. Phases run concurrently if none of them
+  // writes a field that the other one accesses, and one after another
+  // otherwise.
+  template<class ReadsA,
+           class WritesA,
+           std::invocable PhaseA,
+           class ReadsB,
+           class WritesB,
+           std::invocable PhaseB>
+  static void run_phases_(ReadsA /*reads_a*/,
+                          WritesA /*writes_a*/,
+                          PhaseA phase_a,
+                          ReadsB /*reads_b*/,
+                          WritesB /*writes_b*/,
+                          PhaseB phase_b) {
+    static constexpr bool independent =
+        (WritesA{} & (ReadsB{} | WritesB{})) == meta::Set{} &&
+        (WritesB{} & ReadsA{}) == meta::Set{};
+    if constexpr (independent) {
+      // Note: the first phase runs on the calling thread, since the pair
+      //       loops keep their buffers per calling thread.
+      par::TaskGroup group{};
+      group.run(std::move(phase_b));
+      phase_a();
+      group.wait();
+    } else {
+      phase_a();
+      phase_b();
+    }
+  }
+
+  // Compact the mesh pairs and fill the mesh kernel cache for the current
+  // particle positions, if those are enabled. Pairs outside of the kernel
+  // support contribute nothing to any of the pair loops. Both are skipped if
+  // the cache is still filled for the current positions, e.g. when the
+  // forces are computed right after the density.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void cache_kernel_(ParticleMesh& mesh, ParticleArray& particles) const {
+    using PV = ParticleView<ParticleArray>;
+    if (mesh.kernel_cache() && mesh.has_cached_kernel(particles)) return;
+    mesh.compact_pairs(particles, [this](PV a) { return kernel_.radius(a); });
+    if (mesh.kernel_cache()) {
+      mesh.cache_kernel(particles, pair_kernel_(particles));
+    }
+  }
+
+  // Smoothing kernel for the particle pairs. If the particle width is
+  // uniform, the kernel normalization is computed once per pair loop.
+  // Otherwise, the kernel is evaluated with the average width of the pair.
+  template<particle_array<required_fields> ParticleArray>
+  constexpr auto pair_kernel_(const ParticleArray& particles) const noexcept {
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    if constexpr (has_uniform<ParticleArray>(h)) {
+      return kernel_.template fixed_width<Dim>(h[particles]);
+    } else {
+      return kernel_;
+    }
+  }
+
+  // Kernel values of a pair. Values are read from the mesh kernel cache when
+  // it is filled and the pair index is known, and evaluated otherwise.
+  template<particle_mesh ParticleMesh, particle_view PV, class PairKernel>
+  class PairKernel_ final {
+  public:
+
+    static constexpr auto NoIndex = std::numeric_limits<size_t>::max();
+
+    constexpr PairKernel_(const PairKernel& kernel,
+                          const ParticleMesh& mesh,
+                          PV a,
+                          PV b,
+                          size_t index = NoIndex) noexcept
+        : kernel_{&kernel}, mesh_{&mesh}, a_{a}, b_{b}, index_{index} {}
+
+    constexpr auto W() const -> particle_num_t<PV> {
+      if (index_ != NoIndex) return mesh_->template cached_kernel<PV>(index_);
+      return (*kernel_)(a_, b_);
+    }
+
+    constexpr auto grad_W() const -> particle_vec_t<PV> {
+      if (index_ != NoIndex) {
+        return mesh_->template cached_kernel_grad<PV>(index_);
+      }
+      return kernel_->grad(a_, b_);
+    }
+
+  private:
+
+    const PairKernel* kernel_;
+    const ParticleMesh* mesh_;
+    PV a_;
+    PV b_;
+    size_t index_;
+
+  }; // class PairKernel_
+
+  // Is the field value a square or a symmetric matrix?
+  template<class Val>
+  static constexpr bool is_any_mat_v_ = is_mat_v<Val> || is_sym_mat_v<Val>;
+
+  // Type in which the pair contributions to the field are accumulated by the
+  // pair loops. Matrix fields are accumulated in the storage type.
+  template<auto field, class PV>
+  using field_accum_t_ =
+      std::conditional_t<is_any_mat_v_<particle_field_t<field, PV>>,
+                         particle_field_t<field, PV>,
+                         particle_field_accum_t<field, PV>>;
+
+  // Is the field accumulated in a type, that differs from the storage type?
+  template<auto field, class PV>
+  static constexpr bool is_wide_accum_v_ =
+      !std::same_as<field_accum_t_<field, PV>, particle_field_t<field, PV>>;
+
+  // Convert the value between the storage and the accumulation types.
+  template<class To, class From>
+  static constexpr auto accum_cast_(const From& val) -> To {
+    if constexpr (std::same_as<From, To>) return val;
+    else if constexpr (is_vec_v<To>) return vec_cast<vec_num_t<To>>(val);
+    else return static_cast<To>(val);
+  }
+
+  // Reference to the accumulated value that converts the contributions to
+  // the accumulation type.
+  template<class Accum>
+  class AccumRef_ final {
+  public:
+
+    constexpr explicit AccumRef_(Accum& accum) noexcept : accum_{&accum} {}
+
+    template<class Val>
+    constexpr auto operator+=(const Val& val) -> AccumRef_& {
+      *accum_ += accum_cast_<Accum>(val);
+      return *this;
+    }
+
+    template<class Val>
+    constexpr auto operator-=(const Val& val) -> AccumRef_& {
+      *accum_ -= accum_cast_<Accum>(val);
+      return *this;
+    }
+
+  private:
+
+    Accum* accum_;
+
+  }; // class AccumRef_
+
+  // Reference to the particle field value, to which the contributions are
+  // added atomically.
+  template<class Val>
+  class AtomicRef_ final {
+  public:
+
+    constexpr explicit AtomicRef_(Val& val) noexcept : val_{&val} {}
+
+    template<class Delta>
+    auto operator+=(const Delta& delta) -> AtomicRef_& {
+      par::atomic_add(*val_, accum_cast_<Val>(delta));
+      return *this;
+    }
+
+    template<class Delta>
+    auto operator-=(const Delta& delta) -> AtomicRef_& {
+      par::atomic_add(*val_, -accum_cast_<Val>(delta));
+      return *this;
+    }
+
+  private:
+
+    Val* val_;
+
+  }; // class AtomicRef_
+
+  // Compute the contributions for the active particles. Pairs of all the
+  // particles are scattered with the configured pair loop, while only the
+  // rows of the active subset are gathered.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           field... Fields,
+           class ActiveFunc,
+           class Func>
+  void active_pair_for_each_(ParticleMesh& mesh,
+                             ParticleArray& particles,
+                             meta::Set<Fields...> fields,
+                             const ActiveFunc& is_active,
+                             const Func& func) const {
+    if constexpr (std::same_as<ActiveFunc, AlwaysTrue>) {
+      pair_for_each_(mesh, particles, fields, func);
+    } else {
+      gather_pairs_(mesh, particles, fields, is_active, func);
+    }
+  }
+
+  // Gather the contributions from the neighbors for each particle, that
+  // satisfies the predicate. Same as `pair_for_each_`, but the function
+  // computes both sides of the interaction, and the contributions to the
+  // neighbor are simply discarded, so that only the rows of the selected
+  // particles are traversed. Pair indices are not known here, so the kernel
+  // cache is not used.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           field... Fields,
+           class RowFunc,
+           class Func>
+  void gather_pairs_(ParticleMesh& mesh,
+                     ParticleArray& particles,
+                     meta::Set<Fields...> /*fields*/,
+                     const RowFunc& is_row,
+                     const Func& func) const {
+    using PV = ParticleView<ParticleArray>;
+    static constexpr auto fields = meta::Set<Fields...>{} & PV::fields;
+    const auto kernel = pair_kernel_(particles);
+    using PK = PairKernel_<ParticleMesh, PV, decltype(kernel)>;
+    using AccumVals = decltype([]<class... Fs>(meta::Set<Fs...> /*fields*/) {
+      return std::tuple<field_accum_t_<Fs{}, PV>...>{};
+    }(fields));
+    heavy_for_each(particles.all(), [&mesh, &is_row, &func, &kernel](PV a) {
+      if (!is_row(a)) return;
+      AccumVals own_vals{};
+      AccumVals discarded_vals{};
+      for (const PV b : mesh[a]) {
+        if (b == a) continue;
+        func(std::tuple{a, b},
+             PK{kernel, mesh, a, b},
+             [a, &own_vals, &discarded_vals](auto f, PV c) {
+               constexpr auto i = fields.find(decltype(f){});
+               return AccumRef_{c == a ? std::get<i>(own_vals) :
+                                         std::get<i>(discarded_vals)};
+             });
       }
+      fields.for_each([a, &own_vals](auto f) {
+        using Val = particle_field_t<decltype(f){}, PV>;
+        f[a] += accum_cast_<Val>(
+            std::get<fields.find(decltype(f){})>(own_vals));
+      });
     });
+  }
 
-    // Compute the particle shifts.
-    const auto inv_W_0 = inverse(kernel_(unit(r[a_0], h[a_0] / 2), h[a_0]));
-    par::block_for_each(
-        mesh.block_pairs(particles),
-        [inv_W_0, FS_FAR, this](auto ab) {
-          const auto [a, b] = ab;
-          const auto W_ab = kernel_(a, b);
-          const auto grad_W_ab = kernel_.grad(a, b);
+  // Iterate over the pairs of the adjacent particles. The function is called
+  // as `func(ab, kernel_ab, out)`, where `kernel_ab` provides the kernel
+  // values of the pair, and `out(field, a)` returns a reference to which the
+  // contribution of the pair to `field[a]` should be added. Depending on the
+  // loop strategy, the function is called once or twice for each pair.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           field... Fields,
+           class Func>
+  void pair_for_each_(ParticleMesh& mesh,
+                      ParticleArray& particles,
+                      meta::Set<Fields...> /*fields*/,
+                      const Func& func) const {
+    using PV = ParticleView<ParticleArray>;
+    static constexpr auto fields = meta::Set<Fields...>{} & PV::fields;
+    const auto kernel = pair_kernel_(particles);
+    using PK = PairKernel_<ParticleMesh, PV, decltype(kernel)>;
+    static constexpr auto can_privatize =
+        []<class... Fs>(meta::Set<Fs...> /*fields*/) {
+          return (!is_any_mat_v_<particle_field_t<Fs{}, PV>> && ...);
+        }(fields);
+
+    // Gather the contributions from the neighbors for each particle.
+    if (pair_loop_ == PairLoop::gather) {
+      gather_pairs_(mesh, particles, fields, AlwaysTrue{}, func);
+      return;
+    }
 
-          // Update the particle shifts.
-          const auto Chi_ab = R * pow<4>(W_ab * inv_W_0);
-          const auto Xi_a = static_cast<Num>(bitwise_equal(FS[a], FS_FAR));
-          const auto Xi_b = static_cast<Num>(bitwise_equal(FS[b], FS_FAR));
-          dr[a] -= (Xi_a + Chi_ab) * FS[a] * m[b] / rho[b] * grad_W_ab;
-          dr[b] += (Xi_b + Chi_ab) * FS[b] * m[a] / rho[a] * grad_W_ab;
+    // Kernel values of the pair with the given index.
+    const auto use_cache = mesh.has_cached_kernel();
+    const auto kernel_ab = [&mesh, use_cache, &kernel](PV a, PV b, size_t i) {
+      return use_cache ? PK{kernel, mesh, a, b, i} : PK{kernel, mesh, a, b};
+    };
+
+    // Scatter the contributions into the thread-private buffers, and then
+    // reduce the buffers into the particle fields.
+    if constexpr (can_privatize) {
+      if (pair_loop_ == PairLoop::privatized) {
+        // Note: buffers are kept per calling thread, so that independent
+        //       simulations running in different threads do not share them.
+        thread_local auto thread_buffers =
+            []<class... Fs>(meta::Set<Fs...> /*fields*/) {
+              return std::tuple<
+                  par::AccumBuffer<field_accum_t_<Fs{}, PV>>...>{};
+            }(fields);
+        auto& buffers = thread_buffers;
+        std::apply(
+            [size = particles.size()](auto&... b) { (b.reset(size), ...); },
+            buffers);
+        par::flat_for_each(
+            mesh.indexed_block_pairs(particles),
+            [&func, &kernel_ab, &buffers](auto abi) {
+              const auto [a, b, i] = abi;
+              const auto local_vals = std::apply(
+                  [](auto&... buffer) { return std::tuple{buffer.local()...}; },
+                  buffers);
+              func(std::tuple{a, b},
+                   kernel_ab(a, b, i),
+                   [&local_vals](auto f, PV c) {
+                     return AccumRef_{std::get<fields.find(decltype(f){})>(
+                         local_vals)[c.index()]};
+                   });
+            });
+        fields.for_each([&particles, &buffers](auto f) {
+          using Val = particle_field_t<decltype(f){}, PV>;
+          std::get<fields.find(decltype(f){})>(buffers).reduce_into(
+              f[particles],
+              [](const auto& val) { return accum_cast_<Val>(val); });
         });
-  }
+        return;
+      }
+    }
 
-  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Accumulators of the scattered contributions. Fields, that are
+    // accumulated in a wider type than they are stored, are summed into the
+    // zeroed accumulators, that are converted and added to the fields once the
+    // loop is finished. Accumulators of the other fields stay empty, and the
+    // contributions are written directly into the fields.
+    auto accums = []<class... Fs>(meta::Set<Fs...> /*fields*/) {
+      return std::tuple<std::vector<field_accum_t_<Fs{}, PV>>...>{};
+    }(fields);
+    fields.for_each([&particles, &accums](auto f) {
+      if constexpr (is_wide_accum_v_<decltype(f){}, PV>) {
+        std::get<fields.find(decltype(f){})>(accums).resize(particles.size());
+      }
+    });
+    const auto flush_accums = [&particles, &accums] {
+      fields.for_each([&particles, &accums](auto f) {
+        if constexpr (is_wide_accum_v_<decltype(f){}, PV>) {
+          using Val = particle_field_t<decltype(f){}, PV>;
+          const auto& accum = std::get<fields.find(decltype(f){})>(accums);
+          par::for_each(particles.all(), [f, &accum](PV a) {
+            f[a] += accum_cast_<Val>(accum[a.index()]);
+          });
+        }
+      });
+    };
+    const auto scatter_ref = [&accums](auto f, PV c) -> decltype(auto) {
+      if constexpr (is_wide_accum_v_<decltype(f){}, PV>) {
+        return AccumRef_{
+            std::get<fields.find(decltype(f){})>(accums)[c.index()]};
+      } else return f[c];
+    };
+
+    // Scatter the contributions, adding them atomically. Each pair is
+    // processed within the row of its second particle. Pair indices are not
+    // known here, so the kernel cache is not used.
+    if constexpr (can_privatize) {
+      if (pair_loop_ == PairLoop::atomic) {
+        const auto out = [&accums](auto f, PV c) {
+          if constexpr (is_wide_accum_v_<decltype(f){}, PV>) {
+            return AtomicRef_{
+                std::get<fields.find(decltype(f){})>(accums)[c.index()]};
+          } else return AtomicRef_{f[c]};
+        };
+        heavy_for_each(particles.all(), [&mesh, &func, &kernel, &out](PV b) {
+          for (const PV a : mesh[b]) {
+            if (a.index() >= b.index()) continue;
+            func(std::tuple{a, b}, PK{kernel, mesh, a, b}, out);
+          }
+        });
+        flush_accums();
+        return;
+      }
+    }
 
-private:
+    // Scatter the contributions color by color. Pairs of the same color do not
+    // share any particles, so they are written without synchronization.
+    if constexpr (requires { mesh.colored_pairs(particles); }) {
+      if (pair_loop_ == PairLoop::colored) {
+        for (const auto color : mesh.colored_pairs(particles)) {
+          par::for_each(color, [&func, &kernel_ab, &scatter_ref](auto abi) {
+            const auto [a, b, i] = abi;
+            func(std::tuple{a, b}, kernel_ab(a, b, i), scatter_ref);
+          });
+        }
+        flush_accums();
+        return;
+      }
+    }
+
+    // Scatter the contributions block by block. Blocks, that share any
+    // particles, are not processed concurrently.
+    par::deps_for_each(mesh.indexed_block_pairs(particles),
+                       mesh.block_deps(),
+                       [&func, &kernel_ab, &scatter_ref](auto abi) {
+                         const auto [a, b, i] = abi;
+                         func(std::tuple{a, b},
+                              kernel_ab(a, b, i),
+                              scatter_ref);
+                       });
+    flush_accums();
+  }
 
   [[no_unique_address]] MotionEquation motion_equation_;
   [[no_unique_address]] ContinuityEquation continuity_equation_;
@@ -483,6 +1443,10 @@ private:
   [[no_unique_address]] EnergyEquation energy_equation_;
   [[no_unique_address]] EquationOfState eos_;
   [[no_unique_address]] Kernel kernel_;
+  Boundary boundary_;
+  [[no_unique_address]] ParticleShifting particle_shifting_;
+  PairLoop pair_loop_;
+  size_t target_neighbors_;
 
 }; // class FluidEquations
 
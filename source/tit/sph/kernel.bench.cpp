@@ -0,0 +1,144 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/kernel.hpp"
+
+#include "tit/testing/benchmark.hpp"
+
+namespace tit {
+namespace {
+
+using Vec3D = Vec<double, 3>;
+
+// Kernel width.
+constexpr double KernelWidth = 0.1;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Position differences of the pairs, that lie within the kernel support.
+template<sph::kernel Kernel>
+auto kernel_args(const Kernel& w, size_t count) -> std::vector<Vec3D> {
+  const auto half_radius = w.radius(KernelWidth) / 2.0;
+  auto xs = testing::random_points<double, 3>(count);
+  for (auto& x : xs) x = (2.0 * x - Vec3D(1.0)) * half_radius;
+  return xs;
+}
+
+// Evaluate the kernel at each of the points.
+template<sph::kernel Kernel>
+void bench_kernel_value(benchmark::State& state) {
+  const auto count = testing::setup_benchmark(state);
+  const Kernel w{};
+  const auto xs = kernel_args(w, count);
+  std::vector<double> result(count);
+  for (auto _ : state) {
+    par::transform(xs, result.begin(), [&w](const Vec3D& x) {
+      return w(x, KernelWidth);
+    });
+    benchmark::DoNotOptimize(result.data());
+    benchmark::ClobberMemory();
+  }
+  testing::report_items(state, count);
+}
+
+// Evaluate the kernel gradient at each of the points.
+template<sph::kernel Kernel>
+void bench_kernel_grad(benchmark::State& state) {
+  const auto count = testing::setup_benchmark(state);
+  const Kernel w{};
+  const auto xs = kernel_args(w, count);
+  std::vector<Vec3D> result(count);
+  for (auto _ : state) {
+    par::transform(xs, result.begin(), [&w](const Vec3D& x) {
+      return w.grad(x, KernelWidth);
+    });
+    benchmark::DoNotOptimize(result.data());
+    benchmark::ClobberMemory();
+  }
+  testing::report_items(state, count);
+}
+
+// Evaluate the kernel width derivative at each of the points.
+template<sph::kernel Kernel>
+void bench_kernel_width_deriv(benchmark::State& state) {
+  const auto count = testing::setup_benchmark(state);
+  const Kernel w{};
+  const auto xs = kernel_args(w, count);
+  std::vector<double> result(count);
+  for (auto _ : state) {
+    par::transform(xs, result.begin(), [&w](const Vec3D& x) {
+      return w.width_deriv(x, KernelWidth);
+    });
+    benchmark::DoNotOptimize(result.data());
+    benchmark::ClobberMemory();
+  }
+  testing::report_items(state, count);
+}
+
+// Evaluate the kernel at each of the points, packing them into full-width
+// SIMD registers.
+template<sph::kernel Kernel>
+void bench_kernel_value_packed(benchmark::State& state) {
+  using Pack = VecPack<double, 3>;
+  static constexpr auto Lanes = Pack::num_lanes();
+  const auto count = testing::setup_benchmark(state);
+  const Kernel w{};
+  const auto xs = kernel_args(w, count);
+  std::vector<double> result(count);
+  const auto num_packs = (count + Lanes - 1) / Lanes;
+  for (auto _ : state) {
+    par::for_each(std::views::iota(0UZ, num_packs),
+                  [&w, &xs, &result](size_t i) {
+                    const auto first = i * Lanes;
+                    const auto num_lanes = std::min(Lanes, xs.size() - first);
+                    const Pack x_pack{std::span{xs}.subspan(first, num_lanes)};
+                    const auto values = w(x_pack, KernelWidth);
+                    std::copy_n(values.elems().begin(),
+                                num_lanes,
+                                &result[first]);
+                  });
+    benchmark::DoNotOptimize(result.data());
+    benchmark::ClobberMemory();
+  }
+  testing::report_items(state, count);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+#define BENCH_KERNEL(Kernel)                                                   \
+  BENCHMARK_TEMPLATE(bench_kernel_value, Kernel)                               \
+      ->Apply(testing::sweep_sizes_and_threads);                               \
+  BENCHMARK_TEMPLATE(bench_kernel_value_packed, Kernel)                        \
+      ->Apply(testing::sweep_sizes_and_threads);                               \
+  BENCHMARK_TEMPLATE(bench_kernel_grad, Kernel)                                \
+      ->Apply(testing::sweep_sizes_and_threads);                               \
+  BENCHMARK_TEMPLATE(bench_kernel_width_deriv, Kernel)                         \
+      ->Apply(testing::sweep_sizes_and_threads)
+
+BENCH_KERNEL(sph::GaussianKernel);
+BENCH_KERNEL(sph::CubicSplineKernel);
+BENCH_KERNEL(sph::QuarticSplineKernel);
+BENCH_KERNEL(sph::QuinticSplineKernel);
+BENCH_KERNEL(sph::QuarticWendlandKernel);
+BENCH_KERNEL(sph::SixthOrderWendlandKernel);
+BENCH_KERNEL(sph::EighthOrderWendlandKernel);
+BENCH_KERNEL(sph::TabulatedKernel<sph::GaussianKernel>);
+BENCH_KERNEL(sph::TabulatedKernel<sph::EighthOrderWendlandKernel>);
+
+#undef BENCH_KERNEL
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <concepts>
 #include <numbers>
 
@@ -24,6 +26,57 @@ namespace tit::sph {
 // Kernel class.
 //
 
+/// Smoothing kernel with the fixed width.
+///
+/// Normalization constants are computed once at construction, instead of
+/// for each evaluation, which is useful in the pair loops over the particles
+/// with the uniform width. Results match the ones of the underlying kernel
+/// bit by bit.
+template<class K, class Num, size_t Dim>
+class FixedWidthKernel final {
+public:
+
+  /// Construct the fixed width kernel.
+  constexpr FixedWidthKernel(const K& kernel, Num h) noexcept
+      : kernel_{&kernel}, h_inverse_{inverse(h)},
+        w_{K::template weight<Num, Dim>() * pow(h_inverse_, Dim)} {
+    TIT_ASSERT(h > Num{0.0}, "Kernel width must be positive!");
+  }
+
+  /// Value of the smoothing kernel at point.
+  constexpr auto operator()(const Vec<Num, Dim>& x) const noexcept -> Num {
+    const auto q = h_inverse_ * norm(x);
+    return w_ * kernel_->unit_value(q);
+  }
+
+  /// Spatial gradient of the smoothing kernel at point.
+  constexpr auto grad(const Vec<Num, Dim>& x) const noexcept
+      -> Vec<Num, Dim> {
+    const auto q = h_inverse_ * norm(x);
+    const auto grad_q = normalize(x) * h_inverse_;
+    return w_ * kernel_->unit_deriv(q) * grad_q;
+  }
+
+  /// Value of the smoothing kernel for two particles.
+  template<particle_view PV>
+  constexpr auto operator()(PV a, PV b) const noexcept -> Num {
+    return (*this)(r[a, b]);
+  }
+
+  /// Spatial gradient of the smoothing kernel for two particles.
+  template<particle_view PV>
+  constexpr auto grad(PV a, PV b) const noexcept -> Vec<Num, Dim> {
+    return grad(r[a, b]);
+  }
+
+private:
+
+  const K* kernel_;
+  Num h_inverse_;
+  Num w_;
+
+}; // class FixedWidthKernel
+
 /// Abstract smoothing kernel.
 class Kernel {
 public:
@@ -42,12 +95,13 @@ public:
     return self.radius(h[a]);
   }
 
-  /// Value of the smoothing kernel for two particles.
+  /// Value of the smoothing kernel for two particles. If the width is not
+  /// specified, the one of the particles is used, or the average of the
+  /// particle widths, if those are varying.
   /// @{
   template<particle_view<required_fields> PV>
   constexpr auto operator()(this auto& self, PV a, PV b) noexcept {
-    static_assert(has_uniform<PV>(h));
-    return self(r[a, b], h[a]);
+    return self(r[a, b], width_(a, b));
   }
   template<particle_view<required_fields> PV>
   constexpr auto operator()(this auto& self, PV a, PV b, auto h_ab) noexcept {
@@ -60,8 +114,7 @@ public:
   /// @{
   template<particle_view<required_fields> PV>
   constexpr auto grad(this auto& self, PV a, PV b) noexcept {
-    static_assert(has_uniform<PV>(h));
-    return self.grad(r[a, b], h[a]);
+    return self.grad(r[a, b], width_(a, b));
   }
   template<particle_view<required_fields> PV>
   constexpr auto grad(this auto& self, PV a, PV b, auto h_ab) noexcept {
@@ -74,8 +127,7 @@ public:
   /// @{
   template<particle_view<required_fields> PV>
   constexpr auto width_deriv(this auto& self, PV a, PV b) noexcept {
-    static_assert(has_uniform<PV>(h));
-    return self.width_deriv(r[a, b], h[a]);
+    return self.width_deriv(r[a, b], width_(a, b));
   }
   template<particle_view<required_fields> PV>
   constexpr auto width_deriv(this auto& self, PV a, PV b, auto h_ab) noexcept {
@@ -86,6 +138,13 @@ public:
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+  /// Smoothing kernel with the fixed width.
+  template<size_t Dim, class Self, class Num>
+  constexpr auto fixed_width(this const Self& self, Num h) noexcept
+      -> FixedWidthKernel<Self, Num, Dim> {
+    return {self, h};
+  }
+
   /// Support radius.
   template<class Num, class Self>
   constexpr auto radius(this Self& /*self*/, Num h) noexcept -> Num {
@@ -132,6 +191,67 @@ public:
     return dw_dh * self.unit_value(q) + w * self.unit_deriv(q) * dq_dh;
   }
 
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Values of the smoothing kernel at the packed points, e.g. position
+  /// differences of several particle pairs. Lanes are evaluated in one pass.
+  template<class Self, class Num, size_t Dim, size_t Lanes>
+  constexpr auto operator()(this Self& self,
+                            const VecPack<Num, Dim, Lanes>& x,
+                            const Num& h) noexcept -> Vec<Num, Lanes> {
+    TIT_ASSERT(h > Num{0.0}, "Kernel width must be positive!");
+    const auto h_inverse = inverse(h);
+    const auto w = Self::template weight<Num, Dim>() * pow(h_inverse, Dim);
+    const auto q = h_inverse * norm(x);
+    return w * self.unit_values(q);
+  }
+
+  /// Spatial gradients of the smoothing kernel at the packed points.
+  template<class Self, class Num, size_t Dim, size_t Lanes>
+  constexpr auto grad(this Self& self,
+                      const VecPack<Num, Dim, Lanes>& x,
+                      const Num& h) noexcept -> VecPack<Num, Dim, Lanes> {
+    TIT_ASSERT(h > Num{0.0}, "Kernel width must be positive!");
+    const auto h_inverse = inverse(h);
+    const auto w = Self::template weight<Num, Dim>() * pow(h_inverse, Dim);
+    const auto q = h_inverse * norm(x);
+    const auto grad_q = normalize(x) * h_inverse;
+    return (w * self.unit_derivs(q)) * grad_q;
+  }
+
+  /// Values of the unit smoothing kernel at several points.
+  ///
+  /// Lanes are evaluated one by one, kernels override this with the
+  /// vectorized implementation where possible.
+  template<class Self, class Num, size_t Lanes>
+  constexpr auto unit_values(this Self& self, const Vec<Num, Lanes>& q) noexcept
+      -> Vec<Num, Lanes> {
+    Vec<Num, Lanes> r;
+    for (size_t j = 0; j < Lanes; ++j) r[j] = self.unit_value(q[j]);
+    return r;
+  }
+
+  /// Derivatives of the unit smoothing kernel at several points.
+  ///
+  /// Lanes are evaluated one by one, kernels override this with the
+  /// vectorized implementation where possible.
+  template<class Self, class Num, size_t Lanes>
+  constexpr auto unit_derivs(this Self& self, const Vec<Num, Lanes>& q) noexcept
+      -> Vec<Num, Lanes> {
+    Vec<Num, Lanes> r;
+    for (size_t j = 0; j < Lanes; ++j) r[j] = self.unit_deriv(q[j]);
+    return r;
+  }
+
+private:
+
+  // Kernel width for two particles.
+  template<particle_view PV>
+  static constexpr auto width_(PV a, PV b) noexcept {
+    if constexpr (has_uniform<PV>(h)) return h[a];
+    else return h.avg(a, b);
+  }
+
 }; // class Kernel
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -162,12 +282,26 @@ public:
     return exp(-pow2(q));
   }
 
+  /// Values of the unit smoothing kernel at several points.
+  template<class Num, size_t Lanes>
+  static constexpr auto unit_values(const Vec<Num, Lanes>& q) noexcept
+      -> Vec<Num, Lanes> {
+    return exp(-(q * q));
+  }
+
   /// Derivative of the unit smoothing kernel at a point.
   template<class Num>
   static constexpr auto unit_deriv(Num q) noexcept -> Num {
     return -Num{2.0} * q * exp(-pow2(q));
   }
 
+  /// Derivatives of the unit smoothing kernel at several points.
+  template<class Num, size_t Lanes>
+  static constexpr auto unit_derivs(const Vec<Num, Lanes>& q) noexcept
+      -> Vec<Num, Lanes> {
+    return Num{-2.0} * q * exp(-(q * q));
+  }
+
 }; // class GaussianKernel
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -175,6 +309,25 @@ public:
 // Spline kernels.
 //
 
+namespace impl {
+
+// Evaluate the sum of `w_i * (q_i - q)^Power` over the pieces with `q < q_i`
+// for each lane. Scalar evaluation vectorizes over the pieces instead.
+template<size_t Power, class Num, size_t Pieces, size_t Lanes>
+constexpr auto spline_lanes(const Vec<Num, Pieces>& qi,
+                            const Vec<Num, Pieces>& wi,
+                            const Vec<Num, Lanes>& q) noexcept
+    -> Vec<Num, Lanes> {
+  Vec<Num, Lanes> r;
+  for (size_t k = 0; k < Pieces; ++k) {
+    const Vec<Num, Lanes> q_k(qi[k]);
+    r += filter(q < q_k, wi[k] * pow<Power>(q_k - q));
+  }
+  return r;
+}
+
+} // namespace impl
+
 /// Cubic B-spline (M4) smoothing kernel.
 class CubicSplineKernel final : public Kernel {
 public:
@@ -203,6 +356,15 @@ public:
     return sum(filter(qv < qi, wi * pow<3>(qi - qv)));
   }
 
+  /// Values of the unit smoothing kernel at several points.
+  template<class Num, size_t Lanes>
+  static constexpr auto unit_values(const Vec<Num, Lanes>& q) noexcept
+      -> Vec<Num, Lanes> {
+    constexpr Vec qi{Num{2.0}, Num{1.0}};
+    constexpr Vec wi{Num{0.25}, Num{-1.0}};
+    return impl::spline_lanes<3>(qi, wi, q);
+  }
+
   /// Derivative of the unit smoothing kernel at a point.
   template<class Num>
   static constexpr auto unit_deriv(Num q) noexcept -> Num {
@@ -212,6 +374,15 @@ public:
     return sum(filter(qv < qi, wi * pow2(qi - qv)));
   }
 
+  /// Derivatives of the unit smoothing kernel at several points.
+  template<class Num, size_t Lanes>
+  static constexpr auto unit_derivs(const Vec<Num, Lanes>& q) noexcept
+      -> Vec<Num, Lanes> {
+    constexpr Vec qi{Num{2.0}, Num{1.0}};
+    constexpr Vec wi{Num{-0.75}, Num{3.0}};
+    return impl::spline_lanes<2>(qi, wi, q);
+  }
+
 }; // class CubicSplineKernel
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -245,6 +416,15 @@ public:
     return sum(filter(qv < qi, wi * pow<4>(qi - qv)));
   }
 
+  /// Values of the unit smoothing kernel at several points.
+  template<class Num, size_t Lanes>
+  static constexpr auto unit_values(const Vec<Num, Lanes>& q) noexcept
+      -> Vec<Num, Lanes> {
+    constexpr Vec qi{Num{2.5}, Num{1.5}, Num{0.5}};
+    constexpr Vec wi{Num{1.0}, Num{-5.0}, Num{10.0}};
+    return impl::spline_lanes<4>(qi, wi, q);
+  }
+
   /// Derivative value of the unit smoothing kernel at a point.
   template<class Num>
   static constexpr auto unit_deriv(Num q) noexcept -> Num {
@@ -254,6 +434,15 @@ public:
     return sum(filter(qv < qi, wi * pow<3>(qi - qv)));
   }
 
+  /// Derivatives of the unit smoothing kernel at several points.
+  template<class Num, size_t Lanes>
+  static constexpr auto unit_derivs(const Vec<Num, Lanes>& q) noexcept
+      -> Vec<Num, Lanes> {
+    constexpr Vec qi{Num{2.5}, Num{1.5}, Num{0.5}};
+    constexpr Vec wi{Num{-4.0}, Num{20.0}, Num{-40.0}};
+    return impl::spline_lanes<3>(qi, wi, q);
+  }
+
 }; // class QuarticSplineKernel
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -287,6 +476,15 @@ public:
     return sum(filter(qv < qi, wi * pow<5>(qi - qv)));
   }
 
+  /// Values of the unit smoothing kernel at several points.
+  template<class Num, size_t Lanes>
+  static constexpr auto unit_values(const Vec<Num, Lanes>& q) noexcept
+      -> Vec<Num, Lanes> {
+    constexpr Vec qi{Num{3.0}, Num{2.0}, Num{1.0}};
+    constexpr Vec wi{Num{1.0}, Num{-6.0}, Num{15.0}};
+    return impl::spline_lanes<5>(qi, wi, q);
+  }
+
   /// Derivative of the unit smoothing kernel at a point.
   template<class Num>
   static constexpr auto unit_deriv(Num q) noexcept -> Num {
@@ -296,6 +494,15 @@ public:
     return sum(filter(qv < qi, wi * pow<4>(qi - qv)));
   }
 
+  /// Derivatives of the unit smoothing kernel at several points.
+  template<class Num, size_t Lanes>
+  static constexpr auto unit_derivs(const Vec<Num, Lanes>& q) noexcept
+      -> Vec<Num, Lanes> {
+    constexpr Vec qi{Num{3.0}, Num{2.0}, Num{1.0}};
+    constexpr Vec wi{Num{-5.0}, Num{30.0}, Num{-75.0}};
+    return impl::spline_lanes<4>(qi, wi, q);
+  }
+
 }; // class QuinticSplineKernel
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -326,6 +533,20 @@ public:
     return q < Num{2.0} ? self.unit_deriv_notrunc(q) : Num{0.0};
   }
 
+  /// Values of the unit smoothing kernel at several points.
+  template<class Num, size_t Lanes>
+  constexpr auto unit_values(this auto& self, const Vec<Num, Lanes>& q) noexcept
+      -> Vec<Num, Lanes> {
+    return filter(q < Vec<Num, Lanes>(Num{2.0}), self.unit_value_notrunc(q));
+  }
+
+  /// Derivatives of the unit smoothing kernel at several points.
+  template<class Num, size_t Lanes>
+  constexpr auto unit_derivs(this auto& self, const Vec<Num, Lanes>& q) noexcept
+      -> Vec<Num, Lanes> {
+    return filter(q < Vec<Num, Lanes>(Num{2.0}), self.unit_deriv_notrunc(q));
+  }
+
 }; // class WendlandKernel
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -426,15 +647,118 @@ public:
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Closed-form smoothing kernel type.
+template<class K>
+concept closed_form_kernel = std::same_as<K, GaussianKernel> || //
+                             std::same_as<K, CubicSplineKernel> ||
+                             std::same_as<K, QuarticSplineKernel> ||
+                             std::same_as<K, QuinticSplineKernel> ||
+                             std::same_as<K, QuarticWendlandKernel> ||
+                             std::same_as<K, SixthOrderWendlandKernel> ||
+                             std::same_as<K, EighthOrderWendlandKernel>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// Tabulated kernel.
+//
+
+/// Tabulated smoothing kernel.
+///
+/// Values and derivatives of the unit kernel are precomputed on a uniform
+/// grid over the support radius, and are evaluated by the cubic Hermite
+/// interpolation. Interpolated derivative is the exact derivative of the
+/// interpolated value. This pays off for the kernels, that are expensive to
+/// evaluate, like the higher-order Wendland kernels or the Gaussian kernel.
+template<closed_form_kernel K,
+         std::floating_point Num = real_t,
+         size_t NumIntervals = 1024>
+class TabulatedKernel final : public Kernel {
+public:
+
+  /// Kernel that is tabulated.
+  using BaseKernel = K;
+
+  /// Kernel weight.
+  template<class Real, size_t Dim>
+  static consteval auto weight() noexcept -> Real {
+    return K::template weight<Real, Dim>();
+  }
+
+  /// Unit support radius.
+  template<class Real>
+  static consteval auto unit_radius() noexcept -> Real {
+    return K::template unit_radius<Real>();
+  }
+
+  /// Tabulate the kernel.
+  constexpr explicit TabulatedKernel(const K& kernel = {}) noexcept {
+    for (size_t i = 0; i <= NumIntervals; ++i) {
+      const auto q = static_cast<Num>(i) * Step_;
+      values_[i] = kernel.unit_value(q);
+      derivs_[i] = kernel.unit_deriv(q) * Step_;
+    }
+  }
+
+  /// Value of the unit smoothing kernel at a point.
+  constexpr auto unit_value(Num q) const noexcept -> Num {
+    TIT_ASSERT(q >= Num{0.0}, "Kernel argument must be non-negative!");
+    if (q >= Radius_) return Num{0.0};
+    const auto [i, s] = locate_(q);
+    const auto t = Num{1.0} - s;
+    return t * t * ((Num{1.0} + Num{2.0} * s) * values_[i] + s * derivs_[i]) +
+           s * s * ((Num{3.0} - Num{2.0} * s) * values_[i + 1] -
+                    t * derivs_[i + 1]);
+  }
+
+  /// Derivative of the unit smoothing kernel at a point.
+  constexpr auto unit_deriv(Num q) const noexcept -> Num {
+    TIT_ASSERT(q >= Num{0.0}, "Kernel argument must be non-negative!");
+    if (q >= Radius_) return Num{0.0};
+    const auto [i, s] = locate_(q);
+    const auto t = Num{1.0} - s;
+    return (Num{6.0} * s * t * (values_[i + 1] - values_[i]) +
+            t * (Num{1.0} - Num{3.0} * s) * derivs_[i] +
+            s * (Num{3.0} * s - Num{2.0}) * derivs_[i + 1]) *
+           InvStep_;
+  }
+
+private:
+
+  // Index of the grid interval, that contains the point, and the local
+  // coordinate of the point inside of the interval.
+  struct Location_ final {
+    size_t index;
+    Num local;
+  };
+  static constexpr auto locate_(Num q) noexcept -> Location_ {
+    const auto t = q * InvStep_;
+    const auto i = std::min(static_cast<size_t>(t), NumIntervals - 1);
+    return {.index = i, .local = t - static_cast<Num>(i)};
+  }
+
+  static constexpr auto Radius_ = K::template unit_radius<Num>();
+  static constexpr auto Step_ = Radius_ / static_cast<Num>(NumIntervals);
+  static constexpr auto InvStep_ = static_cast<Num>(NumIntervals) / Radius_;
+
+  // Derivatives are stored scaled by the grid step.
+  std::array<Num, NumIntervals + 1> values_{};
+  std::array<Num, NumIntervals + 1> derivs_{};
+
+}; // class TabulatedKernel
+
+namespace impl {
+template<class K>
+inline constexpr bool is_tabulated_kernel_v = false;
+template<class K, class Num, size_t NumIntervals>
+inline constexpr bool
+    is_tabulated_kernel_v<TabulatedKernel<K, Num, NumIntervals>> = true;
+} // namespace impl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Smoothing kernel type.
 template<class K>
-concept kernel = std::same_as<K, GaussianKernel> || //
-                 std::same_as<K, CubicSplineKernel> ||
-                 std::same_as<K, QuarticSplineKernel> ||
-                 std::same_as<K, QuinticSplineKernel> ||
-                 std::same_as<K, QuarticWendlandKernel> ||
-                 std::same_as<K, SixthOrderWendlandKernel> ||
-                 std::same_as<K, EighthOrderWendlandKernel>;
+concept kernel = closed_form_kernel<K> || impl::is_tabulated_kernel_v<K>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
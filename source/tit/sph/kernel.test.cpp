@@ -3,6 +3,7 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <array>
 #include <numbers>
 
 #include "tit/core/math.hpp"
@@ -133,5 +134,63 @@ TEST_CASE_TEMPLATE("sph::Kernel::width_deriv", Kernel, KERNEL_TYPES) {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+TEST_CASE_TEMPLATE("sph::Kernel::operator()(VecPack)", Kernel, KERNEL_TYPES) {
+  // Ensure that the packed evaluation matches the point-wise one. Points are
+  // placed both inside and outside of the kernel support, the last lane is
+  // left unused.
+  const Kernel w{};
+  for (const double h : {1.0, 0.1, 0.01}) {
+    const auto r = w.radius(h);
+    const std::array xs{Vec{0.1 * r, 0.0, 0.0},
+                        Vec{0.3 * r, -0.2 * r, 0.1 * r},
+                        Vec{0.0, 1.5 * r, 0.0}};
+    const VecPack<double, 3, 4> x_pack{xs};
+    const auto values = w(x_pack, h);
+    const auto grads = w.grad(x_pack, h);
+    for (size_t j = 0; j < xs.size(); ++j) {
+      CHECK_APPROX_EQ(values[j], w(xs[j], h));
+      CHECK_APPROX_EQ(grads.unpack(j), w.grad(xs[j], h));
+    }
+    CHECK(grads.unpack(3) == Vec<double, 3>{});
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE_TEMPLATE("sph::Kernel::fixed_width", Kernel, KERNEL_TYPES) {
+  // Ensure that the fixed width kernel matches the kernel exactly.
+  const Kernel w{};
+  for (const double h : {1.0, 0.1, 0.01}) {
+    const auto w_h = w.template fixed_width<3>(h);
+    const auto x = pow2(h) * Vec{0.1, -0.2, 0.3};
+    CHECK(w_h(x) == w(x, h));
+    CHECK(w_h.grad(x) == w.grad(x, h));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE_TEMPLATE("sph::TabulatedKernel", Kernel, KERNEL_TYPES) {
+  // Ensure that the interpolated values and derivatives match the exact ones
+  // between the grid points, and vanish outside of the support.
+  const Kernel w{};
+  const sph::TabulatedKernel<Kernel> w_tab{};
+  const auto r = Kernel::template unit_radius<double>();
+  for (double q = 0.0; q < r; q += r / 97.0) {
+    CHECK_APPROX_EQ(w_tab.unit_value(q), w.unit_value(q));
+    CHECK_APPROX_EQ(w_tab.unit_deriv(q), w.unit_deriv(q));
+  }
+  CHECK(w_tab.unit_value(r) == 0.0);
+  CHECK(w_tab.unit_deriv(r) == 0.0);
+  SUBCASE("kernel") {
+    const auto x = Vec{0.1, -0.2, 0.3};
+    CHECK_APPROX_EQ(w_tab(x, 1.0), w(x, 1.0));
+    CHECK_APPROX_EQ(w_tab.grad(x, 1.0), w.grad(x, 1.0));
+    CHECK(w_tab.radius(0.1) == w.radius(0.1));
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace
 } // namespace tit
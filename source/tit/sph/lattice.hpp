@@ -0,0 +1,360 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <functional>
+#include <limits>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/rand_utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Kind of the particle lattice.
+enum class LatticeKind : uint8_t {
+  cartesian, ///< Cartesian lattice, points are the centers of the cubic cells.
+  hexagonal, ///< Hexagonal (close-packed) lattice.
+};
+
+/// Generator of the initial particle distributions.
+///
+/// Particles are placed at the points of a regular lattice with the spacing
+/// `dr`, that fall into the regions. Regions are boxes, solids defined by the
+/// signed distance functions, and wall layers. If a point falls into several
+/// regions, the first one that was added wins.
+///
+/// Particles are generated in two parallel passes over the lattice: the first
+/// one counts the particles of each type, so that the particle array is
+/// resized only once, and the second one writes the positions. Particles of
+/// each type are appended as a contiguous range, in the lattice order, so the
+/// result does not depend on the number of threads.
+template<class Num, size_t Dim>
+class LatticeFill final {
+public:
+
+  /// Point type.
+  using PointVec = Vec<Num, Dim>;
+
+  /// Bounding box type.
+  using PointBBox = geom::BBox<PointVec>;
+
+  /// Numbers of the particles of each type.
+  using TypeCounts =
+      std::array<size_t, std::to_underlying(ParticleType::count)>;
+
+  /// Construct the lattice with the spacing @p dr.
+  ///
+  /// @param origin Lattice origin. Points of the Cartesian lattice are the
+  ///               centers of the cubic cells with the corner at the origin.
+  constexpr explicit LatticeFill(Num dr,
+                                 LatticeKind kind = LatticeKind::cartesian,
+                                 const PointVec& origin = {})
+      : dr_{dr}, kind_{kind}, origin_{origin} {
+    TIT_ASSERT(dr_ > Num{0}, "Lattice spacing must be positive!");
+    spacing_ = PointVec(dr_);
+    if (kind_ == LatticeKind::hexagonal) {
+      if constexpr (Dim >= 2) spacing_[1] = dr_ * sqrt(Num{3.0}) / 2;
+      if constexpr (Dim >= 3) spacing_[2] = dr_ * sqrt(Num{6.0}) / 3;
+    }
+  }
+
+  /// Lattice spacing.
+  constexpr auto spacing() const noexcept -> Num {
+    return dr_;
+  }
+
+  /// Fill the box with the particles of the given type.
+  auto box(ParticleType type, const PointBBox& box) -> LatticeFill& {
+    return solid(type, box, [box](const PointVec& point) {
+      return in_box_(box, point) ? Num{-1} : Num{1};
+    });
+  }
+
+  /// Fill the solid with the particles of the given type.
+  ///
+  /// @param bounds Bounding box of the solid.
+  /// @param sdf    Signed distance function of the solid, that is negative
+  ///               inside of it. It is called from the multiple threads.
+  template<std::regular_invocable<const PointVec&> SDF>
+  auto solid(ParticleType type, const PointBBox& bounds, SDF sdf)
+      -> LatticeFill& {
+    TIT_ASSERT(type < ParticleType::count, "Invalid particle type!");
+    regions_.push_back({
+        .type = type,
+        .bounds = bounds,
+        .contains = [bounds, sdf = std::move(sdf)](const PointVec& point) {
+          return in_box_(bounds, point) && sdf(point) < Num{0};
+        },
+    });
+    return *this;
+  }
+
+  /// Fill the @p num_layers wall layers of the particles of the given type
+  /// around the box. Walls are not placed on the sides, that are marked as
+  /// open, e.g. the top of a pool.
+  ///
+  /// @param open_low  Axes, for which the lower side of the box is open.
+  /// @param open_high Axes, for which the upper side of the box is open.
+  auto walls(ParticleType type,
+             const PointBBox& box,
+             size_t num_layers,
+             const std::array<bool, Dim>& open_low = {},
+             const std::array<bool, Dim>& open_high = {}) -> LatticeFill& {
+    const auto thickness = static_cast<Num>(num_layers) * dr_;
+    auto low = box.low();
+    auto high = box.high();
+    auto outer_low = low;
+    auto outer_high = high;
+    for (size_t i = 0; i < Dim; ++i) {
+      if (open_low[i]) low[i] = std::numeric_limits<Num>::lowest();
+      else outer_low[i] -= thickness;
+      if (open_high[i]) high[i] = std::numeric_limits<Num>::max();
+      else outer_high[i] += thickness;
+    }
+    const PointBBox inner{low, high};
+    return solid(type,
+                 PointBBox{outer_low, outer_high},
+                 [inner](const PointVec& point) {
+                   return in_box_(inner, point) ? Num{1} : Num{-1};
+                 });
+  }
+
+  /// Displace the particles randomly by up to `amplitude * dr` along each
+  /// axis. Displacement of each particle depends only on the @p seed and
+  /// the lattice point, so it is reproducible.
+  auto jitter(Num amplitude, uint64_t seed) -> LatticeFill& {
+    TIT_ASSERT(amplitude >= Num{0}, "Jitter amplitude must be non-negative!");
+    jitter_ = amplitude * dr_;
+    seed_ = seed;
+    return *this;
+  }
+
+  /// Count the particles of each type.
+  auto count() const -> TypeCounts {
+    TypeCounts result{};
+    for (const auto& counts : count_blocks_(grid_())) {
+      for (size_t t = 0; t < result.size(); ++t) result[t] += counts[t];
+    }
+    return result;
+  }
+
+  /// Append the particles to the particle array. Only the positions of the
+  /// appended particles are set.
+  ///
+  /// @returns Number of the appended particles.
+  template<particle_array<r> ParticleArray>
+  auto append_to(ParticleArray& particles) const -> size_t {
+    const auto grid = grid_();
+    auto offsets = count_blocks_(grid);
+
+    // Append the particles of each type, in the type order, so that the
+    // ranges of the previously appended types are not shifted. Block counts
+    // are turned into the offsets of the blocks within the type ranges.
+    TypeCounts first{};
+    size_t total = 0;
+    for (size_t t = 0; t < first.size(); ++t) {
+      size_t count = 0;
+      for (auto& block_offsets : offsets) {
+        count += std::exchange(block_offsets[t], count);
+      }
+      if (count == 0) continue;
+      const auto appended =
+          particles.append_n(static_cast<ParticleType>(t), count);
+      first[t] = appended.front().index();
+      total += count;
+    }
+
+    // Write the positions.
+    par::for_each(
+        std::views::iota(size_t{0}, offsets.size()),
+        [this, &grid, &offsets, &first, &particles](size_t block) {
+          auto next = offsets[block];
+          const auto write = [this, &grid, &first, &next, &particles](
+                                 size_t index,
+                                 ParticleType type) {
+            const auto t = std::to_underlying(type);
+            r[particles[first[t] + next[t]++]] = position_(grid, index);
+          };
+          for_each_point_(grid, block, write);
+        });
+    return total;
+  }
+
+  /// Positions of the particles of the given type, in the lattice order.
+  /// Drivers, that append the particles through the type-erased solver, use
+  /// them instead of appending to the particle array.
+  auto positions(ParticleType type) const -> std::vector<PointVec> {
+    TIT_ASSERT(type < ParticleType::count, "Invalid particle type!");
+    const auto grid = grid_();
+    auto offsets = count_blocks_(grid);
+    const auto t = std::to_underlying(type);
+    size_t count = 0;
+    for (auto& block_offsets : offsets) {
+      count += std::exchange(block_offsets[t], count);
+    }
+
+    // Write the positions.
+    std::vector<PointVec> result(count);
+    par::for_each(
+        std::views::iota(size_t{0}, offsets.size()),
+        [this, &grid, &offsets, type, t, &result](size_t block) {
+          auto next = offsets[block][t];
+          const auto write = [this, &grid, type, &next, &result](
+                                 size_t index,
+                                 ParticleType point_type) {
+            if (point_type == type) result[next++] = position_(grid, index);
+          };
+          for_each_point_(grid, block, write);
+        });
+    return result;
+  }
+
+private:
+
+  // Number of the lattice points per block of the parallel passes.
+  static constexpr size_t BlockSize_ = 4096;
+
+  struct Region_ {
+    ParticleType type;
+    PointBBox bounds;
+    std::function<bool(const PointVec&)> contains;
+  };
+
+  // Range of the lattice indices that covers all the regions.
+  struct Grid_ {
+    Vec<int64_t, Dim> low;
+    Vec<size_t, Dim> extents;
+    size_t size = 0;
+  };
+
+  static constexpr auto in_box_(const PointBBox& box, const PointVec& point)
+      -> bool {
+    for (size_t i = 0; i < Dim; ++i) {
+      if (point[i] < box.low()[i] || box.high()[i] < point[i]) return false;
+    }
+    return true;
+  }
+
+  auto grid_() const -> Grid_ {
+    Grid_ grid{};
+    if (regions_.empty()) return grid;
+    auto bounds = regions_.front().bounds;
+    for (const auto& region : regions_) {
+      bounds.expand(region.bounds.low()).expand(region.bounds.high());
+    }
+    grid.size = 1;
+    for (size_t i = 0; i < Dim; ++i) {
+      // Hexagonal lattice rows are shifted by up to a half of the spacing, so
+      // the range is extended by one more point on each side.
+      const auto low = (bounds.low()[i] - origin_[i]) / spacing_[i];
+      const auto high = (bounds.high()[i] - origin_[i]) / spacing_[i];
+      grid.low[i] = static_cast<int64_t>(floor(low)) - 1;
+      const auto high_index = static_cast<int64_t>(ceil(high)) + 1;
+      grid.extents[i] = static_cast<size_t>(high_index - grid.low[i]);
+      grid.size *= grid.extents[i];
+    }
+    return grid;
+  }
+
+  // Lattice point at the flat index. Axis 0 varies the slowest.
+  auto point_(const Grid_& grid, size_t index) const -> PointVec {
+    Vec<int64_t, Dim> k{};
+    for (size_t i = Dim; i-- > 0;) {
+      k[i] = grid.low[i] + static_cast<int64_t>(index % grid.extents[i]);
+      index /= grid.extents[i];
+    }
+    PointVec point{};
+    for (size_t i = 0; i < Dim; ++i) {
+      point[i] = origin_[i] + (static_cast<Num>(k[i]) + Num{0.5}) * spacing_[i];
+    }
+    if (kind_ == LatticeKind::hexagonal) {
+      if constexpr (Dim >= 2) {
+        if (k[1] % 2 != 0) point[0] += dr_ / 2;
+      }
+      if constexpr (Dim >= 3) {
+        if (k[2] % 2 != 0) {
+          point[0] += dr_ / 2;
+          point[1] += spacing_[1] / 3;
+        }
+      }
+    }
+    return point;
+  }
+
+  // Jittered position of the particle at the lattice point.
+  auto position_(const Grid_& grid, size_t index) const -> PointVec {
+    auto point = point_(grid, index);
+    if (jitter_ == Num{0}) return point;
+    SplitMix64 rng{seed_ + index};
+    for (size_t i = 0; i < Dim; ++i) {
+      constexpr auto scale = Num{1.0} / static_cast<Num>(uint64_t{1} << 53);
+      const auto unit = static_cast<Num>(rng() >> 11) * scale;
+      point[i] += jitter_ * (2 * unit - 1);
+    }
+    return point;
+  }
+
+  // Invoke the function for each lattice point of the block, that falls into
+  // some region.
+  template<class Func>
+  void for_each_point_(const Grid_& grid, size_t block, Func func) const {
+    const auto first = block * BlockSize_;
+    const auto last = std::min(first + BlockSize_, grid.size);
+    for (size_t index = first; index < last; ++index) {
+      const auto point = point_(grid, index);
+      for (const auto& region : regions_) {
+        if (!region.contains(point)) continue;
+        func(index, region.type);
+        break;
+      }
+    }
+  }
+
+  // Count the particles of each type in each block.
+  auto count_blocks_(const Grid_& grid) const -> std::vector<TypeCounts> {
+    const auto num_blocks = (grid.size + BlockSize_ - 1) / BlockSize_;
+    std::vector<TypeCounts> counts(num_blocks);
+    par::for_each(std::views::iota(size_t{0}, num_blocks),
+                  [this, &grid, &counts](size_t block) {
+                    auto& block_counts = counts[block];
+                    const auto count = [&block_counts](size_t /*index*/,
+                                                       ParticleType type) {
+                      block_counts[std::to_underlying(type)] += 1;
+                    };
+                    for_each_point_(grid, block, count);
+                  });
+    return counts;
+  }
+
+  Num dr_;
+  LatticeKind kind_;
+  PointVec origin_;
+  PointVec spacing_;
+  std::vector<Region_> regions_;
+  Num jitter_ = Num{0};
+  uint64_t seed_ = 0;
+
+}; // class LatticeFill
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,162 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/lattice.hpp"
+#include "tit/sph/particle_array.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+using sph::r;
+
+using Vec2D = Vec<double, 2>;
+using BBox2D = geom::BBox<Vec2D>;
+using Space2D = sph::Space<double, 2>;
+using ParticleArray2D =
+    sph::ParticleArray<Space2D, meta::Set<>, decltype(meta::Set{r})>;
+using LatticeFill2D = sph::LatticeFill<double, 2>;
+
+// Positions of the particles of the range.
+auto positions(auto&& particles) -> std::vector<Vec2D> {
+  std::vector<Vec2D> result;
+  for (const auto a : particles) result.push_back(r[a]);
+  return result;
+}
+
+// Maximal distance between the corresponding points.
+auto max_distance(const std::vector<Vec2D>& a, const std::vector<Vec2D>& b)
+    -> double {
+  double result = 0.0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    result = std::max(result, norm(a[i] - b[i]));
+  }
+  return result;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::LatticeFill") {
+  ParticleArray2D particles{Space2D{}, meta::Set<>{}};
+  SUBCASE("box") {
+    // Points of the Cartesian lattice are the cell centers.
+    LatticeFill2D fill{0.1};
+    fill.box(sph::ParticleType::fluid, BBox2D{{0.0, 0.0}, {1.0, 0.5}});
+    CHECK(fill.count()[0] == 50);
+    REQUIRE(fill.append_to(particles) == 50);
+    REQUIRE(particles.size() == 50);
+    const auto points = positions(particles.fluid());
+    CHECK_APPROX_EQ(points.front(), Vec2D{0.05, 0.05});
+    CHECK_APPROX_EQ(points[1], Vec2D{0.05, 0.15});
+    CHECK_APPROX_EQ(points.back(), Vec2D{0.95, 0.45});
+  }
+  SUBCASE("walls") {
+    // Pool with the open top, partially filled with water. Walls are added
+    // first, but the particles of each type are still contiguous.
+    LatticeFill2D fill{0.1};
+    fill.walls(sph::ParticleType::fixed,
+               BBox2D{{0.0, 0.0}, {1.0, 1.0}},
+               2,
+               {false, false},
+               {false, true});
+    fill.box(sph::ParticleType::fluid, BBox2D{{0.0, 0.0}, {1.0, 0.5}});
+    REQUIRE(fill.append_to(particles) == 50 + 68);
+    REQUIRE(std::ranges::size(particles.fluid()) == 50);
+    REQUIRE(std::ranges::size(particles.fixed()) == 68);
+    for (const auto& point : positions(particles.fixed())) {
+      const bool inside = point[0] > 0.0 && point[0] < 1.0 && point[1] > 0.0;
+      CHECK_FALSE(inside);
+      CHECK(point[1] < 1.0);
+    }
+  }
+  SUBCASE("positions") {
+    // Positions of each type match the appended particles.
+    LatticeFill2D fill{0.1};
+    fill.walls(sph::ParticleType::fixed,
+               BBox2D{{0.0, 0.0}, {1.0, 1.0}},
+               2,
+               {false, false},
+               {false, true});
+    fill.box(sph::ParticleType::fluid, BBox2D{{0.0, 0.0}, {1.0, 0.5}});
+    fill.append_to(particles);
+    const auto fluid_points = fill.positions(sph::ParticleType::fluid);
+    const auto fixed_points = fill.positions(sph::ParticleType::fixed);
+    REQUIRE(fluid_points.size() == 50);
+    REQUIRE(fixed_points.size() == 68);
+    CHECK(max_distance(fluid_points, positions(particles.fluid())) == 0.0);
+    CHECK(max_distance(fixed_points, positions(particles.fixed())) == 0.0);
+    CHECK(fill.positions(sph::ParticleType::buffer).empty());
+  }
+  SUBCASE("solid") {
+    // Number of the particles in a disk is close to its area.
+    constexpr double radius = 0.5;
+    constexpr double dr = 0.01;
+    LatticeFill2D fill{dr};
+    fill.solid(sph::ParticleType::fluid,
+               BBox2D{{-radius, -radius}, {radius, radius}},
+               [](const Vec2D& point) { return norm(point) - radius; });
+    const auto area = std::numbers::pi * pow2(radius);
+    const auto expected = area / pow2(dr);
+    CHECK(std::abs(static_cast<double>(fill.count()[0]) - expected) <
+          0.01 * expected);
+  }
+  SUBCASE("hexagonal") {
+    // Nearest neighbors are at the lattice spacing.
+    constexpr double dr = 0.1;
+    LatticeFill2D fill{dr, sph::LatticeKind::hexagonal};
+    fill.box(sph::ParticleType::fluid, BBox2D{{0.0, 0.0}, {1.0, 1.0}});
+    fill.append_to(particles);
+    const auto points = positions(particles.all());
+    REQUIRE(points.size() > 100);
+    double min_dist = 1.0;
+    for (size_t i = 0; i < points.size(); ++i) {
+      for (size_t j = i + 1; j < points.size(); ++j) {
+        min_dist = std::min(min_dist, norm(points[i] - points[j]));
+      }
+    }
+    CHECK(min_dist == doctest::Approx(dr));
+  }
+  SUBCASE("jitter") {
+    // Jitter is bounded and reproducible.
+    const BBox2D box{{0.0, 0.0}, {1.0, 1.0}};
+    const auto jittered = [&box](uint64_t seed) {
+      ParticleArray2D result{Space2D{}, meta::Set<>{}};
+      LatticeFill2D fill{0.1};
+      fill.box(sph::ParticleType::fluid, box).jitter(0.2, seed);
+      fill.append_to(result);
+      return positions(result.all());
+    };
+    LatticeFill2D{0.1}.box(sph::ParticleType::fluid, box).append_to(particles);
+    const auto points = positions(particles.all());
+    const auto points_1 = jittered(1);
+    const auto points_2 = jittered(2);
+    REQUIRE(points_1.size() == points.size());
+    CHECK(max_distance(points_1, jittered(1)) == 0.0);
+    CHECK(max_distance(points_1, points_2) > 0.0);
+    CHECK(max_distance(points_1, points) <= 0.02 * std::numbers::sqrt2);
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -73,6 +73,13 @@ public:
       ArtificialViscosity::modified_fields |
       (MomentumSources::modified_fields | ... | meta::Set{/*empty*/});
 
+  /// Set of particle fields that are read by the source terms.
+  static constexpr auto source_fields =
+      (MomentumSources::required_fields | ... | meta::Set{/*empty*/});
+
+  /// Is the viscosity applied implicitly?
+  static constexpr bool has_implicit_viscosity = Viscosity::is_implicit;
+
   /// Construct the momentum equation.
   constexpr explicit MomentumEquation(
       Viscosity viscosity,
@@ -0,0 +1,218 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Buffer zone of an open boundary: a layer of the specified width behind
+/// the boundary plane, that is, the points for which the signed distance
+/// `dot(point - origin, normal)` lies in `[-width, 0)`.
+template<class Vec>
+struct OpenBoundaryZone final {
+  Vec origin;                 ///< Point on the boundary plane.
+  Vec normal;                 ///< Unit normal, directed into the fluid domain.
+  vec_num_t<Vec> width = 0.0; ///< Width of the buffer zone.
+
+  /// Signed distance from the point to the boundary plane.
+  constexpr auto dist(const Vec& point) const noexcept -> vec_num_t<Vec> {
+    return dot(point - origin, normal);
+  }
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Open boundary with an inflow and an outflow buffer zone.
+///
+/// Buffer particles of the inflow zone move with the prescribed velocity.
+/// Once such a particle crosses the inflow plane, it becomes a fluid
+/// particle, and a buffer particle with the same state takes its place one
+/// zone width behind. Fluid particles, that cross the outflow plane, become
+/// buffer particles and keep moving with their velocity, until they leave
+/// the outflow zone. The particles, that left the outflow zone, are
+/// recycled into the inflow zone as the replacements, so that in the steady
+/// flow the particles are never appended or removed.
+///
+/// Types of the particles are changed in place, which reorders them, so the
+/// particle mesh is invalidated after each change.
+template<class Vec>
+class OpenBoundary final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{r, v};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{r, v};
+
+  /// Buffer zone type.
+  using Zone = OpenBoundaryZone<Vec>;
+
+  /// Construct the open boundary.
+  ///
+  /// @param inflow          Inflow buffer zone.
+  /// @param inflow_velocity Velocity of the inflow buffer particles.
+  /// @param outflow         Outflow buffer zone.
+  constexpr OpenBoundary(Zone inflow, Vec inflow_velocity, Zone outflow)
+      : inflow_{std::move(inflow)},
+        inflow_velocity_{std::move(inflow_velocity)},
+        outflow_{std::move(outflow)} {
+    TIT_ASSERT(inflow_.width > 0, "Inflow zone width must be positive!");
+    TIT_ASSERT(outflow_.width > 0, "Outflow zone width must be positive!");
+    TIT_ASSERT(dot(inflow_velocity_, inflow_.normal) > 0,
+               "Inflow velocity must point into the fluid domain!");
+  }
+
+  /// Inflow buffer zone.
+  constexpr auto inflow() const noexcept -> const Zone& {
+    return inflow_;
+  }
+
+  /// Velocity of the inflow buffer particles.
+  constexpr auto inflow_velocity() const noexcept -> const Vec& {
+    return inflow_velocity_;
+  }
+
+  /// Outflow buffer zone.
+  constexpr auto outflow() const noexcept -> const Zone& {
+    return outflow_;
+  }
+
+  /// Move the buffer particles and exchange the particles between the buffer
+  /// zones and the fluid domain after a step in time.
+  ///
+  /// @returns True if the particles were exchanged, and the particle mesh was
+  ///          invalidated.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  auto update(particle_num_t<ParticleArray> dt,
+              ParticleMesh& mesh,
+              ParticleArray& particles) -> bool {
+    TIT_PROFILE_SECTION("OpenBoundary::update()");
+    using PV = ParticleView<ParticleArray>;
+    static_assert(std::same_as<particle_vec_t<PV>, Vec>);
+
+    // Move the buffer particles.
+    par::for_each(particles.buffer(), [dt, this](PV a) {
+      if (!is_outflowing_(a)) v[a] = inflow_velocity_;
+      r[a] += dt * v[a];
+    });
+
+    // Fluid particles, that crossed the outflow plane, join the outflow zone.
+    // Types are changed in the decreasing order, so that the swaps do not
+    // move the particles that are yet to be processed.
+    const auto outflowing = select_(particles.fluid(), [this](PV a) {
+      return outflow_.dist(r[a]) < 0;
+    });
+    for (const auto i : outflowing | std::views::reverse) {
+      particles.change_type(i, ParticleType::buffer);
+    }
+
+    // Find the inflow particles, that crossed the inflow plane, and the
+    // outflow particles, that left the outflow zone.
+    const auto entering = select_(particles.buffer(), [this](PV a) {
+      return !is_outflowing_(a) && inflow_.dist(r[a]) >= 0;
+    });
+    const auto leaving = select_(particles.buffer(), [this](PV a) {
+      return is_leaving_(a);
+    });
+
+    // Recycle the leaving particles into the replacements of the entering
+    // ones, and append new buffer particles if there are not enough of them.
+    // Appended particles follow the buffer particles, which are the last
+    // ones, so the columns are only extended at their ends.
+    const auto shift = inflow_.width * inflow_.normal;
+    const auto num_recycled = std::min(entering.size(), leaving.size());
+    for (size_t k = 0; k < num_recycled; ++k) {
+      particles.copy(entering[k], leaving[k]);
+      r[particles[leaving[k]]] -= shift;
+    }
+    if (entering.size() > num_recycled) {
+      const auto appended =
+          particles.append_copies(ParticleType::buffer,
+                                  std::span{entering}.subspan(num_recycled));
+      for (const PV a : appended) r[a] -= shift;
+    }
+
+    // Entering particles join the fluid. Types are changed in the increasing
+    // order, for the reasons above.
+    for (const auto i : entering) particles.change_type(i, ParticleType::fluid);
+
+    // Remove the leaving particles, that were not recycled.
+    if (leaving.size() > num_recycled) {
+      particles.remove_if([this](PV a) { return is_leaving_(a); });
+    }
+
+    // Particles were swapped between the type ranges, so the mesh is no
+    // longer valid.
+    const auto exchanged =
+        !outflowing.empty() || !entering.empty() || !leaving.empty();
+    if (exchanged) mesh.invalidate();
+    return exchanged;
+  }
+
+private:
+
+  // Is the buffer particle in the outflow zone?
+  template<particle_view PV>
+  constexpr auto is_outflowing_(PV a) const noexcept -> bool {
+    return outflow_.dist(r[a]) < 0;
+  }
+
+  // Has the buffer particle left the outflow zone?
+  template<particle_view PV>
+  constexpr auto is_leaving_(PV a) const noexcept -> bool {
+    return a.is_buffer() && outflow_.dist(r[a]) < -outflow_.width;
+  }
+
+  // Indices of the particles in the range, that satisfy the predicate, in
+  // the increasing order.
+  template<std::ranges::range Particles, class Pred>
+  static auto select_(Particles particles, const Pred& pred)
+      -> std::vector<size_t> {
+    using PV = std::ranges::range_value_t<Particles>;
+    if (std::ranges::empty(particles)) return {};
+    const auto first = (*std::ranges::begin(particles)).index();
+    std::vector<uint8_t> selected(std::ranges::size(particles), 0);
+    par::for_each(particles, [first, &selected, &pred](PV a) {
+      selected[a.index() - first] = pred(a) ? 1 : 0;
+    });
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < selected.size(); ++i) {
+      if (selected[i] != 0) indices.push_back(first + i);
+    }
+    return indices;
+  }
+
+  Zone inflow_;
+  Vec inflow_velocity_;
+  Zone outflow_;
+
+}; // class OpenBoundary
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
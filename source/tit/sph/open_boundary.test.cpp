@@ -0,0 +1,107 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <ranges>
+
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/search.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/open_boundary.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+using sph::r;
+using sph::v;
+
+using Vec2D = Vec<double, 2>;
+using Space2D = sph::Space<double, 2>;
+using ParticleArray2D =
+    sph::ParticleArray<Space2D, meta::Set<>, decltype(meta::Set{r, v})>;
+
+// Append the particle of the specified type.
+void append(ParticleArray2D& particles,
+            sph::ParticleType type,
+            const Vec2D& position,
+            const Vec2D& velocity) {
+  const auto a = particles.append(type);
+  r[a] = position, v[a] = velocity;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::OpenBoundary") {
+  // Channel along the X axis, with the inflow plane at zero and the outflow
+  // plane at ten.
+  sph::OpenBoundary<Vec2D> open_boundary{
+      {.origin = {0.0, 0.0}, .normal = {1.0, 0.0}, .width = 1.0},
+      {0.5, 0.0},
+      {.origin = {10.0, 0.0}, .normal = {-1.0, 0.0}, .width = 1.0}};
+  sph::ParticleMesh mesh{geom::GridSearch{1.0}};
+  ParticleArray2D particles{Space2D{}, meta::Set<>{}};
+  append(particles, sph::ParticleType::fluid, {5.0, 0.0}, {1.0, 0.0});
+  append(particles, sph::ParticleType::fluid, {9.0, 0.0}, {1.0, 0.0});
+  append(particles, sph::ParticleType::fixed, {5.0, -1.0}, {0.0, 0.0});
+  SUBCASE("recycle") {
+    append(particles, sph::ParticleType::buffer, {-0.02, 0.0}, {0.0, 0.0});
+    append(particles, sph::ParticleType::buffer, {10.95, 0.0}, {1.0, 0.0});
+    CHECK(open_boundary.update(0.1, mesh, particles));
+    // Entering particle joins the fluid, and the leaving particle takes its
+    // place in the inflow zone, so nothing is appended or removed.
+    REQUIRE(particles.size() == 5);
+    REQUIRE(std::ranges::size(particles.fluid()) == 3);
+    REQUIRE(std::ranges::size(particles.buffer()) == 1);
+    CHECK_APPROX_EQ(r[particles[2]], Vec2D{0.03, 0.0});
+    CHECK(v[particles[2]] == Vec2D{0.5, 0.0});
+    CHECK(particles.has_type(3, sph::ParticleType::fixed));
+    CHECK(r[particles[3]] == Vec2D{5.0, -1.0});
+    CHECK_APPROX_EQ(r[particles[4]], Vec2D{-0.97, 0.0});
+    CHECK(v[particles[4]] == Vec2D{0.5, 0.0});
+  }
+  SUBCASE("append and remove") {
+    append(particles, sph::ParticleType::buffer, {-0.02, 0.0}, {0.0, 0.0});
+    append(particles, sph::ParticleType::buffer, {10.5, 0.0}, {1.0, 0.0});
+    CHECK(open_boundary.update(0.1, mesh, particles));
+    // Outflow particle has not left the outflow zone yet, so the replacement
+    // of the entering particle is appended.
+    REQUIRE(particles.size() == 6);
+    REQUIRE(std::ranges::size(particles.fluid()) == 3);
+    REQUIRE(std::ranges::size(particles.buffer()) == 2);
+    CHECK_APPROX_EQ(r[particles[4]], Vec2D{10.6, 0.0});
+    CHECK_APPROX_EQ(r[particles[5]], Vec2D{-0.97, 0.0});
+    // Fluid particle crosses the outflow plane, and the outflow particle
+    // leaves the outflow zone, and is removed, since nothing enters.
+    r[particles[1]] = {10.2, 0.0};
+    r[particles[4]] = {10.95, 0.0};
+    CHECK(open_boundary.update(0.1, mesh, particles));
+    REQUIRE(particles.size() == 5);
+    REQUIRE(std::ranges::size(particles.fluid()) == 2);
+    REQUIRE(std::ranges::size(particles.buffer()) == 2);
+    CHECK_APPROX_EQ(r[particles[1]], Vec2D{0.03, 0.0});
+    CHECK(particles.has_type(2, sph::ParticleType::fixed));
+    CHECK(r[particles[3]] == Vec2D{10.2, 0.0});
+    CHECK_APPROX_EQ(r[particles[4]], Vec2D{-0.92, 0.0});
+  }
+  SUBCASE("no exchange") {
+    append(particles, sph::ParticleType::buffer, {-0.5, 0.0}, {0.0, 0.0});
+    CHECK_FALSE(open_boundary.update(0.1, mesh, particles));
+    REQUIRE(particles.size() == 4);
+    CHECK_APPROX_EQ(r[particles[3]], Vec2D{-0.45, 0.0});
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
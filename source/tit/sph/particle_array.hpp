@@ -5,9 +5,17 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <concepts>
+#include <cstring>
+#include <format>
+#include <optional>
 #include <ranges>
 #include <span>
+#include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -15,12 +23,32 @@
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/mat.hpp"
+#include "tit/core/memory_stats.hpp"
 #include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/par/first_touch.hpp"
+#include "tit/core/par/task_group.hpp"
+#include "tit/core/serialization.hpp"
+#include "tit/core/simd.hpp"
+#include "tit/core/stream.hpp"
 #include "tit/core/type_utils.hpp"
+#include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
 
+#include "tit/data/filter.hpp"
 #include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
 
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/decimate.hpp"
+#include "tit/geom/grid.hpp"
+#include "tit/geom/periodic_box.hpp"
+#include "tit/geom/point_range.hpp"
+
+#include "tit/sph/checkpoint.hpp"
 #include "tit/sph/field.hpp"
 
 namespace tit::sph {
@@ -29,11 +57,27 @@ namespace tit::sph {
 
 /// Particle type.
 enum class ParticleType : uint8_t {
-  fluid, ///< Fluid particle.
-  fixed, ///< Fixed (boundary) particle.
-  count, ///< Number of particle types.
+  fluid,  ///< Fluid particle.
+  fixed,  ///< Fixed (boundary) particle.
+  buffer, ///< Buffer particle of the open boundaries.
+  count,  ///< Number of particle types.
 };
 
+/// Output precision of a particle field.
+///
+/// Floating-point fields are written in the given precision instead of the
+/// one they are computed in, e.g. the 16-bit floats are plenty for the
+/// positions and velocities of the visualization snapshots.
+struct FieldPrecision final {
+
+  /// Name of the particle field.
+  std::string field_name;
+
+  /// Floating-point data kind, that the field is written with.
+  data::DataKind kind;
+
+}; // struct FieldPrecision
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Particle view.
@@ -88,6 +132,11 @@ public:
     return has_type(ParticleType::fixed);
   }
 
+  /// Check if the particle is a buffer particle.
+  constexpr auto is_buffer() const noexcept -> bool {
+    return has_type(ParticleType::buffer);
+  }
+
   /// Particle field value.
   template<field Field>
   constexpr auto operator[](Field field) const noexcept -> decltype(auto) {
@@ -134,8 +183,20 @@ concept particle_view =
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+template<class ParticleArray, field_set Fields>
+class ParticleColumnView;
+
 /// Particle array.
-template<space Space, field_set Uniforms, field_set Varyings>
+///
+/// Varying fields are stored in the separate columns, except for the
+/// interleaved ones, which are stored together in a single record per
+/// particle. Fields that are read together for each neighbor, like velocity
+/// and density in the pair loops, should be interleaved, so that a single
+/// cache line fetch serves all of them.
+template<space Space,
+         field_set Uniforms,
+         field_set Varyings,
+         field_set Interleaved = meta::Set<>>
 class ParticleArray final {
 public:
 
@@ -151,6 +212,12 @@ public:
   /// Set of particle fields that are present.
   static constexpr field_set auto fields = uniform_fields | varying_fields;
 
+  /// Subset of varying fields that are stored interleaved.
+  static constexpr Interleaved interleaved_fields{};
+
+  static_assert(varying_fields.includes(interleaved_fields),
+                "Only varying fields can be interleaved!");
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Construct a particle array.
@@ -161,27 +228,275 @@ public:
   constexpr explicit ParticleArray(Space /*space*/,
                                    Equations /*equations*/) noexcept {}
 
-  /// Write a particle array into a data series.
+  /// Construct a particle array with the interleaved fields.
+  ///
+  /// @param space The space in which the particles are defined.
+  /// @param equations The equations that define the particle fields.
+  /// @param interleaved Fields to interleave. Fields that are not varying
+  ///                    are stored as usual.
+  template<class Equations, field_set Fields>
+  constexpr ParticleArray(Space /*space*/,
+                          Equations /*equations*/,
+                          Fields /*interleaved*/) noexcept {}
+
+  /// Write a particle array into a data series. All the arrays of the time
+  /// step are committed in a single transaction. Fields that did not change
+  /// since the previous time step refer to its data instead of copying it.
+  ///
+  /// If the positions are varying, the spatial index of the particles is
+  /// written along, so that the regions could be read without loading the
+  /// whole arrays, see `data::DataStorage::create_time_step_index`.
+  ///
+  /// If @p num_levels is positive, a pyramid of the decimated levels of the
+  /// varying fields is written along, see `write_levels_`.
+  ///
+  /// Fields listed in @p precisions are written in the given precision, see
+  /// `data::convert_precision`. The spatial index is still computed from the
+  /// positions of the full precision, before they are converted.
+  ///
+  /// Ranges of the particle types are written as the `particle_ranges`
+  /// uniform array, so that the time step could be read back, see `read`.
   void write(real_t time,
-             data::DataSeriesView<data::DataStorage> series) const {
+             data::DataSeriesView<data::DataStorage> series,
+             size_t num_levels = 0,
+             std::span<const FieldPrecision> precisions = {}) const {
+    using DataSet = data::DataSetView<data::DataStorage>;
+    const auto transaction = series.storage().transaction();
+    std::optional<DataSet> prev_uniforms;
+    std::optional<DataSet> prev_varyings;
+    if (series.num_time_steps() > 0) {
+      const auto prev_time_step = series.last_time_step();
+      prev_uniforms = prev_time_step.uniforms();
+      prev_varyings = prev_time_step.varyings();
+    }
     auto time_step = series.create_time_step(time);
     auto uniforms = time_step.uniforms();
+    ParticleArray::uniform_fields.for_each(
+        [&uniforms, &prev_uniforms, precisions, this](auto field) {
+          write_field_(uniforms,
+                       field.field_name,
+                       output_vals_(std::span{&field[*this], 1}),
+                       precisions,
+                       prev_uniforms);
+        });
+    uniforms.create_array_or_ref("particle_ranges",
+                                 particle_ranges_,
+                                 prev_uniforms);
+    auto varyings = time_step.varyings();
+    ParticleArray::varying_fields.for_each(
+        [&varyings, &prev_varyings, precisions, this](auto field) {
+          write_field_(varyings,
+                       field.field_name,
+                       output_vals_(field[*this]),
+                       precisions,
+                       prev_varyings);
+        });
+    if constexpr (varying_fields.contains(r)) {
+      time_step.create_index(*varyings.find_array(r.field_name), r[*this]);
+    }
+    if (num_levels > 0) write_levels_(time_step, num_levels, precisions);
+  }
+
+  /// Read the particle array from a time step, that was written by the
+  /// particle array of the same type, e.g. to start a run from the settled
+  /// state of another one. Current particles are replaced.
+  ///
+  /// Columns are sized once. Chunks of all the varying fields are then
+  /// decompressed in parallel, straight into the columns, except for the
+  /// interleaved fields and the fields that were written in the different
+  /// precision, that are decompressed into the temporary buffers, and copied
+  /// into their columns in parallel across the fields.
+  void read(data::DataTimeStepView<data::DataStorage> time_step) {
+    // Read the particle type ranges.
+    const auto uniforms = time_step.uniforms();
+    const auto ranges_array = uniforms.find_array("particle_ranges");
+    if (!ranges_array.has_value()) {
+      TIT_THROW("Time step has no particle type ranges.");
+    }
+    // Time steps, that were written before the buffer particles were added,
+    // have one fewer type range, and no buffer particles.
+    const auto num_ranges = ranges_array->size();
+    if (ranges_array->type() != data::type_of<size_t> ||
+        (num_ranges != particle_ranges_.size() &&
+         num_ranges + 1 != particle_ranges_.size())) {
+      TIT_THROW("Time step has invalid particle type ranges.");
+    }
+    decltype(particle_ranges_) particle_ranges{};
+    ranges_array->read_into(std::span{particle_ranges}.first(num_ranges));
+    if (num_ranges < particle_ranges.size()) {
+      particle_ranges.back() = particle_ranges[num_ranges - 1];
+    }
+    if (particle_ranges.front() != 0 ||
+        !std::ranges::is_sorted(particle_ranges)) {
+      TIT_THROW("Time step has invalid particle type ranges.");
+    }
+    const auto count = particle_ranges.back();
+
+    // Find the arrays of the varying fields, and check their sizes and types,
+    // before any of the particle data is changed.
+    const auto varyings = time_step.varyings();
+    std::array<data::DataArrayView<data::DataStorage>, num_varying_fields_>
+        arrays{};
+    size_t field_index = 0;
+    ParticleArray::varying_fields.for_each(
+        [&varyings, &arrays, &field_index, count](auto field) {
+          using Val = field_value_t<decltype(field), Space>;
+          const auto array = find_field_<Val>(varyings, field.field_name);
+          if (array.size() != count) {
+            TIT_THROW("Time step field '{}' has {} values, expected {}.",
+                      field.field_name,
+                      array.size(),
+                      count);
+          }
+          arrays[field_index++] = array;
+        });
+
+    // Restore the uniform fields and the type ranges, and size the columns.
     ParticleArray::uniform_fields.for_each([&uniforms, this](auto field) {
-      uniforms.create_array(field.field_name, std::span{&field[*this], 1});
+      using Val = field_value_t<decltype(field), Space>;
+      const auto array = find_field_<Val>(uniforms, field.field_name);
+      if (array.size() != 1) {
+        TIT_THROW("Time step uniform field '{}' has {} values, expected 1.",
+                  field.field_name,
+                  array.size());
+      }
+      std::vector<byte_t> data(array.type().width());
+      array.read_into(std::span{data});
+      read_field_<Val>(array.type(), data, std::span{&field[*this], 1});
     });
-    auto varyings = time_step.varyings();
-    ParticleArray::varying_fields.for_each([&varyings, this](auto field) {
-      varyings.create_array(field.field_name, field[*this]);
+    particle_ranges_ = particle_ranges;
+    for_each_column_([count](auto& col) { col.resize(count); });
+    generation_ += 1;
+
+    // Decompress the varying fields, either right into the columns, or into
+    // the temporary buffers.
+    std::array<std::vector<byte_t>, num_varying_fields_> buffers{};
+    std::array<std::span<byte_t>, num_varying_fields_> outputs{};
+    field_index = 0;
+    ParticleArray::varying_fields.for_each(
+        [&arrays, &buffers, &outputs, &field_index, this](auto field) {
+          using Field = decltype(field);
+          using Val = field_value_t<Field, Space>;
+          const auto& array = arrays[field_index];
+          auto& output = outputs[field_index];
+          if constexpr (!interleaved_fields.contains(Field{}) &&
+                        !is_sym_mat_v<Val>) {
+            if (array.type() == data::type_of<Val>) {
+              output = std::as_writable_bytes(
+                  std::span{std::get<columnar_fields_.find(Field{})>(
+                      varying_data_)});
+              field_index += 1;
+              return;
+            }
+          }
+          auto& buffer = buffers[field_index];
+          buffer.resize(array.size() * array.type().width());
+          output = buffer;
+          field_index += 1;
+        });
+    std::array<data::DataArrayID, num_varying_fields_> array_ids{};
+    std::ranges::transform(arrays, array_ids.begin(), [](const auto& array) {
+      return array.id();
+    });
+    time_step.storage().array_data_read_all_into(array_ids, outputs);
+
+    // Copy the buffered fields into their columns.
+    par::TaskGroup tasks{};
+    field_index = 0;
+    ParticleArray::varying_fields.for_each(
+        [&tasks, &arrays, &buffers, &field_index, this](auto field) {
+          using Val = field_value_t<decltype(field), Space>;
+          const auto& array = arrays[field_index];
+          const auto& buffer = buffers[field_index];
+          field_index += 1;
+          if (buffer.empty()) return;
+          tasks.run([&array, &buffer, field, this] {
+            read_field_<Val>(array.type(), buffer, field[*this]);
+          });
+        });
+    tasks.wait();
+  }
+
+  /// Write the complete particle array state into a checkpoint.
+  void checkpoint(CheckpointWriter& writer) const {
+    writer.write("particle_ranges", particle_ranges_);
+    ParticleArray::uniform_fields.for_each([&writer, this](auto field) {
+      writer.write(field.field_name, field[*this]);
+    });
+    ParticleArray::varying_fields.for_each([&writer, this](auto field) {
+      if constexpr (interleaved_fields.contains(decltype(field){})) {
+        const auto vals = field[*this] | std::ranges::to<std::vector>();
+        writer.write(field.field_name, std::span{vals});
+      } else {
+        writer.write(field.field_name, field[*this]);
+      }
+    });
+  }
+
+  /// Restore the particle array state from a checkpoint, that was written by
+  /// the particle array of the same type.
+  void restore(CheckpointReader& reader) {
+    reader.read("particle_ranges", particle_ranges_);
+    generation_ += 1;
+    ParticleArray::uniform_fields.for_each([&reader, this](auto field) {
+      reader.read(field.field_name, field[*this]);
+    });
+    ParticleArray::varying_fields.for_each([&reader, this](auto field) {
+      using Field = decltype(field);
+      const auto read_col = [&reader, field, this](auto& col) {
+        reader.read(field.field_name, col);
+        if (col.size() != particle_ranges_.back()) {
+          TIT_THROW("Checkpoint field '{}' has {} values, expected {}.",
+                    field.field_name,
+                    col.size(),
+                    particle_ranges_.back());
+        }
+      };
+      if constexpr (interleaved_fields.contains(Field{})) {
+        std::vector<field_value_t<Field, Space>> col;
+        read_col(col);
+        records_().resize(col.size());
+        const auto vals = field[*this];
+        std::ranges::copy(col, vals.begin());
+      } else {
+        read_col(std::get<columnar_fields_.find(Field{})>(varying_data_));
+      }
     });
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+  /// Periodic box type.
+  using PeriodicBox =
+      geom::PeriodicBox<field_value_t<std::remove_const_t<decltype(r)>, Space>>;
+
+  /// Periodic box of the particles. Position deltas `r[a, b]` are taken for
+  /// the closest images along its periodic axes. No axes are periodic by
+  /// default.
+  constexpr auto periodic_box() const noexcept -> const PeriodicBox& {
+    return periodic_box_;
+  }
+
+  /// Set the periodic box of the particles. Positions are wrapped into it on
+  /// each particle mesh rebuild.
+  constexpr void set_periodic_box(PeriodicBox periodic_box) noexcept {
+    periodic_box_ = std::move(periodic_box);
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
   /// Number of particles.
   constexpr auto size() const noexcept -> size_t {
     return std::get<0>(varying_data_).size();
   }
 
+  /// Generation of the particles. It is incremented each time the particles
+  /// are added, removed, reordered or replaced, so that the per-particle data
+  /// cached by index can be checked for being stale.
+  constexpr auto generation() const noexcept -> size_t {
+    return generation_;
+  }
+
   /// Reserve amount of particles.
   constexpr void reserve(size_t capacity) {
     std::apply([capacity](auto&... cols) { ((cols.reserve(capacity)), ...); },
@@ -200,9 +515,183 @@ public:
     std::apply(
         [index](auto&... cols) { ((cols.emplace(cols.begin() + index)), ...); },
         varying_data_);
+    generation_ += 1;
     return (*this)[index];
   }
 
+  /// Appends @p count new particles of the specified type @p type.
+  ///
+  /// Unlike the repeated `append` calls, the columns are resized only once.
+  ///
+  /// @returns Range of the appended particles.
+  auto append_n(ParticleType type, size_t count) {
+    TIT_ASSERT(type < ParticleType::count, "Invalid particle type.");
+    const auto type_index = std::to_underlying(type);
+    // Get the index of the first new particle of the specified type and
+    // increment the range of particles for the next types.
+    const size_t index = particle_ranges_[type_index + 1];
+    for (auto& p : particle_ranges_ | std::views::drop(type_index + 1)) {
+      p += count;
+    }
+    // Insert the new particles.
+    for_each_column_([index, count](auto& col) {
+      col.insert(col.begin() + index, count, {});
+    });
+    generation_ += 1;
+    return std::views::iota(index, index + count) |
+           std::views::transform([this](size_t i) { return (*this)[i]; });
+  }
+
+  /// Appends the copies of the particles at @p indices as the new particles
+  /// of the specified type @p type. All the varying fields are copied.
+  ///
+  /// @returns Range of the appended particles.
+  auto append_copies(ParticleType type, std::span<const size_t> indices) {
+    TIT_ASSERT(type < ParticleType::count, "Invalid particle type.");
+    TIT_ASSERT(std::ranges::all_of(indices,
+                                   [this](size_t i) { return i < size(); }),
+               "Particle index is out of range.");
+    const auto type_index = std::to_underlying(type);
+    const auto count = indices.size();
+    // Get the index of the first new particle of the specified type and
+    // increment the range of particles for the next types.
+    const size_t index = particle_ranges_[type_index + 1];
+    for (auto& p : particle_ranges_ | std::views::drop(type_index + 1)) {
+      p += count;
+    }
+    // Insert the copies. Values are gathered first, since the insertion
+    // shifts the particles that follow it.
+    for_each_column_([index, indices](auto& col) {
+      const auto copies =
+          indices | std::views::transform([&col](size_t i) { return col[i]; }) |
+          std::ranges::to<std::vector>();
+      col.insert(col.begin() + index, copies.begin(), copies.end());
+    });
+    generation_ += 1;
+    return std::views::iota(index, index + count) |
+           std::views::transform([this](size_t i) { return (*this)[i]; });
+  }
+
+  /// Remove the particles that satisfy the predicate @p pred.
+  ///
+  /// Relative order of the remaining particles is preserved.
+  ///
+  /// @returns Number of the removed particles.
+  template<std::predicate<ParticleView<ParticleArray>> Pred>
+  auto remove_if(const Pred& pred) -> size_t {
+    // Evaluate the predicate.
+    std::vector<uint8_t> keep(size());
+    par::for_each(all(), [&keep, &pred](ParticleView<ParticleArray> a) {
+      keep[a.index()] = pred(a) ? 0 : 1;
+    });
+
+    // Update the ranges of particles.
+    decltype(particle_ranges_) new_ranges{0};
+    for (size_t i = 0; i + 1 < particle_ranges_.size(); ++i) {
+      const auto type_keep = std::span{keep}.subspan(
+          particle_ranges_[i],
+          particle_ranges_[i + 1] - particle_ranges_[i]);
+      const auto type_size = std::ranges::count(type_keep, 1);
+      new_ranges[i + 1] = new_ranges[i] + static_cast<size_t>(type_size);
+    }
+    const auto num_removed = size() - new_ranges.back();
+    if (num_removed == 0) return 0;
+
+    // Compact the columns.
+    for_each_column_([&keep](auto& col) {
+      size_t last = 0;
+      for (size_t i = 0; i < col.size(); ++i) {
+        if (keep[i] != 0) col[last++] = std::move(col[i]);
+      }
+      col.erase(col.begin() + last, col.end());
+    });
+    particle_ranges_ = new_ranges;
+    generation_ += 1;
+    return num_removed;
+  }
+
+  /// Change the type of the particle at @p index to @p type.
+  ///
+  /// The particle is swapped with the boundary particles of the type ranges
+  /// between its current type and the new one, so the change costs a few
+  /// swaps, and the columns are never resized. Since the swapped particles
+  /// change their indices, the types of several particles of the same type
+  /// should be changed in the decreasing order of their indices, if the new
+  /// type follows the current one, and in the increasing order otherwise.
+  ///
+  /// @returns New index of the particle.
+  auto change_type(size_t index, ParticleType type) -> size_t {
+    TIT_ASSERT(type < ParticleType::count, "Invalid particle type.");
+    const auto type_index = std::to_underlying(type);
+    auto current_index = std::to_underlying(type_of_(index));
+    // Move the particle to the following types through the range ends.
+    for (; current_index < type_index; ++current_index) {
+      auto& end = particle_ranges_[current_index + 1];
+      end -= 1;
+      swap_(index, end);
+      index = end;
+    }
+    // Move the particle to the preceding types through the range starts.
+    for (; current_index > type_index; --current_index) {
+      auto& begin = particle_ranges_[current_index];
+      swap_(index, begin);
+      index = begin;
+      begin += 1;
+    }
+    generation_ += 1;
+    return index;
+  }
+
+  /// Copy all the varying fields of the particle at @p from to the particle
+  /// at @p to. Types of the particles are not changed.
+  void copy(size_t from, size_t to) {
+    TIT_ASSERT(from < size(), "Particle index is out of range.");
+    TIT_ASSERT(to < size(), "Particle index is out of range.");
+    std::apply([from, to](auto&... cols) { ((cols[to] = cols[from]), ...); },
+               varying_data_);
+  }
+
+  /// Reorder the particles.
+  ///
+  /// @param perm Permutation, such that the particle at index `i` after the
+  ///             reordering is the particle at index `perm[i]` before it.
+  ///             Particles must not be moved between the type ranges.
+  template<std::ranges::random_access_range Perm>
+    requires std::convertible_to<std::ranges::range_value_t<Perm>, size_t>
+  void reorder(const Perm& perm) {
+    TIT_ASSERT(std::size(perm) == size(),
+               "Permutation size must match the number of particles!");
+    TIT_ASSERT(std::ranges::all_of(std::views::iota(size_t{0}, size()),
+                                   [&perm, this](size_t i) {
+                                     return type_of_(perm[i]) == type_of_(i);
+                                   }),
+               "Permutation must not move particles between type ranges!");
+    par::permute(perm, varying_data_, reorder_buffers_);
+    generation_ += 1;
+  }
+
+  /// Record the heap footprint of each column of the varying fields, of the
+  /// records of the interleaved fields, and of the reordering buffers, see
+  /// `MemoryStats`.
+  void record_memory_stats() const {
+    columnar_fields_.for_each([this](auto field) {
+      TIT_MEMORY_STATS(
+          std::format("ParticleArray::{}", field.field_name),
+          std::get<columnar_fields_.find(decltype(field){})>(varying_data_));
+    });
+    if constexpr (interleaved_fields != meta::Set{}) {
+      TIT_MEMORY_STATS("ParticleArray::records", records_());
+    }
+    if (MemoryStats::enabled()) {
+      MemoryStats::record("ParticleArray::reorder_buffers",
+                          std::apply(
+                              [](const auto&... buffers) {
+                                return (heap_bytes(buffers) + ... + size_t{0});
+                              },
+                              reorder_buffers_));
+    }
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// All particles.
@@ -230,6 +719,11 @@ public:
     return self.typed(ParticleType::fixed);
   }
 
+  /// Buffer particles.
+  constexpr auto buffer(this auto& self) noexcept {
+    return self.typed(ParticleType::buffer);
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Check if the particle has the specified type.
@@ -256,38 +750,292 @@ public:
     TIT_ASSERT(index < self.size(), "Particle index is out of range.");
     if constexpr (uniform_fields.contains(Field{})) {
       return std::get<uniform_fields.find(Field{})>(self.uniform_data_);
+    } else if constexpr (interleaved_fields.contains(Field{})) {
+      return std::get<interleaved_fields.find(Field{})>(self.records_()[index]);
     } else if constexpr (varying_fields.contains(Field{})) {
-      return std::get<varying_fields.find(Field{})>(self.varying_data_)[index];
+      return std::get<columnar_fields_.find(Field{})>(
+          self.varying_data_)[index];
     } else static_assert(false);
   }
 
   /// Values for the specified field.
+  ///
+  /// Values of the varying fields are returned as a span, unless the field is
+  /// interleaved, in which case a random access view is returned.
   template<field Field>
   constexpr auto operator[](this auto& self, Field /*field*/) noexcept
       -> decltype(auto) {
     static_assert(fields.contains(Field{}));
     if constexpr (uniform_fields.contains(Field{})) {
       return std::get<uniform_fields.find(Field{})>(self.uniform_data_);
+    } else if constexpr (interleaved_fields.contains(Field{})) {
+      return std::span{self.records_()} |
+             std::views::transform([](auto& record) -> auto& {
+               return std::get<interleaved_fields.find(Field{})>(record);
+             });
     } else if constexpr (varying_fields.contains(Field{})) {
       return std::span{
-          std::get<varying_fields.find(Field{})>(self.varying_data_)};
+          std::get<columnar_fields_.find(Field{})>(self.varying_data_)};
     } else static_assert(false);
   }
 
+  /// Prefetch the data of the particle, that is read by the pair loops: the
+  /// position and the record of the interleaved fields.
+  void prefetch(size_t index) const noexcept {
+    TIT_ASSERT(index < size(), "Particle index is out of range.");
+    if constexpr (varying_fields.contains(r)) {
+      tit::prefetch(&(*this)[index, r]);
+    }
+    if constexpr (interleaved_fields != meta::Set{}) {
+      // Record may span two cache lines.
+      const auto* const record = &records_()[index];
+      tit::prefetch(record);
+      tit::prefetch(reinterpret_cast<const byte_t*>(record + 1) - 1);
+    }
+  }
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 private:
 
+  template<class ParticleArray_, field_set Fields>
+  friend class ParticleColumnView;
+
+  // Apply the function to each of the varying data columns in parallel.
+  void for_each_column_(const auto& func) {
+    par::TaskGroup tasks{};
+    std::apply(
+        [&tasks, &func](auto&... cols) {
+          (tasks.run([&func, &cols] { func(cols); }), ...);
+        },
+        varying_data_);
+    tasks.wait();
+  }
+
+  // Pointer to the data of the field. Interleaved fields are accessed
+  // through the pointer to the records.
+  template<field Field>
+  constexpr auto data_(this auto& self, Field field) noexcept {
+    static_assert(fields.contains(Field{}));
+    if constexpr (uniform_fields.contains(Field{})) {
+      return &self[field];
+    } else if constexpr (interleaved_fields.contains(Field{})) {
+      return self.records_().data();
+    } else {
+      return self[field].data();
+    }
+  }
+
+  // Record of the interleaved fields of all the particles.
+  constexpr auto records_(this auto& self) noexcept -> auto& {
+    static_assert(interleaved_fields != meta::Set{}, "No interleaved fields!");
+    return std::get<std::tuple_size_v<decltype(self.varying_data_)> - 1>(
+        self.varying_data_);
+  }
+
+  // Write the decimated levels of the varying fields into the time step.
+  //
+  // Each level is decimated over a grid that is twice coarser along each axis
+  // than the one of the previous level, so it holds about `2^Dim` times fewer
+  // particles, and the whole pyramid costs about `1 / (2^Dim - 1)` of the
+  // full varying fields. Fewer levels are written if the grid is exhausted.
+  // Each level also stores the indices of its particles in the full arrays.
+  void write_levels_(data::DataTimeStepView<data::DataStorage> time_step,
+                     size_t num_levels,
+                     std::span<const FieldPrecision> precisions) const {
+    if constexpr (varying_fields.contains(r)) {
+      if (size() == 0) return;
+      using PosVec = field_value_t<decltype(r), Space>;
+      using Num = vec_num_t<PosVec>;
+      constexpr auto Dim = vec_dim_v<PosVec>;
+
+      // Slightly grow the box, so that the points on its upper bound end up
+      // inside of the grid.
+      const auto positions = r[*this];
+      auto box = geom::compute_bbox(positions);
+      box.grow(static_cast<Num>(1.0e-6) *
+               std::max(max_value(box.extents()), Num{1}));
+
+      // Finest grid resolution is such that there is about one particle per
+      // cell, if the particles are evenly distributed.
+      auto resolution = static_cast<size_t>(
+          std::ceil(std::pow(static_cast<Num>(size()), Num{1} / Dim)));
+      for (size_t level = 1; level <= num_levels && resolution > 1; ++level) {
+        resolution = (resolution + 1) / 2;
+        const geom::Grid grid{box, Vec<size_t, Dim>(resolution)};
+        const auto indices = geom::grid_decimate(positions, grid);
+        const auto dataset = time_step.create_level();
+        dataset.create_array("index", indices);
+        ParticleArray::varying_fields.for_each(
+            [&dataset, &indices, precisions, this](auto field) {
+              const auto vals = field[*this];
+              const auto level_vals = std::views::transform(
+                  indices,
+                  [&vals](size_t i) { return vals[i]; });
+              write_field_(dataset,
+                           field.field_name,
+                           output_vals_(level_vals),
+                           precisions,
+                           std::nullopt);
+            });
+      }
+    }
+  }
+
+  // Field values, as they are written into a data series. Symmetric matrices
+  // are unpacked, so that the readers only see the square ones.
+  template<std::ranges::input_range Vals>
+  static constexpr auto output_vals_(Vals vals) {
+    using Val = std::ranges::range_value_t<Vals>;
+    if constexpr (is_sym_mat_v<Val>) {
+      return vals | std::views::transform(
+                        [](const auto& A) { return A.full(); });
+    } else {
+      return vals;
+    }
+  }
+
+  // Write the field values into the dataset, in the output precision of the
+  // field, if it is given. Array may refer to the one of the previous dataset.
+  template<std::ranges::input_range Vals>
+  static void write_field_(
+      const data::DataSetView<data::DataStorage>& dataset,
+      std::string_view field_name,
+      Vals vals,
+      std::span<const FieldPrecision> precisions,
+      std::optional<data::DataSetView<data::DataStorage>> previous) {
+    using Val = std::ranges::range_value_t<Vals>;
+    const auto precision =
+        std::ranges::find(precisions, field_name, &FieldPrecision::field_name);
+    if (precision == precisions.end() ||
+        precision->kind == data::type_of<Val>.kind()) {
+      dataset.create_array_or_ref(field_name, vals, previous);
+      return;
+    }
+
+    // Raw values are converted straight from the field, the others are
+    // serialized first.
+    const auto type = data::type_of<Val>;
+    const auto write_data = [&dataset, field_name, type, precision, &previous](
+                                std::span<const byte_t> data) {
+      dataset.create_array_or_ref(
+          field_name,
+          type.with_kind(precision->kind),
+          data::convert_precision(type, precision->kind, data),
+          previous);
+    };
+    if constexpr (std::ranges::contiguous_range<Vals> &&
+                  is_raw_serializable_v<Val>) {
+      write_data(std::as_bytes(std::span{vals}));
+    } else {
+      std::vector<byte_t> data;
+      make_stream_serializer<Val>(make_container_output_stream(data))
+          ->write(vals);
+      write_data(data);
+    }
+  }
+
+  // Find the array of the field in the dataset, and check that its type
+  // matches the one the field values are written as, up to the precision.
+  template<class Val>
+  static auto find_field_(const data::DataSetView<data::DataStorage>& dataset,
+                          std::string_view field_name)
+      -> data::DataArrayView<data::DataStorage> {
+    using OutVal =
+        std::ranges::range_value_t<decltype(output_vals_(std::span<Val>{}))>;
+    const auto array = dataset.find_array(field_name);
+    if (!array.has_value()) {
+      TIT_THROW("Time step has no field '{}'.", field_name);
+    }
+    constexpr auto type = data::type_of<OutVal>;
+    if (array->type().with_kind(type.kind()) != type) {
+      TIT_THROW("Time step field '{}' has type '{}', expected '{}'.",
+                field_name,
+                array->type().name(),
+                type.name());
+    }
+    return *array;
+  }
+
+  // Read the field values from the data, as they were written by
+  // `write_field_`, converting them to the full precision, if necessary.
+  template<class Val, std::ranges::random_access_range Vals>
+  static void read_field_(data::DataType type,
+                          std::span<const byte_t> data,
+                          Vals&& vals) {
+    using OutVal =
+        std::ranges::range_value_t<decltype(output_vals_(std::span<Val>{}))>;
+    constexpr auto out_type = data::type_of<OutVal>;
+    std::vector<byte_t> converted;
+    if (type != out_type) {
+      converted = data::convert_precision(type, out_type.kind(), data);
+      data = converted;
+    }
+    TIT_ASSERT(data.size() == std::ranges::size(vals) * sizeof(OutVal),
+               "Data size does not match the number of values!");
+    for (size_t i = 0; i < std::ranges::size(vals); ++i) {
+      OutVal val{};
+      std::memcpy(&val, data.data() + i * sizeof(OutVal), sizeof(OutVal));
+      if constexpr (is_sym_mat_v<Val>) {
+        vals[i] = Val{val};
+      } else {
+        vals[i] = val;
+      }
+    }
+  }
+
+  // Swap the varying fields of the particles.
+  void swap_(size_t i, size_t j) {
+    TIT_ASSERT(i < size() && j < size(), "Particle index is out of range.");
+    if (i == j) return;
+    std::apply([i, j](auto&... cols) { (std::swap(cols[i], cols[j]), ...); },
+               varying_data_);
+  }
+
+  // Type of the particle at index.
+  constexpr auto type_of_(size_t index) const noexcept -> ParticleType {
+    TIT_ASSERT(index < size(), "Particle index is out of range.");
+    const auto iter = std::ranges::upper_bound(particle_ranges_, index);
+    return static_cast<ParticleType>(iter - particle_ranges_.begin() - 1);
+  }
+
   std::array<size_t, std::to_underlying(ParticleType::count) + 1>
       particle_ranges_{0};
+  PeriodicBox periodic_box_;
+  size_t generation_ = 0;
 
   decltype([]<class... Fields>(meta::Set<Fields...> /*fields*/) {
     return std::tuple<field_value_t<Fields, Space>...>{};
   }(uniform_fields)) uniform_data_;
 
+  // Varying fields that are stored in the separate columns.
+  static constexpr auto columnar_fields_ = varying_fields - interleaved_fields;
+
+  // Number of the varying fields.
+  static constexpr size_t num_varying_fields_ = varying_fields.apply(
+      [](auto... fields) { return sizeof...(fields); });
+
+  // Values of the interleaved fields of a particle.
+  using Record_ =
+      decltype([]<class... Fields>(meta::Set<Fields...> /*fields*/) {
+        return std::tuple<field_value_t<Fields, Space>...>{};
+      }(interleaved_fields));
+
+  // Columns of the varying fields, followed by the column of records, if any
+  // of the fields is interleaved.
   decltype([]<class... Fields>(meta::Set<Fields...> /*fields*/) {
-    return std::tuple<std::vector<field_value_t<Fields, Space>>...>{};
-  }(varying_fields)) varying_data_;
+    if constexpr (interleaved_fields == meta::Set{}) {
+      return std::tuple<
+          par::FirstTouchVector<field_value_t<Fields, Space>>...>{};
+    } else {
+      return std::tuple<par::FirstTouchVector<field_value_t<Fields, Space>>...,
+                        par::FirstTouchVector<Record_>>{};
+    }
+  }(columnar_fields_)) varying_data_;
+
+  // Buffers of the varying data columns for reordering, that keep their
+  // storage between the reorderings.
+  decltype(varying_data_) reorder_buffers_;
 
 }; // class ParticleArray
 
@@ -297,6 +1045,14 @@ ParticleArray(Space, Equations) -> ParticleArray<
     decltype(Equations::required_fields - Equations::modified_fields),
     decltype(Equations::required_fields & Equations::modified_fields)>;
 
+template<class Space, class Equations, class Fields>
+ParticleArray(Space, Equations, Fields) -> ParticleArray<
+    Space,
+    decltype(Equations::required_fields - Equations::modified_fields),
+    decltype(Equations::required_fields & Equations::modified_fields),
+    decltype(Equations::required_fields & Equations::modified_fields &
+             Fields{})>;
+
 /// Particle array type.
 ///
 /// @tparam fields Fields that the array should contain.
@@ -332,6 +1088,13 @@ template<auto field, class P>
 using particle_field_t =
     std::remove_cvref_t<particle_field_reference_t<field, P>>;
 
+/// Particle field accumulation type.
+template<auto field, class P>
+  requires particle_view<P, field> || particle_array<P, field>
+using particle_field_accum_t = field_accum_value_t<
+    std::remove_cvref_t<decltype(field)>,
+    std::remove_cvref_t<decltype(std::remove_cvref_t<P>::space)>>;
+
 /// Particle scalar type.
 template<class P>
   requires particle_view<P> || particle_array<P>
@@ -349,6 +1112,319 @@ inline constexpr auto particle_dim_v = vec_dim_v<particle_vec_t<P>>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Batch of consecutive particles, which fields are accessed through the SIMD
+/// registers.
+///
+/// Scalar field values are loaded into the registers of `Size` lanes, vector
+/// field values are loaded into the vectors of such registers. Tail lanes of
+/// an incomplete batch are loaded as zeroes and are never stored.
+template<class ParticleArray,
+         size_t Size = simd::max_reg_size_v<particle_num_t<ParticleArray>>>
+class ParticleBatch final {
+public:
+
+  /// Particle array type.
+  using Array = std::remove_const_t<ParticleArray>;
+
+  /// Particle space.
+  static constexpr space auto space = Array::space;
+
+  /// Subset of particle fields that are array-wise constants.
+  static constexpr field_set auto uniform_fields = Array::uniform_fields;
+
+  /// Subset of particle fields that are individual for each particle.
+  static constexpr field_set auto varying_fields = Array::varying_fields;
+
+  /// Set of particle fields that are present.
+  static constexpr field_set auto fields = Array::fields;
+
+  /// Maximum number of particles in the batch.
+  static constexpr size_t BatchSize = Size;
+
+  /// Scalar register type.
+  using Reg = simd::Reg<particle_num_t<Array>, Size>;
+
+  /// Batch value type for the specified field.
+  template<field Field>
+  using Value = decltype([] {
+    using Val = field_value_t<Field, std::remove_const_t<decltype(space)>>;
+    if constexpr (std::same_as<Val, particle_num_t<Array>>) return Reg{};
+    else if constexpr (is_vec_v<Val>) return Vec<Reg, vec_dim_v<Val>>{};
+    else static_assert(false, "Only scalar and vector fields are supported!");
+  }());
+
+  /// Space dimension.
+  static constexpr auto Dim = particle_dim_v<Array>;
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Construct a particle batch.
+  constexpr ParticleBatch(ParticleArray& array,
+                          size_t first,
+                          size_t count) noexcept
+      : array_{&array}, first_{first}, count_{count} {
+    TIT_ASSERT(0 < count_ && count_ <= Size, "Invalid batch size!");
+    TIT_ASSERT(first_ + count_ <= array.size(), "Batch is out of range!");
+  }
+
+  /// Associated particle array.
+  constexpr auto array() const noexcept -> ParticleArray& {
+    TIT_ASSERT(array_ != nullptr, "Particle array was not set.");
+    return *array_;
+  }
+
+  /// Index of the first particle in the batch.
+  constexpr auto first() const noexcept -> size_t {
+    return first_;
+  }
+
+  /// Number of particles in the batch.
+  constexpr auto size() const noexcept -> size_t {
+    return count_;
+  }
+
+  /// Load the particle field values.
+  template<field Field>
+  auto operator[](Field field) const noexcept -> Value<Field> {
+    static_assert(fields.contains(Field{}));
+    if constexpr (uniform_fields.contains(Field{})) {
+      return broadcast_<Field>(array()[field]);
+    } else {
+      return load_<Field>(vals_(field));
+    }
+  }
+
+  /// Store the particle field values.
+  template<field Field>
+  void store(Field field, const Value<Field>& val) const noexcept {
+    static_assert(varying_fields.contains(Field{}));
+    store_<Field>(val, vals_(field));
+  }
+
+private:
+
+  // Values of the batch particles. Interleaved values are not contiguous, so
+  // they are loaded and stored one by one.
+  template<field Field>
+  auto vals_(Field field) const noexcept {
+    if constexpr (Array::interleaved_fields.contains(Field{})) {
+      return array()[field] | std::views::drop(first_) |
+             std::views::take(count_);
+    } else {
+      return array()[field].subspan(first_, count_);
+    }
+  }
+
+  // Broadcast the value to all the lanes.
+  template<field Field>
+  static auto broadcast_(const auto& val) noexcept -> Value<Field> {
+    if constexpr (is_vec_v<std::remove_cvref_t<decltype(val)>>) {
+      Value<Field> result;
+      for (size_t d = 0; d < Dim; ++d) result[d] = Reg{val[d]};
+      return result;
+    } else return Reg{val};
+  }
+
+  // Load the values into the lanes.
+  template<field Field>
+  static auto load_(const auto& vals) noexcept -> Value<Field> {
+    using Num = particle_num_t<Array>;
+    if constexpr (is_vec_v<std::remove_cvref_t<decltype(vals[0])>>) {
+      std::array<std::array<Num, Size>, Dim> lanes{};
+      for (size_t i = 0; i < vals.size(); ++i) {
+        for (size_t d = 0; d < Dim; ++d) lanes[d][i] = vals[i][d];
+      }
+      Value<Field> result;
+      for (size_t d = 0; d < Dim; ++d) result[d] = Reg{lanes[d]};
+      return result;
+    } else {
+      if constexpr (std::ranges::contiguous_range<decltype(vals)>) {
+        if (vals.size() == Size) return Reg{vals};
+      }
+      std::array<Num, Size> lanes{};
+      std::ranges::copy(vals, lanes.begin());
+      return Reg{lanes};
+    }
+  }
+
+  // Store the lanes into the values.
+  template<field Field>
+  static void store_(const Value<Field>& val, const auto& vals) noexcept {
+    using Num = particle_num_t<Array>;
+    if constexpr (is_vec_v<Value<Field>>) {
+      std::array<std::array<Num, Size>, Dim> lanes{};
+      for (size_t d = 0; d < Dim; ++d) val[d].store(lanes[d]);
+      for (size_t i = 0; i < vals.size(); ++i) {
+        for (size_t d = 0; d < Dim; ++d) vals[i][d] = lanes[d][i];
+      }
+    } else {
+      if constexpr (std::ranges::contiguous_range<decltype(vals)>) {
+        if (vals.size() == Size) return val.store(vals);
+      }
+      std::array<Num, Size> lanes{};
+      val.store(lanes);
+      std::ranges::copy(lanes | std::views::take(vals.size()), vals.begin());
+    }
+  }
+
+  ParticleArray* array_;
+  size_t first_;
+  size_t count_;
+
+}; // class ParticleBatch
+
+/// Iterate through the particles in parallel, in batches of the consecutive
+/// particles.
+///
+/// @param particles Range of the particle views with consecutive indices,
+///                  e.g. `particles.fluid()`.
+template<par::range Particles,
+         class PV = std::ranges::range_value_t<Particles>,
+         class PB = ParticleBatch<std::remove_reference_t<
+             decltype(std::declval<PV>().array())>>,
+         std::invocable<PB> Func>
+  requires particle_view<PV>
+void for_each_batch(Particles&& particles, Func func) {
+  TIT_ASSUME_UNIVERSAL(Particles, particles);
+  par::for_each_batch(
+      particles,
+      PB::BatchSize,
+      [&func](const auto& views) {
+        const PV a = *std::begin(views);
+        const auto count = static_cast<size_t>(std::size(views));
+        TIT_ASSERT(PV{views[count - 1]}.index() == a.index() + count - 1,
+                   "Particle indices must be consecutive!");
+        func(PB{a.array(), a.index(), count});
+      });
+}
+
+/// Execution policy for the loops over the particle neighbors. Cost of such
+/// loops varies with the number of the neighbors, so the chunks of the grain
+/// size of the calling thread, e.g. the one tuned by the solver, see
+/// `par::grain_size`, are handed out dynamically to balance the load. Until
+/// the grain size is set, the chunks are sized by the partitioner.
+inline auto heavy_loop_policy() noexcept -> par::Policy {
+  const auto grain_size = par::grain_size();
+  return {
+      .grain_size = grain_size,
+      .partitioner = grain_size > 1 ? par::Partitioner::simple :
+                                      par::Partitioner::automatic,
+  };
+}
+
+/// Iterate through the particles in parallel, with the execution policy of
+/// the loops over the particle neighbors, see `heavy_loop_policy`.
+template<par::range Particles, class Func>
+void heavy_for_each(Particles&& particles, Func func) {
+  TIT_ASSUME_UNIVERSAL(Particles, particles);
+  par::for_each(heavy_loop_policy(), particles, std::move(func));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Lean particle view, that holds the raw pointers to the data of the
+/// selected fields, instead of going through the particle array on each
+/// access.
+///
+/// Pointers are captured once per loop, see `column_views`, and are copied
+/// into each view, so that the compiler can keep them in the registers and
+/// vectorize the loop. Such views are not `particle_view`s, and only provide
+/// access to the selected fields.
+template<class ParticleArray, field_set Fields>
+class ParticleColumnView final {
+public:
+
+  /// Particle array type.
+  using Array = std::remove_const_t<ParticleArray>;
+
+  /// Particle space.
+  static constexpr space auto space = Array::space;
+
+  /// Set of particle fields that are accessible.
+  static constexpr field_set auto fields = Fields{} & Array::fields;
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Construct an empty view.
+  constexpr ParticleColumnView() noexcept = default;
+
+  /// Construct a view of the particle, capturing the field data pointers.
+  constexpr explicit ParticleColumnView(ParticleArray& array,
+                                        size_t index = 0) noexcept
+      : array_{&array}, index_{index} {
+    fields.for_each([&array, this](auto f) {
+      std::get<fields.find(decltype(f){})>(ptrs_) = array.data_(f);
+    });
+  }
+
+  /// View of the particle at index, that shares the data pointers.
+  constexpr auto at(size_t index) const noexcept -> ParticleColumnView {
+    TIT_ASSERT(index < array().size(), "Particle index is out of range.");
+    auto result = *this;
+    result.index_ = index;
+    return result;
+  }
+
+  /// Associated particle array.
+  constexpr auto array() const noexcept -> ParticleArray& {
+    TIT_ASSERT(array_ != nullptr, "Particle array was not set.");
+    return *array_;
+  }
+
+  /// Associated particle index.
+  constexpr auto index() const noexcept -> size_t {
+    return index_;
+  }
+
+  /// Particle field value.
+  template<field Field>
+  constexpr auto operator[](Field /*field*/) const noexcept -> auto& {
+    static_assert(fields.contains(Field{}));
+    const auto ptr = std::get<fields.find(Field{})>(ptrs_);
+    if constexpr (Array::uniform_fields.contains(Field{})) {
+      return *ptr;
+    } else if constexpr (Array::interleaved_fields.contains(Field{})) {
+      return std::get<Array::interleaved_fields.find(Field{})>(ptr[index_]);
+    } else {
+      return ptr[index_];
+    }
+  }
+
+private:
+
+  using Ptrs_ = decltype([]<class... Fs>(meta::Set<Fs...> /*fields*/) {
+    return std::tuple<decltype(std::declval<ParticleArray&>().data_(
+        Fs{}))...>{};
+  }(fields));
+
+  ParticleArray* array_ = nullptr;
+  size_t index_ = 0;
+  Ptrs_ ptrs_{};
+
+}; // class ParticleColumnView
+
+/// Lean views of the particles in the range, that only provide access to the
+/// specified fields, see `ParticleColumnView`.
+///
+/// @param particles Range of the particle views, e.g. `particles.fluid()`.
+template<std::ranges::range Particles,
+         field_set Fields,
+         class PV = std::ranges::range_value_t<Particles>>
+  requires particle_view<PV>
+constexpr auto column_views(Particles&& particles, Fields /*fields*/) {
+  using PCV = ParticleColumnView<
+      std::remove_reference_t<decltype(std::declval<PV>().array())>,
+      Fields>;
+  auto views = std::views::all(std::forward<Particles>(particles));
+  const auto base = std::ranges::empty(views) ?
+                        PCV{} :
+                        PCV{(*std::ranges::begin(views)).array()};
+  return views | std::views::transform(
+                     [base](PV a) { return base.at(a.index()); });
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Check particle fields presence.
 template<class P>
   requires particle_view<P> || particle_array<P>
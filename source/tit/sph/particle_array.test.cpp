@@ -0,0 +1,233 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/simd.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/data/filter.hpp"
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+#include "tit/geom/bbox.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+using sph::h;
+using sph::m;
+using sph::r;
+using sph::v;
+
+using Vec2D = Vec<double, 2>;
+using Space2D = sph::Space<double, 2>;
+using ParticleArray2D = sph::ParticleArray<Space2D,
+                                           decltype(meta::Set{h}),
+                                           decltype(meta::Set{r, v, m}),
+                                           decltype(meta::Set{v, m})>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::column_views") {
+  ParticleArray2D particles{Space2D{}, meta::Set<>{}, meta::Set{v, m}};
+  h[particles] = 0.5;
+  for (const auto i : {1.0, 2.0}) {
+    const auto a = particles.append(sph::ParticleType::fluid);
+    r[a] = {i, 0.0}, v[a] = {0.0, i}, m[a] = i;
+  }
+  const auto b = particles.append(sph::ParticleType::fixed);
+  r[b] = {3.0, 0.0}, v[b] = {0.0, 3.0}, m[b] = 3.0;
+  SUBCASE("columnar, interleaved and uniform fields") {
+    // Views write through to the particle array.
+    const auto views =
+        sph::column_views(particles.fluid(), meta::Set{h, r, v, m});
+    REQUIRE(std::ranges::size(views) == 2);
+    for (const auto a : views) {
+      v[a] += h[a] * r[a];
+      m[a] *= 2.0;
+    }
+    CHECK(v[particles[0]] == Vec2D{0.5, 1.0});
+    CHECK(v[particles[1]] == Vec2D{1.0, 2.0});
+    CHECK(m[particles[0]] == 2.0);
+    CHECK(m[particles[1]] == 4.0);
+    CHECK(m[particles[2]] == 3.0);
+  }
+  SUBCASE("empty range") {
+    const auto views = sph::column_views(particles.buffer(), meta::Set{r});
+    CHECK(std::ranges::empty(views));
+  }
+}
+
+TEST_CASE("sph::ParticleArray::write") {
+  ParticleArray2D particles{Space2D{}, meta::Set<>{}};
+  h[particles] = 0.5;
+  for (const auto i : {1.0, 2.0, 3.0}) {
+    const auto a = particles.append(sph::ParticleType::fluid);
+    r[a] = {i, 0.0}, v[a] = {0.0, -i}, m[a] = i;
+  }
+  data::DataStorage storage{":memory:"};
+  const auto series = storage.create_series("");
+  SUBCASE("full precision") {
+    particles.write(0.0, series);
+    const auto varyings = series.last_time_step().varyings();
+    const auto velocities = varyings.find_array(v.field_name);
+    REQUIRE(velocities.has_value());
+    CHECK(velocities->type() == data::type_of<Vec2D>);
+  }
+  SUBCASE("without the buffer range") {
+    // Time steps, that were written before the buffer particles were added,
+    // have one fewer type range.
+    const auto time_step = series.create_time_step(0.0);
+    const auto uniforms = time_step.uniforms();
+    uniforms.create_array("h", std::vector{h[particles]});
+    uniforms.create_array("particle_ranges", std::vector<size_t>{0, 3, 4});
+    const auto varyings = time_step.varyings();
+    varyings.create_array("r", r[particles]);
+    varyings.create_array("v", v[particles]);
+    varyings.create_array("m", m[particles]);
+    check_read(particles);
+  }
+  SUBCASE("output precision") {
+    // Values are exactly representable in the 16-bit floats.
+    const std::vector<sph::FieldPrecision> precisions{
+        {.field_name = std::string{v.field_name},
+         .kind = data::kind_of<simd::float16_t>},
+        {.field_name = std::string{h.field_name},
+         .kind = data::kind_of<simd::bfloat16_t>},
+    };
+    particles.write(0.0, series, /*num_levels=*/0, precisions);
+    const auto time_step = series.last_time_step();
+    const auto spacing = time_step.uniforms().find_array(h.field_name);
+    REQUIRE(spacing.has_value());
+    CHECK(spacing->type() == data::type_of<simd::bfloat16_t>);
+    const auto velocities = time_step.varyings().find_array(v.field_name);
+    REQUIRE(velocities.has_value());
+    const auto type = velocities->type();
+    CHECK(type == data::type_of<Vec2D>.with_kind(
+                      data::kind_of<simd::float16_t>));
+    const auto vals = data::convert_precision(type,
+                                              data::kind_of<float64_t>,
+                                              *velocities->read());
+    const std::vector<Vec2D> expected{{0.0, -1.0}, {0.0, -2.0}, {0.0, -3.0}};
+    CHECK(std::ranges::equal(vals, std::as_bytes(std::span{expected})));
+
+    // Fields without the output precision are written as usual, and the
+    // spatial index is still available.
+    const auto positions = time_step.varyings().find_array(r.field_name);
+    REQUIRE(positions.has_value());
+    CHECK(positions->type() == data::type_of<Vec2D>);
+    CHECK(time_step.has_index());
+  }
+  SUBCASE("reduced positions") {
+    // Positions of 100.1 and 100.2 are both rounded to 100 in the bfloat16,
+    // but the regions are selected by the full-precision ones.
+    r[particles[0]] = {100.1, 0.0}, r[particles[1]] = {100.2, 0.0};
+    const std::vector<sph::FieldPrecision> precisions{
+        {.field_name = std::string{r.field_name},
+         .kind = data::kind_of<simd::bfloat16_t>},
+    };
+    particles.write(0.0, series, /*num_levels=*/0, precisions);
+    const auto time_step = series.last_time_step();
+    const auto positions = time_step.varyings().find_array(r.field_name);
+    REQUIRE(positions.has_value());
+    CHECK(positions->type() == data::type_of<Vec2D>.with_kind(
+                                   data::kind_of<simd::bfloat16_t>));
+    REQUIRE(time_step.has_index());
+    const auto index_positions = time_step.index().find_array("positions");
+    REQUIRE(index_positions.has_value());
+    CHECK(index_positions->type() == data::type_of<Vec2D>);
+    const std::array<std::string_view, 1> names{v.field_name};
+    const auto region = time_step.read_region(
+        geom::BBox{Vec2D{100.05, -1.0}, Vec2D{100.15, 1.0}},
+        std::span{names});
+    CHECK_RANGE_EQ(region.indices, {0});
+  }
+}
+
+TEST_CASE("sph::ParticleArray::read") {
+  ParticleArray2D particles{Space2D{}, meta::Set<>{}, meta::Set{v, m}};
+  h[particles] = 0.5;
+  for (const auto i : {1.0, 2.0, 3.0}) {
+    const auto a = particles.append(sph::ParticleType::fluid);
+    r[a] = {i, 0.0}, v[a] = {0.0, -i}, m[a] = i;
+  }
+  const auto b = particles.append(sph::ParticleType::fixed);
+  r[b] = {4.0, 0.0}, v[b] = {0.0, 0.0}, m[b] = 4.0;
+  data::DataStorage storage{":memory:"};
+  const auto series = storage.create_series("");
+  const auto check_read = [&series](const ParticleArray2D& expected) {
+    ParticleArray2D restored{Space2D{}, meta::Set<>{}, meta::Set{v, m}};
+    restored.append_n(sph::ParticleType::fluid, 7);
+    restored.read(series.last_time_step());
+    CHECK(h[restored] == h[expected]);
+    REQUIRE(restored.size() == expected.size());
+    CHECK(std::ranges::size(restored.fluid()) == 3);
+    CHECK(std::ranges::size(restored.fixed()) == 1);
+    const auto vec_eq = [](const Vec2D& x, const Vec2D& y) {
+      return all(x == y);
+    };
+    CHECK(std::ranges::equal(r[restored], r[expected], vec_eq));
+    CHECK(std::ranges::equal(v[restored], v[expected], vec_eq));
+    CHECK(std::ranges::equal(m[restored], m[expected]));
+  };
+  SUBCASE("full precision") {
+    particles.write(0.0, series);
+    check_read(particles);
+  }
+  SUBCASE("output precision") {
+    // Values are exactly representable in the 16-bit floats.
+    const std::vector<sph::FieldPrecision> precisions{
+        {.field_name = std::string{r.field_name},
+         .kind = data::kind_of<simd::float16_t>},
+        {.field_name = std::string{h.field_name},
+         .kind = data::kind_of<simd::bfloat16_t>},
+    };
+    particles.write(0.0, series, /*num_levels=*/0, precisions);
+    check_read(particles);
+  }
+  SUBCASE("failure") {
+    SUBCASE("no type ranges") {
+      series.create_time_step(0.0);
+      CHECK_THROWS_MSG(particles.read(series.last_time_step()),
+                       Exception,
+                       "Time step has no particle type ranges.");
+    }
+    SUBCASE("missing field") {
+      sph::ParticleArray<Space2D,
+                         decltype(meta::Set{h}),
+                         decltype(meta::Set{r, m})>
+          partial{Space2D{}, meta::Set<>{}};
+      partial.append_n(sph::ParticleType::fluid, 2);
+      partial.write(0.0, series);
+      CHECK_THROWS_MSG(particles.read(series.last_time_step()),
+                       Exception,
+                       "Time step has no field 'v'.");
+      // Particles were not changed.
+      CHECK(particles.size() == 4);
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -6,51 +6,89 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <exception>
 #include <functional>
 #include <iterator>
 #include <limits>
+#include <memory>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <thread>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/containers/mdvector.hpp"
 #include "tit/core/containers/multivector.hpp"
 #include "tit/core/exception.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/memory_stats.hpp"
 #include "tit/core/missing.hpp" // IWYU pragma: keep
 #include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/atomic.hpp"
 #include "tit/core/par/control.hpp"
+#include "tit/core/par/scratch_arena.hpp"
+#include "tit/core/par/task_arena.hpp"
 #include "tit/core/par/task_group.hpp"
 #include "tit/core/profiler.hpp"
+#include "tit/core/range_utils.hpp"
 #include "tit/core/stats.hpp"
-#include "tit/core/type_utils.hpp"
+#include "tit/core/utils.hpp"
 #include "tit/core/vec.hpp"
 
 #include "tit/geom/bbox.hpp"
+#include "tit/geom/grid.hpp"
+#include "tit/geom/point_range.hpp"
 #include "tit/geom/partition.hpp"
 #include "tit/geom/search.hpp"
+#include "tit/geom/sort.hpp"
 
+#include "tit/graph/coloring.hpp"
+#include "tit/graph/compressed_graph.hpp"
 #include "tit/graph/graph.hpp"
 
+#include "tit/sph/boundary.hpp"
 #include "tit/sph/field.hpp"
 #include "tit/sph/particle_array.hpp"
 
 namespace tit::sph {
 
-/// @todo Move it to an appropriate place!
-constexpr auto RADIUS_SCALE = 3;
-inline constexpr auto Domain = geom::BBox{Vec{0.0, 0.0}, Vec{3.2196, 1.5}};
-
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-
 /// Particle adjacency graph.
+///
+/// Particle indices in the adjacency graphs and the block pairs are stored
+/// as @p Index values. 32-bit indices nearly halve the memory footprint of
+/// the mesh, and suffice for less than 2^32 particles.
+///
+/// If @p Compressed is set, the adjacency graphs are stored in the compressed
+/// form (see `graph::CompressedGraph`) and are decoded on the fly, which fits
+/// larger problems into memory at the cost of the decoding.
+///
+/// If @p ImplicitBlocks is set, the block pairs are not stored. Instead, each
+/// block stores the particles that belong to it, and its pairs are found in
+/// the adjacency rows of these particles on the fly. This saves the memory of
+/// all the pairs at the cost of classifying each pair once per block of its
+/// larger particle. Pairs have no indices then, so the kernel cache is not
+/// available.
 template<geom::search_func SearchFunc = geom::GridSearch,
          geom::partition_func PartitionFunc = geom::RecursiveInertialBisection,
-         geom::partition_func InterfacePartitionFunc = PartitionFunc>
+         geom::partition_func InterfacePartitionFunc = PartitionFunc,
+         std::unsigned_integral Index = size_t,
+         bool Compressed = false,
+         bool ImplicitBlocks = false>
 class ParticleMesh final {
 public:
 
+  /// Maximum allowed relative imbalance of the first level parts in the
+  /// incremental partitioning mode.
+  static constexpr real_t MaxPartImbalance = 0.05;
+
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Construct a particle adjacency graph.
@@ -58,13 +96,249 @@ public:
   /// @param search_indexing_func Nearest-neighbors search indexing function.
   /// @param partition_func Geometry partitioning function.
   /// @param interface_partition_func Interface partitioning function.
+  /// @param skin Search radius skin margin. If positive, the adjacency graph
+  ///             is rebuilt only when some particle has moved further than a
+  ///             half of the skin since the last rebuild.
+  /// @param num_levels Number of the partitioning levels.
+  /// @param parts_per_thread Number of parts per thread in each level. Values
+  ///                         greater than one produce smaller blocks, so that
+  ///                         the load is balanced dynamically between the
+  ///                         threads within a level.
   constexpr explicit ParticleMesh(
       SearchFunc search_func = {},
       PartitionFunc partition_func = {},
-      InterfacePartitionFunc interface_partition_func = {}) noexcept
+      InterfacePartitionFunc interface_partition_func = {},
+      real_t skin = 0.0,
+      size_t num_levels = 2,
+      size_t parts_per_thread = 1) noexcept
       : search_func_{std::move(search_func)},
         partition_func_{std::move(partition_func)},
-        interface_partition_func_{std::move(interface_partition_func)} {}
+        interface_partition_func_{std::move(interface_partition_func)},
+        skin_{skin}, num_levels_{num_levels},
+        parts_per_thread_{parts_per_thread} {
+    TIT_ASSERT(skin_ >= 0.0, "Search radius skin must be non-negative!");
+    TIT_ASSERT(num_levels_ > 0, "Number of levels must be positive!");
+    TIT_ASSERT(num_levels_ < PartVec::MaxNumLevels,
+               "Number of levels exceeds the predefined maximum!");
+    TIT_ASSERT(parts_per_thread_ > 0,
+               "Number of parts per thread must be positive!");
+  }
+
+  /// Search radius skin margin.
+  constexpr auto skin() const noexcept -> real_t {
+    return skin_;
+  }
+
+  /// Number of the partitioning levels.
+  constexpr auto num_levels() const noexcept -> size_t {
+    return num_levels_;
+  }
+
+  /// Set the number of the partitioning levels. Takes effect on the next
+  /// rebuild.
+  constexpr void set_num_levels(size_t num_levels) noexcept {
+    TIT_ASSERT(num_levels > 0, "Number of levels must be positive!");
+    TIT_ASSERT(num_levels < PartVec::MaxNumLevels,
+               "Number of levels exceeds the predefined maximum!");
+    num_levels_ = num_levels;
+  }
+
+  /// Number of parts per thread in each partitioning level.
+  constexpr auto parts_per_thread() const noexcept -> size_t {
+    return parts_per_thread_;
+  }
+
+  /// Number of blocks in each level of the block pairs, as of the last
+  /// partitioning. Should be passed to `par::block_for_each`.
+  constexpr auto level_size() const noexcept -> size_t {
+    return level_size_;
+  }
+
+  /// Number of the adjacency graph rebuilds since the construction.
+  constexpr auto num_rebuilds() const noexcept -> size_t {
+    return num_rebuilds_;
+  }
+
+  /// Number of the unique pairs of the adjacent particles, as of the last
+  /// partitioning.
+  constexpr auto num_pairs() const noexcept -> size_t {
+    if constexpr (ImplicitBlocks) {
+      return std::ranges::fold_left(implicit_block_sizes_, 0UZ, std::plus{});
+    } else {
+      return block_edges_.vals().size();
+    }
+  }
+
+  /// Imbalance of the first level blocks, as of the last partitioning: ratio
+  /// of the largest block size to the mean block size. One means that the
+  /// pairs are perfectly balanced between the blocks.
+  auto block_imbalance() const -> real_t {
+    const auto sizes = block_sizes_() | std::views::take(level_size_);
+    const auto num_blocks = static_cast<size_t>(std::ranges::distance(sizes));
+    const auto total = std::ranges::fold_left(sizes, 0UZ, std::plus{});
+    if (total == 0) return 1.0;
+    const auto max = std::ranges::max(sizes);
+    return static_cast<real_t>(max * num_blocks) / static_cast<real_t>(total);
+  }
+
+  /// Block dependency graph, as of the last partitioning.
+  ///
+  /// Each block depends on the lower level blocks that share particles with
+  /// it. Should be passed to `par::deps_for_each`, so that the block is
+  /// processed as soon as its dependencies are finished, without the
+  /// barriers between the levels.
+  constexpr auto block_deps() const noexcept {
+    return block_deps_.buckets();
+  }
+
+  /// Enable or disable the incremental partitioning.
+  ///
+  /// In the incremental mode, the first level partitioning from the previous
+  /// update is reused, and only the interface particles are moved between the
+  /// parts to keep them balanced. Full partitioning is performed if the number
+  /// of particles or threads has changed, or if the parts are still too
+  /// imbalanced after the local rebalancing.
+  constexpr void set_incremental_partition(bool value) noexcept {
+    incremental_partition_ = value;
+  }
+
+  /// Enable or disable the weighted partitioning.
+  ///
+  /// If enabled, each particle is weighted by the number of its neighbors,
+  /// including itself, and the parts are balanced by the total weight rather
+  /// than by the number of particles. This better reflects the cost of the
+  /// pair loops near the free surface and the boundaries.
+  constexpr void set_weighted_partition(bool value) noexcept {
+    weighted_partition_ = value;
+  }
+
+  /// Enable or disable the particle reordering.
+  ///
+  /// If enabled, particles of each type are reordered along the Hilbert
+  /// curve each time the adjacency graph is rebuilt, so that the spatially
+  /// close particles are also close in memory. Note that this changes the
+  /// particle indices, so any outside data indexed by them becomes invalid
+  /// after the update.
+  constexpr void set_reorder(bool value) noexcept {
+    reorder_ = value;
+  }
+
+  /// Enable or disable the cell pair neighbors search.
+  ///
+  /// If enabled, particles are binned into the grid cells not smaller than
+  /// the search radius, and the unique pairs of neighbors are generated by
+  /// sweeping over the adjacent cell pairs, without the per-particle radius
+  /// queries. This mode assumes the uniform search radius: the maximum radius
+  /// over all the particles is used. It is ignored if the particles have the
+  /// periodic boundaries.
+  constexpr void set_cell_pairs(bool value) noexcept {
+    cell_pairs_ = value;
+  }
+
+  /// Set the software prefetch distance of the block pairs.
+  ///
+  /// If positive, iteration over the block pairs prefetches the data of the
+  /// particles of the pair that lies the given number of pairs ahead, see
+  /// `ParticleArray::prefetch`. The best distance depends on the memory
+  /// latency of the machine and the cost of the pair function, zero disables
+  /// the prefetching. Implicit block pairs are never prefetched.
+  constexpr void set_prefetch_distance(size_t value) noexcept {
+    prefetch_distance_ = value;
+  }
+
+  /// Software prefetch distance of the block pairs.
+  constexpr auto prefetch_distance() const noexcept -> size_t {
+    return prefetch_distance_;
+  }
+
+  /// Enable or disable the block pair coloring.
+  ///
+  /// If enabled, the block pairs are colored on each rebuild, so that the
+  /// pairs of the same color do not share any particles, see
+  /// `colored_pairs`. Unlike the block levels, coloring does not depend on
+  /// the quality of the geometric partitioning. Requires the explicit block
+  /// pairs.
+  constexpr void set_pair_coloring(bool value) {
+    if constexpr (ImplicitBlocks) {
+      if (value) TIT_THROW("Pair coloring requires explicit block pairs.");
+    }
+    pair_coloring_ = value;
+    if (value) is_compacted_ = false;
+  }
+
+  /// Is the block pair coloring enabled?
+  constexpr auto pair_coloring() const noexcept -> bool {
+    return pair_coloring_;
+  }
+
+  /// Unique pairs of the adjacent particles grouped by the color, along with
+  /// the pair indices, see `indexed_block_pairs`. Pairs of the same color do
+  /// not share any particles, so they can be processed in parallel.
+  template<particle_array ParticleArray>
+    requires (!ImplicitBlocks)
+  constexpr auto colored_pairs(ParticleArray& particles) const noexcept {
+    TIT_ASSERT(pair_coloring_, "Pair coloring is disabled!");
+    const auto edges = block_edges_.vals();
+    return pair_colors_.buckets() |
+           std::views::transform([&particles, edges](auto color) {
+             return color | std::views::transform([&particles,
+                                                   edges](size_t i) {
+                      const auto [a, b] = edges[i];
+                      return std::tuple{particles[a], particles[b], i};
+                    });
+           });
+  }
+
+  /// Enable or disable the pruning of the inactive fixed particles.
+  ///
+  /// If enabled, fixed particles without any fluid or buffer neighbors are
+  /// marked inactive on each rebuild. Pairs with the inactive particles are
+  /// excluded from the block pairs, and the inactive particles are skipped
+  /// by the boundary setup. Takes effect on the next rebuild.
+  constexpr void set_prune_fixed(bool value) noexcept {
+    prune_fixed_ = value;
+  }
+
+  /// Enable or disable the asynchronous rebuilds.
+  ///
+  /// If enabled, the next adjacency graph and partitioning are built in the
+  /// background on a copy of the particles, as soon as some particle has
+  /// moved further than a quarter of the skin since the last rebuild. The
+  /// updates keep the current mesh, that is still valid, and the new one
+  /// replaces it on the first update after it is finished. If the current
+  /// mesh becomes invalid before that, the update waits for the background
+  /// rebuild, and rebuilds the mesh synchronously if the new mesh is invalid
+  /// too. Background rebuild runs in a separate task arena of @p num_threads
+  /// threads, a quarter of all the threads if zero, and holds a copy of the
+  /// particles and a second mesh, so the memory footprint is roughly
+  /// doubled. Requires a positive skin, and is ignored if the particle
+  /// reordering is enabled, or if the boundary has the rigid bodies, since
+  /// they are moved while the background rebuild projects onto them.
+  void set_async_rebuild(bool value, size_t num_threads = 0) {
+    async_rebuild_ = value;
+    async_threads_ = num_threads;
+    if (!value) async_.reset();
+  }
+
+  /// Are the asynchronous rebuilds enabled?
+  constexpr auto async_rebuild() const noexcept -> bool {
+    return async_rebuild_;
+  }
+
+  /// Is the particle active? Only the fixed particles may be inactive, and
+  /// only if the pruning is enabled.
+  template<particle_view PV>
+  constexpr auto is_active(PV a) const noexcept -> bool {
+    return !is_pruned_(a.index());
+  }
+
+  /// Active fixed particles, as of the last rebuild.
+  template<particle_array ParticleArray>
+  constexpr auto active_fixed(ParticleArray& particles) const noexcept {
+    return std::views::all(active_fixed_) |
+           std::views::transform(
+               [&particles](size_t a) { return particles[a]; });
+  }
 
   /// Adjacent particles.
   template<particle_view PV>
@@ -87,6 +361,54 @@ public:
                [&particles](size_t b) { return particles[b]; });
   }
 
+  /// Projection of the fixed particle onto the domain walls, as of the last
+  /// rebuild. Particles of the moving bodies should be projected with
+  /// `DomainBoundary::project` instead.
+  template<particle_view PV>
+  auto fixed_projection(PV a) const
+      -> BoundaryProjection<particle_vec_t<PV>> {
+    TIT_ASSERT(a.has_type(ParticleType::fixed),
+               "Particle must be of the fixed type!");
+    static constexpr auto Dim = particle_dim_v<PV>;
+    const size_t i = a - *a.array().fixed().begin();
+    return {
+        .mirror = cached_vec_<PV>(fixed_proj_, i, 0),
+        .normal = cached_vec_<PV>(fixed_proj_, i, Dim),
+        .dist = static_cast<particle_num_t<PV>>(fixed_proj_[i, 2 * Dim]),
+    };
+  }
+
+  /// Set the probe points, e.g. the points of the gauges, see `ProbeSet`.
+  /// Fluid and buffer particles around the probes are searched on each
+  /// rebuild, within the largest search radius of the fluid particles.
+  /// Mesh is invalidated.
+  template<class Num, size_t Dim>
+  void set_probes(std::span<const Vec<Num, Dim>> points) {
+    probe_points_.assign(points.size(), Dim);
+    for (size_t i = 0; i < points.size(); ++i) {
+      for (size_t j = 0; j < Dim; ++j) {
+        probe_points_[i, j] = static_cast<real_t>(points[i][j]);
+      }
+    }
+    invalidate();
+  }
+
+  /// Number of the probe points, whose neighbors were searched on the last
+  /// rebuild.
+  constexpr auto num_probes() const noexcept -> size_t {
+    return probe_adjacency_.size();
+  }
+
+  /// Particles around the probe point, as of the last rebuild.
+  template<particle_array ParticleArray>
+  constexpr auto probe_neighbors(ParticleArray& particles,
+                                 size_t i) const noexcept {
+    TIT_ASSERT(i < num_probes(), "Probe index is out of range!");
+    return probe_adjacency_[i] | //
+           std::views::transform(
+               [&particles](size_t b) { return particles[b]; });
+  }
+
   /// Unique pairs of the adjacent particles.
   template<particle_array ParticleArray>
   constexpr auto pairs(ParticleArray& particles) const noexcept {
@@ -97,120 +419,1113 @@ public:
   }
 
   /// Unique pairs of the adjacent particles partitioned by the block.
+  /// Consecutive `level_size()` blocks form a level, blocks within a level
+  /// do not share any particles.
   template<particle_array ParticleArray>
   constexpr auto block_pairs(ParticleArray& particles) const noexcept {
-    return block_edges_.buckets() |
-           std::views::transform([&particles](auto block) {
-             return block | std::views::transform([&particles](auto ab) {
-                      const auto [a, b] = ab;
-                      /// @todo I have zero idea why, but using pair here
-                      /// instead of a tuple causes a massive performance hit.
-                      return std::tuple{particles[a], particles[b]};
-                    });
-           });
+    if constexpr (ImplicitBlocks) {
+      return std::views::iota(size_t{0}, block_particles_.size()) |
+             std::views::transform([&particles, this](size_t q) {
+               return implicit_block_edges_(parinfo[particles], q) |
+                      std::views::transform([&particles](auto ab) {
+                        const auto [a, b] = ab;
+                        return std::tuple{particles[a], particles[b]};
+                      });
+             });
+    } else {
+      return pair_edges_().buckets() |
+             std::views::transform([&particles, this](auto block) {
+               return block |
+                      std::views::transform([&particles,
+                                             this](const auto& ab) {
+                        prefetch_ahead_(particles, &ab);
+                        const auto [a, b] = ab;
+                        /// @todo I have zero idea why, but using pair here
+                        /// instead of a tuple causes a massive performance hit.
+                        return std::tuple{particles[a], particles[b]};
+                      });
+             });
+    }
+  }
+
+  /// Unique pairs of the adjacent particles partitioned by the block, along
+  /// with the pair indices. Pair index addresses the per-pair data, such as
+  /// the kernel cache. With the implicit block pairs, pair indices are `npos`.
+  template<particle_array ParticleArray>
+  constexpr auto indexed_block_pairs(ParticleArray& particles) const noexcept {
+    if constexpr (ImplicitBlocks) {
+      return block_pairs(particles) |
+             std::views::transform([](auto block) {
+               return block | std::views::transform([](auto ab) {
+                        const auto [a, b] = ab;
+                        return std::tuple{a, b, npos};
+                      });
+             });
+    } else {
+      const auto* const first = pair_edges_().vals().data();
+      const auto indexed_pair = [&particles, first, this](const auto& ab) {
+        prefetch_ahead_(particles, &ab);
+        const auto [a, b] = ab;
+        const auto i = static_cast<size_t>(&ab - first);
+        return std::tuple{particles[a], particles[b], i};
+      };
+      return pair_edges_().buckets() |
+             std::views::transform([indexed_pair](auto block) {
+               return block | std::views::transform(indexed_pair);
+             });
+    }
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Enable or disable the block pair compaction.
+  ///
+  /// With a positive skin, a sizeable fraction of the block pairs lies
+  /// outside of the kernel support at any given step, and the pair loops
+  /// compute zero contributions for them. If enabled, `compact_pairs` filters
+  /// the block pairs into the pairs within the support, so that the pair
+  /// loops and the kernel cache only process those until the next rebuild or
+  /// compaction. Compaction is not available with the implicit block pairs,
+  /// and is skipped while the pair coloring is enabled, since the colors refer
+  /// to all the pairs.
+  constexpr void set_pair_compaction(bool value) noexcept {
+    pair_compaction_ = value && !ImplicitBlocks;
+    if (!pair_compaction_) is_compacted_ = false;
+  }
+
+  /// Is the block pair compaction enabled?
+  constexpr auto pair_compaction() const noexcept -> bool {
+    return pair_compaction_;
+  }
+
+  /// Compact the block pairs for the current particle positions.
+  ///
+  /// Pair is kept if the distance between its particles is less than the
+  /// larger of their support radii. Compaction must be repeated each time the
+  /// particle positions change, before the kernel cache is filled. Does
+  /// nothing unless the compaction is enabled.
+  ///
+  /// @param radius_func Support radius of the particle.
+  template<particle_array ParticleArray, class SupportRadiusFunc>
+  void compact_pairs(ParticleArray& particles,
+                     const SupportRadiusFunc& radius_func) {
+    if constexpr (!ImplicitBlocks) {
+      if (!pair_compaction_ || pair_coloring_) return;
+      TIT_PROFILE_SECTION("ParticleMesh::compact_pairs()");
+
+      // Flag the pairs within the support.
+      const auto edges = block_edges_.vals();
+      pair_flags_.resize(edges.size());
+      par::transform(edges,
+                     pair_flags_.begin(),
+                     [&particles, &radius_func](const auto& ab) -> uint8_t {
+                       const auto a = particles[ab.first];
+                       const auto b = particles[ab.second];
+                       const auto radius =
+                           std::max(radius_func(a), radius_func(b));
+                       return norm2(r[a, b]) < pow2(radius) ? 1 : 0;
+                     });
+
+      // Gather the flagged pairs of each block, keeping the blocks.
+      const auto block_flags = [edges, this](size_t q) {
+        const auto block = block_edges_[q];
+        const auto offset = static_cast<size_t>(block.data() - edges.data());
+        return std::span{pair_flags_}.subspan(offset, block.size());
+      };
+      compacted_edges_.assign_buckets_par(
+          block_edges_.size(),
+          [&block_flags](size_t q) {
+            return static_cast<size_t>(std::ranges::count(block_flags(q), 1));
+          },
+          [&block_flags, this](size_t q,
+                               std::span<std::pair<Index, Index>> pairs) {
+            const auto block = block_edges_[q];
+            const auto flags = block_flags(q);
+            auto out = pairs.begin();
+            for (size_t k = 0; k < block.size(); ++k) {
+              if (flags[k] != 0) *out++ = block[k];
+            }
+          });
+      is_compacted_ = true;
+      kernel_points_.clear();
+    }
+  }
+
+  /// Number of the block pairs after the last compaction, or all the block
+  /// pairs, if they were not compacted since the last rebuild.
+  constexpr auto num_compacted_pairs() const noexcept -> size_t {
+    if constexpr (ImplicitBlocks) return num_pairs();
+    else return pair_edges_().vals().size();
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Enable or disable the per-pair kernel cache.
+  ///
+  /// If enabled, kernel values and kernel gradients of the unique pairs are
+  /// stored alongside the block pairs, so that the pair loops can read them
+  /// instead of evaluating the kernel each time. Cache is never enabled with
+  /// the implicit block pairs.
+  constexpr void set_kernel_cache(bool value) noexcept {
+    kernel_cache_ = value && !ImplicitBlocks;
+    if (!kernel_cache_) {
+      pair_kernel_.clear();
+      kernel_points_.clear();
+    }
+  }
+
+  /// Is the per-pair kernel cache enabled?
+  constexpr auto kernel_cache() const noexcept -> bool {
+    return kernel_cache_;
+  }
+
+  /// Fill the per-pair kernel cache for the current particle positions.
+  ///
+  /// Cache stays valid until the adjacency is rebuilt or compacted, or the
+  /// particle positions or widths change, see `has_cached_kernel`.
+  template<particle_array ParticleArray, class Kernel>
+  void cache_kernel(ParticleArray& particles, const Kernel& kernel) {
+    TIT_PROFILE_SECTION("ParticleMesh::cache_kernel()");
+    using PV = ParticleView<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    TIT_ASSERT(kernel_cache_, "Kernel cache is disabled!");
+    const auto edges = pair_edges_().vals();
+    pair_kernel_.assign(edges.size(), Dim + 1);
+    const auto cache_pair = [&particles, &kernel, edges, this](size_t i) {
+      const auto a = particles[edges[i].first];
+      const auto b = particles[edges[i].second];
+      const auto W_ab = kernel(a, b);
+      const auto grad_W_ab = kernel.grad(a, b);
+      pair_kernel_[i, 0] = static_cast<real_t>(W_ab);
+      for (size_t j = 0; j < Dim; ++j) {
+        pair_kernel_[i, 1 + j] = static_cast<real_t>(grad_W_ab[j]);
+      }
+    };
+    par::for_each(std::views::iota(size_t{0}, edges.size()), cache_pair);
+
+    // Remember the positions and widths the cache was filled for.
+    kernel_points_.assign(particles.size(), Dim + 1);
+    par::for_each(particles.all(), [this](PV a) {
+      for (size_t i = 0; i < Dim; ++i) {
+        kernel_points_[a.index(), i] = static_cast<real_t>(r[a][i]);
+      }
+      kernel_points_[a.index(), Dim] = kernel_width_(a);
+    });
+    kernel_generation_ = particles.generation();
+  }
+
+  /// Is the per-pair kernel cache filled for the current adjacency?
+  constexpr auto has_cached_kernel() const noexcept -> bool {
+    return kernel_cache_ &&
+           pair_kernel_.shape()[0] == pair_edges_().vals().size();
+  }
+
+  /// Is the per-pair kernel cache filled for the current adjacency, and for
+  /// the current particle positions and widths? If so, neither the cache
+  /// nor the compacted pairs need to be refilled.
+  template<particle_array ParticleArray>
+  auto has_cached_kernel(ParticleArray& particles) const -> bool {
+    using PV = ParticleView<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    if (!has_cached_kernel()) return false;
+    if (kernel_points_.shape() != std::array{particles.size(), Dim + 1} ||
+        kernel_generation_ != particles.generation()) {
+      return false;
+    }
+    std::atomic_bool changed = false;
+    par::for_each(particles.all(), [&changed, this](PV a) {
+      bool same = kernel_points_[a.index(), Dim] == kernel_width_(a);
+      for (size_t i = 0; i < Dim; ++i) {
+        same &= kernel_points_[a.index(), i] == static_cast<real_t>(r[a][i]);
+      }
+      if (!same) changed.store(true, std::memory_order_relaxed);
+    });
+    return !changed.load(std::memory_order_relaxed);
+  }
+
+  /// Cached kernel value of the pair.
+  template<particle_view PV>
+  auto cached_kernel(size_t pair_index) const -> particle_num_t<PV> {
+    TIT_ASSERT(has_cached_kernel(), "Kernel cache is not filled!");
+    return static_cast<particle_num_t<PV>>(pair_kernel_[pair_index, 0]);
+  }
+
+  /// Cached kernel gradient of the pair.
+  template<particle_view PV>
+  auto cached_kernel_grad(size_t pair_index) const -> particle_vec_t<PV> {
+    TIT_ASSERT(has_cached_kernel(), "Kernel cache is not filled!");
+    return cached_vec_<PV>(pair_kernel_, pair_index, 1);
+  }
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+  /// Enable or disable the interpolation weights cache of the fixed particles.
+  ///
+  /// If enabled, interpolation weights of the fixed particles are computed
+  /// once per rebuild and reused until the next one. Weights are exact for
+  /// the fixed particles, but the motion of the fluid particles between the
+  /// rebuilds is neglected. Particles of the moving bodies are never cached.
+  constexpr void set_interp_cache(bool value) noexcept {
+    interp_cache_ = value;
+    if (!interp_cache_) interp_cached_ = false;
+  }
+
+  /// Is the interpolation weights cache enabled?
+  constexpr auto interp_cache() const noexcept -> bool {
+    return interp_cache_;
+  }
+
+  /// Is the interpolation weights cache filled for the current adjacency?
+  constexpr auto has_cached_interp() const noexcept -> bool {
+    return interp_cache_ && interp_cached_;
+  }
+
+  /// Fill the interpolation weights cache of the fixed particles.
+  ///
+  /// @param weights_func Function that writes the weights of the particles
+  ///                     in `fixed_interp(b)` for the fixed particle `b` into
+  ///                     the given span, and returns false if the
+  ///                     interpolation fails.
+  template<particle_array ParticleArray, class WeightsFunc>
+  void cache_interp(ParticleArray& particles, const WeightsFunc& weights_func) {
+    TIT_PROFILE_SECTION("ParticleMesh::cache_interp()");
+    TIT_ASSERT(interp_cache_, "Interpolation cache is disabled!");
+    const auto fixed_particles = particles.fixed();
+    const auto num_fixed = std::size(fixed_particles);
+    interp_valid_.assign(num_fixed, 0);
+    interp_weights_.assign_buckets_par(
+        num_fixed,
+        [this](size_t i) { return std::ranges::size(interp_adjacency_[i]); },
+        [fixed_particles, &weights_func, this](size_t i,
+                                               std::span<real_t> weights) {
+          const auto is_valid = weights_func(fixed_particles[i], weights);
+          interp_valid_[i] = is_valid ? 1 : 0;
+        });
+    interp_cached_ = true;
+  }
+
+  /// Cached interpolation weights of the fixed particle, one for each
+  /// particle in `fixed_interp(b)`, or nothing if the interpolation failed.
+  template<particle_view PV>
+  auto cached_interp_weights(PV b) const
+      -> std::optional<std::span<const real_t>> {
+    TIT_ASSERT(has_cached_interp(), "Interpolation cache is not filled!");
+    TIT_ASSERT(b.has_type(ParticleType::fixed),
+               "Particle must be of the fixed type!");
+    const size_t i = b - *b.array().fixed().begin();
+    if (interp_valid_[i] == 0) return std::nullopt;
+    return interp_weights_[i];
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   /// Update the adjacency graph.
-  template<particle_array ParticleArray, class SearchRadiusFunc>
-  void update(ParticleArray& particles, const SearchRadiusFunc& radius_func) {
+  ///
+  /// If the mesh has a positive skin, the update is skipped unless some
+  /// particle has moved further than a half of the skin since the last
+  /// rebuild, or its search radius has grown, so it is cheap to call this
+  /// function on every time step. Particles, that were added, removed or
+  /// reordered, are detected by the generation of the particle array.
+  ///
+  /// @param radius_func Search radius of the particle.
+  /// @param boundary Domain boundary, used to find the interpolation points
+  ///                 of the fixed particles.
+  template<particle_array ParticleArray,
+           class SearchRadiusFunc,
+           domain_boundary Boundary>
+  void update(ParticleArray& particles,
+              const SearchRadiusFunc& radius_func,
+              const Boundary& boundary) {
     TIT_PROFILE_SECTION("ParticleMesh::update()");
 
+    // Skip the update if the current adjacency is still valid. In the
+    // asynchronous mode, the background rebuild may replace it instead.
+    if (async_rebuild_ && skin_ > 0.0 && !reorder_ &&
+        boundary.bodies() == nullptr) {
+      if (update_async_(particles, radius_func, boundary)) return;
+    } else if (!needs_rebuild_(particles, radius_func, boundary)) {
+      return;
+    }
+
+    // Wrap the particles, that have crossed the periodic boundaries.
+    wrap_particles_(particles);
+
+    // Reorder the particles along the space filling curve.
+    if (reorder_) reorder_particles_(particles);
+
+    // Rebuild the mesh.
+    rebuild_(particles, radius_func, boundary, par::num_threads());
+    num_rebuilds_ += 1;
+  }
+
+  /// Invalidate the adjacency graph, so that it is rebuilt on the next
+  /// update, regardless of the skin. Must be called after the particles
+  /// were added or removed, e.g. by the particle refinement.
+  constexpr void invalidate() noexcept {
+    positions_.clear();
+    if (async_ != nullptr) async_->discard = true;
+  }
+
+  /// Record the heap footprint of the mesh data structures, see
+  /// `MemoryStats`.
+  void record_memory_stats() const {
+    TIT_MEMORY_STATS("ParticleMesh::adjacency", adjacency_);
+    TIT_MEMORY_STATS("ParticleMesh::interp_adjacency", interp_adjacency_);
+    TIT_MEMORY_STATS("ParticleMesh::probe_adjacency", probe_adjacency_);
+    TIT_MEMORY_STATS("ParticleMesh::block_edges", block_edges_);
+    TIT_MEMORY_STATS("ParticleMesh::compacted_edges",
+                     compacted_edges_,
+                     pair_flags_);
+    TIT_MEMORY_STATS("ParticleMesh::block_particles", block_particles_);
+    TIT_MEMORY_STATS("ParticleMesh::block_deps",
+                     block_deps_,
+                     block_deps_lists_);
+    TIT_MEMORY_STATS("ParticleMesh::search_scratch", search_scratch_);
+    TIT_MEMORY_STATS("ParticleMesh::positions", positions_, radii_);
+    TIT_MEMORY_STATS("ParticleMesh::pair_kernel",
+                     pair_kernel_,
+                     kernel_points_);
+    TIT_MEMORY_STATS("ParticleMesh::interp_weights", interp_weights_);
+    TIT_MEMORY_STATS("ParticleMesh::pairs", thread_pairs_, directed_pairs_);
+  }
+
+private:
+
+  // Adjacency graph type.
+  using Adjacency_ = std::conditional_t<Compressed,
+                                        graph::CompressedGraph,
+                                        graph::BasicGraph<Index>>;
+
+  // Width of the particle, that the cached kernel values depend on.
+  template<particle_view PV>
+  static auto kernel_width_(PV a) -> real_t {
+    if constexpr (has<PV>(h)) return static_cast<real_t>(h[a]);
+    else return 0.0;
+  }
+
+  // Read a vector from the row of the cache.
+  template<particle_view PV>
+  static auto cached_vec_(const Mdvector<real_t, 2>& cache,
+                          size_t row,
+                          size_t offset) -> particle_vec_t<PV> {
+    using Num = particle_num_t<PV>;
+    particle_vec_t<PV> result{};
+    for (size_t j = 0; j < particle_dim_v<PV>; ++j) {
+      result[j] = static_cast<Num>(cache[row, offset + j]);
+    }
+    return result;
+  }
+
+  // Project the fixed particles onto the domain walls, or onto the walls of
+  // their bodies, if they move with the rigid bodies.
+  template<particle_array ParticleArray, domain_boundary Boundary>
+  void project_fixed_(ParticleArray& particles, const Boundary& boundary) {
+    TIT_PROFILE_SECTION("ParticleMesh::project_fixed()");
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    static_assert(Boundary::Dim == Dim,
+                  "Boundary and particle dimensions must match!");
+    const auto fixed_particles = particles.fixed();
+    fixed_proj_.assign(std::size(fixed_particles), 2 * Dim + 1);
+    par::for_each(
+        std::views::iota(size_t{0}, std::size(fixed_particles)),
+        [fixed_particles, &boundary, this](size_t i) {
+          const auto [mirror, normal, dist] =
+              boundary.project(fixed_particles[i]);
+          for (size_t j = 0; j < Dim; ++j) {
+            fixed_proj_[i, j] = static_cast<real_t>(mirror[j]);
+            fixed_proj_[i, Dim + j] = static_cast<real_t>(normal[j]);
+          }
+          fixed_proj_[i, 2 * Dim] = static_cast<real_t>(dist);
+        });
+  }
+
+  // Rebuild the mesh for the particles, partitioned for the given number of
+  // threads.
+  template<particle_array ParticleArray,
+           class SearchRadiusFunc,
+           domain_boundary Boundary>
+  void rebuild_(ParticleArray& particles,
+                const SearchRadiusFunc& radius_func,
+                const Boundary& boundary,
+                size_t num_threads) {
+    // Compacted pairs and the kernel cache refer to the previous block pairs.
+    is_compacted_ = false;
+    kernel_points_.clear();
+
+    // Fixed particles of the walls never move, so their projections onto the
+    // walls are valid until the next rebuild, that may reorder them. Moving
+    // particles are projected again by the boundary on each step.
+    project_fixed_(particles, boundary);
+
     // Update the adjacency graphs.
-    search_(particles, radius_func);
+    search_(particles, radius_func, boundary);
+
+    // Find the fixed particles, that interact with the fluid.
+    find_active_fixed_(particles);
 
     // Partition the adjacency graph by the block.
-    partition_(particles);
+    partition_(particles, num_threads);
+
+    // Remember the particle positions and the search radii for the further
+    // displacement checks.
+    store_positions_(particles, radius_func);
   }
 
-private:
+  // Check if particles have moved far enough to invalidate the adjacency.
+  template<particle_array ParticleArray,
+           class SearchRadiusFunc,
+           domain_boundary Boundary>
+  auto needs_rebuild_(ParticleArray& particles,
+                      const SearchRadiusFunc& radius_func,
+                      const Boundary& boundary) const -> bool {
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+
+    // Without the skin, or if particles were added, removed or reordered,
+    // the adjacency must be always rebuilt. Same number of particles does
+    // not mean the same particles, so the generation is compared.
+    if (skin_ == 0.0) return true;
+    if (positions_.shape() != std::array{particles.size(), Dim}) return true;
+    if (generation_ != particles.generation()) return true;
 
+    // Note: if two particles are moving towards each other, their distance
+    //       decreases by the sum of their displacements, so the threshold is
+    //       a half of the skin. Interpolation points of the moving bodies
+    //       are checked the same way, since they are not the particles.
+    return has_moved_(particles, radius_func, skin_ / 2) ||
+           has_moved_mirrors_(particles, boundary, skin_ / 2);
+  }
+
+  // Check if some particle has moved further than the given distance since
+  // the last rebuild. Growth of the search radius consumes the skin as well:
+  // the pair stays covered while the sum of the displacements and of the
+  // radius growth is within the skin, so a half of the growth is added to
+  // the displacement of the particle.
   template<particle_array ParticleArray, class SearchRadiusFunc>
-  void search_(ParticleArray& particles, const SearchRadiusFunc& radius_func) {
+  auto has_moved_(ParticleArray& particles,
+                  const SearchRadiusFunc& radius_func,
+                  real_t distance) const -> bool {
+    using PV = ParticleView<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    std::atomic_bool moved_too_far = false;
+    par::for_each(
+        particles.all(),
+        [&moved_too_far, &radius_func, distance, this](PV a) {
+          real_t dist{};
+          for (size_t i = 0; i < Dim; ++i) {
+            dist +=
+                pow2(static_cast<real_t>(r[a][i]) - positions_[a.index(), i]);
+          }
+          const auto growth =
+              static_cast<real_t>(radius_func(a)) - radii_[a.index()];
+          const auto budget = distance - std::max(growth, real_t{0}) / 2;
+          if (budget < 0.0 || dist > pow2(budget)) {
+            moved_too_far.store(true, std::memory_order_relaxed);
+          }
+        });
+    return moved_too_far.load(std::memory_order_relaxed);
+  }
+
+  // Check if some mirror image of the fixed particles of the moving rigid
+  // bodies has moved further than the given distance since the last rebuild.
+  // Interpolation adjacency is searched around the mirror images, so it
+  // becomes invalid once they move, even if the body particles do not.
+  template<particle_array ParticleArray, domain_boundary Boundary>
+  auto has_moved_mirrors_(ParticleArray& particles,
+                          const Boundary& boundary,
+                          real_t distance) const -> bool {
+    using PV = ParticleView<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    if constexpr (has<PV>(body)) {
+      if (boundary.bodies() == nullptr) return false;
+      const auto fixed_particles = particles.fixed();
+      std::atomic_bool moved_too_far = false;
+      const auto max_dist = pow2(distance);
+      par::for_each(
+          std::views::iota(size_t{0}, std::size(fixed_particles)),
+          [fixed_particles, &boundary, &moved_too_far, max_dist, this](
+              size_t i) {
+            const PV b = fixed_particles[i];
+            if (!boundary.is_moving(b)) return;
+            const auto mirror = boundary.project(b).mirror;
+            real_t dist{};
+            for (size_t j = 0; j < Dim; ++j) {
+              dist += pow2(static_cast<real_t>(mirror[j]) - fixed_proj_[i, j]);
+            }
+            if (dist > max_dist) {
+              moved_too_far.store(true, std::memory_order_relaxed);
+            }
+          });
+      return moved_too_far.load(std::memory_order_relaxed);
+    } else {
+      return false;
+    }
+  }
+
+  // Update the mesh in the asynchronous rebuild mode. Returns true if the
+  // current mesh is valid after the update.
+  template<particle_array ParticleArray,
+           class SearchRadiusFunc,
+           domain_boundary Boundary>
+  auto update_async_(ParticleArray& particles,
+                     const SearchRadiusFunc& radius_func,
+                     const Boundary& boundary) -> bool {
+    if (async_ == nullptr) async_ = std::make_unique<AsyncRebuild_>();
+    auto& async = *async_;
+
+    // Swap in the background rebuild, once it is finished, or once the
+    // current mesh becomes invalid. Rebuild of the particles, that were
+    // added or removed since its start, is discarded.
+    if (async.thread.joinable()) {
+      if (!async.done.load(std::memory_order_acquire) &&
+          !needs_rebuild_(particles, radius_func, boundary)) {
+        return true;
+      }
+      TIT_PROFILE_SECTION("ParticleMesh::swap_async()");
+      async.thread.join();
+      if (async.error) std::rethrow_exception(std::exchange(async.error, {}));
+      if (!async.discard && async.parts.size() == particles.size()) {
+        swap_state_(*async.mesh);
+        std::ranges::copy(async.parts, std::begin(parinfo[particles]));
+        wrap_particles_(particles);
+        num_rebuilds_ += 1;
+      }
+    }
+
+    // Rebuild synchronously if the mesh is invalid, or start the background
+    // rebuild, if it is about to become invalid.
+    if (needs_rebuild_(particles, radius_func, boundary)) return false;
+    if (has_moved_(particles, radius_func, skin_ / 4)) {
+      launch_async_(particles, radius_func, boundary);
+    }
+    return true;
+  }
+
+  // Start the background rebuild on the copy of the particles.
+  template<particle_array ParticleArray,
+           class SearchRadiusFunc,
+           domain_boundary Boundary>
+  void launch_async_(const ParticleArray& particles,
+                     const SearchRadiusFunc& radius_func,
+                     const Boundary& boundary) {
+    TIT_PROFILE_SECTION("ParticleMesh::launch_async()");
+    auto& async = *async_;
+    if (async.mesh == nullptr) {
+      async.mesh = std::make_unique<ParticleMesh>(search_func_,
+                                                  partition_func_,
+                                                  interface_partition_func_,
+                                                  skin_,
+                                                  num_levels_,
+                                                  parts_per_thread_);
+    }
+
+    // Settings and the incremental partitioning state are copied to the
+    // background mesh, so that it rebuilds the same way this one would.
+    auto& mesh = *async.mesh;
+    mesh.skin_ = skin_;
+    mesh.num_levels_ = num_levels_;
+    mesh.parts_per_thread_ = parts_per_thread_;
+    mesh.incremental_partition_ = incremental_partition_;
+    mesh.weighted_partition_ = weighted_partition_;
+    mesh.kernel_cache_ = kernel_cache_;
+    mesh.interp_cache_ = interp_cache_;
+    mesh.cell_pairs_ = cell_pairs_;
+    mesh.pair_coloring_ = pair_coloring_;
+    mesh.pair_compaction_ = pair_compaction_;
+    mesh.prune_fixed_ = prune_fixed_;
+    mesh.probe_points_ = probe_points_;
+    mesh.part_sizes_ = part_sizes_;
+    mesh.num_partitioned_ = num_partitioned_;
+
+    // Blocks are partitioned for the threads of this mesh, not for the
+    // threads of the background arena.
+    const auto num_threads = par::num_threads();
+    const auto num_async_threads =
+        async_threads_ != 0 ? async_threads_ :
+                              std::max<size_t>(num_threads / 4, 1);
+    async.done.store(false, std::memory_order_relaxed);
+    async.discard = false;
+    async.thread = std::jthread{[&async,
+                                 &mesh,
+                                 snapshot = particles,
+                                 radius_func,
+                                 boundary,
+                                 num_threads,
+                                 num_async_threads]() mutable {
+      try {
+        par::TaskArena arena{num_async_threads};
+        arena.execute([&mesh,
+                       &snapshot,
+                       &radius_func,
+                       &boundary,
+                       num_threads] {
+          wrap_particles_(snapshot);
+          mesh.rebuild_(snapshot, radius_func, boundary, num_threads);
+        });
+        const auto parts = parinfo[snapshot];
+        async.parts.assign(std::begin(parts), std::end(parts));
+      } catch (...) {
+        async.error = std::current_exception();
+      }
+      async.done.store(true, std::memory_order_release);
+    }};
+  }
+
+  // Swap the rebuilt state with the other mesh. Settings are kept.
+  void swap_state_(ParticleMesh& other) {
+    using std::swap;
+    swap(adjacency_, other.adjacency_);
+    swap(interp_adjacency_, other.interp_adjacency_);
+    swap(probe_adjacency_, other.probe_adjacency_);
+    swap(interface_, other.interface_);
+    swap(block_edges_, other.block_edges_);
+    swap(compacted_edges_, other.compacted_edges_);
+    swap(is_compacted_, other.is_compacted_);
+    swap(block_particles_, other.block_particles_);
+    swap(implicit_block_sizes_, other.implicit_block_sizes_);
+    swap(block_deps_, other.block_deps_);
+    swap(block_deps_lists_, other.block_deps_lists_);
+    swap(level_size_, other.level_size_);
+    swap(positions_, other.positions_);
+    swap(radii_, other.radii_);
+    swap(generation_, other.generation_);
+    swap(part_sizes_, other.part_sizes_);
+    swap(num_partitioned_, other.num_partitioned_);
+    swap(weights_, other.weights_);
+    swap(pair_kernel_, other.pair_kernel_);
+    swap(kernel_points_, other.kernel_points_);
+    swap(fixed_proj_, other.fixed_proj_);
+    swap(interp_cached_, other.interp_cached_);
+    swap(interp_valid_, other.interp_valid_);
+    swap(interp_weights_, other.interp_weights_);
+    swap(cell_points_, other.cell_points_);
+    swap(edge_coloring_, other.edge_coloring_);
+    swap(pair_colors_, other.pair_colors_);
+    swap(first_fixed_, other.first_fixed_);
+    swap(fixed_active_, other.fixed_active_);
+    swap(active_fixed_, other.active_fixed_);
+    swap(thread_pairs_, other.thread_pairs_);
+    swap(directed_pairs_, other.directed_pairs_);
+  }
+
+  // Reorder the particles of each type along the Hilbert curve.
+  template<particle_array ParticleArray>
+  void reorder_particles_(ParticleArray& particles) {
+    TIT_PROFILE_SECTION("ParticleMesh::reorder_particles()");
+    perm_.resize(particles.size());
+    for (size_t type_index = 0;
+         type_index < std::to_underlying(ParticleType::count);
+         ++type_index) {
+      const auto typed = particles.typed(static_cast<ParticleType>(type_index));
+      if (std::ranges::empty(typed)) continue;
+      const auto first = (*std::begin(typed)).index();
+      const auto count = std::size(typed);
+      const auto typed_perm = std::span{perm_}.subspan(first, count);
+      geom::HilbertCurveSort{}(r[particles].subspan(first, count), typed_perm);
+      par::for_each(typed_perm, [first](size_t& i) { i += first; });
+    }
+    particles.reorder(perm_);
+  }
+
+  // Store the particle positions, the search radii and the generation of
+  // the particles at the moment of the rebuild.
+  template<particle_array ParticleArray, class SearchRadiusFunc>
+  void store_positions_(ParticleArray& particles,
+                        const SearchRadiusFunc& radius_func) {
+    using PV = ParticleView<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    if (skin_ == 0.0) return;
+    positions_.assign(particles.size(), Dim);
+    radii_.resize(particles.size());
+    par::for_each(particles.all(), [&radius_func, this](PV a) {
+      for (size_t i = 0; i < Dim; ++i) {
+        positions_[a.index(), i] = static_cast<real_t>(r[a][i]);
+      }
+      radii_[a.index()] = static_cast<real_t>(radius_func(a));
+    });
+    generation_ = particles.generation();
+  }
+
+  // Wrap the particles into the periodic box of the particle array.
+  template<particle_array ParticleArray>
+  static void wrap_particles_(ParticleArray& particles) {
+    using PV = ParticleView<ParticleArray>;
+    const auto& periodic_box = particles.periodic_box();
+    if (!periodic_box.is_periodic()) return;
+    par::for_each(particles.all(), [&periodic_box](PV a) {
+      r[a] = periodic_box.wrap(r[a]);
+    });
+  }
+
+  template<particle_array ParticleArray,
+           class SearchRadiusFunc,
+           domain_boundary Boundary>
+  void search_(ParticleArray& particles,
+               const SearchRadiusFunc& radius_func,
+               const Boundary& boundary) {
     TIT_PROFILE_SECTION("ParticleMesh::search()");
     using PV = ParticleView<ParticleArray>;
+    if (auto max_num_particles = std::numeric_limits<Index>::max();
+        particles.size() > max_num_particles) {
+      TIT_THROW("Number of particles exceeded the limit of {}.",
+                max_num_particles);
+    }
 
     // Build the search index.
     const auto positions = r[particles];
-    const auto search_index = search_func_(positions);
+    const auto search_index = make_index_(positions, particles);
 
-    // Search for the neighbors.
+    // Search for the neighbors. Intermediate results of the previous search
+    // are not used anymore, so the scratch memory is reused.
+    search_scratch_.reset();
     par::TaskGroup search_tasks{};
     search_tasks.run([&particles, &radius_func, &search_index, this] {
-      static std::vector<std::vector<size_t>> adjacency_buckets{};
-      adjacency_buckets.resize(particles.size());
-      par::for_each(particles.all(), [&radius_func, &search_index](PV a) {
-        const auto& search_point = r[a];
-        const auto search_radius = radius_func(a);
-        TIT_ASSERT(search_radius > 0.0, "Search radius must be positive.");
-
-        // Search for the neighbors for the current particle and store the
-        // sorted results.
-        auto& search_results = adjacency_buckets[a.index()];
-        search_results.clear();
-        search_index.search(search_point,
-                            search_radius,
-                            std::back_inserter(search_results));
-        std::ranges::sort(search_results);
-      });
-      adjacency_.assign_buckets_par(adjacency_buckets);
+      auto adjacency = take_graph_(adjacency_);
+      if (cell_pairs_ && !particles.periodic_box().is_periodic()) {
+        cell_pairs_search_(particles, radius_func, adjacency);
+        store_graph_(adjacency_, std::move(adjacency));
+        return;
+      }
+
+      // Search for the neighbors of all the particles at once, and store the
+      // sorted results directly into the graph.
+      const auto search_radii =
+          std::views::iota(size_t{0}, particles.size()) |
+          std::views::transform([&particles, &radius_func, this](size_t i) {
+            const auto search_radius = radius_func(particles[i]) + skin_;
+            TIT_ASSERT(search_radius > 0.0, "Search radius must be positive.");
+            return search_radius;
+          });
+      search_index.search_batch(r[particles],
+                                search_radii,
+                                adjacency,
+                                AlwaysTrue{},
+                                &search_scratch_);
+      store_graph_(adjacency_, std::move(adjacency));
     });
 
-    // Search for the interpolation points for the fixed particles.
-    search_tasks.run([&particles, &radius_func, &search_index, this] {
-      static std::vector<std::vector<size_t>> interp_adjacency_buckets{};
-      interp_adjacency_buckets.resize(particles.fixed().size());
-      par::for_each( //
-          std::views::enumerate(particles.fixed()),
-          [&radius_func, &search_index, &particles](const auto& ia) {
-            const auto& [i, a] = ia;
-
-            /// @todo Once we have a proper geometry library, we should use
-            ///       here and clean up the code.
-            const auto& search_point = r[a];
-            const auto search_radius = RADIUS_SCALE * radius_func(a);
-            const auto point_on_boundary = Domain.clamp(search_point);
-            const auto interp_point = 2 * point_on_boundary - search_point;
-
-            // Search for the neighbors for the interpolation point and
-            // store the sorted results.
-            auto& search_results = interp_adjacency_buckets[i];
-            search_results.clear();
-            search_index.search( //
-                interp_point,
-                search_radius,
-                std::back_inserter(search_results),
-                [&particles](size_t b) {
-                  return particles.has_type(b, ParticleType::fluid);
-                });
-            std::ranges::sort(search_results);
+    // Search for the interpolation points for the fixed particles. Buffer
+    // particles of the open boundaries carry the fluid state, so they are
+    // used for the interpolation along with the fluid particles. Search radii
+    // are a few times larger than the kernel radius, and most of the
+    // candidates near the walls would be fixed particles, so a separate index
+    // is built over the fluid and buffer particles only. Probes are searched
+    // within the same index.
+    search_tasks.run([&particles, &radius_func, &boundary, this] {
+      const auto fixed_particles = particles.fixed();
+      const auto fixed_indices =
+          std::views::iota(size_t{0}, std::size(fixed_particles));
+      auto interp_adjacency = take_graph_(interp_adjacency_);
+      interp_adjacency.clear();
+      probe_adjacency_.clear();
+      if (fixed_indices.empty() && probe_points_.size() == 0) {
+        store_graph_(interp_adjacency_, std::move(interp_adjacency));
+        interp_cached_ = false;
+        return;
+      }
+
+      // Gather the positions of the fluid and buffer particles, and index
+      // them. Buffer particles follow the fixed ones, so their indices in the
+      // index are shifted by the number of the fixed particles.
+      const auto num_fluid = std::size(particles.fluid());
+      const auto num_fixed = std::size(fixed_particles);
+      std::vector<particle_vec_t<ParticleArray>> source_positions(
+          particles.size() - num_fixed);
+      par::for_each(
+          std::views::iota(size_t{0}, source_positions.size()),
+          [num_fluid, num_fixed, &source_positions, &particles](size_t k) {
+            const auto i = k < num_fluid ? k : k + num_fixed;
+            source_positions[k] = r[particles[i]];
           });
-      interp_adjacency_.assign_buckets_par(interp_adjacency_buckets);
+      const auto source_index = make_index_(source_positions, particles);
+
+      // Search for the neighbors of the interpolation points, and store the
+      // sorted results directly into the graph. Index order of the sources
+      // matches the particle order, so the rows stay sorted after the
+      // indices are mapped back.
+      const auto map_back = [num_fluid, num_fixed](Index& b) {
+        if (b >= num_fluid) b += static_cast<Index>(num_fixed);
+      };
+      if (!fixed_indices.empty()) {
+        const auto interp_points =
+            fixed_indices | std::views::transform([this](size_t i) {
+              return cached_vec_<PV>(fixed_proj_, i, 0);
+            });
+        const auto search_radii =
+            fixed_indices |
+            std::views::transform(
+                [fixed_particles, &radius_func, &boundary, this](size_t i) {
+                  return boundary.interp_radius_scale() *
+                             radius_func(fixed_particles[i]) +
+                         skin_;
+                });
+        source_index.search_batch(interp_points,
+                                  search_radii,
+                                  interp_adjacency,
+                                  AlwaysTrue{},
+                                  &search_scratch_);
+        par::for_each(interp_adjacency.vals(), map_back);
+      }
+      store_graph_(interp_adjacency_, std::move(interp_adjacency));
+      interp_cached_ = false;
+
+      // Search for the neighbors of the probe points. Probes have no width
+      // of their own, so the largest search radius of the fluid particles is
+      // used for all of them.
+      if (probe_points_.size() != 0 && num_fluid != 0) {
+        const auto probe_radius =
+            par::transform_reduce(
+                particles.fluid(),
+                real_t{0.0},
+                [](real_t x, real_t y) { return std::max(x, y); },
+                [&radius_func](PV a) {
+                  return static_cast<real_t>(radius_func(a));
+                }) +
+            skin_;
+        const auto probe_indices =
+            std::views::iota(size_t{0}, probe_points_.shape()[0]);
+        source_index.search_batch(
+            probe_indices | std::views::transform([this](size_t i) {
+              return cached_vec_<PV>(probe_points_, i, 0);
+            }),
+            probe_indices | std::views::transform([probe_radius](size_t) {
+              return probe_radius;
+            }),
+            probe_adjacency_,
+            AlwaysTrue{},
+            &search_scratch_);
+        par::for_each(probe_adjacency_.vals(), map_back);
+      }
     });
 
     search_tasks.wait();
   }
 
+  // Build the search index over the positions, respecting the periodic
+  // boundaries of the particle array.
+  template<class Positions, particle_array ParticleArray>
+  auto make_index_(const Positions& positions,
+                   const ParticleArray& particles) const {
+    const auto& periodic_box = particles.periodic_box();
+    if constexpr (std::same_as<SearchFunc, geom::GridSearch>) {
+      return search_func_(positions, periodic_box);
+    } else {
+      if (periodic_box.is_periodic()) {
+        TIT_THROW("Periodic boundaries are only supported by grid search.");
+      }
+      return search_func_(positions);
+    }
+  }
+
+  // Block pairs, that are iterated: the compacted ones, if they are filled
+  // for the current adjacency.
+  constexpr auto pair_edges_() const noexcept
+      -> const Multivector<std::pair<Index, Index>>& {
+    return is_compacted_ ? compacted_edges_ : block_edges_;
+  }
+
+  // Prefetch the data of the particles of the block pair, that lies the
+  // prefetch distance ahead of the given one. Near the end of the block,
+  // pairs of the next block are prefetched, which is harmless.
   template<particle_array ParticleArray>
-  void partition_(ParticleArray& particles, size_t num_levels = 2) {
+  void prefetch_ahead_(const ParticleArray& particles,
+                       const std::pair<Index, Index>* ab) const noexcept {
+    static_assert(!ImplicitBlocks);
+    if (prefetch_distance_ == 0) return;
+    const auto edges = pair_edges_().vals();
+    const auto i = static_cast<size_t>(ab - edges.data()) + prefetch_distance_;
+    if (i >= edges.size()) return;
+    const auto [a, b] = edges[i];
+    particles.prefetch(a);
+    particles.prefetch(b);
+  }
+
+  // Find the active fixed particles, those with at least one fluid or buffer
+  // neighbor. Without the pruning, all the fixed particles are active.
+  template<particle_array ParticleArray>
+  void find_active_fixed_(ParticleArray& particles) {
+    TIT_PROFILE_SECTION("ParticleMesh::find_active_fixed()");
+    const auto fixed_particles = particles.fixed();
+    const auto num_fixed = std::size(fixed_particles);
+    first_fixed_ = std::size(particles.fluid());
+    fixed_active_.clear();
+    if (prune_fixed_) {
+      fixed_active_.resize(num_fixed);
+      par::for_each(std::views::iota(size_t{0}, num_fixed), [this](size_t i) {
+        const auto a = first_fixed_ + i;
+        const auto is_fixed = [this](size_t b) {
+          return b - first_fixed_ < fixed_active_.size();
+        };
+        fixed_active_[i] = std::ranges::all_of(adjacency_[a], is_fixed) ? 0 : 1;
+      });
+    }
+    active_fixed_.clear();
+    for (size_t i = 0; i < num_fixed; ++i) {
+      if (fixed_active_.empty() || fixed_active_[i] != 0) {
+        active_fixed_.push_back(static_cast<Index>(first_fixed_ + i));
+      }
+    }
+  }
+
+  // Is the particle an inactive fixed one?
+  constexpr auto is_pruned_(size_t a) const noexcept -> bool {
+    // Note: indices below the first fixed particle wrap around.
+    const auto i = a - first_fixed_;
+    return i < fixed_active_.size() && fixed_active_[i] == 0;
+  }
+
+  // Search for the neighbors by sweeping over the adjacent grid cell pairs.
+  template<particle_array ParticleArray, class SearchRadiusFunc>
+  void cell_pairs_search_(ParticleArray& particles,
+                          const SearchRadiusFunc& radius_func,
+                          graph::BasicGraph<Index>& adjacency) {
+    TIT_PROFILE_SECTION("ParticleMesh::cell_pairs_search()");
+    using PV = ParticleView<ParticleArray>;
+    using Vec = particle_vec_t<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    using Grid = geom::Grid<Vec>;
+    using VecIndex = Grid::VecIndex;
+    const auto num_particles = particles.size();
+    if (num_particles == 0) {
+      adjacency.clear();
+      return;
+    }
+
+    // Bin the particles into the grid cells, which are not smaller than the
+    // largest search radius.
+    const auto search_radius = std::ranges::max(
+        particles.all() | std::views::transform([&radius_func, this](PV a) {
+          return static_cast<Num>(radius_func(a) + skin_);
+        }));
+    TIT_ASSERT(search_radius > 0.0, "Search radius must be positive.");
+    const auto positions = r[particles];
+    auto box = geom::compute_bbox(positions).grow(search_radius / 2);
+    const auto num_cells =
+        maximum(floor(box.extents() / search_radius), Vec(1));
+    const Grid grid{std::move(box), vec_cast<size_t>(num_cells)};
+    cell_points_.assign_pairs_par_tall(
+        grid.flat_num_cells(),
+        iota_perm(positions) |
+            std::views::transform([&grid, &positions](size_t a) {
+              return std::pair{grid.flat_cell_index(positions[a]),
+                               static_cast<Index>(a)};
+            }));
+
+    // Collect the unique pairs within the cells and with the adjacent cells,
+    // that have the larger flat index ("half stencil").
+    const auto num_threads = par::num_threads();
+    thread_pairs_.resize(num_threads);
+    for (auto& pairs : thread_pairs_) pairs.clear();
+    const auto search_dist = pow2(search_radius);
+    par::static_for_each(
+        grid.cells(),
+        [&grid, &positions, search_dist, this](size_t thread,
+                                               const VecIndex& cell) {
+          const auto flat_cell = grid.flatten_cell_index(cell);
+          const auto cell_points = cell_points_[flat_cell];
+          if (cell_points.empty()) return;
+          auto& pairs = thread_pairs_[thread];
+          const auto add_if_near = [&positions, &pairs, search_dist](
+                                       Index a,
+                                       Index b) {
+            if (norm2(positions[a] - positions[b]) < search_dist) {
+              pairs.emplace_back(a, b);
+            }
+          };
+          for (size_t i = 0; i < cell_points.size(); ++i) {
+            for (size_t j = 0; j < i; ++j) {
+              add_if_near(cell_points[i], cell_points[j]);
+            }
+          }
+          const auto low = cell - minimum(cell, VecIndex(1));
+          const auto high =
+              minimum(cell + VecIndex(1), grid.num_cells() - VecIndex(1));
+          for (const auto& other_cell : grid.cells_inclusive(low, high)) {
+            const auto flat_other_cell = grid.flatten_cell_index(other_cell);
+            if (flat_other_cell <= flat_cell) continue;
+            for (const auto b : cell_points_[flat_other_cell]) {
+              for (const auto a : cell_points) add_if_near(a, b);
+            }
+          }
+        });
+
+    // Assemble the adjacency graph from the pairs in both directions. Each
+    // particle is also adjacent to itself.
+    std::vector<size_t> thread_offsets(num_threads + 1, num_particles);
+    for (size_t thread = 0; thread < num_threads; ++thread) {
+      thread_offsets[thread + 1] =
+          thread_offsets[thread] + 2 * thread_pairs_[thread].size();
+    }
+    directed_pairs_.resize(thread_offsets.back());
+    par::for_each(std::views::iota(Index{0}, static_cast<Index>(num_particles)),
+                  [this](Index a) { directed_pairs_[a] = {a, a}; });
+    par::for_each(std::views::iota(size_t{0}, num_threads),
+                  [&thread_offsets, this](size_t thread) {
+                    auto offset = thread_offsets[thread];
+                    for (const auto& [a, b] : thread_pairs_[thread]) {
+                      directed_pairs_[offset++] = {a, b};
+                      directed_pairs_[offset++] = {b, a};
+                    }
+                  });
+    adjacency.assign_pairs_par_tall(num_particles, directed_pairs_);
+    par::for_each(adjacency.buckets(), std::ranges::sort);
+  }
+
+  // Uncompressed graph to be filled by the search. In the uncompressed mode,
+  // memory of the current graph is reused.
+  static auto take_graph_(Adjacency_& adjacency) -> graph::BasicGraph<Index> {
+    if constexpr (Compressed) return {};
+    else return std::move(adjacency);
+  }
+
+  // Store the graph that was filled by the search.
+  static void store_graph_(Adjacency_& adjacency,
+                           graph::BasicGraph<Index>&& graph) {
+    if constexpr (Compressed) adjacency.assign(graph);
+    else adjacency = std::move(graph);
+  }
+
+  template<particle_array ParticleArray>
+  void partition_(ParticleArray& particles, size_t num_threads) {
     TIT_PROFILE_SECTION("ParticleMesh::partition()");
-    TIT_ASSERT(num_levels < PartVec::MaxNumLevels,
-               "Number of levels exceeds the predefined maximum!");
 
     // Initialize the partitioning.
-    const auto num_threads = par::num_threads();
-    const auto num_parts = num_levels * num_threads + 1;
+    const auto num_levels = num_levels_;
+    const auto level_size = parts_per_thread_ * num_threads;
+    const auto num_parts = num_levels * level_size + 1;
     if (auto max_num_parts = std::numeric_limits<PartIndex>::max();
         num_parts >= max_num_parts) {
       TIT_THROW("Number of parts exceeded the limit of {}.", max_num_parts);
     }
     const auto parts = parinfo[particles];
-    std::ranges::fill(parts, PartVec(static_cast<PartIndex>(num_parts - 1)));
+    const auto last_part = static_cast<PartIndex>(num_parts - 1);
+
+    // Compute the particle weights.
+    if (weighted_partition_) {
+      weights_.resize(particles.size());
+      par::transform(adjacency_.bucket_sizes(),
+                     weights_.begin(),
+                     [](size_t num_neighbors) { return num_neighbors + 1; });
+    } else {
+      weights_.clear();
+    }
+
+    // In the incremental mode, keep the first level of the previous
+    // partitioning, if it is still applicable.
+    const auto is_incremental = incremental_partition_ &&
+                                part_sizes_.size() == level_size &&
+                                num_partitioned_ == particles.size();
+    if (is_incremental) {
+      par::for_each(parts, [last_part](PartVec& part) {
+        const auto first_part = part[0];
+        part = PartVec(last_part);
+        part[0] = first_part;
+      });
+    } else {
+      std::ranges::fill(parts, PartVec(last_part));
+    }
 
     // Build the multi-level partitioning.
     const auto positions = r[particles];
-    static std::vector<size_t> interface{};
     for (size_t level = 0; level < num_levels; ++level) {
       const auto is_first_level = level == 0;
       const auto is_last_level = level == (num_levels - 1);
@@ -220,66 +1535,346 @@ private:
           parts | std::views::transform(
                       [level](PartVec& part) -> auto& { return part[level]; });
       if (is_first_level) {
-        partition_func_(positions, level_parts, num_threads);
+        if (is_incremental) {
+          // Particle weights have changed since the last partitioning.
+          if (weighted_partition_) count_part_sizes_(level_size, level_parts);
+          rebalance_parts_(particles.size(), level_parts);
+        }
+        if (!is_incremental || is_imbalanced_()) {
+          if (weighted_partition_) {
+            partition_func_(positions, weights_, level_parts, level_size);
+          } else {
+            partition_func_(positions, level_parts, level_size);
+          }
+          count_part_sizes_(level_size, level_parts);
+        }
+      } else if (weighted_partition_) {
+        interface_partition_func_(permuted_view(positions, interface_),
+                                  permuted_view(weights_, interface_),
+                                  permuted_view(level_parts, interface_),
+                                  level_size,
+                                  /*init_part=*/level * level_size);
       } else {
-        interface_partition_func_(permuted_view(positions, interface),
-                                  permuted_view(level_parts, interface),
-                                  num_threads,
-                                  /*init_part=*/level * num_threads);
+        interface_partition_func_(permuted_view(positions, interface_),
+                                  permuted_view(level_parts, interface_),
+                                  level_size,
+                                  /*init_part=*/level * level_size);
       }
 
       // Update the interface particles.
       if (is_last_level) break;
       const auto is_interface = [level_parts, this](size_t a) {
         return std::ranges::any_of(
-            permuted_view(level_parts, adjacency_[a]),
+            neighbor_parts_(level_parts, a),
             std::bind_front(std::not_equal_to{}, level_parts[a]));
       };
       if (is_first_level) {
-        interface.resize(particles.size());
+        interface_.resize(particles.size());
         const auto all_particles = iota_perm(particles.all());
         const auto not_interface_iter =
-            par::copy_if(all_particles, interface.begin(), is_interface);
-        interface.erase(not_interface_iter, interface.end());
+            par::copy_if(all_particles, interface_.begin(), is_interface);
+        interface_.erase(not_interface_iter, interface_.end());
       } else {
-        // Note: `std::ranges::partition` is faster than `std::erase_if`
-        //       because it does not preserve the order of the elements.
-        /// @todo Parallelize this code.
-        const auto non_interface =
-            std::ranges::partition(interface, is_interface);
-        interface.erase(std::begin(non_interface), interface.end());
+        // Interface of the next level is a subset of the current one, so it
+        // is compacted in place, without a scratch buffer.
+        const auto not_interface_iter =
+            par::remove_if(interface_, std::not_fn(is_interface));
+        interface_.erase(not_interface_iter, interface_.end());
       }
     }
 
-    // Assemble the block adjacency graph.
-    block_edges_.assign_pairs_par_wide(
-        num_parts,
-        adjacency_.transform_edges([parts](const auto& ab) {
-          const auto [a, b] = ab;
-          const auto part_ab = PartVec::common(parts[a], parts[b]);
-          return std::pair{part_ab, ab};
-        }));
+    // Assemble the block adjacency graph, skipping the pairs with inactive
+    // fixed particles. With the implicit block pairs, only the particles of
+    // each block are stored. Particle belongs to the
+    // blocks of all the levels, up to and including the last one.
+    if constexpr (ImplicitBlocks) {
+      block_particles_.assign_pairs_par_wide(
+          num_parts,
+          iota_perm(particles.all()) |
+              std::views::transform([parts, last_part](size_t a) {
+                return std::views::iota(size_t{0}, PartVec::MaxNumLevels) |
+                       std::views::take_while(
+                           [part_a = parts[a], last_part](size_t l) {
+                             return l == 0 || part_a[l - 1] != last_part;
+                           }) |
+                       std::views::transform([part_a = parts[a], a](size_t l) {
+                         return std::pair{part_a[l], static_cast<Index>(a)};
+                       });
+              }) |
+              std::views::join);
+    } else {
+      block_edges_.assign_pairs_par_wide(
+          num_parts,
+          std::views::iota(size_t{0}, particles.size()) |
+              std::views::transform([parts, this](size_t b) {
+                return adjacency_[b] |
+                       std::views::take_while([b](size_t a) { return a < b; }) |
+                       std::views::filter([b, this](size_t a) {
+                         return !is_pruned_(a) && !is_pruned_(b);
+                       }) |
+                       std::views::transform([parts, b](size_t a) {
+                         const auto part_ab =
+                             PartVec::common(parts[a], parts[b]);
+                         return std::pair{part_ab,
+                                          std::pair{static_cast<Index>(a),
+                                                    static_cast<Index>(b)}};
+                       });
+              }) |
+              std::views::join);
+    }
+
+    // Assemble the block dependency graph. Particle of the block belongs to
+    // the blocks of all the preceding levels, up to the block itself. Blocks
+    // have only a few dependencies, so small sorted lists are used as sets.
+    block_deps_lists_.resize(num_parts);
+    if constexpr (ImplicitBlocks) implicit_block_sizes_.resize(num_parts);
+    par::for_each(std::views::iota(size_t{0}, num_parts),
+                  [parts, this](size_t q) {
+                    auto& deps = block_deps_lists_[q];
+                    deps.clear();
+                    size_t num_edges = 0;
+                    for (const auto& [a, b] : block_edges_of_(parts, q)) {
+                      num_edges += 1;
+                      for (const auto x : {a, b}) {
+                        const auto& part_x = parts[x];
+                        for (size_t l = 0; part_x[l] != q; ++l) {
+                          const size_t p = part_x[l];
+                          const auto iter = std::ranges::lower_bound(deps, p);
+                          if (iter == deps.end() || *iter != p) {
+                            deps.insert(iter, p);
+                          }
+                        }
+                      }
+                    }
+                    if constexpr (ImplicitBlocks) {
+                      implicit_block_sizes_[q] = num_edges;
+                    }
+                  });
+    block_deps_.assign_buckets_par(
+        std::span{block_deps_lists_.data(), num_parts});
+    level_size_ = level_size;
 
     // Report the block sizes.
-    TIT_STATS("ParticleMesh::block_edges_", block_edges_.bucket_sizes());
+    TIT_STATS("ParticleMesh::block_edges_", block_sizes_());
+
+    // Color the block pairs.
+    if constexpr (!ImplicitBlocks) {
+      if (pair_coloring_) {
+        edge_coloring_(particles.size(), block_edges_.vals(), pair_colors_);
+        TIT_STATS("ParticleMesh::pair_colors_", pair_colors_.bucket_sizes());
+      }
+    }
+
+    // Invalidate the kernel cache.
+    pair_kernel_.clear();
+  }
+
+  // Indices of the unique adjacent particle pairs of the block, that are
+  // found on the fly. Each pair is found in the row of its larger particle,
+  // which always belongs to the block of the pair.
+  template<class Parts>
+  auto implicit_block_edges_(Parts parts, size_t q) const {
+    static_assert(ImplicitBlocks);
+    return block_particles_[q] |
+           std::views::transform([parts, q, this](size_t a) {
+             return adjacency_[a] |
+                    std::views::take_while([a](size_t b) { return b < a; }) |
+                    std::views::filter([parts, q, a, this](size_t b) {
+                      return PartVec::common(parts[a], parts[b]) == q &&
+                             !is_pruned_(a) && !is_pruned_(b);
+                    }) |
+                    std::views::transform([a](size_t b) {
+                      return std::pair{b, a};
+                    });
+           }) |
+           std::views::join;
+  }
+
+  // Indices of the unique adjacent particle pairs of the block.
+  template<class Parts>
+  auto block_edges_of_(Parts parts, size_t q) const {
+    if constexpr (ImplicitBlocks) return implicit_block_edges_(parts, q);
+    else return block_edges_[q];
+  }
+
+  // Number of the pairs in each block.
+  auto block_sizes_() const noexcept {
+    if constexpr (ImplicitBlocks) return std::span{implicit_block_sizes_};
+    else return block_edges_.bucket_sizes();
+  }
+
+  // Parts of the particle neighbors.
+  template<class LevelParts>
+  auto neighbor_parts_(LevelParts level_parts, size_t a) const {
+    return adjacency_[a] | std::views::transform([level_parts](size_t b) {
+             return level_parts[b];
+           });
+  }
+
+  // Weight of the particle in the partitioning.
+  auto particle_weight_(size_t a) const noexcept -> size_t {
+    return weights_.empty() ? 1 : weights_[a];
+  }
+
+  // Total weight of the particles in each first level part.
+  auto total_part_size_() const noexcept -> size_t {
+    return std::ranges::fold_left(part_sizes_, 0UZ, std::plus{});
+  }
+
+  // Count the total weight of particles in each first level part.
+  template<class LevelParts>
+  void count_part_sizes_(size_t num_parts, LevelParts level_parts) {
+    part_sizes_.clear(), part_sizes_.resize(num_parts);
+    num_partitioned_ = std::size(level_parts);
+    par::for_each(std::views::iota(size_t{0}, num_partitioned_),
+                  [level_parts, this](size_t a) {
+                    const auto part = level_parts[a];
+                    TIT_ASSERT(part < part_sizes_.size(),
+                               "Part index is out of range!");
+                    par::fetch_and_add(part_sizes_[part], particle_weight_(a));
+                  });
+  }
+
+  // Check if the first level parts are too imbalanced.
+  auto is_imbalanced_() const -> bool {
+    const auto avg_size = static_cast<real_t>(total_part_size_()) /
+                          static_cast<real_t>(part_sizes_.size());
+    const auto max_size = static_cast<real_t>(std::ranges::max(part_sizes_));
+    return max_size > (1.0 + MaxPartImbalance) * avg_size;
+  }
+
+  // Rebalance the first level parts by moving the interface particles from
+  // the overloaded parts to the underloaded neighboring parts.
+  template<class LevelParts>
+  void rebalance_parts_(size_t num_particles, LevelParts level_parts) {
+    TIT_PROFILE_SECTION("ParticleMesh::rebalance_parts()");
+
+    // Collect the interface particles.
+    interface_.resize(num_particles);
+    const auto not_interface_iter = par::copy_if(
+        std::views::iota(size_t{0}, num_particles),
+        interface_.begin(),
+        [level_parts, this](size_t a) {
+          return std::ranges::any_of(
+              neighbor_parts_(level_parts, a),
+              std::bind_front(std::not_equal_to{}, level_parts[a]));
+        });
+    interface_.erase(not_interface_iter, interface_.end());
+
+    // Move the particles. Particles are moved only from the parts that are
+    // larger than average to the parts that are smaller than average, so that
+    // particles do not oscillate between the parts.
+    const auto avg_size = total_part_size_() / part_sizes_.size();
+    for (const auto a : interface_) {
+      const auto part_a = level_parts[a];
+      if (part_sizes_[part_a] <= avg_size) continue;
+      const auto part_b = std::ranges::min(
+          neighbor_parts_(level_parts, a),
+          std::less{},
+          [this](PartIndex part) { return part_sizes_[part]; });
+      if (part_sizes_[part_b] >= avg_size) continue;
+      level_parts[a] = part_b;
+      const auto weight = particle_weight_(a);
+      part_sizes_[part_a] -= weight, part_sizes_[part_b] += weight;
+    }
   }
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-  graph::Graph adjacency_;
-  graph::Graph interp_adjacency_;
-  Multivector<std::pair<size_t, size_t>> block_edges_;
+  Adjacency_ adjacency_;
+  Adjacency_ interp_adjacency_;
+  Multivector<Index> probe_adjacency_;
+  std::vector<size_t> interface_;
+  Multivector<std::pair<Index, Index>> block_edges_;
+  Multivector<std::pair<Index, Index>> compacted_edges_;
+  std::vector<uint8_t> pair_flags_;
+  bool pair_compaction_ = false;
+  bool is_compacted_ = false;
+  Multivector<Index> block_particles_;
+  std::vector<size_t> implicit_block_sizes_;
+  graph::Graph block_deps_;
+  std::vector<std::vector<size_t>> block_deps_lists_;
   [[no_unique_address]] SearchFunc search_func_;
+  par::ScratchArenas search_scratch_;
   [[no_unique_address]] PartitionFunc partition_func_;
   [[no_unique_address]] InterfacePartitionFunc interface_partition_func_;
+  real_t skin_;
+  size_t num_levels_;
+  size_t parts_per_thread_;
+  size_t level_size_ = 0;
+  size_t num_rebuilds_ = 0;
+  Mdvector<real_t, 2> positions_;
+  std::vector<real_t> radii_;
+  size_t generation_ = 0;
+  bool incremental_partition_ = false;
+  std::vector<size_t> part_sizes_;
+  size_t num_partitioned_ = 0;
+  bool weighted_partition_ = false;
+  std::vector<size_t> weights_;
+  bool kernel_cache_ = false;
+  Mdvector<real_t, 2> pair_kernel_;
+  Mdvector<real_t, 2> kernel_points_;
+  size_t kernel_generation_ = 0;
+  Mdvector<real_t, 2> fixed_proj_;
+  Mdvector<real_t, 2> probe_points_;
+  bool interp_cache_ = false;
+  bool interp_cached_ = false;
+  std::vector<uint8_t> interp_valid_;
+  Multivector<real_t> interp_weights_;
+  bool reorder_ = false;
+  std::vector<size_t> perm_;
+  bool cell_pairs_ = false;
+  Multivector<Index> cell_points_;
+  size_t prefetch_distance_ = 0;
+  bool pair_coloring_ = false;
+  graph::EdgeColoring edge_coloring_;
+  Multivector<size_t> pair_colors_;
+  bool prune_fixed_ = false;
+  size_t first_fixed_ = 0;
+  std::vector<uint8_t> fixed_active_;
+  std::vector<Index> active_fixed_;
+  std::vector<std::vector<std::pair<Index, Index>>> thread_pairs_;
+  std::vector<std::pair<Index, Index>> directed_pairs_;
+
+  // State of the background rebuild. Thread is declared last, so that it is
+  // joined before the rest of the state is destroyed.
+  struct AsyncRebuild_ final {
+    std::unique_ptr<ParticleMesh> mesh;
+    std::vector<PartVec> parts;
+    std::atomic<bool> done = false;
+    bool discard = false;
+    std::exception_ptr error;
+    std::jthread thread;
+  };
+
+  bool async_rebuild_ = false;
+  size_t async_threads_ = 0;
+  std::unique_ptr<AsyncRebuild_> async_;
 
 }; // class ParticleMesh
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace impl {
+template<class PM>
+inline constexpr bool is_particle_mesh_v = false;
+template<class SearchFunc,
+         class PartitionFunc,
+         class InterfacePartitionFunc,
+         class Index,
+         bool Compressed,
+         bool ImplicitBlocks>
+inline constexpr bool is_particle_mesh_v<ParticleMesh<SearchFunc,
+                                                      PartitionFunc,
+                                                      InterfacePartitionFunc,
+                                                      Index,
+                                                      Compressed,
+                                                      ImplicitBlocks>> = true;
+} // namespace impl
+
 /// Particle mesh type.
 template<class PM>
-concept particle_mesh = specialization_of<PM, ParticleMesh>;
+concept particle_mesh = impl::is_particle_mesh_v<PM>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
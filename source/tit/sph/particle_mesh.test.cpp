@@ -0,0 +1,322 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <array>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/mat.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/partition.hpp"
+#include "tit/geom/search.hpp"
+
+#include "tit/sph/boundary.hpp"
+#include "tit/sph/field.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+using sph::parinfo;
+using sph::r;
+
+using Vec2D = Vec<double, 2>;
+using Space2D = sph::Space<double, 2>;
+using ParticleArray2D =
+    sph::ParticleArray<Space2D, meta::Set<>, decltype(meta::Set{r, parinfo})>;
+
+template<bool Compressed>
+using ParticleMesh2D = sph::ParticleMesh<geom::GridSearch,
+                                         geom::RecursiveInertialBisection,
+                                         geom::RecursiveInertialBisection,
+                                         uint32_t,
+                                         Compressed>;
+
+// Indices of the particles in the range.
+constexpr auto indices = std::views::transform([](auto a) {
+  return a.index();
+});
+
+// Indices of the particles in the range of pairs.
+constexpr auto pair_indices = std::views::transform([](const auto& ab) {
+  return std::pair{ab.first.index(), ab.second.index()};
+});
+
+// Sorted indices of the particles in the range.
+constexpr auto sorted_indices = [](auto&& range) {
+  auto result = range | indices | std::ranges::to<std::vector>();
+  std::ranges::sort(result);
+  return result;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::ParticleMesh") {
+  // Block of fluid over a few layers of the fixed particles, that are placed
+  // below the bottom wall.
+  constexpr double dr = 0.1;
+  ParticleArray2D particles{Space2D{}, meta::Set<>{}};
+  for (size_t i = 0; i < 10; ++i) {
+    for (size_t j = 0; j < 14; ++j) {
+      const auto a = particles.append(j < 4 ? sph::ParticleType::fixed :
+                                              sph::ParticleType::fluid);
+      r[a] = dr * Vec2D{static_cast<double>(i) + 0.5,
+                        static_cast<double>(j) - 3.5};
+    }
+  }
+  const sph::DomainBoundary boundary{
+      geom::BBox{Vec2D{0.0, 0.0}, Vec2D{1.0, 2.0}},
+      /*rho_0=*/1000.0,
+      /*cs_0=*/10.0,
+      /*g=*/Vec2D{0.0, -10.0},
+  };
+  const auto radius_func = [](auto /*a*/) { return 2.5 * dr; };
+  SUBCASE("compressed") {
+    // Compressed mesh must decode exactly the same adjacency.
+    ParticleMesh2D<false> mesh{geom::GridSearch{2 * dr}};
+    ParticleMesh2D<true> compressed_mesh{geom::GridSearch{2 * dr}};
+    mesh.update(particles, radius_func, boundary);
+    compressed_mesh.update(particles, radius_func, boundary);
+    REQUIRE(mesh.num_pairs() > 0);
+    CHECK(compressed_mesh.num_pairs() == mesh.num_pairs());
+    for (const auto a : particles.all()) {
+      CHECK_RANGE_EQ(compressed_mesh[a] | indices, mesh[a] | indices);
+    }
+    for (const auto b : particles.fixed()) {
+      CHECK_RANGE_EQ(compressed_mesh.fixed_interp(b) | indices,
+                     mesh.fixed_interp(b) | indices);
+    }
+    CHECK_RANGE_EQ(compressed_mesh.pairs(particles) | pair_indices,
+                   mesh.pairs(particles) | pair_indices);
+  }
+  SUBCASE("kernel cache") {
+    // Kernel cache must stay filled until the particles move, or the mesh is
+    // rebuilt.
+    ParticleMesh2D<false> mesh{geom::GridSearch{2 * dr}};
+    mesh.set_kernel_cache(true);
+    mesh.update(particles, radius_func, boundary);
+    const auto kernel = sph::QuarticWendlandKernel{}.fixed_width<2>(dr);
+    REQUIRE_FALSE(mesh.has_cached_kernel(particles));
+    mesh.cache_kernel(particles, kernel);
+    CHECK(mesh.has_cached_kernel(particles));
+    const auto a = particles[0];
+    r[a] = r[a] + Vec2D{0.01 * dr, 0.0};
+    CHECK_FALSE(mesh.has_cached_kernel(particles));
+    mesh.cache_kernel(particles, kernel);
+    CHECK(mesh.has_cached_kernel(particles));
+    mesh.update(particles, radius_func, boundary);
+    CHECK_FALSE(mesh.has_cached_kernel(particles));
+  }
+  SUBCASE("rebuild") {
+    // Mesh with the skin must be rebuilt once the particles are replaced by
+    // the same number of the new ones, or their search radius grows.
+    ParticleMesh2D<false> mesh{geom::GridSearch{2 * dr},
+                               geom::RecursiveInertialBisection{},
+                               geom::RecursiveInertialBisection{},
+                               /*skin=*/dr};
+    mesh.update(particles, radius_func, boundary);
+    mesh.update(particles, radius_func, boundary);
+    REQUIRE(mesh.num_rebuilds() == 1);
+    const auto last = particles.size() - 1;
+    const auto last_r = r[particles[last]];
+    particles.remove_if([last](auto a) { return a.index() == last; });
+    r[particles.append(sph::ParticleType::fluid)] = last_r;
+    mesh.update(particles, radius_func, boundary);
+    CHECK(mesh.num_rebuilds() == 2);
+    const auto grown_radius_func = [](auto /*a*/) { return 4.0 * dr; };
+    mesh.update(particles, grown_radius_func, boundary);
+    CHECK(mesh.num_rebuilds() == 3);
+    const auto shrunk_radius_func = [](auto /*a*/) { return 2.5 * dr; };
+    mesh.update(particles, shrunk_radius_func, boundary);
+    CHECK(mesh.num_rebuilds() == 3);
+  }
+}
+
+TEST_CASE("sph::ParticleMesh::update") {
+  using Mat2D = Mat<double, 2>;
+  using BodyParticleArray2D = sph::ParticleArray<
+      Space2D,
+      meta::Set<>,
+      decltype(meta::Set{r, sph::m, sph::dv_dt, sph::body, parinfo})>;
+
+  // Square of fluid, with a single particle body in the middle. Particle is
+  // placed at the body origin, and is mirrored across the walls of a box
+  // next to it.
+  constexpr double dr = 0.1;
+  BodyParticleArray2D particles{Space2D{}, meta::Set<>{}};
+  for (size_t i = 0; i < 10; ++i) {
+    for (size_t j = 0; j < 10; ++j) {
+      const auto a = particles.append(sph::ParticleType::fluid);
+      r[a] = dr * Vec2D{static_cast<double>(i) + 0.5,
+                        static_cast<double>(j) + 0.5};
+    }
+  }
+  sph::RigidBodies<Vec2D> bodies;
+  const std::array local_positions{Vec2D{0.0, 0.0}};
+  const sph::BoxWalls local_walls{
+      geom::BBox{Vec2D{0.05, -0.05}, Vec2D{0.15, 0.05}}};
+  bodies.add(particles,
+             {.center = {0.5, 0.5}},
+             std::span{local_positions},
+             local_walls);
+  sph::DomainBoundary boundary{
+      geom::BBox{Vec2D{0.0, 0.0}, Vec2D{1.0, 1.0}},
+      /*rho_0=*/1000.0,
+      /*cs_0=*/10.0,
+      /*g=*/Vec2D{0.0, -10.0},
+      /*interp_radius_scale=*/1.0,
+  };
+  boundary.set_bodies(&bodies);
+
+  // Mesh with the skin is not rebuilt until something moves.
+  constexpr double radius = 2.5 * dr;
+  const auto radius_func = [](auto /*a*/) { return radius; };
+  ParticleMesh2D<false> mesh{geom::GridSearch{2 * dr},
+                             geom::RecursiveInertialBisection{},
+                             geom::RecursiveInertialBisection{},
+                             /*skin=*/dr};
+  mesh.update(particles, radius_func, boundary);
+  mesh.update(particles, radius_func, boundary);
+  REQUIRE(mesh.num_rebuilds() == 1);
+
+  // Body rotates a quarter turn around its particle. The particle stays in
+  // place, but its mirror image moves, so the mesh must be rebuilt, and the
+  // interpolation adjacency must cover the new mirror image.
+  bodies.state(0).spin = Mat2D{{0.0, -2.0}, {2.0, 0.0}};
+  bodies.update(1.0, particles);
+  mesh.update(particles, radius_func, boundary);
+  CHECK(mesh.num_rebuilds() == 2);
+  const auto b = *particles.fixed().begin();
+  const auto mirror = boundary.project(b).mirror;
+  const auto interp = mesh.fixed_interp(b) | indices |
+                      std::ranges::to<std::vector>();
+  for (const auto a : particles.fluid()) {
+    if (norm(r[a] - mirror) < radius) {
+      CHECK(std::ranges::contains(interp, a.index()));
+    }
+  }
+}
+
+TEST_CASE("sph::ParticleMesh::set_async_rebuild") {
+  // Block of fluid over a few layers of the fixed particles, that are placed
+  // below the bottom wall.
+  constexpr double dr = 0.1;
+  constexpr double skin = dr;
+  ParticleArray2D particles{Space2D{}, meta::Set<>{}};
+  for (size_t i = 0; i < 10; ++i) {
+    for (size_t j = 0; j < 14; ++j) {
+      const auto a = particles.append(j < 4 ? sph::ParticleType::fixed :
+                                              sph::ParticleType::fluid);
+      r[a] = dr * Vec2D{static_cast<double>(i) + 0.5,
+                        static_cast<double>(j) - 3.5};
+    }
+  }
+  const sph::DomainBoundary boundary{
+      geom::BBox{Vec2D{0.0, 0.0}, Vec2D{1.0, 2.0}},
+      /*rho_0=*/1000.0,
+      /*cs_0=*/10.0,
+      /*g=*/Vec2D{0.0, -10.0},
+  };
+  const auto radius_func = [](auto /*a*/) { return 2.5 * dr; };
+  const auto make_mesh = [] {
+    return ParticleMesh2D<false>{geom::GridSearch{2 * dr},
+                                 geom::RecursiveInertialBisection{},
+                                 geom::RecursiveInertialBisection{},
+                                 skin};
+  };
+  const auto move = [&particles](double distance) {
+    for (const auto a : particles.all()) r[a] = r[a] + Vec2D{distance, 0.0};
+  };
+
+  // Adjacency must be the same as the one of the synchronous rebuild.
+  using Mesh = ParticleMesh2D<false>;
+  const auto check_adjacency = [&particles,
+                                 &radius_func,
+                                 &boundary,
+                                 &make_mesh](const Mesh& mesh) {
+    auto reference_mesh = make_mesh();
+    reference_mesh.update(particles, radius_func, boundary);
+    for (const auto a : particles.all()) {
+      CHECK(sorted_indices(mesh[a]) == sorted_indices(reference_mesh[a]));
+    }
+    for (const auto b : particles.fixed()) {
+      CHECK(sorted_indices(mesh.fixed_interp(b)) ==
+            sorted_indices(reference_mesh.fixed_interp(b)));
+    }
+  };
+
+  // Mesh is built synchronously first, and the background rebuild starts
+  // once the particles have moved further than a quarter of the skin.
+  auto mesh = make_mesh();
+  mesh.set_async_rebuild(true, /*num_threads=*/1);
+  mesh.update(particles, radius_func, boundary);
+  REQUIRE(mesh.num_rebuilds() == 1);
+  move(0.3 * skin);
+  SUBCASE("swap") {
+    // Current mesh stays valid, so it is kept until the background rebuild
+    // is finished, and is replaced by it afterwards.
+    mesh.update(particles, radius_func, boundary);
+    while (mesh.num_rebuilds() < 2) {
+      std::this_thread::yield();
+      mesh.update(particles, radius_func, boundary);
+    }
+    CHECK(mesh.num_rebuilds() == 2);
+    check_adjacency(mesh);
+  }
+  SUBCASE("invalidate") {
+    // Particle is replaced while the background rebuild is running, so its
+    // result is discarded, and the mesh is rebuilt synchronously, only once.
+    mesh.update(particles, radius_func, boundary);
+    const auto last = particles.size() - 1;
+    const auto last_r = r[particles[last]];
+    particles.remove_if([last](auto a) { return a.index() == last; });
+    r[particles.append(sph::ParticleType::fluid)] = last_r;
+    mesh.invalidate();
+    mesh.update(particles, radius_func, boundary);
+    CHECK(mesh.num_rebuilds() == 2);
+    check_adjacency(mesh);
+  }
+  SUBCASE("failure") {
+    // Search radius fails in its copy, that is only made by the background
+    // rebuild, and the error is rethrown once the current mesh is invalid.
+    struct FailingRadiusFunc final {
+      bool is_copy = false;
+      FailingRadiusFunc() = default;
+      FailingRadiusFunc(const FailingRadiusFunc& /*other*/) : is_copy{true} {}
+      auto operator=(const FailingRadiusFunc&) -> FailingRadiusFunc& = delete;
+      ~FailingRadiusFunc() = default;
+      auto operator()(auto /*a*/) const -> double {
+        if (is_copy) TIT_THROW("Background rebuild has failed!");
+        return 2.5 * dr;
+      }
+    };
+    const FailingRadiusFunc failing_radius_func{};
+    mesh.update(particles, failing_radius_func, boundary);
+    move(0.3 * skin);
+    CHECK_THROWS_MSG(mesh.update(particles, failing_radius_func, boundary),
+                     Exception,
+                     "Background rebuild has failed!");
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,255 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <cmath>
+#include <concepts>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/search.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Adaptive particle refinement (Vacondio et al., 2016).
+///
+/// Fluid particles in the regions of interest are split into `2^Dim`
+/// daughters, placed at the corners of a cube around the parent. Pairs of the
+/// fluid particles in the bulk are merged into a single particle. Both the
+/// operations conserve the mass and the momentum. Smoothing lengths of the
+/// particles become non-uniform, which the particle mesh handles through the
+/// per-particle search radius.
+///
+/// Both the operations add or remove particles, so the particle mesh must be
+/// invalidated and updated after them.
+class ParticleRefinement final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{r, m, h};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{r, m, h};
+
+  /// Construct the particle refinement.
+  ///
+  /// @param separation      Distance between the daughter particles, relative
+  ///                        to the smoothing length of the parent.
+  /// @param smoothing_ratio Smoothing length of the daughter particles,
+  ///                        relative to the one of the parent.
+  /// @param merge_radius    Maximum distance between the merged particles,
+  ///                        relative to their smoothing length.
+  constexpr explicit ParticleRefinement(real_t separation = 0.4,
+                                        real_t smoothing_ratio = 0.6,
+                                        real_t merge_radius = 1.0) noexcept
+      : separation_{separation}, smoothing_ratio_{smoothing_ratio},
+        merge_radius_{merge_radius} {
+    TIT_ASSERT(separation_ > 0.0, "Separation must be positive!");
+    TIT_ASSERT(smoothing_ratio_ > 0.0, "Smoothing ratio must be positive!");
+    TIT_ASSERT(merge_radius_ > 0.0, "Merge radius must be positive!");
+  }
+
+  /// Distance between the daughter particles, relative to the smoothing
+  /// length of the parent.
+  constexpr auto separation() const noexcept -> real_t {
+    return separation_;
+  }
+
+  /// Smoothing length of the daughter particles, relative to the one of the
+  /// parent.
+  constexpr auto smoothing_ratio() const noexcept -> real_t {
+    return smoothing_ratio_;
+  }
+
+  /// Maximum distance between the merged particles, relative to their
+  /// smoothing length.
+  constexpr auto merge_radius() const noexcept -> real_t {
+    return merge_radius_;
+  }
+
+  /// Split the fluid particles that satisfy the predicate @p pred.
+  ///
+  /// Each parent particle is replaced with the first of its daughters, the
+  /// rest are appended to the fluid particles. Daughters inherit all the
+  /// fields of the parent, except for the position, mass and smoothing
+  /// length.
+  ///
+  /// @returns Number of the split particles.
+  template<particle_array<r, m, h> ParticleArray,
+           std::predicate<ParticleView<ParticleArray>> Pred>
+  auto split(ParticleArray& particles, const Pred& pred) const -> size_t {
+    TIT_PROFILE_SECTION("ParticleRefinement::split()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    using Vec = particle_vec_t<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    static constexpr size_t NumDaughters = size_t{1} << Dim;
+    static_assert(ParticleArray::varying_fields.includes(meta::Set{r, m, h}),
+                  "Positions, masses and widths must be varying!");
+
+    // Select the parent particles.
+    const auto parents = select_(particles, pred);
+    if (parents.empty()) return 0;
+
+    // Append the rest of the daughters. New particles follow the existing
+    // fluid particles, so the parent indices stay valid.
+    std::vector<size_t> sources;
+    sources.reserve(parents.size() * (NumDaughters - 1));
+    for (const auto i : parents) {
+      sources.insert(sources.end(), NumDaughters - 1, i);
+    }
+    const auto first = std::ranges::size(particles.fluid());
+    particles.append_copies(ParticleType::fluid, sources);
+
+    // Place the daughters at the corners of a cube around the parent.
+    par::for_each(
+        std::views::iota(size_t{0}, parents.size()),
+        [&particles, &parents, first, this](size_t k) {
+          const auto a = particles[parents[k]];
+          const Vec r_a = r[a];
+          const auto m_d = m[a] / static_cast<Num>(NumDaughters);
+          const auto h_d = static_cast<Num>(smoothing_ratio_) * h[a];
+          const auto offset = static_cast<Num>(separation_ / 2) * h[a];
+          for (size_t j = 0; j < NumDaughters; ++j) {
+            const PV d = j == 0 ?
+                             a :
+                             particles[first + k * (NumDaughters - 1) + j - 1];
+            Vec r_d = r_a;
+            for (size_t i = 0; i < Dim; ++i) {
+              r_d[i] += ((j >> i) & 1) != 0 ? offset : -offset;
+            }
+            r[d] = r_d, m[d] = m_d, h[d] = h_d;
+          }
+        });
+
+    return parents.size();
+  }
+
+  /// Merge the pairs of the fluid particles that satisfy the predicate
+  /// @p pred.
+  ///
+  /// Particles are merged with their nearest candidates within the merge
+  /// radius, only if they are mutually the nearest to each other, so that
+  /// the pairs are disjoint and independent of the processing order. The
+  /// merged particle is placed at the center of mass of the pair, and has
+  /// the smoothing length that preserves the total kernel volume `h^Dim`.
+  /// Other fields are kept from the lower-indexed particle of the pair.
+  ///
+  /// @returns Number of the merged pairs.
+  template<particle_array<r, m, h> ParticleArray,
+           std::predicate<ParticleView<ParticleArray>> Pred>
+  auto merge(ParticleArray& particles, const Pred& pred) const -> size_t {
+    TIT_PROFILE_SECTION("ParticleRefinement::merge()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<ParticleArray>;
+    using Vec = particle_vec_t<ParticleArray>;
+    static constexpr auto Dim = particle_dim_v<ParticleArray>;
+    static constexpr auto npos = std::numeric_limits<size_t>::max();
+    static_assert(ParticleArray::varying_fields.includes(meta::Set{r, m, h}),
+                  "Positions, masses and widths must be varying!");
+
+    // Select the candidate particles.
+    const auto candidates = select_(particles, pred);
+    if (candidates.size() < 2) return 0;
+    const auto positions =
+        candidates |
+        std::views::transform([&particles](size_t i) -> Vec {
+          return r[particles[i]];
+        }) |
+        std::ranges::to<std::vector>();
+    const auto max_radius = static_cast<Num>(merge_radius_) *
+                            std::ranges::max(candidates |
+                                             std::views::transform(
+                                                 [&particles](size_t i) {
+                                                   return h[particles[i]];
+                                                 }));
+    const auto search_index = geom::GridSearch{max_radius}(positions);
+
+    // Find the nearest candidate of each candidate. Ties are broken by the
+    // index, so that the mutual nearest pairs are well-defined.
+    std::vector<size_t> nearest(candidates.size(), npos);
+    par::for_each(
+        std::views::iota(size_t{0}, candidates.size()),
+        [&particles, &candidates, &positions, &search_index, &nearest, this](
+            size_t i) {
+          const auto search_radius =
+              static_cast<Num>(merge_radius_) * h[particles[candidates[i]]];
+          std::vector<size_t> found;
+          search_index.search(positions[i],
+                              search_radius,
+                              std::back_inserter(found));
+          auto best_dist = std::numeric_limits<Num>::max();
+          for (const auto j : found) {
+            if (j == i) continue;
+            const auto dist = norm2(positions[j] - positions[i]);
+            if (dist < best_dist || (dist == best_dist && j < nearest[i])) {
+              nearest[i] = j, best_dist = dist;
+            }
+          }
+        });
+
+    // Merge the mutually nearest pairs into the lower-indexed particles.
+    std::vector<uint8_t> removed(particles.size(), 0);
+    par::for_each(
+        std::views::iota(size_t{0}, candidates.size()),
+        [&particles, &candidates, &nearest, &removed](size_t i) {
+          const auto j = nearest[i];
+          if (j == npos || j < i || nearest[j] != i) return;
+          const auto a = particles[candidates[i]];
+          const auto b = particles[candidates[j]];
+          const auto m_ab = m[a] + m[b];
+          r[a] = (m[a] * r[a] + m[b] * r[b]) / m_ab;
+          if constexpr (has<PV>(v)) v[a] = (m[a] * v[a] + m[b] * v[b]) / m_ab;
+          h[a] = std::pow(pow<Dim>(h[a]) + pow<Dim>(h[b]), Num{1} / Dim);
+          m[a] = m_ab;
+          removed[b.index()] = 1;
+        });
+    return particles.remove_if(
+        [&removed](PV a) { return removed[a.index()] != 0; });
+  }
+
+private:
+
+  // Indices of the fluid particles that satisfy the predicate.
+  template<class ParticleArray, class Pred>
+  static auto select_(ParticleArray& particles, const Pred& pred)
+      -> std::vector<size_t> {
+    using PV = ParticleView<ParticleArray>;
+    std::vector<uint8_t> selected(particles.size(), 0);
+    par::for_each(particles.fluid(), [&selected, &pred](PV a) {
+      selected[a.index()] = pred(a) ? 1 : 0;
+    });
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < selected.size(); ++i) {
+      if (selected[i] != 0) indices.push_back(i);
+    }
+    return indices;
+  }
+
+  real_t separation_;
+  real_t smoothing_ratio_;
+  real_t merge_radius_;
+
+}; // class ParticleRefinement
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,118 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <cmath>
+#include <ranges>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_refinement.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+using sph::h;
+using sph::m;
+using sph::r;
+using sph::v;
+
+using Vec2D = Vec<double, 2>;
+using Space2D = sph::Space<double, 2>;
+using ParticleArray2D = sph::ParticleArray<Space2D,
+                                           meta::Set<>,
+                                           decltype(meta::Set{r, v, m, h})>;
+using PV = sph::ParticleView<ParticleArray2D>;
+
+// Append the particle of the specified type.
+void append(ParticleArray2D& particles,
+            sph::ParticleType type,
+            const Vec2D& position,
+            const Vec2D& velocity,
+            double mass) {
+  const auto a = particles.append(type);
+  r[a] = position, v[a] = velocity, m[a] = mass, h[a] = 1.0;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::ParticleRefinement") {
+  const sph::ParticleRefinement refinement{};
+  ParticleArray2D particles{Space2D{}, meta::Set<>{}};
+  SUBCASE("split") {
+    append(particles, sph::ParticleType::fluid, {1.0, 1.0}, {1.0, 0.0}, 4.0);
+    append(particles, sph::ParticleType::fluid, {5.0, 5.0}, {0.0, 0.0}, 4.0);
+    append(particles, sph::ParticleType::fixed, {9.0, 9.0}, {0.0, 0.0}, 4.0);
+    const auto num_split =
+        refinement.split(particles, [](PV a) { return r[a][0] < 2.0; });
+    CHECK(num_split == 1);
+    REQUIRE(particles.size() == 6);
+    REQUIRE(std::ranges::size(particles.fluid()) == 5);
+    // Parent is replaced with the first daughter, the rest follow the fluid
+    // particles.
+    CHECK_APPROX_EQ(r[particles[0]], Vec2D{0.8, 0.8});
+    CHECK_APPROX_EQ(r[particles[2]], Vec2D{1.2, 0.8});
+    CHECK_APPROX_EQ(r[particles[3]], Vec2D{0.8, 1.2});
+    CHECK_APPROX_EQ(r[particles[4]], Vec2D{1.2, 1.2});
+    for (const auto i : {0UZ, 2UZ, 3UZ, 4UZ}) {
+      CHECK(m[particles[i]] == 1.0);
+      CHECK_APPROX_EQ(h[particles[i]], 0.6);
+      CHECK(v[particles[i]] == Vec2D{1.0, 0.0});
+    }
+    // Other particles are not changed.
+    CHECK(r[particles[1]] == Vec2D{5.0, 5.0});
+    CHECK(m[particles[1]] == 4.0);
+    CHECK(particles.has_type(5, sph::ParticleType::fixed));
+    CHECK(r[particles[5]] == Vec2D{9.0, 9.0});
+  }
+  SUBCASE("merge") {
+    append(particles, sph::ParticleType::fluid, {0.0, 0.0}, {4.0, 0.0}, 1.0);
+    append(particles, sph::ParticleType::fluid, {0.5, 0.0}, {0.0, 0.0}, 3.0);
+    append(particles, sph::ParticleType::fluid, {9.0, 9.0}, {0.0, 0.0}, 1.0);
+    append(particles, sph::ParticleType::fixed, {0.2, 0.0}, {0.0, 0.0}, 1.0);
+    const auto num_merged =
+        refinement.merge(particles, [](PV /*a*/) { return true; });
+    CHECK(num_merged == 1);
+    REQUIRE(particles.size() == 3);
+    REQUIRE(std::ranges::size(particles.fluid()) == 2);
+    // Mass and momentum are conserved.
+    CHECK_APPROX_EQ(r[particles[0]], Vec2D{0.375, 0.0});
+    CHECK_APPROX_EQ(v[particles[0]], Vec2D{1.0, 0.0});
+    CHECK(m[particles[0]] == 4.0);
+    CHECK_APPROX_EQ(h[particles[0]], std::sqrt(2.0));
+    // Particle without the neighbors and the fixed particle are kept.
+    CHECK(r[particles[1]] == Vec2D{9.0, 9.0});
+    CHECK(particles.has_type(2, sph::ParticleType::fixed));
+  }
+  SUBCASE("split and merge") {
+    append(particles, sph::ParticleType::fluid, {1.0, 1.0}, {1.0, 2.0}, 4.0);
+    refinement.split(particles, [](PV /*a*/) { return true; });
+    REQUIRE(particles.size() == 4);
+    // Each daughter has two nearest neighbors, ties are broken by the index,
+    // so only one pair is mutually nearest.
+    CHECK(refinement.merge(particles, [](PV /*a*/) { return true; }) == 1);
+    REQUIRE(particles.size() == 3);
+    double total_mass = 0.0;
+    Vec2D total_momentum{};
+    for (const auto a : particles.all()) {
+      total_mass += m[a];
+      total_momentum += m[a] * v[a];
+    }
+    CHECK(total_mass == 4.0);
+    CHECK_APPROX_EQ(total_momentum, Vec2D{4.0, 8.0});
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
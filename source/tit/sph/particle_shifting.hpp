@@ -0,0 +1,107 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <concepts>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/meta.hpp"
+
+#include "tit/sph/field.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// No particle shifting.
+class NoParticleShifting final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{/*empty*/};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{/*empty*/};
+
+}; // class NoParticleShifting
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Particle shifting technique with the free surface detection
+/// (Sun et al., 2017).
+///
+/// Normal vectors are computed together with the density, particles are then
+/// classified into the ones on, near and far from the free surface, and the
+/// shifts are damped accordingly.
+class ParticleShifting final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{dr, N, FS};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{dr, N, FS};
+
+  /// Construct the particle shifting.
+  ///
+  /// @param R              Tensile instability control coefficient.
+  /// @param Ma             Reference Mach number of the flow.
+  /// @param CFL            Courant number of the time step.
+  /// @param detection_freq Free surface detection frequency, in steps.
+  ///                       Free surface moves by a fraction of the particle
+  ///                       spacing per step, so it could be detected less
+  ///                       often than every step.
+  constexpr explicit ParticleShifting(real_t R = 0.2,
+                                      real_t Ma = 0.1,
+                                      real_t CFL = 0.8,
+                                      size_t detection_freq = 1) noexcept
+      : R_{R}, Ma_{Ma}, CFL_{CFL}, detection_freq_{detection_freq} {
+    TIT_ASSERT(R_ >= 0.0, "Tensile coefficient must be non-negative!");
+    TIT_ASSERT(Ma_ > 0.0, "Mach number must be positive!");
+    TIT_ASSERT(CFL_ > 0.0, "Courant number must be positive!");
+    TIT_ASSERT(detection_freq_ > 0, "Detection frequency must be positive!");
+  }
+
+  /// Tensile instability control coefficient.
+  constexpr auto R() const noexcept -> real_t {
+    return R_;
+  }
+
+  /// Reference Mach number of the flow.
+  constexpr auto Ma() const noexcept -> real_t {
+    return Ma_;
+  }
+
+  /// Courant number of the time step.
+  constexpr auto CFL() const noexcept -> real_t {
+    return CFL_;
+  }
+
+  /// Free surface detection frequency, in steps.
+  constexpr auto detection_freq() const noexcept -> size_t {
+    return detection_freq_;
+  }
+
+private:
+
+  real_t R_;
+  real_t Ma_;
+  real_t CFL_;
+  size_t detection_freq_;
+
+}; // class ParticleShifting
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Particle shifting type.
+template<class PS>
+concept particle_shifting = std::same_as<PS, NoParticleShifting> || //
+                            std::same_as<PS, ParticleShifting>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,168 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// No particle sleeping.
+class NoParticleSleeping final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{/*empty*/};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{/*empty*/};
+
+  /// Is the particle asleep?
+  template<particle_view PV>
+  static constexpr auto is_asleep(PV /*a*/) noexcept -> bool {
+    return false;
+  }
+
+  /// Update the sleeping states.
+  template<particle_mesh ParticleMesh, particle_array ParticleArray>
+  static constexpr void update(ParticleMesh& /*mesh*/,
+                               ParticleArray& /*particles*/) noexcept {}
+
+}; // class NoParticleSleeping
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Deactivation of the fluid particles in the quiescent regions.
+///
+/// Fluid particles, which velocity and acceleration stay below the thresholds
+/// for a number of consecutive steps, fall asleep: they are stopped, and the
+/// time integrator skips them, while they still act as the neighbors of the
+/// awake particles. Sleeping particle is woken up as soon as an awake
+/// neighbor, that moves faster than the velocity threshold, approaches it.
+///
+/// Number of the consecutive quiet steps is stored in a particle field, so
+/// that it is preserved when the particles are reordered.
+class ParticleSleeping final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{r, v, dv_dt, quiet};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{v, dv_dt, quiet};
+
+  /// Construct the particle sleeping.
+  ///
+  /// @param max_velocity     Velocity threshold.
+  /// @param max_acceleration Acceleration threshold.
+  /// @param num_quiet_steps  Number of the consecutive quiet steps, after
+  ///                         which the particle falls asleep.
+  constexpr explicit ParticleSleeping(real_t max_velocity,
+                                      real_t max_acceleration,
+                                      size_t num_quiet_steps = 10) noexcept
+      : max_velocity_{max_velocity}, max_acceleration_{max_acceleration},
+        num_quiet_steps_{num_quiet_steps} {
+    TIT_ASSERT(max_velocity_ > 0.0, "Velocity threshold must be positive!");
+    TIT_ASSERT(max_acceleration_ > 0.0,
+               "Acceleration threshold must be positive!");
+    TIT_ASSERT(num_quiet_steps_ > 0,
+               "Number of the quiet steps must be positive!");
+  }
+
+  /// Velocity threshold.
+  constexpr auto max_velocity() const noexcept -> real_t {
+    return max_velocity_;
+  }
+
+  /// Acceleration threshold.
+  constexpr auto max_acceleration() const noexcept -> real_t {
+    return max_acceleration_;
+  }
+
+  /// Number of the consecutive quiet steps, after which the particle falls
+  /// asleep.
+  constexpr auto num_quiet_steps() const noexcept -> size_t {
+    return num_quiet_steps_;
+  }
+
+  /// Is the particle asleep?
+  template<particle_view<quiet> PV>
+  constexpr auto is_asleep(PV a) const noexcept -> bool {
+    return quiet[a] >= num_quiet_steps_;
+  }
+
+  /// Update the sleeping states after a step in time. Accelerations of the
+  /// awake particles must be computed for the step.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void update(ParticleMesh& mesh, ParticleArray& particles) {
+    TIT_PROFILE_SECTION("ParticleSleeping::update()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<PV>;
+
+    // Compute the new states first, since the wake up condition reads the
+    // states of the neighbors.
+    const auto max_velocity2 = pow2(static_cast<Num>(max_velocity_));
+    const auto max_acceleration2 = pow2(static_cast<Num>(max_acceleration_));
+    const auto is_moving = [max_velocity2, this](PV b) {
+      return b.is_fluid() && !is_asleep(b) && norm2(v[b]) >= max_velocity2;
+    };
+    new_quiet_.resize(particles.size());
+    par::for_each(
+        particles.fluid(),
+        [max_velocity2, max_acceleration2, &is_moving, &mesh, this](PV a) {
+          auto& new_quiet = new_quiet_[a.index()];
+          new_quiet = quiet[a];
+          if (is_asleep(a)) {
+            const auto approaches = [a, &is_moving](PV b) {
+              return is_moving(b) && dot(v[b], r[a, b]) > 0;
+            };
+            if (std::ranges::any_of(mesh[a], approaches)) new_quiet = 0;
+          } else if (norm2(v[a]) < max_velocity2 &&
+                     norm2(dv_dt[a]) < max_acceleration2) {
+            new_quiet += 1;
+          } else {
+            new_quiet = 0;
+          }
+        });
+
+    // Apply the new states. Accelerations of the sleeping particles are not
+    // computed, so they are reset along with the velocities.
+    par::for_each(particles.fluid(), [this](PV a) {
+      quiet[a] = new_quiet_[a.index()];
+      if (is_asleep(a)) {
+        v[a] = {};
+        dv_dt[a] = {};
+      }
+    });
+  }
+
+private:
+
+  real_t max_velocity_;
+  real_t max_acceleration_;
+  size_t num_quiet_steps_;
+  std::vector<uint32_t> new_quiet_;
+
+}; // class ParticleSleeping
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,112 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <array>
+#include <future>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/profiler.hpp"
+
+#include "tit/data/events.hpp"
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Asynchronous particle array writer.
+///
+/// Particle array is copied into a staging buffer, and the copy is written
+/// into the data series by a background thread, so that the caller could
+/// continue stepping while the output is being compressed and stored. Two
+/// staging buffers are used in turns, so the snapshot can be taken while the
+/// previous one is still being written, and the buffers are reused between
+/// the writes to avoid the allocations.
+///
+/// After each write, the summary of the new time step is published to the
+/// storage event channel, so that the live monitoring tools could pick it up,
+/// and a part of the retired series is purged from the storage.
+///
+/// @note Storage must not be accessed by the caller until the pending write
+///       is finished, see `wait()`. The write holds the storage lock, see
+///       `DataStorage::lock()`, so the writers of the other data series of
+///       the same storage may run concurrently.
+template<particle_array ParticleArray>
+class ParticleWriter final {
+public:
+
+  /// Construct a particle writer for the data series. If @p num_levels is
+  /// positive, the decimated levels are written along with each time step.
+  /// Fields listed in @p precisions are written in the given precision, see
+  /// `ParticleArray::write`.
+  explicit ParticleWriter(data::DataSeriesView<data::DataStorage> series,
+                          size_t num_levels = 0,
+                          std::vector<FieldPrecision> precisions = {})
+      : series_{series}, publisher_{series.storage().path()},
+        num_levels_{num_levels}, precisions_{std::move(precisions)} {}
+
+  /// Particle writer is not copyable.
+  ParticleWriter(const ParticleWriter&) = delete;
+  auto operator=(const ParticleWriter&) -> ParticleWriter& = delete;
+
+  /// Particle writer is not movable, since the pending write refers to it.
+  ParticleWriter(ParticleWriter&&) = delete;
+  auto operator=(ParticleWriter&&) -> ParticleWriter& = delete;
+
+  /// Wait for the pending write to finish.
+  ~ParticleWriter() {
+    if (pending_.valid()) pending_.wait();
+  }
+
+  /// Write the particle array into the data series asynchronously.
+  ///
+  /// Blocks only if the previous write is not finished yet.
+  void write(real_t time, const ParticleArray& particles) {
+    TIT_PROFILE_SECTION("ParticleWriter::write()");
+    auto& staging = buffers_[next_buffer_];
+    if (staging.has_value()) *staging = particles;
+    else staging.emplace(particles);
+    wait();
+    pending_ = std::async(std::launch::async, [time, &staging, this] {
+      const auto lock = series_.storage().lock();
+      staging->write(time, series_, num_levels_, precisions_);
+      const auto time_step = series_.last_time_step();
+      series_.storage().purge_retired();
+      publisher_.publish({.series_id = series_.id(),
+                          .time_step_id = time_step.id(),
+                          .time = time,
+                          .num_particles = staging->size()});
+    });
+    next_buffer_ = 1 - next_buffer_;
+  }
+
+  /// Wait for the pending write to finish. Exceptions thrown while writing
+  /// are rethrown here.
+  void wait() {
+    if (pending_.valid()) pending_.get();
+  }
+
+private:
+
+  data::DataSeriesView<data::DataStorage> series_;
+  data::DataEventPublisher publisher_;
+  size_t num_levels_;
+  std::vector<FieldPrecision> precisions_;
+  std::array<std::optional<ParticleArray>, 2> buffers_{};
+  size_t next_buffer_ = 0;
+  std::future<void> pending_;
+
+}; // class ParticleWriter
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
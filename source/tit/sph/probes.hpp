@@ -0,0 +1,217 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <optional>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/field.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// In-situ probes, that sample the fluid fields at the fixed points.
+///
+/// Probes are grouped into the gauges: each gauge samples the points evenly
+/// spaced along a segment, and a point gauge is the one with a single point.
+/// Values at the points are the Shepard-normalized SPH interpolants over the
+/// fluid and buffer particles, that the particle mesh finds around the probe
+/// points on each rebuild, see `ParticleMesh::set_probes`.
+///
+/// Free surface level of a gauge is the distance from its start to the first
+/// point, where the kernel sum `Σ V_a W_a` drops below one half, interpolated
+/// linearly between the points. Gauges are therefore placed from the wet end,
+/// e.g., upwards from the bottom of the tank.
+///
+/// Samples are buffered, and appended into a data series in batches, each
+/// sample as a separate time step with the small uniform arrays: `p` and `v`
+/// hold the interpolated pressures and velocities at the points, `weight`
+/// holds the kernel sums, and `level` holds the free surface levels of the
+/// gauges. Positions of the points are stored as the `r` array, that refers
+/// to the data of the previous time step.
+template<class Vec>
+class ProbeSet final {
+public:
+
+  /// Numeric type.
+  using Num = vec_num_t<Vec>;
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{r, h, m, rho, p, v};
+
+  /// Add a gauge with @p num_points points between @p start and @p end.
+  ///
+  /// @returns Index of the gauge.
+  auto add_gauge(const Vec& start, const Vec& end, size_t num_points)
+      -> size_t {
+    TIT_ASSERT(num_points > 0, "Gauge must have at least one point!");
+    TIT_ASSERT(times_.empty(), "Gauges must be added before sampling!");
+    const auto step =
+        num_points == 1 ? Vec{} :
+                          (end - start) / static_cast<Num>(num_points - 1);
+    for (size_t k = 0; k < num_points; ++k) {
+      points_.push_back(start + static_cast<Num>(k) * step);
+    }
+    spacings_.push_back(norm(step));
+    offsets_.push_back(points_.size());
+    return num_gauges() - 1;
+  }
+
+  /// Add a point gauge at @p point.
+  ///
+  /// @returns Index of the gauge.
+  auto add_point(const Vec& point) -> size_t {
+    return add_gauge(point, point, 1);
+  }
+
+  /// Number of the gauges.
+  constexpr auto num_gauges() const noexcept -> size_t {
+    return spacings_.size();
+  }
+
+  /// Probe points of all the gauges.
+  constexpr auto points() const noexcept -> std::span<const Vec> {
+    return points_;
+  }
+
+  /// Number of the buffered samples.
+  constexpr auto num_samples() const noexcept -> size_t {
+    return times_.size();
+  }
+
+  /// Sample the fluid fields at the probe points, and buffer the sample.
+  /// Probes must be set for the particle mesh, see `points()`. Until the mesh
+  /// is rebuilt for them, the points are sampled as though they are dry.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           kernel Kernel>
+  void sample(real_t time,
+              const ParticleMesh& mesh,
+              ParticleArray& particles,
+              const Kernel& kernel) {
+    TIT_PROFILE_SECTION("ProbeSet::sample()");
+    using PV = ParticleView<ParticleArray>;
+    const auto num_points = points_.size();
+    const auto first = times_.size() * num_points;
+    times_.push_back(time);
+    p_.resize(first + num_points);
+    v_.resize(first + num_points);
+    weight_.resize(first + num_points);
+    level_.resize(times_.size() * num_gauges());
+
+    // Interpolate the fields at the points.
+    if (mesh.num_probes() == num_points) {
+      par::for_each(
+          std::views::iota(size_t{0}, num_points),
+          [first, &mesh, &particles, &kernel, this](size_t i) {
+            const auto& box = particles.periodic_box();
+            Num S{};
+            Num p_sum{};
+            Vec v_sum{};
+            for (const PV a : mesh.probe_neighbors(particles, i)) {
+              const auto W_a = kernel(box.delta(points_[i], r[a]), h[a]);
+              const auto V_a = W_a * m[a] / rho[a];
+              S += V_a;
+              p_sum += V_a * p[a];
+              v_sum += V_a * v[a];
+            }
+            weight_[first + i] = S;
+            if (is_tiny(S)) return;
+            const auto S_inverse = inverse(S);
+            p_[first + i] = p_sum * S_inverse;
+            v_[first + i] = v_sum * S_inverse;
+          });
+    }
+
+    // Find the free surface levels along the gauges.
+    const auto weights = std::span{weight_}.subspan(first, num_points);
+    for (size_t g = 0; g < num_gauges(); ++g) {
+      const auto gauge_weights = weights.subspan(
+          offsets_[g],
+          offsets_[g + 1] - offsets_[g]);
+      auto level = static_cast<Num>(gauge_weights.size() - 1);
+      for (size_t k = 0; k < gauge_weights.size(); ++k) {
+        if (gauge_weights[k] >= Num{0.5}) continue;
+        if (k == 0) {
+          level = Num{0.0};
+        } else {
+          const auto above = gauge_weights[k - 1] - Num{0.5};
+          const auto below = Num{0.5} - gauge_weights[k];
+          level = static_cast<Num>(k - 1) + above / (above + below);
+        }
+        break;
+      }
+      level_[(times_.size() - 1) * num_gauges() + g] = level * spacings_[g];
+    }
+  }
+
+  /// Append the buffered samples into the data series, in a single
+  /// transaction, and clear the buffer.
+  ///
+  /// @note Storage must be locked by the caller, if it is shared with the
+  ///       other writers, see `DataStorage::lock()`.
+  void flush(data::DataSeriesView<data::DataStorage> series) {
+    TIT_PROFILE_SECTION("ProbeSet::flush()");
+    if (times_.empty()) return;
+    using DataSet = data::DataSetView<data::DataStorage>;
+    const auto transaction = series.storage().transaction();
+    std::optional<DataSet> prev_uniforms;
+    if (series.num_time_steps() > 0) {
+      prev_uniforms = series.last_time_step().uniforms();
+    }
+    const auto num_points = points_.size();
+    for (size_t n = 0; n < times_.size(); ++n) {
+      const auto uniforms = series.create_time_step(times_[n]).uniforms();
+      uniforms.create_array_or_ref("r", points_, prev_uniforms);
+      const auto first = n * num_points;
+      uniforms.create_array("p", std::span{p_}.subspan(first, num_points));
+      uniforms.create_array("v", std::span{v_}.subspan(first, num_points));
+      uniforms.create_array("weight",
+                            std::span{weight_}.subspan(first, num_points));
+      uniforms.create_array(
+          "level",
+          std::span{level_}.subspan(n * num_gauges(), num_gauges()));
+      prev_uniforms = uniforms;
+    }
+    times_.clear();
+    p_.clear();
+    v_.clear();
+    weight_.clear();
+    level_.clear();
+  }
+
+private:
+
+  std::vector<Vec> points_;
+  std::vector<size_t> offsets_{0};
+  std::vector<Num> spacings_;
+  std::vector<real_t> times_;
+  std::vector<Num> p_;
+  std::vector<Vec> v_;
+  std::vector<Num> weight_;
+  std::vector<Num> level_;
+
+}; // class ProbeSet
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
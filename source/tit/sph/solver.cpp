@@ -0,0 +1,96 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <memory>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/solver.hpp"
+#include "tit/sph/solver_impl.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+namespace {
+
+template<size_t Dim>
+auto make_solver(const SolverConfig& config,
+                 data::DataSeriesView<data::DataStorage> series)
+    -> std::unique_ptr<Solver> {
+  if (config.kernel == "cubic_spline") {
+    return impl::make_solver<Dim, CubicSplineKernel>(config, series);
+  }
+  if (config.kernel == "quintic_spline") {
+    return impl::make_solver<Dim, QuinticSplineKernel>(config, series);
+  }
+  if (config.kernel == "quartic_wendland") {
+    return impl::make_solver<Dim, QuarticWendlandKernel>(config, series);
+  }
+  if (config.kernel == "sixth_order_wendland") {
+    return impl::make_solver<Dim, SixthOrderWendlandKernel>(config, series);
+  }
+  TIT_THROW("Unknown kernel '{}'.", config.kernel);
+}
+
+} // namespace
+
+auto Solver::create(const SolverConfig& config,
+                    data::DataSeriesView<data::DataStorage> series)
+    -> std::unique_ptr<Solver> {
+  if (config.cs_0 <= 0.0) TIT_THROW("Reference sound speed must be positive.");
+  if (config.rho_0 <= 0.0) TIT_THROW("Reference density must be positive.");
+  if (config.h_0 <= 0.0) TIT_THROW("Particle width must be positive.");
+  if (config.mu_0 < 0.0) TIT_THROW("Dynamic viscosity must be non-negative.");
+  if (config.num_time_levels == 0) {
+    TIT_THROW("Number of the time step levels must be positive.");
+  }
+  if (config.mesh_update_freq == 0) {
+    TIT_THROW("Mesh update frequency must be positive.");
+  }
+  if (config.interp_radius_scale <= 0.0) {
+    TIT_THROW("Interpolation radius scale must be positive.");
+  }
+  if (config.inflow_velocity < 0.0) {
+    TIT_THROW("Inflow velocity must be non-negative.");
+  }
+  if (config.inflow_velocity > 0.0 && config.open_boundary_width <= 0.0) {
+    TIT_THROW("Open boundary width must be positive.");
+  }
+  for (size_t d = 0; d < std::min(config.dim, config.domain_low.size()); ++d) {
+    if (config.domain_low[d] >= config.domain_high[d]) {
+      TIT_THROW("Domain must have positive extents.");
+    }
+  }
+  if (config.refinement_low != config.refinement_high) {
+    for (size_t d = 0; d < std::min(config.dim, config.refinement_low.size());
+         ++d) {
+      if (config.refinement_low[d] >= config.refinement_high[d]) {
+        TIT_THROW("Refinement region must have positive extents.");
+      }
+    }
+    if (config.refinement_freq == 0) {
+      TIT_THROW("Refinement frequency must be positive.");
+    }
+    if (config.compressed_mesh) {
+      TIT_THROW("Particle refinement does not support the compressed mesh.");
+    }
+    if (config.target_neighbors != 0) {
+      TIT_THROW("Particle refinement does not support the width adaptation.");
+    }
+  }
+  if (config.dim == 2) return make_solver<2>(config, series);
+  if (config.dim == 3) return make_solver<3>(config, series);
+  TIT_THROW("Unsupported number of dimensions {}.", config.dim);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,276 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/utils.hpp"
+
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/particle_array.hpp"
+
+namespace tit::sph {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Weakly compressible SPH solver configuration.
+///
+/// Momentum equation has the selected physical viscosity, the δ-SPH
+/// artificial viscosity and the gravity source term along the second axis.
+/// Fluid is contained within a box-shaped domain with the slip walls, formed by
+/// the fixed particles that are placed outside of it.
+struct SolverConfig final {
+  /// Number of the spatial dimensions: `2` or `3`.
+  size_t dim = 2;
+
+  /// Kernel: `cubic_spline`, `quintic_spline`, `quartic_wendland` or
+  /// `sixth_order_wendland`.
+  std::string kernel = "quartic_wendland";
+
+  /// Equation of state: `linear_tait` or `tait`.
+  std::string eos = "linear_tait";
+
+  /// Time integrator: `kick_drift`, `kick_drift_kick`, `runge_kutta`,
+  /// `low_storage_runge_kutta`, `multi_rate` or `projection`. Diagnostics are
+  /// not supported by `multi_rate` and `projection`.
+  std::string integrator = "runge_kutta";
+
+  /// Reuse the forces of the previous step in `kick_drift_kick` integrator,
+  /// see `KickDriftKickIntegrator`.
+  bool fsal = false;
+
+  /// Number of the time step levels in `multi_rate` integrator, see
+  /// `MultiRateIntegrator`.
+  size_t num_time_levels = 4;
+
+  /// Viscosity: `none`, `laplacian` or `implicit_laplacian`. Implicit one is
+  /// applied with the backward Euler step, so that the time step is not
+  /// limited by the viscous diffusion, see `ImplicitLaplacianViscosity`. It
+  /// is only supported by `kick_drift` and `projection` integrators.
+  std::string viscosity = "none";
+
+  /// Reference sound speed.
+  real_t cs_0 = 0.0;
+
+  /// Reference density.
+  real_t rho_0 = 1000.0;
+
+  /// Gravitational acceleration absolute value.
+  real_t g = 9.81;
+
+  /// Dynamic viscosity, unused if the viscosity is `none`.
+  real_t mu_0 = 0.0;
+
+  /// Particle width, used to setup the search and the partitioning.
+  real_t h_0 = 0.0;
+
+  /// Lower and upper corners of the fluid domain. Only the first `dim`
+  /// coordinates are used.
+  std::array<real_t, 3> domain_low{};
+  std::array<real_t, 3> domain_high{};
+
+  /// Inflow velocity of the open channel along the first axis. If positive,
+  /// the fluid enters the domain through its lower side along the first axis,
+  /// and leaves it through the upper one. Buffer zones of the
+  /// `open_boundary_width` width are placed outside of these sides, and the
+  /// walls are continued under them, see `OpenBoundary`. Inflow zone should
+  /// be filled with the `ParticleType::buffer` particles.
+  real_t inflow_velocity = 0.0;
+
+  /// Width of the open boundary buffer zones.
+  real_t open_boundary_width = 0.0;
+
+  /// Lower and upper corners of the particle refinement region. If they
+  /// differ, each `refinement_freq` steps the fluid particles that have
+  /// entered the region are split, and the split ones that have left it are
+  /// merged back, see `ParticleRefinement`. Only the first `dim` coordinates
+  /// are used. Refinement supports neither the compressed mesh, nor the
+  /// kernel width adaptation.
+  std::array<real_t, 3> refinement_low{};
+  std::array<real_t, 3> refinement_high{};
+
+  /// Particle refinement frequency.
+  size_t refinement_freq = 10;
+
+  /// Ratio of the boundary interpolation radius to the kernel radius.
+  real_t interp_radius_scale = 3.0;
+
+  /// Particle mesh update frequency.
+  size_t mesh_update_freq = 10;
+
+  /// Tune the particle mesh update frequency, the number of the partitioning
+  /// levels and the parallel loop grain size at run time, by the measured
+  /// step times, see `Autotuner`. Mesh update frequency is limited so that
+  /// the particles move by at most `h_0` between the updates.
+  bool autotune = false;
+
+  /// Update frequencies of the boundary ghost values and the renormalization
+  /// fields in the Runge-Kutta integrators, see `StageUpdateFreq`. Zero
+  /// updates them on each stage.
+  size_t boundary_update_freq = 0;
+  size_t renorm_update_freq = 0;
+
+  /// Skip the fixed particles without the fluid neighbors, see
+  /// `ParticleMesh::set_prune_fixed`.
+  bool prune_fixed = false;
+
+  /// Prefetch distance of the pair loops, zero disables the prefetching, see
+  /// `ParticleMesh::set_prefetch_distance`.
+  size_t prefetch_distance = 0;
+
+  /// Skip the pairs outside of the kernel support on each step, see
+  /// `ParticleMesh::set_pair_compaction`.
+  bool pair_compaction = false;
+
+  /// Store the particle adjacency in the compressed form, that fits larger
+  /// problems into memory at the cost of decoding it in the pair loops, see
+  /// `graph::CompressedGraph`.
+  bool compressed_mesh = false;
+
+  /// Target mean number of the fluid particle neighbors, that the kernel
+  /// width is adapted to on the mesh rebuilds. Zero keeps the kernel width
+  /// fixed at `h_0`.
+  size_t target_neighbors = 0;
+
+  /// Number of the decimated levels, that are written along with each time
+  /// step for the quick-look viewers.
+  size_t output_levels = 0;
+
+  /// Accumulate the global diagnostics of the fluid on each step, within the
+  /// last particle pass of the time integrator, see `Diagnostics`.
+  bool diagnostics = false;
+}; // struct SolverConfig
+
+/// Initial state of the particle.
+struct ParticleState final {
+  real_t rho; ///< Density.
+  real_t p;   ///< Pressure.
+};
+
+/// Initial state function, that is called with the particle type and the
+/// particle position. Function is called for the particles in parallel.
+using ParticleInitFunc = std::move_only_function<
+    ParticleState(ParticleType, std::span<const real_t>) const>;
+
+/// Simulation progress, that is stored in the checkpoints.
+struct SolverProgress final {
+  real_t time = 0.0; ///< Simulation time.
+  size_t step = 0;   ///< Step number.
+};
+
+/// Global diagnostics of the fluid after the last step.
+struct SolverDiagnostics final {
+  real_t mass = 0.0;                ///< Total mass.
+  real_t kinetic_energy = 0.0;      ///< Total kinetic energy.
+  real_t potential_energy = 0.0;    ///< Potential energy in the gravity.
+  std::array<real_t, 3> momentum{}; ///< Total momentum, `dim()` components.
+  real_t max_speed = 0.0;           ///< Maximum speed.
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Type-erased SPH solver.
+///
+/// Each of the configurations is an explicit instantiation of the solver
+/// template, that is compiled once within the library, so that the users
+/// could select the configuration at run time without instantiating the
+/// solver templates themselves.
+class Solver : public VirtualBase {
+public:
+
+  /// Create a solver with the given configuration, that writes the particles
+  /// into the data series.
+  static auto create(const SolverConfig& config,
+                     data::DataSeriesView<data::DataStorage> series)
+      -> std::unique_ptr<Solver>;
+
+  /// Number of the spatial dimensions.
+  virtual auto dim() const noexcept -> size_t = 0;
+
+  /// Number of particles.
+  virtual auto num_particles() const noexcept -> size_t = 0;
+
+  /// Append the particles of the given type.
+  ///
+  /// @param positions Particle positions, `dim()` coordinates per particle.
+  virtual void append(ParticleType type, std::span<const real_t> positions) = 0;
+
+  /// Set the particle mass and width. If the refinement is enabled, the
+  /// particles lighter than @p m_0 are treated as the refined ones.
+  virtual void set_mass_and_width(real_t m_0, real_t h_0) = 0;
+
+  /// Initialize the particle densities and pressures.
+  virtual void init(const ParticleInitFunc& func) = 0;
+
+  /// Make a step in time.
+  virtual void step(real_t dt) = 0;
+
+  /// Write the particles into the data series asynchronously.
+  virtual void write(real_t time) = 0;
+
+  /// Wait for the pending write to finish, and write the buffered gauge
+  /// samples.
+  virtual void wait() = 0;
+
+  /// Add a gauge, that samples the fluid at the @p num_points points evenly
+  /// spaced between @p start and @p end, see `ProbeSet`. Gauges must be added
+  /// before the first sample.
+  ///
+  /// @param start Start of the gauge, `dim()` coordinates.
+  /// @param end   End of the gauge, `dim()` coordinates.
+  virtual void add_gauge(std::span<const real_t> start,
+                         std::span<const real_t> end,
+                         size_t num_points = 1) = 0;
+
+  /// Set the data series, that the gauge samples are written into. It should
+  /// be different from the particle data series.
+  virtual void set_probe_series(
+      data::DataSeriesView<data::DataStorage> series) = 0;
+
+  /// Sample the gauges after the step. Samples are buffered, and written into
+  /// the probe data series before the next particle write, or on `wait()`.
+  virtual void sample(real_t time) = 0;
+
+  /// Write the complete solver state into a checkpoint file.
+  ///
+  /// Particle mesh is not stored, it is rebuilt on the first step after the
+  /// restore. Restarts are bitwise identical to the uninterrupted runs, if
+  /// the checkpoints are written on the particle mesh update boundaries.
+  virtual void checkpoint(const std::filesystem::path& path,
+                          const SolverProgress& progress) const = 0;
+
+  /// Restore the solver state from a checkpoint file, that was written by
+  /// the solver of the same configuration.
+  ///
+  /// @returns Simulation progress at the moment of the checkpoint.
+  virtual auto restore(const std::filesystem::path& path)
+      -> SolverProgress = 0;
+
+  /// Number of the particle mesh rebuilds so far.
+  virtual auto num_mesh_rebuilds() const noexcept -> size_t = 0;
+
+  /// Number of the interacting particle pairs.
+  virtual auto num_pairs() const noexcept -> size_t = 0;
+
+  /// Particle mesh block imbalance, see `ParticleMesh::block_imbalance`.
+  virtual auto block_imbalance() const -> real_t = 0;
+
+  /// Global diagnostics of the fluid after the last step. Diagnostics must
+  /// be enabled in the configuration, see `SolverConfig::diagnostics`.
+  virtual auto diagnostics() const -> SolverDiagnostics = 0;
+
+}; // class Solver
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph
@@ -0,0 +1,426 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/sys/utils.hpp"
+
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/solver.hpp"
+
+#include "tit/testing/temp_dir.hpp"
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Positions of the particles in a cube-shaped lattice, shifted vertically.
+auto lattice(size_t dim, size_t size, real_t dr, real_t shift)
+    -> std::vector<real_t> {
+  std::vector<real_t> positions;
+  const auto num_particles = dim == 2 ? size * size : size * size * size;
+  for (size_t n = 0; n < num_particles; ++n) {
+    auto index = n;
+    for (size_t d = 0; d < dim; ++d) {
+      positions.push_back(dr * (static_cast<real_t>(index % size) + 0.5) +
+                          (d == 1 ? shift : 0.0));
+      index /= size;
+    }
+  }
+  return positions;
+}
+
+// Place a small block of fluid over the fixed particles.
+void setup_block(sph::Solver& solver,
+                 const sph::SolverConfig& config,
+                 real_t dr) {
+  constexpr size_t size = 6;
+  const auto height = static_cast<real_t>(size) * dr;
+  solver.append(sph::ParticleType::fluid, lattice(config.dim, size, dr, 0.0));
+  solver.append(sph::ParticleType::fixed,
+                lattice(config.dim, size, dr, -height));
+  solver.set_mass_and_width(config.rho_0 * dr * dr, config.h_0);
+  solver.init([&config](sph::ParticleType /*type*/,
+                        std::span<const real_t> /*position*/) {
+    return sph::ParticleState{.rho = config.rho_0, .p = 0.0};
+  });
+}
+
+// Raw contents of the last written particle positions.
+auto last_positions(data::DataSeriesView<data::DataStorage> series)
+    -> std::vector<byte_t> {
+  const auto array = series.last_time_step().varyings().find_array("r");
+  REQUIRE(array.has_value());
+  return array->read_range(0, array->size());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::Solver") {
+  data::DataStorage storage{":memory:"};
+  const auto series = storage.create_series();
+  constexpr real_t dr = 0.01;
+  sph::SolverConfig config{
+      .cs_0 = 10.0,
+      .h_0 = 2 * dr,
+      .domain_low = {0.0, 0.0, 0.0},
+      .domain_high = {6 * dr, 12 * dr, 6 * dr},
+  };
+  SUBCASE("configurations") {
+    for (const size_t dim : {2, 3}) {
+      for (const std::string kernel : {"cubic_spline",
+                                       "quintic_spline",
+                                       "quartic_wendland",
+                                       "sixth_order_wendland"}) {
+        for (const std::string eos : {"linear_tait", "tait"}) {
+          for (const std::string integrator : {"kick_drift",
+                                               "kick_drift_kick",
+                                               "runge_kutta",
+                                               "low_storage_runge_kutta",
+                                               "multi_rate",
+                                               "projection"}) {
+            config.dim = dim;
+            config.kernel = kernel;
+            config.eos = eos;
+            config.integrator = integrator;
+            const auto solver = sph::Solver::create(config, series);
+            REQUIRE(solver != nullptr);
+            CHECK(solver->dim() == dim);
+
+            setup_block(*solver, config, dr);
+            const auto num_particles = solver->num_particles();
+            CHECK(num_particles == 2 * (dim == 2 ? 36 : 216));
+
+            // Make a few steps.
+            for (size_t n = 0; n < 3; ++n) solver->step(1.0e-4);
+            CHECK(solver->num_particles() == num_particles);
+            CHECK(solver->num_mesh_rebuilds() > 0);
+            CHECK(solver->num_pairs() > 0);
+            solver->write(0.0);
+            solver->wait();
+          }
+        }
+      }
+    }
+  }
+  SUBCASE("autotune") {
+    config.autotune = true;
+    const auto solver = sph::Solver::create(config, series);
+    setup_block(*solver, config, dr);
+    const auto num_particles = solver->num_particles();
+    for (size_t n = 0; n < 50; ++n) solver->step(1.0e-4);
+    CHECK(solver->num_particles() == num_particles);
+    CHECK(solver->num_mesh_rebuilds() > 0);
+  }
+  SUBCASE("fsal") {
+    config.integrator = "kick_drift_kick";
+    const auto run = [&config, &series, dr] {
+      const auto solver = sph::Solver::create(config, series);
+      setup_block(*solver, config, dr);
+      for (size_t n = 0; n < 5; ++n) solver->step(1.0e-4);
+      solver->write(0.0);
+      solver->wait();
+      return last_positions(series);
+    };
+    // Mesh is rebuilt on each step, so the forces are never reused, and the
+    // result must be exactly the same.
+    config.mesh_update_freq = 1;
+    const auto expected = run();
+    config.fsal = true;
+    CHECK(run() == expected);
+  }
+  SUBCASE("compressed mesh") {
+    const auto run = [&config, &series, dr] {
+      const auto solver = sph::Solver::create(config, series);
+      setup_block(*solver, config, dr);
+      for (size_t n = 0; n < 5; ++n) solver->step(1.0e-4);
+      solver->write(0.0);
+      solver->wait();
+      return last_positions(series);
+    };
+    // Compressed rows are decoded in the same order, so the result must be
+    // exactly the same.
+    const auto expected = run();
+    config.compressed_mesh = true;
+    CHECK(run() == expected);
+  }
+  SUBCASE("open boundary") {
+    // Inflow zone is filled with three columns of the buffer particles.
+    config.inflow_velocity = 0.5;
+    config.open_boundary_width = 3 * dr;
+    const auto solver = sph::Solver::create(config, series);
+    std::vector<real_t> buffer;
+    for (size_t i = 0; i < 3; ++i) {
+      for (size_t j = 0; j < 6; ++j) {
+        buffer.push_back(-dr * (static_cast<real_t>(i) + 0.5));
+        buffer.push_back(dr * (static_cast<real_t>(j) + 0.5));
+      }
+    }
+    solver->append(sph::ParticleType::buffer, buffer);
+    setup_block(*solver, config, dr);
+    const auto num_particles = solver->num_particles();
+    // First column enters the fluid domain within a hundred steps, and is
+    // replaced with the appended buffer particles, since nothing has left the
+    // outflow zone yet.
+    for (size_t n = 0; n < 100; ++n) solver->step(2.0e-4);
+    CHECK(solver->num_particles() == num_particles + 6);
+    CHECK(solver->num_pairs() > 0);
+    solver->write(0.0);
+    solver->wait();
+  }
+  SUBCASE("viscosity") {
+    config.mu_0 = 1.0e-3;
+    for (const std::string viscosity : {"laplacian", "implicit_laplacian"}) {
+      for (const std::string integrator : {"kick_drift", "projection"}) {
+        config.viscosity = viscosity;
+        config.integrator = integrator;
+        const auto solver = sph::Solver::create(config, series);
+        setup_block(*solver, config, dr);
+        const auto num_particles = solver->num_particles();
+        for (size_t n = 0; n < 3; ++n) solver->step(1.0e-4);
+        CHECK(solver->num_particles() == num_particles);
+      }
+    }
+  }
+  SUBCASE("refinement") {
+    // Region covers the first three columns of the block. Daughters of the
+    // third column, that are placed on the right of the parents, are outside
+    // of the region, and are merged back on the next refinement step.
+    config.refinement_low = {-dr, -dr, 0.0};
+    config.refinement_high = {2.8 * dr, 7 * dr, 0.0};
+    config.refinement_freq = 1;
+    config.diagnostics = true;
+    const auto solver = sph::Solver::create(config, series);
+    setup_block(*solver, config, dr);
+    const auto num_particles = solver->num_particles();
+    // Eighteen particles are split into four daughters each.
+    solver->step(1.0e-4);
+    CHECK(solver->num_particles() == num_particles + 18 * 3);
+    // Outer daughters of the third column are merged in five pairs.
+    solver->step(1.0e-4);
+    CHECK(solver->num_particles() == num_particles + 18 * 3 - 5);
+    // Refinement conserves the mass of the fluid.
+    solver->step(1.0e-4);
+    const auto diagnostics = solver->diagnostics();
+    CHECK(approx_equal_to(diagnostics.mass, 36 * config.rho_0 * dr * dr));
+    solver->write(0.0);
+    solver->wait();
+  }
+  SUBCASE("checkpoint") {
+    const testing::TempDir temp_dir{};
+    const auto path = temp_dir / "test_solver.ckpt";
+    for (const std::string integrator : {"kick_drift",
+                                         "kick_drift_kick",
+                                         "runge_kutta",
+                                         "low_storage_runge_kutta",
+                                         "multi_rate",
+                                         "projection"}) {
+      config.integrator = integrator;
+      const auto solver = sph::Solver::create(config, series);
+      setup_block(*solver, config, dr);
+
+      // Checkpoint on the mesh update boundary and continue the simulation.
+      for (size_t n = 0; n < config.mesh_update_freq; ++n) solver->step(1.0e-4);
+      solver->checkpoint(path, {.time = 1.0e-3, .step = 10});
+      for (size_t n = 0; n < 5; ++n) solver->step(1.0e-4);
+      solver->write(1.5e-3);
+      solver->wait();
+      const auto expected = last_positions(series);
+
+      // Restart from the checkpoint must produce exactly the same result.
+      const auto restarted = sph::Solver::create(config, series);
+      const auto progress = restarted->restore(path);
+      CHECK(progress.time == 1.0e-3);
+      CHECK(progress.step == 10);
+      CHECK(restarted->num_particles() == solver->num_particles());
+      for (size_t n = 0; n < 5; ++n) restarted->step(1.0e-4);
+      restarted->write(1.5e-3);
+      restarted->wait();
+      CHECK(last_positions(series) == expected);
+    }
+    SUBCASE("failure") {
+      SUBCASE("configuration") {
+        const auto solver = sph::Solver::create(config, series);
+        setup_block(*solver, config, dr);
+        solver->checkpoint(path, {});
+        config.dim = 3;
+        const auto other = sph::Solver::create(config, series);
+        CHECK_THROWS_MSG(other->restore(path),
+                         Exception,
+                         "has value size");
+      }
+      SUBCASE("not a checkpoint") {
+        {
+          const auto file = open_file(path.c_str(), "w");
+          std::fputs("particles", file.get());
+        }
+        const auto solver = sph::Solver::create(config, series);
+        CHECK_THROWS_MSG(solver->restore(path),
+                         Exception,
+                         "is not a checkpoint");
+      }
+      SUBCASE("missing file") {
+        std::filesystem::remove(path);
+        const auto solver = sph::Solver::create(config, series);
+        CHECK_THROWS_MSG(solver->restore(path),
+                         Exception,
+                         "Unable to open the checkpoint file");
+      }
+    }
+  }
+  SUBCASE("probes") {
+    const auto probe_series = storage.create_series();
+    const auto solver = sph::Solver::create(config, series);
+    setup_block(*solver, config, dr);
+    // Point gauge within the block, and a vertical gauge through its top.
+    const std::vector<real_t> point{3 * dr, 3 * dr};
+    const std::vector<real_t> top{3 * dr, 9 * dr};
+    solver->add_gauge(point, point);
+    solver->add_gauge(point, top, 7);
+    CHECK_THROWS_MSG(solver->sample(0.0),
+                     Exception,
+                     "Probe data series must be set");
+    solver->set_probe_series(probe_series);
+    for (size_t n = 0; n < 3; ++n) {
+      solver->step(1.0e-4);
+      solver->sample(static_cast<real_t>(n + 1) * 1.0e-4);
+    }
+    solver->wait();
+    REQUIRE(probe_series.num_time_steps() == 3);
+    const auto uniforms = probe_series.last_time_step().uniforms();
+    const auto weight_array = uniforms.find_array("weight");
+    REQUIRE(weight_array.has_value());
+    REQUIRE(weight_array->size() == 8);
+    std::vector<real_t> weights(8);
+    weight_array->read_into(std::span{weights});
+    CHECK(weights[0] > 0.5);
+    CHECK(weights[7] < 0.5);
+    const auto level_array = uniforms.find_array("level");
+    REQUIRE(level_array.has_value());
+    REQUIRE(level_array->size() == 2);
+    std::vector<real_t> levels(2);
+    level_array->read_into(std::span{levels});
+    // Free surface of the block is at the half of the vertical gauge.
+    CHECK(levels[0] == 0.0);
+    CHECK(levels[1] > 2 * dr);
+    CHECK(levels[1] < 4 * dr);
+  }
+  SUBCASE("diagnostics") {
+    const auto solver = sph::Solver::create(config, series);
+    setup_block(*solver, config, dr);
+    CHECK_THROWS_MSG(solver->diagnostics(),
+                     Exception,
+                     "Diagnostics must be enabled");
+    config.diagnostics = true;
+    for (const std::string integrator : {"kick_drift",
+                                         "kick_drift_kick",
+                                         "runge_kutta",
+                                         "low_storage_runge_kutta",
+                                         "multi_rate",
+                                         "projection"}) {
+      config.integrator = integrator;
+      const auto observed = sph::Solver::create(config, series);
+      setup_block(*observed, config, dr);
+      for (size_t n = 0; n < 3; ++n) observed->step(1.0e-4);
+      const auto diagnostics = observed->diagnostics();
+      // Only the fluid particles are accounted for.
+      CHECK(approx_equal_to(diagnostics.mass, 36 * config.rho_0 * dr * dr));
+      CHECK(diagnostics.kinetic_energy > 0.0);
+      CHECK(diagnostics.potential_energy > 0.0);
+      CHECK(diagnostics.max_speed > 0.0);
+    }
+  }
+  SUBCASE("failure") {
+    SUBCASE("dimension") {
+      config.dim = 4;
+      CHECK_THROWS_MSG(sph::Solver::create(config, series),
+                       Exception,
+                       "Unsupported number of dimensions 4.");
+    }
+    SUBCASE("domain") {
+      config.domain_high[1] = 0.0;
+      CHECK_THROWS_MSG(sph::Solver::create(config, series),
+                       Exception,
+                       "Domain must have positive extents.");
+    }
+    SUBCASE("kernel") {
+      config.kernel = "gaussian";
+      CHECK_THROWS_MSG(sph::Solver::create(config, series),
+                       Exception,
+                       "Unknown kernel 'gaussian'.");
+    }
+    SUBCASE("equation of state") {
+      config.eos = "ideal_gas";
+      CHECK_THROWS_MSG(sph::Solver::create(config, series),
+                       Exception,
+                       "Unknown equation of state 'ideal_gas'.");
+    }
+    SUBCASE("integrator") {
+      config.integrator = "euler";
+      CHECK_THROWS_MSG(sph::Solver::create(config, series),
+                       Exception,
+                       "Unknown time integrator 'euler'.");
+    }
+    SUBCASE("time levels") {
+      config.integrator = "multi_rate";
+      config.num_time_levels = 0;
+      CHECK_THROWS_MSG(sph::Solver::create(config, series),
+                       Exception,
+                       "Number of the time step levels must be positive.");
+    }
+    SUBCASE("open boundary") {
+      config.inflow_velocity = 1.0;
+      CHECK_THROWS_MSG(sph::Solver::create(config, series),
+                       Exception,
+                       "Open boundary width must be positive.");
+    }
+    SUBCASE("refinement") {
+      config.refinement_high = {dr, dr, 0.0};
+      config.compressed_mesh = true;
+      CHECK_THROWS_MSG(sph::Solver::create(config, series),
+                       Exception,
+                       "does not support the compressed mesh");
+      config.refinement_low = {dr, 0.0, 0.0};
+      CHECK_THROWS_MSG(sph::Solver::create(config, series),
+                       Exception,
+                       "Refinement region must have positive extents.");
+    }
+    SUBCASE("viscosity") {
+      config.viscosity = "sutherland";
+      CHECK_THROWS_MSG(sph::Solver::create(config, series),
+                       Exception,
+                       "Unknown viscosity 'sutherland'.");
+    }
+    SUBCASE("implicit viscosity") {
+      config.viscosity = "implicit_laplacian";
+      config.integrator = "runge_kutta";
+      CHECK_THROWS_MSG(sph::Solver::create(config, series),
+                       Exception,
+                       "does not support implicit viscosity");
+    }
+    SUBCASE("dynamic viscosity") {
+      config.mu_0 = -1.0;
+      CHECK_THROWS_MSG(sph::Solver::create(config, series),
+                       Exception,
+                       "Dynamic viscosity must be non-negative.");
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
@@ -0,0 +1,34 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <memory>
+
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/solver.hpp"
+#include "tit/sph/solver_impl.hpp"
+
+namespace tit::sph::impl {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// 2D solver configurations.
+template auto make_solver<2, CubicSplineKernel>(
+    const SolverConfig& config,
+    data::DataSeriesView<data::DataStorage> series) -> std::unique_ptr<Solver>;
+template auto make_solver<2, QuinticSplineKernel>(
+    const SolverConfig& config,
+    data::DataSeriesView<data::DataStorage> series) -> std::unique_ptr<Solver>;
+template auto make_solver<2, QuarticWendlandKernel>(
+    const SolverConfig& config,
+    data::DataSeriesView<data::DataStorage> series) -> std::unique_ptr<Solver>;
+template auto make_solver<2, SixthOrderWendlandKernel>(
+    const SolverConfig& config,
+    data::DataSeriesView<data::DataStorage> series) -> std::unique_ptr<Solver>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph::impl
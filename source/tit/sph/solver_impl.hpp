@@ -0,0 +1,626 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <utility>
+
+#include "tit/core/autotuner.hpp"
+#include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/memory_stats.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/time.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/partition.hpp"
+#include "tit/geom/search.hpp"
+
+#include "tit/data/storage.hpp"
+
+#include "tit/sph/artificial_viscosity.hpp"
+#include "tit/sph/boundary.hpp"
+#include "tit/sph/checkpoint.hpp"
+#include "tit/sph/continuity_equation.hpp"
+#include "tit/sph/diagnostics.hpp"
+#include "tit/sph/energy_equation.hpp"
+#include "tit/sph/equation_of_state.hpp"
+#include "tit/sph/field.hpp"
+#include "tit/sph/fluid_equations.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/momentum_equation.hpp"
+#include "tit/sph/motion_equation.hpp"
+#include "tit/sph/open_boundary.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/particle_refinement.hpp"
+#include "tit/sph/particle_shifting.hpp"
+#include "tit/sph/particle_writer.hpp"
+#include "tit/sph/probes.hpp"
+#include "tit/sph/solver.hpp"
+#include "tit/sph/time_integrator.hpp"
+#include "tit/sph/viscosity.hpp"
+
+namespace tit::sph::impl {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Particle fields of the solver. Fields of the time integrator are extended
+/// with the ones of the particle refinement, if it is enabled.
+template<class Integrator, bool Refinement>
+struct SolverFields final {
+  static constexpr auto required_fields = Integrator::required_fields;
+  static constexpr auto modified_fields = Integrator::modified_fields;
+};
+
+template<class Integrator>
+struct SolverFields<Integrator, true> final {
+  static constexpr auto required_fields =
+      Integrator::required_fields | ParticleRefinement::required_fields;
+  static constexpr auto modified_fields =
+      Integrator::modified_fields | ParticleRefinement::modified_fields;
+};
+
+/// Solver implementation for the given time integrator. If @p CompressedMesh
+/// is set, the particle adjacency is stored in the compressed form. If
+/// @p Refinement is set, the particle masses and widths are varying, and the
+/// particles are refined within the refinement region, see
+/// `SolverConfig::refinement_low`.
+template<size_t Dim,
+         class Integrator,
+         bool CompressedMesh = false,
+         bool Refinement = false>
+class SolverImpl final : public Solver {
+public:
+
+  /// Particle array type. Fields that are read together by the pair loops
+  /// are interleaved.
+  using Particles =
+      decltype(ParticleArray{Space<real_t, Dim>{},
+                             SolverFields<Integrator, Refinement>{},
+                             Integrator::pair_fields});
+
+  /// Particle mesh type. Particle indices are 32-bit to save the memory.
+  using Mesh = ParticleMesh<geom::GridSearch,
+                            geom::RecursiveInertialBisection,
+                            geom::GridGraphPartition,
+                            uint32_t,
+                            CompressedMesh>;
+
+  /// Construct a solver.
+  SolverImpl(const SolverConfig& config,
+             Integrator integrator,
+             data::DataSeriesView<data::DataStorage> series)
+      : integrator_{std::move(integrator)},
+        particles_{Space<real_t, Dim>{},
+                   SolverFields<Integrator, Refinement>{},
+                   Integrator::pair_fields},
+        // Graph partitioning with larger cell size is used as the interface
+        // partitioning method.
+        mesh_{geom::GridSearch{config.h_0},
+              geom::RecursiveInertialBisection{},
+              geom::GridGraphPartition{2 * config.h_0}},
+        writer_{series, config.output_levels} {
+    mesh_.set_prune_fixed(config.prune_fixed);
+    mesh_.set_prefetch_distance(config.prefetch_distance);
+    mesh_.set_pair_compaction(config.pair_compaction);
+    if constexpr (has_uniform<Particles>(mu)) mu[particles_] = config.mu_0;
+    if (config.inflow_velocity > 0.0) setup_open_boundary_(config);
+    if constexpr (Refinement) setup_refinement_(config);
+    if (config.diagnostics) {
+      diagnostics_.emplace(unit<1>(Vec<real_t, Dim>{}, -config.g));
+    }
+    if (config.autotune) setup_autotuner_(config.h_0);
+  }
+
+  auto dim() const noexcept -> size_t override {
+    return Dim;
+  }
+
+  auto num_particles() const noexcept -> size_t override {
+    return particles_.size();
+  }
+
+  void append(ParticleType type, std::span<const real_t> positions) override {
+    TIT_ASSERT(positions.size() % Dim == 0,
+               "Number of coordinates must be a multiple of dimension!");
+    const auto count = positions.size() / Dim;
+    const auto appended = particles_.append_n(type, count);
+    par::for_each(std::views::iota(size_t{0}, count),
+                  [&appended, positions](size_t i) {
+                    auto& r_a = r[appended[i]];
+                    for (size_t d = 0; d < Dim; ++d) {
+                      r_a[d] = positions[i * Dim + d];
+                    }
+                  });
+  }
+
+  void set_mass_and_width(real_t m_0, real_t h_0) override {
+    if constexpr (Refinement) {
+      m_0_ = m_0;
+      par::for_each(particles_.all(), [m_0, h_0](PV a) {
+        m[a] = m_0;
+        h[a] = h_0;
+      });
+    } else {
+      m[particles_] = m_0;
+      h[particles_] = h_0;
+    }
+  }
+
+  void init(const ParticleInitFunc& func) override {
+    par::for_each(particles_.all(), [&func](auto a) {
+      std::array<real_t, Dim> position{};
+      for (size_t d = 0; d < Dim; ++d) position[d] = r[a][d];
+      const auto type = a.is_fixed()  ? ParticleType::fixed :
+                        a.is_buffer() ? ParticleType::buffer :
+                                        ParticleType::fluid;
+      const auto [rho_a, p_a] = func(type, position);
+      rho[a] = rho_a;
+      p[a] = p_a;
+    });
+  }
+
+  void step(real_t dt) override {
+    Stopwatch stopwatch{};
+    {
+      const StopwatchCycle cycle{stopwatch};
+      const par::GrainScope grain_scope{grain_size_};
+      if (diagnostics_.has_value()) {
+        diagnostics_->reset();
+        integrator_.step(dt, mesh_, particles_, diagnostics_->observer());
+      } else {
+        integrator_.step(dt, mesh_, particles_);
+      }
+
+      // Exchange the particles through the open boundaries. Exchange
+      // reorders the particles, so the mesh is rebuilt right away.
+      if (open_boundary_.has_value() &&
+          open_boundary_->update(dt, mesh_, particles_)) {
+        integrator_.equations().index(mesh_, particles_);
+      }
+
+      // Refine the particles within the refinement region. Refinement
+      // changes the number of the particles, so the mesh is rebuilt right
+      // away.
+      if constexpr (Refinement) {
+        if (refinement_step_++ % refinement_freq_ == 0 && refine_()) {
+          integrator_.equations().index(mesh_, particles_);
+        }
+      }
+    }
+    last_dt_ = dt;
+    autotuner_.record(stopwatch.total());
+    if (MemoryStats::enabled()) [[unlikely]] record_memory_stats_();
+  }
+
+  void write(real_t time) override {
+    // Samples are written first, so that the new particle write does not
+    // hold the storage lock.
+    flush_probes_();
+    writer_.write(time, particles_);
+  }
+
+  void wait() override {
+    writer_.wait();
+    flush_probes_();
+  }
+
+  void add_gauge(std::span<const real_t> start,
+                 std::span<const real_t> end,
+                 size_t num_points) override {
+    TIT_ASSERT(start.size() == Dim && end.size() == Dim,
+               "Number of the gauge coordinates must match dimension!");
+    Vec<real_t, Dim> start_vec{};
+    Vec<real_t, Dim> end_vec{};
+    for (size_t d = 0; d < Dim; ++d) {
+      start_vec[d] = start[d];
+      end_vec[d] = end[d];
+    }
+    probes_.add_gauge(start_vec, end_vec, num_points);
+    mesh_.set_probes(probes_.points());
+  }
+
+  void set_probe_series(
+      data::DataSeriesView<data::DataStorage> series) override {
+    probe_series_ = series;
+  }
+
+  void sample(real_t time) override {
+    if (!probe_series_.has_value()) {
+      TIT_THROW("Probe data series must be set before sampling.");
+    }
+    probes_.sample(time, mesh_, particles_, integrator_.equations().kernel());
+  }
+
+  void checkpoint(const std::filesystem::path& path,
+                  const SolverProgress& progress) const override {
+    CheckpointWriter writer{path};
+    writer.write("progress", progress);
+    integrator_.checkpoint(writer);
+    particles_.checkpoint(writer);
+    writer.commit();
+  }
+
+  auto restore(const std::filesystem::path& path) -> SolverProgress override {
+    // Pending write may still be reading the particles.
+    writer_.wait();
+    CheckpointReader reader{path};
+    SolverProgress progress{};
+    reader.read("progress", progress);
+    integrator_.restore(reader);
+    particles_.restore(reader);
+    return progress;
+  }
+
+  auto num_mesh_rebuilds() const noexcept -> size_t override {
+    return mesh_.num_rebuilds();
+  }
+
+  auto num_pairs() const noexcept -> size_t override {
+    return mesh_.num_pairs();
+  }
+
+  auto block_imbalance() const -> real_t override {
+    return mesh_.block_imbalance();
+  }
+
+  auto diagnostics() const -> SolverDiagnostics override {
+    if (!diagnostics_.has_value()) {
+      TIT_THROW("Diagnostics must be enabled in the solver configuration.");
+    }
+    const auto fluid = diagnostics_->result();
+    SolverDiagnostics result{
+        .mass = fluid.mass,
+        .kinetic_energy = fluid.kinetic_energy,
+        .potential_energy = fluid.potential_energy,
+        .momentum = {},
+        .max_speed = fluid.max_speed,
+    };
+    for (size_t d = 0; d < Dim; ++d) result.momentum[d] = fluid.momentum[d];
+    return result;
+  }
+
+private:
+
+  using PV = ParticleView<Particles>;
+
+  // Ratio of the particle mass to the initial one, below which the particle
+  // is considered refined.
+  static constexpr real_t RefinedMassRatio_ = 0.99;
+
+  // Setup the open channel along the first axis, see
+  // `SolverConfig::inflow_velocity`.
+  void setup_open_boundary_(const SolverConfig& config) {
+    using Zone = OpenBoundaryZone<Vec<real_t, Dim>>;
+    Vec<real_t, Dim> low{};
+    Vec<real_t, Dim> high{};
+    for (size_t d = 0; d < Dim; ++d) {
+      low[d] = config.domain_low[d];
+      high[d] = config.domain_high[d];
+    }
+    const auto normal = unit<0>(Vec<real_t, Dim>{});
+    open_boundary_.emplace(
+        Zone{.origin = low,
+             .normal = normal,
+             .width = config.open_boundary_width},
+        config.inflow_velocity * normal,
+        Zone{.origin = high,
+             .normal = -normal,
+             .width = config.open_boundary_width});
+  }
+
+  // Setup the particle refinement region, see `SolverConfig::refinement_low`.
+  void setup_refinement_(const SolverConfig& config) {
+    Vec<real_t, Dim> low{};
+    Vec<real_t, Dim> high{};
+    for (size_t d = 0; d < Dim; ++d) {
+      low[d] = config.refinement_low[d];
+      high[d] = config.refinement_high[d];
+    }
+    refinement_region_ = geom::BBox{low, high};
+    refinement_freq_ = config.refinement_freq;
+  }
+
+  // Merge the refined fluid particles that have left the refinement region,
+  // and split the ones that have entered it. Particles lighter than the
+  // initial ones are the split ones, or the partially merged back ones.
+  // Returns true if any particles were merged or split.
+  auto refine_() -> bool {
+    const auto is_refined = [this](PV a) {
+      return m[a] < RefinedMassRatio_ * m_0_;
+    };
+    const auto is_inside = [this](PV a) {
+      for (size_t d = 0; d < Dim; ++d) {
+        if (r[a][d] < refinement_region_.low()[d] ||
+            r[a][d] > refinement_region_.high()[d]) {
+          return false;
+        }
+      }
+      return true;
+    };
+    const auto num_merged =
+        refinement_.merge(particles_, [&is_refined, &is_inside](PV a) {
+          return is_refined(a) && !is_inside(a);
+        });
+    const auto num_split =
+        refinement_.split(particles_, [&is_refined, &is_inside](PV a) {
+          return !is_refined(a) && is_inside(a);
+        });
+    if (num_merged == 0 && num_split == 0) return false;
+    mesh_.invalidate();
+    return true;
+  }
+
+  // Tune the mesh update frequency, the number of the partitioning levels and
+  // the grain size, in that order.
+  void setup_autotuner_(real_t h_0) {
+    autotuner_.add({
+        .name = "mesh_update_freq",
+        .candidates = {1, 2, 5, 10, 20},
+        .initial = integrator_.mesh_update_freq(),
+        .apply =
+            [this](size_t freq) { integrator_.set_mesh_update_freq(freq); },
+        .is_allowed =
+            [h_0, this](size_t freq) {
+              const auto drift = static_cast<real_t>(freq) * last_dt_;
+              return drift * max_speed_() <= h_0;
+            },
+    });
+    autotuner_.add({
+        .name = "num_levels",
+        .candidates = {1, 2, 3},
+        .initial = mesh_.num_levels(),
+        .apply = [this](size_t levels) { mesh_.set_num_levels(levels); },
+    });
+    autotuner_.add({
+        .name = "grain_size",
+        .candidates = {1, 16, 64, 256},
+        .initial = grain_size_,
+        .apply = [this](size_t grain_size) { grain_size_ = grain_size; },
+    });
+  }
+
+  // Record the heap footprint of the solver data structures and the peak
+  // resident set size of the process after the step.
+  void record_memory_stats_() const {
+    particles_.record_memory_stats();
+    mesh_.record_memory_stats();
+    TIT_MEMORY_STATS("TimeIntegrator::scratch", integrator_);
+    MemoryStats::record_step();
+  }
+
+  // Write the buffered gauge samples into the probe data series.
+  void flush_probes_() {
+    if (!probe_series_.has_value() || probes_.num_samples() == 0) return;
+    const auto lock = probe_series_->storage().lock();
+    probes_.flush(*probe_series_);
+  }
+
+  // Maximum speed of the fluid particles.
+  auto max_speed_() -> real_t {
+    // Diagnostics already hold the maximum speed after the last step.
+    if (diagnostics_.has_value()) return diagnostics_->result().max_speed;
+    return sqrt(par::transform_reduce(
+        particles_.fluid(),
+        real_t{0.0},
+        [](real_t x, real_t y) { return std::max(x, y); },
+        [](PV a) { return norm2(v[a]); }));
+  }
+
+  Integrator integrator_;
+  Particles particles_;
+  Mesh mesh_;
+  ParticleWriter<Particles> writer_;
+  ProbeSet<Vec<real_t, Dim>> probes_;
+  std::optional<data::DataSeriesView<data::DataStorage>> probe_series_;
+  std::optional<Diagnostics<Vec<real_t, Dim>>> diagnostics_;
+  std::optional<OpenBoundary<Vec<real_t, Dim>>> open_boundary_;
+  ParticleRefinement refinement_;
+  geom::BBox<Vec<real_t, Dim>> refinement_region_;
+  size_t refinement_freq_ = 1;
+  size_t refinement_step_ = 0;
+  real_t m_0_ = 0.0;
+  // Note: each candidate window should span a few mesh updates.
+  Autotuner autotuner_{/*window=*/40};
+  size_t grain_size_ = 1;
+  real_t last_dt_ = 0.0;
+
+}; // class SolverImpl
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Create a solver with the given number of dimensions and kernel. Equation
+/// of state and time integrator are selected from the configuration.
+///
+/// @note This function is explicitly instantiated in the separate translation
+///       units for each of the supported dimensions and kernels, see below.
+template<size_t Dim, class Kernel>
+auto make_solver(const SolverConfig& config,
+                 data::DataSeriesView<data::DataStorage> series)
+    -> std::unique_ptr<Solver> {
+  // Domain boundary, gravity is directed along the second axis.
+  Vec<real_t, Dim> low{};
+  Vec<real_t, Dim> high{};
+  for (size_t d = 0; d < Dim; ++d) {
+    low[d] = config.domain_low[d];
+    high[d] = config.domain_high[d];
+  }
+  if (config.inflow_velocity > 0.0) {
+    // Walls of the open channel are continued under the buffer zones.
+    low[0] -= config.open_boundary_width;
+    high[0] += config.open_boundary_width;
+  }
+  const DomainBoundary boundary{geom::BBox{low, high},
+                                config.rho_0,
+                                config.cs_0,
+                                unit<1>(Vec<real_t, Dim>{}, -config.g),
+                                config.interp_radius_scale};
+  const auto with_equations = [&config, &series, &boundary](
+                                  auto eos,
+                                  auto viscosity) -> std::unique_ptr<Solver> {
+    const FluidEquations equations{
+        // Standard motion equation.
+        MotionEquation{},
+        // Continuity equation with no source terms.
+        ContinuityEquation{},
+        // Momentum equation with gravity source term.
+        MomentumEquation{
+            // Selected physical viscosity.
+            std::move(viscosity),
+            // δ-SPH artificial viscosity formulation.
+            DeltaSPHArtificialViscosity{config.cs_0, config.rho_0},
+            // Gravity source term.
+            GravitySource{config.g},
+        },
+        // No energy equation.
+        NoEnergyEquation{},
+        // Weakly compressible equation of state.
+        std::move(eos),
+        // Kernel.
+        Kernel{},
+        // Slip walls around the domain.
+        boundary,
+        // Particle shifting with the free surface detection.
+        ParticleShifting{},
+        // Blocked pair loops.
+        PairLoop::blocked,
+        // Kernel width adaptation.
+        config.target_neighbors,
+    };
+    const StageUpdateFreq stage_update_freq{
+        .boundary = config.boundary_update_freq,
+        .renormalization = config.renorm_update_freq,
+    };
+    // Implicit viscosity is only applied by some of the integrators.
+    constexpr bool is_implicit = decltype(viscosity)::is_implicit;
+    const auto with_integrator =
+        [&config, &series](auto integrator) -> std::unique_ptr<Solver> {
+      using Integrator = decltype(integrator);
+      if (config.refinement_low != config.refinement_high) {
+        return std::make_unique<SolverImpl<Dim, Integrator, false, true>>(
+            config,
+            std::move(integrator),
+            series);
+      }
+      if (config.compressed_mesh) {
+        return std::make_unique<SolverImpl<Dim, Integrator, true>>(
+            config,
+            std::move(integrator),
+            series);
+      }
+      return std::make_unique<SolverImpl<Dim, Integrator>>(
+          config,
+          std::move(integrator),
+          series);
+    };
+    if (config.integrator == "kick_drift") {
+      return with_integrator(
+          KickDriftIntegrator{equations, config.mesh_update_freq});
+    }
+    if (config.integrator == "projection") {
+      return with_integrator(
+          ProjectionIntegrator{equations, config.mesh_update_freq});
+    }
+    if constexpr (!is_implicit) {
+      if (config.integrator == "kick_drift_kick") {
+        return with_integrator(
+            KickDriftKickIntegrator{equations,
+                                    config.mesh_update_freq,
+                                    config.fsal});
+      }
+      if (config.integrator == "runge_kutta") {
+        return with_integrator(
+            RungeKuttaIntegrator{equations,
+                                 config.mesh_update_freq,
+                                 stage_update_freq});
+      }
+      if (config.integrator == "low_storage_runge_kutta") {
+        return with_integrator(
+            LowStorageRungeKuttaIntegrator{equations,
+                                           config.mesh_update_freq,
+                                           stage_update_freq});
+      }
+      if (config.integrator == "multi_rate") {
+        return with_integrator(
+            MultiRateIntegrator{equations,
+                                config.num_time_levels,
+                                config.mesh_update_freq});
+      }
+    } else {
+      if (std::ranges::contains(std::array{"kick_drift_kick",
+                                           "runge_kutta",
+                                           "low_storage_runge_kutta",
+                                           "multi_rate"},
+                                config.integrator)) {
+        TIT_THROW("Time integrator '{}' does not support implicit viscosity.",
+                  config.integrator);
+      }
+    }
+    TIT_THROW("Unknown time integrator '{}'.", config.integrator);
+  };
+  const auto with_eos = [&config, &with_equations](
+                            auto eos) -> std::unique_ptr<Solver> {
+    if (config.viscosity == "none") {
+      return with_equations(std::move(eos), NoViscosity{});
+    }
+    if (config.viscosity == "laplacian") {
+      return with_equations(std::move(eos), LaplacianViscosity{});
+    }
+    if (config.viscosity == "implicit_laplacian") {
+      return with_equations(std::move(eos), ImplicitLaplacianViscosity{});
+    }
+    TIT_THROW("Unknown viscosity '{}'.", config.viscosity);
+  };
+  if (config.eos == "linear_tait") {
+    return with_eos(LinearTaitEquationOfState{config.cs_0, config.rho_0});
+  }
+  if (config.eos == "tait") {
+    return with_eos(TaitEquationOfState{config.cs_0, config.rho_0});
+  }
+  TIT_THROW("Unknown equation of state '{}'.", config.eos);
+}
+
+// Supported solver configurations. Each one is instantiated only once, within
+// the corresponding `solver_<dim>d.cpp` translation unit.
+extern template auto make_solver<2, CubicSplineKernel>(
+    const SolverConfig& config,
+    data::DataSeriesView<data::DataStorage> series) -> std::unique_ptr<Solver>;
+extern template auto make_solver<2, QuinticSplineKernel>(
+    const SolverConfig& config,
+    data::DataSeriesView<data::DataStorage> series) -> std::unique_ptr<Solver>;
+extern template auto make_solver<2, QuarticWendlandKernel>(
+    const SolverConfig& config,
+    data::DataSeriesView<data::DataStorage> series) -> std::unique_ptr<Solver>;
+extern template auto make_solver<2, SixthOrderWendlandKernel>(
+    const SolverConfig& config,
+    data::DataSeriesView<data::DataStorage> series) -> std::unique_ptr<Solver>;
+extern template auto make_solver<3, CubicSplineKernel>(
+    const SolverConfig& config,
+    data::DataSeriesView<data::DataStorage> series) -> std::unique_ptr<Solver>;
+extern template auto make_solver<3, QuinticSplineKernel>(
+    const SolverConfig& config,
+    data::DataSeriesView<data::DataStorage> series) -> std::unique_ptr<Solver>;
+extern template auto make_solver<3, QuarticWendlandKernel>(
+    const SolverConfig& config,
+    data::DataSeriesView<data::DataStorage> series) -> std::unique_ptr<Solver>;
+extern template auto make_solver<3, SixthOrderWendlandKernel>(
+    const SolverConfig& config,
+    data::DataSeriesView<data::DataStorage> series) -> std::unique_ptr<Solver>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::sph::impl
@@ -5,18 +5,32 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <optional>
+#include <ranges>
 #include <utility>
+#include <vector>
 
 #include "tit/core/basic_types.hpp"
+#include "tit/core/checks.hpp"
+#include "tit/core/containers/mdvector.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/memory_stats.hpp"
 #include "tit/core/meta.hpp"
 #include "tit/core/par/algorithms.hpp"
 #include "tit/core/profiler.hpp"
+#include "tit/core/vec.hpp"
 
 #include "tit/core/type_utils.hpp"
+#include "tit/sph/checkpoint.hpp"
 #include "tit/sph/field.hpp"
 #include "tit/sph/fluid_equations.hpp"
 #include "tit/sph/particle_array.hpp"
 #include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/particle_sleeping.hpp"
 
 namespace tit::sph {
 
@@ -26,11 +40,118 @@ namespace tit::sph {
 template<class EE>
 concept explicit_equations = specialization_of<EE, FluidEquations>;
 
+/// Observer of the fluid particles at the end of the step, that does nothing.
+///
+/// Observers are called for each fluid particle, once its state of the step
+/// is final, within the last particle pass of the integrator, so that the
+/// per-particle reductions, e.g. `Diagnostics`, need no pass of their own.
+/// They are called concurrently from the worker threads.
+struct NoStepObserver final {
+  template<particle_view PV>
+  constexpr void operator()(PV /*a*/) const noexcept {}
+};
+
+namespace impl {
+
+// Pass each fluid particle to the observer, within a pass of its own.
+template<particle_array ParticleArray, class Observer>
+void observe_step(ParticleArray& particles, const Observer& observer) {
+  using PV = ParticleView<ParticleArray>;
+  if constexpr (!std::same_as<Observer, NoStepObserver>) {
+    par::for_each(particles.fluid(), [&observer](PV a) { observer(a); });
+  }
+}
+
+// Apply the particle shifting, if necessary, and pass each fluid particle to
+// the observer. Observer is fused into the shifting pass, if there is one.
+// Rigid bodies of the boundary, if any, are moved last.
+template<class Equations,
+         particle_mesh ParticleMesh,
+         particle_array ParticleArray,
+         class Observer>
+void finish_step(particle_num_t<ParticleArray> dt,
+                 Equations& equations,
+                 ParticleMesh& mesh,
+                 ParticleArray& particles,
+                 size_t step_index,
+                 const Observer& observer) {
+  using PV = ParticleView<ParticleArray>;
+  using PB = ParticleBatch<ParticleArray>;
+  if constexpr (has<PV>(dr)) {
+    equations.compute_shifts(mesh, particles, step_index);
+    for_each_batch(particles.fluid(), [&observer](PB b) {
+      b.store(r, r[b] + dr[b]);
+      for (size_t i = 0; i < b.size(); ++i) observer(b.array()[b.first() + i]);
+    });
+  } else {
+    observe_step(particles, observer);
+  }
+  equations.move_bodies(dt, mesh, particles);
+}
+
+// Particle mesh update frequency of the time integrators, that is tuned at
+// run time, see `Autotuner`.
+class MeshUpdateFreq {
+public:
+
+  /// Particle mesh update frequency.
+  constexpr auto mesh_update_freq() const noexcept -> size_t {
+    return mesh_update_freq_;
+  }
+
+  /// Set the particle mesh update frequency.
+  constexpr void set_mesh_update_freq(size_t mesh_update_freq) noexcept {
+    TIT_ASSERT(mesh_update_freq > 0, "Mesh update frequency must be positive!");
+    mesh_update_freq_ = mesh_update_freq;
+  }
+
+protected:
+
+  constexpr explicit MeshUpdateFreq(size_t mesh_update_freq) noexcept
+      : mesh_update_freq_{mesh_update_freq} {}
+
+private:
+
+  size_t mesh_update_freq_;
+
+}; // class MeshUpdateFreq
+
+// Step index of the time integrators, that is written into the checkpoints.
+// Particle mesh is not stored in the checkpoint, so restoring the step index
+// requests the mesh to be rebuilt on the next step.
+class StepIndex {
+public:
+
+  /// Write the integrator state into a checkpoint.
+  void checkpoint(CheckpointWriter& writer) const {
+    writer.write("step_index", step_index_);
+  }
+
+  /// Restore the integrator state from a checkpoint. Particle mesh is not
+  /// stored in the checkpoint, so it is rebuilt on the next step.
+  void restore(CheckpointReader& reader) {
+    reader.read("step_index", step_index_);
+    reindex_ = true;
+  }
+
+protected:
+
+  constexpr StepIndex() noexcept = default;
+
+  size_t step_index_ = 0;
+  bool reindex_ = false;
+
+}; // class StepIndex
+
+} // namespace impl
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Kick-Drift Euler time integrator.
 template<explicit_equations Equations>
-class KickDriftIntegrator final {
+class KickDriftIntegrator final :
+    public impl::MeshUpdateFreq,
+    public impl::StepIndex {
 public:
 
   /// Set of particle fields that are required.
@@ -41,25 +162,44 @@ public:
   static constexpr auto modified_fields =
       Equations::modified_fields | meta::Set{parinfo, r, v, u, alpha};
 
+  /// Set of particle fields that the pair loops read together.
+  static constexpr auto pair_fields = Equations::pair_fields;
+
   /// Construct time integrator.
   ///
   /// @param equations Equations to integrate.
+  /// @param mesh_update_freq Particle mesh update frequency. Meshes with a
+  ///                         search radius skin skip the redundant updates,
+  ///                         so the frequency of one could be used with them.
   constexpr explicit KickDriftIntegrator(Equations equations,
                                          size_t mesh_update_freq = 10) noexcept
-      : equations_{std::move(equations)}, mesh_update_freq_{mesh_update_freq} {}
+      : MeshUpdateFreq{mesh_update_freq}, equations_{std::move(equations)} {}
+
+  /// Fluid equations.
+  constexpr auto equations() const noexcept -> const Equations& {
+    return equations_;
+  }
 
-  /// Make a step in time.
+  /// Make a step in time. Observer is called for each fluid particle at
+  /// the end of the step, see `NoStepObserver`.
   template<particle_mesh ParticleMesh,
-           particle_array<required_fields> ParticleArray>
+           particle_array<required_fields> ParticleArray,
+           class Observer = NoStepObserver>
   void step(particle_num_t<ParticleArray> dt,
             ParticleMesh& mesh,
-            ParticleArray& particles) {
+            ParticleArray& particles,
+            const Observer& observer = {}) {
     TIT_PROFILE_SECTION("EulerIntegrator::step()");
     using PV = ParticleView<ParticleArray>;
+    using PB = ParticleBatch<ParticleArray>;
+    using Reg = PB::Reg;
 
     // Initialize particles, build the mesh.
     if (step_index_ == 0) equations_.init(particles);
-    if (step_index_ % mesh_update_freq_ == 0) equations_.index(mesh, particles);
+    if (step_index_ % mesh_update_freq() == 0 || reindex_) {
+      equations_.index(mesh, particles);
+      reindex_ = false;
+    }
 
     // Setup boundary conditions.
     equations_.setup_boundary(mesh, particles);
@@ -67,34 +207,64 @@ public:
     // Update particle density.
     equations_.compute_density(mesh, particles);
     if constexpr (has<PV>(drho_dt)) {
-      par::for_each(particles.fluid(),
-                    [dt](PV a) { rho[a] += dt * drho_dt[a]; });
+      for_each_batch(particles.fluid(), [dt = Reg{dt}](PB b) {
+        b.store(rho, rho[b] + dt * drho_dt[b]);
+      });
     }
 
     // Update particle velocty, internal energy, etc.
     equations_.compute_forces(mesh, particles);
-    par::for_each(particles.fluid(), [dt](PV a) {
-      v[a] += dt * dv_dt[a];
-      r[a] += dt * v[a]; // Kick-Drift: position is updated after velocity.
-      if constexpr (has<PV>(u, du_dt)) u[a] += dt * du_dt[a];
-      if constexpr (has<PV>(alpha, dalpha_dt)) alpha[a] += dt * dalpha_dt[a];
+    for_each_batch(particles.fluid(), [dt = Reg{dt}](PB b) {
+      const auto v_b = v[b] + dt * dv_dt[b];
+      b.store(v, v_b);
+      if constexpr (!Equations::has_implicit_viscosity) {
+        b.store(r, r[b] + dt * v_b); // Kick-Drift: position is updated last.
+      }
+      if constexpr (has<PV>(u, du_dt)) b.store(u, u[b] + dt * du_dt[b]);
+      if constexpr (has<PV>(alpha, dalpha_dt)) {
+        b.store(alpha, alpha[b] + dt * dalpha_dt[b]);
+      }
     });
 
-    // Apply particle shifting.
-    if constexpr (has<PV>(dr)) {
-      equations_.compute_shifts(mesh, particles);
-      par::for_each(particles.fluid(), [](PV a) { r[a] += dr[a]; });
+    // Apply the implicit viscosity, before the positions are updated.
+    if constexpr (Equations::has_implicit_viscosity) {
+      equations_.apply_implicit_viscosity(dt, mesh, particles);
+      for_each_batch(particles.fluid(), [dt = Reg{dt}](PB b) {
+        b.store(r, r[b] + dt * v[b]);
+      });
     }
 
+    // Apply particle shifting, if necessary, and observe the particles.
+    impl::finish_step(dt,
+                      equations_,
+                      mesh,
+                      particles,
+                      step_index_,
+                      observer);
+
     // Increment step index.
     step_index_ += 1;
   }
 
+  /// Make a step in time with the maximum stable time step.
+  ///
+  /// @param max_dt Upper bound of the time step.
+  ///
+  /// @returns Time step that was made.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  auto adaptive_step(particle_num_t<ParticleArray> max_dt,
+                     ParticleMesh& mesh,
+                     ParticleArray& particles)
+      -> particle_num_t<ParticleArray> {
+    const auto dt = equations_.time_step(particles, max_dt);
+    step(dt, mesh, particles);
+    return dt;
+  }
+
 private:
 
   [[no_unique_address]] Equations equations_{};
-  size_t mesh_update_freq_;
-  size_t step_index_ = 0;
 
 }; // class KickDriftIntegrator
 
@@ -102,9 +272,14 @@ private:
 
 /// Kick-Drift-Kick Leapfrog time integrator.
 template<explicit_equations Equations>
-class KickDriftKickIntegrator final {
+class KickDriftKickIntegrator final :
+    public impl::MeshUpdateFreq,
+    public impl::StepIndex {
 public:
 
+  static_assert(!Equations::has_implicit_viscosity,
+                "Implicit viscosity is not supported by this integrator!");
+
   /// Set of particle fields that are required.
   static constexpr auto required_fields =
       Equations::required_fields | meta::Set{parinfo, r, v, dv_dt};
@@ -113,81 +288,197 @@ public:
   static constexpr auto modified_fields =
       Equations::modified_fields | meta::Set{parinfo, r, v, u, alpha};
 
+  /// Set of particle fields that the pair loops read together.
+  static constexpr auto pair_fields = Equations::pair_fields;
+
   /// Construct time integrator.
   ///
   /// @param equations Equations to integrate.
-  constexpr explicit KickDriftKickIntegrator(
-      Equations equations,
-      size_t mesh_update_freq = 10) noexcept
-      : equations_{std::move(equations)}, mesh_update_freq_{mesh_update_freq} {}
+  /// @param mesh_update_freq Particle mesh update frequency. Meshes with a
+  ///                         search radius skin skip the redundant updates,
+  ///                         so the frequency of one could be used with them.
+  /// @param fsal Reuse the forces of the last kick of the previous step for
+  ///             the first kick ("first same as last"), unless the particle
+  ///             mesh was rebuilt or the particles were added or removed.
+  ///             Halves the number of the force evaluations, at the cost of
+  ///             ignoring the particle shifting and the boundary update in
+  ///             the reused forces.
+  constexpr explicit KickDriftKickIntegrator(Equations equations,
+                                             size_t mesh_update_freq = 10,
+                                             bool fsal = false) noexcept
+      : MeshUpdateFreq{mesh_update_freq}, equations_{std::move(equations)},
+        fsal_{fsal} {}
 
-  /// Make a step in time.
+  /// Fluid equations.
+  constexpr auto equations() const noexcept -> const Equations& {
+    return equations_;
+  }
+
+  /// Make a step in time. Observer is called for each fluid particle at
+  /// the end of the step, see `NoStepObserver`.
   template<particle_mesh ParticleMesh,
-           particle_array<required_fields> ParticleArray>
+           particle_array<required_fields> ParticleArray,
+           class Observer = NoStepObserver>
   void step(particle_num_t<ParticleArray> dt,
             ParticleMesh& mesh,
-            ParticleArray& particles) {
+            ParticleArray& particles,
+            const Observer& observer = {}) {
     TIT_PROFILE_SECTION("LeapfrogIntegrator::step()");
     using PV = ParticleView<ParticleArray>;
+    using PB = ParticleBatch<ParticleArray>;
+    using Reg = PB::Reg;
 
     // Initialize and index particles.
     if (step_index_ == 0) equations_.init(particles);
-    if (step_index_ % mesh_update_freq_ == 0) equations_.index(mesh, particles);
+    if (step_index_ % mesh_update_freq() == 0 || reindex_) {
+      equations_.index(mesh, particles);
+      reindex_ = false;
+    }
 
     // Setup boundary conditions.
     equations_.setup_boundary(mesh, particles);
 
     // Update particle velocity to the half step, and position to the full
-    // step.
+    // step. Forces of the previous step are reused, if possible.
     const auto dt_2 = dt / 2;
-    equations_.compute_forces(mesh, particles);
-    par::for_each(particles.fluid(), [dt, dt_2](PV a) {
-      v[a] += dt_2 * dv_dt[a];
-      r[a] += dt * v[a]; // Kick-Drift: position is updated after velocity.
-      if constexpr (has<PV>(u, du_dt)) u[a] += dt_2 * du_dt[a];
-      if constexpr (has<PV>(alpha, dalpha_dt)) alpha[a] += dt_2 * dalpha_dt[a];
+    const auto fsal_state = fsal_state_(mesh, particles);
+    if (!fsal_ || fsal_state != last_fsal_state_) {
+      equations_.compute_forces(mesh, particles);
+    }
+    for_each_batch(particles.fluid(), [dt = Reg{dt}, dt_2 = Reg{dt_2}](PB b) {
+      const auto v_b = v[b] + dt_2 * dv_dt[b];
+      b.store(v, v_b);
+      b.store(r, r[b] + dt * v_b); // Kick-Drift: position is updated last.
+      if constexpr (has<PV>(u, du_dt)) b.store(u, u[b] + dt_2 * du_dt[b]);
+      if constexpr (has<PV>(alpha, dalpha_dt)) {
+        b.store(alpha, alpha[b] + dt_2 * dalpha_dt[b]);
+      }
     });
 
     // Update particle velocity to the full step.
     equations_.compute_density(mesh, particles);
     if constexpr (has<PV>(drho_dt)) {
-      par::for_each(particles.fluid(),
-                    [dt](PV a) { rho[a] += dt * drho_dt[a]; });
+      for_each_batch(particles.fluid(), [dt = Reg{dt}](PB b) {
+        b.store(rho, rho[b] + dt * drho_dt[b]);
+      });
     }
 
     // Update particle velocity to the full step.
     equations_.compute_forces(mesh, particles);
-    par::for_each(particles.fluid(), [dt_2](PV a) {
-      v[a] += dt_2 * dv_dt[a]; // Kick.
-      if constexpr (has<PV>(u, du_dt)) u[a] += dt_2 * du_dt[a];
-      if constexpr (has<PV>(alpha, dalpha_dt)) alpha[a] += dt_2 * dalpha_dt[a];
+    for_each_batch(particles.fluid(), [dt_2 = Reg{dt_2}](PB b) {
+      b.store(v, v[b] + dt_2 * dv_dt[b]); // Kick.
+      if constexpr (has<PV>(u, du_dt)) b.store(u, u[b] + dt_2 * du_dt[b]);
+      if constexpr (has<PV>(alpha, dalpha_dt)) {
+        b.store(alpha, alpha[b] + dt_2 * dalpha_dt[b]);
+      }
     });
+    last_fsal_state_ = fsal_state;
 
-    // Apply particle shifting, if necessary.
-    if constexpr (has<PV>(dr)) {
-      equations_.compute_shifts(mesh, particles);
-      par::for_each(particles.fluid(), [](PV a) { r[a] += dr[a]; });
-    }
+    // Apply particle shifting, if necessary, and observe the particles.
+    impl::finish_step(dt,
+                      equations_,
+                      mesh,
+                      particles,
+                      step_index_,
+                      observer);
 
     // Increment step index.
     step_index_ += 1;
   }
 
+  /// Make a step in time with the maximum stable time step.
+  ///
+  /// @param max_dt Upper bound of the time step.
+  ///
+  /// @returns Time step that was made.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  auto adaptive_step(particle_num_t<ParticleArray> max_dt,
+                     ParticleMesh& mesh,
+                     ParticleArray& particles)
+      -> particle_num_t<ParticleArray> {
+    const auto dt = equations_.time_step(particles, max_dt);
+    step(dt, mesh, particles);
+    return dt;
+  }
+
+  /// Restore the integrator state from a checkpoint. Forces of the last
+  /// step are not stored in the checkpoint, so they are not reused.
+  void restore(CheckpointReader& reader) {
+    StepIndex::restore(reader);
+    last_fsal_state_ = std::nullopt;
+  }
+
 private:
 
+  // State of the particles, that must not change for the forces to be
+  // reused: the number of the mesh rebuilds and the particle counts.
+  struct FSALState_ final {
+    size_t num_rebuilds = 0;
+    size_t num_particles = 0;
+    size_t num_fluid = 0;
+
+    constexpr auto operator==(const FSALState_&) const noexcept
+        -> bool = default;
+  };
+
+  // Current FSAL state.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  static constexpr auto fsal_state_(const ParticleMesh& mesh,
+                                    ParticleArray& particles) -> FSALState_ {
+    return {.num_rebuilds = mesh.num_rebuilds(),
+            .num_particles = particles.size(),
+            .num_fluid = std::ranges::size(particles.fluid())};
+  }
+
   [[no_unique_address]] Equations equations_{};
-  size_t mesh_update_freq_;
-  size_t step_index_ = 0;
+  bool fsal_;
+  std::optional<FSALState_> last_fsal_state_;
 
 }; // class KickDriftKickIntegrator
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Update frequencies of the slowly changing fields in the multi-stage
+/// integrators. With zero frequency, the fields are updated on each stage.
+/// With positive frequency `K`, the fields are updated only on the first
+/// stage of each `K`-th step, and of each step with the particle mesh update,
+/// and are reused otherwise.
+struct StageUpdateFreq final {
+  /// Update frequency of the boundary ghost values.
+  size_t boundary = 0;
+
+  /// Update frequency of the density gradient and renormalization fields.
+  size_t renormalization = 0;
+
+  /// Should the fields with the given update frequency be updated?
+  ///
+  /// @param freq       Update frequency.
+  /// @param step_index Index of the current step.
+  /// @param stage      Index of the current stage within the step.
+  /// @param indexed    Was the particle mesh updated on the current step?
+  static constexpr auto is_update(size_t freq,
+                                  size_t step_index,
+                                  size_t stage,
+                                  bool indexed) noexcept -> bool {
+    if (freq == 0) return true;
+    return stage == 0 && (indexed || step_index % freq == 0);
+  }
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /// Runge-Kutta time integrator (SSPRK(3,3)).
 template<explicit_equations Equations>
-class RungeKuttaIntegrator final {
+class RungeKuttaIntegrator final :
+    public impl::MeshUpdateFreq,
+    public impl::StepIndex {
 public:
 
+  static_assert(!Equations::has_implicit_viscosity,
+                "Implicit viscosity is not supported by this integrator!");
+
   /// Set of particle fields that are required.
   static constexpr auto required_fields =
       Equations::required_fields | meta::Set{parinfo, r, v, dv_dt};
@@ -196,97 +487,934 @@ public:
   static constexpr auto modified_fields =
       Equations::modified_fields | meta::Set{parinfo, r, v, u, alpha};
 
+  /// Set of particle fields that the pair loops read together.
+  static constexpr auto pair_fields = Equations::pair_fields;
+
   /// Construct time integrator.
-  constexpr explicit RungeKuttaIntegrator(Equations equations,
-                                          size_t mesh_update_freq = 10) noexcept
-      : equations_{std::move(equations)}, mesh_update_freq_{mesh_update_freq} {}
+  ///
+  /// @param equations Equations to integrate.
+  /// @param mesh_update_freq Particle mesh update frequency. Meshes with a
+  ///                         search radius skin skip the redundant updates,
+  ///                         so the frequency of one could be used with them.
+  /// @param stage_update_freq Update frequencies of the slowly changing
+  ///                          fields.
+  constexpr explicit RungeKuttaIntegrator(
+      Equations equations,
+      size_t mesh_update_freq = 10,
+      StageUpdateFreq stage_update_freq = {}) noexcept
+      : MeshUpdateFreq{mesh_update_freq}, equations_{std::move(equations)},
+        stage_update_freq_{stage_update_freq} {}
 
-  /// Make a step in time.
+  /// Fluid equations.
+  constexpr auto equations() const noexcept -> const Equations& {
+    return equations_;
+  }
+
+  /// Make a step in time. Observer is called for each fluid particle at
+  /// the end of the step, see `NoStepObserver`.
   template<particle_mesh ParticleMesh,
-           particle_array<required_fields> ParticleArray>
+           particle_array<required_fields> ParticleArray,
+           class Observer = NoStepObserver>
   void step(particle_num_t<ParticleArray> dt,
             ParticleMesh& mesh,
-            ParticleArray& particles) {
+            ParticleArray& particles,
+            const Observer& observer = {}) {
     TIT_PROFILE_SECTION("RungeKuttaIntegrator::step()");
-    using PV = ParticleView<ParticleArray>;
 
     // Initialize and index particles.
     if (step_index_ == 0) equations_.init(particles);
-    if (step_index_ % mesh_update_freq_ == 0) equations_.index(mesh, particles);
+    const auto indexed = step_index_ % mesh_update_freq() == 0 || reindex_;
+    if (indexed) {
+      equations_.index(mesh, particles);
+      reindex_ = false;
+    }
 
     // Run the SSPRK(3,3) substeps.
-    /// @todo We should copy only the needed fields, and not the whole array.
-    const auto old_particles(particles);
-    substep_(dt, mesh, particles);
-    substep_(dt, mesh, particles);
-    lincomb_(0.75, old_particles, 0.25, particles);
-    substep_(dt, mesh, particles);
-    lincomb_(1.0 / 3.0, old_particles, 2.0 / 3.0, particles);
-
-    // Apply particle shifting, if necessary.
-    if constexpr (has<PV>(dr)) {
-      equations_.compute_shifts(mesh, particles);
-      par::for_each(particles.fluid(), [](PV a) { r[a] += dr[a]; });
-    }
+    save_state_(particles);
+    substep_(dt, 0, indexed, mesh, particles);
+    substep_(dt, 1, indexed, mesh, particles);
+    lincomb_(0.75, 0.25, particles);
+    substep_(dt, 2, indexed, mesh, particles);
+    lincomb_(1.0 / 3.0, 2.0 / 3.0, particles);
+
+    // Apply particle shifting, if necessary, and observe the particles.
+    impl::finish_step(dt,
+                      equations_,
+                      mesh,
+                      particles,
+                      step_index_,
+                      observer);
 
     // Increment step index.
     step_index_ += 1;
   }
 
+  /// Make a step in time with the maximum stable time step.
+  ///
+  /// @param max_dt Upper bound of the time step.
+  ///
+  /// @returns Time step that was made.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  auto adaptive_step(particle_num_t<ParticleArray> max_dt,
+                     ParticleMesh& mesh,
+                     ParticleArray& particles)
+      -> particle_num_t<ParticleArray> {
+    const auto dt = equations_.time_step(particles, max_dt);
+    step(dt, mesh, particles);
+    return dt;
+  }
+
+  /// Number of bytes of the integrator scratch allocated on the heap.
+  auto heap_bytes() const noexcept -> size_t {
+    return tit::heap_bytes(state_);
+  }
+
 private:
 
   // Do an explicit Euler substep.
   template<particle_mesh ParticleMesh,
            particle_array<required_fields> ParticleArray>
   void substep_(particle_num_t<ParticleArray> dt,
+                size_t stage,
+                bool indexed,
                 ParticleMesh& mesh,
                 ParticleArray& particles) {
     using PV = ParticleView<ParticleArray>;
+    using PB = ParticleBatch<ParticleArray>;
+    using Reg = PB::Reg;
 
     // Calculate right hand sides for the given particle array.
-    equations_.setup_boundary(mesh, particles);
-    equations_.compute_density(mesh, particles);
-    equations_.compute_forces(mesh, particles);
+    compute_rates_(stage, indexed, mesh, particles);
 
     // Integrate.
-    par::for_each(particles.fluid(), [dt](PV a) {
-      r[a] += dt * v[a]; // Drift-Kick: position is updated before velocity.
-      v[a] += dt * dv_dt[a];
-      if constexpr (has<PV>(drho_dt)) rho[a] += dt * drho_dt[a];
-      if constexpr (has<PV>(u, du_dt)) u[a] += dt * du_dt[a];
-      if constexpr (has<PV>(alpha, dalpha_dt)) alpha[a] += dt * dalpha_dt[a];
+    for_each_batch(particles.fluid(), [dt = Reg{dt}](PB b) {
+      const auto v_b = v[b];
+      b.store(r, r[b] + dt * v_b); // Drift-Kick: position is updated first.
+      b.store(v, v_b + dt * dv_dt[b]);
+      if constexpr (has<PV>(drho_dt)) b.store(rho, rho[b] + dt * drho_dt[b]);
+      if constexpr (has<PV>(u, du_dt)) b.store(u, u[b] + dt * du_dt[b]);
+      if constexpr (has<PV>(alpha, dalpha_dt)) {
+        b.store(alpha, alpha[b] + dt * dalpha_dt[b]);
+      }
     });
   }
 
-  // Compute the linear combination of the two substeps.
+  // Setup the boundary conditions and calculate the right hand sides on the
+  // given stage, updating the slowly changing fields only when needed.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void compute_rates_(size_t stage,
+                      bool indexed,
+                      ParticleMesh& mesh,
+                      ParticleArray& particles) {
+    const auto is_update = [stage, indexed, this](size_t freq) {
+      return StageUpdateFreq::is_update(freq, step_index_, stage, indexed);
+    };
+    if (is_update(stage_update_freq_.boundary)) {
+      equations_.setup_boundary(mesh, particles);
+    }
+    equations_.compute_rates(mesh,
+                             particles,
+                             is_update(stage_update_freq_.renormalization));
+  }
+
+  // Fields that are integrated in time.
+  static constexpr auto state_fields = meta::Set{r, v, rho, u, alpha};
+
+  // Save the integrated fields of the fluid particles into the state buffer.
+  template<particle_array<required_fields> ParticleArray>
+  void save_state_(ParticleArray& particles) {
+    using PV = ParticleView<ParticleArray>;
+    static constexpr auto fields = state_fields & PV::fields;
+    size_t state_size = 0;
+    fields.for_each([&state_size](auto f) {
+      using Val = particle_field_t<decltype(f){}, PV>;
+      if constexpr (is_vec_v<Val>) state_size += vec_dim_v<Val>;
+      else state_size += 1;
+    });
+    state_.assign(particles.size(), state_size);
+    const auto fluid_views = column_views(particles.fluid(), fields);
+    par::for_each(fluid_views, [this](auto a) {
+      size_t offset = 0;
+      fields.for_each([a, &offset, this](auto f) {
+        using Val = particle_field_t<decltype(f){}, PV>;
+        if constexpr (is_vec_v<Val>) {
+          for (size_t i = 0; i < vec_dim_v<Val>; ++i) {
+            state_[a.index(), offset++] = static_cast<real_t>(f[a][i]);
+          }
+        } else {
+          state_[a.index(), offset++] = static_cast<real_t>(f[a]);
+        }
+      });
+    });
+  }
+
+  // Compute the linear combination of the saved state and the current
+  // substep.
   template<particle_array<required_fields> ParticleArray>
   void lincomb_(particle_num_t<ParticleArray> weight,
-                const ParticleArray& particles,
                 particle_num_t<ParticleArray> out_weight,
-                ParticleArray& out_particles) {
+                ParticleArray& particles) {
     using PV = ParticleView<ParticleArray>;
-    par::for_each( //
-        out_particles.fluid(),
-        [out_weight, weight, &particles](PV out_a) {
-          const auto a = particles[out_a.index()];
-          r[out_a] = weight * r[a] + out_weight * r[out_a];
-          v[out_a] = weight * v[a] + out_weight * v[out_a];
-          rho[out_a] = weight * rho[a] + out_weight * rho[out_a];
-          if constexpr (has<PV>(u)) {
-            u[out_a] = weight * u[a] + out_weight * u[out_a];
-          }
-          if constexpr (has<PV>(alpha)) {
-            alpha[out_a] = weight * alpha[a] + out_weight * alpha[out_a];
+    static constexpr auto fields = state_fields & PV::fields;
+    const auto fluid_views = column_views(particles.fluid(), fields);
+    par::for_each(fluid_views, [weight, out_weight, this](auto a) {
+      size_t offset = 0;
+      fields.for_each([a, weight, out_weight, &offset, this](auto f) {
+        using Val = particle_field_t<decltype(f){}, PV>;
+        Val old_val{};
+        if constexpr (is_vec_v<Val>) {
+          using Num = vec_num_t<Val>;
+          for (size_t i = 0; i < vec_dim_v<Val>; ++i) {
+            old_val[i] = static_cast<Num>(state_[a.index(), offset++]);
           }
-        });
+        } else {
+          old_val = static_cast<Val>(state_[a.index(), offset++]);
+        }
+        f[a] = weight * old_val + out_weight * f[a];
+      });
+    });
   }
 
   [[no_unique_address]] Equations equations_;
-  size_t mesh_update_freq_;
-  size_t step_index_ = 0;
+  StageUpdateFreq stage_update_freq_;
+  Mdvector<real_t, 2> state_;
 
 }; // class RungeKuttaIntegrator
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/// Williamson (1980) three-stage third-order low-storage Runge-Kutta scheme.
+struct Williamson3 final {
+  /// Register weights.
+  static constexpr std::array<real_t, 3> a{0.0, -5.0 / 9.0, -153.0 / 128.0};
+
+  /// Stage weights.
+  static constexpr std::array<real_t, 3> b{1.0 / 3.0, 15.0 / 16.0, 8.0 / 15.0};
+};
+
+/// Carpenter and Kennedy (1994) five-stage fourth-order low-storage
+/// Runge-Kutta scheme, RK4(3)5[2R+]C.
+struct CarpenterKennedy4 final {
+  /// Register weights.
+  static constexpr std::array<real_t, 5> a{
+      0.0,
+      -567301805773.0 / 1357537059087.0,
+      -2404267990393.0 / 2016746695238.0,
+      -3550918686646.0 / 2091501179385.0,
+      -1275806237668.0 / 842570457699.0,
+  };
+
+  /// Stage weights.
+  static constexpr std::array<real_t, 5> b{
+      1432997174477.0 / 9575080441755.0,
+      5161836677717.0 / 13612068292357.0,
+      1720146321549.0 / 2090206949498.0,
+      3134564353537.0 / 4481467310338.0,
+      2277821191437.0 / 14882151754819.0,
+  };
+};
+
+/// Low-storage Runge-Kutta scheme type.
+template<class Scheme>
+concept low_storage_scheme = requires {
+  Scheme::a;
+  Scheme::b;
+  requires Scheme::a.size() == Scheme::b.size();
+};
+
+/// Low-storage (2N) Runge-Kutta time integrator.
+///
+/// Each stage updates the register and the state as `dq = a * dq + dt * f(q)`
+/// and `q += b * dq`, so only a single register per integrated field is
+/// needed, regardless of the number of stages.
+template<explicit_equations Equations,
+         low_storage_scheme Scheme = CarpenterKennedy4>
+class LowStorageRungeKuttaIntegrator final :
+    public impl::MeshUpdateFreq,
+    public impl::StepIndex {
+public:
+
+  static_assert(!Equations::has_implicit_viscosity,
+                "Implicit viscosity is not supported by this integrator!");
+
+  /// Set of particle fields that are required.
+  static constexpr auto required_fields =
+      Equations::required_fields | meta::Set{parinfo, r, v, dv_dt};
+
+  /// Set of particle fields that are modified.
+  static constexpr auto modified_fields =
+      Equations::modified_fields | meta::Set{parinfo, r, v, u, alpha};
+
+  /// Set of particle fields that the pair loops read together.
+  static constexpr auto pair_fields = Equations::pair_fields;
+
+  /// Construct time integrator.
+  ///
+  /// @param equations Equations to integrate.
+  /// @param mesh_update_freq Particle mesh update frequency. Meshes with a
+  ///                         search radius skin skip the redundant updates,
+  ///                         so the frequency of one could be used with them.
+  /// @param stage_update_freq Update frequencies of the slowly changing
+  ///                          fields.
+  /// @param scheme Low-storage Runge-Kutta scheme.
+  constexpr explicit LowStorageRungeKuttaIntegrator(
+      Equations equations,
+      size_t mesh_update_freq = 10,
+      StageUpdateFreq stage_update_freq = {},
+      [[maybe_unused]] Scheme scheme = {}) noexcept
+      : MeshUpdateFreq{mesh_update_freq}, equations_{std::move(equations)},
+        stage_update_freq_{stage_update_freq} {}
+
+  /// Fluid equations.
+  constexpr auto equations() const noexcept -> const Equations& {
+    return equations_;
+  }
+
+  /// Make a step in time. Observer is called for each fluid particle at
+  /// the end of the step, see `NoStepObserver`.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Observer = NoStepObserver>
+  void step(particle_num_t<ParticleArray> dt,
+            ParticleMesh& mesh,
+            ParticleArray& particles,
+            const Observer& observer = {}) {
+    TIT_PROFILE_SECTION("LowStorageRungeKuttaIntegrator::step()");
+    using PV = ParticleView<ParticleArray>;
+
+    // Initialize and index particles.
+    if (step_index_ == 0) equations_.init(particles);
+    const auto indexed = step_index_ % mesh_update_freq() == 0 || reindex_;
+    if (indexed) {
+      equations_.index(mesh, particles);
+      reindex_ = false;
+    }
+
+    // Run the stages. First register weight is zero, so the register is
+    // never read before it is written within the step.
+    static_assert(Scheme::a[0] == 0.0);
+    register_.assign(particles.size(), register_size_<PV>());
+    for (size_t k = 0; k < Scheme::a.size(); ++k) {
+      stage_(dt, k, indexed, mesh, particles);
+    }
+
+    // Apply particle shifting, if necessary, and observe the particles.
+    impl::finish_step(dt,
+                      equations_,
+                      mesh,
+                      particles,
+                      step_index_,
+                      observer);
+
+    // Increment step index.
+    step_index_ += 1;
+  }
+
+  /// Make a step in time with the maximum stable time step.
+  ///
+  /// @param max_dt Upper bound of the time step.
+  ///
+  /// @returns Time step that was made.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  auto adaptive_step(particle_num_t<ParticleArray> max_dt,
+                     ParticleMesh& mesh,
+                     ParticleArray& particles)
+      -> particle_num_t<ParticleArray> {
+    const auto dt = equations_.time_step(particles, max_dt);
+    step(dt, mesh, particles);
+    return dt;
+  }
+
+  /// Number of bytes of the integrator scratch allocated on the heap.
+  auto heap_bytes() const noexcept -> size_t {
+    return tit::heap_bytes(register_);
+  }
+
+private:
+
+  // Setup the boundary conditions and calculate the right hand sides on the
+  // given stage, updating the slowly changing fields only when needed.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void compute_rates_(size_t stage,
+                      bool indexed,
+                      ParticleMesh& mesh,
+                      ParticleArray& particles) {
+    const auto is_update = [stage, indexed, this](size_t freq) {
+      return StageUpdateFreq::is_update(freq, step_index_, stage, indexed);
+    };
+    if (is_update(stage_update_freq_.boundary)) {
+      equations_.setup_boundary(mesh, particles);
+    }
+    equations_.compute_rates(mesh,
+                             particles,
+                             is_update(stage_update_freq_.renormalization));
+  }
+
+  // Fields that are integrated in time, along with their rates.
+  static constexpr auto state_fields =
+      meta::Set{r, v, dv_dt, rho, drho_dt, u, du_dt, alpha, dalpha_dt};
+
+  // Number of the register values per particle.
+  template<particle_view PV>
+  static constexpr auto register_size_() noexcept -> size_t {
+    size_t size = 2 * particle_dim_v<PV>;
+    if constexpr (has<PV>(drho_dt)) size += 1;
+    if constexpr (has<PV>(u, du_dt)) size += 1;
+    if constexpr (has<PV>(alpha, dalpha_dt)) size += 1;
+    return size;
+  }
+
+  // Do a single stage of the scheme.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void stage_(particle_num_t<ParticleArray> dt,
+              size_t k,
+              bool indexed,
+              ParticleMesh& mesh,
+              ParticleArray& particles) {
+    using PV = ParticleView<ParticleArray>;
+    static constexpr auto fields = state_fields & PV::fields;
+
+    // Calculate right hand sides for the given particle array.
+    compute_rates_(k, indexed, mesh, particles);
+
+    // Update the registers and the integrated fields. Position is updated
+    // first, since its rate is the velocity.
+    const auto fluid_views = column_views(particles.fluid(), fields);
+    par::for_each(fluid_views, [dt, k, this](auto a) {
+      size_t offset = 0;
+      const auto advance = [a, dt, k, &offset, this](auto& val,
+                                                     const auto& rate) {
+        advance_(a.index(), offset, dt, k, val, rate);
+      };
+      advance(r[a], v[a]);
+      advance(v[a], dv_dt[a]);
+      if constexpr (has<PV>(drho_dt)) advance(rho[a], drho_dt[a]);
+      if constexpr (has<PV>(u, du_dt)) advance(u[a], du_dt[a]);
+      if constexpr (has<PV>(alpha, dalpha_dt)) advance(alpha[a], dalpha_dt[a]);
+    });
+  }
+
+  // Update the register of the value and the value itself.
+  template<class Val>
+  void advance_(size_t index,
+                size_t& offset,
+                real_t dt,
+                size_t k,
+                Val& val,
+                const Val& rate) {
+    if constexpr (is_vec_v<Val>) {
+      for (size_t i = 0; i < vec_dim_v<Val>; ++i) {
+        advance_(index, offset, dt, k, val[i], rate[i]);
+      }
+    } else {
+      auto& reg = register_[index, offset++];
+      const auto scaled_rate = dt * static_cast<real_t>(rate);
+      reg = k == 0 ? scaled_rate : Scheme::a[k] * reg + scaled_rate;
+      val += static_cast<Val>(Scheme::b[k] * reg);
+    }
+  }
+
+  [[no_unique_address]] Equations equations_;
+  StageUpdateFreq stage_update_freq_;
+  Mdvector<real_t, 2> register_;
+
+}; // class LowStorageRungeKuttaIntegrator
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Multi-rate Kick-Drift integrator with hierarchical block time stepping.
+///
+/// At the beginning of each step, particles are assigned to the power-of-two
+/// time step levels according to their stability limits. Levels of the
+/// neighboring particles differ by at most one, so that a fast particle never
+/// interacts with the much slower ones. The step is split into the substeps
+/// of the smallest time step. All the particles are drifted on each substep,
+/// but only the active ones, whose own time step starts on the substep, are
+/// kicked, and the forces are computed only for their pairs.
+///
+/// Sleeping particles, see `ParticleSleeping`, are never active, and their
+/// sleeping states are updated at the end of each step.
+template<explicit_equations Equations, class Sleeping = NoParticleSleeping>
+class MultiRateIntegrator final :
+    public impl::MeshUpdateFreq,
+    public impl::StepIndex {
+public:
+
+  static_assert(!Equations::has_implicit_viscosity,
+                "Implicit viscosity is not supported by this integrator!");
+
+  /// Set of particle fields that are required.
+  static constexpr auto required_fields = Equations::required_fields |
+                                          Sleeping::required_fields |
+                                          meta::Set{parinfo, r, v, dv_dt};
+
+  /// Set of particle fields that are modified.
+  static constexpr auto modified_fields = Equations::modified_fields |
+                                          Sleeping::modified_fields |
+                                          meta::Set{parinfo, r, v, u, alpha};
+
+  /// Set of particle fields that the pair loops read together.
+  static constexpr auto pair_fields = Equations::pair_fields;
+
+  /// Construct time integrator.
+  ///
+  /// @param equations Equations to integrate.
+  /// @param num_levels Number of the time step levels. The smallest time step
+  ///                   is `2^(num_levels - 1)` times smaller than the step.
+  /// @param mesh_update_freq Particle mesh update frequency.
+  /// @param sleeping Particle sleeping.
+  constexpr explicit MultiRateIntegrator(Equations equations,
+                                         size_t num_levels = 4,
+                                         size_t mesh_update_freq = 1,
+                                         Sleeping sleeping = {}) noexcept
+      : MeshUpdateFreq{mesh_update_freq}, equations_{std::move(equations)},
+        sleeping_{std::move(sleeping)}, num_levels_{num_levels} {
+    TIT_ASSERT(num_levels_ > 0, "Number of levels must be positive!");
+  }
+
+  /// Fluid equations.
+  constexpr auto equations() const noexcept -> const Equations& {
+    return equations_;
+  }
+
+  /// Make a step in time. Observer is called for each fluid particle at
+  /// the end of the step, see `NoStepObserver`.
+  ///
+  /// @param dt Time step, that is the time step of the slowest particles.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Observer = NoStepObserver>
+  void step(particle_num_t<ParticleArray> dt,
+            ParticleMesh& mesh,
+            ParticleArray& particles,
+            const Observer& observer = {}) {
+    TIT_PROFILE_SECTION("MultiRateIntegrator::step()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<PV>;
+
+    // Initialize and index particles, and assign the time step levels.
+    // Mesh is updated only here, since the update may reorder the particles.
+    if (step_index_ == 0) equations_.init(particles);
+    if (step_index_ % mesh_update_freq() == 0 || reindex_) {
+      equations_.index(mesh, particles);
+      reindex_ = false;
+    }
+    assign_levels_(dt, mesh, particles);
+
+    // Run the substeps.
+    const auto num_substeps = size_t{1} << (num_levels_ - 1);
+    const auto dt_min = dt / static_cast<Num>(num_substeps);
+    for (size_t k = 0; k < num_substeps; ++k) {
+      // Compute the time derivatives for the active particles.
+      const auto is_active = [num_substeps, k, this](PV a) {
+        if (!a.is_fluid() || sleeping_.is_asleep(a)) return false;
+        const auto stride = num_substeps >> levels_[a.index()];
+        return k % stride == 0;
+      };
+      equations_.setup_boundary(mesh, particles);
+      equations_.compute_rates(mesh, particles, is_active);
+
+      // Kick the active particles for their whole time step, and drift all
+      // the particles for the substep.
+      par::for_each(particles.fluid(), [dt, dt_min, &is_active, this](PV a) {
+        if (is_active(a)) {
+          const auto level = levels_[a.index()];
+          const auto dt_a = dt / static_cast<Num>(size_t{1} << level);
+          v[a] += dt_a * dv_dt[a];
+          if constexpr (has<PV>(drho_dt)) rho[a] += dt_a * drho_dt[a];
+          if constexpr (has<PV>(u, du_dt)) u[a] += dt_a * du_dt[a];
+          if constexpr (has<PV>(alpha, dalpha_dt)) {
+            alpha[a] += dt_a * dalpha_dt[a];
+          }
+        }
+        r[a] += dt_min * v[a]; // Kick-Drift: position is updated last.
+      });
+    }
+
+    // Apply particle shifting, if necessary, and observe the particles.
+    // Sleeping particles are stopped once their states are updated, so with
+    // the sleeping, the particles are observed after the update.
+    if constexpr (std::same_as<Sleeping, NoParticleSleeping>) {
+      impl::finish_step(dt,
+                        equations_,
+                        mesh,
+                        particles,
+                        step_index_,
+                        observer);
+    } else {
+      impl::finish_step(dt,
+                        equations_,
+                        mesh,
+                        particles,
+                        step_index_,
+                        NoStepObserver{});
+      sleeping_.update(mesh, particles);
+      impl::observe_step(particles, observer);
+    }
+
+    // Increment step index.
+    step_index_ += 1;
+  }
+
+  /// Number of bytes of the integrator scratch allocated on the heap.
+  auto heap_bytes() const noexcept -> size_t {
+    return tit::heap_bytes(levels_, next_levels_);
+  }
+
+private:
+
+  // Assign the time step levels to the particles, and limit the level
+  // difference between the neighbors to one. Limiting only refines the
+  // levels, and each sweep propagates the limit by one neighbor, so it
+  // converges within `num_levels_ - 1` sweeps.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void assign_levels_(particle_num_t<ParticleArray> dt,
+                      ParticleMesh& mesh,
+                      ParticleArray& particles) {
+    TIT_PROFILE_SECTION("MultiRateIntegrator::assign_levels()");
+    using PV = ParticleView<ParticleArray>;
+    levels_.assign(particles.size(), 0);
+    par::for_each(particles.fluid(), [dt, this](PV a) {
+      const auto dt_a = equations_.time_step(a);
+      auto dt_level = dt;
+      auto& level = levels_[a.index()];
+      while (level + 1U < num_levels_ && dt_level > dt_a) {
+        dt_level /= 2, level += 1;
+      }
+    });
+    for (size_t sweep = 1; sweep < num_levels_; ++sweep) {
+      next_levels_ = levels_;
+      std::atomic_bool changed = false;
+      par::for_each(particles.fluid(), [&mesh, &changed, this](PV a) {
+        auto& level = next_levels_[a.index()];
+        for (const PV b : mesh[a]) {
+          const auto level_b = levels_[b.index()];
+          if (level + 1U < level_b) {
+            level = static_cast<uint8_t>(level_b - 1U);
+            changed.store(true, std::memory_order_relaxed);
+          }
+        }
+      });
+      std::swap(levels_, next_levels_);
+      if (!changed.load(std::memory_order_relaxed)) break;
+    }
+  }
+
+  [[no_unique_address]] Equations equations_;
+  [[no_unique_address]] Sleeping sleeping_;
+  size_t num_levels_;
+  std::vector<uint8_t> levels_;
+  std::vector<uint8_t> next_levels_;
+
+}; // class MultiRateIntegrator
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Pressure projection time integrator for the incompressible fluids.
+///
+/// Velocities are first predicted with the non-pressure forces, then the
+/// pressure Poisson equation `div(grad(p) / rho) = div(v*) / dt` is solved,
+/// and the predicted velocities are corrected with the pressure gradient,
+/// so that the velocity field becomes divergence-free. Laplacian is
+/// discretized as in Shao and Lo (2003), and the equation is solved with
+/// the relaxed Jacobi iterations, matrix-free over the particle adjacency.
+/// Pressure of the free surface particles, that are detected by the
+/// divergence of the particle positions, is zero.
+///
+/// Time step is not limited by the speed of sound, so the equations should
+/// use `IncompressibleEquationOfState` with the numerical sound speed of the
+/// order of the flow velocity.
+template<explicit_equations Equations>
+class ProjectionIntegrator final :
+    public impl::MeshUpdateFreq,
+    public impl::StepIndex {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr auto required_fields =
+      Equations::required_fields |
+      meta::Set{parinfo, h, m, r, rho, p, v, dv_dt};
+
+  /// Set of particle fields that are modified.
+  static constexpr auto modified_fields =
+      Equations::modified_fields | meta::Set{parinfo, r, v, p, dv_dt, u, alpha};
+
+  /// Set of particle fields that the pair loops read together.
+  static constexpr auto pair_fields = Equations::pair_fields;
+
+  /// Construct time integrator.
+  ///
+  /// @param equations          Equations to integrate.
+  /// @param mesh_update_freq   Particle mesh update frequency.
+  /// @param max_iterations     Maximum number of the pressure iterations.
+  /// @param tolerance          Relative tolerance of the pressure iterations.
+  /// @param relaxation         Relaxation factor of the Jacobi iterations.
+  /// @param free_surface_ratio Particle is on the free surface if the
+  ///                           divergence of the positions is less than
+  ///                           this fraction of the spatial dimension.
+  constexpr explicit ProjectionIntegrator(Equations equations,
+                                          size_t mesh_update_freq = 10,
+                                          size_t max_iterations = 100,
+                                          real_t tolerance = 1.0e-3,
+                                          real_t relaxation = 0.5,
+                                          real_t free_surface_ratio = 0.75)
+      : MeshUpdateFreq{mesh_update_freq}, equations_{std::move(equations)},
+        max_iterations_{max_iterations}, tolerance_{tolerance},
+        relaxation_{relaxation}, free_surface_ratio_{free_surface_ratio} {
+    TIT_ASSERT(max_iterations_ > 0, "Number of iterations must be positive!");
+    TIT_ASSERT(tolerance_ > 0.0, "Tolerance must be positive!");
+    TIT_ASSERT(0.0 < relaxation_ && relaxation_ <= 1.0,
+               "Relaxation factor must be in (0, 1]!");
+  }
+
+  /// Number of the pressure iterations made on the last step.
+  constexpr auto num_iterations() const noexcept -> size_t {
+    return num_iterations_;
+  }
+
+  /// Fluid equations.
+  constexpr auto equations() const noexcept -> const Equations& {
+    return equations_;
+  }
+
+  /// Make a step in time. Observer is called for each fluid particle at
+  /// the end of the step, see `NoStepObserver`.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray,
+           class Observer = NoStepObserver>
+  void step(particle_num_t<ParticleArray> dt,
+            ParticleMesh& mesh,
+            ParticleArray& particles,
+            const Observer& observer = {}) {
+    TIT_PROFILE_SECTION("ProjectionIntegrator::step()");
+    using PV = ParticleView<ParticleArray>;
+
+    // Initialize and index particles.
+    if (step_index_ == 0) equations_.init(particles);
+    if (step_index_ % mesh_update_freq() == 0 || reindex_) {
+      equations_.index(mesh, particles);
+      reindex_ = false;
+    }
+
+    // Setup boundary conditions.
+    equations_.setup_boundary(mesh, particles);
+
+    // Update particle density.
+    equations_.compute_density(mesh, particles);
+    if constexpr (has<PV>(drho_dt)) {
+      par::for_each(particles.fluid(), [dt](PV a) {
+        rho[a] += dt * drho_dt[a];
+      });
+    }
+
+    // Compute the non-pressure forces. Pressure of the previous step is kept
+    // aside, and is used as the initial guess of the pressure iterations.
+    guess_.resize(particles.size());
+    par::for_each(particles.all(), [this](PV a) {
+      guess_[a.index()] = static_cast<real_t>(p[a]);
+      p[a] = 0.0;
+    });
+    equations_.compute_forces(mesh, particles);
+
+    // Predict velocities, and update the boundary velocities accordingly.
+    par::for_each(particles.fluid(), [dt](PV a) { v[a] += dt * dv_dt[a]; });
+    equations_.apply_implicit_viscosity(dt, mesh, particles);
+    equations_.setup_boundary(mesh, particles);
+
+    // Solve for pressure, correct velocities, and update positions.
+    solve_pressure_(dt, mesh, particles);
+    project_velocities_(dt, mesh, particles);
+    par::for_each(particles.fluid(), [dt](PV a) {
+      r[a] += dt * v[a];
+      if constexpr (has<PV>(u, du_dt)) u[a] += dt * du_dt[a];
+      if constexpr (has<PV>(alpha, dalpha_dt)) alpha[a] += dt * dalpha_dt[a];
+    });
+
+    // Apply particle shifting, if necessary, and observe the particles.
+    impl::finish_step(dt,
+                      equations_,
+                      mesh,
+                      particles,
+                      step_index_,
+                      observer);
+
+    // Increment step index.
+    step_index_ += 1;
+  }
+
+  /// Make a step in time with the maximum stable time step.
+  ///
+  /// @param max_dt Upper bound of the time step.
+  ///
+  /// @returns Time step that was made.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  auto adaptive_step(particle_num_t<ParticleArray> max_dt,
+                     ParticleMesh& mesh,
+                     ParticleArray& particles)
+      -> particle_num_t<ParticleArray> {
+    const auto dt = equations_.time_step(particles, max_dt);
+    step(dt, mesh, particles);
+    return dt;
+  }
+
+  /// Number of bytes of the integrator scratch allocated on the heap.
+  auto heap_bytes() const noexcept -> size_t {
+    return tit::heap_bytes(guess_, rhs_, diag_, new_p_, free_, accels_);
+  }
+
+private:
+
+  // Coefficient of the neighbor in the Laplacian of the pressure divided by
+  // the density, so that `div(grad(p) / rho)[a]` is the sum of
+  // `coeff(a, b) * (p[a] - p[b])` over the neighbors.
+  template<class Kernel, particle_view<required_fields> PV>
+  static constexpr auto laplacian_coeff_(const Kernel& kernel, PV a, PV b)
+      -> particle_num_t<PV> {
+    using Num = particle_num_t<PV>;
+    const auto r_ab = r[a, b];
+    const auto eta_2 = pow2(Num{0.1} * h[a]);
+    const auto F_ab = dot(r_ab, kernel.grad(a, b)) / (norm2(r_ab) + eta_2);
+    return Num{8.0} * m[b] * F_ab / pow2(rho[a] + rho[b]);
+  }
+
+  // Solve the pressure Poisson equation.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void solve_pressure_(particle_num_t<ParticleArray> dt,
+                       ParticleMesh& mesh,
+                       ParticleArray& particles) {
+    TIT_PROFILE_SECTION("ProjectionIntegrator::solve_pressure_()");
+    using PV = ParticleView<ParticleArray>;
+    using Num = particle_num_t<PV>;
+    static constexpr auto Dim = particle_dim_v<PV>;
+    const auto& kernel = equations_.kernel();
+
+    // Compute the right hand side and the diagonal of the system, detect the
+    // free surface particles, and set the initial guess. Fixed particles are
+    // never on the free surface, their velocities mirror the fluid ones, so
+    // the wall pressure ensures the impermeability.
+    const auto num_particles = particles.size();
+    rhs_.resize(num_particles), diag_.resize(num_particles);
+    new_p_.resize(num_particles), free_.resize(num_particles);
+    heavy_for_each(particles.all(), [dt, &kernel, &mesh, this](PV a) {
+      Num div_v{};
+      Num div_r{};
+      Num diag{};
+      for (const PV b : mesh[a]) {
+        if (b == a) continue;
+        const auto grad_W_ab = kernel.grad(a, b);
+        const auto V_b = m[b] / rho[b];
+        div_v += V_b * dot(v[b, a], grad_W_ab);
+        div_r += V_b * dot(r[b, a], grad_W_ab);
+        diag += laplacian_coeff_(kernel, a, b);
+      }
+      const auto i = a.index();
+      rhs_[i] = static_cast<real_t>(div_v / dt);
+      diag_[i] = static_cast<real_t>(diag);
+      const auto is_free =
+          diag == 0.0 ||
+          (a.is_fluid() && div_r < static_cast<Num>(free_surface_ratio_ * Dim));
+      free_[i] = is_free ? 1 : 0;
+      p[a] = is_free ? Num{0.0} : static_cast<Num>(guess_[i]);
+    });
+
+    // Iterate until the pressure change is small enough.
+    const auto omega = static_cast<Num>(relaxation_);
+    std::vector<Num> thread_dps(par::num_threads());
+    std::vector<Num> thread_ps(par::num_threads());
+    num_iterations_ = 0;
+    while (num_iterations_ < max_iterations_) {
+      std::ranges::fill(thread_dps, Num{0.0});
+      std::ranges::fill(thread_ps, Num{0.0});
+      par::static_for_each(
+          particles.all(),
+          [omega, &kernel, &mesh, &thread_dps, &thread_ps, this](
+              size_t thread_index,
+              PV a) {
+            const auto i = a.index();
+            Num p_a{};
+            if (free_[i] == 0) {
+              auto sum = static_cast<Num>(rhs_[i]);
+              for (const PV b : mesh[a]) {
+                if (b == a) continue;
+                sum += laplacian_coeff_(kernel, a, b) * p[b];
+              }
+              const auto p_jacobi = sum / static_cast<Num>(diag_[i]);
+              p_a = (Num{1.0} - omega) * p[a] + omega * p_jacobi;
+            }
+            new_p_[i] = static_cast<real_t>(p_a);
+            auto& dp = thread_dps[thread_index];
+            auto& max_p = thread_ps[thread_index];
+            dp = std::max(dp, abs(p_a - p[a]));
+            max_p = std::max(max_p, abs(p_a));
+          });
+      par::for_each(particles.all(), [this](PV a) {
+        p[a] = static_cast<Num>(new_p_[a.index()]);
+      });
+      num_iterations_ += 1;
+      const auto dp = std::ranges::max(thread_dps);
+      const auto max_p = std::ranges::max(thread_ps);
+      if (dp <= static_cast<Num>(tolerance_) * max_p) break;
+    }
+  }
+
+  // Correct the predicted velocities with the pressure gradient. Pressure
+  // acceleration is also added to the particle accelerations, so that the
+  // loads, that are computed from them, include the pressure forces.
+  template<particle_mesh ParticleMesh,
+           particle_array<required_fields> ParticleArray>
+  void project_velocities_(particle_num_t<ParticleArray> dt,
+                           ParticleMesh& mesh,
+                           ParticleArray& particles) {
+    TIT_PROFILE_SECTION("ProjectionIntegrator::project_velocities_()");
+    using PV = ParticleView<ParticleArray>;
+    using Vec = particle_vec_t<PV>;
+    const auto& kernel = equations_.kernel();
+    accels_.assign(particles.size(), particle_dim_v<PV>);
+    heavy_for_each(particles.all(), [&kernel, &mesh, this](PV a) {
+      Vec dv_dt_a{};
+      const auto P_a = p[a] / pow2(rho[a]);
+      for (const PV b : mesh[a]) {
+        if (b == a) continue;
+        const auto P_b = p[b] / pow2(rho[b]);
+        dv_dt_a -= m[b] * (P_a + P_b) * kernel.grad(a, b);
+      }
+      for (size_t i = 0; i < particle_dim_v<PV>; ++i) {
+        accels_[a.index(), i] = static_cast<real_t>(dv_dt_a[i]);
+      }
+    });
+    par::for_each(particles.all(), [dt, this](PV a) {
+      Vec dv_dt_a{};
+      for (size_t i = 0; i < particle_dim_v<PV>; ++i) {
+        dv_dt_a[i] = static_cast<particle_num_t<PV>>(accels_[a.index(), i]);
+      }
+      dv_dt[a] += dv_dt_a;
+      if (a.is_fluid()) v[a] += dt * dv_dt_a;
+    });
+  }
+
+  [[no_unique_address]] Equations equations_;
+  size_t max_iterations_;
+  real_t tolerance_;
+  real_t relaxation_;
+  real_t free_surface_ratio_;
+  size_t num_iterations_ = 0;
+  std::vector<real_t> guess_;
+  std::vector<real_t> rhs_;
+  std::vector<real_t> diag_;
+  std::vector<real_t> new_p_;
+  std::vector<uint8_t> free_;
+  Mdvector<real_t, 2> accels_;
+
+}; // class ProjectionIntegrator
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 } // namespace tit::sph
@@ -6,13 +6,21 @@
 #pragma once
 
 #include <concepts>
+#include <ranges>
+#include <span>
+#include <vector>
 
+#include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
+#include "tit/core/containers/multivector.hpp"
 #include "tit/core/meta.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/profiler.hpp"
 #include "tit/core/vec.hpp"
 
 #include "tit/sph/field.hpp"
 #include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
 
 namespace tit::sph {
 
@@ -28,6 +36,9 @@ public:
   /// Set of particle fields that are modified.
   static constexpr meta::Set modified_fields{/*empty*/};
 
+  /// Is the viscosity applied implicitly?
+  static constexpr bool is_implicit = false;
+
   /// Compute viscosity term.
   template<particle_view<required_fields> PV>
   constexpr auto operator()(PV a, PV b) const noexcept {
@@ -49,24 +60,199 @@ public:
   /// Set of particle fields that are modified.
   static constexpr meta::Set modified_fields{/*empty*/};
 
+  /// Is the viscosity applied implicitly?
+  static constexpr bool is_implicit = false;
+
   /// Compute viscosity term.
   template<particle_view<required_fields> PV>
   constexpr auto operator()(PV a, PV b) const noexcept {
+    TIT_ASSERT(a != b, "Particles must be different!");
+    return coeff(a, b) * dot(r[a, b], v[a, b]);
+  }
+
+  /// Coefficient of the viscosity term, that is linear in the velocity
+  /// difference.
+  template<particle_view<required_fields> PV>
+  static constexpr auto coeff(PV a, PV b) noexcept {
     TIT_ASSERT(a != b, "Particles must be different!");
     const auto d = r[a].dim();
     const auto mu_ab = mu.havg(a, b);
-    return 2 * (d + 2) * mu_ab * dot(r[a, b], v[a, b]) /
-           (rho[a] * rho[b] * norm2(r[a, b]));
+    return 2 * (d + 2) * mu_ab / (rho[a] * rho[b] * norm2(r[a, b]));
+  }
+
+}; // class LaplacianViscosity
+
+/// Laplacian viscosity term, that is applied implicitly.
+///
+/// Viscosity term is the same as in `LaplacianViscosity`, but it is excluded
+/// from the explicit forces, and the velocities are instead updated with the
+/// backward Euler step of it, solved over the particle adjacency. So the time
+/// step is not limited by the viscous diffusion, which is useful for the
+/// highly viscous flows. Viscous heating is not accounted for.
+class ImplicitLaplacianViscosity final {
+public:
+
+  /// Set of particle fields that are required.
+  static constexpr meta::Set required_fields{rho, r, v, mu};
+
+  /// Set of particle fields that are modified.
+  static constexpr meta::Set modified_fields{v};
+
+  /// Is the viscosity applied implicitly?
+  static constexpr bool is_implicit = true;
+
+  /// Construct the viscosity term.
+  ///
+  /// @param max_iterations Maximum number of the linear solver iterations.
+  /// @param tolerance      Relative tolerance of the linear solver.
+  constexpr explicit ImplicitLaplacianViscosity(size_t max_iterations = 100,
+                                                real_t tolerance = 1.0e-6)
+      : max_iterations_{max_iterations}, tolerance_{tolerance} {
+    TIT_ASSERT(max_iterations_ > 0, "Number of iterations must be positive!");
+    TIT_ASSERT(tolerance_ > 0.0, "Tolerance must be positive!");
+  }
+
+  /// Maximum number of the linear solver iterations.
+  constexpr auto max_iterations() const noexcept -> size_t {
+    return max_iterations_;
+  }
+
+  /// Relative tolerance of the linear solver.
+  constexpr auto tolerance() const noexcept -> real_t {
+    return tolerance_;
+  }
+
+  /// Compute the explicit part of the viscosity term, which is zero.
+  template<particle_view<required_fields> PV>
+  constexpr auto operator()(PV a, PV b) const noexcept {
+    TIT_ASSERT(a != b, "Particles must be different!");
+    return 0;
+  }
+
+  /// @copydoc LaplacianViscosity::coeff
+  template<particle_view<required_fields> PV>
+  static constexpr auto coeff(PV a, PV b) noexcept {
+    return LaplacianViscosity::coeff(a, b);
+  }
+
+private:
+
+  size_t max_iterations_;
+  real_t tolerance_;
+
+}; // class ImplicitLaplacianViscosity
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Backward Euler step of the implicit Laplacian viscosity.
+///
+/// Linear operator `x - dt * L(x)` over the particle velocities, flattened
+/// into a single vector of the velocity components, to be used with the
+/// `graph` linear solvers. Pair coefficients, including the kernel gradients,
+/// are computed once by `assemble`, and are reused by each application. Rows
+/// of the non-fluid particles are identity, so that their velocities are
+/// kept as they are.
+template<class Num, size_t Dim>
+class ImplicitViscosityOperator final {
+public:
+
+  /// Assemble the pair coefficients of the operator.
+  template<class Kernel,
+           particle_mesh ParticleMesh,
+           particle_array<ImplicitLaplacianViscosity::required_fields>
+               ParticleArray>
+  void assemble(Num dt,
+                const Kernel& kernel,
+                ParticleMesh& mesh,
+                ParticleArray& particles) {
+    TIT_PROFILE_SECTION("ImplicitViscosityOperator::assemble()");
+    using PV = ParticleView<ParticleArray>;
+    static_assert(particle_dim_v<PV> == Dim);
+    dt_ = dt;
+    is_fluid_.resize(particles.size());
+    par::for_each(particles.all(), [this](PV a) {
+      is_fluid_[a.index()] = a.is_fluid() ? 1 : 0;
+    });
+    pairs_.assign_buckets_par(
+        particles.size(),
+        [&mesh, &particles](size_t i) {
+          return std::ranges::size(mesh[particles[i]]);
+        },
+        [&kernel, &mesh, &particles](size_t i, std::span<Pair_> pairs) {
+          const auto a = particles[i];
+          for (auto&& [pair, b] : std::views::zip(pairs, mesh[a])) {
+            pair.index = b.index();
+            if (b == a) continue;
+            const auto coeff = ImplicitLaplacianViscosity::coeff(a, b);
+            pair.weight = m[b] * coeff * kernel.grad(a, b);
+            pair.delta = r[a, b];
+          }
+        });
+  }
+
+  /// Number of the operator rows.
+  constexpr auto num_rows() const noexcept -> size_t {
+    return Dim * is_fluid_.size();
+  }
+
+  /// Diagonal coefficient of the row.
+  constexpr auto diagonal(size_t row) const -> Num {
+    TIT_ASSERT(row < num_rows(), "Row index is out of range!");
+    const auto a = row / Dim;
+    const auto i = row % Dim;
+    if (is_fluid_[a] == 0) return Num{1.0};
+    Num sum{};
+    for (const auto& pair : pairs_[a]) sum += pair.weight[i] * pair.delta[i];
+    return Num{1.0} - dt_ * sum;
+  }
+
+  /// Apply the operator.
+  void operator()(std::span<const Num> x, std::span<Num> y) const {
+    TIT_ASSERT(x.size() == num_rows(), "Operand size mismatch!");
+    TIT_ASSERT(y.size() == num_rows(), "Result size mismatch!");
+    const auto load = [x](size_t a) {
+      Vec<Num, Dim> x_a;
+      for (size_t i = 0; i < Dim; ++i) x_a[i] = x[Dim * a + i];
+      return x_a;
+    };
+    par::for_each(std::views::iota(size_t{0}, is_fluid_.size()),
+                  [&load, y, this](size_t a) {
+                    auto y_a = load(a);
+                    if (is_fluid_[a] != 0) {
+                      Vec<Num, Dim> L_a{};
+                      for (const auto& pair : pairs_[a]) {
+                        const auto x_ab = y_a - load(pair.index);
+                        L_a += dot(pair.delta, x_ab) * pair.weight;
+                      }
+                      y_a -= dt_ * L_a;
+                    }
+                    for (size_t i = 0; i < Dim; ++i) y[Dim * a + i] = y_a[i];
+                  });
   }
 
-}; // class ConstantViscosity
+private:
+
+  // Neighbor of a particle, with the pair coefficients. Contribution of the
+  // neighbor to the viscous term is `dot(delta, x_ab) * weight`.
+  struct Pair_ final {
+    size_t index = 0;
+    Vec<Num, Dim> weight{};
+    Vec<Num, Dim> delta{};
+  };
+
+  Num dt_{};
+  std::vector<uint8_t> is_fluid_;
+  Multivector<Pair_> pairs_;
+
+}; // class ImplicitViscosityOperator
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 /// Viscosity type.
 template<class V>
-concept viscosity = std::same_as<V, NoViscosity> || //
-                    std::same_as<V, LaplacianViscosity>;
+concept viscosity = std::same_as<V, NoViscosity> ||        //
+                    std::same_as<V, LaplacianViscosity> || //
+                    std::same_as<V, ImplicitLaplacianViscosity>;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
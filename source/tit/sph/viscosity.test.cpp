@@ -0,0 +1,167 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <cmath>
+#include <numbers>
+#include <span>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/meta.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/search.hpp"
+
+#include "tit/graph/linear_solver.hpp"
+
+#include "tit/sph/boundary.hpp"
+#include "tit/sph/field.hpp"
+#include "tit/sph/kernel.hpp"
+#include "tit/sph/particle_array.hpp"
+#include "tit/sph/particle_mesh.hpp"
+#include "tit/sph/viscosity.hpp"
+
+#include "tit/testing/test.hpp"
+
+namespace tit {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+using sph::h;
+using sph::m;
+using sph::mu;
+using sph::parinfo;
+using sph::r;
+using sph::rho;
+using sph::v;
+
+using Vec2D = Vec<double, 2>;
+using Space2D = sph::Space<double, 2>;
+using ParticleArray2D =
+    sph::ParticleArray<Space2D,
+                       decltype(meta::Set{h, m, rho, mu}),
+                       decltype(meta::Set{r, v, parinfo})>;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST_CASE("sph::ImplicitViscosityOperator") {
+  // Unit square of fluid, surrounded by a few layers of the fixed particles,
+  // that cover the kernel support of the fluid particles near the walls.
+  // Velocity is the shear profile `v_x = sin(k * y)`, that decays as
+  // `exp(-nu * k^2 * t)` and stays divergence-free.
+  constexpr size_t N = 20;
+  constexpr size_t NumLayers = 3;
+  constexpr double dr = 1.0 / N;
+  constexpr double h_0 = 1.5 * dr;
+  constexpr double rho_0 = 1000.0;
+  constexpr double mu_0 = 1.0;
+  constexpr double nu_0 = mu_0 / rho_0;
+  constexpr double k = 2.0 * std::numbers::pi;
+  ParticleArray2D particles{Space2D{}, meta::Set<>{}};
+  h[particles] = h_0;
+  m[particles] = rho_0 * dr * dr;
+  rho[particles] = rho_0;
+  mu[particles] = mu_0;
+  for (size_t i = 0; i < N + 2 * NumLayers; ++i) {
+    for (size_t j = 0; j < N + 2 * NumLayers; ++j) {
+      const auto is_fluid = NumLayers <= i && i < N + NumLayers && //
+                            NumLayers <= j && j < N + NumLayers;
+      const auto a = particles.append(is_fluid ? sph::ParticleType::fluid :
+                                                 sph::ParticleType::fixed);
+      r[a] = dr * Vec2D{static_cast<double>(i) - NumLayers + 0.5,
+                        static_cast<double>(j) - NumLayers + 0.5};
+    }
+  }
+  const auto shear = [k](auto a) { return Vec2D{std::sin(k * r[a][1]), 0.0}; };
+  for (const auto a : particles.all()) v[a] = shear(a);
+
+  // Build the adjacency.
+  const sph::QuarticWendlandKernel kernel{};
+  const sph::DomainBoundary boundary{
+      geom::BBox{Vec2D{0.0, 0.0}, Vec2D{1.0, 1.0}},
+      /*rho_0=*/rho_0,
+      /*cs_0=*/10.0,
+      /*g=*/Vec2D{0.0, 0.0},
+  };
+  sph::ParticleMesh<> mesh{geom::GridSearch{kernel.radius(h_0)}};
+  mesh.update(
+      particles,
+      [&kernel](auto a) { return kernel.radius(a); },
+      boundary);
+
+  // Flatten the velocities.
+  const auto pack = [&particles] {
+    std::vector<double> x(2 * particles.size());
+    for (const auto a : particles.all()) {
+      x[2 * a.index() + 0] = v[a][0];
+      x[2 * a.index() + 1] = v[a][1];
+    }
+    return x;
+  };
+
+  SUBCASE("explicit scheme") {
+    // Operator must apply the same viscous term as the explicit scheme.
+    constexpr double dt = 1.0;
+    sph::ImplicitViscosityOperator<double, 2> A{};
+    A.assemble(dt, kernel, mesh, particles);
+    REQUIRE(A.num_rows() == 2 * particles.size());
+    const auto x = pack();
+    std::vector<double> y(A.num_rows());
+    A(std::span<const double>{x}, std::span{y});
+    for (const auto a : particles.all()) {
+      Vec2D L_a{};
+      if (a.is_fluid()) {
+        for (const auto b : mesh[a]) {
+          if (b == a) continue;
+          L_a += m[b] * sph::LaplacianViscosity{}(a, b) * kernel.grad(a, b);
+        }
+      }
+      CHECK_APPROX_EQ(y[2 * a.index() + 0], x[2 * a.index() + 0] - dt * L_a[0]);
+      CHECK_APPROX_EQ(y[2 * a.index() + 1], x[2 * a.index() + 1] - dt * L_a[1]);
+    }
+  }
+  SUBCASE("diagonal") {
+    // Diagonal must match the operator applied to the unit vectors.
+    constexpr double dt = 1.0;
+    sph::ImplicitViscosityOperator<double, 2> A{};
+    A.assemble(dt, kernel, mesh, particles);
+    std::vector<double> e(A.num_rows()), y(A.num_rows());
+    for (size_t row = 0; row < A.num_rows(); row += 37) {
+      e[row] = 1.0;
+      A(std::span<const double>{e}, std::span{y});
+      CHECK_APPROX_EQ(A.diagonal(row), y[row]);
+      CHECK(A.diagonal(row) >= 1.0);
+      e[row] = 0.0;
+    }
+  }
+  SUBCASE("backward Euler") {
+    // Time step is far above the explicit diffusion limit, the backward Euler
+    // step halves the profile amplitude. Fixed particles hold the expected
+    // velocities, so that the walls do not disturb the decay.
+    constexpr double dt = 1.0 / (nu_0 * k * k);
+    constexpr double ratio = 1.0 / (1.0 + nu_0 * k * k * dt);
+    for (const auto a : particles.fixed()) v[a] = ratio * shear(a);
+    sph::ImplicitViscosityOperator<double, 2> A{};
+    A.assemble(dt, kernel, mesh, particles);
+    const auto b = pack();
+    auto x = b;
+    const graph::BiCGStab solve{/*max_iterations=*/1000, /*tolerance=*/1.0e-10};
+    const graph::JacobiPreconditioner<double> M{A};
+    const auto result =
+        solve(A, std::span<const double>{b}, std::span{x}, M);
+    REQUIRE(result.converged);
+    for (const auto a : particles.fluid()) {
+      CHECK(std::abs(x[2 * a.index() + 0] - ratio * shear(a)[0]) < 0.05);
+      CHECK(std::abs(x[2 * a.index() + 1]) < 0.05);
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit
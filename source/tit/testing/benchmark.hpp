@@ -0,0 +1,70 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h> // IWYU pragma: exports
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/vec.hpp"
+
+namespace tit::testing {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Sweep the benchmark over the problem sizes and the number of threads.
+///
+/// The first argument of the benchmark is the problem size, and the second
+/// one is the number of threads, see `setup_benchmark`.
+inline void sweep_sizes_and_threads(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"size", "threads"})
+      ->ArgsProduct({{1 << 12, 1 << 15, 1 << 18}, {1, 2, 4, 8}})
+      ->UseRealTime()
+      ->Unit(benchmark::kMillisecond);
+}
+
+/// Set the number of threads from the benchmark arguments, and return the
+/// problem size.
+inline auto setup_benchmark(const benchmark::State& state) -> size_t {
+  par::set_num_threads(static_cast<size_t>(state.range(1)));
+  return static_cast<size_t>(state.range(0));
+}
+
+/// Report the number of processed items per iteration.
+inline void report_items(benchmark::State& state, size_t items_per_iter) {
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(items_per_iter));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Generate the points, uniformly distributed in a unit cube. Points are
+/// generated from the fixed seed, so all the runs measure the same input.
+template<class Num, size_t Dim>
+auto random_points(size_t count, uint64_t seed = 42)
+    -> std::vector<Vec<Num, Dim>> {
+  std::mt19937_64 rng{seed};
+  std::uniform_real_distribution<Num> dist{Num{0.0}, Num{1.0}};
+  std::vector<Vec<Num, Dim>> points(count);
+  for (auto& point : points) {
+    for (size_t d = 0; d < Dim; ++d) point[d] = dist(rng);
+  }
+  return points;
+}
+
+/// Typical particle spacing of the points, generated by `random_points`.
+template<class Num, size_t Dim>
+auto random_points_spacing(size_t count) -> Num {
+  return std::pow(Num{1.0} / static_cast<Num>(count), Num{1.0} / Dim);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::testing
@@ -0,0 +1,65 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#pragma once
+
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#include "tit/core/exception.hpp"
+#include "tit/core/utils.hpp"
+
+namespace tit::testing {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Temporary directory for the files written by a test.
+///
+/// Directory with a unique name is created in the system temporary directory,
+/// and is removed with all of its contents on destruction, so that the tests
+/// leave nothing behind in the current directory.
+class TempDir final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(TempDir);
+
+  /// Create the temporary directory.
+  TempDir() {
+    auto path = (std::filesystem::temp_directory_path() / "tit_test_XXXXXX")
+                    .string();
+    if (mkdtemp(path.data()) == nullptr) {
+      TIT_THROW("Unable to create the temporary directory '{}'.", path);
+    }
+    path_ = path;
+  }
+
+  /// Remove the temporary directory with all of its contents.
+  ~TempDir() noexcept {
+    std::error_code error{};
+    std::filesystem::remove_all(path_, error);
+  }
+
+  /// Path to the temporary directory.
+  auto path() const noexcept -> const std::filesystem::path& {
+    return path_;
+  }
+
+  /// Path to the file in the temporary directory.
+  auto operator/(const std::filesystem::path& name) const
+      -> std::filesystem::path {
+    return path_ / name;
+  }
+
+private:
+
+  std::filesystem::path path_;
+
+}; // class TempDir
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace tit::testing
@@ -3,34 +3,1084 @@
  * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <exception>
 #include <filesystem>
+#include <format>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
 #include <span>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <crow/app.h>
 #include <crow/http_request.h>
 #include <crow/http_response.h>
+#include <crow/json.h>
+#include <crow/mime_types.h>
 #include <crow/websocket.h>
 
 #include "tit/core/basic_types.hpp"
 #include "tit/core/checks.hpp"
 #include "tit/core/cmd.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/par/accum_buffer.hpp"
+#include "tit/core/par/algorithms.hpp"
 #include "tit/core/sys/utils.hpp"
+#include "tit/core/utils.hpp"
+#include "tit/core/vec.hpp"
+
+#include "tit/data/events.hpp"
+#include "tit/data/filter.hpp"
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+#include "tit/geom/bbox.hpp"
+#include "tit/geom/decimate.hpp"
+#include "tit/geom/grid.hpp"
+#include "tit/geom/point_range.hpp"
 
 #include "tit/py/cast.hpp"
 #include "tit/py/error.hpp"
 #include "tit/py/gil.hpp"
 #include "tit/py/interpreter.hpp"
-#include "tit/py/mapping.hpp"
 #include "tit/py/module.hpp"
+#include "tit/py/numpy.hpp"
 #include "tit/py/object.hpp"
 #include "tit/py/type.hpp"
 
 namespace tit::back {
 namespace {
 
+using Connection = crow::websocket::connection;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Send the error response.
+void send_error(Connection& connection,
+                const std::string& request_id,
+                const std::string& type,
+                const std::string& message) {
+  crow::json::wvalue response;
+  response["requestID"] = request_id;
+  response["status"] = "error";
+  response["result"]["type"] = type;
+  response["result"]["error"] = message;
+  connection.send_text(response.dump());
+}
+
+// Maximal payload size of a single binary message.
+constexpr size_t BinaryChunkSize = 4 * 1024 * 1024;
+
+// Quantization of the floating-point array to the unsigned integers.
+//
+// Each component of the array elements is mapped linearly from its range onto
+// `[0, 2^bits - 1]`. For the particle positions the ranges form the bounding
+// box of the particles.
+struct Quantization final {
+  size_t bits = 0;
+  std::vector<float64_t> low;
+  std::vector<float64_t> high;
+};
+
+// Quantize the values, with a separate range for each component.
+template<class Num, class Quant>
+auto quantize_values(std::span<const byte_t> bytes, size_t num_components)
+    -> std::pair<std::vector<byte_t>, Quantization> {
+  std::vector<Num> values(bytes.size() / sizeof(Num));
+  std::memcpy(values.data(), bytes.data(), bytes.size());
+  Quantization quantization{
+      .bits = 8 * sizeof(Quant),
+      .low = std::vector(num_components, float64_t{0.0}),
+      .high = std::vector(num_components, float64_t{0.0}),
+  };
+  std::vector<Quant> quants(values.size());
+  constexpr auto max_quant =
+      static_cast<float64_t>(std::numeric_limits<Quant>::max());
+  for (size_t c = 0; c < num_components && !values.empty(); ++c) {
+    auto low = static_cast<float64_t>(values[c]);
+    auto high = low;
+    for (size_t i = c; i < values.size(); i += num_components) {
+      low = std::min(low, static_cast<float64_t>(values[i]));
+      high = std::max(high, static_cast<float64_t>(values[i]));
+    }
+    quantization.low[c] = low;
+    quantization.high[c] = high;
+    const auto scale = high > low ? max_quant / (high - low) : 0.0;
+    for (size_t i = c; i < values.size(); i += num_components) {
+      const auto scaled = (static_cast<float64_t>(values[i]) - low) * scale;
+      quants[i] =
+          static_cast<Quant>(std::lround(std::clamp(scaled, 0.0, max_quant)));
+    }
+  }
+  std::vector<byte_t> result(quants.size() * sizeof(Quant));
+  std::memcpy(result.data(), quants.data(), result.size());
+  return {std::move(result), std::move(quantization)};
+}
+
+// Quantize the floating-point array data to the 8- or 16-bit integers.
+auto quantize(data::DataType type, std::span<const byte_t> data, size_t bits)
+    -> std::pair<std::vector<byte_t>, Quantization> {
+  if (bits != 8 && bits != 16) TIT_THROW("Quantization must be 8 or 16 bits.");
+  if (!type.kind().is_float()) {
+    TIT_THROW("Only floating-point arrays can be quantized, got '{}'.",
+              type.name());
+  }
+  const auto num_components = type.width() / type.kind().width();
+  const auto quantize_as = [bits, num_components]<class Num>(
+                               std::span<const byte_t> bytes) {
+    return bits == 8 ?
+               quantize_values<Num, uint8_t>(bytes, num_components) :
+               quantize_values<Num, uint16_t>(bytes, num_components);
+  };
+  using enum data::DataKind::ID;
+  const auto kind = type.kind().id();
+  if (kind == float32) return quantize_as.operator()<float32_t>(data);
+  if (kind == float64) return quantize_as.operator()<float64_t>(data);
+
+  // Other floating-point kinds are converted to the 64-bit numbers first.
+  const auto converted =
+      data::convert_precision(type, data::kind_of<float64_t>, data);
+  return quantize_as.operator()<float64_t>(converted);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Convert the numeric array data to the 64-bit floating-point values.
+auto to_float64(data::DataType type, std::span<const byte_t> data)
+    -> std::vector<float64_t> {
+  std::vector<float64_t> values(data.size() / type.kind().width());
+  const auto convert = [data, &values]<class Num>() {
+    par::for_each(std::views::iota(size_t{0}, values.size()),
+                  [data, &values](size_t i) {
+                    Num val{};
+                    std::memcpy(&val, &data[i * sizeof(Num)], sizeof(Num));
+                    values[i] = static_cast<float64_t>(val);
+                  });
+  };
+  using enum data::DataKind::ID;
+  switch (type.kind().id()) {
+    case int8:    convert.operator()<int8_t>(); break;
+    case uint8:   convert.operator()<uint8_t>(); break;
+    case int16:   convert.operator()<int16_t>(); break;
+    case uint16:  convert.operator()<uint16_t>(); break;
+    case int32:   convert.operator()<int32_t>(); break;
+    case uint32:  convert.operator()<uint32_t>(); break;
+    case int64:   convert.operator()<int64_t>(); break;
+    case uint64:  convert.operator()<uint64_t>(); break;
+    case float32: convert.operator()<float32_t>(); break;
+    case float64: convert.operator()<float64_t>(); break;
+    default: {
+      // Other floating-point kinds are converted with the vectorized
+      // routines, or rejected if the conversion is not supported.
+      const auto converted =
+          data::convert_precision(type, data::kind_of<float64_t>, data);
+      std::memcpy(values.data(), converted.data(), converted.size());
+      break;
+    }
+  }
+  return values;
+}
+
+// Summary of the values of a single component of the array elements.
+struct Summary final {
+  float64_t min = std::numeric_limits<float64_t>::infinity();
+  float64_t max = -std::numeric_limits<float64_t>::infinity();
+  float64_t sum = 0.0;
+};
+
+// Summarize the component of the array elements, in parallel.
+auto summarize(std::span<const float64_t> values,
+               size_t num_components,
+               size_t component) -> Summary {
+  TIT_ASSERT(component < num_components, "Component is out of range!");
+  return par::fold(
+      std::views::iota(size_t{0}, values.size() / num_components),
+      Summary{},
+      [values, num_components, component](Summary summary, size_t i) {
+        const auto val = values[i * num_components + component];
+        summary.min = std::min(summary.min, val);
+        summary.max = std::max(summary.max, val);
+        summary.sum += val;
+        return summary;
+      },
+      [](Summary a, const Summary& b) {
+        a.min = std::min(a.min, b.min);
+        a.max = std::max(a.max, b.max);
+        a.sum += b.sum;
+        return a;
+      });
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Send the array as a sequence of binary messages.
+//
+// Each message starts with the 32-bit little-endian size of the JSON header,
+// followed by the header itself and the chunk of the raw row-major array data.
+// Header contains the request ID, element kind and shape of the array, the
+// total data size, and the offset of the chunk within the data. This way the
+// array is transferred without converting it to text. For the quantized
+// arrays, header also contains the number of bits and the ranges of the
+// components, so that the values are restored as
+// `low + quant * (high - low) / (2^bits - 1)`.
+void send_array(Connection& connection,
+                const std::string& request_id,
+                std::string_view kind,
+                std::span<const size_t> shape,
+                std::span<const byte_t> data,
+                const std::optional<Quantization>& quantization = {}) {
+  static_assert(std::endian::native == std::endian::little);
+  crow::json::wvalue::list shape_list;
+  for (const auto extent : shape) shape_list.emplace_back(extent);
+  crow::json::wvalue::list low_list;
+  crow::json::wvalue::list high_list;
+  if (quantization.has_value()) {
+    for (const auto low : quantization->low) low_list.emplace_back(low);
+    for (const auto high : quantization->high) high_list.emplace_back(high);
+  }
+  size_t offset = 0;
+  do {
+    const auto chunk_size = std::min(BinaryChunkSize, data.size() - offset);
+    crow::json::wvalue header;
+    header["requestID"] = request_id;
+    header["kind"] = std::string{kind};
+    header["shape"] = shape_list;
+    header["size"] = data.size();
+    header["offset"] = offset;
+    if (quantization.has_value()) {
+      header["quantization"]["bits"] = quantization->bits;
+      header["quantization"]["low"] = low_list;
+      header["quantization"]["high"] = high_list;
+    }
+    const auto header_str = header.dump();
+    const auto header_size = static_cast<uint32_t>(header_str.size());
+    std::string message(sizeof(header_size) + header_str.size() + chunk_size,
+                        '\0');
+    auto* out = message.data();
+    std::memcpy(out, &header_size, sizeof(header_size));
+    out += sizeof(header_size);
+    std::memcpy(out, header_str.data(), header_str.size());
+    out += header_str.size();
+    std::memcpy(out, data.subspan(offset, chunk_size).data(), chunk_size);
+    connection.send_binary(std::move(message));
+    offset += chunk_size;
+  } while (offset < data.size());
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Send the static file of the frontend.
+//
+// Brotli or gzip compressed copy of the file, written next to it by the
+// frontend build, is sent if the client accepts it. Files in `assets` have
+// the content hashes in their names, so they are cached forever. The other
+// files are revalidated with the ETag, derived from the file size and
+// modification time.
+void send_static_file(const crow::request& request,
+                      crow::response& response,
+                      const std::filesystem::path& path) {
+  std::error_code error;
+  const auto size = std::filesystem::file_size(path, error);
+  const auto mtime = std::filesystem::last_write_time(path, error);
+  if (error) {
+    response.code = crow::status::NOT_FOUND;
+    response.end();
+    return;
+  }
+  const auto etag = std::format("\"{:x}-{:x}\"",
+                                size,
+                                mtime.time_since_epoch().count());
+  response.set_header("ETag", etag);
+  response.set_header("Cache-Control",
+                      path.parent_path().filename() == "assets" ?
+                          "public, max-age=31536000, immutable" :
+                          "no-cache");
+  response.set_header("Vary", "Accept-Encoding");
+  if (request.get_header_value("If-None-Match") == etag) {
+    response.code = crow::status::NOT_MODIFIED;
+    response.end();
+    return;
+  }
+  auto file_path = path;
+  const auto& accept_encoding = request.get_header_value("Accept-Encoding");
+  for (const auto& [encoding, suffix] :
+       {std::pair{"br", ".br"}, std::pair{"gzip", ".gz"}}) {
+    auto compressed_path = path;
+    compressed_path += suffix;
+    if (accept_encoding.contains(encoding) &&
+        std::filesystem::is_regular_file(compressed_path)) {
+      file_path = std::move(compressed_path);
+      response.set_header("Content-Encoding", encoding);
+      break;
+    }
+  }
+  response.set_static_file_info_unsafe(file_path.native());
+
+  // Content type is derived from the extension of the original file.
+  auto extension = path.extension().string();
+  if (!extension.empty()) extension.erase(0, 1);
+  const auto mime_type = crow::mime_types.find(extension);
+  response.set_header("Content-Type",
+                      mime_type != crow::mime_types.end() ? mime_type->second :
+                                                            "text/plain");
+  response.end();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Python expression evaluator.
+//
+// Expressions are evaluated one by one by a dedicated worker thread, so that
+// the connection threads are never blocked on the GIL, and the requests that
+// do not need Python are served while an expression is being evaluated.
+class PythonWorker final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(PythonWorker);
+
+  // Start the worker thread. If no interpreter is given, expressions are
+  // evaluated in a subinterpreter of the worker, with its own GIL.
+  explicit PythonWorker(const py::embed::Interpreter* interpreter)
+      : interpreter_{interpreter}, thread_{[this] { run_(); }} {}
+
+  // Stop the worker thread. Pending requests are discarded.
+  ~PythonWorker() {
+    {
+      const std::scoped_lock lock{mutex_};
+      stopping_ = true;
+    }
+    condition_.notify_one();
+    const py::ReleaseGIL release_gil{}; // Worker may be waiting for the GIL.
+    thread_.join();
+  }
+
+  // Enqueue the expression evaluation.
+  void submit(Connection& connection,
+              std::string request_id,
+              std::string expression) {
+    {
+      const std::scoped_lock lock{mutex_};
+      queue_.push_back({.connection = &connection,
+                        .request_id = std::move(request_id),
+                        .expression = std::move(expression)});
+    }
+    condition_.notify_one();
+  }
+
+  // Cancel the pending expression evaluation. Evaluation that has already
+  // started cannot be cancelled.
+  auto cancel(Connection& connection, std::string_view request_id) -> bool {
+    const std::scoped_lock lock{mutex_};
+    const auto iter =
+        std::ranges::find_if(queue_, [&connection, request_id](const auto& r) {
+          return r.connection == &connection && r.request_id == request_id;
+        });
+    if (iter == queue_.end()) return false;
+    queue_.erase(iter);
+    return true;
+  }
+
+  // Discard the pending requests of the closed connection.
+  void forget(Connection& connection) {
+    const std::scoped_lock lock{mutex_};
+    std::erase_if(queue_, [&connection](const auto& r) {
+      return r.connection == &connection;
+    });
+    if (current_ == &connection) current_ = nullptr;
+  }
+
+private:
+
+  struct Request {
+    Connection* connection;
+    std::string request_id;
+    std::string expression;
+  };
+
+  void run_() {
+    if (interpreter_ == nullptr) {
+      const py::AcquireGIL acquire_gil{};
+      sub_interpreter_.emplace();
+    }
+
+    // Resolve the callables, that are needed for every request, only once.
+    // NumPy does not support subinterpreters, so arrays are returned only by
+    // the main interpreter.
+    with_python_([this] {
+      json_dumps_ = py::import_("json").attr("dumps");
+      if (sub_interpreter_.has_value()) return;
+      numpy_ascontiguousarray_ = py::import_("numpy").attr("ascontiguousarray");
+    });
+    while (true) {
+      Request request;
+      {
+        std::unique_lock lock{mutex_};
+        condition_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (stopping_) break;
+        request = std::move(queue_.front());
+        queue_.pop_front();
+        current_ = request.connection;
+      }
+      try {
+        evaluate_(request);
+      } catch (const std::exception& e) {
+        const std::scoped_lock lock{mutex_};
+        if (current_ == nullptr) continue;
+        send_error(*current_, request.request_id, "RuntimeError", e.what());
+        current_ = nullptr;
+      }
+    }
+    with_python_([this] {
+      json_dumps_ = {};
+      numpy_ascontiguousarray_ = {};
+    });
+    sub_interpreter_.reset();
+  }
+
+  // Run the function with the GIL of the worker's interpreter held.
+  template<class Func>
+  void with_python_(Func func) const {
+    if (sub_interpreter_.has_value()) {
+      const py::embed::EnterInterpreter enter{*sub_interpreter_};
+      func();
+    } else {
+      const py::AcquireGIL acquire_gil{};
+      func();
+    }
+  }
+
+  void evaluate_(const Request& request) {
+    with_python_([this, &request] { respond_(request); });
+  }
+
+  void respond_(const Request& request) {
+    std::optional<py::Object> result;
+    std::optional<py::NDArray> array;
+    std::string array_kind;
+    std::string text;
+    try {
+      result = sub_interpreter_.has_value() ?
+                   sub_interpreter_->eval(request.expression) :
+                   interpreter_->eval(request.expression);
+      if (numpy_ascontiguousarray_.valid() &&
+          py::NDArray::isinstance(*result)) {
+        array = py::expect<py::NDArray>(*result);
+        result.reset();
+        array_kind = array->kind().name();
+        if (!array->is_contiguous()) {
+          array = py::expect<py::NDArray>(numpy_ascontiguousarray_(*array));
+        }
+      }
+    } catch (const py::ErrorException& e) {
+      crow::json::wvalue response;
+      response["requestID"] = request.request_id;
+      response["status"] = "error";
+      response["result"]["type"] = py::type(e.error()).fully_qualified_name();
+      response["result"]["error"] = py::str(e.error());
+      if (const auto tb = e.error().traceback(); tb) {
+        response["traceback"] = py::expect<py::Traceback>(tb).render();
+      }
+      text = response.dump();
+      result.reset(), array.reset();
+    }
+    if (result.has_value()) {
+      // Only the result itself is encoded by Python, the envelope is written
+      // directly.
+      const auto result_text = py::extract<std::string>(json_dumps_(*result));
+      text = R"({"requestID":)";
+      text += crow::json::wvalue{request.request_id}.dump();
+      text += R"(,"status":"success","result":)";
+      text += result_text;
+      text += '}';
+    }
+
+    // Connection may have been closed while the expression was evaluated.
+    const std::scoped_lock lock{mutex_};
+    if (current_ == nullptr) return;
+    if (array.has_value()) {
+      send_array(*current_,
+                 request.request_id,
+                 array_kind,
+                 array->shape(),
+                 array->data());
+    } else {
+      current_->send_text(text);
+    }
+    current_ = nullptr;
+  }
+
+  const py::embed::Interpreter* interpreter_;
+  std::optional<py::embed::SubInterpreter> sub_interpreter_;
+  py::Object json_dumps_;
+  py::Object numpy_ascontiguousarray_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Request> queue_;
+  Connection* current_ = nullptr;
+  bool stopping_ = false;
+  std::thread thread_;
+
+}; // class PythonWorker
+
+// Pool of the Python expression evaluators.
+//
+// First worker evaluates the expressions in the main interpreter, and the
+// others in their own subinterpreters. Connections are assigned to the
+// workers in the round-robin order, so that the expressions of different
+// connections are evaluated in parallel.
+class PythonWorkerPool final {
+public:
+
+  // Start the workers.
+  PythonWorkerPool(const py::embed::Interpreter& interpreter,
+                   size_t num_workers) {
+    TIT_ASSERT(num_workers > 0, "Number of workers must be positive!");
+    workers_.push_back(std::make_unique<PythonWorker>(&interpreter));
+    for (size_t i = 1; i < num_workers; ++i) {
+      workers_.push_back(std::make_unique<PythonWorker>(nullptr));
+    }
+  }
+
+  // Enqueue the expression evaluation.
+  void submit(Connection& connection,
+              std::string request_id,
+              std::string expression) {
+    worker_(connection).submit(connection,
+                               std::move(request_id),
+                               std::move(expression));
+  }
+
+  // Cancel the pending expression evaluation.
+  auto cancel(Connection& connection, std::string_view request_id) -> bool {
+    return worker_(connection).cancel(connection, request_id);
+  }
+
+  // Discard the pending requests of the closed connection.
+  void forget(Connection& connection) {
+    PythonWorker* worker = nullptr;
+    {
+      const std::scoped_lock lock{mutex_};
+      const auto iter = assignments_.find(&connection);
+      if (iter == assignments_.end()) return;
+      worker = workers_[iter->second].get();
+      assignments_.erase(iter);
+    }
+    worker->forget(connection);
+  }
+
+private:
+
+  auto worker_(Connection& connection) -> PythonWorker& {
+    const std::scoped_lock lock{mutex_};
+    const auto [iter, inserted] =
+        assignments_.try_emplace(&connection, next_worker_);
+    if (inserted) next_worker_ = (next_worker_ + 1) % workers_.size();
+    return *workers_[iter->second];
+  }
+
+  std::vector<std::unique_ptr<PythonWorker>> workers_;
+  std::mutex mutex_;
+  std::unordered_map<Connection*, size_t> assignments_;
+  size_t next_worker_ = 0;
+
+}; // class PythonWorkerPool
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Data storage requests, served without Python.
+class StorageHandler final {
+public:
+
+  // Construct a handler for the storage at the given path. Storage is opened
+  // on the first request.
+  explicit StorageHandler(std::filesystem::path path)
+      : path_{std::move(path)} {}
+
+  // Handle the request. Returns false if the command is unknown.
+  auto handle(Connection& connection,
+              const std::string& request_id,
+              const crow::json::rvalue& request) -> bool {
+    const std::string command = request["command"].s();
+    const std::scoped_lock lock{mutex_};
+    auto& storage = open_();
+    if (command == "series") {
+      crow::json::wvalue::list result;
+      for (const auto series : storage.series()) {
+        crow::json::wvalue item;
+        item["id"] = series.id().get();
+        item["parameters"] = series.parameters();
+        item["numTimeSteps"] = series.num_time_steps();
+        result.push_back(std::move(item));
+      }
+      send_result_(connection, request_id, std::move(result));
+    } else if (command == "timeSteps") {
+      const data::DataSeriesID series_id{request["series"].i()};
+      if (!storage.check_series(series_id)) TIT_THROW("Invalid series ID.");
+      crow::json::wvalue::list result;
+      for (const auto time_step : storage.series_time_steps(series_id)) {
+        crow::json::wvalue item;
+        item["id"] = time_step.id().get();
+        item["time"] = time_step.time();
+        result.push_back(std::move(item));
+      }
+      send_result_(connection, request_id, std::move(result));
+    } else if (command == "arrays") {
+      const data::DataTimeStepID time_step_id{request["timeStep"].i()};
+      if (!storage.check_time_step(time_step_id)) {
+        TIT_THROW("Invalid time step ID.");
+      }
+      const auto list_arrays = [](const auto& dataset) {
+        crow::json::wvalue::list arrays;
+        for (const auto& [name, array] : dataset.arrays()) {
+          crow::json::wvalue item;
+          item["name"] = name;
+          item["id"] = array.id().get();
+          item["type"] = array.type().name();
+          item["size"] = array.size();
+          arrays.push_back(std::move(item));
+        }
+        return arrays;
+      };
+      crow::json::wvalue result;
+      result["uniforms"] =
+          list_arrays(storage.time_step_uniforms(time_step_id));
+      result["varyings"] =
+          list_arrays(storage.time_step_varyings(time_step_id));
+      send_result_(connection, request_id, std::move(result));
+    } else if (command == "array") {
+      const data::DataArrayID array_id{request["array"].i()};
+      if (!storage.check_array(array_id)) TIT_THROW("Invalid array ID.");
+      const auto type = storage.array_type(array_id);
+      const auto size = storage.array_size(array_id);
+      const auto first =
+          request.has("first") ? static_cast<size_t>(request["first"].u()) : 0;
+      const auto count =
+          request.has("count") ? static_cast<size_t>(request["count"].u()) :
+                                 size - std::min(first, size);
+      // Whole arrays are read through the cache, so that scrubbing over the
+      // recent time steps does not decode them again. Ranges of the cached
+      // arrays are also served from the cache.
+      data::DataArrayCache::Buffer cached;
+      std::vector<byte_t> range;
+      if (first == 0 && count == size) {
+        cached = storage.array_data_read(array_id);
+      } else {
+        range = storage.array_data_read_range(array_id, first, count);
+      }
+      const std::span<const byte_t> bytes{cached != nullptr ? *cached : range};
+      std::vector<size_t> shape{bytes.size() / type.width()};
+      if (type.rank() != data::DataRank::scalar) shape.push_back(type.dim());
+      if (type.rank() == data::DataRank::matrix) shape.push_back(type.dim());
+      send_array_(connection, request_id, request, type, shape, bytes);
+    } else if (command == "decimate") {
+      const data::DataArrayID positions_id{request["positions"].i()};
+      const data::DataArrayID array_id{request["array"].i()};
+      if (!storage.check_array(positions_id) ||
+          !storage.check_array(array_id)) {
+        TIT_THROW("Invalid array ID.");
+      }
+      const auto size = storage.array_size(positions_id);
+      if (storage.array_size(array_id) != size) {
+        TIT_THROW("Position and data array sizes do not match.");
+      }
+      const auto indices = decimate_(storage, positions_id, request);
+      const auto type = storage.array_type(array_id);
+      const auto width = type.width();
+      const auto bytes = storage.array_data_read(array_id);
+      std::vector<byte_t> result(indices.size() * width);
+      for (size_t i = 0; i < indices.size(); ++i) {
+        std::memcpy(&result[i * width], &(*bytes)[indices[i] * width], width);
+      }
+      std::vector<size_t> shape{indices.size()};
+      if (type.rank() != data::DataRank::scalar) shape.push_back(type.dim());
+      if (type.rank() == data::DataRank::matrix) shape.push_back(type.dim());
+      send_array_(connection, request_id, request, type, shape, result);
+    } else {
+      return query_(connection, request_id, command, request, storage);
+    }
+    return true;
+  }
+
+private:
+
+  // Default and maximal decimation resolution, in cells per axis.
+  static constexpr size_t DefaultResolution = 256;
+  static constexpr size_t MaxResolution = 4096;
+
+  // Default and maximal number of the histogram and profile bins.
+  static constexpr size_t DefaultNumBins = 64;
+  static constexpr size_t MaxNumBins = 65536;
+
+  // Handle the query, that is reduced on the server side, so that only the
+  // summary is sent. Returns false if the command is unknown.
+  static auto query_(Connection& connection,
+                     const std::string& request_id,
+                     const std::string& command,
+                     const crow::json::rvalue& request,
+                     const data::DataStorage& storage) -> bool {
+    const auto read_values = [&storage](const crow::json::rvalue& id) {
+      const data::DataArrayID array_id{id.i()};
+      if (!storage.check_array(array_id)) TIT_THROW("Invalid array ID.");
+      const auto type = storage.array_type(array_id);
+      const auto num_components = type.width() / type.kind().width();
+      auto values = to_float64(type, *storage.array_data_read(array_id));
+      return std::pair{std::move(values), num_components};
+    };
+    const auto num_bins = [&request] {
+      const auto result = request.has("bins") ?
+                              static_cast<size_t>(request["bins"].u()) :
+                              DefaultNumBins;
+      if (result == 0 || result > MaxNumBins) {
+        TIT_THROW("Number of bins must be between 1 and {}.", MaxNumBins);
+      }
+      return result;
+    };
+    const auto component = [&request](const char* key,
+                                      size_t fallback,
+                                      size_t num_components) {
+      const auto result =
+          request.has(key) ? static_cast<size_t>(request[key].u()) : fallback;
+      if (result >= num_components) {
+        TIT_THROW("Component '{}' is out of range, there are only {}.",
+                  key,
+                  num_components);
+      }
+      return result;
+    };
+    if (command == "stats") {
+      // Minimum, maximum, sum and mean of each component.
+      const auto [values, num_components] = read_values(request["array"]);
+      const auto count = values.size() / num_components;
+      crow::json::wvalue::list min_list;
+      crow::json::wvalue::list max_list;
+      crow::json::wvalue::list sum_list;
+      crow::json::wvalue::list mean_list;
+      for (size_t c = 0; c < num_components && count != 0; ++c) {
+        const auto summary = summarize(values, num_components, c);
+        min_list.emplace_back(summary.min);
+        max_list.emplace_back(summary.max);
+        sum_list.emplace_back(summary.sum);
+        mean_list.emplace_back(summary.sum / static_cast<float64_t>(count));
+      }
+      crow::json::wvalue result;
+      result["count"] = count;
+      result["min"] = std::move(min_list);
+      result["max"] = std::move(max_list);
+      result["sum"] = std::move(sum_list);
+      result["mean"] = std::move(mean_list);
+      send_result_(connection, request_id, std::move(result));
+    } else if (command == "histogram") {
+      // Histogram of the component over the `low` and `high` range, or over
+      // the range of the values. Values outside of the range are skipped.
+      const auto [values, num_components] = read_values(request["array"]);
+      const auto c = component("component", 0, num_components);
+      const auto bins = num_bins();
+      auto low = 0.0;
+      auto high = 0.0;
+      if (request.has("low") && request.has("high")) {
+        low = request["low"].d();
+        high = request["high"].d();
+      } else if (!values.empty()) {
+        const auto summary = summarize(values, num_components, c);
+        low = summary.min;
+        high = summary.max;
+      }
+      const auto scale = high > low ? static_cast<float64_t>(bins) /
+                                          (high - low) :
+                                      0.0;
+      par::AccumBuffer<size_t> buffer;
+      buffer.reset(bins);
+      par::for_each(
+          std::views::iota(size_t{0}, values.size() / num_components),
+          [&values, num_components, c, low, high, scale, bins, &buffer](
+              size_t i) {
+            const auto val = values[i * num_components + c];
+            if (!(low <= val && val <= high)) return;
+            const auto bin = static_cast<size_t>((val - low) * scale);
+            buffer.local()[std::min(bin, bins - 1)] += 1;
+          });
+      std::vector<size_t> counts(bins);
+      buffer.reduce_into(counts);
+      crow::json::wvalue::list counts_list;
+      for (const auto count : counts) counts_list.emplace_back(count);
+      crow::json::wvalue result;
+      result["low"] = low;
+      result["high"] = high;
+      result["counts"] = std::move(counts_list);
+      send_result_(connection, request_id, std::move(result));
+    } else if (command == "kineticEnergy") {
+      // Total kinetic energy of the particles, `sum(m * |v|^2) / 2`.
+      const auto [masses, mass_components] = read_values(request["mass"]);
+      const auto [velocities, dim] = read_values(request["velocity"]);
+      if (mass_components != 1 || masses.size() * dim != velocities.size()) {
+        TIT_THROW("Mass must be a scalar array, and velocity must be "
+                  "a vector array of the same size.");
+      }
+      const auto energy = par::transform_reduce(
+          std::views::iota(size_t{0}, masses.size()),
+          0.0,
+          std::plus{},
+          [&masses, &velocities, dim](size_t i) {
+            auto velocity_sqr = 0.0;
+            for (size_t d = 0; d < dim; ++d) {
+              velocity_sqr += pow2(velocities[i * dim + d]);
+            }
+            return masses[i] * velocity_sqr / 2;
+          });
+      crow::json::wvalue result;
+      result["energy"] = energy;
+      send_result_(connection, request_id, std::move(result));
+    } else if (command == "profile") {
+      // Maximum of the `height` coordinate of the positions over the bins
+      // along the `axis` coordinate, such as the free surface height. Empty
+      // bins are null.
+      const auto [positions, dim] = read_values(request["positions"]);
+      if (positions.empty()) TIT_THROW("Positions must not be empty.");
+      const auto axis = component("axis", 0, dim);
+      const auto height = component("height", dim - 1, dim);
+      const auto bins = num_bins();
+      const auto summary = summarize(positions, dim, axis);
+      const auto low = summary.min;
+      const auto high = summary.max;
+      const auto scale = high > low ? static_cast<float64_t>(bins) /
+                                          (high - low) :
+                                      0.0;
+      const auto profile = par::fold(
+          std::views::iota(size_t{0}, positions.size() / dim),
+          std::vector(bins, -std::numeric_limits<float64_t>::infinity()),
+          [&positions, dim, axis, height, low, scale, bins](
+              std::vector<float64_t> maxima,
+              size_t i) {
+            const auto bin = static_cast<size_t>(
+                (positions[i * dim + axis] - low) * scale);
+            auto& val = maxima[std::min(bin, bins - 1)];
+            val = std::max(val, positions[i * dim + height]);
+            return maxima;
+          },
+          [](std::vector<float64_t> a, const std::vector<float64_t>& b) {
+            for (size_t i = 0; i < a.size(); ++i) a[i] = std::max(a[i], b[i]);
+            return a;
+          });
+      crow::json::wvalue::list values_list;
+      for (const auto val : profile) {
+        if (std::isinf(val)) values_list.emplace_back(nullptr);
+        else values_list.emplace_back(val);
+      }
+      crow::json::wvalue result;
+      result["low"] = low;
+      result["high"] = high;
+      result["values"] = std::move(values_list);
+      send_result_(connection, request_id, std::move(result));
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  auto open_() -> data::DataStorage& {
+    if (!storage_.has_value()) {
+      if (!std::filesystem::exists(path_)) {
+        TIT_THROW("Storage '{}' does not exist.", path_.string());
+      }
+      storage_.emplace(path_, data::OpenMode::read_only);
+    }
+    return *storage_;
+  }
+
+  // Select the particles to display from the position array: one particle per
+  // cell of the grid of the requested `resolution` over the requested `low`
+  // and `high` bounds (or the bounding box of all the particles). Selection
+  // is deterministic, so that the arrays of the same time step, decimated
+  // with the same parameters, match each other.
+  static auto decimate_(const data::DataStorage& storage,
+                        data::DataArrayID positions_id,
+                        const crow::json::rvalue& request)
+      -> std::vector<size_t> {
+    const auto type = storage.array_type(positions_id);
+    const auto size = storage.array_size(positions_id);
+    if (size == 0) return {};
+    const auto resolution =
+        request.has("resolution") ?
+            static_cast<size_t>(request["resolution"].u()) :
+            DefaultResolution;
+    if (resolution == 0 || resolution > MaxResolution) {
+      TIT_THROW("Resolution must be between 1 and {}.", MaxResolution);
+    }
+    const auto bytes = storage.array_data_read(positions_id);
+    const auto decimate = [&]<class Num, size_t Dim>() {
+      using PointVec = Vec<Num, Dim>;
+      std::vector<PointVec> points(size);
+      for (size_t i = 0; i < size; ++i) {
+        std::array<Num, Dim> coords{};
+        std::memcpy(coords.data(),
+                    &(*bytes)[i * sizeof(coords)],
+                    sizeof(coords));
+        for (size_t d = 0; d < Dim; ++d) points[i][d] = coords[d];
+      }
+      geom::BBox<PointVec> box;
+      if (request.has("low") && request.has("high")) {
+        PointVec low{};
+        PointVec high{};
+        for (size_t d = 0; d < Dim; ++d) {
+          low[d] = static_cast<Num>(request["low"][d].d());
+          high[d] = static_cast<Num>(request["high"][d].d());
+        }
+        box = geom::BBox{low, high};
+      } else {
+        // Slightly grow the box, so that the points on its upper bound and
+        // the flat point sets end up inside of the grid.
+        box = geom::compute_bbox(points);
+        box.grow(static_cast<Num>(1.0e-6) *
+                 std::max(max_value(box.extents()), Num{1}));
+      }
+      const geom::Grid grid{box, Vec<size_t, Dim>(resolution)};
+      return geom::grid_decimate(points, grid);
+    };
+    using enum data::DataKind::ID;
+    if (type.rank() == data::DataRank::vector) {
+      const auto kind = type.kind().id();
+      const auto dim = type.dim();
+      if (kind == float32 && dim == 2) return decimate.operator()<float, 2>();
+      if (kind == float32 && dim == 3) return decimate.operator()<float, 3>();
+      if (kind == float64 && dim == 2) return decimate.operator()<double, 2>();
+      if (kind == float64 && dim == 3) return decimate.operator()<double, 3>();
+    }
+    TIT_THROW("Positions must be 2D or 3D floating-point vectors, got '{}'.",
+              type.name());
+  }
+
+  // Send the array, quantized if the request asks for the `quantize` bits.
+  static void send_array_(Connection& connection,
+                          const std::string& request_id,
+                          const crow::json::rvalue& request,
+                          data::DataType type,
+                          std::span<const size_t> shape,
+                          std::span<const byte_t> bytes) {
+    if (!request.has("quantize")) {
+      send_array(connection, request_id, type.kind().name(), shape, bytes);
+      return;
+    }
+    const auto bits = static_cast<size_t>(request["quantize"].u());
+    const auto [quants, quantization] = quantize(type, bytes, bits);
+    const auto kind = bits == 8 ? data::kind_of<uint8_t> :
+                                  data::kind_of<uint16_t>;
+    send_array(connection,
+               request_id,
+               kind.name(),
+               shape,
+               quants,
+               quantization);
+  }
+
+  static void send_result_(Connection& connection,
+                           const std::string& request_id,
+                           crow::json::wvalue result) {
+    crow::json::wvalue response;
+    response["requestID"] = request_id;
+    response["status"] = "success";
+    response["result"] = std::move(result);
+    connection.send_text(response.dump());
+  }
+
+  std::filesystem::path path_;
+  std::mutex mutex_;
+  std::optional<data::DataStorage> storage_;
+
+}; // class StorageHandler
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Live time step notifications.
+//
+// Solver publishes a summary of each new time step to the storage event
+// channel, and the summaries are forwarded to the subscribed connections, so
+// that they need not poll the storage. Summaries are pushed as the `timeStep`
+// event messages, that carry no request ID, since the subscription request
+// itself is answered only once.
+class TimeStepNotifier final {
+public:
+
+  TIT_NOT_COPYABLE_OR_MOVABLE(TimeStepNotifier);
+
+  // Start listening to the events of the storage at the given path.
+  explicit TimeStepNotifier(const std::filesystem::path& storage_path)
+      : subscriber_{storage_path}, thread_{[this] { run_(); }} {}
+
+  // Stop listening.
+  ~TimeStepNotifier() {
+    stopping_ = true;
+    thread_.join();
+  }
+
+  // Subscribe the connection, and acknowledge the request.
+  void subscribe(Connection& connection, const std::string& request_id) {
+    {
+      const std::scoped_lock lock{mutex_};
+      if (std::ranges::find(subscriptions_, &connection) ==
+          subscriptions_.end()) {
+        subscriptions_.push_back(&connection);
+      }
+    }
+    crow::json::wvalue response;
+    response["requestID"] = request_id;
+    response["status"] = "success";
+    response["result"] = true;
+    connection.send_text(response.dump());
+  }
+
+  // Remove the subscription of the closed connection.
+  void forget(Connection& connection) {
+    const std::scoped_lock lock{mutex_};
+    std::erase(subscriptions_, &connection);
+  }
+
+private:
+
+  void run_() {
+    using namespace std::chrono_literals;
+    while (!stopping_) {
+      const auto event = subscriber_.receive(100ms);
+      if (!event.has_value()) continue;
+      crow::json::wvalue message;
+      message["event"] = "timeStep";
+      message["result"]["series"] = event->series_id.get();
+      message["result"]["timeStep"] = event->time_step_id.get();
+      message["result"]["time"] = event->time;
+      message["result"]["numParticles"] = event->num_particles;
+      const auto text = message.dump();
+      const std::scoped_lock lock{mutex_};
+      for (auto* const connection : subscriptions_) {
+        connection->send_text(text);
+      }
+    }
+  }
+
+  data::DataEventSubscriber subscriber_;
+  std::mutex mutex_;
+  std::vector<Connection*> subscriptions_;
+  std::atomic<bool> stopping_ = false;
+  std::thread thread_;
+
+}; // class TimeStepNotifier
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 auto run_backend(CmdArgs args) -> int {
@@ -60,55 +1110,114 @@ auto run_backend(CmdArgs args) -> int {
     return interpreter.exec_file(file_name) ? 0 : 1;
   }
 
+  const std::filesystem::path storage_path{
+      get_env("TIT_BACKEND_STORAGE").value_or("./particles.ttdb")};
+  auto num_interpreters = get_env<size_t>("TIT_BACKEND_NUM_INTERPRETERS", 1);
+  if (num_interpreters > 1 && !py::embed::SubInterpreter::supported()) {
+    TIT_WARN("Python subinterpreters are not supported, "
+             "using a single interpreter.");
+    num_interpreters = 1;
+  }
+  num_interpreters = std::max<size_t>(num_interpreters, 1);
+  PythonWorkerPool python_workers{interpreter, num_interpreters};
+  StorageHandler storage_handler{storage_path};
+  // Live notifications are optional: the storage directory may be read-only,
+  // or another backend may already listen to the storage.
+  std::optional<TimeStepNotifier> time_step_notifier;
+  try {
+    time_step_notifier.emplace(storage_path);
+  } catch (const std::exception& e) {
+    TIT_WARN("Live time step notifications are disabled: {}", e.what());
+  }
+
   crow::SimpleApp app;
 
+  // Requests are JSON objects with the `requestID` field and either the
+  // `expression` to evaluate in Python, the `cancel` flag to cancel the
+  // pending evaluation, the `subscribe` flag to receive the new time steps,
+  // or the storage `command`.
   CROW_WEBSOCKET_ROUTE(app, "/ws")
-      .onmessage([&interpreter](crow::websocket::connection& connection,
-                                const std::string& data,
-                                bool is_binary) { //
-        TIT_ASSERT(!is_binary, "Binary messages are not supported.");
-        const py::AcquireGIL acquire_gil{};
-        const auto json = py::import_("json");
-        const py::Dict response;
+      .onclose([&python_workers, &time_step_notifier](
+                   Connection& connection,
+                   const std::string& /*reason*/,
+                   uint16_t /*code*/) {
+        python_workers.forget(connection);
+        if (time_step_notifier.has_value()) {
+          time_step_notifier->forget(connection);
+        }
+      })
+      .onmessage([&python_workers, &storage_handler, &time_step_notifier](
+                     Connection& connection,
+                     const std::string& data,
+                     bool is_binary) {
+        if (is_binary) {
+          send_error(connection, "", "TypeError", "Binary requests.");
+          return;
+        }
+        // Request ID is read inside of the `try` block, so that no malformed
+        // request escapes the handler and stops the backend.
+        std::string request_id;
         try {
-          const auto request = py::expect<py::Dict>(json.attr("loads")(data));
-          response["requestID"] = request["requestID"];
-          const auto expr = py::extract<std::string>(request["expression"]);
-          response["result"] = interpreter.eval(expr);
-          response["status"] = "success";
-        } catch (const py::ErrorException& e) {
-          const py::Dict error;
-          error["type"] = py::type(e.error()).fully_qualified_name();
-          error["error"] = py::str(e.error());
-          if (const auto tb = e.error().traceback(); tb) {
-            response["traceback"] = py::expect<py::Traceback>(tb).render();
+          const auto request = crow::json::load(data);
+          if (!request || request.t() != crow::json::type::Object ||
+              !request.has("requestID") ||
+              request["requestID"].t() != crow::json::type::String) {
+            send_error(connection, "", "ValueError", "Malformed request.");
+            return;
+          }
+          request_id = request["requestID"].s();
+          if (request.has("cancel")) {
+            if (!python_workers.cancel(connection, request_id)) return;
+            send_error(connection,
+                       request_id,
+                       "CancelledError",
+                       "Request was cancelled.");
+          } else if (request.has("subscribe")) {
+            if (!time_step_notifier.has_value()) {
+              send_error(connection,
+                         request_id,
+                         "RuntimeError",
+                         "Live time step notifications are disabled.");
+              return;
+            }
+            time_step_notifier->subscribe(connection, request_id);
+          } else if (request.has("expression")) {
+            python_workers.submit(connection,
+                                 request_id,
+                                 request["expression"].s());
+          } else if (request.has("command")) {
+            if (!storage_handler.handle(connection, request_id, request)) {
+              send_error(connection,
+                         request_id,
+                         "ValueError",
+                         "Unknown command.");
+            }
+          } else {
+            send_error(connection, request_id, "ValueError", "Bad request.");
           }
-          response["result"] = error;
-          response["status"] = "error";
+        } catch (const std::exception& e) {
+          send_error(connection, request_id, "RuntimeError", e.what());
         }
-        connection.send_text(
-            py::extract<std::string>(json.attr("dumps")(response)));
       });
 
   CROW_ROUTE(app, "/")
-  ([&root_dir](const crow::request& /*request*/, crow::response& response) {
-    const auto index_html = root_dir / "frontend" / "index.html";
-    response.set_static_file_info_unsafe(index_html.native());
-    response.end();
+  ([&root_dir](const crow::request& request, crow::response& response) {
+    send_static_file(request, response, root_dir / "frontend" / "index.html");
   });
   CROW_ROUTE(app, "/<path>")
-  ([&root_dir](const crow::request& /*request*/,
+  ([&root_dir](const crow::request& request,
                crow::response& response,
                const std::filesystem::path& file_name) {
     auto file_path = root_dir / "frontend" / file_name;
     if (std::filesystem::is_directory(file_path)) file_path /= "index.html";
-    response.set_static_file_info_unsafe(file_path.native());
-    response.end();
+    send_static_file(request, response, file_path);
   });
 
   /// @todo Pass port as a command line argument.
   const py::ReleaseGIL release_gil{};
-  app.port(get_env<uint16_t>("TIT_BACKEND_PORT", 18080)).run();
+  app.port(get_env<uint16_t>("TIT_BACKEND_PORT", 18080))
+      .multithreaded()
+      .run();
 
   return 0;
 }
@@ -0,0 +1,436 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *|
+ * Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+ * Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+\* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tit/core/basic_types.hpp"
+#include "tit/core/cmd.hpp"
+#include "tit/core/exception.hpp"
+#include "tit/core/log.hpp"
+#include "tit/core/options.hpp"
+#include "tit/core/par/algorithms.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/sys/utils.hpp"
+
+#include "tit/data/storage.hpp"
+#include "tit/data/type.hpp"
+
+namespace tit::data {
+namespace {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Contents of the data array.
+using ArrayContents = DataArrayContents<DataStorage>;
+
+// Number of the values that are generated at once, for the data arrays that
+// are not stored in the storage.
+constexpr size_t GeneratedBlockSize = 64 * 1024;
+
+// VTK type name of the data kind, if the kind is supported by VTK.
+auto vtk_type_name(DataKind kind) -> std::optional<std::string_view> {
+  using enum DataKind::ID;
+  switch (kind.id()) {
+    case int8:    return "Int8";
+    case uint8:   return "UInt8";
+    case int16:   return "Int16";
+    case uint16:  return "UInt16";
+    case int32:   return "Int32";
+    case uint32:  return "UInt32";
+    case int64:   return "Int64";
+    case uint64:  return "UInt64";
+    case float32: return "Float32";
+    case float64: return "Float64";
+    default:      return std::nullopt;
+  }
+}
+
+// Number of the scalar components of the data type.
+auto num_components(DataType type) -> size_t {
+  return type.width() / type.kind().width();
+}
+
+// Escape the string for the XML attribute.
+auto xml_escape(std::string_view str) -> std::string {
+  std::string result;
+  for (const auto c : str) {
+    switch (c) {
+      case '&': result += "&amp;"; break;
+      case '<': result += "&lt;"; break;
+      case '>': result += "&gt;"; break;
+      case '"': result += "&quot;"; break;
+      default:  result += c; break;
+    }
+  }
+  return result;
+}
+
+// Write the bytes into the file.
+void write_bytes(std::FILE* file, std::span<const byte_t> bytes) {
+  if (std::fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size()) {
+    TIT_THROW("Unable to write the output file!");
+  }
+}
+void write_bytes(std::FILE* file, std::string_view str) {
+  write_bytes(file, std::as_bytes(std::span{str}));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// VTK XML file writer, that stores the data arrays in the raw appended
+// section. Arrays that are stored in the buffers are written from them
+// directly, the others are generated in blocks while being written.
+class VTKWriter final {
+public:
+
+  // Function that fills the block of the generated data array, starting
+  // from the value with the given index.
+  using Generator = std::function<void(size_t first, std::span<byte_t> data)>;
+
+  // Add the data array, that is written from the buffer, and return its XML
+  // element.
+  auto add_array(std::string_view name,
+                 DataType type,
+                 std::span<const byte_t> data,
+                 std::string_view attributes = "") -> std::string {
+    const auto type_name = vtk_type_name(type.kind());
+    TIT_ASSERT(type_name.has_value(), "Unsupported data type!");
+    blocks_.push_back({.data = data, .size = data.size()});
+    return element_(name, *type_name, num_components(type), attributes);
+  }
+
+  // Add the data array of @p count values, that is generated while being
+  // written, and return its XML element.
+  auto add_generated_array(std::string_view name,
+                           DataKind kind,
+                           size_t num_components,
+                           size_t count,
+                           Generator generator) -> std::string {
+    const auto type_name = vtk_type_name(kind);
+    TIT_ASSERT(type_name.has_value(), "Unsupported data type!");
+    const auto width = kind.width() * num_components;
+    blocks_.push_back({.size = count * width,
+                       .width = width,
+                       .generator = std::move(generator)});
+    return element_(name, *type_name, num_components, "");
+  }
+
+  // Write the file: the XML header, that refers to the data arrays, and then
+  // the appended data arrays.
+  void write(const std::filesystem::path& path, std::string_view header) {
+    const auto file = open_file(path.c_str(), "wb");
+    write_bytes(file.get(), header);
+    write_bytes(file.get(), "<AppendedData encoding=\"raw\">\n_");
+    std::vector<byte_t> buffer;
+    for (const auto& block : blocks_) {
+      const auto size = static_cast<uint64_t>(block.size);
+      write_bytes(file.get(), std::as_bytes(std::span{&size, 1}));
+      if (!block.generator) {
+        write_bytes(file.get(), block.data);
+        continue;
+      }
+      const auto count = block.size / block.width;
+      for (size_t first = 0; first < count; first += GeneratedBlockSize) {
+        buffer.resize(std::min(GeneratedBlockSize, count - first) *
+                      block.width);
+        block.generator(first, buffer);
+        write_bytes(file.get(), buffer);
+      }
+    }
+    write_bytes(file.get(), "\n</AppendedData>\n</VTKFile>\n");
+  }
+
+private:
+
+  struct Block_ final {
+    std::span<const byte_t> data;
+    size_t size = 0;
+    size_t width = 0;
+    Generator generator;
+  };
+
+  // Make the XML element of the data array and advance the offset.
+  auto element_(std::string_view name,
+                std::string_view type_name,
+                size_t num_components,
+                std::string_view attributes) -> std::string {
+    auto element = std::format(
+        "<DataArray type=\"{}\" Name=\"{}\" NumberOfComponents=\"{}\"{} "
+        "format=\"appended\" offset=\"{}\"/>\n",
+        type_name,
+        xml_escape(name),
+        num_components,
+        attributes,
+        offset_);
+    offset_ += sizeof(uint64_t) + blocks_.back().size;
+    return element;
+  }
+
+  size_t offset_ = 0;
+  std::vector<Block_> blocks_;
+
+}; // class VTKWriter
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Export the time step into the VTK unstructured grid file.
+//
+// Particles are stored as the vertex cells. Varying arrays are stored as the
+// point data, and the uniform arrays are stored as the field data, along with
+// the time value. Arrays of the types that are not supported by VTK are
+// skipped.
+void export_vtu(const std::filesystem::path& path,
+                float64_t time,
+                std::span<const ArrayContents> uniforms,
+                std::span<const ArrayContents> varyings,
+                std::string_view positions_name) {
+  VTKWriter writer;
+  const auto supported = [](const ArrayContents& item) {
+    if (vtk_type_name(item.array.type().kind()).has_value()) return true;
+    TIT_WARN("Array '{}' of type '{}' is not supported by VTK, skipping.",
+             item.name,
+             item.array.type().name());
+    return false;
+  };
+
+  // Find the particle positions.
+  const auto positions_iter =
+      std::ranges::find(varyings, positions_name, &ArrayContents::name);
+  if (positions_iter == varyings.end()) {
+    TIT_THROW("Time step has no positions array '{}'.", positions_name);
+  }
+  const auto& positions = *positions_iter;
+  const auto positions_type = positions.array.type();
+  const auto dim = num_components(positions_type);
+  if (dim > 3 || !supported(positions)) {
+    TIT_THROW("Positions array '{}' has invalid type '{}'.",
+              positions_name,
+              positions_type.name());
+  }
+  const auto num_points = positions.data.size() / positions_type.width();
+
+  // Uniform arrays, and the time value.
+  auto header = std::format(
+      "<?xml version=\"1.0\"?>\n"
+      "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" "
+      "byte_order=\"LittleEndian\" header_type=\"UInt64\">\n"
+      "<UnstructuredGrid>\n"
+      "<FieldData>\n"
+      "<DataArray type=\"Float64\" Name=\"TimeValue\" NumberOfTuples=\"1\" "
+      "format=\"ascii\">{}</DataArray>\n",
+      time);
+  for (const auto& item : uniforms) {
+    if (!supported(item)) continue;
+    const auto num_tuples = item.data.size() / item.array.type().width();
+    header += writer.add_array(
+        item.name,
+        item.array.type(),
+        item.data,
+        std::format(" NumberOfTuples=\"{}\"", num_tuples));
+  }
+  header += "</FieldData>\n";
+
+  // Varying arrays.
+  header += std::format("<Piece NumberOfPoints=\"{0}\" NumberOfCells=\"{0}\">\n"
+                        "<PointData>\n",
+                        num_points);
+  for (const auto& item : varyings) {
+    if (&item == &positions || !supported(item)) continue;
+    if (item.data.size() != num_points * item.array.type().width()) {
+      TIT_WARN("Array '{}' does not match the number of particles, skipping.",
+               item.name);
+      continue;
+    }
+    header += writer.add_array(item.name, item.array.type(), item.data);
+  }
+  header += "</PointData>\n";
+
+  // Points must have three components, so the lower-dimensional positions
+  // are padded with zeroes.
+  header += "<Points>\n";
+  if (dim == 3) {
+    header += writer.add_array("Points", positions_type, positions.data);
+  } else {
+    const auto kind = positions_type.kind();
+    header += writer.add_generated_array(
+        "Points",
+        kind,
+        /*num_components=*/3,
+        num_points,
+        [&positions, dim, width = kind.width()](size_t first,
+                                                std::span<byte_t> data) {
+          std::ranges::fill(data, byte_t{0});
+          const auto count = data.size() / (3 * width);
+          for (size_t i = 0; i < count; ++i) {
+            std::ranges::copy(std::span{positions.data}.subspan(
+                                  (first + i) * dim * width,
+                                  dim * width),
+                              data.begin() + i * 3 * width);
+          }
+        });
+  }
+  header += "</Points>\n";
+
+  // Each particle is a vertex cell.
+  const auto generate_cells = [](auto func) {
+    return [func](size_t first, std::span<byte_t> data) {
+      using Val = decltype(func(size_t{0}));
+      const auto count = data.size() / sizeof(Val);
+      for (size_t i = 0; i < count; ++i) {
+        const auto val = func(first + i);
+        std::ranges::copy(std::as_bytes(std::span{&val, 1}),
+                          data.begin() + i * sizeof(Val));
+      }
+    };
+  };
+  constexpr uint8_t vtk_vertex = 1;
+  header += "<Cells>\n";
+  header += writer.add_generated_array(
+      "connectivity",
+      kind_of<int64_t>,
+      /*num_components=*/1,
+      num_points,
+      generate_cells([](size_t i) { return static_cast<int64_t>(i); }));
+  header += writer.add_generated_array(
+      "offsets",
+      kind_of<int64_t>,
+      /*num_components=*/1,
+      num_points,
+      generate_cells([](size_t i) { return static_cast<int64_t>(i + 1); }));
+  header += writer.add_generated_array(
+      "types",
+      kind_of<uint8_t>,
+      /*num_components=*/1,
+      num_points,
+      generate_cells([](size_t /*i*/) { return vtk_vertex; }));
+  header += "</Cells>\n"
+            "</Piece>\n"
+            "</UnstructuredGrid>\n";
+
+  writer.write(path, header);
+}
+
+// Export the ParaView collection file, that lists the time steps.
+void export_pvd(const std::filesystem::path& path,
+                std::span<const std::pair<float64_t, std::string>> steps) {
+  const auto file = open_file(path.c_str(), "w");
+  write_bytes(file.get(),
+              "<?xml version=\"1.0\"?>\n"
+              "<VTKFile type=\"Collection\" version=\"0.1\" "
+              "byte_order=\"LittleEndian\">\n"
+              "<Collection>\n");
+  for (const auto& [time, file_name] : steps) {
+    write_bytes(file.get(),
+                std::format("<DataSet timestep=\"{}\" part=\"0\" "
+                            "file=\"{}\"/>\n",
+                            time,
+                            xml_escape(file_name)));
+  }
+  write_bytes(file.get(), "</Collection>\n</VTKFile>\n");
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Worker, that exports the time steps.
+struct Worker final {
+  explicit Worker(const std::filesystem::path& path)
+      : storage{path, OpenMode::read_only} {}
+  DataStorage storage;
+  std::vector<ArrayContents> uniforms;
+  std::vector<ArrayContents> varyings;
+};
+
+// Data series is exported into the VTK unstructured grid files, one per time
+// step, and the ParaView collection file that lists them. Time steps are
+// exported in parallel, each worker thread reads them through its own
+// connection to the storage.
+auto export_main(CmdArgs args) -> int {
+  const Options options{args};
+  const std::filesystem::path input_path{
+      options.get("input").value_or("./particles.ttdb")};
+  const std::filesystem::path output_path{
+      options.get("output").value_or("./export")};
+  const auto series_index = options.get<size_t>("series");
+  const std::string positions_name{options.get("positions").value_or("r")};
+  if (const auto num_threads = options.get<size_t>("threads")) {
+    par::set_num_threads(*num_threads);
+  }
+  options.check_unused();
+  if (!std::filesystem::exists(input_path)) {
+    TIT_THROW("Data storage '{}' does not exist.", input_path.c_str());
+  }
+
+  // Select the data series, the last one by default.
+  const DataStorage storage{input_path, OpenMode::read_only};
+  std::vector<DataSeriesID> series_ids;
+  for (const auto series_id : storage.series_ids()) {
+    series_ids.push_back(series_id);
+  }
+  if (series_ids.empty()) TIT_THROW("Data storage has no data series.");
+  if (series_index.has_value() && *series_index >= series_ids.size()) {
+    TIT_THROW("Data series index {} is out of range, storage has {} series.",
+              *series_index,
+              series_ids.size());
+  }
+  const DataSeriesView series{
+      storage,
+      series_ids[series_index.value_or(series_ids.size() - 1)]};
+
+  // Collect the time steps.
+  const auto stem = input_path.stem().string();
+  std::vector<DataTimeStepID> step_ids;
+  std::vector<std::pair<float64_t, std::string>> steps;
+  for (const auto step : series.time_steps()) {
+    steps.emplace_back(step.time(),
+                       std::format("{}_{:06}.vtu", stem, step_ids.size()));
+    step_ids.push_back(step.id());
+  }
+  TIT_INFO("Exporting {} time steps into '{}'.",
+           steps.size(),
+           output_path.c_str());
+
+  // Export the time steps. Connections are opened before the export starts,
+  // so that the storage is not modified while it is being read.
+  std::filesystem::create_directories(output_path);
+  std::vector<std::unique_ptr<Worker>> workers(par::num_threads());
+  for (auto& worker : workers) worker = std::make_unique<Worker>(input_path);
+  par::static_for_each(
+      std::views::iota(size_t{0}, step_ids.size()),
+      [&workers, &step_ids, &steps, &output_path, &positions_name](
+          size_t thread_index,
+          size_t index) {
+        auto& worker = *workers[thread_index];
+        const DataTimeStepView step{worker.storage, step_ids[index]};
+        step.uniforms().read_all(worker.uniforms);
+        step.varyings().read_all(worker.varyings);
+        export_vtu(output_path / steps[index].second,
+                   steps[index].first,
+                   worker.uniforms,
+                   worker.varyings,
+                   positions_name);
+      });
+  export_pvd(output_path / std::format("{}.pvd", stem), steps);
+
+  return 0;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+} // namespace
+} // namespace tit::data
+
+TIT_IMPLEMENT_MAIN(data::export_main)
@@ -9,7 +9,12 @@ import { describe, it, expect } from "vitest";
 import { useState } from "react";
 import { z } from "zod";
 
-import { PyConnectionProvider, PyError, usePython } from "~/components/Python";
+import {
+  PyArray,
+  PyConnectionProvider,
+  PyError,
+  usePython,
+} from "~/components/Python";
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -100,6 +105,34 @@ describe("usePython", () => {
 
   // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+  it("runs code and returns arrays", async () => {
+    const TestComponent = () => {
+      const [result, setResult] = useState("");
+      const runCode = usePython();
+      runCode("__import__('numpy').arange(6.0).reshape(2, 3)", (result) => {
+        expect(result).toBeInstanceOf(PyArray);
+        const { kind, shape, data } = result as PyArray;
+        expect(data).toBeInstanceOf(Float64Array);
+        setResult(`${kind} [${shape.join(", ")}]: ${data.join(", ")}`);
+      });
+      return <div>{result}</div>;
+    };
+
+    render(
+      <PyConnectionProvider>
+        <TestComponent />
+      </PyConnectionProvider>
+    );
+
+    await waitFor(() => {
+      expect(
+        screen.getByText("float64_t [2, 3]: 0, 1, 2, 3, 4, 5")
+      ).toBeInTheDocument();
+    });
+  });
+
+  // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
   it("runs code and returns errors", async () => {
     const TestComponent = () => {
       const [result, setResult] = useState("");
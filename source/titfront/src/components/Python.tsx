@@ -46,6 +46,37 @@ export class PyError extends Error {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+/**
+ * Typed array of NumPy array data.
+ */
+export type PyTypedArray =
+  | Int8Array
+  | Uint8Array
+  | Int16Array
+  | Uint16Array
+  | Int32Array
+  | Uint32Array
+  | BigInt64Array
+  | BigUint64Array
+  | Float32Array
+  | Float64Array;
+
+/**
+ * NumPy array, transferred in binary form.
+ */
+export class PyArray {
+  /**
+   * Construct a new NumPy array.
+   */
+  constructor(
+    public readonly kind: string,
+    public readonly shape: number[],
+    public readonly data: PyTypedArray
+  ) {}
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 /**
  * Callback to pass the execution result.
  * @param result The result of the Python code or an error.
@@ -89,6 +120,72 @@ const PyResponseSchema = z.union([
   }),
 ]);
 
+const PyEventSchema = z.object({
+  event: z.string(),
+  result: z.unknown(),
+});
+
+const PyArrayHeaderSchema = z.object({
+  requestID: z.string(),
+  kind: z.string(),
+  shape: z.array(z.number()),
+  size: z.number(),
+  offset: z.number(),
+  quantization: z
+    .object({
+      bits: z.number(),
+      low: z.array(z.number()),
+      high: z.array(z.number()),
+    })
+    .optional(),
+});
+
+/**
+ * Restore the values of the quantized array, with a separate range for each
+ * component of the elements.
+ */
+function dequantize(
+  quants: PyTypedArray,
+  { bits, low, high }: { bits: number; low: number[]; high: number[] }
+): Float32Array {
+  const maxQuant = 2 ** bits - 1;
+  const numComponents = low.length;
+  const values = new Float32Array(quants.length);
+  for (let i = 0; i < quants.length; i++) {
+    const c = i % numComponents;
+    const scale = (high[c] - low[c]) / maxQuant;
+    values[i] = low[c] + Number(quants[i]) * scale;
+  }
+  return values;
+}
+
+function makeTypedArray(kind: string, buffer: ArrayBuffer): PyTypedArray {
+  switch (kind) {
+    case "int8_t":
+      return new Int8Array(buffer);
+    case "uint8_t":
+      return new Uint8Array(buffer);
+    case "int16_t":
+      return new Int16Array(buffer);
+    case "uint16_t":
+      return new Uint16Array(buffer);
+    case "int32_t":
+      return new Int32Array(buffer);
+    case "uint32_t":
+      return new Uint32Array(buffer);
+    case "int64_t":
+      return new BigInt64Array(buffer);
+    case "uint64_t":
+      return new BigUint64Array(buffer);
+    case "float32_t":
+      return new Float32Array(buffer);
+    case "float64_t":
+      return new Float64Array(buffer);
+    default:
+      throw new Error(`Unsupported array kind '${kind}'.`);
+  }
+}
+
 /**
  * Provide a connection to the Python server to the children.
  */
@@ -97,17 +194,60 @@ export const PyConnectionProvider: FC<{ children: ReactNode }> = ({
 }) => {
   const [webSocket, setWebSocket] = useState<WebSocket | null>(null);
   const pendingRequests = useRef(new Map<string, PyCallback>());
+  const pendingArrays = useRef(
+    new Map<string, { buffer: Uint8Array; received: number }>()
+  );
 
   useEffect(() => {
     const ws = new WebSocket(`ws://${window.location.host}/ws`);
+    ws.binaryType = "arraybuffer";
     ws.onopen = () => setWebSocket(ws);
     ws.onclose = () => setWebSocket(null);
     ws.onmessage = (event: MessageEvent) => {
-      // Parse and validate the message.
+      // Binary messages carry chunks of the array data.
+      if (event.data instanceof ArrayBuffer) {
+        const view = new DataView(event.data);
+        const headerSize = view.getUint32(0, true);
+        const { requestID, kind, shape, size, offset, quantization } =
+          PyArrayHeaderSchema.parse(
+            JSON.parse(
+              new TextDecoder().decode(
+                new Uint8Array(event.data, 4, headerSize)
+              )
+            )
+          );
+        let pending = pendingArrays.current.get(requestID);
+        if (pending === undefined) {
+          pending = { buffer: new Uint8Array(size), received: 0 };
+          pendingArrays.current.set(requestID, pending);
+        }
+        const chunk = new Uint8Array(event.data, 4 + headerSize);
+        pending.buffer.set(chunk, offset);
+        pending.received += chunk.byteLength;
+        if (pending.received < size) return;
+
+        // Array is complete, invoke the callback.
+        pendingArrays.current.delete(requestID);
+        const callback = pendingRequests.current.get(requestID);
+        assert(callback !== undefined, `No callback for request ${requestID}`);
+        const data = makeTypedArray(kind, pending.buffer.buffer);
+        if (quantization !== undefined) {
+          callback(
+            new PyArray("float32_t", shape, dequantize(data, quantization))
+          );
+        } else {
+          callback(new PyArray(kind, shape, data));
+        }
+        pendingRequests.current.delete(requestID);
+        return;
+      }
+
+      // Parse and validate the message. Event messages, e.g. the new time
+      // steps, are pushed without a request, and are not handled yet.
       assert(typeof event.data === "string", "Not a string message.");
-      const { requestID, status, result } = PyResponseSchema.parse(
-        JSON.parse(event.data)
-      );
+      const message: unknown = JSON.parse(event.data);
+      if (PyEventSchema.safeParse(message).success) return;
+      const { requestID, status, result } = PyResponseSchema.parse(message);
 
       // Invoke the callback.
       const callback = pendingRequests.current.get(requestID);
@@ -4,7 +4,9 @@
 \* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 /// <reference types="vitest" />
+import fs from "node:fs/promises";
 import path from "node:path";
+import zlib from "node:zlib";
 import react from "@vitejs/plugin-react";
 import tailwindcss from "@tailwindcss/vite";
 import { Plugin, defineConfig } from "vite";
@@ -22,6 +24,7 @@ export default defineConfig({
     }),
     tailwindcss(),
     titback(),
+    precompress(),
   ],
   resolve: {
     alias: {
@@ -59,3 +62,33 @@ function titback(): Plugin {
 }
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/// Vite plugin to write the Brotli and gzip compressed copies of the bundle
+/// files, so that the backend serves them without compressing on the fly.
+function precompress(): Plugin {
+  const extensions = [".html", ".js", ".css", ".svg", ".json", ".wasm"];
+  return {
+    name: "precompress-assets",
+    apply: "build",
+    async writeBundle(options, bundle) {
+      const outDir = options.dir ?? "dist";
+      const files = Object.keys(bundle).filter((fileName) =>
+        extensions.includes(path.extname(fileName))
+      );
+      await Promise.all(
+        files.map(async (fileName) => {
+          const filePath = path.join(outDir, fileName);
+          const data = await fs.readFile(filePath);
+          const brotli = zlib.brotliCompressSync(data, {
+            params: { [zlib.constants.BROTLI_PARAM_QUALITY]: 11 },
+          });
+          const gzip = zlib.gzipSync(data, { level: 9 });
+          await fs.writeFile(`${filePath}.br`, brotli);
+          await fs.writeFile(`${filePath}.gz`, gzip);
+        })
+      );
+    },
+  };
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
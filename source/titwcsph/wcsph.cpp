@@ -1,182 +1,459 @@
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
 #include "tit/core/basic_types.hpp"
 #include "tit/core/cmd.hpp"
+#include "tit/core/exception.hpp"
 #include "tit/core/log.hpp"
+#include "tit/core/math.hpp"
+#include "tit/core/memory_stats.hpp"
+#include "tit/core/options.hpp"
+#include "tit/core/par/control.hpp"
+#include "tit/core/par/task_arena.hpp"
+#include "tit/core/profiler.hpp"
+#include "tit/core/stats.hpp"
+#include "tit/core/sys/signal.hpp"
 #include "tit/core/time.hpp"
-#include "tit/core/vec.hpp"
-
-#include "tit/geom/partition.hpp"
-#include "tit/geom/search.hpp"
+#include "tit/core/uint_utils.hpp"
 
 #include "tit/data/storage.hpp"
 
-#include "tit/sph/artificial_viscosity.hpp"
-#include "tit/sph/continuity_equation.hpp"
-#include "tit/sph/energy_equation.hpp"
-#include "tit/sph/equation_of_state.hpp"
-#include "tit/sph/field.hpp"
-#include "tit/sph/fluid_equations.hpp"
-#include "tit/sph/kernel.hpp"
-#include "tit/sph/momentum_equation.hpp"
-#include "tit/sph/motion_equation.hpp"
+#include "tit/sph/dam_break.hpp"
 #include "tit/sph/particle_array.hpp"
-#include "tit/sph/particle_mesh.hpp"
-#include "tit/sph/time_integrator.hpp"
-#include "tit/sph/viscosity.hpp"
+#include "tit/sph/solver.hpp"
 
 namespace tit::sph {
 namespace {
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-template<class Real>
-auto sph_main(CmdArgs /*args*/) -> int {
-  constexpr Real H = 0.6;   // Water column height.
-  constexpr Real L = 2 * H; // Water column length.
-
-  constexpr Real POOL_WIDTH = 5.366 * H;
-  constexpr Real POOL_HEIGHT = 2.5 * H;
+// Case parameters.
+struct CaseConfig final {
+  size_t resolution;
+  real_t end_time;
+  std::optional<size_t> max_steps;
+  size_t output_freq;
+  size_t probe_freq; // Zero if the gauges are disabled.
+  size_t mesh_update_freq;
+  bool autotune;
+  size_t boundary_update_freq;
+  size_t renorm_update_freq;
+  bool prune_fixed;
+  size_t prefetch_distance;
+  bool compressed_mesh;
+  size_t output_levels;
+  real_t cfl;
+  std::string output_path;
+  bool record_telemetry;
+  bool diagnostics;
+  std::string kernel;
+  std::string eos;
+  std::string integrator;
+  bool fsal;
+  size_t num_time_levels;
+  std::string viscosity;
+  real_t mu_0;
+  real_t refine_width; // Zero if the refinement is disabled.
+  std::string checkpoint_path; // Empty if checkpoints are disabled.
+  size_t checkpoint_freq;
+  std::string restart_path; // Empty if not restarting.
+  size_t ensemble_size;
+  size_t ensemble_threads;
+  bool shards;
+};
 
-  constexpr Real dr = H / 80.0;
+// Run the case, writing the particles into a new data series of the storage.
+// Storage may be shared with the other ensemble members, so it is only
+// accessed under its lock.
+auto run_case(const CaseConfig& config,
+              data::DataStorage& storage,
+              size_t member) -> int {
+  // Resolution is the number of particles along the water column height.
+  constexpr real_t H = 0.6; // Water column height.
+  const DamBreakCase<real_t> dam_break{H, config.resolution};
 
-  constexpr auto N_FIXED = 4;
-  constexpr auto WATER_M = int(round(L / dr));
-  constexpr auto WATER_N = int(round(H / dr));
-  constexpr auto POOL_M = int(round(POOL_WIDTH / dr));
-  constexpr auto POOL_N = int(round(POOL_HEIGHT / dr));
+  const real_t POOL_WIDTH = dam_break.pool_width();
+  const real_t POOL_HEIGHT = dam_break.pool_height();
 
-  constexpr Real g = 9.81;
-  constexpr Real rho_0 = 1000.0;
-  constexpr Real cs_0 = 20 * sqrt(g * H);
-  constexpr Real h_0 = 2.0 * dr;
-  constexpr Real m_0 = rho_0 * pow(dr, 2);
+  constexpr real_t g = DamBreakCase<real_t>::g;
+  constexpr real_t rho_0 = DamBreakCase<real_t>::rho_0;
+  const real_t cs_0 = dam_break.sound_speed();
+  const real_t h_0 = dam_break.width();
+  const real_t m_0 = dam_break.mass();
 
-  constexpr Real CFL = 0.8;
-  constexpr Real dt = std::min(CFL * h_0 / cs_0, 0.25 * sqrt(h_0 / g));
+  const real_t dt = dam_break.time_step(config.cfl);
 
   // Parameters for the heat equation. Unused for now.
-  [[maybe_unused]] constexpr Real kappa_0 = 0.6;
-  [[maybe_unused]] constexpr Real c_v = 4184.0;
-
-  // Setup the SPH equations.
-  const FluidEquations equations{
-      // Standard motion equation.
-      MotionEquation{},
-      // Continuity equation with no source terms.
-      ContinuityEquation{},
-      // Momentum equation with gravity source term.
-      MomentumEquation{
-          // Inviscid flow.
-          NoViscosity{},
-          // δ-SPH artificial viscosity formulation.
-          DeltaSPHArtificialViscosity{cs_0, rho_0},
-          // Gravity source term.
-          GravitySource{g},
-      },
-      // No energy equation.
-      NoEnergyEquation{},
-      // Weakly compressible equation of state.
-      LinearTaitEquationOfState{cs_0, rho_0},
-      // C2 Wendland's spline kernel.
-      QuarticWendlandKernel{},
-  };
+  [[maybe_unused]] constexpr real_t kappa_0 = 0.6;
+  [[maybe_unused]] constexpr real_t c_v = 4184.0;
 
-  // Setup the time integrator.
-  RungeKuttaIntegrator time_integrator{equations};
+  // Create a data series to store the particles.
+  const auto series = [&storage] {
+    const auto lock = storage.lock();
+    return storage.create_series();
+  }();
 
-  // Setup the particles array:
-  ParticleArray particles{
-      // 2D space.
-      Space<Real, 2>{},
-      // Set of fields is inferred from the equations.
-      time_integrator,
-  };
+  // Refined zone at the right wall, empty if the refinement is disabled.
+  std::array<real_t, 3> refine_low{};
+  std::array<real_t, 3> refine_high{};
+  if (config.refine_width != 0.0) {
+    refine_low = {POOL_WIDTH - config.refine_width * H, 0.0, 0.0};
+    refine_high = {POOL_WIDTH, POOL_HEIGHT, 0.0};
+  }
 
-  // Generate individual particles.
-  size_t num_fixed_particles = 0;
-  size_t num_fluid_particles = 0;
-  for (auto i = -N_FIXED; i < POOL_M + N_FIXED; ++i) {
-    for (auto j = -N_FIXED; j < POOL_N; ++j) {
-      const bool is_fixed = (i < 0 || i >= POOL_M) || (j < 0);
-      const bool is_fluid = (i < WATER_M) && (j < WATER_N);
-
-      if (is_fixed) num_fixed_particles += 1;
-      else if (is_fluid) num_fluid_particles += 1;
-      else continue;
-
-      auto a = particles.append(is_fixed ? ParticleType::fixed :
-                                           ParticleType::fluid);
-      r[a] = dr * Vec{i + 0.5, j + 0.5};
+  // Setup the 2D solver: selected physical viscosity with δ-SPH artificial
+  // viscosity and gravity, weakly compressible equation of state, slip walls
+  // around the pool. Particles are searched with the grid search, and
+  // partitioned with RIB.
+  const auto solver = Solver::create(
+      {
+          .dim = 2,
+          .kernel = config.kernel,
+          .eos = config.eos,
+          .integrator = config.integrator,
+          .fsal = config.fsal,
+          .num_time_levels = config.num_time_levels,
+          .viscosity = config.viscosity,
+          .cs_0 = cs_0,
+          .rho_0 = rho_0,
+          .g = g,
+          .mu_0 = config.mu_0,
+          .h_0 = h_0,
+          .domain_low = {0.0, 0.0, 0.0},
+          .domain_high = {POOL_WIDTH, POOL_HEIGHT, 0.0},
+          .refinement_low = refine_low,
+          .refinement_high = refine_high,
+          .mesh_update_freq = config.mesh_update_freq,
+          .autotune = config.autotune,
+          .boundary_update_freq = config.boundary_update_freq,
+          .renorm_update_freq = config.renorm_update_freq,
+          .prune_fixed = config.prune_fixed,
+          .prefetch_distance = config.prefetch_distance,
+          .compressed_mesh = config.compressed_mesh,
+          .output_levels = config.output_levels,
+          .diagnostics = config.diagnostics,
+      },
+      series);
+
+  // Sample the pressure on the right wall near the bottom, and the water
+  // levels at a quarter and at the half of the pool width. Level gauges start
+  // one kernel support above the bottom, where the fluid is never dry, and
+  // the levels are measured from there.
+  if (config.probe_freq != 0) {
+    const auto probe_series = [&storage] {
+      const auto lock = storage.lock();
+      return storage.create_series("probes");
+    }();
+    solver->set_probe_series(probe_series);
+    const std::vector<real_t> pressure_point{POOL_WIDTH, 0.19 * H};
+    solver->add_gauge(pressure_point, pressure_point);
+    for (const auto x : {0.25 * POOL_WIDTH, 0.5 * POOL_WIDTH}) {
+      const std::vector<real_t> bottom{x, 2 * h_0};
+      const std::vector<real_t> top{x, POOL_HEIGHT};
+      solver->add_gauge(bottom, top, dam_break.num_pool_rows());
     }
   }
-  TIT_INFO("Num. fixed particles: {}", num_fixed_particles);
-  TIT_INFO("Num. fluid particles: {}", num_fluid_particles);
+
+  // Generate individual particles. Particles of each type are appended all
+  // at once.
+  const auto lattice = dam_break.lattice();
+  const auto append = [&solver, &lattice](ParticleType type) {
+    const auto points = lattice.positions(type);
+    std::vector<real_t> positions;
+    positions.reserve(2 * points.size());
+    for (const auto& point : points) {
+      positions.push_back(point[0]);
+      positions.push_back(point[1]);
+    }
+    solver->append(type, positions);
+    return points.size();
+  };
+  const auto num_fluid = append(ParticleType::fluid);
+  const auto num_fixed = append(ParticleType::fixed);
+  TIT_INFO("Num. fixed particles: {}", num_fixed);
+  TIT_INFO("Num. fluid particles: {}", num_fluid);
 
   // Set global particle constants.
-  m[particles] = m_0;
-  h[particles] = h_0;
+  solver->set_mass_and_width(m_0, h_0);
 
   // Density hydrostatic initialization.
-  for (const auto a : particles.all()) {
-    if (a.has_type(ParticleType::fixed)) {
-      rho[a] = rho_0;
-      continue;
+  solver->init([&dam_break](ParticleType type, std::span<const real_t> r_a) {
+    if (type == ParticleType::fixed) {
+      return ParticleState{.rho = rho_0, .p = 0.0};
     }
+    const auto p_a = dam_break.hydrostatic_pressure(Vec{r_a[0], r_a[1]});
+    return ParticleState{.rho = dam_break.density(p_a), .p = p_a};
+  });
 
-    // Compute pressure from Poisson problem.
-    const auto x = r[a][0];
-    const auto y = r[a][1];
-    p[a] = rho_0 * g * (H - y);
-    for (size_t N = 1; N < 100; N += 2) {
-      constexpr auto pi = std::numbers::pi_v<Real>;
-      const auto n = static_cast<Real>(N);
-      p[a] -= 8 * rho_0 * g * H / pow2(pi) *
-              (exp(n * pi * (x - L) / (2 * H)) * cos(n * pi * y / (2 * H))) /
-              pow2(n);
-    }
-    // Recalculate density from EOS.
-    rho[a] = rho_0 + p[a] / pow2(cs_0);
+  // Restore the solver state, if restarting. Particle setup above is still
+  // needed, since it reports the case sizes, but it is overwritten here.
+  SolverProgress progress{};
+  if (!config.restart_path.empty()) {
+    progress = solver->restore(config.restart_path);
+    TIT_INFO("Restarted from '{}' at step {}.",
+             config.restart_path,
+             progress.step);
   }
 
-  // Setup the particle mesh structure.
-  ParticleMesh mesh{
-      // Search for the particles using the grid search.
-      geom::GridSearch{h_0},
-      // Use RIB as the primary partitioning method.
-      geom::RecursiveInertialBisection{},
-      // Use graph partitioning with larger cell size as the interface
-      // partitioning method.
-      geom::GridGraphPartition{2 * h_0},
+  solver->write(progress.time * sqrt(g / H));
+
+  // Per-step telemetry is recorded only if requested, since the wall times
+  // make the storage contents non-reproducible. It is buffered, and flushed
+  // into the series in a single transaction each time the particles are
+  // written. Storage must not be accessed while the particles are being
+  // written, so the pending write is waited for first.
+  std::vector<std::tuple<size_t, std::string_view, real_t>> telemetry;
+  const auto flush_telemetry = [&storage, &series, &solver, &telemetry] {
+    solver->wait();
+    const auto lock = storage.lock();
+    const auto transaction = storage.transaction();
+    for (const auto& [step, name, value] : telemetry) {
+      series.record_telemetry(step, name, value);
+    }
+    telemetry.clear();
   };
 
-  // Create a data storage to store the particles.  We'll store only one last
-  // run result, all the previous runs will be discarded.
-  data::DataStorage storage{"./particles.ttdb"};
-  storage.set_max_series(1);
-  const auto series = storage.create_series();
-  particles.write(0.0, series);
+  // Running case is inspected with the signals, that are handled at the step
+  // boundaries: `SIGUSR1` prints the profiling and the statistics reports,
+  // and `SIGUSR2` writes a checkpoint. Ensemble members would handle them
+  // concurrently, so the signals are only handled for the single runs.
+  std::optional<SignalFlag> report_signal;
+  std::optional<SignalFlag> checkpoint_signal;
+  if (config.ensemble_size == 1) {
+    report_signal.emplace(SIGUSR1);
+    checkpoint_signal.emplace(SIGUSR2);
+  }
 
-  Real time{};
+  real_t time = progress.time;
   Stopwatch exectime{};
   Stopwatch printtime{};
-  for (size_t n = 0;; ++n) {
-    TIT_INFO("{:>15}\t\t{:>10.5f}\t\t{:>10.5f}\t\t{:>10.5f}",
-             n,
-             time * sqrt(g / H),
-             exectime.cycle(),
-             printtime.cycle());
+  for (size_t n = progress.step;; ++n) {
+    // Progress of the ensemble members would be interleaved, so it is only
+    // reported for the single runs.
+    if (config.ensemble_size == 1) {
+      TIT_PROGRESS("{:>15}\t\t{:>10.5f}\t\t{:>10.5f}\t\t{:>10.5f}",
+                   n,
+                   time * sqrt(g / H),
+                   exectime.cycle(),
+                   printtime.cycle());
+    }
+    const auto exec_start = exectime.total();
+    const auto num_rebuilds = solver->num_mesh_rebuilds();
     {
       const StopwatchCycle cycle{exectime};
-      time_integrator.step(dt, mesh, particles);
+      solver->step(dt);
+    }
+    if (config.probe_freq != 0 && n % config.probe_freq == 0) {
+      solver->sample(time * sqrt(g / H));
+    }
+    if (config.record_telemetry) {
+      telemetry.emplace_back(n, "time", time * sqrt(g / H));
+      telemetry.emplace_back(n, "wall_time", exectime.total() - exec_start);
+      telemetry.emplace_back(
+          n,
+          "rebuild",
+          solver->num_mesh_rebuilds() != num_rebuilds ? 1.0 : 0.0);
+      telemetry.emplace_back(n, "num_pairs", solver->num_pairs());
+      telemetry.emplace_back(n, "block_imbalance", solver->block_imbalance());
+    }
+    if (config.diagnostics) {
+      const auto diagnostics = solver->diagnostics();
+      telemetry.emplace_back(n, "mass", diagnostics.mass);
+      telemetry.emplace_back(n, "kinetic_energy", diagnostics.kinetic_energy);
+      telemetry.emplace_back(n,
+                             "potential_energy",
+                             diagnostics.potential_energy);
+      telemetry.emplace_back(n, "momentum_x", diagnostics.momentum[0]);
+      telemetry.emplace_back(n, "momentum_y", diagnostics.momentum[1]);
+      telemetry.emplace_back(n, "max_speed", diagnostics.max_speed);
     }
-    const auto end = time * sqrt(g / H) >= 6.9;
-    if ((n % 100 == 0 && n != 0) || end) {
+    const auto end = time * sqrt(g / H) >= config.end_time ||
+                     (config.max_steps.has_value() &&
+                      n + 1 >= *config.max_steps);
+    if ((n % config.output_freq == 0 && n != 0) || end) {
       const StopwatchCycle cycle{printtime};
-      particles.write(time * sqrt(g / H), series);
+      flush_telemetry();
+      solver->write(time * sqrt(g / H));
+    }
+    if (report_signal && report_signal->test_and_reset()) {
+      solver->wait();
+      if (Profiler::enabled()) Profiler::report();
+      if (Stats::enabled()) Stats::report();
+      if (MemoryStats::enabled()) MemoryStats::report();
     }
     if (end) break;
     time += dt;
+    const auto checkpoint_requested =
+        checkpoint_signal && checkpoint_signal->test_and_reset();
+    if (checkpoint_requested && config.checkpoint_path.empty()) {
+      TIT_WARN("Checkpoint is requested, but no checkpoint path is set.");
+    }
+    if (!config.checkpoint_path.empty() &&
+        ((n + 1) % config.checkpoint_freq == 0 || checkpoint_requested)) {
+      solver->checkpoint(config.checkpoint_path,
+                         {.time = time, .step = n + 1});
+    }
+  }
+  solver->wait();
+
+  // Report the performance summary, parsed by the scaling harness.
+  const auto num_particles = solver->num_particles();
+  const auto num_steps = exectime.cycles();
+  TIT_INFO("Performance: member {}, {} particles, {} steps, {:.6f} s, "
+           "{:.6e} particle updates/s",
+           member,
+           num_particles,
+           num_steps,
+           exectime.total(),
+           static_cast<real_t>(num_particles * num_steps) / exectime.total());
+
+  return 0;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Case parameters are read from the command line arguments, `--name=value`,
+// and from the configuration files, `--config=<path>`. Solver configuration
+// is selected at run time from the precompiled ones, see `Solver`.
+auto sph_main(CmdArgs args) -> int {
+  const Options options{args};
+  const CaseConfig config{
+      // Number of particles along the water column height.
+      .resolution = options.get("resolution", 80UZ),
+      // Dimensionless end time, `t * sqrt(g / H)`.
+      .end_time = options.get<real_t>("end_time", 6.9),
+      // Scaling studies limit the number of steps.
+      .max_steps = options.get<size_t>("max_steps"),
+      // Particles are written each `output_freq` steps.
+      .output_freq = options.get("output_freq", 100UZ),
+      // Gauges are sampled each `probe_freq` steps, into a separate series.
+      .probe_freq = options.get("probe_freq", 0UZ),
+      .mesh_update_freq = options.get("mesh_update_freq", 10UZ),
+      // Autotuning overrides the mesh update frequency.
+      .autotune = options.get("autotune", false),
+      // Zero updates the boundary and the renormalization on each stage.
+      .boundary_update_freq = options.get("boundary_freq", 0UZ),
+      .renorm_update_freq = options.get("renorm_freq", 0UZ),
+      // Most of the pool walls are far from the water, so the fixed particles
+      // without the fluid neighbors are skipped.
+      .prune_fixed = options.get("prune_fixed", true),
+      // Best prefetch distance depends on the machine, zero disables it.
+      .prefetch_distance = options.get("prefetch", 0UZ),
+      // Compressed adjacency fits the larger runs into memory.
+      .compressed_mesh = options.get("compressed_mesh", false),
+      // Decimated levels are written along with the particles.
+      .output_levels = options.get("output_levels", 0UZ),
+      .cfl = options.get<real_t>("cfl", 0.8),
+      .output_path =
+          std::string{options.get("output").value_or("./particles.ttdb")},
+      // Per-step telemetry makes the storage contents non-reproducible,
+      // since it contains the wall times.
+      .record_telemetry = options.get("telemetry", false),
+      // Global diagnostics are recorded along with the telemetry, they are
+      // reproducible and cost no extra pass over the particles.
+      .diagnostics = options.get("diagnostics", false),
+      .kernel = std::string{options.get("kernel").value_or("quartic_wendland")},
+      .eos = std::string{options.get("eos").value_or("linear_tait")},
+      .integrator =
+          std::string{options.get("integrator").value_or("runge_kutta")},
+      // Reused forces are lagged by the particle shifting.
+      .fsal = options.get("fsal", false),
+      .num_time_levels = options.get("time_levels", 4UZ),
+      // Flow is inviscid by default, water is `--viscosity=laplacian` with
+      // `--mu=1.0e-3`.
+      .viscosity = std::string{options.get("viscosity").value_or("none")},
+      .mu_0 = options.get<real_t>("mu", 0.0),
+      // Dimensionless width of the refined zone at the right wall, where the
+      // water impacts it, `w / H`.
+      .refine_width = options.get<real_t>("refine_width", 0.0),
+      // Checkpoints are written each `checkpoint_freq` steps. Multiples of
+      // the mesh update frequency make the restarts bitwise identical.
+      .checkpoint_path = std::string{options.get("checkpoint").value_or("")},
+      .checkpoint_freq = options.get("checkpoint_freq", 1000UZ),
+      .restart_path = std::string{options.get("restart").value_or("")},
+      // Ensemble members are run concurrently within the isolated task
+      // arenas, each with its own thread budget.
+      .ensemble_size = options.get("ensemble", 1UZ),
+      .ensemble_threads = options.get("ensemble_threads", 1UZ),
+      // Sharded ensemble members write into the separate database files of
+      // the storage, and do not wait for each other to write.
+      .shards = options.get("shards", false),
+  };
+  if (const auto num_threads = options.get<size_t>("threads")) {
+    par::set_num_threads(*num_threads);
+  }
+  // Progress is written by a background thread, so that the slow output does
+  // not stall the stepping. Only the progress lines above the rate limit are
+  // dropped, and the limit of zero keeps all of them.
+  const AsyncLogger logger{options.get("log_rate", 0UZ)};
+  options.check_unused();
+  if (config.resolution == 0 || config.output_freq == 0 ||
+      config.checkpoint_freq == 0 || config.cfl <= 0.0) {
+    TIT_THROW("Resolution, output and checkpoint frequencies, and CFL number "
+              "must be positive.");
+  }
+  if (config.ensemble_size == 0 || config.ensemble_threads == 0) {
+    TIT_THROW("Ensemble size and number of the threads per member must be "
+              "positive.");
+  }
+  if (config.ensemble_size > 1 &&
+      (!config.checkpoint_path.empty() || !config.restart_path.empty())) {
+    TIT_THROW("Checkpoints and restarts are not supported for ensembles.");
   }
+  if (config.ensemble_size == 1 && config.shards) {
+    TIT_THROW("Shards are only supported for ensembles.");
+  }
+  TIT_INFO("Case: resolution {}, kernel '{}', EOS '{}', integrator '{}'.",
+           config.resolution,
+           config.kernel,
+           config.eos,
+           config.integrator);
+
+  // Create a data storage to store the particles. We'll store only the last
+  // run results, all the previous runs will be discarded.
+  data::DataStorage storage{config.output_path};
+  storage.set_max_series(config.ensemble_size *
+                         (config.probe_freq != 0 ? 2 : 1));
+
+  // Monitoring tools read the storage while the particles are written, so
+  // the write-ahead log is used, that lets them read without blocking us.
+  storage.set_journal_mode(data::JournalMode::wal);
+  if (config.ensemble_size == 1) return run_case(config, storage, 0);
 
+  // Members of the ensemble share the storage, but nothing else. Sharded
+  // members write into the shards of the storage instead, so they only share
+  // a shard, and its lock, if there are more members than the shards.
+  std::vector<data::DataStorage> shards;
+  if (config.shards) {
+    const auto num_shards =
+        std::min(config.ensemble_size, data::DataStorage::MaxShards);
+    const auto members_per_shard = divide_up(config.ensemble_size, num_shards);
+    for (size_t index = 1; index <= num_shards; ++index) {
+      auto& shard = shards.emplace_back(storage.open_shard(index));
+      shard.set_max_series(members_per_shard *
+                           (config.probe_freq != 0 ? 2 : 1));
+      shard.set_journal_mode(data::JournalMode::wal);
+    }
+  }
+  TIT_INFO("Ensemble: {} members, {} threads per member, {} shards.",
+           config.ensemble_size,
+           config.ensemble_threads,
+           shards.size());
+  par::run_isolated(config.ensemble_size,
+                    config.ensemble_threads,
+                    [&config, &storage, &shards](size_t member) {
+                      auto& member_storage =
+                          shards.empty() ? storage :
+                                           shards[member % shards.size()];
+                      run_case(config, member_storage, member);
+                    });
   return 0;
 }
 
@@ -185,4 +462,4 @@ auto sph_main(CmdArgs /*args*/) -> int {
 } // namespace
 } // namespace tit::sph
 
-TIT_IMPLEMENT_MAIN(sph::sph_main<tit::real_t>)
+TIT_IMPLEMENT_MAIN(sph::sph_main)
@@ -0,0 +1,17 @@
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+# Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+# Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+# Run a few steps of the coarse dam break case.
+
+import pytit
+
+sim = pytit.dam_break(height=0.6, resolution=10)
+print("particles:", len(pytit.field(sim, "rho")))
+print("time:", pytit.time(sim))
+
+time = pytit.run(sim, num_steps=10)
+rho = pytit.field(sim, "rho")
+print("advanced:", time > 0.0 and time == pytit.time(sim))
+print("density:", bool((900.0 < rho).all() and (rho < 1100.0).all()))
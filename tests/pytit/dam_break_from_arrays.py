@@ -0,0 +1,36 @@
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+# Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+# Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+# Set up the dam break case from the particle arrays.
+
+import numpy as np
+
+import pytit
+
+# Block of 5x5 fluid particles over 4 layers of the fixed particles.
+dr = 0.6 / 10
+i, j = np.meshgrid(np.arange(-4, 9), np.arange(-4, 5), indexing="ij")
+i, j = i.ravel(), j.ravel()
+keep = (j < 0) | ((i >= 0) & (i < 5))
+i, j = i[keep], j[keep]
+types = np.where(j < 0, 1, 0).astype(np.uint8)
+r = np.ascontiguousarray(np.stack([dr * (i + 0.5), dr * (j + 0.5)], axis=1))
+
+sim = pytit.dam_break_from_arrays(height=0.6, resolution=10, type=types, r=r)
+rho = pytit.field(sim, "rho")
+print("particles:", len(rho))
+print("hydrostatic:", bool((rho[: (types == 0).sum()] > 1000.0).all()))
+time = pytit.run(sim, num_steps=5)
+print("advanced:", time > 0.0)
+
+# Buffer particles are not supported by the case.
+try:
+    bad_types = types.copy()
+    bad_types[0] = 2
+    pytit.dam_break_from_arrays(
+        height=0.6, resolution=10, type=bad_types, r=r
+    )
+except Exception as e:
+    print(f"{type(e).__name__}: {e}")
@@ -40,6 +40,10 @@ namespace {
 
 auto run_test(CmdArgs /*args*/) -> int {
   func_1();
+
+  // Sections of the worker thread are reported separately.
+  std::thread worker{func_3};
+  worker.join();
   return 0;
 }
 
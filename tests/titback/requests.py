@@ -0,0 +1,105 @@
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+# Part of BlueTit Solver, licensed under Apache 2.0 with Commons Clause.
+# Commercial use, including SaaS, requires a separate license, see /LICENSE.md
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+# Send the requests to the running backend and print the responses.
+#
+# Minimal WebSocket client is implemented here on top of the standard library,
+# so that the test does not depend on any third-party packages.
+
+import base64
+import json
+import os
+import socket
+import struct
+import sys
+import time
+
+PORT = int(os.environ["TIT_BACKEND_PORT"])
+REQUESTS = [
+    # Well-formed request.
+    '{"requestID": "1", "expression": "1 + 2"}',
+    # Malformed requests.
+    "not a json",
+    '["requestID", "2"]',
+    '{"requestID": 3, "expression": "1 + 2"}',
+    '{"requestID": "4"}',
+    # Request with the missing ID.
+    '{"expression": "1 + 2"}',
+    # Backend must still be alive.
+    '{"requestID": "5", "expression": "[4, 5]"}',
+]
+
+
+def recv_exact(sock, size):
+    data = b""
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            sys.exit("Connection was closed.")
+        data += chunk
+    return data
+
+
+def connect():
+    for _ in range(100):
+        try:
+            sock = socket.create_connection(("127.0.0.1", PORT))
+            break
+        except OSError:
+            time.sleep(0.1)
+    else:
+        sys.exit("Backend is not running.")
+    key = base64.b64encode(os.urandom(16)).decode()
+    sock.sendall(
+        (
+            "GET /ws HTTP/1.1\r\n"
+            f"Host: 127.0.0.1:{PORT}\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            f"Sec-WebSocket-Key: {key}\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "\r\n"
+        ).encode()
+    )
+    header = b""
+    while not header.endswith(b"\r\n\r\n"):
+        header += recv_exact(sock, 1)
+    if b" 101 " not in header.split(b"\r\n")[0]:
+        sys.exit("WebSocket handshake failed.")
+    return sock
+
+
+def send_text(sock, text):
+    payload = text.encode()
+    mask = os.urandom(4)
+    header = bytes([0x81])
+    if len(payload) < 126:
+        header += bytes([0x80 | len(payload)])
+    elif len(payload) < 2**16:
+        header += bytes([0x80 | 126]) + struct.pack("!H", len(payload))
+    else:
+        header += bytes([0x80 | 127]) + struct.pack("!Q", len(payload))
+    masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+    sock.sendall(header + mask + masked)
+
+
+def recv_text(sock):
+    while True:
+        opcode, size = recv_exact(sock, 2)
+        size &= 0x7F
+        if size == 126:
+            (size,) = struct.unpack("!H", recv_exact(sock, 2))
+        elif size == 127:
+            (size,) = struct.unpack("!Q", recv_exact(sock, 8))
+        payload = recv_exact(sock, size)
+        if opcode & 0x0F == 0x01:
+            return payload.decode()
+
+
+sock = connect()
+for request in REQUESTS:
+    send_text(sock, request)
+    print(json.dumps(json.loads(recv_text(sock)), sort_keys=True))
+sock.close()